@@ -0,0 +1,31 @@
+/*
+ * Copyright 2026 Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _GNU_UNISTD_H_
+#define _GNU_UNISTD_H_
+
+
+#include_next <unistd.h>
+#include <features.h>
+
+
+#ifdef _DEFAULT_SOURCE
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern ssize_t copy_file_range(int fromFD, off_t* fromOffset, int toFD,
+	off_t* toOffset, size_t length, unsigned int flags);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
+
+
+#endif  /* _GNU_UNISTD_H_ */
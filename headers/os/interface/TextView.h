@@ -1,5 +1,5 @@
 /*
- * Copyright 2007-2020 Haiku, Inc. All rights reserved.
+ * Copyright 2007-2026 Haiku, Inc. All rights reserved.
  * Distributed under the terms of the MIT License.
  */
 #ifndef _TEXTVIEW_H
@@ -304,12 +304,26 @@ private:
 			void				_Refresh(int32 fromOffset, int32 toOffset,
 									int32 scrollTo = INT32_MIN);
 			void				_RecalculateLineBreaks(int32* startLine,
-									int32* endLine);
+									int32* endLine, bool estimate = false);
+			void				_FitTextRectToLines();
+			float				_LinesHeight(int32 startLine,
+									int32 endLine) const;
 			void				_ValidateTextRect();
 			int32				_FindLineBreak(int32 fromOffset,
 									float* _ascent, float* _descent,
 									float* inOutWidth);
 
+			int32				_EstimateLines(int32 lineIndex,
+									int32 minOffset);
+			float				_LayoutEstimatedLines(int32 fromLine,
+									int32 toLine);
+			bool				_LayoutNextLines() const;
+			void				_LayoutLinesUpTo(int32 line) const;
+			void				_LayoutLinesUpToOffset(int32 offset) const;
+			void				_LayoutLinesUpToPixel(float y) const;
+			void				_ScheduleLayout();
+			void				_ContinueLayout();
+
 			float				_StyledWidth(int32 fromOffset, int32 length,
 									float* _ascent = NULL,
 									float* _descent = NULL) const;
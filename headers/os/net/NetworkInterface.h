@@ -76,6 +76,9 @@ public:
 			uint32				Metric() const;
 			uint32				Type() const;
 			status_t			GetStats(ifreq_stats& stats);
+			int32				CountReceiveQueues() const;
+			status_t			GetReceiveQueueStats(int32 index,
+									ifreq_stream_stats& stats) const;
 			bool				HasLink() const;
 
 			status_t			SetFlags(uint32 flags);
@@ -64,6 +64,14 @@ struct ifaliasreq {
 	uint32_t		ifra_flags;
 };
 
+/* used with B_SOCKET_GET_RECEIVE_QUEUE_STATS */
+struct ifreceivequeuereq {
+	char			ifrq_name[IF_NAMESIZE];
+	uint32_t		ifrq_index;
+	uint32_t		ifrq_count;		/* number of receive queues */
+	struct ifreq_stream_stats ifrq_stats;
+};
+
 
 /* interface flags */
 #define IFF_UP				0x0001
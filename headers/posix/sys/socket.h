@@ -125,6 +125,13 @@ struct msghdr {
 #define MSG_MCAST		0x0200	/* this message rec'd as multicast */
 #define	MSG_EOF			0x0400	/* data completes connection */
 #define MSG_NOSIGNAL	0x0800	/* don't raise SIGPIPE if socket is closed */
+#define MSG_WAITFORONE	0x1000	/* recvmmsg(): only wait for the first message */
+
+/* Used by recvmmsg() and sendmmsg() to transfer several messages at once */
+struct mmsghdr {
+	struct msghdr	msg_hdr;
+	unsigned int	msg_len;		/* number of bytes transferred */
+};
 
 struct cmsghdr {
 	socklen_t	cmsg_len;
@@ -182,8 +189,12 @@ ssize_t recv(int socket, void *buffer, size_t length, int flags);
 ssize_t recvfrom(int socket, void *buffer, size_t bufferLength, int flags,
 			struct sockaddr *address, socklen_t *_addressLength);
 ssize_t recvmsg(int socket, struct msghdr *message, int flags);
+int		recvmmsg(int socket, struct mmsghdr *messages, unsigned int count,
+			int flags, struct timespec *timeout);
 ssize_t send(int socket, const void *buffer, size_t length, int flags);
 ssize_t	sendmsg(int socket, const struct msghdr *message, int flags);
+int		sendmmsg(int socket, struct mmsghdr *messages, unsigned int count,
+			int flags);
 ssize_t sendto(int socket, const void *message, size_t length, int flags,
 			const struct sockaddr *address, socklen_t addressLength);
 int     setsockopt(int socket, int level, int option, const void *value,
@@ -21,6 +21,8 @@ class BRegion;
 
 namespace BPrivate {
 
+class LinkRing;
+
 class LinkReceiver {
 	public:
 		LinkReceiver(port_id port);
@@ -29,6 +31,9 @@ class LinkReceiver {
 		void SetPort(port_id port);
 		port_id	Port(void) const { return fReceivePort; }
 
+		void SetRing(LinkRing* ring);
+		LinkRing* Ring() const { return fRing; }
+
 		status_t GetNextMessage(int32& code, bigtime_t timeout = B_INFINITE_TIMEOUT);
 		bool HasMessages() const;
 		bool NeedsReply() const;
@@ -47,9 +52,14 @@ class LinkReceiver {
 	protected:
 		virtual status_t ReadFromPort(bigtime_t timeout);
 		virtual status_t AdjustReplyBuffer(bigtime_t timeout);
+		status_t AdjustBufferSize(ssize_t size);
+		status_t ReadFromRing(bigtime_t timeout);
+		status_t ReadRingRecord();
+		bool PortHasMessages() const;
 		void ResetBuffer();
 
 		port_id fReceivePort;
+		LinkRing* fRing;
 
 		char*	fRecvBuffer;
 		int32	fRecvPosition;	//current read position
@@ -60,6 +70,11 @@ class LinkReceiver {
 		int32	fReplySize;	//size of current reply message
 
 		status_t fReadError;	//Read failed for current message
+
+		char*	fDeferredBuffer;	//port batch waiting for the ring
+		int32	fDeferredBufferSize;
+		int32	fDeferredSize;
+		bool	fPortTurn;
 };
 
 }	// namespace BPrivate
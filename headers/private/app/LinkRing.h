@@ -0,0 +1,61 @@
+/*
+ * Copyright 2026, Haiku.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _LINK_RING_H
+#define _LINK_RING_H
+
+
+#include <OS.h>
+
+
+namespace BPrivate {
+
+struct link_ring_header;
+
+/*!	A single-producer, single-consumer ring in a shared area that carries
+	the batches of a LinkSender to a LinkReceiver. The port of the link is
+	then only used to wake up the receiver, and for batches that do not fit
+	into the ring.
+*/
+class LinkRing {
+	public:
+		LinkRing();
+		~LinkRing();
+
+		status_t Create(const char* name, size_t size);
+		status_t Clone(area_id area);
+		area_id Area() const { return fArea; }
+
+		// producer side
+		bool Write(const void* data, size_t size);
+		bool DisarmWakeup();
+		void WakeupFailed();
+		void PortBatchSent();
+		void PortBatchFailed();
+
+		// consumer side
+		bool HasData() const;
+		ssize_t NextRecordSize();
+		void SkipRecord();
+		const void* RecordData() const;
+		bool ArmWakeup();
+		void PortBatchReceived();
+		void WakeupReceived();
+		int32 PendingWakeups() const;
+
+	private:
+		status_t _Init(void* address, size_t areaSize);
+
+		area_id				fArea;
+		link_ring_header*	fHeader;
+		uint8*				fData;
+		uint32				fSize;
+		uint32				fReadPosition;
+		uint32				fRecordSize;
+		uint32				fWakeupsReceived;
+};
+
+}	// namespace BPrivate
+
+#endif	// _LINK_RING_H
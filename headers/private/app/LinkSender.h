@@ -15,7 +15,9 @@
 
 
 namespace BPrivate {
-	
+
+class LinkRing;
+
 class LinkSender {
 	public:
 		LinkSender(port_id sendport);
@@ -24,6 +26,9 @@ class LinkSender {
 		void SetPort(port_id port);
 		port_id	Port() const { return fPort; }
 
+		void SetRing(LinkRing* ring);
+		LinkRing* Ring() const { return fRing; }
+
 		team_id TargetTeam() const;
 		void SetTargetTeam(team_id team);
 
@@ -49,6 +54,7 @@ class LinkSender {
 
 		port_id	fPort;
 		team_id fTargetTeam;
+		LinkRing* fRing;
 
 		char	*fBuffer;
 		size_t	fBufferSize;
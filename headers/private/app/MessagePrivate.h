@@ -239,6 +239,21 @@ class BMessage::Private {
 			BMessage::_StaticCacheCleanup();
 		}
 
+		static uint32
+		HashName(const char* name)
+		{
+			char ch;
+			uint32 result = 0;
+
+			while ((ch = *name++) != 0) {
+				result = (result << 7) ^ (result >> 24);
+				result ^= ch;
+			}
+
+			result ^= result << 12;
+			return result;
+		}
+
 	private:
 		BMessage* fMessage;
 };
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _MESSAGE_VIEW_H
+#define _MESSAGE_VIEW_H
+
+
+#include <Message.h>
+
+
+class BPoint;
+class BRect;
+
+
+namespace BPrivate {
+
+
+/*!	Read-only access to a flattened BMessage, without copying it.
+
+	The buffer is validated once in SetTo(), and must stay valid and
+	unchanged for as long as the view is used. All pointers returned point
+	into the buffer; they are not necessarily aligned for their type.
+*/
+class MessageView {
+public:
+	/*!	A field name with its hash computed in advance. If it is used
+		repeatedly, for example with messages of the same layout, it also
+		remembers where it found the field last time.
+	*/
+	class FieldName {
+	public:
+								FieldName(const char* name);
+
+				const char*		String() const	{ return fName; }
+
+	private:
+		friend class MessageView;
+
+				const char*		fName;
+				uint32			fLength;
+				uint32			fHash;
+		mutable	int32			fHint;
+	};
+
+public:
+								MessageView();
+								MessageView(const void* buffer, size_t size);
+
+			status_t			SetTo(const void* buffer, size_t size);
+			void				Unset();
+			status_t			InitCheck() const;
+
+			const void*			Buffer() const	{ return fHeader; }
+			size_t				FlattenedSize() const;
+
+			uint32				What() const;
+			int32				CountNames(type_code type = B_ANY_TYPE) const;
+			bool				HasField(const FieldName& name,
+									type_code type = B_ANY_TYPE) const;
+
+			status_t			GetInfo(const FieldName& name,
+									type_code* _type, int32* _count = NULL,
+									bool* _fixedSize = NULL) const;
+			status_t			GetInfo(type_code type, int32 index,
+									const char** _name, type_code* _type,
+									int32* _count = NULL) const;
+
+			status_t			FindData(const FieldName& name,
+									type_code type, int32 index,
+									const void** _data, ssize_t* _size) const;
+			status_t			FindData(const FieldName& name,
+									type_code type, const void** _data,
+									ssize_t* _size) const;
+
+			status_t			FindString(const FieldName& name,
+									int32 index, const char** _string) const;
+			status_t			FindString(const FieldName& name,
+									const char** _string) const;
+			status_t			FindMessage(const FieldName& name,
+									int32 index, MessageView& _message) const;
+			status_t			FindMessage(const FieldName& name,
+									MessageView& _message) const;
+
+			status_t			FindBool(const FieldName& name, int32 index,
+									bool* _value) const;
+			status_t			FindInt8(const FieldName& name, int32 index,
+									int8* _value) const;
+			status_t			FindInt16(const FieldName& name, int32 index,
+									int16* _value) const;
+			status_t			FindInt32(const FieldName& name, int32 index,
+									int32* _value) const;
+			status_t			FindInt64(const FieldName& name, int32 index,
+									int64* _value) const;
+			status_t			FindFloat(const FieldName& name, int32 index,
+									float* _value) const;
+			status_t			FindDouble(const FieldName& name, int32 index,
+									double* _value) const;
+			status_t			FindPoint(const FieldName& name, int32 index,
+									BPoint* _value) const;
+			status_t			FindRect(const FieldName& name, int32 index,
+									BRect* _value) const;
+
+			status_t			FindBool(const FieldName& name,
+									bool* _value) const;
+			status_t			FindInt8(const FieldName& name,
+									int8* _value) const;
+			status_t			FindInt16(const FieldName& name,
+									int16* _value) const;
+			status_t			FindInt32(const FieldName& name,
+									int32* _value) const;
+			status_t			FindInt64(const FieldName& name,
+									int64* _value) const;
+			status_t			FindFloat(const FieldName& name,
+									float* _value) const;
+			status_t			FindDouble(const FieldName& name,
+									double* _value) const;
+			status_t			FindPoint(const FieldName& name,
+									BPoint* _value) const;
+			status_t			FindRect(const FieldName& name,
+									BRect* _value) const;
+
+			status_t			Unflatten(BMessage& message) const;
+
+private:
+			typedef BMessage::message_header message_header;
+			typedef BMessage::field_header field_header;
+
+			status_t			_Validate(size_t size) const;
+			status_t			_FindField(const FieldName& name,
+									type_code type,
+									const field_header** _field) const;
+			status_t			_FindFixedSize(const FieldName& name,
+									type_code type, int32 index, void* value,
+									size_t size) const;
+
+private:
+			const message_header* fHeader;
+			const field_header*	fFields;
+			const uint8*		fData;
+			status_t			fStatus;
+};
+
+
+}	// namespace BPrivate
+
+
+using BPrivate::MessageView;
+
+
+#endif	// _MESSAGE_VIEW_H
@@ -194,6 +194,8 @@ enum {
 	AS_GET_DECORATOR_NAME,
 	AS_SET_CONTROL_LOOK,
 	AS_GET_CONTROL_LOOK,
+	AS_SET_COMPOSITING,
+	AS_GET_COMPOSITING,
 
 	AS_COUNT_WORKSPACES,
 	AS_CURRENT_WORKSPACE,
@@ -356,6 +358,7 @@ enum {
 	// debugging helper
 	AS_DUMP_ALLOCATOR,
 	AS_DUMP_BITMAPS,
+	AS_DUMP_FONT_CACHE,
 
 	// transformation in addition to origin/scale
 	AS_VIEW_SET_TRANSFORM,
@@ -374,6 +377,9 @@ enum {
 	AS_VIEW_CLIP_TO_RECT,
 	AS_VIEW_CLIP_TO_SHAPE,
 
+	// shared memory ring for the window link
+	AS_ATTACH_LINK_RING,
+
 	AS_LAST_CODE
 };
 
@@ -44,6 +44,9 @@ public:
 			bool				IsLoaded() const	{ return fLoadCount > 0; }
 			uint32				LinkIndex() const	{ return fLinkIndex; }
 
+private:
+			void				_FreeData();
+
 private:
 			const char*			fName;
 			uint32				fType;
@@ -51,6 +54,8 @@ private:
 			uint64				fOffset;
 			uint64				fSize;
 			void*				fData;
+			void*				fMapping;
+			size_t				fMappingSize;
 			target_addr_t		fLoadAddress;
 			uint32				fFlags;
 			int32				fLoadCount;
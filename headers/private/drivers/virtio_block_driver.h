@@ -0,0 +1,35 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _VIRTIO_BLOCK_DRIVER_H_
+#define _VIRTIO_BLOCK_DRIVER_H_
+
+
+#include <SupportDefs.h>
+#include <Drivers.h>
+
+
+#define VIRTIO_BLOCK_MAX_QUEUES		16
+
+
+enum {
+	VIRTIO_BLOCK_GET_STATISTICS = B_DEVICE_OP_CODES_END + 1,
+};
+
+
+typedef struct virtio_block_queue_statistics {
+	int32	in_flight;
+	int32	max_in_flight;
+	int64	submitted;
+	int64	waits;
+} virtio_block_queue_statistics;
+
+
+typedef struct virtio_block_statistics {
+	uint32	queue_count;
+	virtio_block_queue_statistics queues[VIRTIO_BLOCK_MAX_QUEUES];
+} virtio_block_statistics;
+
+
+#endif	// _VIRTIO_BLOCK_DRIVER_H_
@@ -60,6 +60,7 @@ class OutlineView;
 class TitleView;
 class BRowContainer;
 class RecursiveOutlineIterator;
+class RowPositionTree;
 
 }	// ns BPrivate
 
@@ -67,6 +68,7 @@ class BColumn;
 class BColumnListView;
 class BField;
 class BRow;
+class BRowSource;
 
 enum LatchType {
 	B_NO_LATCH					= 0,
@@ -148,16 +150,37 @@ private:
 			BPrivate::
 			BRowContainer*		fChildList;
 			bool				fIsExpanded;
+			bool				fFieldsFetched;
+				// uses the padding after fIsExpanded
 			float				fHeight;
 			BRow*				fNextSelected;
 			BRow*				fPrevSelected;
 			BRow*				fParent;
 			BColumnListView*	fList;
+			int32				fPositionNode;
+				// of a root row in the position tree of the list
 
 
 	friend class BColumnListView;
 	friend class BPrivate::RecursiveOutlineIterator;
 	friend class BPrivate::OutlineView;
+	friend class BPrivate::RowPositionTree;
+};
+
+// Provides the fields of the rows on demand. If a list view has a row
+// source, its rows may be added without any fields; FetchRow() is then
+// called to fill them in via BRow::SetField() only once a row is drawn,
+// compared, or measured. The fields of rows that have not been needed for a
+// while are deleted again, so that only the fields of the rows around the
+// visible part of a large list are kept in memory; don't hold on to them.
+// Only the fields of the sort columns are kept, so that sorting does not
+// have to fetch every row again and again.
+// Call BColumnListView::UpdateRow() to have a row fetched anew.
+class BRowSource {
+public:
+	virtual						~BRowSource();
+
+	virtual	void				FetchRow(BRow* row) = 0;
 };
 
 // Information about a single column in the list.  A column knows
@@ -340,6 +363,9 @@ public:
 
 			void				InvalidateRow(BRow* row);
 
+			void				SetRowSource(BRowSource* source);
+			BRowSource*			RowSource() const;
+
 	// Appearance (DEPRECATED)
 			void				GetFont(BFont* font) const
 									{ BView::GetFont(font); }
@@ -29,6 +29,9 @@ void		set_workspaces_layout(uint32 columns, uint32 rows);
 bool		get_control_look(BString& path);
 status_t	set_control_look(const BString& path);
 
+bool		get_compositing();
+void		set_compositing(bool compositing);
+
 }	// namespace BPrivate
 
 
@@ -1,5 +1,5 @@
 /*
- * Copyright 2001-2010, Haiku, Inc.
+ * Copyright 2001-2026, Haiku, Inc.
  * Distributed under the terms of the MIT License.
  */
 
@@ -68,7 +68,10 @@ _BTextViewSupportBuffer_<T>::InsertItemsAt(int32 inNumItems,
 	int32 delta = inNumItems * sizeof(T);
 	int32 logSize = fItemCount * sizeof(T);
 	if ((logSize + delta) >= fBufferCount) {
-		fBufferCount = logSize + delta + (fExtraCount * sizeof(T));
+		// grow by at least half of the current size, so that adding items one
+		// at a time doesn't copy the whole buffer each time
+		fBufferCount = logSize + delta
+			+ max_c((int32)(fExtraCount * sizeof(T)), logSize / 2);
 		fBuffer = (T*)realloc((void*)fBuffer, fBufferCount);
 		if (fBuffer == NULL)
 			debugger("InsertItemsAt(): reallocation failed");
@@ -100,9 +103,13 @@ _BTextViewSupportBuffer_<T>::RemoveItemsAt(int32 inNumItems,
 
 	int32 delta = inNumItems * sizeof(T);
 	int32 logSize = fItemCount * sizeof(T);
-	uint32 extraSize = fBufferCount - (logSize - delta);
-	if (extraSize > (fExtraCount * sizeof(T))) {
-		fBufferCount = (logSize - delta) + (fExtraCount * sizeof(T));
+	int32 newSize = logSize - delta;
+	uint32 extraSize = fBufferCount - newSize;
+	if (extraSize > (fExtraCount * sizeof(T)) && extraSize > (uint32)newSize) {
+		// only shrink when less than half of the buffer is used, or the
+		// slack that InsertItemsAt() leaves would be given back right away
+		fBufferCount = newSize
+			+ max_c((int32)(fExtraCount * sizeof(T)), newSize / 2);
 		fBuffer = (T*)realloc(fBuffer, fBufferCount);
 		if (fBuffer == NULL)
 			debugger("RemoveItemsAt(): reallocation failed");
@@ -1,5 +1,5 @@
 /*
- * Copyright 2003-2010, Haiku, Inc.
+ * Copyright 2003-2026, Haiku, Inc.
  * Distributed under the terms of the MIT License.
  */
 #ifndef __WIDTHBUFFER_H
@@ -47,7 +47,9 @@ private:
 
 			bool				GetEscapement(uint32 value, int32 index,
 									float* escapement);
-			float				HashEscapements(const char* chars,
+			void				InsertEscapement(uint32 value, int32 index,
+									float escapement);
+			void				HashEscapements(const char* chars,
 									int32 numChars, int32 numBytes,
 									int32 tableIndex, const BFont* font);
 
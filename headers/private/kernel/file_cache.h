@@ -44,6 +44,11 @@ extern void cache_node_closed(struct vnode *vnode, VMCache *cache,
 extern void cache_node_launched(size_t argCount, char * const *args);
 extern void cache_prefetch_vnode(struct vnode *vnode, off_t offset, size_t size);
 extern void cache_prefetch(dev_t mountID, ino_t vnodeID, off_t offset, size_t size);
+extern status_t cache_wire_vnode_pages(struct vnode *vnode, void *cookie,
+				off_t offset, size_t *_size, struct vm_page **pages,
+				uint32 *_count, VMCache **_cache);
+extern void cache_unwire_vnode_pages(VMCache *cache, struct vm_page **pages,
+				uint32 count);
 
 extern status_t file_map_init(void);
 extern status_t file_cache_init_post_boot_device(void);
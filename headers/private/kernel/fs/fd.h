@@ -90,6 +90,8 @@ extern status_t deselect_fd(int32 fd, struct select_info *info, bool kernel);
 extern bool fd_is_valid(int fd, bool kernel);
 extern struct vnode *fd_vnode(struct file_descriptor *descriptor);
 extern bool fd_is_file(struct file_descriptor* descriptor);
+extern ssize_t fd_copy_data(struct file_descriptor* from, off_t* _fromPos,
+	struct file_descriptor* to, off_t* _toPos, size_t length);
 
 extern bool fd_close_on_exec(const struct io_context *context, int fd);
 extern void fd_set_close_on_exec(struct io_context *context, int fd,
@@ -38,6 +38,8 @@ extern status_t _user_start_watching(dev_t device, ino_t node, uint32 flags,
 					port_id port, uint32 token);
 extern status_t _user_stop_watching(dev_t device, ino_t node, port_id port,
 					uint32 token);
+extern area_id _user_set_node_monitor_ring(port_id port, uint32 token,
+					size_t size, void** _address);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,29 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _KERNEL_IO_RING_H
+#define _KERNEL_IO_RING_H
+
+
+#include <OS.h>
+
+#include <io_ring_defs.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+extern int		_user_io_ring_create(uint32 entries, uint32 flags,
+					void** _address);
+extern ssize_t	_user_io_ring_enter(int ring, uint32 toSubmit,
+					uint32 minComplete, uint32 flags, bigtime_t timeout);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* _KERNEL_IO_RING_H */
@@ -44,6 +44,9 @@ void timer_init_post_rtc(void);
 void timer_real_time_clock_changed();
 int32 timer_interrupt(void);
 
+status_t add_timer_etc(timer* event, timer_hook hook, bigtime_t period,
+	int32 flags, bigtime_t slack);
+
 #ifdef __cplusplus
 }
 #endif
@@ -106,6 +106,8 @@ status_t	vfs_write_pages(struct vnode *vnode, void *cookie, off_t pos,
 				generic_size_t *_numBytes);
 status_t	vfs_vnode_io(struct vnode* vnode, void* cookie,
 				io_request* request);
+status_t	vfs_asynchronous_vnode_io(struct vnode* vnode, void* cookie,
+				io_request* request);
 status_t	vfs_synchronous_io(io_request* request,
 				status_t (*doIO)(void* cookie, off_t offset, void* buffer,
 					size_t* length),
@@ -254,6 +256,8 @@ int			_user_dup2(int ofd, int nfd, int flags);
 status_t	_user_lock_node(int fd);
 status_t	_user_unlock_node(int fd);
 status_t	_user_preallocate(int fd, off_t offset, off_t length);
+ssize_t		_user_copy_file_range(int fromFD, off_t *_fromPos, int toFD,
+				off_t *_toPos, size_t length, uint32 flags);
 
 /* socket user prototypes (implementation in socket.cpp) */
 int			_user_socket(int family, int type, int protocol);
@@ -269,10 +273,15 @@ ssize_t		_user_recv(int socket, void *data, size_t length, int flags);
 ssize_t		_user_recvfrom(int socket, void *data, size_t length, int flags,
 				struct sockaddr *address, socklen_t *_addressLength);
 ssize_t		_user_recvmsg(int socket, struct msghdr *message, int flags);
+ssize_t		_user_recvmmsg(int socket, struct mmsghdr *messages,
+				unsigned int count, int flags, bigtime_t timeout);
 ssize_t		_user_send(int socket, const void *data, size_t length, int flags);
 ssize_t		_user_sendto(int socket, const void *data, size_t length, int flags,
 				const struct sockaddr *address, socklen_t addressLength);
 ssize_t		_user_sendmsg(int socket, const struct msghdr *message, int flags);
+ssize_t		_user_sendmmsg(int socket, struct mmsghdr *messages,
+				unsigned int count, int flags);
+ssize_t		_user_sendfile(int socket, int fd, off_t *_pos, size_t length);
 status_t	_user_getsockopt(int socket, int level, int option, void *value,
 				socklen_t *_length);
 status_t	_user_setsockopt(int socket, int level, int option,
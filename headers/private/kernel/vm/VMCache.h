@@ -394,8 +394,10 @@ vm_page::DecrementWiredCount()
 {
 	ASSERT_PRINT(fWiredCount > 0, "page: %#" B_PRIx64, physical_page_number * B_PAGE_SIZE);
 
-	if (--fWiredCount == 0)
+	if (--fWiredCount == 0 && cache_ref != NULL) {
+		// a lent page might have been removed from its cache already
 		cache_ref->cache->DecrementWiredPagesCount();
+	}
 }
 
 
@@ -149,7 +149,8 @@ public:
 	bool					busy_writing : 1;
 	bool					accessed : 1;
 	bool					modified : 1;
-	uint8					_unused : 1;
+	bool					lent : 1;
+								// wired by the file cache for someone else
 
 	uint8					usage_count;
 
@@ -209,7 +210,7 @@ vm_page::Init(page_num_t pageNumber)
 	InitState(PAGE_STATE_FREE);
 	busy = busy_writing = false;
 	accessed = modified = false;
-	_unused = 0;
+	lent = false;
 	usage_count = 0;
 
 	fWiredCount = 0;
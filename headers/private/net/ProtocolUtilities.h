@@ -120,6 +120,8 @@ public:
 			net_buffer*			Dequeue(bool clone);
 			status_t			BlockingDequeue(bool peek, bigtime_t timeout,
 									net_buffer** _buffer);
+			ssize_t				DequeueMultiple(uint32 flags,
+									net_buffer** _buffers, size_t count);
 
 			void				Clear();
 
@@ -263,6 +265,37 @@ DECL_DATAGRAM_SOCKET(inline status_t)::BlockingDequeue(bool peek,
 }
 
 
+/*!	Waits for the first buffer as Dequeue() does, and then removes up to
+	\a count of the queued buffers at once.
+*/
+DECL_DATAGRAM_SOCKET(inline ssize_t)::DequeueMultiple(uint32 flags,
+	net_buffer** _buffers, size_t count)
+{
+	if ((flags & ~MSG_DONTWAIT) != 0)
+		return EOPNOTSUPP;
+
+	bigtime_t timeout = _SocketTimeout(flags);
+
+	AutoLocker _(fLock);
+
+	while (fBuffers.IsEmpty()) {
+		status_t status = SocketStatus(false);
+		if (status != B_OK)
+			return status;
+
+		status = _Wait(timeout);
+		if (status != B_OK)
+			return status;
+	}
+
+	size_t dequeued = 0;
+	while (dequeued < count && !fBuffers.IsEmpty())
+		_buffers[dequeued++] = _Dequeue(false);
+
+	return dequeued;
+}
+
+
 DECL_DATAGRAM_SOCKET(inline void)::Clear()
 {
 	AutoLocker _(fLock);
@@ -28,6 +28,9 @@ enum {
 
 	ETHER_SEND_NET_BUFFER,					/* send a net_buffer */
 	ETHER_RECEIVE_NET_BUFFER,				/* receive a net_buffer */
+	ETHER_GET_OFFLOADS,
+		/* get the work the device can do on sent net_buffers (uint32 *,
+		   NET_DEVICE_OFFLOAD_* from net_device.h) */
 };
 
 
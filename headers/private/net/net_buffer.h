@@ -19,6 +19,9 @@
 enum net_buffer_flags {
 	NET_BUFFER_L3_CHECKSUM_VALID = (1 << 0),
 	NET_BUFFER_L4_CHECKSUM_VALID = (1 << 1),
+	NET_BUFFER_L4_CHECKSUM_PARTIAL = (1 << 2),
+		// outgoing only: the L4 checksum field only contains the sum of the
+		// pseudo header, the device has to complete it
 };
 
 
@@ -42,8 +45,20 @@ typedef struct net_buffer {
 	uint32					size;
 	uint8					protocol;
 	uint16					buffer_flags;
+	uint16					segment_size;
+		// if not 0, the device has to split the TCP payload into segments
+		// of this size
 } net_buffer;
 
+/*!	Memory that is not owned by the net_buffer module, but can be referred
+	to by net_buffers without copying it. The \c free hook is called once
+	the last reference is gone.
+*/
+typedef struct net_buffer_external {
+	int32					ref_count;
+	void					(*free)(struct net_buffer_external* external);
+} net_buffer_external;
+
 struct ancillary_data_container;
 
 struct net_buffer_module_info {
@@ -74,6 +89,8 @@ struct net_buffer_module_info {
 	status_t		(*trim)(net_buffer* buffer, size_t newSize);
 	status_t		(*append_cloned)(net_buffer* buffer, net_buffer* source,
 						uint32 offset, size_t bytes);
+	status_t		(*append_external)(net_buffer* buffer, const void* data,
+						size_t bytes, net_buffer_external* external);
 
 	status_t		(*associate_data)(net_buffer* buffer, void* data);
 
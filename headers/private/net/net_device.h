@@ -14,6 +14,17 @@
 typedef struct net_buffer net_buffer;
 
 
+// net_device::offloads
+enum {
+	NET_DEVICE_OFFLOAD_CHECKSUM_IPV4	= 0x01,
+		// completes TCP/UDP checksums over IPv4
+	NET_DEVICE_OFFLOAD_CHECKSUM_IPV6	= 0x02,
+	NET_DEVICE_OFFLOAD_TSO_IPV4			= 0x04,
+		// splits TCP segments over IPv4 into net_buffer::segment_size pieces
+	NET_DEVICE_OFFLOAD_TSO_IPV6			= 0x08,
+};
+
+
 struct net_hardware_address {
 	uint8	data[64];
 	uint8	length;
@@ -31,6 +42,7 @@ typedef struct net_device {
 	uint64	link_speed;
 	uint32	link_quality;
 	size_t	header_length;
+	uint32	offloads;	// NET_DEVICE_OFFLOAD_*
 
 	struct net_hardware_address address;
 
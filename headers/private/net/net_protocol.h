@@ -114,6 +114,11 @@ struct net_protocol_module_info {
 					size_t vecCount, ancillary_data_container** _ancillaryData,
 					struct sockaddr* _address, socklen_t* _addressLength,
 					int flags);
+
+	status_t	(*send_data_multiple)(net_protocol* self, net_buffer** buffers,
+					size_t count, size_t* _sent);
+	ssize_t		(*read_data_multiple)(net_protocol* self, uint32 flags,
+					net_buffer** _buffers, size_t count);
 };
 
 
@@ -108,11 +108,19 @@ struct net_socket_module_info {
 					size_t length, int flags);
 	ssize_t		(*send)(net_socket* socket, struct msghdr* , const void* data,
 					size_t length, int flags);
+	ssize_t		(*receive_multiple)(net_socket* socket,
+					struct mmsghdr* messages, size_t count, int flags);
+	ssize_t		(*send_multiple)(net_socket* socket, struct mmsghdr* messages,
+					size_t count, int flags);
 	int			(*setsockopt)(net_socket* socket, int level, int option,
 					const void* optionValue, int optionLength);
 	int			(*shutdown)(net_socket* socket, int direction);
 	status_t	(*socketpair)(int family, int type, int protocol,
 					net_socket* _sockets[2]);
+
+	ssize_t		(*send_external)(net_socket* socket, const struct iovec* vecs,
+					size_t vecCount, net_buffer_external* external,
+					int flags);
 };
 
 
@@ -17,6 +17,7 @@
 	"network/stack/userland_interface/v1"
 
 
+struct net_buffer_external;
 struct net_socket;
 struct net_stat;
 
@@ -42,6 +43,8 @@ struct net_stack_interface_module_info {
 					int flags, struct sockaddr* address,
 					socklen_t* _addressLength);
 	ssize_t (*recvmsg)(net_socket* socket, struct msghdr* message, int flags);
+	ssize_t (*recvmmsg)(net_socket* socket, struct mmsghdr* messages,
+					size_t count, int flags);
 
 	ssize_t (*send)(net_socket* socket, const void* data, size_t length,
 					int flags);
@@ -50,6 +53,8 @@ struct net_stack_interface_module_info {
 					socklen_t addressLength);
 	ssize_t (*sendmsg)(net_socket* socket, const struct msghdr* message,
 					int flags);
+	ssize_t (*sendmmsg)(net_socket* socket, struct mmsghdr* messages,
+					size_t count, int flags);
 
 	status_t (*getsockopt)(net_socket* socket, int level, int option,
 					void* value, socklen_t* _length);
@@ -75,6 +80,10 @@ struct net_stack_interface_module_info {
 
 	status_t (*get_next_socket_stat)(int family, uint32 *cookie,
 					struct net_stat *stat);
+
+	ssize_t (*send_external)(net_socket* socket, const struct iovec* vecs,
+					size_t vecCount, struct net_buffer_external* external,
+					int flags);
 };
 
 
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _IO_RING_H
+#define _IO_RING_H
+
+
+#include <OS.h>
+
+#include <io_ring_defs.h>
+
+
+namespace BPrivate {
+
+
+/*!	Submits I/O operations to the kernel without blocking, and collects their
+	results, through a pair of queues shared with the kernel.
+
+	Queue operations with Read(), Write(), and friends, hand them to the
+	kernel with Submit(), and look for results with GetCompletion(), or wait
+	for them with WaitForCompletion(). The \a userData of an operation is
+	passed back with its result, which is the number of bytes transferred,
+	the new socket of an accept, or a negative error code.
+
+	With IO_RING_SQ_POLL, a kernel thread picks up new operations, so that
+	Submit() only needs a syscall when that thread went to sleep.
+
+	An IORing must only be used by one thread at a time.
+*/
+class IORing {
+public:
+								IORing();
+								~IORing();
+
+			status_t			Init(uint32 entries, uint32 flags = 0);
+			void				Unset();
+			status_t			InitCheck() const;
+
+			uint32				Entries() const	{ return fSubmissionCount; }
+
+			status_t			Nop(uint64 userData);
+			status_t			Read(int fd, void* buffer, size_t length,
+									off_t offset, uint64 userData);
+			status_t			Write(int fd, const void* buffer,
+									size_t length, off_t offset,
+									uint64 userData);
+			status_t			Sync(int fd, uint64 userData);
+			status_t			Send(int socket, const void* buffer,
+									size_t length, int flags,
+									uint64 userData);
+			status_t			Receive(int socket, void* buffer,
+									size_t length, int flags,
+									uint64 userData);
+			status_t			Accept(int socket, int flags,
+									uint64 userData);
+
+			ssize_t				Submit(uint32 waitForCompletions = 0,
+									bigtime_t timeout = B_INFINITE_TIMEOUT);
+
+			bool				GetCompletion(io_ring_cqe& completion);
+			status_t			WaitForCompletion(io_ring_cqe& completion,
+									bigtime_t timeout = B_INFINITE_TIMEOUT);
+
+private:
+								IORing(const IORing&);
+			IORing&				operator=(const IORing&);
+
+			io_ring_sqe*		_NextSubmission(uint8 opcode, int fd,
+									uint64 userData);
+
+private:
+			int					fFD;
+			uint32				fFlags;
+			io_ring_header*		fHeader;
+			io_ring_sqe*		fSubmissions;
+			io_ring_cqe*		fCompletions;
+			uint32				fSubmissionCount;
+			uint32				fCompletionCount;
+			uint32				fSubmissionTail;
+};
+
+
+}	// namespace BPrivate
+
+
+using BPrivate::IORing;
+
+
+#endif	// _IO_RING_H
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _NODE_MONITOR_RING_H
+#define _NODE_MONITOR_RING_H
+
+
+#include <Messenger.h>
+#include <NodeMonitor.h>
+
+#include <node_monitor_private.h>
+	// for B_NODE_MONITOR_EVENTS_LOST
+
+
+namespace BPrivate {
+
+
+/*!	Lets the kernel deliver the node monitor events of a target through a
+	ring in shared memory instead of sending a message for each of them.
+	Repeated stat and attribute changes of a node are merged while the target
+	did not get to them yet.
+
+	The ring must be set up before the target starts watching anything. The
+	target then only gets a B_NODE_MONITOR message when there are new events,
+	and uses GetNextEvent() or DispatchEvents() to retrieve them as classic
+	node monitor messages. If the ring was full, a message with the opcode
+	B_NODE_MONITOR_EVENTS_LOST, and the number of dropped events as "count"
+	takes the place of the missing events:
+
+		case B_NODE_MONITOR:
+			if (fRing.IsReadyMessage(message)) {
+				fRing.DispatchEvents(this);
+				break;
+			}
+			...
+*/
+class BNodeMonitorRing {
+public:
+								BNodeMonitorRing();
+								~BNodeMonitorRing();
+
+			status_t			SetTo(const BMessenger& target,
+									size_t size = kDefaultSize);
+			void				Unset();
+			status_t			InitCheck() const;
+
+			bool				IsReadyMessage(const BMessage* message) const;
+
+			status_t			GetNextEvent(BMessage& event);
+			int32				DispatchEvents(BHandler* handler);
+
+			uint32				LostEvents() const;
+
+	static	const size_t		kDefaultSize = 256 * 1024;
+
+private:
+								BNodeMonitorRing(const BNodeMonitorRing&);
+			BNodeMonitorRing&	operator=(const BNodeMonitorRing&);
+
+private:
+			BMessenger			fTarget;
+			area_id				fArea;
+			node_monitor_ring_header* fHeader;
+			uint8*				fBuffer;
+			uint32				fSize;
+};
+
+
+}	// namespace BPrivate
+
+
+using BPrivate::BNodeMonitorRing;
+
+
+#endif	// _NODE_MONITOR_RING_H
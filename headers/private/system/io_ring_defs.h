@@ -0,0 +1,95 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _SYSTEM_IO_RING_DEFS_H
+#define _SYSTEM_IO_RING_DEFS_H
+
+
+#include <SupportDefs.h>
+
+
+#define IO_RING_MAGIC				'iorg'
+#define IO_RING_MAX_ENTRIES			4096
+	// maximum number of submission entries, the completion queue has twice
+	// as many
+
+
+// _kern_io_ring_create() flags
+enum {
+	IO_RING_SQ_POLL				= 0x01
+		// a kernel thread picks up new submissions without a syscall; it sets
+		// IO_RING_SQ_NEED_WAKEUP when it went to sleep
+};
+
+// _kern_io_ring_enter() flags
+enum {
+	IO_RING_ENTER_GET_EVENTS	= 0x01,
+		// wait until the requested number of completions is available
+	IO_RING_ENTER_SQ_WAKEUP		= 0x02
+		// wake up the polling thread
+};
+
+// io_ring_header::flags
+enum {
+	IO_RING_SQ_NEED_WAKEUP		= 0x01
+};
+
+// io_ring_sqe::opcode
+enum {
+	IO_RING_OP_NOP				= 0,
+	IO_RING_OP_READ,
+		// read_pos(), or read() with an offset of -1
+	IO_RING_OP_WRITE,
+		// write_pos(), or write() with an offset of -1
+	IO_RING_OP_FSYNC,
+	IO_RING_OP_SEND,
+	IO_RING_OP_RECV,
+	IO_RING_OP_ACCEPT
+		// the result is the new socket, the peer address is not returned
+};
+
+
+/*!	The header of an I/O ring; the submission and completion entries follow
+	at the given offsets in the same area.
+	Only the application writes "sq_tail" and "cq_head", only the kernel
+	writes "sq_head" and "cq_tail". All of them are entry counters that are
+	only ever increased, and are wrapped at the number of entries of their
+	queue, which is a power of two.
+*/
+typedef struct io_ring_header {
+	uint32		magic;
+	uint32		sq_entries;
+	uint32		cq_entries;
+	uint32		sq_offset;
+	uint32		cq_offset;
+	int32		flags;
+
+	uint32		sq_head __attribute__((aligned(64)));
+	uint32		sq_tail;
+	uint32		cq_head __attribute__((aligned(64)));
+	uint32		cq_tail;
+} io_ring_header;
+
+
+typedef struct io_ring_sqe {
+	uint8		opcode;
+	uint8		reserved[3];
+	int32		fd;
+	off_t		offset;
+	uint64		address;
+	uint32		length;
+	int32		op_flags;
+		// the flags of send(), recv(), and accept()
+	uint64		user_data;
+} io_ring_sqe;
+
+
+typedef struct io_ring_cqe {
+	uint64		user_data;
+	int64		result;
+		// the number of bytes transferred, the new socket, or an error code
+} io_ring_cqe;
+
+
+#endif	/* _SYSTEM_IO_RING_DEFS_H */
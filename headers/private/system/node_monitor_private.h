@@ -1,14 +1,79 @@
 /*
  * Copyright 2010, Clemens Zeidler, haiku@clemens-zeidler.de.
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
  * Distributed under the terms of the MIT License.
  */
 #ifndef _NODE_MONITOR_PRIVATE_H
 #define _NODE_MONITOR_PRIVATE_H
 
 
+#include <SupportDefs.h>
+
+
 enum {
 	B_WATCH_VOLUME	= 0xF000
 };
 
 
-#endif	/* _NODE_MONITOR_PRIVATE_H */ 
+// private opcodes of B_NODE_MONITOR messages (the public ones are defined in
+// <NodeMonitor.h>)
+enum {
+	B_NODE_MONITOR_RING_PADDING		= 0,
+		// only used in the ring; the rest of the ring buffer is unused
+	B_NODE_MONITOR_RING_READY		= 0x100,
+		// the ring of the target contains new events
+	B_NODE_MONITOR_EVENTS_LOST		= 0x101
+		// the ring was full, and "count" events have been dropped
+};
+
+
+#define NODE_MONITOR_RING_MAGIC			'nmrg'
+#define NODE_MONITOR_RING_MIN_SIZE		(16 * 1024)
+#define NODE_MONITOR_RING_MAX_SIZE		(4 * 1024 * 1024)
+#define NODE_MONITOR_RING_EVENT_CONSUMED	(1UL << 31)
+
+
+/*!	The header of a node monitor ring, followed by the ring buffer on the next
+	page.
+	Only the kernel writes "head", and only the consumer writes "tail"; both
+	are byte positions that are only ever increased, and are wrapped at the
+	size of the buffer, which is a power of two.
+*/
+typedef struct node_monitor_ring_header {
+	uint32		magic;
+	uint32		size;
+	uint32		head;
+	uint32		tail;
+	uint32		lost_events;
+		// total number of events that were dropped
+	int32		wakeup_pending;
+		// set when the kernel sent a B_NODE_MONITOR_RING_READY message, the
+		// consumer must clear it before it looks at "head"
+} node_monitor_ring_header;
+
+
+/*!	An event in the ring. Records are 8 byte aligned, and never wrap around
+	the end of the buffer.
+	"state" contains the stat fields of a B_STAT_CHANGED, the cause of a
+	B_ATTR_CHANGED, and the number of dropped events for a
+	B_NODE_MONITOR_EVENTS_LOST event. While the consumer did not set
+	NODE_MONITOR_RING_EVENT_CONSUMED in it, the kernel may merge further
+	changes of the same node into the event.
+*/
+typedef struct node_monitor_ring_event {
+	uint32		size;
+	int32		opcode;
+	int32		state;
+	dev_t		device;
+	ino_t		node;
+	ino_t		directory;
+	ino_t		to_directory;
+	dev_t		node_device;
+	uint16		name_length;
+	uint16		from_name_length;
+		// both include the terminating null, "from name" follows "name"
+	char		names[0];
+} node_monitor_ring_event;
+
+
+#endif	/* _NODE_MONITOR_PRIVATE_H */
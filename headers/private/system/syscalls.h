@@ -81,6 +81,11 @@ extern status_t		_kern_event_queue_select(int queue,
 extern ssize_t		_kern_event_queue_wait(int queue, struct event_wait_info* infos,
 						int numInfos, uint32 flags, bigtime_t timeout);
 
+extern int			_kern_io_ring_create(uint32 entries, uint32 flags,
+						void** _address);
+extern ssize_t		_kern_io_ring_enter(int ring, uint32 toSubmit,
+						uint32 minComplete, uint32 flags, bigtime_t timeout);
+
 /* user mutex functions */
 extern status_t		_kern_mutex_lock(int32* mutex, const char* name,
 						uint32 flags, bigtime_t timeout);
@@ -353,6 +358,8 @@ extern status_t		_kern_unlock_node(int fd);
 extern status_t		_kern_get_next_fd_info(team_id team, uint32 *_cookie,
 						struct fd_info *info, size_t infoSize);
 extern status_t		_kern_preallocate(int fd, off_t offset, off_t length);
+extern ssize_t		_kern_copy_file_range(int fromFD, off_t *_fromPos,
+						int toFD, off_t *_toPos, size_t length, uint32 flags);
 
 // socket functions
 extern int			_kern_socket(int family, int type, int protocol);
@@ -371,6 +378,8 @@ extern ssize_t		_kern_recvfrom(int socket, void *data, size_t length,
 						socklen_t *_addressLength);
 extern ssize_t		_kern_recvmsg(int socket, struct msghdr *message,
 						int flags);
+extern ssize_t		_kern_recvmmsg(int socket, struct mmsghdr *messages,
+						unsigned int count, int flags, bigtime_t timeout);
 extern ssize_t		_kern_send(int socket, const void *data, size_t length,
 						int flags);
 extern ssize_t		_kern_sendto(int socket, const void *data, size_t length,
@@ -378,6 +387,10 @@ extern ssize_t		_kern_sendto(int socket, const void *data, size_t length,
 						socklen_t addressLength);
 extern ssize_t		_kern_sendmsg(int socket, const struct msghdr *message,
 						int flags);
+extern ssize_t		_kern_sendmmsg(int socket, struct mmsghdr *messages,
+						unsigned int count, int flags);
+extern ssize_t		_kern_sendfile(int socket, int fd, off_t *_pos,
+						size_t length);
 extern status_t		_kern_getsockopt(int socket, int level, int option,
 						void *value, socklen_t *_length);
 extern status_t		_kern_setsockopt(int socket, int level, int option,
@@ -398,6 +411,8 @@ extern status_t		_kern_start_watching(dev_t device, ino_t node, uint32 flags,
 						port_id port, uint32 token);
 extern status_t		_kern_stop_watching(dev_t device, ino_t node, port_id port,
 						uint32 token);
+extern area_id		_kern_set_node_monitor_ring(port_id port, uint32 token,
+						size_t size, void** _address);
 
 // time functions
 extern status_t		_kern_set_real_time_clock(bigtime_t time);
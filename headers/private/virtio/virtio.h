@@ -36,7 +36,7 @@
 #define VIRTIO_FEATURE_BAD_FEATURE			(1 << 30)
 #define VIRTIO_FEATURE_VERSION_1			(1ULL << 32)
 
-#define VIRTIO_VIRTQUEUES_MAX_COUNT	8
+#define VIRTIO_VIRTQUEUES_MAX_COUNT	32
 
 #define VIRTIO_CONFIG_STATUS_RESET	0x00
 #define VIRTIO_CONFIG_STATUS_ACK	0x01
@@ -9,11 +9,13 @@
 #include <StackOrHeapArray.h>
 #include <util/AutoLock.h>
 #include <virtio.h>
+#include <virtio_block_driver.h>
 
 #include "virtio_blk.h"
 
 
 class DMAResource;
+class IOOperation;
 class IOScheduler;
 
 
@@ -48,17 +50,59 @@ static const uint8 kDriveIcon[] = {
 #define VIRTIO_BLOCK_DEVICE_MODULE_NAME "drivers/disk/virtual/virtio_block/device_v1"
 #define VIRTIO_BLOCK_DEVICE_ID_GENERATOR	"virtio_block/device_id"
 
+#define VIRTIO_BLOCK_QUEUE_REQUESTS		64
+
+
+struct virtio_block_driver_info;
+
+
+// The part of a request the device accesses
+typedef struct {
+	struct virtio_blk_outhdr	header;
+	struct virtio_blk_discard_write_zeroes segment;
+	uint8						ack;
+} _PACKED virtio_block_command;
+
+
+typedef struct virtio_block_request {
+	virtio_block_command*		command;
+	phys_addr_t					physAddr;
+	IOOperation*				operation;
+	bool						waiting;
+	bool						done;
+	virtio_block_request*		next;
+} virtio_block_request;
+
 
 typedef struct {
+	virtio_block_driver_info*	info;
+	::virtio_queue				queue;
+
+	spinlock					lock;
+	virtio_block_request		requests[VIRTIO_BLOCK_QUEUE_REQUESTS];
+	virtio_block_request*		freeRequests;
+	ConditionVariable			condition;
+
+	// statistics
+	int32						inFlight;
+	int32						maxInFlight;
+	int64						submitted;
+	int64						waits;
+} virtio_block_queue;
+
+
+typedef struct virtio_block_driver_info {
 	device_node*			node;
 	::virtio_device			virtio_device;
 	virtio_device_interface*	virtio;
-	::virtio_queue			virtio_queue;
 	IOScheduler*			io_scheduler;
 	DMAResource*			dma_resource;
 
 	struct virtio_blk_config	config;
 
+	virtio_block_queue*		queues;
+	uint32					queueCount;
+
 	area_id					bufferArea;
 	addr_t					bufferAddr;
 	phys_addr_t				bufferPhysAddr;
@@ -69,9 +113,7 @@ typedef struct {
 	uint32					physical_block_size;
 	status_t				media_status;
 
-	mutex					lock;
-	int32					currentRequest;
-	ConditionVariable		interruptCondition;
+	virtio_block_driver_info*	next;
 } virtio_block_driver_info;
 
 
@@ -85,6 +127,8 @@ typedef struct {
 #include <stdlib.h>
 
 #include <fs/devfs.h>
+#include <kernel.h>
+#include <smp.h>
 
 #include "dma_resources.h"
 #include "IORequest.h"
@@ -103,6 +147,9 @@ typedef struct {
 
 static device_manager_info* sDeviceManager;
 
+static mutex sDeviceListLock = MUTEX_INITIALIZER("virtio block devices");
+static virtio_block_driver_info* sDeviceList;
+
 
 bool virtio_block_set_capacity(virtio_block_driver_info* info);
 
@@ -131,6 +178,12 @@ get_feature_name(uint64 feature)
 			return "topology";
 		case VIRTIO_BLK_F_CONFIG_WCE:
 			return "config wce";
+		case VIRTIO_BLK_F_MQ:
+			return "multiqueue";
+		case VIRTIO_BLK_F_DISCARD:
+			return "discard command";
+		case VIRTIO_BLK_F_WRITE_ZEROES:
+			return "write zeroes command";
 	}
 	return NULL;
 }
@@ -174,88 +227,483 @@ virtio_block_config_callback(void* driverCookie)
 }
 
 
+//	#pragma mark - requests
+
+
+/*!	Requests are submitted to the queue of the current CPU, so that
+	submissions from different CPUs do not contend for the same lock, and
+	the device can work on them in parallel.
+*/
+static inline virtio_block_queue*
+virtio_block_current_queue(virtio_block_driver_info* info)
+{
+	return &info->queues[smp_get_current_cpu() % info->queueCount];
+}
+
+
+//!	Waits for a request of the queue to complete. The queue must be locked.
+static void
+virtio_block_wait(virtio_block_queue* queue, InterruptsSpinLocker& locker)
+{
+	ConditionVariableEntry entry;
+	queue->condition.Add(&entry);
+	queue->waits++;
+
+	locker.Unlock();
+	entry.Wait();
+	locker.Lock();
+}
+
+
+static virtio_block_request*
+virtio_block_get_request(virtio_block_queue* queue,
+	InterruptsSpinLocker& locker)
+{
+	while (queue->freeRequests == NULL)
+		virtio_block_wait(queue, locker);
+
+	virtio_block_request* request = queue->freeRequests;
+	queue->freeRequests = request->next;
+
+	request->operation = NULL;
+	request->waiting = false;
+	request->done = false;
+	request->command->ack = 0xff;
+	return request;
+}
+
+
+static void
+virtio_block_put_request(virtio_block_queue* queue,
+	virtio_block_request* request)
+{
+	request->next = queue->freeRequests;
+	queue->freeRequests = request;
+}
+
+
+/*!	Hands the request over to the device. If there is no room in the ring,
+	this waits for earlier requests to complete. The queue must be locked.
+*/
+static status_t
+virtio_block_submit(virtio_block_driver_info* info, virtio_block_queue* queue,
+	virtio_block_request* request, const physical_entry* entries,
+	size_t readCount, size_t writtenCount, InterruptsSpinLocker& locker)
+{
+	while (true) {
+		status_t status = info->virtio->queue_request_v(queue->queue, entries,
+			readCount, writtenCount, request);
+		if (status == B_OK)
+			break;
+		if (status != B_BUSY || queue->inFlight == 0)
+			return status;
+
+		virtio_block_wait(queue, locker);
+	}
+
+	queue->submitted++;
+	if (++queue->inFlight > queue->maxInFlight)
+		queue->maxInFlight = queue->inFlight;
+	return B_OK;
+}
+
+
+static status_t
+virtio_block_request_status(virtio_block_request* request)
+{
+	switch (request->command->ack) {
+		case VIRTIO_BLK_S_OK:
+			return B_OK;
+		case VIRTIO_BLK_S_UNSUPP:
+			return ENOTSUP;
+		default:
+			return EIO;
+	}
+}
+
+
 static void
 virtio_block_callback(void* driverCookie, void* _cookie)
 {
-	virtio_block_driver_info* info = (virtio_block_driver_info*)_cookie;
+	virtio_block_queue* queue = (virtio_block_queue*)_cookie;
+	virtio_block_driver_info* info = queue->info;
+
+	while (true) {
+		InterruptsSpinLocker locker(queue->lock);
 
-	void* cookie = NULL;
-	while (info->virtio->queue_dequeue(info->virtio_queue, &cookie, NULL)) {
-		if ((int32)(addr_t)cookie == atomic_get(&info->currentRequest))
-			info->interruptCondition.NotifyAll();
+		void* cookie = NULL;
+		if (!info->virtio->queue_dequeue(queue->queue, &cookie, NULL))
+			break;
+
+		virtio_block_request* request = (virtio_block_request*)cookie;
+		IOOperation* operation = request->operation;
+		status_t status = virtio_block_request_status(request);
+
+		queue->inFlight--;
+		if (operation == NULL && request->waiting)
+			request->done = true;
+		else
+			virtio_block_put_request(queue, request);
+		queue->condition.NotifyAll();
+
+		locker.Unlock();
+
+		if (operation != NULL) {
+			info->io_scheduler->OperationCompleted(operation, status,
+				status == B_OK ? operation->Length() : 0);
+		}
 	}
 }
 
 
+/*!	Executes a command that does not transfer any data of the disk, and
+	waits for it to complete.
+*/
+static status_t
+virtio_block_command_sync(virtio_block_driver_info* info, uint32 type,
+	uint64 sector, uint32 sectorCount, uint32 flags)
+{
+	virtio_block_queue* queue = virtio_block_current_queue(info);
+
+	InterruptsSpinLocker locker(queue->lock);
+	virtio_block_request* request = virtio_block_get_request(queue, locker);
+	virtio_block_command* command = request->command;
+
+	command->header.type = type;
+	command->header.ioprio = 1;
+	command->header.sector = 0;
+
+	physical_entry entries[3];
+	size_t readCount = 1;
+	entries[0].address = request->physAddr
+		+ offsetof(virtio_block_command, header);
+	entries[0].size = sizeof(struct virtio_blk_outhdr);
+
+	if (type == VIRTIO_BLK_T_DISCARD || type == VIRTIO_BLK_T_WRITE_ZEROES) {
+		command->segment.sector = sector;
+		command->segment.num_sectors = sectorCount;
+		command->segment.flags = flags;
+
+		entries[1].address = request->physAddr
+			+ offsetof(virtio_block_command, segment);
+		entries[1].size = sizeof(struct virtio_blk_discard_write_zeroes);
+		readCount++;
+	}
+
+	entries[readCount].address = request->physAddr
+		+ offsetof(virtio_block_command, ack);
+	entries[readCount].size = sizeof(uint8);
+
+	request->waiting = true;
+	status_t status = virtio_block_submit(info, queue, request, entries,
+		readCount, 1, locker);
+	if (status != B_OK) {
+		virtio_block_put_request(queue, request);
+		return status;
+	}
+
+	bigtime_t timeout = system_time() + 10 * 1000 * 1000;
+	while (!request->done) {
+		ConditionVariableEntry entry;
+		queue->condition.Add(&entry);
+
+		locker.Unlock();
+		status = entry.Wait(B_ABSOLUTE_TIMEOUT, timeout);
+		locker.Lock();
+
+		if (status == B_TIMED_OUT && !request->done) {
+			// the request will be freed once the device is done with it
+			request->waiting = false;
+			return B_TIMED_OUT;
+		}
+	}
+
+	status = virtio_block_request_status(request);
+	virtio_block_put_request(queue, request);
+	return status;
+}
+
+
+/*!	Called by the I/O scheduler for each operation. The operation is only
+	submitted to the device here; it is completed from the interrupt
+	handler, so that many operations can be in flight at the same time.
+*/
 static status_t
 do_io(void* cookie, IOOperation* operation)
 {
 	virtio_block_driver_info* info = (virtio_block_driver_info*)cookie;
 
-	MutexTryLocker locker(&info->lock);
-	if (!locker.IsLocked())
-		return B_BUSY;
-
 	BStackOrHeapArray<physical_entry, 16> entries(operation->VecCount() + 2);
+	if (!entries.IsValid()) {
+		info->io_scheduler->OperationCompleted(operation, B_NO_MEMORY, 0);
+		return B_NO_MEMORY;
+	}
 
-	struct virtio_blk_outhdr *header = (struct virtio_blk_outhdr*)info->bufferAddr;
-	header->type = operation->IsWrite() ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
-	header->sector = operation->Offset() / 512;
-	header->ioprio = 1;
+	virtio_block_queue* queue = virtio_block_current_queue(info);
 
-	uint8* ack = (uint8*)info->bufferAddr + sizeof(struct virtio_blk_outhdr);
-	*ack = 0xff;
+	InterruptsSpinLocker locker(queue->lock);
+	virtio_block_request* request = virtio_block_get_request(queue, locker);
+	virtio_block_command* command = request->command;
 
-	entries[0].address = info->bufferPhysAddr;
+	command->header.type = operation->IsWrite()
+		? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
+	command->header.sector = operation->Offset() / 512;
+	command->header.ioprio = 1;
+
+	entries[0].address = request->physAddr
+		+ offsetof(virtio_block_command, header);
 	entries[0].size = sizeof(struct virtio_blk_outhdr);
-	entries[operation->VecCount() + 1].address = entries[0].address
-		+ sizeof(struct virtio_blk_outhdr);
+	entries[operation->VecCount() + 1].address = request->physAddr
+		+ offsetof(virtio_block_command, ack);
 	entries[operation->VecCount() + 1].size = sizeof(uint8);
 
 	memcpy(entries + 1, operation->Vecs(), operation->VecCount()
 		* sizeof(physical_entry));
 
-	atomic_add(&info->currentRequest, 1);
-
-	ConditionVariableEntry entry;
-	info->interruptCondition.Add(&entry);
+	request->operation = operation;
 
-	status_t result = info->virtio->queue_request_v(info->virtio_queue, entries,
+	status_t status = virtio_block_submit(info, queue, request, entries,
 		1 + (operation->IsWrite() ? operation->VecCount() : 0 ),
-		1 + (operation->IsWrite() ? 0 : operation->VecCount()),
-		(void *)(addr_t)info->currentRequest);
-
-	if (result == B_OK)
-		result = entry.Wait(B_RELATIVE_TIMEOUT, 10 * 1000 * 1000);
-
-	size_t bytesTransferred = 0;
-	status_t status = B_OK;
-	if (result != B_OK) {
-		status = EIO;
-	} else {
-		switch (*ack) {
-			case VIRTIO_BLK_S_OK:
-				status = B_OK;
-				bytesTransferred = operation->Length();
-				break;
-			case VIRTIO_BLK_S_UNSUPP:
-				status = ENOTSUP;
-				break;
-			default:
-				status = EIO;
-				break;
-		}
+		1 + (operation->IsWrite() ? 0 : operation->VecCount()), locker);
+	if (status != B_OK) {
+		virtio_block_put_request(queue, request);
+		locker.Unlock();
+
+		ERROR("submitting request failed: %s\n", strerror(status));
+		info->io_scheduler->OperationCompleted(operation, EIO, 0);
 	}
 
-	info->io_scheduler->OperationCompleted(operation, status,
-		bytesTransferred);
 	return status;
 }
 
 
+static status_t
+virtio_block_flush(virtio_block_driver_info* info)
+{
+	if ((info->features & VIRTIO_BLK_F_FLUSH) == 0)
+		return B_OK;
+
+	return virtio_block_command_sync(info, VIRTIO_BLK_T_FLUSH, 0, 0, 0);
+}
+
+
+/*!	Uses the discard command if available. Otherwise, if the device may
+	deallocate blocks that are written with zeroes, that is used instead.
+*/
+static status_t
+virtio_block_trim(virtio_block_driver_info* info, fs_trim_data* trimData)
+{
+	CALLED();
+	trimData->trimmed_size = 0;
+
+	uint32 type;
+	uint32 maxSectors;
+	uint32 flags = 0;
+	uint64 alignment = info->block_size;
+	if ((info->features & VIRTIO_BLK_F_DISCARD) != 0) {
+		type = VIRTIO_BLK_T_DISCARD;
+		maxSectors = info->config.max_discard_sectors;
+		if (info->config.discard_sector_alignment > 0) {
+			alignment = max_c(alignment,
+				(uint64)info->config.discard_sector_alignment * 512);
+		}
+	} else if ((info->features & VIRTIO_BLK_F_WRITE_ZEROES) != 0
+		&& info->config.write_zeroes_may_unmap != 0) {
+		type = VIRTIO_BLK_T_WRITE_ZEROES;
+		maxSectors = info->config.max_write_zeroes_sectors;
+		flags = VIRTIO_BLK_WRITE_ZEROES_FLAG_UNMAP;
+	} else
+		return B_UNSUPPORTED;
+
+	uint64 maxLength = ROUNDDOWN((uint64)(maxSectors > 0
+		? maxSectors : UINT32_MAX) * 512, alignment);
+	if (maxLength == 0)
+		return B_UNSUPPORTED;
+
+	const uint64 deviceSize = info->capacity * info->block_size;
+	for (uint32 i = 0; i < trimData->range_count; i++) {
+		if (trimData->ranges[i].offset >= deviceSize)
+			return B_BAD_VALUE;
+	}
+
+	for (uint32 i = 0; i < trimData->range_count; i++) {
+		uint64 offset = trimData->ranges[i].offset;
+		uint64 end = offset + min_c(trimData->ranges[i].size,
+			deviceSize - offset);
+
+		// Only whole blocks are trimmed; some space at the beginning and
+		// end may thus be left alone.
+		offset = ROUNDUP(offset, alignment);
+		end = ROUNDDOWN(end, alignment);
+
+		while (offset < end) {
+			uint64 length = min_c(end - offset, maxLength);
+
+			TRACE("trim %" B_PRIu64 " bytes from %" B_PRIu64 "\n", length,
+				offset);
+
+			status_t status = virtio_block_command_sync(info, type,
+				offset / 512, length / 512, flags);
+			if (status != B_OK)
+				return status;
+
+			trimData->trimmed_size += length;
+			offset += length;
+		}
+	}
+
+	return B_OK;
+}
+
+
+static int
+dump_virtio_block(int argc, char** argv)
+{
+	for (virtio_block_driver_info* info = sDeviceList; info != NULL;
+			info = info->next) {
+		kprintf("virtio_block %p: %" B_PRIu32 " queue(s), capacity %" B_PRIu64
+			", block size %" B_PRIu32 "\n", info, info->queueCount,
+			info->capacity, info->block_size);
+
+		for (uint32 i = 0; i < info->queueCount; i++) {
+			virtio_block_queue& queue = info->queues[i];
+			kprintf("  queue %" B_PRIu32 ": in flight %" B_PRId32 ", max %"
+				B_PRId32 ", submitted %" B_PRId64 ", waits %" B_PRId64 "\n",
+				i, queue.inFlight, queue.maxInFlight, queue.submitted,
+				queue.waits);
+		}
+	}
+	return 0;
+}
+
+
+static status_t
+virtio_block_get_statistics(virtio_block_driver_info* info, void* buffer,
+	size_t length)
+{
+	if (buffer == NULL || length != sizeof(virtio_block_statistics))
+		return B_BAD_VALUE;
+
+	virtio_block_statistics statistics;
+	memset(&statistics, 0, sizeof(statistics));
+	statistics.queue_count = info->queueCount;
+
+	for (uint32 i = 0; i < info->queueCount; i++) {
+		virtio_block_queue& queue = info->queues[i];
+		virtio_block_queue_statistics& queueStatistics
+			= statistics.queues[i];
+
+		InterruptsSpinLocker locker(queue.lock);
+		queueStatistics.in_flight = queue.inFlight;
+		queueStatistics.max_in_flight = queue.maxInFlight;
+		queueStatistics.submitted = queue.submitted;
+		queueStatistics.waits = queue.waits;
+	}
+
+	return user_memcpy(buffer, &statistics, sizeof(statistics));
+}
+
+
 //	#pragma mark - device module API
 
 
+//!	Frees what virtio_block_init_queues() allocated, except the virtio queues.
+static void
+virtio_block_free_queues(virtio_block_driver_info* info)
+{
+	if (info->bufferArea >= 0)
+		delete_area(info->bufferArea);
+	info->bufferArea = -1;
+
+	delete[] info->queues;
+	info->queues = NULL;
+	info->queueCount = 0;
+}
+
+
+static status_t
+virtio_block_init_queues(virtio_block_driver_info* info)
+{
+	uint32 queueCount = 1;
+	if ((info->features & VIRTIO_BLK_F_MQ) != 0)
+		queueCount = max_c(info->config.num_queues, 1);
+	queueCount = min_c(queueCount, (uint32)smp_get_num_cpus());
+	queueCount = min_c(queueCount, VIRTIO_BLOCK_MAX_QUEUES);
+
+	TRACE("using %" B_PRIu32 " queue(s)\n", queueCount);
+
+	info->queues = new(std::nothrow) virtio_block_queue[queueCount];
+	if (info->queues == NULL)
+		return B_NO_MEMORY;
+	info->queueCount = queueCount;
+
+	// create the area for the commands, each request has its own
+	size_t commandSize = ROUNDUP(sizeof(virtio_block_command), 16);
+	size_t areaSize = ROUNDUP(commandSize * VIRTIO_BLOCK_QUEUE_REQUESTS
+		* queueCount, B_PAGE_SIZE);
+	info->bufferArea = create_area("virtio_block command buffer",
+		(void**)&info->bufferAddr, B_ANY_KERNEL_BLOCK_ADDRESS, areaSize,
+		B_CONTIGUOUS, B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA);
+	if (info->bufferArea < B_OK) {
+		status_t status = info->bufferArea;
+		virtio_block_free_queues(info);
+		return status;
+	}
+
+	physical_entry entry;
+	status_t status = get_memory_map((void*)info->bufferAddr, B_PAGE_SIZE,
+		&entry, 1);
+	if (status != B_OK) {
+		virtio_block_free_queues(info);
+		return status;
+	}
+	info->bufferPhysAddr = entry.address;
+
+	uint16 requestedSizes[VIRTIO_BLOCK_MAX_QUEUES];
+	virtio_queue virtioQueues[VIRTIO_BLOCK_MAX_QUEUES];
+	for (uint32 i = 0; i < queueCount; i++) {
+		requestedSizes[i] = 0;
+		if ((info->features & VIRTIO_BLK_F_SEG_MAX) != 0)
+			requestedSizes[i] = info->config.seg_max + 2;
+				// two entries are taken up by the header and result
+	}
+
+	status = info->virtio->alloc_queues(info->virtio_device, queueCount,
+		virtioQueues, requestedSizes);
+	if (status != B_OK) {
+		ERROR("queue allocation failed (%s)\n", strerror(status));
+		virtio_block_free_queues(info);
+		return status;
+	}
+
+	size_t offset = 0;
+	for (uint32 i = 0; i < queueCount; i++) {
+		virtio_block_queue* queue = &info->queues[i];
+		queue->info = info;
+		queue->queue = virtioQueues[i];
+		B_INITIALIZE_SPINLOCK(&queue->lock);
+		queue->condition.Init(queue, "virtio block request");
+		queue->freeRequests = NULL;
+		queue->inFlight = 0;
+		queue->maxInFlight = 0;
+		queue->submitted = 0;
+		queue->waits = 0;
+
+		for (int32 j = 0; j < VIRTIO_BLOCK_QUEUE_REQUESTS; j++) {
+			virtio_block_request* request = &queue->requests[j];
+			request->command
+				= (virtio_block_command*)(info->bufferAddr + offset);
+			request->physAddr = info->bufferPhysAddr + offset;
+			offset += commandSize;
+
+			virtio_block_put_request(queue, request);
+		}
+	}
+
+	return B_OK;
+}
+
+
 static status_t
 virtio_block_init_device(void* _info, void** _cookie)
 {
@@ -272,6 +720,8 @@ virtio_block_init_device(void* _info, void** _cookie)
 			| VIRTIO_BLK_F_SEG_MAX | VIRTIO_BLK_F_GEOMETRY
 			| VIRTIO_BLK_F_RO | VIRTIO_BLK_F_BLK_SIZE
 			| VIRTIO_BLK_F_FLUSH | VIRTIO_BLK_F_TOPOLOGY
+			| VIRTIO_BLK_F_MQ | VIRTIO_BLK_F_DISCARD
+			| VIRTIO_BLK_F_WRITE_ZEROES
 			| VIRTIO_FEATURE_RING_INDIRECT_DESC,
 		&info->features, &get_feature_name);
 
@@ -286,28 +736,35 @@ virtio_block_init_device(void* _info, void** _cookie)
 	TRACE("virtio_block: capacity: %" B_PRIu64 ", block_size %" B_PRIu32 "\n",
 		info->capacity, info->block_size);
 
-	uint16 requestedSize = 0;
-	if ((info->features & VIRTIO_BLK_F_SEG_MAX) != 0)
-		requestedSize = info->config.seg_max + 2;
-			// two entries are taken up by the header and result
-
-	status = info->virtio->alloc_queues(info->virtio_device, 1,
-		&info->virtio_queue, &requestedSize);
-	if (status != B_OK) {
-		ERROR("queue allocation failed (%s)\n", strerror(status));
+	status = virtio_block_init_queues(info);
+	if (status != B_OK)
 		return status;
-	}
 
 	status = info->virtio->setup_interrupt(info->virtio_device,
 		virtio_block_config_callback, info);
-
 	if (status == B_OK) {
-		status = info->virtio->queue_setup_interrupt(info->virtio_queue,
-			virtio_block_callback, info);
+		for (uint32 i = 0; status == B_OK && i < info->queueCount; i++) {
+			status = info->virtio->queue_setup_interrupt(
+				info->queues[i].queue, virtio_block_callback,
+				&info->queues[i]);
+		}
+		if (status != B_OK)
+			info->virtio->free_interrupts(info->virtio_device);
+	}
+	if (status != B_OK) {
+		info->virtio->free_queues(info->virtio_device);
+		virtio_block_free_queues(info);
+		return status;
+	}
+
+	{
+		MutexLocker locker(sDeviceListLock);
+		info->next = sDeviceList;
+		sDeviceList = info;
 	}
 
 	*_cookie = info;
-	return status;
+	return B_OK;
 }
 
 
@@ -317,6 +774,19 @@ virtio_block_uninit_device(void* _cookie)
 	CALLED();
 	virtio_block_driver_info* info = (virtio_block_driver_info*)_cookie;
 
+	{
+		MutexLocker locker(sDeviceListLock);
+		virtio_block_driver_info** link = &sDeviceList;
+		while (*link != NULL && *link != info)
+			link = &(*link)->next;
+		if (*link != NULL)
+			*link = info->next;
+	}
+
+	info->virtio->free_interrupts(info->virtio_device);
+	info->virtio->free_queues(info->virtio_device);
+	virtio_block_free_queues(info);
+
 	delete info->io_scheduler;
 	delete info->dma_resource;
 }
@@ -431,8 +901,19 @@ virtio_block_ioctl(void* cookie, uint32 op, void* buffer, size_t length)
 			return user_memcpy(buffer, &iconData, sizeof(device_icon));
 		}
 
-		/*case B_FLUSH_DRIVE_CACHE:
-			return synchronize_cache(info);*/
+		case B_FLUSH_DRIVE_CACHE:
+			return virtio_block_flush(info);
+
+		case B_TRIM_DEVICE:
+		{
+			// We know the buffer is kernel-side because it has been
+			// preprocessed in devfs
+			ASSERT(IS_KERNEL_ADDRESS(buffer));
+			return virtio_block_trim(info, (fs_trim_data*)buffer);
+		}
+
+		case VIRTIO_BLOCK_GET_STATISTICS:
+			return virtio_block_get_statistics(info, buffer, length);
 	}
 
 	return B_DEV_INVALID_IOCTL;
@@ -561,30 +1042,7 @@ virtio_block_init_driver(device_node *node, void **cookie)
 		return B_NO_MEMORY;
 	}
 
-	// create command buffer area
-	info->bufferArea = create_area("virtio_block command buffer", (void**)&info->bufferAddr,
-		B_ANY_KERNEL_BLOCK_ADDRESS, B_PAGE_SIZE,
-		B_FULL_LOCK, B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA);
-	if (info->bufferArea < B_OK) {
-		status_t status = info->bufferArea;
-		delete info->dma_resource;
-		free(info);
-		return status;
-	}
-
-	physical_entry entry;
-	status_t status = get_memory_map((void*)info->bufferAddr, B_PAGE_SIZE, &entry, 1);
-	if (status != B_OK) {
-		delete_area(info->bufferArea);
-		delete info->dma_resource;
-		free(info);
-		return status;
-	}
-
-	info->bufferPhysAddr = entry.address;
-	info->interruptCondition.Init(info, "virtio block transfer");
-	info->currentRequest = 0;
-	mutex_init(&info->lock, "virtio block request");
+	info->bufferArea = -1;
 
 	info->node = node;
 
@@ -598,8 +1056,6 @@ virtio_block_uninit_driver(void *_cookie)
 {
 	CALLED();
 	virtio_block_driver_info* info = (virtio_block_driver_info*)_cookie;
-	mutex_destroy(&info->lock);
-	delete_area(info->bufferArea);
 	free(info);
 }
 
@@ -629,6 +1085,24 @@ virtio_block_register_child_devices(void* _cookie)
 //	#pragma mark -
 
 
+static status_t
+virtio_block_std_ops(int32 op, ...)
+{
+	switch (op) {
+		case B_MODULE_INIT:
+			add_debugger_command("virtio_block", &dump_virtio_block,
+				"Lists the virtio block devices and their queue usage");
+			return B_OK;
+
+		case B_MODULE_UNINIT:
+			remove_debugger_command("virtio_block", &dump_virtio_block);
+			return B_OK;
+	}
+
+	return B_ERROR;
+}
+
+
 module_dependency module_dependencies[] = {
 	{ B_DEVICE_MANAGER_MODULE_NAME, (module_info**)&sDeviceManager },
 	{ NULL }
@@ -661,7 +1135,7 @@ struct driver_module_info sVirtioBlockDriver = {
 	{
 		VIRTIO_BLOCK_DRIVER_MODULE_NAME,
 		0,
-		NULL
+		virtio_block_std_ops
 	},
 
 	virtio_block_supports_device,
@@ -9,12 +9,16 @@
 #include <netinet/in.h>
 #include <netinet/ip.h>
 #include <netinet/ip6.h>
+#include <netinet/tcp.h>
+#include <netinet/udp.h>
 #include <sys/sockio.h>
 
 #include <ethernet.h>
 #include <kernel.h>
 #include <lock.h>
 #include <net_buffer.h>
+#include <net_device.h>
+#include <smp.h>
 #include <util/AutoLock.h>
 #include <util/DoublyLinkedList.h>
 #include <virtio.h>
@@ -52,38 +56,52 @@ struct BufInfo : DoublyLinkedListLinkImpl<BufInfo> {
 	physical_entry			entry;
 	physical_entry			hdrEntry;
 	uint32					rxUsedLength;
+	net_buffer*				txBuffer;
+		// a frame the device reads directly, freed once it is done
 };
 
 
 typedef DoublyLinkedList<BufInfo> BufInfoList;
 
 
+typedef struct {
+	::virtio_queue			rxQueue;
+	uint16					rxSize;
+	BufInfo**				rxBufInfos;
+	area_id					rxArea;
+	BufInfoList				rxFullList;
+
+	::virtio_queue			txQueue;
+	uint16					txSize;
+	BufInfo**				txBufInfos;
+	sem_id					txDone;
+	area_id					txArea;
+	BufInfoList				txFreeList;
+	mutex					txLock;
+
+	physical_entry*			txEntries;
+	iovec*					txVecs;
+	uint32					txEntryCount;
+} virtio_net_queue_pair;
+
+
 typedef struct {
 	device_node*			node;
 	::virtio_device			virtio_device;
 	virtio_device_interface*	virtio;
 
 	uint64 					features;
+	size_t					headerSize;
+	bool					mergeRxBuffers;
+	uint32					offloads;
 
 	uint32					pairsCount;
+	uint32					txPairsCount;
+	virtio_net_queue_pair*	pairs;
 
-	::virtio_queue*			rxQueues;
-	uint16*					rxSizes;
-
-	BufInfo**				rxBufInfos;
 	sem_id					rxDone;
-	area_id					rxArea;
-	BufInfoList				rxFullList;
 	mutex					rxLock;
-
-	::virtio_queue*			txQueues;
-	uint16*					txSizes;
-
-	BufInfo**				txBufInfos;
-	sem_id					txDone;
-	area_id					txArea;
-	BufInfoList				txFreeList;
-	mutex					txLock;
+	uint32					rxNextPair;
 
 	::virtio_queue			ctrlQueue;
 
@@ -182,38 +200,66 @@ get_feature_name(uint64 feature)
 }
 
 
+//!	Moves the transmitted buffers back to the free list; needs the tx lock.
+static void
+virtio_net_tx_reclaim(virtio_net_driver_info* info,
+	virtio_net_queue_pair* pair)
+{
+	BufInfo* buf = NULL;
+	while (info->virtio->queue_dequeue(pair->txQueue, (void**)&buf, NULL)) {
+		if (buf == NULL)
+			break;
+
+		if (buf->txBuffer != NULL) {
+			sBufferModule->free(buf->txBuffer);
+			buf->txBuffer = NULL;
+		}
+		pair->txFreeList.Add(buf);
+	}
+}
+
+
 static status_t
 virtio_net_drain_queues(virtio_net_driver_info* info)
 {
-	BufInfo* buf = NULL;
-	while (info->virtio->queue_dequeue(info->txQueues[0], (void**)&buf, NULL))
-		info->txFreeList.Add(buf);
+	for (uint32 i = 0; i < info->pairsCount; i++) {
+		virtio_net_queue_pair* pair = &info->pairs[i];
 
-	while (info->virtio->queue_dequeue(info->rxQueues[0], NULL, NULL))
-		;
+		virtio_net_tx_reclaim(info, pair);
 
-	while (info->rxFullList.RemoveHead() != NULL)
-		;
+		while (info->virtio->queue_dequeue(pair->rxQueue, NULL, NULL))
+			;
+
+		while (pair->rxFullList.RemoveHead() != NULL)
+			;
+	}
 
 	return B_OK;
 }
 
 
 static status_t
-virtio_net_rx_enqueue_buf(virtio_net_driver_info* info, BufInfo* buf)
+virtio_net_rx_enqueue_buf(virtio_net_driver_info* info,
+	virtio_net_queue_pair* pair, BufInfo* buf)
 {
 	CALLED();
 	physical_entry entries[2];
+	size_t entryCount = 1;
 	entries[0] = buf->hdrEntry;
-	entries[1] = buf->entry;
+	if (!info->mergeRxBuffers) {
+		// the header needs its own descriptor
+		entries[1] = buf->entry;
+		entryCount = 2;
+	}
 
-	memset(buf->hdr, 0, sizeof(struct virtio_net_hdr));
+	memset(buf->hdr, 0, info->headerSize);
 
 	// queue the rx buffer
-	status_t status = info->virtio->queue_request_v(info->rxQueues[0],
-		entries, 0, 2, buf);
+	status_t status = info->virtio->queue_request_v(pair->rxQueue,
+		entries, 0, entryCount, buf);
 	if (status != B_OK) {
-		ERROR("rx queueing on queue %d failed (%s)\n", 0, strerror(status));
+		ERROR("rx queueing on queue %" B_PRId32 " failed (%s)\n",
+			(int32)(pair - info->pairs), strerror(status));
 		return status;
 	}
 
@@ -222,26 +268,30 @@ virtio_net_rx_enqueue_buf(virtio_net_driver_info* info, BufInfo* buf)
 
 
 static status_t
-virtio_net_ctrl_exec_cmd(virtio_net_driver_info* info, int cmd, bool value)
+virtio_net_ctrl_exec(virtio_net_driver_info* info, uint8 netClass, uint8 cmd,
+	const void* data, size_t dataLength)
 {
 	struct {
 		struct virtio_net_ctrl_hdr hdr;
 		uint8 pad1;
-		uint8 onoff;
+		uint8 data[8];
 		uint8 pad2;
 		uint8 ack;
 	} s __attribute__((aligned(2)));
 
-	s.hdr.net_class = VIRTIO_NET_CTRL_RX;
+	if (dataLength > sizeof(s.data))
+		return B_BAD_VALUE;
+
+	s.hdr.net_class = netClass;
 	s.hdr.cmd = cmd;
-	s.onoff = value;
+	memcpy(s.data, data, dataLength);
 	s.ack = VIRTIO_NET_ERR;
 
 	physical_entry entries[3];
 	status_t status = get_memory_map(&s.hdr, sizeof(s.hdr), &entries[0], 1);
 	if (status != B_OK)
 		return status;
-	status = get_memory_map(&s.onoff, sizeof(s.onoff), &entries[1], 1);
+	status = get_memory_map(s.data, dataLength, &entries[1], 1);
 	if (status != B_OK)
 		return status;
 	status = get_memory_map(&s.ack, sizeof(s.ack), &entries[2], 1);
@@ -263,6 +313,15 @@ virtio_net_ctrl_exec_cmd(virtio_net_driver_info* info, int cmd, bool value)
 }
 
 
+static status_t
+virtio_net_ctrl_exec_cmd(virtio_net_driver_info* info, int cmd, bool value)
+{
+	uint8 onoff = value;
+	return virtio_net_ctrl_exec(info, VIRTIO_NET_CTRL_RX, cmd, &onoff,
+		sizeof(onoff));
+}
+
+
 static status_t
 virtio_net_set_promisc(virtio_net_driver_info* info, bool on)
 {
@@ -277,9 +336,163 @@ vtnet_set_allmulti(virtio_net_driver_info* info, bool on)
 }
 
 
+static status_t
+virtio_net_set_queue_pairs(virtio_net_driver_info* info, uint16 count)
+{
+	struct virtio_net_ctrl_mq mq;
+	mq.virtqueue_pairs = count;
+	return virtio_net_ctrl_exec(info, VIRTIO_NET_CTRL_MQ,
+		VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET, &mq, sizeof(mq));
+}
+
+
 #define ROUND_TO_PAGE_SIZE(x) (((x) + (B_PAGE_SIZE) - 1) & ~((B_PAGE_SIZE) - 1))
 
 
+static status_t
+virtio_net_init_queue_pair(virtio_net_driver_info* info,
+	virtio_net_queue_pair* pair)
+{
+	char* rxBuffer;
+	char* txBuffer;
+
+	pair->rxArea = -1;
+	pair->txArea = -1;
+	pair->txDone = -1;
+	mutex_init(&pair->txLock, "virtionet tx lock");
+
+	// merged receive buffers only need one descriptor each
+	pair->rxSize = info->virtio->queue_size(pair->rxQueue);
+	if (!info->mergeRxBuffers)
+		pair->rxSize /= 2;
+	pair->txSize = info->virtio->queue_size(pair->txQueue) / 2;
+
+	// frames that are too large to be copied are passed on in as many
+	// pieces as an indirect descriptor can hold
+	pair->txEntryCount = info->virtio->queue_size(pair->txQueue);
+
+	pair->rxBufInfos = new(std::nothrow) BufInfo*[pair->rxSize];
+	pair->txBufInfos = new(std::nothrow) BufInfo*[pair->txSize];
+	pair->txEntries = new(std::nothrow) physical_entry[pair->txEntryCount];
+	pair->txVecs = new(std::nothrow) iovec[pair->txEntryCount];
+	if (pair->rxBufInfos == NULL || pair->txBufInfos == NULL
+		|| pair->txEntries == NULL || pair->txVecs == NULL) {
+		return B_NO_MEMORY;
+	}
+	memset(pair->rxBufInfos, 0, sizeof(BufInfo*) * pair->rxSize);
+	memset(pair->txBufInfos, 0, sizeof(BufInfo*) * pair->txSize);
+
+	// create receive buffer area
+	pair->rxArea = create_area("virtionet rx buffer", (void**)&rxBuffer,
+		B_ANY_KERNEL_BLOCK_ADDRESS, ROUND_TO_PAGE_SIZE(
+			BUFFER_SIZE * pair->rxSize),
+		B_FULL_LOCK, B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA);
+	if (pair->rxArea < B_OK)
+		return pair->rxArea;
+
+	// initialize receive buffer descriptors
+	for (int i = 0; i < pair->rxSize; i++) {
+		BufInfo* buf = new(std::nothrow) BufInfo;
+		if (buf == NULL)
+			return B_NO_MEMORY;
+
+		pair->rxBufInfos[i] = buf;
+		buf->txBuffer = NULL;
+		buf->hdr = (struct virtio_net_hdr*)((addr_t)rxBuffer
+			+ i * BUFFER_SIZE);
+
+		status_t status;
+		if (info->mergeRxBuffers) {
+			// the header is followed by the data
+			buf->buffer = (char*)((addr_t)buf->hdr + info->headerSize);
+			status = get_memory_map(buf->hdr, BUFFER_SIZE, &buf->hdrEntry, 1);
+		} else {
+			buf->buffer = (char*)((addr_t)buf->hdr
+				+ sizeof(virtio_net_rx_hdr));
+
+			status = get_memory_map(buf->buffer,
+				BUFFER_SIZE - sizeof(virtio_net_rx_hdr), &buf->entry, 1);
+			if (status == B_OK) {
+				status = get_memory_map(buf->hdr, info->headerSize,
+					&buf->hdrEntry, 1);
+			}
+		}
+		if (status != B_OK)
+			return status;
+	}
+
+	// create transmit buffer area
+	pair->txArea = create_area("virtionet tx buffer", (void**)&txBuffer,
+		B_ANY_KERNEL_BLOCK_ADDRESS, ROUND_TO_PAGE_SIZE(
+			BUFFER_SIZE * pair->txSize),
+		B_FULL_LOCK, B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA);
+	if (pair->txArea < B_OK)
+		return pair->txArea;
+
+	// initialize transmit buffer descriptors
+	for (int i = 0; i < pair->txSize; i++) {
+		BufInfo* buf = new(std::nothrow) BufInfo;
+		if (buf == NULL)
+			return B_NO_MEMORY;
+
+		pair->txBufInfos[i] = buf;
+		buf->txBuffer = NULL;
+		buf->hdr = (struct virtio_net_hdr*)((addr_t)txBuffer
+			+ i * BUFFER_SIZE);
+		buf->buffer = (char*)((addr_t)buf->hdr + sizeof(virtio_net_tx_hdr));
+
+		status_t status = get_memory_map(buf->buffer,
+			BUFFER_SIZE - sizeof(virtio_net_tx_hdr), &buf->entry, 1);
+		if (status != B_OK)
+			return status;
+
+		status = get_memory_map(buf->hdr, info->headerSize, &buf->hdrEntry,
+			1);
+		if (status != B_OK)
+			return status;
+
+		pair->txFreeList.Add(buf);
+	}
+
+	return B_OK;
+}
+
+
+static void
+virtio_net_uninit_queue_pair(virtio_net_queue_pair* pair)
+{
+	while (pair->txFreeList.RemoveHead() != NULL)
+		;
+	while (pair->rxFullList.RemoveHead() != NULL)
+		;
+
+	if (pair->rxBufInfos != NULL) {
+		for (int i = 0; i < pair->rxSize; i++)
+			delete pair->rxBufInfos[i];
+	}
+	if (pair->txBufInfos != NULL) {
+		for (int i = 0; i < pair->txSize; i++) {
+			if (pair->txBufInfos[i] != NULL
+				&& pair->txBufInfos[i]->txBuffer != NULL) {
+				sBufferModule->free(pair->txBufInfos[i]->txBuffer);
+			}
+			delete pair->txBufInfos[i];
+		}
+	}
+	if (pair->rxArea >= 0)
+		delete_area(pair->rxArea);
+	if (pair->txArea >= 0)
+		delete_area(pair->txArea);
+
+	delete[] pair->rxBufInfos;
+	delete[] pair->txBufInfos;
+	delete[] pair->txEntries;
+	delete[] pair->txVecs;
+
+	mutex_destroy(&pair->txLock);
+}
+
+
 //	#pragma mark - device module API
 
 
@@ -297,21 +510,52 @@ virtio_net_init_device(void* _info, void** _cookie)
 	info->virtio->negotiate_features(info->virtio_device,
 		VIRTIO_NET_F_STATUS | VIRTIO_NET_F_MAC | VIRTIO_NET_F_MTU
 			| VIRTIO_NET_F_CTRL_VQ | VIRTIO_NET_F_CTRL_RX | VIRTIO_NET_F_GUEST_CSUM
-			/* | VIRTIO_NET_F_MQ */,
+			| VIRTIO_NET_F_CSUM | VIRTIO_NET_F_HOST_TSO4
+			| VIRTIO_NET_F_HOST_TSO6 | VIRTIO_NET_F_MRG_RXBUF
+			| VIRTIO_NET_F_MQ | VIRTIO_FEATURE_RING_INDIRECT_DESC,
 		&info->features, &get_feature_name);
 
+	// modern devices always use the larger header
+	info->mergeRxBuffers = (info->features & VIRTIO_NET_F_MRG_RXBUF) != 0;
+	if (info->mergeRxBuffers
+		|| (info->features & VIRTIO_FEATURE_VERSION_1) != 0)
+		info->headerSize = sizeof(struct virtio_net_hdr_mrg_rxbuf);
+	else
+		info->headerSize = sizeof(struct virtio_net_hdr);
+
+	info->offloads = 0;
+	if ((info->features & VIRTIO_NET_F_CSUM) != 0) {
+		info->offloads |= NET_DEVICE_OFFLOAD_CHECKSUM_IPV4
+			| NET_DEVICE_OFFLOAD_CHECKSUM_IPV6;
+
+		// segmented frames are not copied, but passed on in pieces, which
+		// only fits into the ring with indirect descriptors
+		if ((info->features & VIRTIO_FEATURE_RING_INDIRECT_DESC) != 0) {
+			if ((info->features & VIRTIO_NET_F_HOST_TSO4) != 0)
+				info->offloads |= NET_DEVICE_OFFLOAD_TSO_IPV4;
+			if ((info->features & VIRTIO_NET_F_HOST_TSO6) != 0)
+				info->offloads |= NET_DEVICE_OFFLOAD_TSO_IPV6;
+		}
+	}
+
+	uint16 maxPairs;
+	info->pairsCount = 1;
 	if ((info->features & VIRTIO_NET_F_MQ) != 0
 			&& (info->features & VIRTIO_NET_F_CTRL_VQ) != 0
 			&& info->virtio->read_device_config(info->virtio_device,
 				offsetof(struct virtio_net_config, max_virtqueue_pairs),
-				&info->pairsCount, sizeof(info->pairsCount)) == B_OK) {
+				&maxPairs, sizeof(maxPairs)) == B_OK) {
+		// one pair per CPU, as far as the bus lets us
 		system_info sysinfo;
+		info->pairsCount = maxPairs;
 		if (get_system_info(&sysinfo) == B_OK
 			&& info->pairsCount > sysinfo.cpu_count) {
 			info->pairsCount = sysinfo.cpu_count;
 		}
-	} else
-		info->pairsCount = 1;
+		info->pairsCount = min_c(info->pairsCount,
+			(VIRTIO_VIRTQUEUES_MAX_COUNT - 1) / 2);
+		info->pairsCount = max_c(info->pairsCount, 1);
+	}
 
 	// TODO read config
 
@@ -327,128 +571,50 @@ virtio_net_init_device(void* _info, void** _cookie)
 		return status;
 	}
 
-	char* rxBuffer;
-	char* txBuffer;
-
-	info->rxQueues = new(std::nothrow) virtio_queue[info->pairsCount];
-	info->txQueues = new(std::nothrow) virtio_queue[info->pairsCount];
-	info->rxSizes = new(std::nothrow) uint16[info->pairsCount];
-	info->txSizes = new(std::nothrow) uint16[info->pairsCount];
-	if (info->rxQueues == NULL || info->txQueues == NULL
-		|| info->rxSizes == NULL || info->txSizes == NULL) {
-		status = B_NO_MEMORY;
-		goto err1;
-	}
-	for (uint32 i = 0; i < info->pairsCount; i++) {
-		info->rxQueues[i] = virtioQueues[i * 2];
-		info->txQueues[i] = virtioQueues[i * 2 + 1];
-		info->rxSizes[i] = info->virtio->queue_size(info->rxQueues[i]) / 2;
-		info->txSizes[i] = info->virtio->queue_size(info->txQueues[i]) / 2;
-	}
-	if ((info->features & VIRTIO_NET_F_CTRL_VQ) != 0)
-		info->ctrlQueue = virtioQueues[info->pairsCount * 2];
-
-	info->rxBufInfos = new(std::nothrow) BufInfo*[info->rxSizes[0]];
-	info->txBufInfos = new(std::nothrow) BufInfo*[info->txSizes[0]];
-	if (info->rxBufInfos == NULL || info->txBufInfos == NULL) {
-		status = B_NO_MEMORY;
-		goto err2;
-	}
-	memset(info->rxBufInfos, 0, sizeof(BufInfo*) * info->rxSizes[0]);
-	memset(info->txBufInfos, 0, sizeof(BufInfo*) * info->txSizes[0]);
-
-	// create receive buffer area
-	info->rxArea = create_area("virtionet rx buffer", (void**)&rxBuffer,
-		B_ANY_KERNEL_BLOCK_ADDRESS, ROUND_TO_PAGE_SIZE(
-			BUFFER_SIZE * info->rxSizes[0]),
-		B_FULL_LOCK, B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA);
-	if (info->rxArea < B_OK) {
-		status = info->rxArea;
-		goto err3;
+	info->pairs = new(std::nothrow) virtio_net_queue_pair[info->pairsCount]();
+	if (info->pairs == NULL) {
+		info->virtio->free_queues(info->virtio_device);
+		return B_NO_MEMORY;
 	}
 
-	// initialize receive buffer descriptors
-	for (int i = 0; i < info->rxSizes[0]; i++) {
-		BufInfo* buf = new(std::nothrow) BufInfo;
-		if (buf == NULL) {
-			status = B_NO_MEMORY;
-			goto err4;
-		}
-
-		info->rxBufInfos[i] = buf;
-		buf->hdr = (struct virtio_net_hdr*)((addr_t)rxBuffer
-			+ i * BUFFER_SIZE);
-		buf->buffer = (char*)((addr_t)buf->hdr + sizeof(virtio_net_rx_hdr));
-
-		status = get_memory_map(buf->buffer,
-			BUFFER_SIZE - sizeof(virtio_net_rx_hdr), &buf->entry, 1);
-		if (status != B_OK)
-			goto err4;
-
-		status = get_memory_map(buf->hdr, sizeof(struct virtio_net_hdr),
-			&buf->hdrEntry, 1);
-		if (status != B_OK)
-			goto err4;
-	}
+	mutex_init(&info->rxLock, "virtionet rx lock");
 
-	// create transmit buffer area
-	info->txArea = create_area("virtionet tx buffer", (void**)&txBuffer,
-		B_ANY_KERNEL_BLOCK_ADDRESS, ROUND_TO_PAGE_SIZE(
-			BUFFER_SIZE * info->txSizes[0]),
-		B_FULL_LOCK, B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA);
-	if (info->txArea < B_OK) {
-		status = info->txArea;
-		goto err5;
-	}
+	uint32 initializedPairs = 0;
+	for (; initializedPairs < info->pairsCount; initializedPairs++) {
+		virtio_net_queue_pair* pair = &info->pairs[initializedPairs];
+		pair->rxQueue = virtioQueues[initializedPairs * 2];
+		pair->txQueue = virtioQueues[initializedPairs * 2 + 1];
 
-	// initialize transmit buffer descriptors
-	for (int i = 0; i < info->txSizes[0]; i++) {
-		BufInfo* buf = new(std::nothrow) BufInfo;
-		if (buf == NULL) {
-			status = B_NO_MEMORY;
-			goto err6;
+		status = virtio_net_init_queue_pair(info, pair);
+		if (status != B_OK) {
+			initializedPairs++;
+			goto err;
 		}
-
-		info->txBufInfos[i] = buf;
-		buf->hdr = (struct virtio_net_hdr*)((addr_t)txBuffer
-			+ i * BUFFER_SIZE);
-		buf->buffer = (char*)((addr_t)buf->hdr + sizeof(virtio_net_tx_hdr));
-
-		status = get_memory_map(buf->buffer,
-			BUFFER_SIZE - sizeof(virtio_net_tx_hdr), &buf->entry, 1);
-		if (status != B_OK)
-			goto err6;
-
-		status = get_memory_map(buf->hdr, sizeof(struct virtio_net_hdr),
-			&buf->hdrEntry, 1);
-		if (status != B_OK)
-			goto err6;
-
-		info->txFreeList.Add(buf);
 	}
-
-	mutex_init(&info->rxLock, "virtionet rx lock");
-	mutex_init(&info->txLock, "virtionet tx lock");
+	if ((info->features & VIRTIO_NET_F_CTRL_VQ) != 0)
+		info->ctrlQueue = virtioQueues[info->pairsCount * 2];
 
 	// Setup interrupt
 	status = info->virtio->setup_interrupt(info->virtio_device, NULL, info);
 	if (status != B_OK) {
 		ERROR("interrupt setup failed (%s)\n", strerror(status));
-		goto err6;
+		goto err;
 	}
 
-	status = info->virtio->queue_setup_interrupt(info->rxQueues[0],
-		virtio_net_rxDone, info);
-	if (status != B_OK) {
-		ERROR("queue interrupt setup failed (%s)\n", strerror(status));
-		goto err6;
-	}
+	for (uint32 i = 0; i < info->pairsCount; i++) {
+		status = info->virtio->queue_setup_interrupt(info->pairs[i].rxQueue,
+			virtio_net_rxDone, info);
+		if (status != B_OK) {
+			ERROR("queue interrupt setup failed (%s)\n", strerror(status));
+			goto err;
+		}
 
-	status = info->virtio->queue_setup_interrupt(info->txQueues[0],
-		virtio_net_txDone, info);
-	if (status != B_OK) {
-		ERROR("queue interrupt setup failed (%s)\n", strerror(status));
-		goto err6;
+		status = info->virtio->queue_setup_interrupt(info->pairs[i].txQueue,
+			virtio_net_txDone, &info->pairs[i]);
+		if (status != B_OK) {
+			ERROR("queue interrupt setup failed (%s)\n", strerror(status));
+			goto err;
+		}
 	}
 
 	if ((info->features & VIRTIO_NET_F_CTRL_VQ) != 0) {
@@ -456,31 +622,29 @@ virtio_net_init_device(void* _info, void** _cookie)
 			NULL, info);
 		if (status != B_OK) {
 			ERROR("queue interrupt setup failed (%s)\n", strerror(status));
-			goto err6;
+			goto err;
 		}
 	}
 
+	info->txPairsCount = info->pairsCount;
+	if (info->pairsCount > 1
+		&& virtio_net_set_queue_pairs(info, info->pairsCount) != B_OK) {
+		// the device keeps using the first pair only; we still receive on
+		// all of them, but must not send on the others
+		ERROR("enabling %" B_PRIu32 " queue pairs failed\n", info->pairsCount);
+		info->txPairsCount = 1;
+	}
+
 	*_cookie = info;
 	return B_OK;
 
-err6:
-	for (int i = 0; i < info->txSizes[0]; i++)
-		delete info->txBufInfos[i];
-err5:
-	delete_area(info->txArea);
-err4:
-	for (int i = 0; i < info->rxSizes[0]; i++)
-		delete info->rxBufInfos[i];
-err3:
-	delete_area(info->rxArea);
-err2:
-	delete[] info->rxBufInfos;
-	delete[] info->txBufInfos;
-err1:
-	delete[] info->rxQueues;
-	delete[] info->txQueues;
-	delete[] info->rxSizes;
-	delete[] info->txSizes;
+err:
+	mutex_destroy(&info->rxLock);
+	for (uint32 i = 0; i < initializedPairs; i++)
+		virtio_net_uninit_queue_pair(&info->pairs[i]);
+	delete[] info->pairs;
+	info->pairs = NULL;
+	info->virtio->free_queues(info->virtio_device);
 	return status;
 }
 
@@ -494,28 +658,10 @@ virtio_net_uninit_device(void* _cookie)
 	info->virtio->free_interrupts(info->virtio_device);
 
 	mutex_destroy(&info->rxLock);
-	mutex_destroy(&info->txLock);
 
-	while (true) {
-		BufInfo* buf = info->txFreeList.RemoveHead();
-		if (buf == NULL)
-			break;
-	}
-
-	for (int i = 0; i < info->rxSizes[0]; i++) {
-		delete info->rxBufInfos[i];
-	}
-	for (int i = 0; i < info->txSizes[0]; i++) {
-		delete info->txBufInfos[i];
-	}
-	delete_area(info->rxArea);
-	delete_area(info->txArea);
-	delete[] info->rxBufInfos;
-	delete[] info->txBufInfos;
-	delete[] info->rxSizes;
-	delete[] info->txSizes;
-	delete[] info->rxQueues;
-	delete[] info->txQueues;
+	for (uint32 i = 0; i < info->pairsCount; i++)
+		virtio_net_uninit_queue_pair(&info->pairs[i]);
+	delete[] info->pairs;
 
 	info->virtio->free_queues(info->virtio_device);
 }
@@ -535,9 +681,13 @@ virtio_net_open(void* _info, const char* path, int openMode, void** _cookie)
 	info->nonblocking = (openMode & O_NONBLOCK) != 0;
 	info->maxframesize = MAX_FRAME_SIZE;
 	info->rxDone = create_sem(0, "virtio_net_rx");
-	info->txDone = create_sem(1, "virtio_net_tx");
-	if (info->rxDone < B_OK || info->txDone < B_OK)
+	if (info->rxDone < B_OK)
 		goto error;
+	for (uint32 i = 0; i < info->pairsCount; i++) {
+		info->pairs[i].txDone = create_sem(1, "virtio_net_tx");
+		if (info->pairs[i].txDone < B_OK)
+			goto error;
+	}
 	handle->info = info;
 
 	if ((info->features & VIRTIO_NET_F_MAC) != 0) {
@@ -561,16 +711,22 @@ virtio_net_open(void* _info, const char* path, int openMode, void** _cookie)
 		dprintf("virtio_net: no mtu feature\n");
 	}
 
-	for (int i = 0; i < info->rxSizes[0]; i++)
-		virtio_net_rx_enqueue_buf(info, info->rxBufInfos[i]);
+	for (uint32 i = 0; i < info->pairsCount; i++) {
+		virtio_net_queue_pair* pair = &info->pairs[i];
+		for (int j = 0; j < pair->rxSize; j++)
+			virtio_net_rx_enqueue_buf(info, pair, pair->rxBufInfos[j]);
+	}
 
 	*_cookie = handle;
 	return B_OK;
 
 error:
 	delete_sem(info->rxDone);
-	delete_sem(info->txDone);
-	info->rxDone = info->txDone = -1;
+	info->rxDone = -1;
+	for (uint32 i = 0; i < info->pairsCount; i++) {
+		delete_sem(info->pairs[i].txDone);
+		info->pairs[i].txDone = -1;
+	}
 	free(handle);
 	return B_ERROR;
 }
@@ -584,8 +740,11 @@ virtio_net_close(void* cookie)
 
 	virtio_net_driver_info* info = handle->info;
 	delete_sem(info->rxDone);
-	delete_sem(info->txDone);
-	info->rxDone = info->txDone = -1;
+	info->rxDone = -1;
+	for (uint32 i = 0; i < info->pairsCount; i++) {
+		delete_sem(info->pairs[i].txDone);
+		info->pairs[i].txDone = -1;
+	}
 
 	return B_OK;
 }
@@ -614,6 +773,43 @@ virtio_net_rxDone(void* driverCookie, void* cookie)
 }
 
 
+//!	Collects the received buffers of all queues; needs the rx lock.
+static void
+virtio_net_rx_dequeue(virtio_net_driver_info* info)
+{
+	for (uint32 i = 0; i < info->pairsCount; i++) {
+		virtio_net_queue_pair* pair = &info->pairs[i];
+		while (true) {
+			uint32 usedLength = 0;
+			BufInfo* buf = NULL;
+			if (!info->virtio->queue_dequeue(pair->rxQueue, (void**)&buf,
+					&usedLength) || buf == NULL) {
+				break;
+			}
+
+			buf->rxUsedLength = usedLength;
+			pair->rxFullList.Add(buf);
+		}
+	}
+}
+
+
+//!	Returns the next queue pair with received data; needs the rx lock.
+static virtio_net_queue_pair*
+virtio_net_rx_next_pair(virtio_net_driver_info* info)
+{
+	for (uint32 i = 0; i < info->pairsCount; i++) {
+		uint32 index = (info->rxNextPair + i) % info->pairsCount;
+		if (info->pairs[index].rxFullList.Head() != NULL) {
+			info->rxNextPair = (index + 1) % info->pairsCount;
+			return &info->pairs[index];
+		}
+	}
+
+	return NULL;
+}
+
+
 static status_t
 virtio_net_receive(void* cookie, net_buffer** _buffer)
 {
@@ -622,7 +818,8 @@ virtio_net_receive(void* cookie, net_buffer** _buffer)
 	virtio_net_driver_info* info = handle->info;
 
 	MutexLocker rxLocker(info->rxLock);
-	while (info->rxFullList.Head() == NULL) {
+	virtio_net_queue_pair* pair;
+	while ((pair = virtio_net_rx_next_pair(info)) == NULL) {
 		rxLocker.Unlock();
 
 		if (info->nonblocking)
@@ -639,41 +836,62 @@ virtio_net_receive(void* cookie, net_buffer** _buffer)
 			acquire_sem_etc(info->rxDone, semCount, B_RELATIVE_TIMEOUT, 0);
 
 		rxLocker.Lock();
-		while (info->rxDone != -1) {
-			uint32 usedLength = 0;
-			BufInfo* buf = NULL;
-			if (!info->virtio->queue_dequeue(info->rxQueues[0], (void**)&buf,
-					&usedLength) || buf == NULL) {
-				break;
-			}
-
-			if (usedLength > sizeof(virtio_net_hdr))
-				buf->rxUsedLength = usedLength - sizeof(virtio_net_hdr);
-			else
-				buf->rxUsedLength = 0;
-			info->rxFullList.Add(buf);
-		}
+		if (info->rxDone != -1)
+			virtio_net_rx_dequeue(info);
 		TRACE("virtio_net_read: finished waiting\n");
 	}
 
-	net_buffer* buffer = sBufferModule->create(0);
-	if (buffer == NULL)
-		return B_NO_MEMORY;
-
-	BufInfo* buf = info->rxFullList.RemoveHead();
+	// With merged buffers, a frame may continue in the following buffers
+	// of the same queue; the device hands them over all at once.
+	BufInfoList frame;
+	BufInfo* buf = pair->rxFullList.RemoveHead();
+	frame.Add(buf);
+
+	uint16 bufferCount = 1;
+	if (info->mergeRxBuffers)
+		bufferCount = ((virtio_net_hdr_mrg_rxbuf*)buf->hdr)->num_buffers;
+	for (uint16 i = 1; i < bufferCount; i++) {
+		BufInfo* next = pair->rxFullList.RemoveHead();
+		if (next == NULL)
+			break;
+		frame.Add(next);
+	}
 	rxLocker.Unlock();
 
-	if (sBufferModule->append(buffer, buf->buffer, buf->rxUsedLength) != B_OK) {
-		sBufferModule->free(buffer);
-		buffer = NULL;
-	}
 	const uint8_t flags = buf->hdr->flags;
+	net_buffer* buffer = sBufferModule->create(0);
+	status_t status = buffer != NULL ? B_OK : B_NO_MEMORY;
+	uint16 count = 0;
+	for (BufInfo* part = frame.First(); part != NULL;
+			part = frame.GetNext(part), count++) {
+		const char* data = part->buffer;
+		uint32 length = part->rxUsedLength;
+		if (part == buf) {
+			length = length > info->headerSize
+				? length - info->headerSize : 0;
+		} else {
+			// only the first buffer starts with the header
+			data = (const char*)part->hdr;
+		}
+
+		if (status == B_OK)
+			status = sBufferModule->append(buffer, data, length);
+	}
+	if (status == B_OK && count != bufferCount) {
+		ERROR("received frame is missing buffers\n");
+		status = B_BAD_DATA;
+	}
+
 	rxLocker.Lock();
-	virtio_net_rx_enqueue_buf(info, buf);
+	while (BufInfo* part = frame.RemoveHead())
+		virtio_net_rx_enqueue_buf(info, pair, part);
 	rxLocker.Unlock();
 
-	if (buffer == NULL)
-		return B_NO_MEMORY;
+	if (status != B_OK) {
+		if (buffer != NULL)
+			sBufferModule->free(buffer);
+		return status;
+	}
 
 	if ((flags & (VIRTIO_NET_HDR_F_DATA_VALID | VIRTIO_NET_HDR_F_NEEDS_CSUM)) != 0) {
 		buffer->buffer_flags |= NET_BUFFER_L3_CHECKSUM_VALID;
@@ -712,9 +930,110 @@ static void
 virtio_net_txDone(void* driverCookie, void* cookie)
 {
 	CALLED();
-	virtio_net_driver_info* info = (virtio_net_driver_info*)cookie;
+	virtio_net_queue_pair* pair = (virtio_net_queue_pair*)cookie;
 
-	release_sem_etc(info->txDone, 1, B_DO_NOT_RESCHEDULE);
+	release_sem_etc(pair->txDone, 1, B_DO_NOT_RESCHEDULE);
+}
+
+
+/*!	Tells the device which checksum to complete, and how to segment the
+	frame, as requested by the stack.
+*/
+static status_t
+virtio_net_tx_offloads(virtio_net_driver_info* info, net_buffer* buffer,
+	struct virtio_net_hdr* hdr)
+{
+	if ((buffer->buffer_flags & NET_BUFFER_L4_CHECKSUM_PARTIAL) == 0)
+		return B_OK;
+
+	uint16 etherType;
+	if (sBufferModule->read(buffer, offsetof(ether_header, type),
+			&etherType, sizeof(etherType)) != B_OK) {
+		return B_BAD_DATA;
+	}
+
+	uint32 headerLength = 0;
+	uint8 protocol = 0;
+	uint8 gsoType = VIRTIO_NET_HDR_GSO_NONE;
+	etherType = ntohs(etherType);
+	if (etherType == ETHER_TYPE_IP) {
+		uint8 versionAndLength;
+		if (sBufferModule->read(buffer, ETHER_HEADER_LENGTH,
+				&versionAndLength, sizeof(versionAndLength)) != B_OK
+			|| sBufferModule->read(buffer,
+				ETHER_HEADER_LENGTH + offsetof(struct ip, ip_p),
+				&protocol, sizeof(protocol)) != B_OK) {
+			return B_BAD_DATA;
+		}
+		headerLength = (versionAndLength & 0xf) * 4;
+		gsoType = VIRTIO_NET_HDR_GSO_TCPV4;
+	} else if (etherType == ETHER_TYPE_IPV6) {
+		if (sBufferModule->read(buffer,
+				ETHER_HEADER_LENGTH + offsetof(struct ip6_hdr, ip6_nxt),
+				&protocol, sizeof(protocol)) != B_OK) {
+			return B_BAD_DATA;
+		}
+		headerLength = sizeof(struct ip6_hdr);
+		gsoType = VIRTIO_NET_HDR_GSO_TCPV6;
+	}
+
+	uint16 checksumOffset;
+	if (protocol == IPPROTO_TCP)
+		checksumOffset = offsetof(struct tcphdr, th_sum);
+	else if (protocol == IPPROTO_UDP)
+		checksumOffset = offsetof(struct udphdr, uh_sum);
+	else
+		return B_BAD_DATA;
+
+	uint32 checksumStart = ETHER_HEADER_LENGTH + headerLength;
+	hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+	hdr->csum_start = checksumStart;
+	hdr->csum_offset = checksumOffset;
+
+	if (buffer->segment_size != 0) {
+		uint8 dataOffset;
+		if (protocol != IPPROTO_TCP
+			|| sBufferModule->read(buffer, checksumStart + 12, &dataOffset,
+				sizeof(dataOffset)) != B_OK) {
+			return B_BAD_DATA;
+		}
+
+		hdr->gso_type = gsoType;
+		hdr->gso_size = buffer->segment_size;
+		hdr->hdr_len = checksumStart + (dataOffset >> 4) * 4;
+	}
+
+	return B_OK;
+}
+
+
+/*!	Describes the physical pages of \a buffer in the entries of \a pair,
+	starting at \a entryCount.
+*/
+static status_t
+virtio_net_tx_map(virtio_net_queue_pair* pair, net_buffer* buffer,
+	size_t& entryCount)
+{
+	uint32 vecCount = sBufferModule->get_iovecs(buffer, pair->txVecs,
+		pair->txEntryCount - entryCount);
+	if (vecCount < sBufferModule->count_iovecs(buffer))
+		return B_BUFFER_OVERFLOW;
+
+	for (uint32 i = 0; i < vecCount; i++) {
+		uint32 count = pair->txEntryCount - entryCount;
+		if (count == 0)
+			return B_BUFFER_OVERFLOW;
+
+		status_t status = get_memory_map_etc(B_CURRENT_TEAM,
+			pair->txVecs[i].iov_base, pair->txVecs[i].iov_len,
+			pair->txEntries + entryCount, &count);
+		if (status != B_OK)
+			return status;
+
+		entryCount += count;
+	}
+
+	return B_OK;
 }
 
 
@@ -725,62 +1044,83 @@ virtio_net_send(void* cookie, net_buffer* buffer)
 	virtio_net_handle* handle = (virtio_net_handle*)cookie;
 	virtio_net_driver_info* info = handle->info;
 
-	mutex_lock(&info->txLock);
-	while (info->txFreeList.Head() == NULL) {
-		mutex_unlock(&info->txLock);
+	virtio_net_queue_pair* pair
+		= &info->pairs[smp_get_current_cpu() % info->txPairsCount];
+
+	MutexLocker txLocker(pair->txLock);
+	virtio_net_tx_reclaim(info, pair);
+	while (pair->txFreeList.Head() == NULL) {
+		txLocker.Unlock();
 		if (info->nonblocking)
 			return B_WOULD_BLOCK;
 
-		status_t status = acquire_sem(info->txDone);
+		status_t status = acquire_sem(pair->txDone);
 		if (status != B_OK) {
 			ERROR("acquire_sem(txDone) failed (%s)\n", strerror(status));
 			return status;
 		}
 
 		int32 semCount = 0;
-		get_sem_count(info->txDone, &semCount);
+		get_sem_count(pair->txDone, &semCount);
 		if (semCount > 0)
-			acquire_sem_etc(info->txDone, semCount, B_RELATIVE_TIMEOUT, 0);
+			acquire_sem_etc(pair->txDone, semCount, B_RELATIVE_TIMEOUT, 0);
 
-		mutex_lock(&info->txLock);
-		while (info->txDone != -1) {
-			BufInfo* buf = NULL;
-			if (!info->virtio->queue_dequeue(info->txQueues[0], (void**)&buf,
-					NULL) || buf == NULL) {
-				break;
-			}
-
-			info->txFreeList.Add(buf);
-		}
+		txLocker.Lock();
+		if (pair->txDone != -1)
+			virtio_net_tx_reclaim(info, pair);
 	}
-	BufInfo* buf = info->txFreeList.RemoveHead();
+	BufInfo* buf = pair->txFreeList.RemoveHead();
 
-	const size_t size = MIN(MAX_FRAME_SIZE, buffer->size);
-	TRACE("virtio_net_write: copying %lu\n", size);
-	if (sBufferModule->read(buffer, 0, buf->buffer, size) != B_OK) {
-		info->txFreeList.Add(buf);
-		mutex_unlock(&info->txLock);
-		return B_BAD_DATA;
+	memset(buf->hdr, 0, info->headerSize);
+	status_t status = virtio_net_tx_offloads(info, buffer, buf->hdr);
+	if (status != B_OK) {
+		pair->txFreeList.Add(buf);
+		return status;
 	}
-	memset(buf->hdr, 0, sizeof(virtio_net_hdr));
 
-	physical_entry entries[2];
+	physical_entry* entries = pair->txEntries;
 	entries[0] = buf->hdrEntry;
-	entries[0].size = sizeof(virtio_net_hdr);
-	entries[1] = buf->entry;
-	entries[1].size = size;
+	entries[0].size = info->headerSize;
+	size_t entryCount = 1;
+
+	const bool copy = buffer->size <= MAX_FRAME_SIZE;
+	if (copy) {
+		TRACE("virtio_net_write: copying %lu\n", buffer->size);
+		if (sBufferModule->read(buffer, 0, buf->buffer, buffer->size)
+				!= B_OK) {
+			pair->txFreeList.Add(buf);
+			return B_BAD_DATA;
+		}
 
-	// queue the virtio_net_hdr + buffer data
-	status_t status = info->virtio->queue_request_v(info->txQueues[0],
-		entries, 2, 0, buf);
-	mutex_unlock(&info->txLock);
+		entries[1] = buf->entry;
+		entries[1].size = buffer->size;
+		entryCount = 2;
+	} else {
+		// large (segmented) frames are read by the device directly
+		status = virtio_net_tx_map(pair, buffer, entryCount);
+		if (status != B_OK) {
+			ERROR("mapping a frame of %" B_PRIu32 " bytes failed (%s)\n",
+				buffer->size, strerror(status));
+			pair->txFreeList.Add(buf);
+			return status;
+		}
+		buf->txBuffer = buffer;
+	}
 
+	// queue the virtio_net_hdr + buffer data
+	status = info->virtio->queue_request_v(pair->txQueue, entries, entryCount,
+		0, buf);
 	if (status != B_OK) {
-		ERROR("tx queueing on queue %d failed (%s)\n", 0, strerror(status));
+		ERROR("tx queueing on queue %" B_PRId32 " failed (%s)\n",
+			(int32)(pair - info->pairs), strerror(status));
+		buf->txBuffer = NULL;
+		pair->txFreeList.Add(buf);
 		return status;
 	}
+	txLocker.Unlock();
 
-	sBufferModule->free(buffer);
+	if (copy)
+		sBufferModule->free(buffer);
 	return B_OK;
 }
 
@@ -926,6 +1266,14 @@ virtio_net_ioctl(void* cookie, uint32 op, void* buffer, size_t length)
 				return B_BAD_ADDRESS;
 			return virtio_net_receive(cookie, (net_buffer**)buffer);
 
+		case ETHER_GET_OFFLOADS:
+			TRACE("ioctl: get offloads\n");
+			if (length != sizeof(info->offloads))
+				return B_BAD_VALUE;
+
+			return user_memcpy(buffer, &info->offloads,
+				sizeof(info->offloads));
+
 		case SIOCGIFSTATS:
 			break;
 
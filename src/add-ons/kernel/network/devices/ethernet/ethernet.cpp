@@ -207,6 +207,13 @@ ethernet_up(net_device *_device)
 		device->frame_size = ETHER_MAX_FRAME_SIZE;
 #endif
 
+	if (!device->supports_net_buffer
+		|| ioctl(device->fd, ETHER_GET_OFFLOADS, &device->offloads,
+			sizeof(uint32)) < 0) {
+		// the offloads only work on the net_buffer itself
+		device->offloads = 0;
+	}
+
 	if (update_link_state(device, false) == B_OK) {
 		// device supports retrieval of the link state
 
@@ -274,7 +281,16 @@ ethernet_send_data(net_device *_device, net_buffer *buffer)
 	ethernet_device *device = (ethernet_device *)_device;
 
 //dprintf("try to send ethernet packet of %lu bytes (flags %ld):\n", buffer->size, buffer->flags);
-	if (buffer->size > device->frame_size || buffer->size < ETHER_HEADER_LENGTH)
+	size_t maxSize = device->frame_size;
+	if (buffer->segment_size != 0) {
+		if ((device->offloads & (NET_DEVICE_OFFLOAD_TSO_IPV4
+				| NET_DEVICE_OFFLOAD_TSO_IPV6)) == 0) {
+			return B_BAD_VALUE;
+		}
+		maxSize = ETHER_HEADER_LENGTH + 0xffff;
+	}
+
+	if (buffer->size > maxSize || buffer->size < ETHER_HEADER_LENGTH)
 		return B_BAD_VALUE;
 
 	if (device->supports_net_buffer) {
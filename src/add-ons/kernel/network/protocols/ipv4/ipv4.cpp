@@ -1600,8 +1600,9 @@ ipv4_send_routed_data(net_protocol* _protocol, struct net_route* route,
 		ntohl(destination.sin_addr.s_addr));
 
 	uint32 mtu = route->mtu ? route->mtu : interface->device->mtu;
-	if (buffer->size > mtu) {
-		// we need to fragment the packet
+	if (buffer->size > mtu && buffer->segment_size == 0) {
+		// we need to fragment the packet; segmented buffers are left to the
+		// device
 		return send_fragments(protocol, route, buffer, mtu);
 	}
 
@@ -1343,8 +1343,9 @@ ipv6_send_routed_data(net_protocol* _protocol, struct net_route* route,
 	TRACE_SK(protocol, "  SendRoutedData(): destination: %s", addrbuf);
 
 	uint32 mtu = route->mtu ? route->mtu : interface->device->mtu;
-	if (buffer->size > mtu) {
-		// we need to fragment the packet
+	if (buffer->size > mtu && buffer->segment_size == 0) {
+		// we need to fragment the packet; segmented buffers are left to the
+		// device
 		return send_fragments(protocol, route, buffer, mtu);
 	}
 
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "CongestionControl.h"
+
+#include <new>
+#include <string.h>
+
+
+template<typename Algorithm>
+static CongestionControl*
+create_algorithm()
+{
+	return new(std::nothrow) Algorithm;
+}
+
+
+static const struct {
+	const char*			name;
+	CongestionControl*	(*create)();
+} kAlgorithms[] = {
+	{"newreno", &create_algorithm<NewReno>},
+	{"cubic", &create_algorithm<Cubic>},
+};
+
+
+/*!	Creates a new instance of the congestion control algorithm called \a name,
+	or returns \c NULL if there is no such algorithm, or no memory.
+*/
+CongestionControl*
+create_congestion_control(const char* name)
+{
+	for (size_t i = 0; i < B_COUNT_OF(kAlgorithms); i++) {
+		if (strcmp(kAlgorithms[i].name, name) == 0)
+			return kAlgorithms[i].create();
+	}
+
+	return NULL;
+}
+
+
+//	#pragma mark -
+
+
+CongestionControl::~CongestionControl()
+{
+}
+
+
+/*!	Opens the congestion window after \a bytesAcknowledged new bytes have been
+	acknowledged outside of loss recovery. Slow start is the same for all
+	algorithms; it grows the window by at most one segment per ACK (RFC 3465).
+*/
+void
+CongestionControl::Acknowledged(uint32& congestionWindow,
+	uint32 slowStartThreshold, uint32 bytesAcknowledged, uint32 maxSegmentSize,
+	int32 roundTripTime)
+{
+	if (congestionWindow < slowStartThreshold) {
+		congestionWindow += min_c(bytesAcknowledged, maxSegmentSize);
+		return;
+	}
+
+	CongestionAvoidance(congestionWindow, bytesAcknowledged, maxSegmentSize,
+		roundTripTime);
+}
+
+
+//	#pragma mark - NewReno
+
+
+const char*
+NewReno::Name() const
+{
+	return "newreno";
+}
+
+
+uint32
+NewReno::LossDetected(uint32 congestionWindow, uint32 flightSize,
+	uint32 maxSegmentSize, bool timeout)
+{
+	return max_c(flightSize / 2, 2 * maxSegmentSize);
+}
+
+
+void
+NewReno::CongestionAvoidance(uint32& congestionWindow,
+	uint32 bytesAcknowledged, uint32 maxSegmentSize, int32 roundTripTime)
+{
+	// about one segment per round trip
+	uint32 increment = maxSegmentSize * maxSegmentSize;
+
+	if (increment < congestionWindow)
+		increment = 1;
+	else
+		increment /= congestionWindow;
+
+	congestionWindow += increment;
+}
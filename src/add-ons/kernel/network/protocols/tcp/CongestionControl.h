@@ -0,0 +1,98 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef CONGESTION_CONTROL_H
+#define CONGESTION_CONTROL_H
+
+
+#include <SupportDefs.h>
+
+
+#define TCP_DEFAULT_CONGESTION_CONTROL	"newreno"
+
+
+/*!	A congestion control algorithm. Every connection has its own instance, so
+	that an algorithm can keep per-connection state.
+	The algorithm only decides how the congestion window grows while data is
+	acknowledged, and what the slow start threshold becomes after a loss; the
+	endpoint takes care of loss detection and recovery itself.
+*/
+class CongestionControl {
+public:
+	virtual						~CongestionControl();
+
+	virtual	const char*			Name() const = 0;
+
+			void				Acknowledged(uint32& congestionWindow,
+									uint32 slowStartThreshold,
+									uint32 bytesAcknowledged,
+									uint32 maxSegmentSize,
+									int32 roundTripTime);
+	virtual	uint32				LossDetected(uint32 congestionWindow,
+									uint32 flightSize,
+									uint32 maxSegmentSize,
+									bool timeout) = 0;
+
+protected:
+	virtual	void				CongestionAvoidance(uint32& congestionWindow,
+									uint32 bytesAcknowledged,
+									uint32 maxSegmentSize,
+									int32 roundTripTime) = 0;
+};
+
+
+/*!	RFC 5681 congestion avoidance, with the NewReno modification of fast
+	recovery (RFC 6582) done by the endpoint.
+*/
+class NewReno : public CongestionControl {
+public:
+	virtual	const char*			Name() const;
+
+	virtual	uint32				LossDetected(uint32 congestionWindow,
+									uint32 flightSize,
+									uint32 maxSegmentSize,
+									bool timeout);
+
+protected:
+	virtual	void				CongestionAvoidance(uint32& congestionWindow,
+									uint32 bytesAcknowledged,
+									uint32 maxSegmentSize,
+									int32 roundTripTime);
+};
+
+
+/*!	CUBIC (RFC 9438): the window grows as a cubic function of the time since
+	the last loss, which lets it recover its previous size quickly on paths
+	with a large bandwidth-delay product.
+*/
+class Cubic : public CongestionControl {
+public:
+								Cubic();
+
+	virtual	const char*			Name() const;
+
+	virtual	uint32				LossDetected(uint32 congestionWindow,
+									uint32 flightSize,
+									uint32 maxSegmentSize,
+									bool timeout);
+
+protected:
+	virtual	void				CongestionAvoidance(uint32& congestionWindow,
+									uint32 bytesAcknowledged,
+									uint32 maxSegmentSize,
+									int32 roundTripTime);
+
+private:
+			uint32				fMaxWindow;
+			uint32				fOriginWindow;
+			uint32				fEstimatedWindow;
+			uint32				fEpochStart;
+			uint32				fTimeToOrigin;
+};
+
+
+CongestionControl* create_congestion_control(const char* name);
+
+
+#endif	// CONGESTION_CONTROL_H
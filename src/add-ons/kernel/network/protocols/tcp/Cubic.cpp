@@ -0,0 +1,141 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "CongestionControl.h"
+
+#include "tcp.h"
+
+
+// The constants of RFC 9438, as fractions: C = 0.4, and beta = 0.7.
+// alpha (3 * (1 - beta) / (1 + beta)) is used to follow the window Reno
+// would have, since CUBIC should never be slower than that.
+static const int64 kCubicFactor = 4;
+static const int64 kCubicDivisor = 10;
+static const uint32 kBetaFactor = 7;
+static const uint32 kBetaDivisor = 10;
+static const uint32 kAlphaFactor = 529;
+static const uint32 kAlphaDivisor = 1000;
+
+static const int64 kMaxTimeOffset = 100000;
+	// in ms; keeps the cube of the offset well in range
+
+
+/*!	Integer cube root, rounded down. */
+static uint32
+cube_root(uint64 value)
+{
+	uint64 root = 0;
+	for (int shift = 63; shift >= 0; shift -= 3) {
+		root <<= 1;
+		uint64 bit = 3 * root * (root + 1) + 1;
+		if ((value >> shift) >= bit) {
+			value -= bit << shift;
+			root++;
+		}
+	}
+
+	return (uint32)root;
+}
+
+
+Cubic::Cubic()
+	:
+	fMaxWindow(0),
+	fOriginWindow(0),
+	fEstimatedWindow(0),
+	fEpochStart(0),
+	fTimeToOrigin(0)
+{
+}
+
+
+const char*
+Cubic::Name() const
+{
+	return "cubic";
+}
+
+
+uint32
+Cubic::LossDetected(uint32 congestionWindow, uint32 flightSize,
+	uint32 maxSegmentSize, bool timeout)
+{
+	fEpochStart = 0;
+
+	// Fast convergence: if we lost before reaching the window of the last
+	// loss, another flow probably needs the bandwidth; give it up faster.
+	if (congestionWindow < fMaxWindow) {
+		fMaxWindow = (uint64)congestionWindow * (kBetaDivisor + kBetaFactor)
+			/ (2 * kBetaDivisor);
+	} else
+		fMaxWindow = congestionWindow;
+
+	return max_c((uint64)congestionWindow * kBetaFactor / kBetaDivisor,
+		2 * maxSegmentSize);
+}
+
+
+void
+Cubic::CongestionAvoidance(uint32& congestionWindow,
+	uint32 bytesAcknowledged, uint32 maxSegmentSize, int32 roundTripTime)
+{
+	uint32 now = tcp_now();
+
+	if (fEpochStart == 0) {
+		// Start a new epoch: the window follows W(t) = C * (t - K)^3 + W_max,
+		// with K being the time it takes to get back to W_max.
+		fEpochStart = now != 0 ? now : 1;
+		fEstimatedWindow = congestionWindow;
+
+		if (congestionWindow < fMaxWindow) {
+			// K = cbrt((W_max - cwnd) / C), computed in segments scaled by
+			// 1024, and in milliseconds (10^9 / 0.4 / 1024 = 2441406)
+			uint64 segments = (uint64)(fMaxWindow - congestionWindow) * 1024
+				/ maxSegmentSize;
+			fTimeToOrigin = cube_root(segments * 2441406);
+			fOriginWindow = fMaxWindow;
+		} else {
+			fTimeToOrigin = 0;
+			fOriginWindow = congestionWindow;
+		}
+	}
+
+	// Aim at where the window should be one round trip from now
+	int64 time = (int32)(now - fEpochStart) + max_c(roundTripTime, 0);
+	int64 offset = time - fTimeToOrigin;
+	if (offset > kMaxTimeOffset)
+		offset = kMaxTimeOffset;
+	else if (offset < -kMaxTimeOffset)
+		offset = -kMaxTimeOffset;
+
+	int64 delta = offset * offset * offset / 1000 * kCubicFactor
+		* maxSegmentSize / (kCubicDivisor * 1000000);
+	int64 target = (int64)fOriginWindow + delta;
+	if (target > (int64)congestionWindow * 3 / 2)
+		target = (int64)congestionWindow * 3 / 2;
+
+	fEstimatedWindow += (uint64)maxSegmentSize * bytesAcknowledged
+		* kAlphaFactor / ((uint64)kAlphaDivisor * congestionWindow);
+
+	if (target < (int64)fEstimatedWindow) {
+		// we are in the Reno-friendly region
+		if (fEstimatedWindow > congestionWindow)
+			congestionWindow = fEstimatedWindow;
+		return;
+	}
+
+	uint64 increment;
+	if (target > (int64)congestionWindow) {
+		increment = (uint64)(target - congestionWindow) * bytesAcknowledged
+			/ congestionWindow;
+	} else {
+		// close to W_max, probe very slowly
+		increment = (uint64)maxSegmentSize * bytesAcknowledged
+			/ (100 * (uint64)congestionWindow);
+	}
+
+	congestionWindow += increment;
+}
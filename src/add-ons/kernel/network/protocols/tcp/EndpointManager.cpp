@@ -132,6 +132,8 @@ protected:
 
 static const uint16 kLastReservedPort = 1023;
 static const uint16 kFirstEphemeralPort = 40000;
+static const int32 kMaxTimeWaitEntries = 65536;
+	// when there are more, the oldest ones are dropped early
 
 
 ConnectionHashDefinition::ConnectionHashDefinition(EndpointManager* manager)
@@ -214,18 +216,63 @@ EndpointHashDefinition::GetLink(TCPEndpoint* endpoint) const
 //	#pragma mark -
 
 
+ReusePortGroup::ReusePortGroup(uid_t owner)
+	:
+	fOwner(owner)
+{
+}
+
+
+/*!	Chooses the member that gets the connection with the given \a flowHash.
+	Members that are no longer listening are skipped.
+	You must hold the manager's lock when calling this method.
+*/
+TCPEndpoint*
+ReusePortGroup::Select(size_t flowHash) const
+{
+	int32 count = fMembers.Count();
+
+	// spread the bits of the hash over the whole range
+	int32 index = (((uint32)flowHash * 0x9e3779b1U) >> 16) % count;
+
+	for (int32 i = 0; i < count; i++) {
+		TCPEndpoint* endpoint = fMembers.ElementAt((index + i) % count);
+		if (endpoint->State() == LISTEN)
+			return endpoint;
+	}
+
+	return fMembers.ElementAt(index);
+}
+
+
+//	#pragma mark -
+
+
 EndpointManager::EndpointManager(net_domain* domain)
 	:
 	fDomain(domain),
 	fConnectionHash(this),
-	fLastPort(kFirstEphemeralPort)
+	fLastPort(kFirstEphemeralPort),
+	fSynCache(this),
+	fTimeWaitHash(domain->address_module),
+	fTimeWaitCount(0)
 {
 	rw_lock_init(&fLock, "TCP endpoint manager");
+	mutex_init(&fTimeWaitLock, "TCP time-wait");
+	gStackModule->init_timer(&fTimeWaitTimer, &EndpointManager::_TimeWaitTimer,
+		this);
 }
 
 
 EndpointManager::~EndpointManager()
 {
+	gStackModule->cancel_timer(&fTimeWaitTimer);
+	gStackModule->wait_for_timer(&fTimeWaitTimer);
+
+	while (time_wait_entry* entry = fTimeWaitList.RemoveHead())
+		delete entry;
+
+	mutex_destroy(&fTimeWaitLock);
 	rw_lock_destroy(&fLock);
 }
 
@@ -236,6 +283,10 @@ EndpointManager::Init()
 	status_t status = fConnectionHash.Init();
 	if (status == B_OK)
 		status = fEndpointHash.Init();
+	if (status == B_OK)
+		status = fSynCache.Init();
+	if (status == B_OK)
+		status = fTimeWaitHash.Init();
 
 	return status;
 }
@@ -255,6 +306,47 @@ EndpointManager::_LookupConnection(const sockaddr* local, const sockaddr* peer)
 }
 
 
+/*!	If \a endpoint is part of a SO_REUSEPORT group, this returns the member
+	of the group that should handle the connection from \a peer to \a local.
+	You must hold the manager's lock when calling this method (either read or
+	write).
+*/
+TCPEndpoint*
+EndpointManager::_SelectListener(TCPEndpoint* endpoint, const sockaddr* local,
+	const sockaddr* peer)
+{
+	if (endpoint == NULL || endpoint->fReusePortGroup == NULL)
+		return endpoint;
+
+	return endpoint->fReusePortGroup->Select(
+		ConstSocketAddress(AddressModule(), local).HashPair(peer));
+}
+
+
+/*!	Removes \a endpoint from its SO_REUSEPORT group, and makes sure the
+	group stays reachable through the connection hash.
+	You must hold the manager's write lock when calling this method.
+*/
+void
+EndpointManager::_LeaveReusePortGroup(TCPEndpoint* endpoint)
+{
+	ReusePortGroup* group = endpoint->fReusePortGroup;
+	endpoint->fReusePortGroup = NULL;
+
+	bool wasFirst = group->First() == endpoint;
+	group->Remove(endpoint);
+
+	if (wasFirst) {
+		fConnectionHash.Remove(endpoint);
+		if (group->CountMembers() > 0)
+			fConnectionHash.Insert(group->First());
+	}
+
+	if (group->CountMembers() == 0)
+		delete group;
+}
+
+
 status_t
 EndpointManager::SetConnection(TCPEndpoint* endpoint, const sockaddr* _local,
 	const sockaddr* peer, const sockaddr* interfaceLocal)
@@ -274,7 +366,8 @@ EndpointManager::SetConnection(TCPEndpoint* endpoint, const sockaddr* _local,
 
 	// We want to create a connection for (local, peer), so check to make sure
 	// that this pair is not already in use by an existing connection.
-	if (_LookupConnection(*local, peer) != NULL)
+	if (_LookupConnection(*local, peer) != NULL
+		|| !_ReuseTimeWait(*local, peer))
 		return EADDRINUSE;
 
 	endpoint->LocalAddress().SetTo(*local);
@@ -319,8 +412,35 @@ EndpointManager::SetPassive(TCPEndpoint* endpoint)
 	SocketAddressStorage passive(AddressModule());
 	passive.SetToEmpty();
 
-	if (_LookupConnection(*endpoint->LocalAddress(), *passive))
-		return EADDRINUSE;
+	TCPEndpoint* listener = _LookupConnection(*endpoint->LocalAddress(),
+		*passive);
+	if (listener != NULL) {
+		// Only join listeners of the same user that explicitly allowed it
+		ReusePortGroup* group = listener->fReusePortGroup;
+		if (group == NULL || (endpoint->socket->options & SO_REUSEPORT) == 0
+			|| group->Owner() != geteuid()) {
+			return EADDRINUSE;
+		}
+
+		status_t status = group->Add(endpoint);
+		if (status != B_OK)
+			return status;
+
+		endpoint->fReusePortGroup = group;
+		endpoint->PeerAddress().SetTo(*passive);
+		return B_OK;
+	}
+
+	if ((endpoint->socket->options & SO_REUSEPORT) != 0) {
+		// start a group others can join later
+		ReusePortGroup* group = new(std::nothrow) ReusePortGroup(geteuid());
+		if (group == NULL || group->Add(endpoint) != B_OK) {
+			delete group;
+			return B_NO_MEMORY;
+		}
+
+		endpoint->fReusePortGroup = group;
+	}
 
 	endpoint->PeerAddress().SetTo(*passive);
 	fConnectionHash.Insert(endpoint);
@@ -346,7 +466,8 @@ EndpointManager::FindConnection(sockaddr* local, sockaddr* peer)
 	SocketAddressStorage wildcard(AddressModule());
 	wildcard.SetToEmpty();
 
-	endpoint = _LookupConnection(local, *wildcard);
+	endpoint = _SelectListener(_LookupConnection(local, *wildcard), local,
+		peer);
 	if (endpoint != NULL) {
 		TRACE(("TCP: Received packet corresponds to wildcard endpoint %p\n",
 			endpoint));
@@ -358,7 +479,8 @@ EndpointManager::FindConnection(sockaddr* local, sockaddr* peer)
 	localWildcard.SetToEmpty();
 	localWildcard.SetPort(AddressModule()->get_port(local));
 
-	endpoint = _LookupConnection(*localWildcard, *wildcard);
+	endpoint = _SelectListener(_LookupConnection(*localWildcard, *wildcard),
+		local, peer);
 	if (endpoint != NULL) {
 		TRACE(("TCP: Received packet corresponds to local wildcard endpoint "
 			"%p\n", endpoint));
@@ -448,6 +570,13 @@ EndpointManager::_BindToAddress(WriteLocker& locker, TCPEndpoint* endpoint,
 					break;
 				}
 
+				if ((endpoint->socket->options & SO_REUSEPORT) != 0
+					&& (user->socket->options & SO_REUSEPORT) != 0) {
+					// both may share the port; listen() decides whether they
+					// may form a group
+					continue;
+				}
+
 				if ((endpoint->socket->options & SO_REUSEADDR) == 0)
 					return EADDRINUSE;
 
@@ -457,6 +586,10 @@ EndpointManager::_BindToAddress(WriteLocker& locker, TCPEndpoint* endpoint,
 		}
 	} while (retry-- > 0);
 
+	if ((endpoint->socket->options & SO_REUSEADDR) == 0
+		&& _IsPortInTimeWait(*address))
+		return EADDRINUSE;
+
 	return _Bind(endpoint, *address);
 }
 
@@ -537,7 +670,10 @@ EndpointManager::Unbind(TCPEndpoint* endpoint)
 	if (!fEndpointHash.Remove(endpoint))
 		panic("bound endpoint %p not in hash!", endpoint);
 
-	fConnectionHash.Remove(endpoint);
+	if (endpoint->fReusePortGroup != NULL)
+		_LeaveReusePortGroup(endpoint);
+	else
+		fConnectionHash.Remove(endpoint);
 
 	(*endpoint->LocalAddress())->sa_len = 0;
 
@@ -572,7 +708,17 @@ EndpointManager::ReplyWithReset(tcp_segment_header& segment, net_buffer* buffer)
 	} else
 		outSegment.sequence = segment.acknowledge;
 
-	status_t status = add_tcp_header(AddressModule(), outSegment, reply);
+	return SendReply(outSegment, reply);
+}
+
+
+/*!	Sends a segment that does not belong to any endpoint. The addresses of
+	\a reply must already be set; it is freed in case of an error.
+*/
+status_t
+EndpointManager::SendReply(tcp_segment_header& segment, net_buffer* reply)
+{
+	status_t status = add_tcp_header(AddressModule(), segment, reply);
 	if (status == B_OK)
 		status = Domain()->module->send_data(NULL, reply);
 
@@ -583,6 +729,220 @@ EndpointManager::ReplyWithReset(tcp_segment_header& segment, net_buffer* buffer)
 }
 
 
+//	#pragma mark - time-wait
+
+
+/*!	Takes over a connection in TIME_WAIT state, so that its endpoint can be
+	deleted right away.
+*/
+status_t
+EndpointManager::EnterTimeWait(const time_wait_entry& _entry)
+{
+	MutexLocker locker(fTimeWaitLock);
+
+	time_wait_entry* entry = fTimeWaitHash.Lookup(std::make_pair(
+		(const sockaddr*)&_entry.local, (const sockaddr*)&_entry.peer));
+	if (entry != NULL) {
+		_RemoveTimeWait(entry);
+		entry = NULL;
+	}
+
+	if (fTimeWaitCount >= kMaxTimeWaitEntries) {
+		// recycle the entry that would expire next
+		entry = fTimeWaitList.RemoveHead();
+		fTimeWaitHash.RemoveUnchecked(entry);
+		atomic_add(&fTimeWaitCount, -1);
+	} else {
+		entry = new(std::nothrow) time_wait_entry;
+		if (entry == NULL)
+			return B_NO_MEMORY;
+	}
+
+	*entry = _entry;
+	entry->expires = system_time() + (TCP_MAX_SEGMENT_LIFETIME << 1);
+
+	if (fTimeWaitList.IsEmpty()) {
+		gStackModule->set_timer(&fTimeWaitTimer,
+			TCP_MAX_SEGMENT_LIFETIME << 1);
+	}
+
+	fTimeWaitHash.Insert(entry);
+	fTimeWaitList.Add(entry);
+	atomic_add(&fTimeWaitCount, 1);
+
+	return B_OK;
+}
+
+
+/*!	Handles a segment for a connection that is in the time-wait table.
+	Returns \c false if there is no such connection, or if the segment
+	starts a new incarnation of it; the segment must then be passed on to
+	the endpoints as usual.
+*/
+bool
+EndpointManager::TimeWaitReceived(tcp_segment_header& segment,
+	net_buffer* buffer, int32& segmentAction)
+{
+	if (atomic_get(&fTimeWaitCount) == 0)
+		return false;
+
+	MutexLocker locker(fTimeWaitLock);
+
+	time_wait_entry* entry = fTimeWaitHash.Lookup(std::make_pair(
+		(const sockaddr*)buffer->destination,
+		(const sockaddr*)buffer->source));
+	if (entry == NULL)
+		return false;
+
+	segmentAction = DROP;
+
+	// We generally ignore resets in time wait state (see RFC 1337)
+	if ((segment.flags & TCP_FLAG_RESET) != 0)
+		return true;
+
+	bool hasTimestamp = entry->timestamps
+		&& (segment.options & TCP_HAS_TIMESTAMPS) != 0;
+
+	if ((segment.flags & (TCP_FLAG_SYNCHRONIZE | TCP_FLAG_ACKNOWLEDGE))
+			== TCP_FLAG_SYNCHRONIZE
+		&& (tcp_sequence(segment.sequence) > entry->receive_next
+			|| (hasTimestamp && (int32)(segment.timestamp_value
+				- entry->received_timestamp) > 0))) {
+		// The SYN cannot be an old duplicate, so the address pair may be
+		// reused right away (RFC 1122, 4.2.2.13, and RFC 6191)
+		_RemoveTimeWait(entry);
+		return false;
+	}
+
+	if ((segment.flags & TCP_FLAG_FINISH) != 0) {
+		// our last ACK got lost - restart the 2MSL timeout
+		entry->expires = system_time() + (TCP_MAX_SEGMENT_LIFETIME << 1);
+		fTimeWaitList.Remove(entry);
+		fTimeWaitList.Add(entry);
+	} else if (buffer->size == 0
+		&& (segment.flags & TCP_FLAG_SYNCHRONIZE) == 0) {
+		// never answer a pure ACK
+		return true;
+	}
+
+	if (hasTimestamp)
+		entry->received_timestamp = segment.timestamp_value;
+
+	_SendTimeWaitAcknowledge(*entry);
+	return true;
+}
+
+
+/*!	Checks if the connection (\a local, \a peer) may be established while
+	it's still in the time-wait table. If the old connection used timestamps,
+	PAWS protects the new one from old duplicates, and its entry is removed.
+	You must hold the manager's lock when calling this method.
+*/
+bool
+EndpointManager::_ReuseTimeWait(const sockaddr* local, const sockaddr* peer)
+{
+	if (atomic_get(&fTimeWaitCount) == 0)
+		return true;
+
+	MutexLocker locker(fTimeWaitLock);
+
+	time_wait_entry* entry = fTimeWaitHash.Lookup(std::make_pair(local, peer));
+	if (entry == NULL)
+		return true;
+	if (!entry->timestamps)
+		return false;
+
+	_RemoveTimeWait(entry);
+	return true;
+}
+
+
+/*!	Returns whether any connection in the time-wait table uses the local
+	\a address, just like endpoints in TIME_WAIT state would block it.
+	This walks the whole table, but is only needed for binding to a specific
+	port without SO_REUSEADDR.
+*/
+bool
+EndpointManager::_IsPortInTimeWait(const sockaddr* _address)
+{
+	if (atomic_get(&fTimeWaitCount) == 0)
+		return false;
+
+	ConstSocketAddress address(AddressModule(), _address);
+	bool anyAddress = address.IsEmpty(false);
+
+	MutexLocker locker(fTimeWaitLock);
+
+	TimeWaitList::Iterator iterator = fTimeWaitList.GetIterator();
+	while (time_wait_entry* entry = iterator.Next()) {
+		const sockaddr* local = (const sockaddr*)&entry->local;
+		if (address.EqualPorts(local)
+			&& (anyAddress || address.EqualTo(local, false)))
+			return true;
+	}
+
+	return false;
+}
+
+
+/*!	You must hold the time-wait lock when calling this method. */
+void
+EndpointManager::_RemoveTimeWait(time_wait_entry* entry)
+{
+	fTimeWaitHash.RemoveUnchecked(entry);
+	fTimeWaitList.Remove(entry);
+	atomic_add(&fTimeWaitCount, -1);
+
+	delete entry;
+}
+
+
+status_t
+EndpointManager::_SendTimeWaitAcknowledge(const time_wait_entry& entry)
+{
+	net_buffer* reply = gBufferModule->create(256);
+	if (reply == NULL)
+		return B_NO_MEMORY;
+
+	AddressModule()->set_to(reply->source, (const sockaddr*)&entry.local);
+	AddressModule()->set_to(reply->destination, (const sockaddr*)&entry.peer);
+
+	tcp_segment_header segment(TCP_FLAG_ACKNOWLEDGE);
+	segment.sequence = entry.send_next.Number();
+	segment.acknowledge = entry.receive_next.Number();
+	segment.advertised_window = 0;
+	segment.urgent_offset = 0;
+
+	if (entry.timestamps) {
+		segment.options |= TCP_HAS_TIMESTAMPS;
+		segment.timestamp_value = tcp_now();
+		segment.timestamp_reply = entry.received_timestamp;
+	}
+
+	return SendReply(segment, reply);
+}
+
+
+/*static*/ void
+EndpointManager::_TimeWaitTimer(net_timer* timer, void* _manager)
+{
+	EndpointManager* manager = (EndpointManager*)_manager;
+
+	MutexLocker locker(manager->fTimeWaitLock);
+
+	bigtime_t now = system_time();
+
+	while (time_wait_entry* entry = manager->fTimeWaitList.Head()) {
+		if (entry->expires > now) {
+			gStackModule->set_timer(timer, entry->expires - now);
+			break;
+		}
+
+		manager->_RemoveTimeWait(entry);
+	}
+}
+
+
 void
 EndpointManager::Dump() const
 {
@@ -602,6 +962,31 @@ EndpointManager::Dump() const
 		kprintf("%p %21s %21s %8lu %8lu %12s\n", endpoint, localBuf, peerBuf,
 			endpoint->fReceiveQueue.Available(), endpoint->fSendQueue.Used(),
 			name_for_state(endpoint->State()));
+
+		ReusePortGroup* group = endpoint->fReusePortGroup;
+		if (group == NULL)
+			continue;
+
+		// the other members of the group are not in the hash
+		for (int32 i = 1; i < group->CountMembers(); i++) {
+			kprintf("%p %21s %21s %8s %8s %12s\n", group->MemberAt(i),
+				"", "(reuseport)", "", "", "");
+		}
 	}
+
+	TimeWaitList::ConstIterator timeWaitIterator
+		= fTimeWaitList.GetIterator();
+	while (const time_wait_entry* entry = timeWaitIterator.Next()) {
+		char localBuf[64], peerBuf[64];
+		ConstSocketAddress(AddressModule(), (const sockaddr*)&entry->local)
+			.AsString(localBuf, sizeof(localBuf), true);
+		ConstSocketAddress(AddressModule(), (const sockaddr*)&entry->peer)
+			.AsString(peerBuf, sizeof(peerBuf), true);
+
+		kprintf("%10s %21s %21s %8s %8s %12s\n", "-", localBuf, peerBuf, "",
+			"", "time-wait");
+	}
+
+	fSynCache.Dump();
 }
 
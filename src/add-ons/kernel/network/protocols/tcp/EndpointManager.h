@@ -10,6 +10,7 @@
 #define ENDPOINT_MANAGER_H
 
 
+#include "SynCache.h"
 #include "tcp.h"
 
 #include <AddressUtilities.h>
@@ -19,6 +20,7 @@
 #include <util/DoublyLinkedList.h>
 #include <util/MultiHashTable.h>
 #include <util/OpenHashTable.h>
+#include <util/Vector.h>
 
 #include <utility>
 
@@ -66,6 +68,54 @@ public:
 };
 
 
+/*!	The listening endpoints that share their local address via SO_REUSEPORT.
+	Only the first member is in the connection hash; incoming connections are
+	spread over all members by their flow hash, so that each member keeps its
+	own accept backlog.
+*/
+class ReusePortGroup {
+public:
+							ReusePortGroup(uid_t owner);
+
+			uid_t			Owner() const { return fOwner; }
+
+			status_t		Add(TCPEndpoint* endpoint)
+								{ return fMembers.PushBack(endpoint); }
+			void			Remove(TCPEndpoint* endpoint)
+								{ fMembers.Remove(endpoint); }
+
+			int32			CountMembers() const
+								{ return fMembers.Count(); }
+			TCPEndpoint*	First() const
+								{ return fMembers.ElementAt(0); }
+			TCPEndpoint*	MemberAt(int32 index) const
+								{ return fMembers.ElementAt(index); }
+
+			TCPEndpoint*	Select(size_t flowHash) const;
+
+private:
+	Vector<TCPEndpoint*>	fMembers;
+	uid_t					fOwner;
+};
+
+
+/*!	What remains of a connection in TIME_WAIT state after its socket has been
+	closed: just enough to acknowledge retransmitted FINs, and to protect the
+	address pair from being reused too early.
+*/
+struct time_wait_entry : DoublyLinkedListLinkImpl<time_wait_entry> {
+	sockaddr_storage	local;
+	sockaddr_storage	peer;
+	time_wait_entry*	hash_link;
+
+	tcp_sequence		send_next;
+	tcp_sequence		receive_next;
+	uint32				received_timestamp;
+	bool				timestamps;
+	bigtime_t			expires;
+};
+
+
 class EndpointManager : public DoublyLinkedListLinkImpl<EndpointManager> {
 public:
 							EndpointManager(net_domain* domain);
@@ -88,6 +138,14 @@ public:
 
 			status_t		ReplyWithReset(tcp_segment_header& segment,
 								net_buffer* buffer);
+			status_t		SendReply(tcp_segment_header& segment,
+								net_buffer* reply);
+
+			status_t		EnterTimeWait(const time_wait_entry& entry);
+			bool			TimeWaitReceived(tcp_segment_header& segment,
+								net_buffer* buffer, int32& segmentAction);
+
+			SynCache&		GetSynCache() { return fSynCache; }
 
 			net_domain*		Domain() const { return fDomain; }
 			net_address_module_info* AddressModule() const
@@ -98,6 +156,9 @@ public:
 private:
 			TCPEndpoint*	_LookupConnection(const sockaddr* local,
 								const sockaddr* peer);
+			TCPEndpoint*	_SelectListener(TCPEndpoint* endpoint,
+								const sockaddr* local, const sockaddr* peer);
+			void			_LeaveReusePortGroup(TCPEndpoint* endpoint);
 			status_t		_Bind(TCPEndpoint* endpoint,
 								const sockaddr* address);
 			status_t		_BindToAddress(WriteLocker& locker,
@@ -105,14 +166,34 @@ private:
 			status_t		_BindToEphemeral(TCPEndpoint* endpoint,
 								const sockaddr* address);
 
+			bool			_ReuseTimeWait(const sockaddr* local,
+								const sockaddr* peer);
+			bool			_IsPortInTimeWait(const sockaddr* address);
+			void			_RemoveTimeWait(time_wait_entry* entry);
+			status_t		_SendTimeWaitAcknowledge(
+								const time_wait_entry& entry);
+	static	void			_TimeWaitTimer(net_timer* timer, void* _manager);
+
 	typedef BOpenHashTable<ConnectionHashDefinition> ConnectionTable;
 	typedef MultiHashTable<EndpointHashDefinition> EndpointTable;
+	typedef BOpenHashTable<AddressPairHashDefinition<time_wait_entry> >
+		TimeWaitTable;
+	typedef DoublyLinkedList<time_wait_entry> TimeWaitList;
 
 	rw_lock					fLock;
 	net_domain*				fDomain;
 	ConnectionTable			fConnectionHash;
 	EndpointTable			fEndpointHash;
 	uint16					fLastPort;
+
+	SynCache				fSynCache;
+
+	mutex					fTimeWaitLock;
+	TimeWaitTable			fTimeWaitHash;
+	TimeWaitList			fTimeWaitList;
+		// ordered by expiration
+	int32					fTimeWaitCount;
+	net_timer				fTimeWaitTimer;
 };
 
 #endif	// ENDPOINT_MANAGER_H
@@ -0,0 +1,235 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "SackScoreboard.h"
+
+#include <string.h>
+
+#include <KernelExport.h>
+
+
+SackScoreboard::SackScoreboard()
+	:
+	fCount(0)
+{
+}
+
+
+void
+SackScoreboard::Clear()
+{
+	fCount = 0;
+}
+
+
+/*!	Removes everything that \a acknowledge covers, and adds the blocks the
+	peer reported in its last segment.
+	Blocks that lie below \a acknowledge (D-SACKs, RFC 2883), or beyond
+	anything we have sent, are ignored.
+	Returns whether the peer selectively acknowledged any new data.
+*/
+bool
+SackScoreboard::Update(tcp_sequence acknowledge, tcp_sequence sendMax,
+	const tcp_sack* sacks, int count)
+{
+	RemoveUntil(acknowledge);
+
+	uint32 previouslySacked = SackedBytes();
+
+	for (int i = 0; i < count; i++) {
+		tcp_sequence left = sacks[i].left_edge;
+		tcp_sequence right = sacks[i].right_edge;
+
+		if (right <= left || right <= acknowledge || right > sendMax)
+			continue;
+		if (left < acknowledge)
+			left = acknowledge;
+
+		_Insert(left, right);
+	}
+
+	return SackedBytes() > previouslySacked;
+}
+
+
+void
+SackScoreboard::RemoveUntil(tcp_sequence sequence)
+{
+	int32 count = 0;
+	while (count < fCount && fBlocks[count].right <= sequence)
+		count++;
+
+	if (count > 0) {
+		memmove(&fBlocks[0], &fBlocks[count],
+			(fCount - count) * sizeof(block));
+		fCount -= count;
+	}
+
+	if (fCount > 0 && fBlocks[0].left < sequence)
+		fBlocks[0].left = sequence;
+}
+
+
+/*!	Returns whether the segment starting at \a sequence is considered lost,
+	that is, enough data above it has been selectively acknowledged.
+*/
+bool
+SackScoreboard::IsLost(tcp_sequence sequence, uint32 maxSegmentSize) const
+{
+	int32 hole = 0;
+	while (hole < fCount && fBlocks[hole].right <= sequence)
+		hole++;
+
+	if (hole < fCount && fBlocks[hole].left <= sequence)
+		return false;
+
+	return _IsLost(hole, maxSegmentSize);
+}
+
+
+/*!	Estimates how many bytes are still in the network: everything that has
+	been neither acknowledged nor considered lost, plus what has been
+	retransmitted (up to \a highRetransmitted).
+*/
+uint32
+SackScoreboard::Pipe(tcp_sequence unacknowledged, tcp_sequence sendMax,
+	tcp_sequence highRetransmitted, uint32 maxSegmentSize) const
+{
+	uint32 pipe = 0;
+
+	for (int32 hole = 0; hole <= fCount; hole++) {
+		tcp_sequence start = hole == 0
+			? unacknowledged : fBlocks[hole - 1].right;
+		tcp_sequence end = hole < fCount ? fBlocks[hole].left : sendMax;
+		if (end <= start)
+			continue;
+
+		if (!_IsLost(hole, maxSegmentSize))
+			pipe += (end - start).Number();
+
+		if (highRetransmitted > start) {
+			tcp_sequence retransmitted = highRetransmitted < end
+				? highRetransmitted : end;
+			pipe += (retransmitted - start).Number();
+		}
+	}
+
+	return pipe;
+}
+
+
+/*!	Chooses the next segment to retransmit: the first hole above
+	\a highRetransmitted that is considered lost, or, if \a lostOnly is
+	\c false, any hole below the highest selectively acknowledged data.
+	Returns \c false if there is nothing to retransmit.
+*/
+bool
+SackScoreboard::NextSegment(tcp_sequence unacknowledged, tcp_sequence sendMax,
+	tcp_sequence highRetransmitted, uint32 maxSegmentSize, bool lostOnly,
+	tcp_sequence& _sequence, uint32& _length) const
+{
+	// the hole above the last block is never considered lost
+	for (int32 hole = 0; hole < fCount; hole++) {
+		tcp_sequence start = hole == 0
+			? unacknowledged : fBlocks[hole - 1].right;
+		tcp_sequence end = fBlocks[hole].left;
+		if (start < highRetransmitted)
+			start = highRetransmitted;
+		if (end <= start)
+			continue;
+
+		if (lostOnly && !_IsLost(hole, maxSegmentSize))
+			continue;
+
+		_sequence = start;
+		_length = min_c((end - start).Number(), maxSegmentSize);
+		return true;
+	}
+
+	return false;
+}
+
+
+uint32
+SackScoreboard::SackedBytes() const
+{
+	uint32 bytes = 0;
+	for (int32 i = 0; i < fCount; i++)
+		bytes += (fBlocks[i].right - fBlocks[i].left).Number();
+
+	return bytes;
+}
+
+
+void
+SackScoreboard::Dump() const
+{
+	kprintf("  sack scoreboard: %" B_PRId32 " blocks", fCount);
+	for (int32 i = 0; i < fCount; i++) {
+		kprintf(" %" B_PRIu32 "-%" B_PRIu32, fBlocks[i].left.Number(),
+			fBlocks[i].right.Number());
+	}
+	kprintf("\n");
+}
+
+
+void
+SackScoreboard::_Insert(tcp_sequence left, tcp_sequence right)
+{
+	int32 first = 0;
+	while (first < fCount && fBlocks[first].right < left)
+		first++;
+
+	// merge all blocks that overlap with, or touch the new one
+	int32 last = first;
+	while (last < fCount && fBlocks[last].left <= right) {
+		if (fBlocks[last].left < left)
+			left = fBlocks[last].left;
+		if (fBlocks[last].right > right)
+			right = fBlocks[last].right;
+		last++;
+	}
+
+	int32 merged = last - first;
+	if (merged == 0) {
+		if (fCount == kMaxBlocks) {
+			if (first == fCount)
+				return;
+
+			// forget about the highest block to make room
+			fCount--;
+		}
+
+		memmove(&fBlocks[first + 1], &fBlocks[first],
+			(fCount - first) * sizeof(block));
+		fCount++;
+	} else if (merged > 1) {
+		memmove(&fBlocks[first + 1], &fBlocks[last],
+			(fCount - last) * sizeof(block));
+		fCount -= merged - 1;
+	}
+
+	fBlocks[first].left = left;
+	fBlocks[first].right = right;
+}
+
+
+/*!	A hole is lost if there are at least DupThresh blocks above it, or more
+	than (DupThresh - 1) * SMSS bytes have been acknowledged above it
+	(RFC 6675, section 4).
+*/
+bool
+SackScoreboard::_IsLost(int32 hole, uint32 maxSegmentSize) const
+{
+	if (fCount - hole >= kDuplicateThreshold)
+		return true;
+
+	uint32 sackedAbove = 0;
+	for (int32 i = hole; i < fCount; i++)
+		sackedAbove += (fBlocks[i].right - fBlocks[i].left).Number();
+
+	return sackedAbove > (kDuplicateThreshold - 1) * maxSegmentSize;
+}
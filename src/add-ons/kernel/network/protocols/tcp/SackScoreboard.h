@@ -0,0 +1,67 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef SACK_SCOREBOARD_H
+#define SACK_SCOREBOARD_H
+
+
+#include "tcp.h"
+
+
+/*!	Remembers which parts of the data in flight the peer has selectively
+	acknowledged, and implements the loss recovery algorithm of RFC 6675 on
+	top of it.
+	The blocks are kept sorted, and never overlap. Only a limited number of
+	them is kept; if there are more holes than that, the highest blocks are
+	forgotten, which only makes the recovery more conservative.
+*/
+class SackScoreboard {
+public:
+								SackScoreboard();
+
+			void				Clear();
+			bool				IsEmpty() const { return fCount == 0; }
+
+			bool				Update(tcp_sequence acknowledge,
+									tcp_sequence sendMax,
+									const tcp_sack* sacks, int count);
+			void				RemoveUntil(tcp_sequence sequence);
+
+			bool				IsLost(tcp_sequence sequence,
+									uint32 maxSegmentSize) const;
+			uint32				Pipe(tcp_sequence unacknowledged,
+									tcp_sequence sendMax,
+									tcp_sequence highRetransmitted,
+									uint32 maxSegmentSize) const;
+			bool				NextSegment(tcp_sequence unacknowledged,
+									tcp_sequence sendMax,
+									tcp_sequence highRetransmitted,
+									uint32 maxSegmentSize, bool lostOnly,
+									tcp_sequence& _sequence,
+									uint32& _length) const;
+
+			uint32				SackedBytes() const;
+			void				Dump() const;
+
+private:
+	struct block {
+		tcp_sequence	left;
+		tcp_sequence	right;
+	};
+
+			void				_Insert(tcp_sequence left, tcp_sequence right);
+			bool				_IsLost(int32 hole, uint32 maxSegmentSize)
+									const;
+
+	enum {
+		kMaxBlocks = 32,
+		kDuplicateThreshold = 3
+	};
+
+			block				fBlocks[kMaxBlocks];
+			int32				fCount;
+};
+
+
+#endif	// SACK_SCOREBOARD_H
@@ -0,0 +1,352 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "SynCache.h"
+
+#include <new>
+
+#include <KernelExport.h>
+
+#include <util/AutoLock.h>
+#include <util/Random.h>
+
+#include "EndpointManager.h"
+
+
+//#define TRACE_SYN_CACHE
+#ifdef TRACE_SYN_CACHE
+#	define TRACE(x) dprintf x
+#else
+#	define TRACE(x)
+#endif
+
+
+static const int32 kMaxSynCacheEntries = 1024;
+static const bigtime_t kSynCacheTick = 500000;
+	// how often the cache looks for SYN+ACKs to retransmit
+static const bigtime_t kSynRetransmitTimeout = 1000000;
+static const uint8 kMaxSynRetransmits = 3;
+	// the entry is dropped 15 seconds after the SYN arrived
+
+static const bigtime_t kCookieCounterPeriod = 64000000LL;
+	// a cookie is valid for one to two periods
+static const uint16 kCookieMaxSegmentSizes[] = {
+	216, 536, 1200, 1360, 1440, 1460, 4312, 8960
+};
+static const uint32 kCookieMaxSegmentSizeCount
+	= sizeof(kCookieMaxSegmentSizes) / sizeof(kCookieMaxSegmentSizes[0]);
+
+
+static inline uint32
+mix_hash(uint32 hash)
+{
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6b;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+
+//	#pragma mark -
+
+
+SynCache::SynCache(EndpointManager* manager)
+	:
+	fManager(manager),
+	fTable(manager->AddressModule()),
+	fCookieSecret(secure_get_random<uint32>()),
+	fLastCookieSent(0)
+{
+	mutex_init(&fLock, "tcp syn cache");
+	gStackModule->init_timer(&fTimer, &SynCache::_RetransmitTimer, this);
+}
+
+
+SynCache::~SynCache()
+{
+	gStackModule->cancel_timer(&fTimer);
+	gStackModule->wait_for_timer(&fTimer);
+
+	mutex_lock(&fLock);
+
+	while (syn_cache_entry* entry = fList.RemoveHead())
+		delete entry;
+
+	mutex_destroy(&fLock);
+}
+
+
+status_t
+SynCache::Init()
+{
+	return fTable.Init();
+}
+
+
+/*!	Remembers the connection request described by \a _entry, and answers it.
+	The initial send sequence is chosen here.
+*/
+status_t
+SynCache::Add(const syn_cache_entry& _entry)
+{
+	MutexLocker locker(fLock);
+
+	syn_cache_entry* entry = fTable.Lookup(std::make_pair(
+		(const sockaddr*)&_entry.local, (const sockaddr*)&_entry.peer));
+	if (entry != NULL) {
+		if (entry->initial_receive_sequence
+				== _entry.initial_receive_sequence) {
+			// the peer did not receive our SYN+ACK
+			entry->received_timestamp = _entry.received_timestamp;
+			return _SendSynchronizeAcknowledge(*entry);
+		}
+
+		// this is a new attempt to connect, forget the old one
+		_Remove(entry);
+	}
+
+	if ((int32)fTable.CountElements() >= kMaxSynCacheEntries)
+		return _SendCookie(_entry);
+
+	entry = new(std::nothrow) syn_cache_entry(_entry);
+	if (entry == NULL)
+		return _SendCookie(_entry);
+
+	entry->initial_send_sequence = system_time() >> 4;
+	entry->retransmits = 0;
+	entry->next_retransmit = system_time() + kSynRetransmitTimeout;
+
+	fTable.Insert(entry);
+	fList.Add(entry);
+
+	if (!gStackModule->is_timer_active(&fTimer))
+		gStackModule->set_timer(&fTimer, kSynCacheTick);
+
+	TRACE(("SynCache::Add(): %p, %" B_PRIu32 " entries\n", entry,
+		(uint32)fTable.CountElements()));
+
+	return _SendSynchronizeAcknowledge(*entry);
+}
+
+
+/*!	Checks whether \a segment completes a handshake, and if so, copies
+	everything known about the connection into \a entry.
+	The entry stays in the cache until Remove() is called, so that the
+	handshake can still be completed if creating the endpoint fails.
+*/
+bool
+SynCache::Lookup(const sockaddr* local, const sockaddr* peer,
+	const tcp_segment_header& segment, syn_cache_entry& entry)
+{
+	MutexLocker locker(fLock);
+
+	syn_cache_entry* cached = fTable.Lookup(std::make_pair(local, peer));
+	if (cached == NULL)
+		return _CheckCookie(local, peer, segment, entry);
+
+	if (tcp_sequence(segment.acknowledge)
+			!= cached->initial_send_sequence + 1) {
+		return false;
+	}
+
+	entry = *cached;
+	return true;
+}
+
+
+void
+SynCache::Remove(const sockaddr* local, const sockaddr* peer)
+{
+	MutexLocker locker(fLock);
+
+	syn_cache_entry* entry = fTable.Lookup(std::make_pair(local, peer));
+	if (entry != NULL)
+		_Remove(entry);
+}
+
+
+void
+SynCache::Dump() const
+{
+	kprintf("SYN cache: %" B_PRIu32 " half-open connections",
+		(uint32)fTable.CountElements());
+	if (fLastCookieSent != 0) {
+		kprintf(", last cookie sent %" B_PRIdBIGTIME " usecs ago",
+			system_time() - fLastCookieSent);
+	}
+	kprintf("\n");
+}
+
+
+void
+SynCache::_Remove(syn_cache_entry* entry)
+{
+	fTable.RemoveUnchecked(entry);
+	fList.Remove(entry);
+	delete entry;
+}
+
+
+status_t
+SynCache::_SendSynchronizeAcknowledge(const syn_cache_entry& entry)
+{
+	net_buffer* buffer = gBufferModule->create(256);
+	if (buffer == NULL)
+		return B_NO_MEMORY;
+
+	net_address_module_info* addressModule = fManager->AddressModule();
+	addressModule->set_to(buffer->source, (const sockaddr*)&entry.local);
+	addressModule->set_to(buffer->destination, (const sockaddr*)&entry.peer);
+
+	tcp_segment_header segment(TCP_FLAG_SYNCHRONIZE | TCP_FLAG_ACKNOWLEDGE);
+	segment.sequence = entry.initial_send_sequence.Number();
+	segment.acknowledge = (entry.initial_receive_sequence + 1).Number();
+	segment.advertised_window = min_c(entry.receive_window, TCP_MAX_WINDOW);
+		// the window in a SYN is never scaled
+	segment.urgent_offset = 0;
+	segment.max_segment_size = entry.receive_max_segment_size;
+
+	if ((entry.options & TCP_HAS_WINDOW_SCALE) != 0) {
+		segment.options |= TCP_HAS_WINDOW_SCALE;
+		segment.window_shift = entry.receive_window_shift;
+	}
+	if ((entry.options & TCP_SACK_PERMITTED) != 0)
+		segment.options |= TCP_SACK_PERMITTED;
+	if ((entry.options & TCP_HAS_TIMESTAMPS) != 0) {
+		segment.options |= TCP_HAS_TIMESTAMPS;
+		segment.timestamp_value = tcp_now();
+		segment.timestamp_reply = entry.received_timestamp;
+	}
+
+	return fManager->SendReply(segment, buffer);
+}
+
+
+/*!	Computes the part of a SYN cookie that proves we sent it. This is not a
+	cryptographic hash, but the secret is chosen randomly on every boot, and
+	a cookie is only valid for a limited time.
+*/
+uint32
+SynCache::_CookieHash(const sockaddr* local, const sockaddr* peer,
+	tcp_sequence initialReceiveSequence, uint32 counter) const
+{
+	uint32 hash = fManager->AddressModule()->hash_address_pair(local, peer);
+	hash = mix_hash(hash ^ fCookieSecret);
+	hash = mix_hash(hash ^ initialReceiveSequence.Number());
+	return mix_hash(hash ^ counter ^ fCookieSecret);
+}
+
+
+/*!	Answers the SYN without keeping any state. The initial send sequence
+	consists of a 5 bit counter, the index of the maximum segment size of the
+	peer, and 24 bits of a hash over the connection and the counter.
+	Since the other options cannot be restored later, they are not offered.
+*/
+status_t
+SynCache::_SendCookie(const syn_cache_entry& entry)
+{
+	uint16 maxSegmentSize = entry.max_segment_size != 0
+		? entry.max_segment_size : TCP_DEFAULT_MAX_SEGMENT_SIZE;
+
+	uint32 index = 0;
+	for (uint32 i = kCookieMaxSegmentSizeCount; i-- > 0;) {
+		if (kCookieMaxSegmentSizes[i] <= maxSegmentSize) {
+			index = i;
+			break;
+		}
+	}
+
+	bigtime_t now = system_time();
+	uint32 counter = now / kCookieCounterPeriod;
+
+	syn_cache_entry cookie = entry;
+	cookie.initial_send_sequence = ((counter & 0x1f) << 27) | (index << 24)
+		| (_CookieHash((const sockaddr*)&entry.local,
+			(const sockaddr*)&entry.peer, entry.initial_receive_sequence,
+			counter) & 0xffffff);
+	cookie.options = 0;
+
+	fLastCookieSent = now;
+
+	TRACE(("SynCache: sending cookie %" B_PRIu32 "\n",
+		cookie.initial_send_sequence.Number()));
+
+	return _SendSynchronizeAcknowledge(cookie);
+}
+
+
+bool
+SynCache::_CheckCookie(const sockaddr* local, const sockaddr* peer,
+	const tcp_segment_header& segment, syn_cache_entry& entry)
+{
+	// Only accept cookies if we actually handed some out recently
+	bigtime_t now = system_time();
+	if (fLastCookieSent == 0
+		|| now - fLastCookieSent > 2 * kCookieCounterPeriod) {
+		return false;
+	}
+
+	uint32 cookie = segment.acknowledge - 1;
+	tcp_sequence initialReceiveSequence = segment.sequence - 1;
+
+	uint32 currentCounter = now / kCookieCounterPeriod;
+	uint32 age = (currentCounter - (cookie >> 27)) & 0x1f;
+	if (age > 1)
+		return false;
+
+	if ((_CookieHash(local, peer, initialReceiveSequence, currentCounter - age)
+			& 0xffffff) != (cookie & 0xffffff)) {
+		return false;
+	}
+
+	uint32 index = (cookie >> 24) & 0x7;
+
+	entry = syn_cache_entry();
+	fManager->AddressModule()->set_to((sockaddr*)&entry.local, local);
+	fManager->AddressModule()->set_to((sockaddr*)&entry.peer, peer);
+	entry.initial_send_sequence = cookie;
+	entry.initial_receive_sequence = initialReceiveSequence;
+	entry.max_segment_size = kCookieMaxSegmentSizes[index];
+	entry.advertised_window = segment.advertised_window;
+
+	TRACE(("SynCache: accepted cookie %" B_PRIu32 "\n", cookie));
+	return true;
+}
+
+
+/*static*/ void
+SynCache::_RetransmitTimer(net_timer* timer, void* _cache)
+{
+	SynCache* cache = (SynCache*)_cache;
+
+	MutexLocker locker(cache->fLock);
+
+	bigtime_t now = system_time();
+
+	EntryList::Iterator iterator = cache->fList.GetIterator();
+	while (syn_cache_entry* entry = iterator.Next()) {
+		if (entry->next_retransmit > now)
+			continue;
+
+		if (entry->retransmits >= kMaxSynRetransmits) {
+			// the peer never completed the handshake
+			iterator.Remove();
+			cache->fTable.RemoveUnchecked(entry);
+			delete entry;
+			continue;
+		}
+
+		entry->retransmits++;
+		entry->next_retransmit = now
+			+ (kSynRetransmitTimeout << entry->retransmits);
+		cache->_SendSynchronizeAcknowledge(*entry);
+	}
+
+	if (!cache->fList.IsEmpty())
+		gStackModule->set_timer(&cache->fTimer, kSynCacheTick);
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef SYN_CACHE_H
+#define SYN_CACHE_H
+
+
+#include "tcp.h"
+
+#include <net_datalink.h>
+
+#include <lock.h>
+#include <util/DoublyLinkedList.h>
+#include <util/OpenHashTable.h>
+
+#include <utility>
+
+
+class EndpointManager;
+
+
+/*!	Hash definition for the compact connection records that are kept instead
+	of a full endpoint; \c Entry must have \c local, \c peer, and \c hash_link
+	members.
+*/
+template<typename Entry>
+class AddressPairHashDefinition {
+public:
+	typedef std::pair<const sockaddr*, const sockaddr*> KeyType;
+	typedef Entry ValueType;
+
+	AddressPairHashDefinition(net_address_module_info* module)
+		:
+		fModule(module)
+	{
+	}
+
+	AddressPairHashDefinition(const AddressPairHashDefinition& definition)
+		:
+		fModule(definition.fModule)
+	{
+	}
+
+	size_t HashKey(const KeyType& key) const
+	{
+		return fModule->hash_address_pair(key.first, key.second);
+	}
+
+	size_t Hash(Entry* entry) const
+	{
+		return fModule->hash_address_pair((const sockaddr*)&entry->local,
+			(const sockaddr*)&entry->peer);
+	}
+
+	bool Compare(const KeyType& key, Entry* entry) const
+	{
+		return fModule->equal_addresses_and_ports(
+				(const sockaddr*)&entry->local, key.first)
+			&& fModule->equal_addresses_and_ports(
+				(const sockaddr*)&entry->peer, key.second);
+	}
+
+	Entry*& GetLink(Entry* entry) const
+	{
+		return entry->hash_link;
+	}
+
+private:
+	net_address_module_info* fModule;
+};
+
+
+/*!	Everything needed to answer a SYN, and to create the endpoint once the
+	handshake completes.
+*/
+struct syn_cache_entry : DoublyLinkedListLinkImpl<syn_cache_entry> {
+	sockaddr_storage	local;
+	sockaddr_storage	peer;
+	syn_cache_entry*	hash_link;
+
+	// what we announced in our SYN+ACK
+	tcp_sequence		initial_send_sequence;
+	uint32				receive_window;
+	uint16				receive_max_segment_size;
+	uint8				receive_window_shift;
+
+	// what the peer announced in its SYN
+	tcp_sequence		initial_receive_sequence;
+	uint32				received_timestamp;
+	uint16				max_segment_size;
+	uint16				advertised_window;
+	uint8				window_shift;
+	uint8				options;
+
+	bigtime_t			next_retransmit;
+	uint8				retransmits;
+};
+
+
+/*!	Keeps track of half-open connections to listening sockets, so that a
+	socket and an endpoint only need to be created once the peer completed
+	the three-way handshake.
+	When the cache is full, SYN cookies are used instead: the initial send
+	sequence then encodes enough to validate the final ACK without any state.
+*/
+class SynCache {
+public:
+								SynCache(EndpointManager* manager);
+								~SynCache();
+
+			status_t			Init();
+
+			status_t			Add(const syn_cache_entry& entry);
+			bool				Lookup(const sockaddr* local,
+									const sockaddr* peer,
+									const tcp_segment_header& segment,
+									syn_cache_entry& entry);
+			void				Remove(const sockaddr* local,
+									const sockaddr* peer);
+
+			void				Dump() const;
+
+private:
+	typedef AddressPairHashDefinition<syn_cache_entry> HashDefinition;
+	typedef BOpenHashTable<HashDefinition> EntryTable;
+	typedef DoublyLinkedList<syn_cache_entry> EntryList;
+
+			void				_Remove(syn_cache_entry* entry);
+			status_t			_SendSynchronizeAcknowledge(
+									const syn_cache_entry& entry);
+
+			uint32				_CookieHash(const sockaddr* local,
+									const sockaddr* peer,
+									tcp_sequence initialReceiveSequence,
+									uint32 counter) const;
+			status_t			_SendCookie(const syn_cache_entry& entry);
+			bool				_CheckCookie(const sockaddr* local,
+									const sockaddr* peer,
+									const tcp_segment_header& segment,
+									syn_cache_entry& entry);
+
+	static	void				_RetransmitTimer(net_timer* timer,
+									void* _cache);
+
+			EndpointManager*	fManager;
+			mutex				fLock;
+			EntryTable			fTable;
+			EntryList			fList;
+			net_timer			fTimer;
+			uint32				fCookieSecret;
+			bigtime_t			fLastCookieSent;
+};
+
+
+#endif	// SYN_CACHE_H
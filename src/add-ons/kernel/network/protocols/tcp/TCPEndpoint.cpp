@@ -25,6 +25,7 @@
 
 #include <net_buffer.h>
 #include <net_datalink.h>
+#include <net_device.h>
 #include <net_stat.h>
 #include <NetBufferUtilities.h>
 #include <NetUtilities.h>
@@ -42,19 +43,20 @@
 //	- RFC 793 - Transmission Control Protocol
 //	- RFC 813 - Window and Acknowledgement Strategy in TCP
 //	- RFC 1337 - TIME_WAIT Assassination Hazards in TCP
+//	- RFC 5681 - TCP Congestion Control
+//	- RFC 6582 - The NewReno Modification to TCP's Fast Recovery Algorithm
+//	- RFC 6675 - A Conservative Loss Recovery Algorithm Based on Selective
+//	  Acknowledgment (SACK) for TCP
+//	- RFC 9438 - CUBIC for Fast and Long-Distance Networks
 //
 // Things incomplete in this implementation:
 //	- TCP Extensions for High Performance, RFC 1323 - RTTM, PAWS
-//	- Congestion Control, RFC 5681
 //	- Limited Transit, RFC 3042
-//	- SACK, Selective Acknowledgment; RFC 2018, RFC 2883, RFC 6675
-//	- NewReno Modification to TCP's Fast Recovery, RFC 2582
+//	- SACK, Selective Acknowledgment; RFC 2883 (D-SACKs are ignored)
 //
 // Things this implementation currently doesn't implement:
 //	- Explicit Congestion Notification (ECN), RFC 3168
-//	- SYN-Cache
 //	- Forward RTO-Recovery, RFC 4138
-//	- Time-Wait hash instead of keeping sockets alive
 
 #define PrintAddress(address) \
 	AddressString(Domain(), address, true).Data()
@@ -323,11 +325,13 @@ enum {
 	FLAG_RECOVERY				= 0x40,
 	FLAG_OPTION_SACK_PERMITTED	= 0x80,
 	FLAG_AUTO_RECEIVE_BUFFER_SIZE = 0x100,
+	FLAG_SACK_RECOVERY			= 0x200,
 };
 
 
-static const int kTimestampFactor = 1000;
-	// conversion factor between usec system time and msec tcp time
+static const uint32 kMaxSegmentationOffloadSize = 0xffff - 2 * 60;
+	// the payload of a buffer the device segments has to leave room for
+	// the largest IP and TCP headers
 
 
 static inline bigtime_t
@@ -390,13 +394,6 @@ is_establishing(tcp_state state)
 }
 
 
-static inline uint32
-tcp_now()
-{
-	return system_time() / kTimestampFactor;
-}
-
-
 static inline uint32
 tcp_diff_timestamp(uint32 base)
 {
@@ -422,6 +419,7 @@ state_needs_finish(int32 state)
 TCPEndpoint::TCPEndpoint(net_socket* socket)
 	:
 	ProtocolSocket(socket),
+	fReusePortGroup(NULL),
 	fManager(NULL),
 	fOptions(0),
 	fSendWindowShift(0),
@@ -454,6 +452,9 @@ TCPEndpoint::TCPEndpoint(net_socket* socket)
 	fReceivedTimestamp(0),
 	fCongestionWindow(0),
 	fSlowStartThreshold(0),
+	fCongestionControl(create_congestion_control(
+		TCP_DEFAULT_CONGESTION_CONTROL)),
+	fHighRetransmitted(0),
 	fState(CLOSED),
 	fFlags(FLAG_OPTION_WINDOW_SCALE | FLAG_OPTION_TIMESTAMP
 		| FLAG_OPTION_SACK_PERMITTED | FLAG_AUTO_RECEIVE_BUFFER_SIZE)
@@ -500,13 +501,14 @@ TCPEndpoint::~TCPEndpoint()
 	gStackModule->wait_for_timer(&fTimeWaitTimer);
 
 	gDatalinkModule->put_route(Domain(), fRoute);
+	delete fCongestionControl;
 }
 
 
 status_t
 TCPEndpoint::InitCheck() const
 {
-	return B_OK;
+	return fCongestionControl != NULL ? B_OK : B_NO_MEMORY;
 }
 
 
@@ -1085,6 +1087,19 @@ TCPEndpoint::SetReceiveBufferSize(size_t length)
 status_t
 TCPEndpoint::GetOption(int option, void* _value, int* _length)
 {
+	if (option == TCP_CONGESTION) {
+		MutexLocker _(fLock);
+
+		const char* name = fCongestionControl->Name();
+		int length = strlen(name) + 1;
+		if (*_length < length)
+			return B_BAD_VALUE;
+
+		memcpy(_value, name, length);
+		*_length = length;
+		return B_OK;
+	}
+
 	if (*_length != sizeof(int))
 		return B_BAD_VALUE;
 
@@ -1111,6 +1126,20 @@ TCPEndpoint::GetOption(int option, void* _value, int* _length)
 status_t
 TCPEndpoint::SetOption(int option, const void* _value, int length)
 {
+	if (option == TCP_CONGESTION) {
+		if (length <= 0)
+			return B_BAD_VALUE;
+
+		// The value does not need to be null terminated
+		char name[TCP_CA_NAME_MAX];
+		size_t nameLength = min_c((size_t)length, sizeof(name) - 1);
+		memcpy(name, _value, nameLength);
+		name[nameLength] = '\0';
+
+		MutexLocker _(fLock);
+		return _SetCongestionControl(name);
+	}
+
 	if (option != TCP_NODELAY)
 		return B_BAD_VALUE;
 
@@ -1180,13 +1209,41 @@ TCPEndpoint::_EnterTimeWait()
 {
 	TRACE("_EnterTimeWait()");
 
-	if (fState == TIME_WAIT)
+	if (fState == TIME_WAIT) {
 		_CancelConnectionTimers();
 
+		if ((fFlags & FLAG_CLOSED) != 0 && _HandOverTimeWait()) {
+			// the endpoint manager takes care of the connection from now on,
+			// we can go away right now
+			gStackModule->set_timer(&fTimeWaitTimer, 0);
+			T(TimerSet(this, "time-wait", 0));
+			return;
+		}
+	}
+
 	_UpdateTimeWait();
 }
 
 
+/*!	Passes the remaining time-wait duty to the endpoint manager, so that
+	the socket does not need to be kept around until the 2MSL timeout.
+	This is only possible once the socket has been closed.
+*/
+bool
+TCPEndpoint::_HandOverTimeWait()
+{
+	time_wait_entry entry;
+	AddressModule()->set_to((sockaddr*)&entry.local, *LocalAddress());
+	AddressModule()->set_to((sockaddr*)&entry.peer, *PeerAddress());
+	entry.send_next = fSendMax;
+	entry.receive_next = fReceiveNext;
+	entry.received_timestamp = fReceivedTimestamp;
+	entry.timestamps = (fFlags & FLAG_OPTION_TIMESTAMP) != 0;
+
+	return fManager->EnterTimeWait(entry) == B_OK;
+}
+
+
 void
 TCPEndpoint::_UpdateTimeWait()
 {
@@ -1309,7 +1366,25 @@ TCPEndpoint::_DuplicateAcknowledge(tcp_segment_header &segment)
 	if (fDuplicateAcknowledgeCount == 0)
 		fPreviousFlightSize = (fSendMax - fSendUnacknowledged).Number();
 
-	if (++fDuplicateAcknowledgeCount < 3) {
+	fDuplicateAcknowledgeCount++;
+
+	if ((fFlags & FLAG_SACK_RECOVERY) != 0) {
+		// every ACK may allow us to send more during recovery
+		_SendRecovery();
+		return;
+	}
+
+	if ((fFlags & FLAG_RECOVERY) == 0
+		&& (fDuplicateAcknowledgeCount >= 3
+			|| fScoreboard.IsLost(fSendUnacknowledged, fSendMaxSegmentSize))) {
+		if ((segment.acknowledge - 1) > fRecover || (fCongestionWindow > fSendMaxSegmentSize &&
+			(fSendUnacknowledged - fPreviousHighestAcknowledge) <= 4 * fSendMaxSegmentSize)) {
+			_EnterRecovery(segment);
+			return;
+		}
+	}
+
+	if (fDuplicateAcknowledgeCount < 3) {
 		if (fSendQueue.Available(fSendMax) != 0 && fSendWindow != 0) {
 			fSendNext = fSendMax;
 			fCongestionWindow += fDuplicateAcknowledgeCount * fSendMaxSegmentSize;
@@ -1317,19 +1392,6 @@ TCPEndpoint::_DuplicateAcknowledge(tcp_segment_header &segment)
 			TRACE("_DuplicateAcknowledge(): packet sent under limited transmit on receipt of dup ack");
 			fCongestionWindow -= fDuplicateAcknowledgeCount * fSendMaxSegmentSize;
 		}
-	}
-
-	if (fDuplicateAcknowledgeCount == 3) {
-		if ((segment.acknowledge - 1) > fRecover || (fCongestionWindow > fSendMaxSegmentSize &&
-			(fSendUnacknowledged - fPreviousHighestAcknowledge) <= 4 * fSendMaxSegmentSize)) {
-			fFlags |= FLAG_RECOVERY;
-			fRecover = fSendMax.Number() - 1;
-			fSlowStartThreshold = max_c(fPreviousFlightSize / 2, 2 * fSendMaxSegmentSize);
-			fCongestionWindow = fSlowStartThreshold + 3 * fSendMaxSegmentSize;
-			fSendNext = segment.acknowledge;
-			_SendQueued();
-			TRACE("_DuplicateAcknowledge(): packet sent under fast restransmit on the receipt of 3rd dup ack");
-		}
 	} else if (fDuplicateAcknowledgeCount > 3) {
 		uint32 flightSize = (fSendMax - fSendUnacknowledged).Number();
 		if ((fDuplicateAcknowledgeCount - 3) * fSendMaxSegmentSize <= flightSize)
@@ -1342,6 +1404,94 @@ TCPEndpoint::_DuplicateAcknowledge(tcp_segment_header &segment)
 }
 
 
+/*!	Starts fast retransmit and fast recovery. If the peer told us what it
+	received, the scoreboard decides what to retransmit (RFC 6675), otherwise
+	the window is inflated for every duplicate acknowledgement (RFC 6582).
+*/
+void
+TCPEndpoint::_EnterRecovery(tcp_segment_header& segment)
+{
+	fFlags |= FLAG_RECOVERY;
+	fRecover = fSendMax.Number() - 1;
+	fSlowStartThreshold = fCongestionControl->LossDetected(fCongestionWindow,
+		fPreviousFlightSize, fSendMaxSegmentSize, false);
+
+	if ((fFlags & FLAG_OPTION_SACK_PERMITTED) == 0 || fScoreboard.IsEmpty()) {
+		fCongestionWindow = fSlowStartThreshold + 3 * fSendMaxSegmentSize;
+		fSendNext = segment.acknowledge;
+		_SendQueued();
+		TRACE("_EnterRecovery(): packet sent under fast restransmit on the receipt of 3rd dup ack");
+		return;
+	}
+
+	fFlags |= FLAG_SACK_RECOVERY;
+	fCongestionWindow = fSlowStartThreshold;
+	fSendNext = fSendMax;
+
+	// the first segment is retransmitted regardless of the window
+	tcp_sequence sequence = fSendUnacknowledged;
+	uint32 length = fSendMaxSegmentSize;
+	fScoreboard.NextSegment(fSendUnacknowledged, fSendMax, fSendUnacknowledged,
+		fSendMaxSegmentSize, false, sequence, length);
+
+	fHighRetransmitted = fSendUnacknowledged;
+	if (_SendSegment(sequence, length, true) == B_OK)
+		fHighRetransmitted = sequence + length;
+
+	TRACE("_EnterRecovery(): retransmitted %" B_PRIu32 " bytes at %" B_PRIu32,
+		length, sequence.Number());
+
+	_SendRecovery();
+}
+
+
+/*!	Sends as much as the congestion window allows during SACK based loss
+	recovery: first the segments considered lost, then new data, and then
+	anything else the peer has not acknowledged yet (RFC 6675, section 5).
+*/
+void
+TCPEndpoint::_SendRecovery()
+{
+	if (fHighRetransmitted < fSendUnacknowledged)
+		fHighRetransmitted = fSendUnacknowledged;
+
+	while (true) {
+		uint32 pipe = fScoreboard.Pipe(fSendUnacknowledged, fSendMax,
+			fHighRetransmitted, fSendMaxSegmentSize);
+		if (pipe + fSendMaxSegmentSize > fCongestionWindow)
+			break;
+
+		tcp_sequence sequence;
+		uint32 length;
+		bool retransmit = fScoreboard.NextSegment(fSendUnacknowledged,
+			fSendMax, fHighRetransmitted, fSendMaxSegmentSize, true, sequence,
+			length);
+
+		if (!retransmit) {
+			uint32 window = 0;
+			if (fSendUnacknowledged + fSendWindow > fSendMax)
+				window = (fSendUnacknowledged + fSendWindow - fSendMax).Number();
+
+			sequence = fSendMax;
+			length = min_c(fSendQueue.Available(fSendMax), window);
+			if (length == 0) {
+				retransmit = fScoreboard.NextSegment(fSendUnacknowledged,
+					fSendMax, fHighRetransmitted, fSendMaxSegmentSize, false,
+					sequence, length);
+				if (!retransmit)
+					break;
+			}
+		}
+
+		if (_SendSegment(sequence, length, retransmit) != B_OK || length == 0)
+			break;
+
+		if (retransmit)
+			fHighRetransmitted = sequence + length;
+	}
+}
+
+
 void
 TCPEndpoint::_UpdateTimestamps(tcp_segment_header& segment,
 	size_t segmentLength)
@@ -1543,9 +1693,13 @@ TCPEndpoint::_ShouldReceive() const
 }
 
 
+/*!	Creates the endpoint for a connection whose handshake was completed by
+	\a segment. The SYN of the peer, and our answer to it were handled by
+	the SYN cache, and are described by \a entry.
+*/
 int32
-TCPEndpoint::_Spawn(TCPEndpoint* parent, tcp_segment_header& segment,
-	net_buffer* buffer)
+TCPEndpoint::_Spawn(TCPEndpoint* parent, const syn_cache_entry& entry,
+	tcp_segment_header& segment, net_buffer* buffer)
 {
 	MutexLocker _(fLock);
 
@@ -1574,18 +1728,46 @@ TCPEndpoint::_Spawn(TCPEndpoint* parent, tcp_segment_header& segment,
 	fOptions = parent->fOptions;
 	fAcceptSemaphore = parent->fAcceptSemaphore;
 
-	_PrepareReceivePath(segment);
-
-	// send SYN+ACK
-	if (_SendAcknowledge() != B_OK) {
-		T(Error(this, "sending failed", __LINE__));
+	if (_SetCongestionControl(parent->fCongestionControl->Name()) != B_OK) {
+		T(Error(this, "creating congestion control failed", __LINE__));
 		return DROP;
 	}
 
-	segment.flags &= ~TCP_FLAG_SYNCHRONIZE;
-		// we handled this flag now, it must not be set for further processing
+	// our SYN has already been sent
+	fInitialSendSequence = entry.initial_send_sequence;
+	fSendUnacknowledged = fInitialSendSequence;
+	fSendNext = fInitialSendSequence + 1;
+	fSendMax = fSendNext;
+	fSendUrgentOffset = fInitialSendSequence;
+	fRecover = fInitialSendSequence.Number();
+	fSendQueue.SetInitialSequence(fSendNext);
+	fReceiveWindowShift = entry.receive_window_shift;
+
+	// replay the SYN of the peer
+	tcp_segment_header synchronize(TCP_FLAG_SYNCHRONIZE);
+	synchronize.sequence = entry.initial_receive_sequence.Number();
+	synchronize.advertised_window = entry.advertised_window;
+	synchronize.max_segment_size = entry.max_segment_size;
+	synchronize.window_shift = entry.window_shift;
+	synchronize.timestamp_value = entry.received_timestamp;
+	synchronize.options = entry.options;
+	_PrepareReceivePath(synchronize);
+
+	fLastAcknowledgeSent = fReceiveNext;
+	fReceiveMaxAdvertised = fReceiveNext
+		+ min_c(socket->receive.buffer_size, TCP_MAX_WINDOW);
+
+	int32 action = _Receive(segment, buffer);
+
+	// the caller only knows about the listening endpoint
+	if ((action & IMMEDIATE_ACKNOWLEDGE) != 0)
+		_SendAcknowledge(true);
+	else if ((action & ACKNOWLEDGE) != 0)
+		DelayedAcknowledge();
+	if ((action & SEND_QUEUED) != 0)
+		_SendQueued();
 
-	return _Receive(segment, buffer);
+	return action & ~(IMMEDIATE_ACKNOWLEDGE | ACKNOWLEDGE | SEND_QUEUED);
 }
 
 
@@ -1596,23 +1778,77 @@ TCPEndpoint::_ListenReceive(tcp_segment_header& segment, net_buffer* buffer)
 
 	// Essentially, we accept only TCP_FLAG_SYNCHRONIZE in this state,
 	// but the error behaviour differs
-	if (segment.flags & TCP_FLAG_RESET)
+	if (segment.flags & TCP_FLAG_RESET) {
+		// the peer might have given up on a half-open connection
+		fManager->GetSynCache().Remove(buffer->destination, buffer->source);
 		return DROP;
-	if (segment.flags & TCP_FLAG_ACKNOWLEDGE)
-		return DROP | RESET;
+	}
+	if (segment.flags & TCP_FLAG_ACKNOWLEDGE) {
+		if ((segment.flags & TCP_FLAG_SYNCHRONIZE) != 0)
+			return DROP | RESET;
+
+		return _CompleteHandshake(segment, buffer);
+	}
 	if ((segment.flags & TCP_FLAG_SYNCHRONIZE) == 0)
 		return DROP;
 
 	// TODO: drop broadcast/multicast
 
+	// Only remember the connection request for now, the endpoint is created
+	// when the peer acknowledges our SYN
+	bool local = AddressModule()->equal_addresses(buffer->source,
+		buffer->destination);
+
+	syn_cache_entry entry;
+	AddressModule()->set_to((sockaddr*)&entry.local, buffer->destination);
+	AddressModule()->set_to((sockaddr*)&entry.peer, buffer->source);
+	entry.receive_window = socket->receive.buffer_size;
+	entry.receive_max_segment_size = 0;
+	entry.receive_window_shift = _ReceiveWindowShift(local);
+	entry.initial_receive_sequence = segment.sequence;
+	entry.received_timestamp = segment.timestamp_value;
+	entry.max_segment_size = 0;
+	entry.advertised_window = segment.advertised_window;
+	entry.window_shift = segment.window_shift;
+	entry.options = 0;
+
+	if ((fOptions & TCP_NOOPT) == 0) {
+		entry.receive_max_segment_size = _MaxSegmentSize(buffer->source);
+		entry.max_segment_size = segment.max_segment_size;
+		entry.options = segment.options
+			& (TCP_HAS_WINDOW_SCALE | TCP_HAS_TIMESTAMPS | TCP_SACK_PERMITTED);
+	}
+
+	fManager->GetSynCache().Add(entry);
+	return DROP;
+}
+
+
+/*!	Called for an ACK to a listening endpoint: if it finishes a handshake
+	the SYN cache knows about, the endpoint for accept() is created.
+*/
+int32
+TCPEndpoint::_CompleteHandshake(tcp_segment_header& segment,
+	net_buffer* buffer)
+{
+	syn_cache_entry entry;
+	if (!fManager->GetSynCache().Lookup(buffer->destination, buffer->source,
+			segment, entry)) {
+		return DROP | RESET;
+	}
+
 	// spawn new endpoint for accept()
 	net_socket* newSocket;
 	if (gSocketModule->spawn_pending_socket(socket, &newSocket) < B_OK) {
+		// the backlog is full; the handshake can still be completed when the
+		// peer retransmits
 		T(Error(this, "spawning failed", __LINE__));
 		return DROP;
 	}
 
-	return ((TCPEndpoint *)newSocket->first_protocol)->_Spawn(this,
+	fManager->GetSynCache().Remove(buffer->destination, buffer->source);
+
+	return ((TCPEndpoint *)newSocket->first_protocol)->_Spawn(this, entry,
 		segment, buffer);
 }
 
@@ -1675,6 +1911,7 @@ TCPEndpoint::_Receive(tcp_segment_header& segment, net_buffer* buffer)
 
 	if (fState == ESTABLISHED
 		&& segment.AcknowledgeOnly()
+		&& (segment.options & TCP_HAS_SACK) == 0
 		&& fReceiveNext == segment.sequence
 		&& advertisedWindow > 0 && advertisedWindow == fSendWindow
 		&& fSendNext == fSendMax) {
@@ -1832,6 +2069,12 @@ TCPEndpoint::_Receive(tcp_segment_header& segment, net_buffer* buffer)
 		if (fSendMax < segment.acknowledge)
 			return DROP | IMMEDIATE_ACKNOWLEDGE;
 
+		if ((fFlags & FLAG_OPTION_SACK_PERMITTED) != 0
+			&& segment.acknowledge >= fSendUnacknowledged) {
+			fScoreboard.Update(segment.acknowledge, fSendMax, segment.sacks,
+				segment.sackCount);
+		}
+
 		if (segment.acknowledge == fSendUnacknowledged) {
 			if (buffer->size == 0 && advertisedWindow == fSendWindow
 				&& (segment.flags & TCP_FLAG_FINISH) == 0 && fSendUnacknowledged != fSendMax) {
@@ -1843,13 +2086,13 @@ TCPEndpoint::_Receive(tcp_segment_header& segment, net_buffer* buffer)
 		} else {
 			// this segment acknowledges in flight data
 
-			if (fDuplicateAcknowledgeCount >= 3) {
+			if ((fFlags & FLAG_RECOVERY) != 0 || fDuplicateAcknowledgeCount >= 3) {
 				// deflate the window.
 				if (segment.acknowledge > fRecover) {
 					uint32 flightSize = (fSendMax - fSendUnacknowledged).Number();
 					fCongestionWindow = min_c(fSlowStartThreshold,
 						max_c(flightSize, fSendMaxSegmentSize) + fSendMaxSegmentSize);
-					fFlags &= ~FLAG_RECOVERY;
+					fFlags &= ~(FLAG_RECOVERY | FLAG_SACK_RECOVERY);
 				}
 			}
 
@@ -2144,6 +2387,17 @@ TCPEndpoint::_PrepareAndSend(tcp_segment_header& segment, net_buffer* buffer,
 
 	PROBE(buffer, sendWindow);
 
+	uint32 segmentCount = 1;
+	if (buffer->segment_size != 0) {
+		segmentCount = (segmentLength + buffer->segment_size - 1)
+			/ buffer->segment_size;
+	}
+
+	if (_DeviceCanOffload(NET_DEVICE_OFFLOAD_CHECKSUM_IPV4,
+			NET_DEVICE_OFFLOAD_CHECKSUM_IPV6)) {
+		buffer->buffer_flags |= NET_BUFFER_L4_CHECKSUM_PARTIAL;
+	}
+
 	status_t status = add_tcp_header(AddressModule(), segment, buffer);
 	if (status != B_OK) {
 		gBufferModule->free(buffer);
@@ -2172,7 +2426,7 @@ TCPEndpoint::_PrepareAndSend(tcp_segment_header& segment, net_buffer* buffer,
 	fReceiveMaxAdvertised = fReceiveNext + segment.AdvertisedWindow(fReceiveWindowShift);
 
 	if (segmentLength != 0 && fState == ESTABLISHED)
-		--fSendMaxSegments;
+		fSendMaxSegments -= segmentCount;
 
 	if (fSendTime == 0 && !isRetransmit
 			&& (segmentLength != 0 || (segment.flags & TCP_FLAG_SYNCHRONIZE) != 0)) {
@@ -2203,7 +2457,7 @@ TCPEndpoint::_ShouldSendSegment(tcp_segment_header& segment, uint32 length,
 		// - the buffer is at least larger than half of the maximum send window,
 		//   or
 		// - we're retransmitting data
-		if (length == segmentMaxSize
+		if (length >= segmentMaxSize
 			|| (fOptions & TCP_NODELAY) != 0
 			|| tcp_sequence(fSendNext + length) == fSendQueue.LastSequence()
 			|| (fSendMaxWindow > 0 && length >= fSendMaxWindow / 2))
@@ -2311,10 +2565,23 @@ TCPEndpoint::_SendQueued(bool force)
 		length = min_c(length, fSendMaxSegmentSize);
 	}
 
+	// Let the device split up new data into segments if it can; this is
+	// not worth it for retransmissions, as they only send one segment.
+	bool segmentationOffload = !retransmit && fDuplicateAcknowledgeCount == 0
+		&& _DeviceCanOffload(NET_DEVICE_OFFLOAD_TSO_IPV4,
+			NET_DEVICE_OFFLOAD_TSO_IPV6);
+
 	do {
 		uint32 segmentMaxSize = fSendMaxSegmentSize
 			- tcp_options_length(segment);
-		uint32 segmentLength = min_c(length, segmentMaxSize);
+		uint32 bufferMaxSize = segmentMaxSize;
+		if (segmentationOffload) {
+			uint32 segments = kMaxSegmentationOffloadSize / segmentMaxSize;
+			if (fState == ESTABLISHED && fSendMaxSegments < segments)
+				segments = max_c(fSendMaxSegments, 1);
+			bufferMaxSize *= segments;
+		}
+		uint32 segmentLength = min_c(length, bufferMaxSize);
 
 		if ((fSendNext + segmentLength) == fSendQueue.LastSequence() && !force) {
 			if (state_needs_finish(fState))
@@ -2344,6 +2611,8 @@ TCPEndpoint::_SendQueued(bool force)
 			gBufferModule->free(buffer);
 			return status;
 		}
+		if (segmentLength > segmentMaxSize)
+			buffer->segment_size = segmentMaxSize;
 
 		sendWindow -= buffer->size;
 
@@ -2372,6 +2641,58 @@ TCPEndpoint::_SendQueued(bool force)
 }
 
 
+/*!	Sends a single segment with up to \a length bytes of the send queue,
+	starting at \a sequence, independent of the send and congestion windows.
+	This is used during SACK based loss recovery, which decides on its own
+	what may be sent. On return, \a length contains the number of bytes sent.
+*/
+status_t
+TCPEndpoint::_SendSegment(tcp_sequence sequence, uint32& length,
+	bool isRetransmit)
+{
+	tcp_segment_header segment = _PrepareSendSegment();
+
+	uint32 segmentMaxSize = fSendMaxSegmentSize - tcp_options_length(segment);
+	length = min_c(length, min_c(segmentMaxSize,
+		fSendQueue.Available(sequence)));
+	if (length == 0)
+		return B_OK;
+
+	if ((sequence + length) == fSendQueue.LastSequence()) {
+		if (state_needs_finish(fState))
+			segment.flags |= TCP_FLAG_FINISH;
+		segment.flags |= TCP_FLAG_PUSH;
+	}
+
+	net_buffer* buffer = gBufferModule->create(256);
+	if (buffer == NULL)
+		return B_NO_MEMORY;
+
+	status_t status = fSendQueue.Get(buffer, sequence, length);
+	if (status != B_OK) {
+		gBufferModule->free(buffer);
+		return status;
+	}
+
+	tcp_sequence sendNext = fSendNext;
+	fSendNext = sequence;
+
+	status = _PrepareAndSend(segment, buffer, isRetransmit);
+
+	if (fSendNext < sendNext)
+		fSendNext = sendNext;
+	if (status != B_OK)
+		return status;
+
+	if (!gStackModule->is_timer_active(&fRetransmitTimer)) {
+		gStackModule->set_timer(&fRetransmitTimer, fRetransmitTimeout);
+		T(TimerSet(this, "retransmit", fRetransmitTimeout));
+	}
+
+	return B_OK;
+}
+
+
 int
 TCPEndpoint::_MaxSegmentSize(const sockaddr* address) const
 {
@@ -2379,6 +2700,21 @@ TCPEndpoint::_MaxSegmentSize(const sockaddr* address) const
 }
 
 
+/*!	Returns whether the device of our route can take over the work given by
+	\a ipv4Offload, or \a ipv6Offload, depending on our address family.
+*/
+bool
+TCPEndpoint::_DeviceCanOffload(uint32 ipv4Offload, uint32 ipv6Offload) const
+{
+	if (fRoute == NULL)
+		return false;
+
+	net_device* device = fRoute->interface_address->interface->device;
+	uint32 offload = Domain()->family == AF_INET6 ? ipv6Offload : ipv4Offload;
+	return (device->offloads & offload) != 0;
+}
+
+
 status_t
 TCPEndpoint::_PrepareSendPath(const sockaddr* peer)
 {
@@ -2411,17 +2747,26 @@ TCPEndpoint::_PrepareSendPath(const sockaddr* peer)
 
 	// Compute the window shift we advertise to our peer - if it doesn't support
 	// this option, this will be reset to 0 (when its SYN is received)
-	fReceiveWindowShift = 0;
-	while (fReceiveWindowShift < TCP_MAX_WINDOW_SHIFT
-			&& (0xffffUL << fReceiveWindowShift) < socket->receive.buffer_size) {
-		fReceiveWindowShift++;
+	fReceiveWindowShift = _ReceiveWindowShift(IsLocal());
+
+	return B_OK;
+}
+
+
+uint8
+TCPEndpoint::_ReceiveWindowShift(bool local) const
+{
+	uint8 shift = 0;
+	while (shift < TCP_MAX_WINDOW_SHIFT
+			&& (0xffffUL << shift) < socket->receive.buffer_size) {
+		shift++;
 	}
 
 	// Increase to a default of 8 (window minimum 256 bytes, maximum 15 MB.)
-	if (fReceiveWindowShift < 8 && !IsLocal())
-		fReceiveWindowShift = 8;
+	if (shift < 8 && !local)
+		shift = 8;
 
-	return B_OK;
+	return shift;
 }
 
 
@@ -2448,28 +2793,31 @@ TCPEndpoint::_Acknowledged(tcp_segment_header& segment)
 			fRecover = segment.acknowledge - 1;
 		}
 
+		fScoreboard.RemoveUntil(fSendUnacknowledged);
+
 		// the acknowledgment of the SYN/ACK MUST NOT increase the size of the congestion window
 		if (fSendUnacknowledged != fInitialSendSequence) {
-			if (fCongestionWindow < fSlowStartThreshold)
-				fCongestionWindow += min_c(bytesAcknowledged, fSendMaxSegmentSize);
-			else {
-				uint32 increment = fSendMaxSegmentSize * fSendMaxSegmentSize;
-
-				if (increment < fCongestionWindow)
-					increment = 1;
-				else
-					increment /= fCongestionWindow;
-
-				fCongestionWindow += increment;
+			if ((fFlags & FLAG_RECOVERY) == 0) {
+				fCongestionControl->Acknowledged(fCongestionWindow,
+					fSlowStartThreshold, bytesAcknowledged, fSendMaxSegmentSize,
+					fSmoothedRoundTripTime);
 			}
 
 			fSendMaxSegments = UINT32_MAX;
 		}
 
-		if ((fFlags & FLAG_RECOVERY) != 0) {
+		if ((fFlags & FLAG_SACK_RECOVERY) != 0) {
+			// a partial acknowledgement; the window is not inflated in this
+			// case, so there is nothing to deflate
+			_SendRecovery();
+		} else if ((fFlags & FLAG_RECOVERY) != 0) {
 			fSendNext = fSendUnacknowledged;
 			_SendQueued();
-			fCongestionWindow -= bytesAcknowledged;
+
+			if (bytesAcknowledged < fCongestionWindow)
+				fCongestionWindow -= bytesAcknowledged;
+			else
+				fCongestionWindow = fSendMaxSegmentSize;
 
 			if (bytesAcknowledged > fSendMaxSegmentSize)
 				fCongestionWindow += fSendMaxSegmentSize;
@@ -2524,6 +2872,10 @@ TCPEndpoint::_Retransmit()
 	} else {
 		_ResetSlowStart();
 		fDuplicateAcknowledgeCount = 0;
+
+		// The peer may discard data it selectively acknowledged, so we
+		// retransmit everything from the first unacknowledged byte on.
+		fScoreboard.Clear();
 		// Do exponential back off of the retransmit timeout
 		fRetransmitTimeout *= 2;
 		if (fRetransmitTimeout > TCP_MAX_RETRANSMIT_TIMEOUT)
@@ -2534,8 +2886,7 @@ TCPEndpoint::_Retransmit()
 	_SendQueued();
 
 	fRecover = fSendNext.Number() - 1;
-	if ((fFlags & FLAG_RECOVERY) != 0)
-		fFlags &= ~FLAG_RECOVERY;
+	fFlags &= ~(FLAG_RECOVERY | FLAG_SACK_RECOVERY);
 }
 
 
@@ -2574,12 +2925,31 @@ TCPEndpoint::_UpdateRoundTripTime(int32 roundTripTime, int32 expectedSamples)
 void
 TCPEndpoint::_ResetSlowStart()
 {
-	fSlowStartThreshold = max_c((fSendMax - fSendUnacknowledged).Number() / 2,
-		2 * fSendMaxSegmentSize);
+	fSlowStartThreshold = fCongestionControl->LossDetected(fCongestionWindow,
+		(fSendMax - fSendUnacknowledged).Number(), fSendMaxSegmentSize, true);
 	fCongestionWindow = fSendMaxSegmentSize;
 }
 
 
+/*!	Replaces the congestion control algorithm with the one called \a name.
+	The current congestion window is kept.
+*/
+status_t
+TCPEndpoint::_SetCongestionControl(const char* name)
+{
+	if (strcmp(fCongestionControl->Name(), name) == 0)
+		return B_OK;
+
+	CongestionControl* congestionControl = create_congestion_control(name);
+	if (congestionControl == NULL)
+		return B_BAD_VALUE;
+
+	delete fCongestionControl;
+	fCongestionControl = congestionControl;
+	return B_OK;
+}
+
+
 //	#pragma mark - timer
 
 
@@ -2722,7 +3092,10 @@ TCPEndpoint::Dump() const
 	kprintf("  smoothed round trip time: %" B_PRId32 " (deviation %" B_PRId32 ")\n",
 		fSmoothedRoundTripTime, fRoundTripVariation);
 	kprintf("  retransmit timeout: %" B_PRId64 "\n", fRetransmitTimeout);
+	kprintf("  congestion control: %s\n", fCongestionControl->Name());
 	kprintf("  congestion window: %" B_PRIu32 "\n", fCongestionWindow);
 	kprintf("  slow start threshold: %" B_PRIu32 "\n", fSlowStartThreshold);
+	if (!fScoreboard.IsEmpty())
+		fScoreboard.Dump();
 }
 
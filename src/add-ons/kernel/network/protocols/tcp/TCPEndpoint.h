@@ -12,7 +12,9 @@
 
 
 #include "BufferQueue.h"
+#include "CongestionControl.h"
 #include "EndpointManager.h"
+#include "SackScoreboard.h"
 #include "tcp.h"
 
 #include <ProtocolUtilities.h>
@@ -70,6 +72,7 @@ public:
 private:
 			void		_StartPersistTimer();
 			void		_EnterTimeWait();
+			bool		_HandOverTimeWait();
 			void		_UpdateTimeWait();
 			void		_Close();
 			void		_CancelConnectionTimers();
@@ -82,16 +85,21 @@ private:
 							bool isRetransmit);
 			status_t	_SendAcknowledge(bool force = false);
 			status_t	_SendQueued(bool force = false);
+			status_t	_SendSegment(tcp_sequence sequence, uint32& length,
+							bool isRetransmit);
 
 			status_t	_Disconnect(bool closing);
 			ssize_t		_AvailableData() const;
 			void		_NotifyReader();
 			bool		_ShouldReceive() const;
 			void		_HandleReset(status_t error);
-			int32		_Spawn(TCPEndpoint* parent, tcp_segment_header& segment,
-							net_buffer* buffer);
+			int32		_Spawn(TCPEndpoint* parent,
+							const syn_cache_entry& entry,
+							tcp_segment_header& segment, net_buffer* buffer);
 			int32		_ListenReceive(tcp_segment_header& segment,
 							net_buffer* buffer);
+			int32		_CompleteHandshake(tcp_segment_header& segment,
+							net_buffer* buffer);
 			int32		_SynchronizeSentReceive(tcp_segment_header& segment,
 							net_buffer* buffer);
 			int32		_SegmentReceived(tcp_segment_header& segment,
@@ -107,13 +115,19 @@ private:
 			bool		_AddData(tcp_segment_header& segment,
 							net_buffer* buffer);
 			int			_MaxSegmentSize(const struct sockaddr* address) const;
+			bool		_DeviceCanOffload(uint32 ipv4Offload,
+							uint32 ipv6Offload) const;
 			void		_PrepareReceivePath(tcp_segment_header& segment);
 			status_t	_PrepareSendPath(const sockaddr* peer);
+			uint8		_ReceiveWindowShift(bool local) const;
 			void		_Acknowledged(tcp_segment_header& segment);
 			void		_Retransmit();
 			void		_UpdateRoundTripTime(int32 roundTripTime, int32 expectedSamples);
 			void		_ResetSlowStart();
 			void		_DuplicateAcknowledge(tcp_segment_header& segment);
+			void		_EnterRecovery(tcp_segment_header& segment);
+			void		_SendRecovery();
+			status_t	_SetCongestionControl(const char* name);
 
 	static	void		_TimeWaitTimer(net_timer* timer, void* _endpoint);
 	static	void		_RetransmitTimer(net_timer* timer, void* _endpoint);
@@ -127,6 +141,7 @@ private:
 private:
 	TCPEndpoint*	fConnectionHashLink;
 	TCPEndpoint*	fEndpointHashLink;
+	ReusePortGroup*	fReusePortGroup;
 	friend class	EndpointManager;
 	friend struct	ConnectionHashDefinition;
 	friend class	EndpointHashDefinition;
@@ -186,6 +201,12 @@ private:
 
 	uint32			fCongestionWindow;
 	uint32			fSlowStartThreshold;
+	CongestionControl*
+					fCongestionControl;
+
+	// SACK based loss recovery
+	SackScoreboard	fScoreboard;
+	tcp_sequence	fHighRetransmitted;
 
 	tcp_state		fState;
 	uint32			fFlags;
@@ -433,8 +433,14 @@ add_tcp_header(net_address_module_info* addressModule,
 		"win %u\n", buffer, segment.flags, segment.sequence,
 		segment.acknowledge, segment.urgent_offset, segment.advertised_window));
 
-	*TCPChecksumField(buffer) = Checksum::PseudoHeader(addressModule,
-		gBufferModule, buffer, IPPROTO_TCP);
+	if ((buffer->buffer_flags & NET_BUFFER_L4_CHECKSUM_PARTIAL) != 0) {
+		// the device will complete it
+		*TCPChecksumField(buffer) = Checksum::PartialPseudoHeader(
+			addressModule, buffer, IPPROTO_TCP);
+	} else {
+		*TCPChecksumField(buffer) = Checksum::PseudoHeader(addressModule,
+			gBufferModule, buffer, IPPROTO_TCP);
+	}
 	buffer->buffer_flags |= NET_BUFFER_L4_CHECKSUM_VALID;
 
 	return B_OK;
@@ -731,19 +737,22 @@ tcp_receive_data(net_buffer* buffer)
 
 	int32 segmentAction = DROP;
 
-	TCPEndpoint* endpoint = endpointManager->FindConnection(
-		buffer->destination, buffer->source);
-	if (endpoint != NULL) {
-		segmentAction = endpoint->SegmentReceived(segment, buffer);
-
-		// There are some states in which the socket could have been deleted
-		// while handling a segment. If this flag is set in segmentAction
-		// then we know the socket has been freed and can skip releasing
-		// the reference acquired in EndpointManager::FindConnection().
-		if ((segmentAction & DELETED_ENDPOINT) == 0)
-			gSocketModule->release_socket(endpoint->socket);
-	} else if ((segment.flags & TCP_FLAG_RESET) == 0)
-		segmentAction = DROP | RESET;
+	if (!endpointManager->TimeWaitReceived(segment, buffer, segmentAction)) {
+		TCPEndpoint* endpoint = endpointManager->FindConnection(
+			buffer->destination, buffer->source);
+		if (endpoint != NULL) {
+			segmentAction = endpoint->SegmentReceived(segment, buffer);
+
+			// There are some states in which the socket could have been
+			// deleted while handling a segment. If this flag is set in
+			// segmentAction then we know the socket has been freed and can
+			// skip releasing the reference acquired in
+			// EndpointManager::FindConnection().
+			if ((segmentAction & DELETED_ENDPOINT) == 0)
+				gSocketModule->release_socket(endpoint->socket);
+		} else if ((segment.flags & TCP_FLAG_RESET) == 0)
+			segmentAction = DROP | RESET;
+	}
 
 	if ((segmentAction & RESET) != 0) {
 		// send reset
@@ -196,6 +196,9 @@ operator==(tcp_sequence a, tcp_sequence b)
 // New value for timeout in case of lost SYN (RFC 6298)
 #define TCP_SYN_RETRANSMIT_TIMEOUT 		3000000		// 3 secs
 
+static const int kTimestampFactor = 1000;
+	// conversion factor between usec system time and msec tcp time
+
 struct tcp_sack {
 	uint32 left_edge;
 	uint32 right_edge;
@@ -289,6 +292,13 @@ enum tcp_segment_action {
 };
 
 
+static inline uint32
+tcp_now()
+{
+	return system_time() / kTimestampFactor;
+}
+
+
 extern net_buffer_module_info* gBufferModule;
 extern net_datalink_module_info* gDatalinkModule;
 extern net_socket_module_info* gSocketModule;
@@ -31,6 +31,7 @@
 #include <new>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include <utility>
 
 
@@ -90,10 +91,14 @@ public:
 			status_t			SendRoutedData(net_buffer* buffer,
 									net_route* route);
 			status_t			SendData(net_buffer* buffer);
+			status_t			SendDataMultiple(net_buffer** buffers,
+									size_t count, size_t* _sent);
 
 			ssize_t				BytesAvailable();
 			status_t			FetchData(size_t numBytes, uint32 flags,
 									net_buffer** _buffer);
+			ssize_t				FetchDataMultiple(uint32 flags,
+									net_buffer** _buffers, size_t count);
 
 			status_t			StoreData(net_buffer* buffer);
 			status_t			DeliverData(net_buffer* buffer);
@@ -103,6 +108,9 @@ public:
 			bool				IsActive() const { return fActive; }
 			void				SetActive(bool newValue) { fActive = newValue; }
 
+			uid_t				Owner() const { return fOwner; }
+			void				SetOwner(uid_t owner) { fOwner = owner; }
+
 			UdpEndpoint*&		HashTableLink() { return fLink; }
 
 			void				Dump() const;
@@ -114,6 +122,11 @@ private:
 									// endpoint hash (and it is bound and
 									// optionally connected)
 
+			uid_t				fOwner;
+									// the effective user that bound it, only
+									// endpoints of the same owner may share
+									// an address via SO_REUSEPORT
+
 			UdpEndpoint*		fLink;
 };
 
@@ -191,7 +204,13 @@ private:
 	status_t _FinishBind(UdpEndpoint *endpoint, const sockaddr *address);
 
 	UdpEndpoint *_FindActiveEndpoint(const sockaddr *ourAddress,
-		const sockaddr *peerAddress, uint32 index = 0);
+		const sockaddr *peerAddress, uint32 index = 0, size_t flowHash = 0);
+	UdpEndpoint *_SelectReusePortEndpoint(UdpEndpoint *first,
+		const sockaddr *ourAddress, const sockaddr *peerAddress, uint32 index,
+		size_t flowHash);
+	bool _IsReusePortCandidate(UdpEndpoint *endpoint,
+		const sockaddr *ourAddress, const sockaddr *peerAddress,
+		uint32 index) const;
 	status_t _DemuxBroadcast(net_buffer *buffer);
 	status_t _DemuxUnicast(net_buffer *buffer);
 
@@ -456,10 +475,12 @@ UdpDomainSupport::_Bind(UdpEndpoint *endpoint, const sockaddr *address)
 				|| (socketOptions & (SO_REUSEADDR | SO_REUSEPORT)) == 0)
 				return EADDRINUSE;
 
-			// if both addresses are the same, SO_REUSEPORT is required:
+			// if both addresses are the same, SO_REUSEPORT is required, and
+			// the datagrams are only shared with endpoints of the same user:
 			if (otherEndpoint->LocalAddress().EqualTo(address, false)
 				&& ((otherEndpoint->Socket()->options & SO_REUSEPORT) == 0
-					|| (socketOptions & SO_REUSEPORT) == 0))
+					|| (socketOptions & SO_REUSEPORT) == 0
+					|| otherEndpoint->Owner() != geteuid()))
 				return EADDRINUSE;
 		}
 	}
@@ -494,6 +515,7 @@ UdpDomainSupport::_FinishBind(UdpEndpoint *endpoint, const sockaddr *address)
 	if (status < B_OK)
 		return status;
 
+	endpoint->SetOwner(geteuid());
 	fActiveEndpoints.Insert(endpoint);
 	endpoint->SetActive(true);
 
@@ -503,7 +525,7 @@ UdpDomainSupport::_FinishBind(UdpEndpoint *endpoint, const sockaddr *address)
 
 UdpEndpoint *
 UdpDomainSupport::_FindActiveEndpoint(const sockaddr *ourAddress,
-	const sockaddr *peerAddress, uint32 index)
+	const sockaddr *peerAddress, uint32 index, size_t flowHash)
 {
 	ASSERT_LOCKED_MUTEX(&fLock);
 
@@ -524,10 +546,66 @@ UdpDomainSupport::_FindActiveEndpoint(const sockaddr *ourAddress,
 			return NULL;
 	}
 
+	if (endpoint != NULL && (endpoint->Socket()->options & SO_REUSEPORT) != 0) {
+		endpoint = _SelectReusePortEndpoint(endpoint, ourAddress, peerAddress,
+			index, flowHash);
+	}
+
 	return endpoint;
 }
 
 
+/*!	Spreads the datagrams over all endpoints that share the address via
+	SO_REUSEPORT, so that datagrams of the same flow always end up in the
+	same endpoint.
+*/
+UdpEndpoint *
+UdpDomainSupport::_SelectReusePortEndpoint(UdpEndpoint *first,
+	const sockaddr *ourAddress, const sockaddr *peerAddress, uint32 index,
+	size_t flowHash)
+{
+	ASSERT_LOCKED_MUTEX(&fLock);
+
+	// All endpoints with the same addresses are in the same bucket, after the
+	// one we found
+	uint32 count = 0;
+	for (UdpEndpoint* endpoint = first; endpoint != NULL;
+			endpoint = endpoint->HashTableLink()) {
+		if (_IsReusePortCandidate(endpoint, ourAddress, peerAddress, index))
+			count++;
+	}
+
+	if (count <= 1)
+		return first;
+
+	// spread the bits of the hash over the whole range
+	uint32 selected = (((uint32)flowHash * 0x9e3779b1U) >> 16) % count;
+
+	for (UdpEndpoint* endpoint = first; endpoint != NULL;
+			endpoint = endpoint->HashTableLink()) {
+		if (_IsReusePortCandidate(endpoint, ourAddress, peerAddress, index)
+			&& selected-- == 0) {
+			return endpoint;
+		}
+	}
+
+	return first;
+}
+
+
+bool
+UdpDomainSupport::_IsReusePortCandidate(UdpEndpoint *endpoint,
+	const sockaddr *ourAddress, const sockaddr *peerAddress,
+	uint32 index) const
+{
+	return (endpoint->Socket()->options & SO_REUSEPORT) != 0
+		&& (endpoint->socket->bound_to_device == 0 || index == 0
+			|| endpoint->socket->bound_to_device == index)
+		&& endpoint->LocalAddress().EqualTo(ourAddress, true)
+		&& endpoint->PeerAddress().EqualTo(peerAddress, true);
+}
+
+
 status_t
 UdpDomainSupport::_DemuxBroadcast(net_buffer* buffer)
 {
@@ -585,21 +663,28 @@ UdpDomainSupport::_DemuxUnicast(net_buffer* buffer)
 	const sockaddr* localAddress = buffer->destination;
 	const sockaddr* peerAddress = buffer->source;
 
+	// used to choose between endpoints sharing their address
+	size_t flowHash = AddressModule()->hash_address_pair(localAddress,
+		peerAddress);
+
 	// look for full (most special) match:
 	UdpEndpoint* endpoint = _FindActiveEndpoint(localAddress, peerAddress,
-		buffer->index);
+		buffer->index, flowHash);
 	if (endpoint == NULL) {
 		// look for endpoint matching local address & port:
-		endpoint = _FindActiveEndpoint(localAddress, NULL, buffer->index);
+		endpoint = _FindActiveEndpoint(localAddress, NULL, buffer->index,
+			flowHash);
 		if (endpoint == NULL) {
 			// look for endpoint matching peer address & port and local port:
 			SocketAddressStorage local(AddressModule());
 			local.SetToEmpty();
 			local.SetPort(AddressModule()->get_port(localAddress));
-			endpoint = _FindActiveEndpoint(*local, peerAddress, buffer->index);
+			endpoint = _FindActiveEndpoint(*local, peerAddress, buffer->index,
+				flowHash);
 			if (endpoint == NULL) {
 				// last chance: look for endpoint matching local port only:
-				endpoint = _FindActiveEndpoint(*local, NULL, buffer->index);
+				endpoint = _FindActiveEndpoint(*local, NULL, buffer->index,
+					flowHash);
 			}
 		}
 	}
@@ -939,7 +1024,8 @@ UdpEndpointManager::_GetDomainSupport(net_buffer* buffer)
 UdpEndpoint::UdpEndpoint(net_socket *socket)
 	:
 	DatagramSocket<>("udp endpoint", socket),
-	fActive(false)
+	fActive(false),
+	fOwner(0)
 {
 }
 
@@ -1057,6 +1143,73 @@ UdpEndpoint::SendData(net_buffer *buffer)
 }
 
 
+/*!	Sends the \a buffers in order, but only looks up the route once for all
+	consecutive buffers going to the same destination. Stops at the first
+	buffer that could not be sent; the remaining buffers are left to the
+	caller.
+*/
+status_t
+UdpEndpoint::SendDataMultiple(net_buffer** buffers, size_t count,
+	size_t* _sent)
+{
+	TRACE_EP("SendDataMultiple(%p, %" B_PRIuSIZE ")", buffers, count);
+
+	*_sent = 0;
+
+	if (fSocket->bound_to_device != 0) {
+		// leave the route selection to the datalink layer
+		for (size_t i = 0; i < count; i++) {
+			status_t status = SendData(buffers[i]);
+			if (status != B_OK)
+				return status;
+
+			(*_sent)++;
+		}
+		return B_OK;
+	}
+
+	net_route* route = NULL;
+	sockaddr_storage source;
+	sockaddr_storage destination;
+	status_t status = B_OK;
+
+	for (size_t i = 0; i < count; i++) {
+		net_buffer* buffer = buffers[i];
+
+		if (route != NULL && AddressModule()->equal_addresses_and_ports(
+				(sockaddr*)&destination, buffer->destination)) {
+			// same destination as before, the buffer would get the same
+			// source address, too
+			memcpy(buffer->source, &source, source.ss_len);
+		} else {
+			if (route != NULL)
+				gDatalinkModule->put_route(Domain(), route);
+
+			route = NULL;
+			status = gDatalinkModule->get_buffer_route(Domain(), buffer,
+				&route);
+			if (status != B_OK)
+				break;
+
+			memcpy(&source, buffer->source, buffer->source->sa_len);
+			memcpy(&destination, buffer->destination,
+				buffer->destination->sa_len);
+		}
+
+		status = SendRoutedData(buffer, route);
+		if (status != B_OK)
+			break;
+
+		(*_sent)++;
+	}
+
+	if (route != NULL)
+		gDatalinkModule->put_route(Domain(), route);
+
+	return status;
+}
+
+
 // #pragma mark - inbound
 
 
@@ -1085,6 +1238,17 @@ UdpEndpoint::FetchData(size_t numBytes, uint32 flags, net_buffer **_buffer)
 }
 
 
+ssize_t
+UdpEndpoint::FetchDataMultiple(uint32 flags, net_buffer** _buffers,
+	size_t count)
+{
+	TRACE_EP("FetchDataMultiple(0x%" B_PRIx32 ", %" B_PRIuSIZE ")", flags,
+		count);
+
+	return DequeueMultiple(flags, _buffers, count);
+}
+
+
 status_t
 UdpEndpoint::StoreData(net_buffer *buffer)
 {
@@ -1256,6 +1420,14 @@ udp_send_data(net_protocol *protocol, net_buffer *buffer)
 }
 
 
+status_t
+udp_send_data_multiple(net_protocol *protocol, net_buffer **buffers,
+	size_t count, size_t *_sent)
+{
+	return ((UdpEndpoint *)protocol)->SendDataMultiple(buffers, count, _sent);
+}
+
+
 ssize_t
 udp_send_avail(net_protocol *protocol)
 {
@@ -1271,6 +1443,14 @@ udp_read_data(net_protocol *protocol, size_t numBytes, uint32 flags,
 }
 
 
+ssize_t
+udp_read_data_multiple(net_protocol *protocol, uint32 flags,
+	net_buffer **_buffers, size_t count)
+{
+	return ((UdpEndpoint *)protocol)->FetchDataMultiple(flags, _buffers, count);
+}
+
+
 ssize_t
 udp_read_avail(net_protocol *protocol)
 {
@@ -1495,7 +1675,9 @@ net_protocol_module_info sUDPModule = {
 	NULL,		// process_ancillary_data()
 	udp_process_ancillary_data_no_container,
 	NULL,		// send_data_no_buffer()
-	NULL		// read_data_no_buffer()
+	NULL,		// read_data_no_buffer()
+	udp_send_data_multiple,
+	udp_read_data_multiple
 };
 
 module_dependency module_dependencies[] = {
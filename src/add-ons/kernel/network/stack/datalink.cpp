@@ -114,6 +114,8 @@ option_to_string(int32 option)
 		CODE(B_SOCKET_SET_ALIAS)		/* set interface alias, ifaliasreq */
 		CODE(B_SOCKET_GET_ALIAS)		/* get interface alias, ifaliasreq */
 		CODE(B_SOCKET_COUNT_ALIASES)	/* count interface aliases */
+		CODE(B_SOCKET_GET_RECEIVE_QUEUE_STATS)
+			/* get receive queue statistics, ifreceivequeuereq */
 
 		default:
 			static char buffer[24];
@@ -393,8 +395,8 @@ datalink_send_routed_data(struct net_route* route, net_buffer* buffer)
 
 		// this one goes back to the domain directly
 		const size_t packetSize = buffer->size;
-		status_t status = fifo_enqueue_buffer(
-			&interface->DeviceInterface()->receive_queue, buffer);
+		status_t status = device_interface_enqueue_buffer(
+			interface->DeviceInterface(), buffer);
 		update_device_send_stats(interface->DeviceInterface()->device,
 			status, packetSize);
 		return status;
@@ -901,6 +903,25 @@ interface_protocol_control(net_datalink_protocol* _protocol, int32 option,
 				&stats, sizeof(struct ifreq_stats));
 		}
 
+		case B_SOCKET_GET_RECEIVE_QUEUE_STATS:
+		{
+			ifreceivequeuereq request;
+			if (user_memcpy(&request, argument, sizeof(ifreceivequeuereq))
+					!= B_OK)
+				return B_BAD_ADDRESS;
+
+			net_device_interface* deviceInterface
+				= interface->DeviceInterface();
+			request.ifrq_count = deviceInterface->receive_queue_count;
+
+			status_t status = get_device_interface_receive_queue_stats(
+				deviceInterface, request.ifrq_index, &request.ifrq_stats);
+			if (status != B_OK)
+				return status;
+
+			return user_memcpy(argument, &request, sizeof(ifreceivequeuereq));
+		}
+
 		case SIOCGIFTYPE:
 		{
 			// get type
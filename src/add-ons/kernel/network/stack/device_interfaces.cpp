@@ -16,12 +16,17 @@
 #include <net_device.h>
 
 #include <lock.h>
+#include <smp.h>
+#include <thread.h>
 #include <util/AutoLock.h>
+#include <util/ThreadAutoLock.h>
 
 #include <KernelExport.h>
 
 #include <net/if_dl.h>
 #include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/ip6.h>
 #include <new>
 #include <stdio.h>
 #include <stdlib.h>
@@ -36,14 +41,100 @@
 #endif
 
 
+static const uint32 kMaxReceiveQueues = 8;
+static const size_t kReceiveQueueBytes = 16 * 1024 * 1024;
+	// shared by all receive queues of a device interface
+
 static mutex sLock;
 static DeviceInterfaceList sInterfaces;
 static uint32 sDeviceIndex;
 
 
+static inline uint32
+hash_flow_word(uint32 hash, uint32 word)
+{
+	hash ^= word;
+	hash *= 0x01000193;
+	return hash ^ (hash >> 15);
+}
+
+
+/*!	Computes a hash over the addresses, the protocol, and, if available, the
+	ports of an IP packet. All packets of a flow get the same hash, and thus
+	end up in the same receive queue, so that their order is preserved.
+	Fragments are only hashed by their addresses, as only the first one
+	carries the ports. Anything else is hashed to 0.
+*/
+static uint32
+receive_flow_hash(net_buffer* buffer)
+{
+	uint8 version;
+	if (gNetBufferModule.read(buffer, 0, &version, 1) != B_OK)
+		return 0;
+
+	uint32 hash = 0x811c9dc5;
+	size_t headerLength;
+	uint8 protocol;
+
+	switch (version >> 4) {
+		case 4:
+		{
+			ip header;
+			if (gNetBufferModule.read(buffer, 0, &header, sizeof(ip)) != B_OK)
+				return 0;
+
+			hash = hash_flow_word(hash, header.ip_src.s_addr);
+			hash = hash_flow_word(hash, header.ip_dst.s_addr);
+			hash = hash_flow_word(hash, header.ip_p);
+
+			if ((ntohs(header.ip_off) & (IP_MF | IP_OFFMASK)) != 0)
+				return hash;
+
+			headerLength = header.ip_hl << 2;
+			protocol = header.ip_p;
+			break;
+		}
+
+		case 6:
+		{
+			ip6_hdr header;
+			if (gNetBufferModule.read(buffer, 0, &header, sizeof(ip6_hdr))
+					!= B_OK)
+				return 0;
+
+			const uint32* source = (const uint32*)&header.ip6_src;
+			const uint32* destination = (const uint32*)&header.ip6_dst;
+			for (int i = 0; i < 4; i++) {
+				hash = hash_flow_word(hash, source[i]);
+				hash = hash_flow_word(hash, destination[i]);
+			}
+			hash = hash_flow_word(hash, header.ip6_nxt);
+
+			// extension headers are not followed, the addresses suffice then
+			headerLength = sizeof(ip6_hdr);
+			protocol = header.ip6_nxt;
+			break;
+		}
+
+		default:
+			return 0;
+	}
+
+	if (protocol != IPPROTO_TCP && protocol != IPPROTO_UDP)
+		return hash;
+
+	uint32 ports;
+	if (gNetBufferModule.read(buffer, headerLength, &ports, sizeof(ports))
+			== B_OK)
+		hash = hash_flow_word(hash, ports);
+
+	return hash;
+}
+
+
 /*!	A service thread for each device interface. It just reads as many packets
-	as available, deframes them, and puts them into the receive queue of the
-	device interface.
+	as available, deframes them, and puts them into one of the receive queues
+	of the device interface.
 */
 static status_t
 device_reader_thread(void* _interface)
@@ -69,7 +160,7 @@ device_reader_thread(void* _interface)
 			}
 
 			const size_t packetSize = buffer->size;
-			status = fifo_enqueue_buffer(&interface->receive_queue, buffer);
+			status = device_interface_enqueue_buffer(interface, buffer);
 			if (status == B_OK) {
 				atomic_add((int32*)&device->stats.receive.packets, 1);
 				atomic_add64((int64*)&device->stats.receive.bytes, packetSize);
@@ -93,15 +184,23 @@ device_reader_thread(void* _interface)
 }
 
 
+/*!	There is one consumer thread for each receive queue of a device interface;
+	it passes the packets on to the protocol layers. As there are as many
+	queues as there are CPUs (up to kMaxReceiveQueues), the protocol
+	processing of different flows can run in parallel.
+	The receive lock is only held while looking up the handlers; they are
+	called without it, and are only kept alive by their busy_count.
+*/
 static status_t
-device_consumer_thread(void* _interface)
+device_consumer_thread(void* _queue)
 {
-	net_device_interface* interface = (net_device_interface*)_interface;
+	net_receive_queue* queue = (net_receive_queue*)_queue;
+	net_device_interface* interface = queue->interface;
 	net_device* device = interface->device;
 	net_buffer* buffer;
 
 	while (atomic_get(&interface->ref_count) > 0) {
-		ssize_t status = fifo_dequeue_buffer(&interface->receive_queue, 0,
+		ssize_t status = fifo_dequeue_buffer(&queue->fifo, 0,
 			B_INFINITE_TIMEOUT, &buffer);
 		if (status != B_OK) {
 			if (status == B_INTERRUPTED)
@@ -123,22 +222,42 @@ device_consumer_thread(void* _interface)
 
 			buffer->index = interface->device->index;
 
-			// Find handler for this packet
+			// Find the handlers for this packet; as there is only one handler
+			// per type, there can be at most two of them
+
+			net_device_handler* handlers[2];
+			int32 handlerCount = 0;
 
 			RecursiveLocker locker(interface->receive_lock);
 
 			DeviceHandlerList::Iterator iterator
 				= interface->receive_funcs.GetIterator();
-			while (buffer != NULL && iterator.HasNext()) {
+			while (handlerCount < 2 && iterator.HasNext()) {
 				net_device_handler* handler = iterator.Next();
+				if (handler->type == genericType
+					|| handler->type == specificType) {
+					handler->busy_count++;
+					handlers[handlerCount++] = handler;
+				}
+			}
 
-				// If the handler returns B_OK, it consumed the buffer - first
-				// handler wins.
-				if ((handler->type == genericType
-						|| handler->type == specificType)
-					&& handler->func(handler->cookie, device, buffer) == B_OK)
+			locker.Unlock();
+
+			// If the handler returns B_OK, it consumed the buffer - first
+			// handler wins.
+			for (int32 i = 0; i < handlerCount && buffer != NULL; i++) {
+				if (handlers[i]->func(handlers[i]->cookie, device, buffer)
+						== B_OK)
 					buffer = NULL;
 			}
+
+			if (handlerCount > 0) {
+				locker.Lock();
+				for (int32 i = 0; i < handlerCount; i++) {
+					if (--handlers[i]->busy_count == 0 && handlers[i]->removed)
+						interface->receive_handler_idle.NotifyAll();
+				}
+			}
 		}
 
 		if (buffer != NULL)
@@ -176,6 +295,103 @@ find_device_interface(const char* name)
 }
 
 
+/*!	Restricts the (not yet running) consumer \a thread to \a cpu, so that the
+	flows of its receive queue are always processed on the same CPU.
+*/
+static void
+bind_consumer_thread(thread_id id, int32 cpu)
+{
+	Thread* thread = Thread::GetAndLock(id);
+	if (thread == NULL)
+		return;
+
+	BReference<Thread> threadReference(thread, true);
+	ThreadLocker threadLocker(thread, true);
+
+	thread->cpumask.ClearAll();
+	thread->cpumask.SetBit(cpu);
+}
+
+
+/*!	Stops the consumer threads of the first \a count receive queues of the
+	\a interface, and frees them all. The interface must already be marked
+	as being destroyed (its ref_count must be 0).
+*/
+static void
+delete_receive_queues(net_device_interface* interface, uint32 count)
+{
+	for (uint32 i = 0; i < count; i++) {
+		net_receive_queue& queue = interface->receive_queues[i];
+
+		thread_id thread = queue.consumer_thread;
+		uninit_fifo(&queue.fifo);
+		if (thread >= 0)
+			wait_for_thread(thread, NULL);
+	}
+
+	delete[] interface->receive_queues;
+	interface->receive_queues = NULL;
+	interface->receive_queue_count = 0;
+}
+
+
+static status_t
+create_receive_queues(net_device_interface* interface)
+{
+	system_info info;
+	get_system_info(&info);
+
+	uint32 count = min_c(max_c(info.cpu_count, 1), kMaxReceiveQueues);
+
+	interface->receive_queues = new(std::nothrow) net_receive_queue[count];
+	if (interface->receive_queues == NULL)
+		return B_NO_MEMORY;
+
+	interface->receive_queue_count = 0;
+
+	for (uint32 i = 0; i < count; i++) {
+		net_receive_queue& queue = interface->receive_queues[i];
+		queue.interface = interface;
+		queue.consumer_thread = -1;
+		memset(&queue.stats, 0, sizeof(queue.stats));
+
+		char name[128];
+		snprintf(name, sizeof(name), "%s receive queue %" B_PRIu32,
+			interface->device->name, i);
+
+		status_t status = init_fifo(&queue.fifo, name,
+			kReceiveQueueBytes / count);
+		if (status != B_OK) {
+			delete_receive_queues(interface, i);
+			return status;
+		}
+
+		snprintf(name, sizeof(name), "%s consumer %" B_PRIu32,
+			interface->device->name, i);
+
+		queue.consumer_thread = spawn_kernel_thread(device_consumer_thread,
+			name, B_DISPLAY_PRIORITY, &queue);
+		if (queue.consumer_thread < 0) {
+			status = queue.consumer_thread;
+			interface->ref_count = 0;
+			delete_receive_queues(interface, i + 1);
+			return status;
+		}
+	}
+
+	interface->receive_queue_count = count;
+
+	for (uint32 i = 0; i < count; i++) {
+		thread_id thread = interface->receive_queues[i].consumer_thread;
+		if (count > 1)
+			bind_consumer_thread(thread, i);
+		resume_thread(thread);
+	}
+
+	return B_OK;
+}
+
+
 static net_device_interface*
 allocate_device_interface(net_device* device, net_device_module_info* module)
 {
@@ -184,14 +400,10 @@ allocate_device_interface(net_device* device, net_device_module_info* module)
 		return NULL;
 
 	recursive_lock_init(&interface->receive_lock, "device interface receive");
+	interface->receive_handler_idle.Init(interface,
+		"device interface handler idle");
 	recursive_lock_init(&interface->monitor_lock, "device interface monitors");
 
-	char name[128];
-	snprintf(name, sizeof(name), "%s receive queue", device->name);
-
-	if (init_fifo(&interface->receive_queue, name, 16 * 1024 * 1024) < B_OK)
-		goto error1;
-
 	interface->device = device;
 	interface->up_count = 0;
 	interface->ref_count = 1;
@@ -200,14 +412,9 @@ allocate_device_interface(net_device* device, net_device_module_info* module)
 	interface->deframe_func = NULL;
 	interface->deframe_ref_count = 0;
 
-	snprintf(name, sizeof(name), "%s consumer", device->name);
-
-	interface->reader_thread   = -1;
-	interface->consumer_thread = spawn_kernel_thread(device_consumer_thread,
-		name, B_DISPLAY_PRIORITY, interface);
-	if (interface->consumer_thread < B_OK)
-		goto error2;
-	resume_thread(interface->consumer_thread);
+	interface->reader_thread = -1;
+	if (create_receive_queues(interface) != B_OK)
+		goto error;
 
 	// TODO: proper interface index allocation
 	device->index = ++sDeviceIndex;
@@ -216,9 +423,7 @@ allocate_device_interface(net_device* device, net_device_module_info* module)
 	sInterfaces.Add(interface);
 	return interface;
 
-error2:
-	uninit_fifo(&interface->receive_queue);
-error1:
+error:
 	recursive_lock_destroy(&interface->receive_lock);
 	recursive_lock_destroy(&interface->monitor_lock);
 	delete interface;
@@ -261,7 +466,6 @@ dump_device_interface(int argc, char** argv)
 	kprintf("ref_count:         %" B_PRId32 "\n", interface->ref_count);
 	kprintf("deframe_func:      %p\n", interface->deframe_func);
 	kprintf("deframe_ref_count: %" B_PRId32 "\n", interface->ref_count);
-	kprintf("consumer_thread:   %" B_PRId32 "\n", interface->consumer_thread);
 
 	kprintf("monitor_count:     %" B_PRId32 "\n", interface->monitor_count);
 	kprintf("monitor_lock:      %p\n", &interface->monitor_lock);
@@ -272,7 +476,16 @@ dump_device_interface(int argc, char** argv)
 		kprintf("  %p\n", monitorIterator.Next());
 
 	kprintf("receive_lock:      %p\n", &interface->receive_lock);
-	kprintf("receive_queue:     %p\n", &interface->receive_queue);
+	kprintf("receive_queues:    %" B_PRIu32 "\n",
+		interface->receive_queue_count);
+	for (uint32 i = 0; i < interface->receive_queue_count; i++) {
+		net_receive_queue& queue = interface->receive_queues[i];
+		kprintf("  %p  consumer %" B_PRId32 ", %" B_PRIuSIZE " bytes queued, "
+			"%" B_PRIu32 " packets, %" B_PRIu64 " bytes, %" B_PRIu32
+			" dropped\n", &queue.fifo, queue.consumer_thread,
+			queue.fifo.current_bytes, queue.stats.packets, queue.stats.bytes,
+			queue.stats.dropped);
+	}
 	kprintf("receive_funcs:\n");
 	DeviceHandlerList::Iterator handlerIterator
 		= interface->receive_funcs.GetIterator();
@@ -400,8 +613,7 @@ put_device_interface(struct net_device_interface* interface)
 	sInterfaces.Remove(interface);
 	locker.Unlock();
 
-	uninit_fifo(&interface->receive_queue);
-	wait_for_thread(interface->consumer_thread, NULL);
+	delete_receive_queues(interface, interface->receive_queue_count);
 
 	net_device* device = interface->device;
 	const char* moduleName = device->module->info.name;
@@ -514,6 +726,51 @@ device_interface_monitor_receive(net_device_interface* interface,
 }
 
 
+/*!	Puts the \a buffer into the receive queue of its flow, and accounts for
+	it in the statistics of that queue.
+	The caller keeps ownership of the buffer if this fails.
+*/
+status_t
+device_interface_enqueue_buffer(net_device_interface* interface,
+	net_buffer* buffer)
+{
+	net_receive_queue* queue = &interface->receive_queues[0];
+	if (interface->receive_queue_count > 1) {
+		queue = &interface->receive_queues[
+			receive_flow_hash(buffer) % interface->receive_queue_count];
+	}
+
+	const size_t packetSize = buffer->size;
+	status_t status = fifo_enqueue_buffer(&queue->fifo, buffer);
+	if (status == B_OK) {
+		atomic_add((int32*)&queue->stats.packets, 1);
+		atomic_add64((int64*)&queue->stats.bytes, packetSize);
+	} else
+		atomic_add((int32*)&queue->stats.dropped, 1);
+
+	return status;
+}
+
+
+status_t
+get_device_interface_receive_queue_stats(net_device_interface* interface,
+	uint32 index, ifreq_stream_stats* stats)
+{
+	if (index >= interface->receive_queue_count)
+		return B_BAD_INDEX;
+
+	const ifreq_stream_stats& queueStats
+		= interface->receive_queues[index].stats;
+
+	stats->packets = atomic_get((int32*)&queueStats.packets);
+	stats->errors = 0;
+	stats->bytes = atomic_get64((int64*)&queueStats.bytes);
+	stats->multicast_packets = 0;
+	stats->dropped = atomic_get((int32*)&queueStats.dropped);
+	return B_OK;
+}
+
+
 status_t
 up_device_interface(net_device_interface* interface)
 {
@@ -686,6 +943,8 @@ register_device_handler(struct net_device* device, int32 type,
 	handler->func = receiveFunc;
 	handler->type = type;
 	handler->cookie = cookie;
+	handler->busy_count = 0;
+	handler->removed = false;
 	interface->receive_funcs.Add(handler);
 	return B_OK;
 }
@@ -702,22 +961,46 @@ unregister_device_handler(struct net_device* device, int32 type)
 	if (interface == NULL)
 		return B_DEVICE_NOT_FOUND;
 
-	RecursiveLocker _(interface->receive_lock);
+	RecursiveLocker receiveLocker(interface->receive_lock);
 
 	// search for the handler
 
+	net_device_handler* handler = NULL;
 	DeviceHandlerList::Iterator iterator
 		= interface->receive_funcs.GetIterator();
-	while (net_device_handler* handler = iterator.Next()) {
-		if (handler->type == type) {
-			// found it
+	while (iterator.HasNext()) {
+		net_device_handler* next = iterator.Next();
+		if (next->type == type) {
 			iterator.Remove();
-			delete handler;
-			return B_OK;
+			handler = next;
+			break;
 		}
 	}
 
-	return B_BAD_VALUE;
+	if (handler == NULL)
+		return B_BAD_VALUE;
+
+	// Wait until the consumer threads no longer call the handler. The
+	// handler might need sLock, so it is released while waiting, if the
+	// interface can be kept alive without it.
+	net_device_interface* reference = acquire_device_interface(interface);
+	if (reference != NULL)
+		locker.Unlock();
+
+	handler->removed = true;
+	while (handler->busy_count > 0) {
+		ConditionVariableEntry entry;
+		interface->receive_handler_idle.Add(&entry);
+		receiveLocker.Unlock();
+		entry.Wait();
+		receiveLocker.Lock();
+	}
+
+	receiveLocker.Unlock();
+	delete handler;
+
+	put_device_interface(reference);
+	return B_OK;
 }
 
 
@@ -838,7 +1121,7 @@ device_enqueue_buffer(net_device* device, net_buffer* buffer)
 		return status;
 	}
 
-	status = fifo_enqueue_buffer(&interface->receive_queue, buffer);
+	status = device_interface_enqueue_buffer(interface, buffer);
 
 	put_device_interface(interface);
 	return status;
@@ -12,6 +12,7 @@
 #include <net_datalink.h>
 #include <net_stack.h>
 
+#include <condition_variable.h>
 #include <util/DoublyLinkedList.h>
 
 
@@ -19,6 +20,10 @@ struct net_device_handler : DoublyLinkedListLinkImpl<net_device_handler> {
 	net_receive_func	func;
 	int32				type;
 	void*				cookie;
+
+	int32				busy_count;
+		// the number of consumer threads that are calling func
+	bool				removed;
 };
 
 typedef DoublyLinkedList<net_device_handler> DeviceHandlerList;
@@ -26,6 +31,15 @@ typedef DoublyLinkedList<net_device_handler> DeviceHandlerList;
 typedef DoublyLinkedList<net_device_monitor,
 	DoublyLinkedListCLink<net_device_monitor> > DeviceMonitorList;
 
+struct net_device_interface;
+
+struct net_receive_queue {
+	net_device_interface* interface;
+	thread_id			consumer_thread;
+	net_fifo			fifo;
+	ifreq_stream_stats	stats;
+};
+
 struct net_device_interface : DoublyLinkedListLinkImpl<net_device_interface> {
 	struct net_device*	device;
 	thread_id			reader_thread;
@@ -43,9 +57,12 @@ struct net_device_interface : DoublyLinkedListLinkImpl<net_device_interface> {
 
 	DeviceHandlerList	receive_funcs;
 	recursive_lock		receive_lock;
+	ConditionVariable	receive_handler_idle;
+		// notified when a removed handler is no longer busy
 
-	thread_id			consumer_thread;
-	net_fifo			receive_queue;
+	net_receive_queue*	receive_queues;
+	uint32				receive_queue_count;
+		// received packets are spread over the queues by flow
 };
 
 typedef DoublyLinkedList<net_device_interface> DeviceInterfaceList;
@@ -63,6 +80,10 @@ struct net_device_interface* get_device_interface(const char* name,
 	bool create = true);
 void device_interface_monitor_receive(net_device_interface* interface,
 	net_buffer* buffer);
+status_t device_interface_enqueue_buffer(net_device_interface* interface,
+	net_buffer* buffer);
+status_t get_device_interface_receive_queue_stats(
+	net_device_interface* interface, uint32 index, ifreq_stream_stats* stats);
 status_t up_device_interface(net_device_interface* interface);
 void down_device_interface(net_device_interface* interface);
 
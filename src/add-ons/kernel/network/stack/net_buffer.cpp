@@ -70,6 +70,8 @@ struct data_header {
 	uint8*			data_end;
 	header_space	space;
 	uint16			tail_space;
+	net_buffer_external* external;
+		// if set, the data of this header lives in external memory
 };
 
 struct data_node {
@@ -149,10 +151,12 @@ struct net_buffer_private : net_buffer {
 #define DATA_HEADER_SIZE				_ALIGN(sizeof(data_header))
 #define DATA_NODE_SIZE					_ALIGN(sizeof(data_node))
 #define MAX_FREE_BUFFER_SIZE			(BUFFER_SIZE - DATA_HEADER_SIZE)
+#define MAX_EXTERNAL_NODE_SIZE			32768
 
 
 static object_cache* sNetBufferCache;
 static object_cache* sDataNodeCache;
+static object_cache* sExternalHeaderCache;
 
 
 static status_t append_data(net_buffer* buffer, const void* data, size_t size);
@@ -161,6 +165,8 @@ static status_t remove_header(net_buffer* _buffer, size_t bytes);
 static status_t remove_trailer(net_buffer* _buffer, size_t bytes);
 static status_t append_cloned_data(net_buffer* _buffer, net_buffer* _source,
 					uint32 offset, size_t bytes);
+static status_t append_external_data(net_buffer* _buffer, const void* data,
+					size_t bytes, net_buffer_external* external);
 static status_t read_data(net_buffer* _buffer, size_t offset, void* data,
 					size_t size);
 
@@ -814,6 +820,7 @@ create_data_header(size_t headerSpace)
 	header->tail_space = (uint8*)header + BUFFER_SIZE - header->data_end
 		- headerSpace;
 	header->first_free = NULL;
+	header->external = NULL;
 
 	TRACE(("%d:   create new data header %p\n", find_thread(NULL), header));
 	T2(CreateDataHeader(header));
@@ -821,6 +828,35 @@ create_data_header(size_t headerSpace)
 }
 
 
+/*!	Creates a header that only tracks the references to \a external; it has
+	no space of its own, and is therefore never used to allocate nodes from.
+*/
+static data_header*
+create_external_data_header(net_buffer_external* external)
+{
+	data_header* header = (data_header*)object_cache_alloc(
+		sExternalHeaderCache, 0);
+	if (header == NULL)
+		return NULL;
+
+	header->ref_count = 1;
+	header->physical_address = 0;
+	header->space.size = 0;
+	header->space.free = 0;
+	header->data_end = (uint8*)header + DATA_HEADER_SIZE;
+	header->tail_space = 0;
+	header->first_free = NULL;
+	header->external = external;
+
+	atomic_add(&external->ref_count, 1);
+
+	TRACE(("%d:   create new external data header %p\n", find_thread(NULL),
+		header));
+	T2(CreateDataHeader(header));
+	return header;
+}
+
+
 static void
 release_data_header(data_header* header)
 {
@@ -830,6 +866,16 @@ release_data_header(data_header* header)
 		return;
 
 	TRACE(("%d:   free header %p\n", find_thread(NULL), header));
+
+	net_buffer_external* external = header->external;
+	if (external != NULL) {
+		if (atomic_add(&external->ref_count, -1) == 1)
+			external->free(external);
+
+		object_cache_free(sExternalHeaderCache, header, 0);
+		return;
+	}
+
 	free_data_header(header);
 }
 
@@ -1076,6 +1122,7 @@ copy_metadata(net_buffer* destination, const net_buffer* source)
 
 	destination->msg_flags = source->msg_flags;
 	destination->buffer_flags = source->buffer_flags;
+	destination->segment_size = source->segment_size;
 	destination->interface_address = source->interface_address;
 	if (destination->interface_address != NULL)
 		((InterfaceAddress*)destination->interface_address)->AcquireReference();
@@ -1130,6 +1177,7 @@ create_buffer(size_t headerSpace)
 	buffer->offset = 0;
 	buffer->msg_flags = 0;
 	buffer->buffer_flags = 0;
+	buffer->segment_size = 0;
 	buffer->size = 0;
 
 	CHECK_BUFFER(buffer);
@@ -2011,6 +2059,58 @@ append_cloned_data(net_buffer* _buffer, net_buffer* _source, uint32 offset,
 }
 
 
+/*!	Appends \a bytes of external memory at \a data to the buffer without
+	copying it. The nodes referring to it are read-only, and keep a reference
+	to \a external until they are gone.
+*/
+static status_t
+append_external_data(net_buffer* _buffer, const void* data, size_t bytes,
+	net_buffer_external* external)
+{
+	if (bytes == 0)
+		return B_OK;
+
+	net_buffer_private* buffer = (net_buffer_private*)_buffer;
+	TRACE(("%d: append_external_data(buffer %p, data %p, bytes = %ld)\n",
+		find_thread(NULL), buffer, data, bytes));
+
+	ParanoiaChecker _(buffer);
+
+	data_header* header = create_external_data_header(external);
+	if (header == NULL)
+		return ENOBUFS;
+
+	size_t sizeAppended = 0;
+	while (sizeAppended < bytes) {
+		data_node* node = add_data_node(buffer, header);
+		if (node == NULL) {
+			remove_trailer(buffer, sizeAppended);
+			release_data_header(header);
+			return ENOBUFS;
+		}
+
+		node->offset = buffer->size;
+		node->start = (uint8*)data + sizeAppended;
+		node->used = min_c(bytes - sizeAppended, MAX_EXTERNAL_NODE_SIZE);
+		node->flags = DATA_NODE_READ_ONLY;
+
+		list_add_item(&buffer->buffers, node);
+
+		buffer->size += node->used;
+		sizeAppended += node->used;
+	}
+
+	// the nodes keep the header alive
+	release_data_header(header);
+
+	CHECK_BUFFER(buffer);
+	SET_PARANOIA_CHECK(PARANOIA_SUSPICIOUS, buffer, &buffer->size,
+		sizeof(buffer->size));
+
+	return B_OK;
+}
+
+
 void
 set_ancillary_data(net_buffer* buffer, ancillary_data_container* container)
 {
@@ -2327,6 +2427,14 @@ std_ops(int32 op, ...)
 				return B_NO_MEMORY;
 			}
 
+			sExternalHeaderCache = create_object_cache("external data header "
+				"cache", DATA_HEADER_SIZE, 0);
+			if (sExternalHeaderCache == NULL) {
+				delete_object_cache(sNetBufferCache);
+				delete_object_cache(sDataNodeCache);
+				return B_NO_MEMORY;
+			}
+
 #if ENABLE_STATS
 			add_debugger_command_etc("net_buffer_stats", &dump_net_buffer_stats,
 				"Print net buffer statistics",
@@ -2348,6 +2456,7 @@ std_ops(int32 op, ...)
 #endif
 			delete_object_cache(sNetBufferCache);
 			delete_object_cache(sDataNodeCache);
+			delete_object_cache(sExternalHeaderCache);
 			return B_OK;
 
 		default:
@@ -2380,6 +2489,7 @@ net_buffer_module_info gNetBufferModule = {
 	remove_trailer,
 	trim_data,
 	append_cloned_data,
+	append_external_data,
 
 	NULL,	// associate_data
 
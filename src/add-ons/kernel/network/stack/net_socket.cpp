@@ -44,6 +44,9 @@
 #	define TRACE(x...) ;
 #endif
 
+// number of datagrams passed to the protocol at once
+#define MESSAGE_BATCH_SIZE	32
+
 
 struct net_socket_private;
 typedef DoublyLinkedList<net_socket_private> SocketList;
@@ -316,6 +319,177 @@ socket_receive_no_buffer(net_socket* socket, msghdr* header, void* data,
 }
 
 
+/*!	Copies the data, the ancillary data, and the source address of the
+	received \a buffer into the message, and frees the buffer.
+*/
+static ssize_t
+receive_buffer(net_socket* socket, net_buffer* buffer, msghdr* header,
+	void* data, size_t length, int originalFlags)
+{
+	status_t status;
+
+	// process ancillary data
+	if (header != NULL) {
+		if (buffer != NULL && header->msg_control != NULL) {
+			ancillary_data_container* container
+				= gNetBufferModule.get_ancillary_data(buffer);
+			if (container != NULL)
+				status = process_ancillary_data(socket, container, header);
+			else
+				status = process_ancillary_data(socket, buffer, header);
+			if (status != B_OK) {
+				gNetBufferModule.free(buffer);
+				return status;
+			}
+		} else
+			header->msg_controllen = 0;
+	}
+
+	// TODO: - returning a NULL buffer when received 0 bytes
+	//         may not make much sense as we still need the address
+
+	size_t nameLen = 0;
+	if (header != NULL) {
+		// TODO: - consider the control buffer options
+		nameLen = header->msg_namelen;
+		header->msg_namelen = 0;
+		header->msg_flags = 0;
+	}
+
+	if (buffer == NULL)
+		return 0;
+
+	const size_t bytesReceived = buffer->size;
+	size_t bytesCopied = 0;
+
+	size_t toRead = min_c(bytesReceived, length);
+	status = gNetBufferModule.read(buffer, 0, data, toRead);
+	if (status != B_OK) {
+		gNetBufferModule.free(buffer);
+
+		if (status == B_BAD_ADDRESS)
+			return status;
+		return ENOBUFS;
+	}
+
+	// if first copy was a success, proceed to following copies as required
+	bytesCopied += toRead;
+
+	if (header != NULL) {
+		// We start at iovec[1] as { data, length } is iovec[0].
+		for (int i = 1; i < header->msg_iovlen && bytesCopied < bytesReceived; i++) {
+			iovec& vec = header->msg_iov[i];
+			toRead = min_c(bytesReceived - bytesCopied, vec.iov_len);
+			if (gNetBufferModule.read(buffer, bytesCopied, vec.iov_base,
+					toRead) < B_OK) {
+				break;
+			}
+
+			bytesCopied += toRead;
+		}
+
+		if (header->msg_name != NULL) {
+			header->msg_namelen = min_c(nameLen, buffer->source->sa_len);
+			memcpy(header->msg_name, buffer->source, header->msg_namelen);
+		}
+	}
+
+	gNetBufferModule.free(buffer);
+
+	if (bytesCopied < bytesReceived) {
+		if (header != NULL)
+			header->msg_flags = MSG_TRUNC;
+
+		if ((originalFlags & MSG_TRUNC) != 0)
+			return bytesReceived;
+	}
+
+	return bytesCopied;
+}
+
+
+/*!	Creates a single buffer containing the whole datagram described by
+	\a header, including its ancillary data, ready to be passed to the
+	protocol.
+*/
+static status_t
+create_message_buffer(net_socket* socket, const msghdr& header, int flags,
+	net_buffer** _buffer)
+{
+	const sockaddr* address = (const sockaddr*)header.msg_name;
+	socklen_t addressLength = header.msg_namelen;
+
+	if (addressLength == 0)
+		address = NULL;
+	else if (address == NULL)
+		return B_BAD_VALUE;
+
+	if (socket->peer.ss_len != 0) {
+		if (address != NULL)
+			return EISCONN;
+
+		// socket is connected, we use that address
+		address = (struct sockaddr*)&socket->peer;
+		addressLength = socket->peer.ss_len;
+	}
+
+	if (address == NULL)
+		return EDESTADDRREQ;
+
+	size_t length = 0;
+	for (int i = 0; i < header.msg_iovlen; i++)
+		length += header.msg_iov[i].iov_len;
+	if (length > socket->send.buffer_size)
+		return EMSGSIZE;
+
+	if (socket->address.ss_len == 0) {
+		// try to bind first
+		status_t status = socket_bind(socket, NULL, 0);
+		if (status != B_OK)
+			return status;
+	}
+
+	net_buffer* buffer = gNetBufferModule.create(256);
+	if (buffer == NULL)
+		return ENOBUFS;
+
+	for (int i = 0; i < header.msg_iovlen; i++) {
+		if (gNetBufferModule.append(buffer, header.msg_iov[i].iov_base,
+				header.msg_iov[i].iov_len) != B_OK) {
+			gNetBufferModule.free(buffer);
+			return ENOBUFS;
+		}
+	}
+
+	if (header.msg_control != NULL) {
+		ancillary_data_container* ancillaryData
+			= create_ancillary_data_container();
+		if (ancillaryData == NULL) {
+			gNetBufferModule.free(buffer);
+			return B_NO_MEMORY;
+		}
+
+		// the buffer owns the container from now on
+		gNetBufferModule.set_ancillary_data(buffer, ancillaryData);
+
+		status_t status = add_ancillary_data(socket, ancillaryData,
+			header.msg_control, header.msg_controllen);
+		if (status != B_OK) {
+			gNetBufferModule.free(buffer);
+			return status;
+		}
+	}
+
+	buffer->msg_flags = flags;
+	memcpy(buffer->source, &socket->address, socket->address.ss_len);
+	memcpy(buffer->destination, address, addressLength);
+	buffer->destination->sa_len = addressLength;
+
+	*_buffer = buffer;
+	return B_OK;
+}
+
+
 #if ENABLE_DEBUGGER_COMMANDS
 
 
@@ -1159,83 +1333,7 @@ socket_receive(net_socket* socket, msghdr* header, void* data, size_t length,
 	if (status != B_OK)
 		return status;
 
-	// process ancillary data
-	if (header != NULL) {
-		if (buffer != NULL && header->msg_control != NULL) {
-			ancillary_data_container* container
-				= gNetBufferModule.get_ancillary_data(buffer);
-			if (container != NULL)
-				status = process_ancillary_data(socket, container, header);
-			else
-				status = process_ancillary_data(socket, buffer, header);
-			if (status != B_OK) {
-				gNetBufferModule.free(buffer);
-				return status;
-			}
-		} else
-			header->msg_controllen = 0;
-	}
-
-	// TODO: - returning a NULL buffer when received 0 bytes
-	//         may not make much sense as we still need the address
-
-	size_t nameLen = 0;
-	if (header != NULL) {
-		// TODO: - consider the control buffer options
-		nameLen = header->msg_namelen;
-		header->msg_namelen = 0;
-		header->msg_flags = 0;
-	}
-
-	if (buffer == NULL)
-		return 0;
-
-	const size_t bytesReceived = buffer->size;
-	size_t bytesCopied = 0;
-
-	size_t toRead = min_c(bytesReceived, length);
-	status = gNetBufferModule.read(buffer, 0, data, toRead);
-	if (status != B_OK) {
-		gNetBufferModule.free(buffer);
-
-		if (status == B_BAD_ADDRESS)
-			return status;
-		return ENOBUFS;
-	}
-
-	// if first copy was a success, proceed to following copies as required
-	bytesCopied += toRead;
-
-	if (header != NULL) {
-		// We start at iovec[1] as { data, length } is iovec[0].
-		for (int i = 1; i < header->msg_iovlen && bytesCopied < bytesReceived; i++) {
-			iovec& vec = header->msg_iov[i];
-			toRead = min_c(bytesReceived - bytesCopied, vec.iov_len);
-			if (gNetBufferModule.read(buffer, bytesCopied, vec.iov_base,
-					toRead) < B_OK) {
-				break;
-			}
-
-			bytesCopied += toRead;
-		}
-
-		if (header->msg_name != NULL) {
-			header->msg_namelen = min_c(nameLen, buffer->source->sa_len);
-			memcpy(header->msg_name, buffer->source, header->msg_namelen);
-		}
-	}
-
-	gNetBufferModule.free(buffer);
-
-	if (bytesCopied < bytesReceived) {
-		if (header != NULL)
-			header->msg_flags = MSG_TRUNC;
-
-		if ((originalFlags & MSG_TRUNC) != 0)
-			return bytesReceived;
-	}
-
-	return bytesCopied;
+	return receive_buffer(socket, buffer, header, data, length, originalFlags);
 }
 
 
@@ -1417,6 +1515,278 @@ socket_send(net_socket* socket, msghdr* header, const void* data, size_t length,
 }
 
 
+/*!	Sends the external memory described by \a vecs over the connected
+	\a socket, without copying it into the buffers first. The memory stays
+	referenced by \a external for as long as the protocol keeps the data
+	around, ie. until it has been acknowledged in case of TCP.
+*/
+ssize_t
+socket_send_external(net_socket* socket, const iovec* vecs, size_t vecCount,
+	net_buffer_external* external, int flags)
+{
+	const bool nosignal = ((flags & MSG_NOSIGNAL) != 0);
+	flags &= ~MSG_NOSIGNAL;
+
+	size_t length = 0;
+	for (size_t i = 0; i < vecCount; i++) {
+		if (vecs[i].iov_len > SSIZE_MAX - length)
+			return B_BAD_VALUE;
+		length += vecs[i].iov_len;
+	}
+
+	if (socket->peer.ss_len == 0)
+		return ENOTCONN;
+
+	if (socket->first_info->send_data_no_buffer != NULL) {
+		// the protocol copies the data anyway
+		ssize_t written = socket->first_info->send_data_no_buffer(
+			socket->first_protocol, vecs, vecCount, NULL,
+			(struct sockaddr*)&socket->peer, socket->peer.ss_len, flags);
+
+		if (written == EPIPE && is_syscall() && !nosignal)
+			send_signal(find_thread(NULL), SIGPIPE);
+		return written;
+	}
+
+	size_t bytesLeft = length;
+	ssize_t bytesSent = 0;
+	size_t vecIndex = 0;
+	size_t vecOffset = 0;
+
+	while (bytesLeft > 0) {
+		net_buffer* buffer = gNetBufferModule.create(256);
+		if (buffer == NULL)
+			return bytesSent > 0 ? bytesSent : ENOBUFS;
+
+		// fill the buffer with as many vecs as fit into it
+		size_t bytes = min_c(bytesLeft, socket->send.buffer_size);
+		size_t bytesAppended = 0;
+		while (bytesAppended < bytes) {
+			size_t toAppend = min_c(vecs[vecIndex].iov_len - vecOffset,
+				bytes - bytesAppended);
+			if (gNetBufferModule.append_external(buffer,
+					(uint8*)vecs[vecIndex].iov_base + vecOffset, toAppend,
+					external) != B_OK) {
+				gNetBufferModule.free(buffer);
+				return bytesSent > 0 ? bytesSent : ENOBUFS;
+			}
+
+			bytesAppended += toAppend;
+			vecOffset += toAppend;
+			if (vecOffset == vecs[vecIndex].iov_len) {
+				vecIndex++;
+				vecOffset = 0;
+			}
+		}
+
+		buffer->msg_flags = flags;
+		memcpy(buffer->source, &socket->address, socket->address.ss_len);
+		memcpy(buffer->destination, &socket->peer, socket->peer.ss_len);
+
+		status_t status = socket->first_info->send_data(
+			socket->first_protocol, buffer);
+		if (status != B_OK) {
+			// we only send signals when called from userland
+			if (status == EPIPE && is_syscall() && !nosignal)
+				send_signal(find_thread(NULL), SIGPIPE);
+
+			size_t sizeAfterSend = buffer->size;
+			gNetBufferModule.free(buffer);
+
+			if ((sizeAfterSend != bytes || bytesSent > 0)
+				&& (status == B_INTERRUPTED || status == B_WOULD_BLOCK)) {
+				// this appears to be a partial write
+				return bytesSent + (bytes - sizeAfterSend);
+			}
+			return status;
+		}
+
+		bytesLeft -= bytes;
+		bytesSent += bytes;
+	}
+
+	return bytesSent;
+}
+
+
+/*!	Receives up to \a count messages at once, and stores their sizes in the
+	msg_len fields. Only the first message is waited for; the others are only
+	received if they are already available. Returns the number of messages
+	received, or an error if there was none.
+*/
+ssize_t
+socket_receive_multiple(net_socket* socket, mmsghdr* messages, size_t count,
+	int flags)
+{
+	if (count == 0)
+		return 0;
+
+	const int originalFlags = flags;
+	flags &= ~(MSG_NOSIGNAL | MSG_TRUNC);
+
+	if (socket->first_info->read_data_multiple == NULL
+		|| socket->first_info->read_data_no_buffer != NULL
+		|| (flags & MSG_PEEK) != 0) {
+		// receive the messages one by one
+		size_t received = 0;
+		for (; received < count; received++) {
+			msghdr& header = messages[received].msg_hdr;
+			void* data = NULL;
+			size_t length = 0;
+			if (header.msg_iovlen > 0) {
+				data = header.msg_iov[0].iov_base;
+				length = header.msg_iov[0].iov_len;
+			}
+
+			ssize_t bytesReceived = socket_receive(socket, &header, data,
+				length, received == 0
+					? originalFlags : originalFlags | MSG_DONTWAIT);
+			if (bytesReceived < 0) {
+				if (received == 0)
+					return bytesReceived;
+				break;
+			}
+
+			messages[received].msg_len = bytesReceived;
+		}
+
+		return received;
+	}
+
+	// Let the protocol dequeue as many buffers as possible at once
+
+	net_buffer* buffers[MESSAGE_BATCH_SIZE];
+	size_t received = 0;
+
+	while (received < count) {
+		size_t batchCount = min_c(count - received, MESSAGE_BATCH_SIZE);
+		ssize_t bufferCount = socket->first_info->read_data_multiple(
+			socket->first_protocol,
+			received == 0 ? flags : flags | MSG_DONTWAIT, buffers,
+			batchCount);
+		if (bufferCount < 0) {
+			if (received == 0)
+				return bufferCount;
+			break;
+		}
+
+		for (ssize_t i = 0; i < bufferCount; i++) {
+			msghdr& header = messages[received].msg_hdr;
+			void* data = NULL;
+			size_t length = 0;
+			if (header.msg_iovlen > 0) {
+				data = header.msg_iov[0].iov_base;
+				length = header.msg_iov[0].iov_len;
+			}
+
+			ssize_t bytesReceived = receive_buffer(socket, buffers[i],
+				&header, data, length, originalFlags);
+			if (bytesReceived < 0) {
+				// the remaining messages are lost
+				while (++i < bufferCount)
+					gNetBufferModule.free(buffers[i]);
+
+				if (received == 0)
+					return bytesReceived;
+				return received;
+			}
+
+			messages[received++].msg_len = bytesReceived;
+		}
+
+		if ((size_t)bufferCount < batchCount)
+			break;
+	}
+
+	return received;
+}
+
+
+/*!	Sends up to \a count messages at once, and stores their sizes in the
+	msg_len fields. Returns the number of messages sent, or an error if not
+	even the first one could be sent.
+*/
+ssize_t
+socket_send_multiple(net_socket* socket, mmsghdr* messages, size_t count,
+	int flags)
+{
+	if (count == 0)
+		return 0;
+
+	if (socket->first_info->send_data_multiple == NULL
+		|| socket->first_info->send_data_no_buffer != NULL
+		|| (socket->first_info->flags & NET_PROTOCOL_ATOMIC_MESSAGES) == 0) {
+		// send the messages one by one
+		size_t sent = 0;
+		for (; sent < count; sent++) {
+			msghdr& header = messages[sent].msg_hdr;
+			const void* data = NULL;
+			size_t length = 0;
+			if (header.msg_iovlen > 0) {
+				data = header.msg_iov[0].iov_base;
+				length = header.msg_iov[0].iov_len;
+			}
+
+			ssize_t bytesSent = socket_send(socket, &header, data, length,
+				flags);
+			if (bytesSent < 0) {
+				if (sent == 0)
+					return bytesSent;
+				break;
+			}
+
+			messages[sent].msg_len = bytesSent;
+		}
+
+		return sent;
+	}
+
+	// Every message fits into a single buffer; pass them on to the protocol
+	// in batches
+
+	flags &= ~MSG_NOSIGNAL;
+
+	net_buffer* buffers[MESSAGE_BATCH_SIZE];
+	size_t sizes[MESSAGE_BATCH_SIZE];
+	size_t sent = 0;
+
+	while (sent < count) {
+		size_t batchCount = min_c(count - sent, MESSAGE_BATCH_SIZE);
+		size_t bufferCount = 0;
+		status_t status = B_OK;
+
+		for (; bufferCount < batchCount; bufferCount++) {
+			status = create_message_buffer(socket,
+				messages[sent + bufferCount].msg_hdr, flags,
+				&buffers[bufferCount]);
+			if (status != B_OK)
+				break;
+
+			sizes[bufferCount] = buffers[bufferCount]->size;
+		}
+
+		size_t buffersSent = 0;
+		if (bufferCount > 0) {
+			status_t sendStatus = socket->first_info->send_data_multiple(
+				socket->first_protocol, buffers, bufferCount, &buffersSent);
+			if (sendStatus != B_OK)
+				status = sendStatus;
+
+			for (size_t i = buffersSent; i < bufferCount; i++)
+				gNetBufferModule.free(buffers[i]);
+		}
+
+		for (size_t i = 0; i < buffersSent; i++)
+			messages[sent++].msg_len = sizes[i];
+
+		if (status != B_OK)
+			return sent > 0 ? (ssize_t)sent : status;
+	}
+
+	return sent;
+}
+
+
 status_t
 socket_set_option(net_socket* socket, int level, int option, const void* value,
 	int length)
@@ -1699,8 +2069,12 @@ net_socket_module_info gNetSocketModule = {
 	socket_listen,
 	socket_receive,
 	socket_send,
+	socket_receive_multiple,
+	socket_send_multiple,
 	socket_setsockopt,
 	socket_shutdown,
-	socket_socketpair
+	socket_socketpair,
+
+	socket_send_external
 };
 
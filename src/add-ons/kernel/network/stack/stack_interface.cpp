@@ -119,6 +119,14 @@ stack_interface_recvmsg(net_socket* socket, struct msghdr* message, int flags)
 }
 
 
+static ssize_t
+stack_interface_recvmmsg(net_socket* socket, struct mmsghdr* messages,
+	size_t count, int flags)
+{
+	return gNetSocketModule.receive_multiple(socket, messages, count, flags);
+}
+
+
 static ssize_t
 stack_interface_send(net_socket* socket, const void* data, size_t length,
 	int flags)
@@ -161,6 +169,14 @@ stack_interface_sendmsg(net_socket* socket, const struct msghdr* message,
 }
 
 
+static ssize_t
+stack_interface_sendmmsg(net_socket* socket, struct mmsghdr* messages,
+	size_t count, int flags)
+{
+	return gNetSocketModule.send_multiple(socket, messages, count, flags);
+}
+
+
 static status_t
 stack_interface_getsockopt(net_socket* socket, int level, int option,
 	void* value, socklen_t* _length)
@@ -244,6 +260,15 @@ stack_interface_get_next_socket_stat(int family, uint32* cookie,
 }
 
 
+static ssize_t
+stack_interface_send_external(net_socket* socket, const iovec* vecs,
+	size_t vecCount, net_buffer_external* external, int flags)
+{
+	return gNetSocketModule.send_external(socket, vecs, vecCount, external,
+		flags);
+}
+
+
 static status_t
 stack_interface_std_ops(int32 op, ...)
 {
@@ -279,10 +304,12 @@ net_stack_interface_module_info gNetStackInterfaceModule = {
 	&stack_interface_recv,
 	&stack_interface_recvfrom,
 	&stack_interface_recvmsg,
+	&stack_interface_recvmmsg,
 
 	&stack_interface_send,
 	&stack_interface_sendto,
 	&stack_interface_sendmsg,
+	&stack_interface_sendmmsg,
 
 	&stack_interface_getsockopt,
 	&stack_interface_setsockopt,
@@ -298,5 +325,7 @@ net_stack_interface_module_info gNetStackInterfaceModule = {
 	&stack_interface_select,
 	&stack_interface_deselect,
 
-	&stack_interface_get_next_socket_stat
+	&stack_interface_get_next_socket_stat,
+
+	&stack_interface_send_external
 };
@@ -13,6 +13,7 @@
 #include "StreamingRingBuffer.h"
 
 #include <Application.h>
+#include <AutoDeleter.h>
 #include <Autolock.h>
 #include <Bitmap.h>
 #include <Message.h>
@@ -39,11 +40,48 @@ static const uint8 kCursorData[] = { 16 /* size, 16x16 */,
 };
 
 
+static const uint32 kBitmapCacheSize = 32 * 1024 * 1024;
+
+
 #define TRACE(x...)				/*printf("RemoteView: " x)*/
 #define TRACE_ALWAYS(x...)		printf("RemoteView: " x)
 #define TRACE_ERROR(x...)		printf("RemoteView: " x)
 
 
+//!	Decompresses PackBits data, and returns whether it filled \a target.
+static bool
+unpack_bits(const uint8 *source, size_t sourceLength, uint8 *target,
+	size_t targetLength)
+{
+	size_t position = 0;
+	while (sourceLength > 0) {
+		int8 header = (int8)*source++;
+		sourceLength--;
+
+		if (header >= 0) {
+			size_t length = header + 1;
+			if (length > sourceLength || position + length > targetLength)
+				return false;
+
+			memcpy(target + position, source, length);
+			source += length;
+			sourceLength -= length;
+			position += length;
+		} else if (header != -128) {
+			size_t length = 1 - header;
+			if (sourceLength == 0 || position + length > targetLength)
+				return false;
+
+			memset(target + position, *source++, length);
+			sourceLength--;
+			position += length;
+		}
+	}
+
+	return position == targetLength;
+}
+
+
 typedef struct engine_state {
 	uint32		token;
 	BView *		view;
@@ -69,7 +107,8 @@ RemoteView::RemoteView(BRect frame, const char *remoteHost, uint16 remotePort)
 	fOffscreen(NULL),
 	fViewCursor(kCursorData),
 	fCursorBitmap(NULL),
-	fCursorVisible(false)
+	fCursorVisible(false),
+	fCachedBitmaps(NULL)
 {
 	fReceiveBuffer = new(std::nothrow) StreamingRingBuffer(16 * 1024);
 	if (fReceiveBuffer == NULL) {
@@ -173,6 +212,12 @@ RemoteView::~RemoteView()
 
 	int32 result;
 	wait_for_thread(fDrawThread, &result);
+
+	if (fCachedBitmaps != NULL) {
+		for (int32 i = 0; i < kMaxCachedBitmaps; i++)
+			delete fCachedBitmaps[i];
+		delete[] fCachedBitmaps;
+	}
 }
 
 
@@ -442,7 +487,14 @@ RemoteView::_DrawThread()
 	// cursor
 	BPoint cursorHotSpot(0, 0);
 
+	// keeping bitmaps around is optional, the server sends them as is if we
+	// don't ask for it
+	fCachedBitmaps = new(std::nothrow) BBitmap*[kMaxCachedBitmaps];
+	if (fCachedBitmaps != NULL)
+		memset(fCachedBitmaps, 0, kMaxCachedBitmaps * sizeof(BBitmap*));
+
 	reply.Start(RP_INIT_CONNECTION);
+	reply.Add(fCachedBitmaps != NULL ? kBitmapCacheSize : (uint32)0);
 	reply.Flush();
 
 	while (!fStopThread) {
@@ -484,6 +536,14 @@ RemoteView::_DrawThread()
 				continue;
 			}
 
+			case RP_CACHE_BITMAP:
+			{
+				if (_ReadCachedBitmap(message) != B_OK)
+					TRACE_ERROR("failed to read cached bitmap\n");
+
+				continue;
+			}
+
 			case RP_CREATE_STATE:
 			case RP_DELETE_STATE:
 			{
@@ -774,6 +834,27 @@ RemoteView::_DrawThread()
 				break;
 			}
 
+			case RP_DRAW_CACHED_BITMAP:
+			{
+				BRect bitmapRect, viewRect;
+				uint32 options;
+				int32 slot;
+
+				message.Read(bitmapRect);
+				message.Read(viewRect);
+				message.Read(options);
+				if (message.Read(slot) != B_OK || fCachedBitmaps == NULL
+					|| slot < 0 || slot >= kMaxCachedBitmaps
+					|| fCachedBitmaps[slot] == NULL) {
+					continue;
+				}
+
+				offscreen->DrawBitmap(fCachedBitmaps[slot], bitmapRect,
+					viewRect, options);
+				invalidRegion.Include(viewRect);
+				break;
+			}
+
 			case RP_DRAW_BITMAP_RECTS:
 			{
 				color_space colorSpace;
@@ -1328,3 +1409,101 @@ RemoteView::_BuildInvalidateRect(BPoint *points, int32 pointCount)
 
 	return bounds;
 }
+
+
+/*!	Reads a bitmap the server wants us to keep. It may be based on another
+	one we already have, and then only contains the parts that changed.
+*/
+status_t
+RemoteView::_ReadCachedBitmap(RemoteMessage &message)
+{
+	int32 slot, baseSlot, width, height, bytesPerRow, tileCount;
+	color_space colorSpace;
+	uint32 flags;
+
+	message.Read(slot);
+	message.Read(baseSlot);
+	message.Read(width);
+	message.Read(height);
+	message.Read(bytesPerRow);
+	message.Read(colorSpace);
+	message.Read(flags);
+	status_t result = message.Read(tileCount);
+	if (result != B_OK)
+		return result;
+
+	if (fCachedBitmaps == NULL || slot < 0 || slot >= kMaxCachedBitmaps
+		|| baseSlot >= kMaxCachedBitmaps || baseSlot == slot) {
+		return B_BAD_VALUE;
+	}
+
+	// whatever happens, the previous contents of the slot are outdated
+	BBitmap *base = baseSlot >= 0 ? fCachedBitmaps[baseSlot] : NULL;
+	delete fCachedBitmaps[slot];
+	fCachedBitmaps[slot] = NULL;
+
+	if (baseSlot >= 0 && base == NULL)
+		return B_BAD_DATA;
+
+	BBitmap *bitmap = new(std::nothrow) BBitmap(
+		BRect(0, 0, width - 1, height - 1), flags, colorSpace, bytesPerRow);
+	ObjectDeleter<BBitmap> bitmapDeleter(bitmap);
+	if (bitmap == NULL)
+		return B_NO_MEMORY;
+
+	result = bitmap->InitCheck();
+	if (result != B_OK)
+		return result;
+
+	if (bitmap->BytesPerRow() != bytesPerRow)
+		return B_BAD_DATA;
+
+	uint8 *bits = (uint8 *)bitmap->Bits();
+	if (base != NULL) {
+		if (base->BitsLength() != bitmap->BitsLength())
+			return B_BAD_DATA;
+
+		memcpy(bits, base->Bits(), bitmap->BitsLength());
+	}
+
+	for (int32 i = 0; i < tileCount; i++) {
+		int32 x, y, tileWidth, tileHeight;
+		uint32 packedSize;
+
+		message.Read(x);
+		message.Read(y);
+		message.Read(tileWidth);
+		message.Read(tileHeight);
+		result = message.Read(packedSize);
+		if (result != B_OK)
+			return result;
+
+		if (x < 0 || y < 0 || tileWidth <= 0 || tileHeight <= 0
+			|| tileWidth > bytesPerRow - x || tileHeight > height - y
+			|| packedSize > message.DataLeft()) {
+			return B_BAD_DATA;
+		}
+
+		size_t tileSize = (size_t)tileWidth * tileHeight;
+		uint8 *buffer = (uint8 *)malloc(tileSize + packedSize);
+		MemoryDeleter bufferDeleter(buffer);
+		if (buffer == NULL)
+			return B_NO_MEMORY;
+
+		uint8 *packed = buffer + tileSize;
+		result = message.ReadData(packed, packedSize);
+		if (result != B_OK)
+			return result;
+
+		if (!unpack_bits(packed, packedSize, buffer, tileSize))
+			return B_BAD_DATA;
+
+		for (int32 row = 0; row < tileHeight; row++) {
+			memcpy(bits + (y + row) * bytesPerRow + x, buffer + row * tileWidth,
+				tileWidth);
+		}
+	}
+
+	fCachedBitmaps[slot] = bitmapDeleter.Detach();
+	return B_OK;
+}
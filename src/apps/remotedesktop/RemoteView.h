@@ -16,6 +16,7 @@
 class BBitmap;
 class NetReceiver;
 class NetSender;
+class RemoteMessage;
 class StreamingRingBuffer;
 
 struct engine_state;
@@ -61,6 +62,8 @@ static	int32						_DrawEntry(void *data);
 		BRect						_BuildInvalidateRect(BPoint *points,
 										int32 pointCount);
 
+		status_t					_ReadCachedBitmap(RemoteMessage &message);
+
 		status_t					fInitStatus;
 		bool						fIsConnected;
 
@@ -82,6 +85,8 @@ static	int32						_DrawEntry(void *data);
 		bool						fCursorVisible;
 
 		BObjectList<engine_state>	fStates;
+
+		BBitmap **					fCachedBitmaps;
 };
 
 #endif // REMOTE_VIEW_H
@@ -571,10 +571,29 @@ BasicTerminalBuffer::Find(const char* _pattern, const TermPos& start,
 			std::swap(pattern[i], pattern[patternLen - i - 1]);
 	}
 
+	// Between lines, skip the parts of the history that cannot contain the
+	// pattern -- unless it spans a hard line break.
+	HistoryBuffer::CharacterMask patternCharacters;
+	bool skipHistory = fHistory != NULL;
+	for (int32 i = 0; i < patternLen; i++) {
+		if (pattern[i].bytes[0] == '\n')
+			skipHistory = false;
+		patternCharacters.Add(pattern[i].bytes, pattern[i].ByteCount());
+	}
+
 	// search loop
 	int32 matchIndex = 0;
 	TermPos matchStart;
 	while (true) {
+		if (skipHistory && matchIndex == 0 && pos.x == 0) {
+			if (forward && pos.y < 0) {
+				pos.y = -fHistory->SkipLines(-pos.y - 1, false,
+					patternCharacters) - 1;
+			} else if (!forward && pos.y <= 0) {
+				pos.y = -fHistory->SkipLines(-pos.y, true, patternCharacters);
+			}
+		}
+
 //debug_printf("    (%ld, %ld): matchIndex: %ld\n", pos.x, pos.y, matchIndex);
 		TermPos previousPos(pos);
 		UTF8Char c;
@@ -664,6 +683,73 @@ BasicTerminalBuffer::InsertChar(UTF8Char c)
 }
 
 
+/*!	Inserts a run of printable characters, with the same result as calling
+	InsertChar() for each of them, but invalidates each line only once.
+	\a text must consist of complete UTF-8 characters.
+*/
+void
+BasicTerminalBuffer::InsertChars(const char* text, int32 length)
+{
+	const char* end = text + length;
+
+	if (!fOverwriteMode) {
+		// every character needs its own gap
+		while (text < end) {
+			UTF8Char c(text);
+			text += c.ByteCount();
+			InsertChar(c);
+		}
+		return;
+	}
+
+	TerminalLine* line = NULL;
+	while (text < end) {
+		UTF8Char c(text);
+		int32 width = HALF_WIDTH;
+		if ((uchar)*text < 0x80)
+			text++;
+		else {
+			text += c.ByteCount();
+			if (c.IsFullWidth())
+				width = FULL_WIDTH;
+		}
+
+		if (fSoftWrappedCursor || (fCursor.x + width) > fWidth) {
+			if (line != NULL)
+				_Invalidate(fCursor.y, fCursor.y);
+			_SoftBreakLine();
+			line = NULL;
+		}
+
+		if (line == NULL) {
+			_PadLineToCursor();
+			line = _LineAt(fCursor.y);
+		}
+
+		fSoftWrappedCursor = false;
+
+		TerminalCell& cell = line->cells[fCursor.x];
+		cell.character = c;
+		cell.attributes = fAttributes;
+		cell.attributes.state |= (width == FULL_WIDTH ? A_WIDTH : 0);
+
+		if (line->length < fCursor.x + width)
+			line->length = fCursor.x + width;
+
+		fCursor.x += width;
+		if (fCursor.x == fWidth) {
+			fCursor.x -= width;
+			fSoftWrappedCursor = true;
+		}
+
+		fLast = c;
+	}
+
+	if (line != NULL)
+		_Invalidate(fCursor.y, fCursor.y);
+}
+
+
 void
 BasicTerminalBuffer::FillScreen(UTF8Char c, Attributes &attributes)
 {
@@ -131,6 +131,7 @@ public:
 
 			// insert chars/lines
 			void				InsertChar(UTF8Char c);
+			void				InsertChars(const char* text, int32 length);
 			void				FillScreen(UTF8Char c, Attributes &attr);
 
 			void				InsertCR();
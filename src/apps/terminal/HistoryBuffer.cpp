@@ -1,5 +1,5 @@
 /*
- * Copyright 2013, Haiku, Inc. All rights reserved.
+ * Copyright 2013-2026, Haiku, Inc. All rights reserved.
  * Copyright 2008, Ingo Weinhold, ingo_weinhold@gmx.de.
  * Distributed under the terms of the MIT License.
  *
@@ -10,13 +10,116 @@
 
 #include "HistoryBuffer.h"
 
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
 #include <new>
 
+#include <FindDirectory.h>
 #include <OS.h>
+#include <Path.h>
+
+#include <zlib.h>
 
 #include "TermConst.h"
 
 
+static const int32 kMaxRingLines = 4096;
+static const int32 kBlockLines = 256;
+static const int32 kCacheEntries = 4;
+static const size_t kMaxCompressedSize = 8 * 1024 * 1024;
+static const size_t kSpillSegmentSize = 4 * 1024 * 1024;
+
+
+/*!	A line as it is stored in a block: the header is followed by the
+	attributes runs and the characters, and padded to a multiple of 4 bytes.
+*/
+struct stored_line {
+	Attributes		attributes;
+	uint16			attributesRunCount;
+	uint16			byteLength : 15;
+	bool			softBreak : 1;
+};
+
+
+struct HistoryBuffer::Block {
+	uint8*			data;
+	uint32			compressedSize;
+	uint32			size;
+	int32			spillSegment;
+	CharacterMask	characters;
+	bool			joined;
+		// the block is soft broken into one of its neighbours
+};
+
+
+struct HistoryBuffer::CacheEntry {
+	int64			serial;
+	int32			lastUsed;
+	uint8*			data;
+	size_t			allocated;
+	uint32			lineOffsets[kBlockLines];
+
+	CacheEntry()
+		:
+		serial(-1),
+		lastUsed(0),
+		data(NULL),
+		allocated(0)
+	{
+	}
+
+	~CacheEntry()
+	{
+		free(data);
+	}
+};
+
+
+struct HistoryBuffer::SpillSegment {
+	uint8*			address;
+	size_t			used;
+	int32			blockCount;
+};
+
+
+static inline size_t
+stored_line_size(int32 attributesRuns, int32 byteLength)
+{
+	return (sizeof(stored_line) + attributesRuns * sizeof(AttributesRun)
+		+ byteLength + 3) & ~(size_t)3;
+}
+
+
+static void
+add_characters(HistoryBuffer::CharacterMask& characters, const char* chars,
+	int32 length)
+{
+	// Searches may ignore case, so the lower case variant of each character
+	// is added as well.
+	for (int32 i = 0; i < length;) {
+		if ((uint8)chars[i] < 0x80) {
+			char lower = tolower(chars[i]);
+			characters.Add(chars + i, 1);
+			characters.Add(&lower, 1);
+			i++;
+			continue;
+		}
+
+		int32 charLength = min_c(UTF8Char::ByteCount(chars[i]), length - i);
+		UTF8Char lower = UTF8Char(chars + i, charLength).ToLower();
+		characters.Add(chars + i, charLength);
+		characters.Add(lower.bytes, lower.ByteCount());
+		i += charLength;
+	}
+}
+
+
+//	#pragma mark -
+
+
 HistoryBuffer::HistoryBuffer()
 	:
 	fLines(NULL),
@@ -24,17 +127,54 @@ HistoryBuffer::HistoryBuffer()
 	fCapacity(0),
 	fNextLine(0),
 	fSize(0),
+	fRingCapacity(0),
+	fRingSize(0),
 	fBuffer(NULL),
 	fBufferSize(0),
-	fBufferAllocationOffset(0)
+	fBufferAllocationOffset(0),
+	fBlocks(NULL),
+	fBlockCapacity(0),
+	fFirstBlock(0),
+	fBlockCount(0),
+	fFirstBlockSerial(0),
+	fStoredSize(0),
+	fStoredSkip(0),
+	fCompressedSize(0),
+	fOpenBlock(NULL),
+	fOpenBlockSize(0),
+	fOpenBlockAllocated(0),
+	fOpenLineOffsets(NULL),
+	fOpenLineCount(0),
+	fOpenJoinedToPrevious(false),
+	fLastSoftBreak(false),
+	fCache(NULL),
+	fCacheClock(0),
+	fSpillFile(-1),
+	fSpillSegments(NULL),
+	fSpillSegmentCount(0),
+	fCurrentSpillSegment(-1),
+	fSpilledBlocks(0),
+	fSpillFailed(false)
 {
 }
 
 
 HistoryBuffer::~HistoryBuffer()
 {
+	_RemoveBlocks(fBlockCount);
+
 	delete[] fLines;
 	delete[] fBuffer;
+	delete[] fBlocks;
+	delete[] fCache;
+	delete[] fOpenLineOffsets;
+	free(fOpenBlock);
+
+	for (int32 i = 0; i < fSpillSegmentCount; i++)
+		munmap(fSpillSegments[i].address, kSpillSegmentSize);
+	free(fSpillSegments);
+	if (fSpillFile >= 0)
+		close(fSpillFile);
 }
 
 
@@ -44,13 +184,23 @@ HistoryBuffer::Init(int32 width, int32 capacity)
 	if (width <= 0 || capacity <= 0)
 		return B_BAD_VALUE;
 
-	int32 bufferSize = (width + 4) * capacity;
+	int32 ringCapacity = min_c(capacity, kMaxRingLines);
+	int32 bufferSize = (width + 4) * ringCapacity;
+
+	fLines = new(std::nothrow) HistoryLine[ringCapacity];
+	fBuffer = new(std::nothrow) uint8[bufferSize];
 
-	if (capacity > 0) {
-		fLines = new(std::nothrow) HistoryLine[capacity];
-		fBuffer = new(std::nothrow) uint8[bufferSize];
+	if (fLines == NULL || fBuffer == NULL)
+		return B_NO_MEMORY;
 
-		if (fLines == NULL || fBuffer == NULL)
+	if (capacity > ringCapacity) {
+		// the lines that don't fit into the ring buffer are stored in blocks
+		fBlockCapacity = capacity / kBlockLines + 1;
+		fBlocks = new(std::nothrow) Block[fBlockCapacity];
+		fCache = new(std::nothrow) CacheEntry[kCacheEntries];
+		fOpenLineOffsets = new(std::nothrow) uint32[kBlockLines];
+
+		if (fBlocks == NULL || fCache == NULL || fOpenLineOffsets == NULL)
 			return B_NO_MEMORY;
 	}
 
@@ -58,6 +208,8 @@ HistoryBuffer::Init(int32 width, int32 capacity)
 	fCapacity = capacity;
 	fNextLine = 0;
 	fSize = 0;
+	fRingCapacity = ringCapacity;
+	fRingSize = 0;
 	fBufferSize = bufferSize;
 	fBufferAllocationOffset = 0;
 
@@ -68,12 +220,32 @@ HistoryBuffer::Init(int32 width, int32 capacity)
 void
 HistoryBuffer::Clear()
 {
+	_DropStoredLines(fStoredSize);
+
 	fNextLine = 0;
 	fSize = 0;
+	fRingSize = 0;
 	fBufferAllocationOffset = 0;
 }
 
 
+/*!	Returns the line at \a index, counting from the most recent one. If the
+	line had to be decompressed, the returned line is only valid until the
+	next call.
+*/
+HistoryLine*
+HistoryBuffer::LineAt(int32 index) const
+{
+	if (index < 0 || index >= fSize)
+		return NULL;
+
+	if (index < fRingSize)
+		return _LineAt(index);
+
+	return _StoredLineAt(fSize - index - 1);
+}
+
+
 TerminalLine*
 HistoryBuffer::GetTerminalLineAt(int32 index, TerminalLine* buffer) const
 {
@@ -93,7 +265,7 @@ HistoryBuffer::GetTerminalLineAt(int32 index, TerminalLine* buffer) const
 	for (int32 i = 0; i < line->byteLength;) {
 		// get attributes
 		if (charCount == nextAttributesAt) {
-			if (charCount < attributesRun->offset) {
+			if (attributesRunCount > 0 && charCount < attributesRun->offset) {
 				// the "hole" in attributes run
 				attributes.Reset();
 				nextAttributesAt = attributesRun->offset;
@@ -135,6 +307,42 @@ HistoryBuffer::GetTerminalLineAt(int32 index, TerminalLine* buffer) const
 }
 
 
+/*!	Starting at line \a index, skips all lines in the direction given by
+	\a older that are part of a block which cannot contain all of
+	\a characters, and returns the index of the first line that may.
+	Blocks that are soft broken into a neighbour are never skipped, so that
+	no match across them is lost.
+*/
+int32
+HistoryBuffer::SkipLines(int32 index, bool older,
+	const CharacterMask& characters) const
+{
+	while (index >= fRingSize && index < fSize) {
+		int32 blockIndex = (fStoredSkip + fSize - index - 1) / kBlockLines;
+		if (blockIndex == fBlockCount) {
+			if (fOpenJoinedToPrevious || fLastSoftBreak
+				|| fOpenCharacters.Contains(characters)) {
+				break;
+			}
+		} else {
+			const Block& block
+				= fBlocks[(fFirstBlock + blockIndex) % fBlockCapacity];
+			if (block.joined || block.characters.Contains(characters))
+				break;
+		}
+
+		// continue with the first line beyond the block
+		int32 oldestLine = fSize - 1 - (blockIndex * kBlockLines - fStoredSkip);
+		if (older)
+			index = min_c(oldestLine + 1, fSize);
+		else
+			index = max_c(oldestLine - kBlockLines, fRingSize - 1);
+	}
+
+	return index;
+}
+
+
 void
 HistoryBuffer::AddLine(const TerminalLine* line)
 {
@@ -219,33 +427,44 @@ HistoryBuffer::AddEmptyLines(int32 count)
 	if (count + fSize > fCapacity)
 		DropLines(count + fSize - fCapacity);
 
-	// All lines use the same buffer address, since they don't use any memory.
-	AttributesRun* attributesRun
-		= (AttributesRun*)(fBuffer + fBufferAllocationOffset);
-
 	for (int32 i = 0; i < count; i++) {
+		if (fRingSize == fRingCapacity)
+			_EvictLines(1);
+
+		// All lines use the same buffer address, since they don't use any
+		// memory.
 		HistoryLine* line = &fLines[fNextLine];
-		fNextLine = (fNextLine + 1) % fCapacity;
-		line->attributesRuns = attributesRun;
+		fNextLine = (fNextLine + 1) % fRingCapacity;
+		line->attributesRuns
+			= (AttributesRun*)(fBuffer + fBufferAllocationOffset);
 		line->attributesRunCount = 0;
 		line->byteLength = 0;
 		line->softBreak = false;
-	}
 
-	fSize += count;
+		fRingSize++;
+		fSize++;
+	}
 }
 
 
+/*!	Drops the \a count oldest lines.
+*/
 void
 HistoryBuffer::DropLines(int32 count)
 {
 	if (count <= 0)
 		return;
 
-	if (count < fSize) {
-		fSize -= count;
-	} else {
-		fSize = 0;
+	if (count > fSize)
+		count = fSize;
+
+	int32 storedCount = min_c(count, fStoredSize);
+	_DropStoredLines(storedCount);
+
+	fRingSize -= count - storedCount;
+	fSize -= count;
+
+	if (fRingSize == 0) {
 		fNextLine = 0;
 		fBufferAllocationOffset = 0;
 	}
@@ -255,17 +474,20 @@ HistoryBuffer::DropLines(int32 count)
 HistoryLine*
 HistoryBuffer::_AllocateLine(int32 attributesRuns, int32 byteLength)
 {
-	// we need at least one spare line slot
-	int32 toDrop = 0;
 	if (fSize == fCapacity)
-		toDrop = 1;
+		DropLines(1);
+
+	// we need at least one spare line slot
+	int32 toEvict = 0;
+	if (fRingSize == fRingCapacity)
+		toEvict = 1;
 
 	int32 bytesNeeded = attributesRuns * sizeof(AttributesRun) + byteLength;
 
 	if (fBufferAllocationOffset + bytesNeeded > fBufferSize) {
-		// drop all lines after the allocation index
-		for (; toDrop < fSize; toDrop++) {
-			HistoryLine* line = _LineAt(fSize - toDrop - 1);
+		// evict all lines after the allocation index
+		for (; toEvict < fRingSize; toEvict++) {
+			HistoryLine* line = _LineAt(fRingSize - toEvict - 1);
 			int32 offset = (uint8*)line->AttributesRuns() - fBuffer;
 			if (offset < fBufferAllocationOffset)
 				break;
@@ -274,30 +496,378 @@ HistoryBuffer::_AllocateLine(int32 attributesRuns, int32 byteLength)
 		fBufferAllocationOffset = 0;
 	}
 
-	// drop all lines interfering
+	// evict all lines interfering; empty lines may sit right at the
+	// allocation index, with other lines following them
 	int32 nextOffset = (fBufferAllocationOffset + bytesNeeded + 1) & ~1;
-	for (; toDrop < fSize; toDrop++) {
-		HistoryLine* line = _LineAt(fSize - toDrop - 1);
+	for (; toEvict < fRingSize; toEvict++) {
+		HistoryLine* line = _LineAt(fRingSize - toEvict - 1);
 		int32 offset = (uint8*)line->AttributesRuns() - fBuffer;
-		if (offset + line->BufferSize() <= fBufferAllocationOffset
-				|| offset >= nextOffset) {
+		if (offset < fBufferAllocationOffset || offset >= nextOffset)
 			break;
-		}
 	}
 
-	DropLines(toDrop);
+	_EvictLines(toEvict);
 
 	// init the line
 	HistoryLine* line = &fLines[fNextLine];
-	fNextLine = (fNextLine + 1) % fCapacity;
+	fNextLine = (fNextLine + 1) % fRingCapacity;
+	fRingSize++;
 	fSize++;
 	line->attributesRuns = (AttributesRun*)(fBuffer + fBufferAllocationOffset);
 	line->attributesRunCount = attributesRuns;
 	line->byteLength = byteLength;
 
 	fBufferAllocationOffset = (fBufferAllocationOffset + bytesNeeded + 1) & ~1;
-		// DropLines() may have changed fBufferAllocationOffset, so don't use
-		// nextOffset.
+		// _EvictLines() may have changed fBufferAllocationOffset, so don't
+		// use nextOffset.
 
 	return line;
 }
+
+
+/*!	Moves the \a count oldest lines out of the ring buffer, and into the
+	open block, if there is one. Otherwise, they are dropped.
+*/
+void
+HistoryBuffer::_EvictLines(int32 count)
+{
+	for (; count > 0 && fRingSize > 0; count--) {
+		HistoryLine* line = _LineAt(fRingSize - 1);
+		fRingSize--;
+
+		if (fBlocks == NULL || _StoreLine(line) != B_OK) {
+			// we can't keep the line, and so neither the ones before it
+			fSize--;
+			DropLines(fStoredSize);
+		}
+	}
+
+	if (fRingSize == 0) {
+		fNextLine = 0;
+		fBufferAllocationOffset = 0;
+	}
+}
+
+
+/*!	Returns the stored line at \a index, counting from the oldest one.
+*/
+HistoryLine*
+HistoryBuffer::_StoredLineAt(int32 index) const
+{
+	int32 position = fStoredSkip + index;
+	int32 blockIndex = position / kBlockLines;
+
+	const uint8* data;
+	if (blockIndex == fBlockCount)
+		data = fOpenBlock + fOpenLineOffsets[position % kBlockLines];
+	else {
+		const CacheEntry* entry = _CachedBlock(blockIndex);
+		if (entry == NULL)
+			return NULL;
+
+		data = entry->data + entry->lineOffsets[position % kBlockLines];
+	}
+
+	const stored_line* storedLine = (const stored_line*)data;
+	fStoredLine.attributesRuns = (AttributesRun*)(storedLine + 1);
+	fStoredLine.attributesRunCount = storedLine->attributesRunCount;
+	fStoredLine.byteLength = storedLine->byteLength;
+	fStoredLine.softBreak = storedLine->softBreak;
+	fStoredLine.attributes = storedLine->attributes;
+
+	return &fStoredLine;
+}
+
+
+status_t
+HistoryBuffer::_StoreLine(const HistoryLine* line)
+{
+	size_t lineSize = stored_line_size(line->attributesRunCount,
+		line->byteLength);
+	if (fOpenBlockSize + lineSize > fOpenBlockAllocated) {
+		size_t allocated = max_c(fOpenBlockAllocated * 2,
+			max_c(fOpenBlockSize + lineSize, kBlockLines * (size_t)fWidth));
+		uint8* block = (uint8*)realloc(fOpenBlock, allocated);
+		if (block == NULL)
+			return B_NO_MEMORY;
+
+		fOpenBlock = block;
+		fOpenBlockAllocated = allocated;
+	}
+
+	stored_line* storedLine = (stored_line*)(fOpenBlock + fOpenBlockSize);
+	storedLine->attributes = line->attributes;
+	storedLine->attributesRunCount = line->attributesRunCount;
+	storedLine->byteLength = line->byteLength;
+	storedLine->softBreak = line->softBreak;
+
+	uint8* data = (uint8*)(storedLine + 1);
+	memcpy(data, line->AttributesRuns(), line->BufferSize());
+	memset(data + line->BufferSize(), 0,
+		lineSize - sizeof(stored_line) - line->BufferSize());
+
+	if (fOpenLineCount == 0) {
+		fOpenCharacters.Clear();
+		fOpenJoinedToPrevious = fLastSoftBreak;
+	}
+	add_characters(fOpenCharacters, line->Chars(), line->byteLength);
+
+	fOpenLineOffsets[fOpenLineCount++] = fOpenBlockSize;
+	fOpenBlockSize += lineSize;
+	fLastSoftBreak = line->softBreak;
+	fStoredSize++;
+
+	if (fOpenLineCount == kBlockLines && _CloseBlock() != B_OK) {
+		// without the block, the lines before it are useless
+		DropLines(fStoredSize);
+	}
+
+	return B_OK;
+}
+
+
+/*!	Compresses the open block, and appends it to the other blocks.
+*/
+status_t
+HistoryBuffer::_CloseBlock()
+{
+	uLongf compressedSize = compressBound(fOpenBlockSize);
+	uint8* data = (uint8*)malloc(compressedSize);
+	if (data == NULL)
+		return B_NO_MEMORY;
+
+	if (compress2(data, &compressedSize, fOpenBlock, fOpenBlockSize,
+			Z_BEST_SPEED) != Z_OK) {
+		free(data);
+		return B_ERROR;
+	}
+
+	// compressBound() is generous, give back what we didn't need
+	uint8* shrunkData = (uint8*)realloc(data, compressedSize);
+	if (shrunkData != NULL)
+		data = shrunkData;
+
+	// There is always room for another block, as long as the lines in it
+	// fit into the capacity.
+	Block& block = fBlocks[(fFirstBlock + fBlockCount) % fBlockCapacity];
+	block.data = data;
+	block.compressedSize = compressedSize;
+	block.size = fOpenBlockSize;
+	block.spillSegment = -1;
+	block.characters = fOpenCharacters;
+	block.joined = fOpenJoinedToPrevious || fLastSoftBreak;
+
+	fBlockCount++;
+	fCompressedSize += compressedSize;
+
+	fOpenBlockSize = 0;
+	fOpenLineCount = 0;
+
+	_SpillBlocks();
+	return B_OK;
+}
+
+
+/*!	Drops the \a count oldest stored lines. Blocks are only freed when all
+	of their lines are gone.
+*/
+void
+HistoryBuffer::_DropStoredLines(int32 count)
+{
+	if (count <= 0)
+		return;
+
+	fStoredSize -= count;
+	if (fStoredSize == 0) {
+		_RemoveBlocks(fBlockCount);
+		fStoredSkip = 0;
+		fOpenBlockSize = 0;
+		fOpenLineCount = 0;
+		return;
+	}
+
+	fStoredSkip += count;
+	int32 blocks = min_c(fStoredSkip / kBlockLines, fBlockCount);
+	_RemoveBlocks(blocks);
+	fStoredSkip -= blocks * kBlockLines;
+}
+
+
+void
+HistoryBuffer::_RemoveBlocks(int32 count)
+{
+	for (int32 i = 0; i < count; i++) {
+		Block& block = fBlocks[fFirstBlock];
+		if (block.spillSegment >= 0) {
+			SpillSegment& segment = fSpillSegments[block.spillSegment];
+			if (--segment.blockCount == 0)
+				segment.used = 0;
+			fSpilledBlocks--;
+		} else {
+			free(block.data);
+			fCompressedSize -= block.compressedSize;
+		}
+
+		fFirstBlock = (fFirstBlock + 1) % fBlockCapacity;
+		fBlockCount--;
+		fFirstBlockSerial++;
+	}
+}
+
+
+/*!	Returns the decompressed contents of the block at \a blockIndex, either
+	from the cache, or by replacing the least recently used cache entry.
+*/
+const HistoryBuffer::CacheEntry*
+HistoryBuffer::_CachedBlock(int32 blockIndex) const
+{
+	int64 serial = fFirstBlockSerial + blockIndex;
+
+	CacheEntry* leastRecentlyUsed = &fCache[0];
+	for (int32 i = 0; i < kCacheEntries; i++) {
+		CacheEntry& entry = fCache[i];
+		if (entry.serial == serial) {
+			entry.lastUsed = ++fCacheClock;
+			return &entry;
+		}
+		if (entry.lastUsed < leastRecentlyUsed->lastUsed)
+			leastRecentlyUsed = &entry;
+	}
+
+	const Block& block = fBlocks[(fFirstBlock + blockIndex) % fBlockCapacity];
+	CacheEntry& entry = *leastRecentlyUsed;
+	entry.serial = -1;
+
+	if (entry.allocated < block.size) {
+		uint8* data = (uint8*)realloc(entry.data, block.size);
+		if (data == NULL)
+			return NULL;
+
+		entry.data = data;
+		entry.allocated = block.size;
+	}
+
+	uLongf size = block.size;
+	if (uncompress(entry.data, &size, block.data, block.compressedSize) != Z_OK
+		|| size != block.size) {
+		return NULL;
+	}
+
+	uint32 offset = 0;
+	for (int32 i = 0; i < kBlockLines; i++) {
+		entry.lineOffsets[i] = offset;
+		const stored_line* line = (const stored_line*)(entry.data + offset);
+		offset += stored_line_size(line->attributesRunCount, line->byteLength);
+	}
+
+	entry.serial = serial;
+	entry.lastUsed = ++fCacheClock;
+	return &entry;
+}
+
+
+/*!	Moves the oldest blocks into the spill file, until the ones left in
+	memory take up no more than kMaxCompressedSize.
+*/
+void
+HistoryBuffer::_SpillBlocks()
+{
+	while (fCompressedSize > kMaxCompressedSize && fSpilledBlocks < fBlockCount
+		&& !fSpillFailed) {
+		Block& block = fBlocks[(fFirstBlock + fSpilledBlocks) % fBlockCapacity];
+
+		int32 segment;
+		uint8* address = _AllocateSpillSpace(block.compressedSize, segment);
+		if (address == NULL)
+			break;
+
+		memcpy(address, block.data, block.compressedSize);
+		free(block.data);
+		fCompressedSize -= block.compressedSize;
+
+		block.data = address;
+		block.spillSegment = segment;
+		fSpilledBlocks++;
+	}
+}
+
+
+uint8*
+HistoryBuffer::_AllocateSpillSpace(size_t size, int32& _segment)
+{
+	if (size > kSpillSegmentSize)
+		return NULL;
+
+	SpillSegment* segment = fCurrentSpillSegment >= 0
+		? &fSpillSegments[fCurrentSpillSegment] : NULL;
+	if (segment == NULL || segment->used + size > kSpillSegmentSize) {
+		// continue with a segment that is no longer used, or add a new one
+		int32 index = 0;
+		while (index < fSpillSegmentCount
+			&& fSpillSegments[index].blockCount > 0) {
+			index++;
+		}
+
+		if (index == fSpillSegmentCount && _AddSpillSegment() != B_OK) {
+			fSpillFailed = true;
+			return NULL;
+		}
+
+		fCurrentSpillSegment = index;
+		segment = &fSpillSegments[index];
+	}
+
+	uint8* address = segment->address + segment->used;
+	segment->used += (size + 7) & ~(size_t)7;
+	segment->blockCount++;
+
+	_segment = fCurrentSpillSegment;
+	return address;
+}
+
+
+status_t
+HistoryBuffer::_AddSpillSegment()
+{
+	if (fSpillFile < 0) {
+		BPath path;
+		status_t status = find_directory(B_SYSTEM_TEMP_DIRECTORY, &path);
+		if (status == B_OK)
+			status = path.Append("Terminal history XXXXXX");
+		if (status != B_OK)
+			return status;
+
+		char name[B_PATH_NAME_LENGTH];
+		strlcpy(name, path.Path(), sizeof(name));
+
+		fSpillFile = mkstemp(name);
+		if (fSpillFile < 0)
+			return errno;
+
+		// nobody else needs to see it
+		unlink(name);
+	}
+
+	SpillSegment* segments = (SpillSegment*)realloc(fSpillSegments,
+		(fSpillSegmentCount + 1) * sizeof(SpillSegment));
+	if (segments == NULL)
+		return B_NO_MEMORY;
+
+	fSpillSegments = segments;
+
+	off_t offset = (off_t)fSpillSegmentCount * kSpillSegmentSize;
+	if (ftruncate(fSpillFile, offset + kSpillSegmentSize) != 0)
+		return errno;
+
+	void* address = mmap(NULL, kSpillSegmentSize, PROT_READ | PROT_WRITE,
+		MAP_SHARED, fSpillFile, offset);
+	if (address == MAP_FAILED)
+		return errno;
+
+	SpillSegment& segment = fSpillSegments[fSpillSegmentCount++];
+	segment.address = (uint8*)address;
+	segment.used = 0;
+	segment.blockCount = 0;
+
+	return B_OK;
+}
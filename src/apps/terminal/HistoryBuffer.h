@@ -5,6 +5,8 @@
 #ifndef HISTORY_BUFFER_H
 #define HISTORY_BUFFER_H
 
+#include <string.h>
+
 #include <SupportDefs.h>
 
 #include "TerminalLine.h"
@@ -14,7 +16,49 @@ struct HistoryLine;
 struct TerminalLine;
 
 
+/*!	The most recent lines are kept as they are in a ring buffer. If the
+	capacity is larger than that, older lines are moved into blocks of a fixed
+	number of lines, which are compressed once they are full. When the
+	compressed blocks take up too much memory, the oldest of them are moved
+	to a memory mapped temporary file.
+
+	Since all blocks have the same number of lines, any line can be found
+	without looking at other blocks, and each block remembers which
+	characters it contains, so that searches can skip it.
+*/
 class HistoryBuffer {
+public:
+	struct CharacterMask {
+		uint32			bits[8];
+
+						CharacterMask()
+						{
+							Clear();
+						}
+
+		void			Clear()
+						{
+							memset(bits, 0, sizeof(bits));
+						}
+
+		void			Add(const char* bytes, int32 count)
+						{
+							for (int32 i = 0; i < count; i++) {
+								uint8 byte = bytes[i];
+								bits[byte >> 5] |= 1UL << (byte & 31);
+							}
+						}
+
+		bool			Contains(const CharacterMask& other) const
+						{
+							for (int32 i = 0; i < 8; i++) {
+								if ((other.bits[i] & ~bits[i]) != 0)
+									return false;
+							}
+							return true;
+						}
+	};
+
 public:
 								HistoryBuffer();
 								~HistoryBuffer();
@@ -27,18 +71,38 @@ public:
 			int32				Capacity() const	{ return fCapacity; }
 			int32				Size() const		{ return fSize; }
 
-	inline	HistoryLine*		LineAt(int32 index) const;
+			HistoryLine*		LineAt(int32 index) const;
 			TerminalLine*		GetTerminalLineAt(int32 index,
 									TerminalLine* buffer) const;
 
+			int32				SkipLines(int32 index, bool older,
+									const CharacterMask& characters) const;
+
 			void				AddLine(const TerminalLine* line);
 			void				AddEmptyLines(int32 count);
 			void				DropLines(int32 count);
 
 private:
+			struct Block;
+			struct CacheEntry;
+			struct SpillSegment;
+
 			HistoryLine*		_AllocateLine(int32 attributesRuns,
 									int32 byteLength);
 	inline	HistoryLine*		_LineAt(int32 index) const;
+			void				_EvictLines(int32 count);
+
+			HistoryLine*		_StoredLineAt(int32 index) const;
+			status_t			_StoreLine(const HistoryLine* line);
+			status_t			_CloseBlock();
+			void				_DropStoredLines(int32 count);
+			void				_RemoveBlocks(int32 count);
+			const CacheEntry*	_CachedBlock(int32 blockIndex) const;
+
+			void				_SpillBlocks();
+			uint8*				_AllocateSpillSpace(size_t size,
+									int32& _segment);
+			status_t			_AddSpillSegment();
 
 private:
 			HistoryLine*		fLines;
@@ -46,23 +110,49 @@ private:
 			int32				fCapacity;
 			int32				fNextLine;
 			int32				fSize;
+			int32				fRingCapacity;
+			int32				fRingSize;
 			uint8*				fBuffer;
 			int32				fBufferSize;
 			int32				fBufferAllocationOffset;
+
+			// lines that no longer fit into the ring buffer
+			Block*				fBlocks;
+			int32				fBlockCapacity;
+			int32				fFirstBlock;
+			int32				fBlockCount;
+			int64				fFirstBlockSerial;
+			int32				fStoredSize;
+			int32				fStoredSkip;
+			size_t				fCompressedSize;
+
+			// the block that is still being filled
+			uint8*				fOpenBlock;
+			size_t				fOpenBlockSize;
+			size_t				fOpenBlockAllocated;
+			uint32*				fOpenLineOffsets;
+			int32				fOpenLineCount;
+			CharacterMask		fOpenCharacters;
+			bool				fOpenJoinedToPrevious;
+			bool				fLastSoftBreak;
+
+			CacheEntry*			fCache;
+	mutable	int32				fCacheClock;
+	mutable	HistoryLine			fStoredLine;
+
+			int					fSpillFile;
+			SpillSegment*		fSpillSegments;
+			int32				fSpillSegmentCount;
+			int32				fCurrentSpillSegment;
+			int32				fSpilledBlocks;
+			bool				fSpillFailed;
 };
 
 
 inline HistoryLine*
 HistoryBuffer::_LineAt(int32 index) const
 {
-	return &fLines[(fCapacity + fNextLine - index - 1) % fCapacity];
-}
-
-
-inline HistoryLine*
-HistoryBuffer::LineAt(int32 index) const
-{
-	return index >= 0 && index < fSize ? _LineAt(index) : NULL;
+	return &fLines[(fRingCapacity + fNextLine - index - 1) % fRingCapacity];
 }
 
 
@@ -31,6 +31,10 @@
 #include <Message.h>
 #include <UTF8.h>
 
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#endif
+
 #include "Colors.h"
 #include "TermConst.h"
 #include "TerminalBuffer.h"
@@ -56,6 +60,62 @@ extern const char* gLineDrawGraphSet[]; /* may be used for G0, G1, G2, G3 */
 #define NPARAM 10		// Max parameters
 
 
+/*!	Returns the end of the run of printable characters that starts at
+	\a start, as the UTF-8 ground table sees them: printable ASCII, and
+	complete two and three byte sequences. Everything else, including a
+	sequence that is cut off by the end of the buffer, ends the run.
+*/
+static inline const uchar*
+find_printable_run_end(const uchar* start, const uchar* end)
+{
+	while (start < end) {
+#if defined(__SSE2__)
+		const __m128i minPrintable = _mm_set1_epi8(0x1f);
+		const __m128i maxPrintable = _mm_set1_epi8(0x7f);
+
+		while (end - start >= 16) {
+			// bytes >= 0x80 are negative, and therefore not printable here
+			__m128i chunk = _mm_loadu_si128((const __m128i*)start);
+			int mask = _mm_movemask_epi8(_mm_and_si128(
+				_mm_cmpgt_epi8(chunk, minPrintable),
+				_mm_cmplt_epi8(chunk, maxPrintable)));
+			if (mask != 0xffff) {
+				start += __builtin_ctz(~mask);
+				break;
+			}
+
+			start += 16;
+		}
+		if (start == end)
+			break;
+#endif
+
+		uchar c = *start;
+		if (c >= 0x20 && c < 0x7f) {
+			start++;
+			continue;
+		}
+
+		int32 count;
+		if (c >= 0xc0 && c < 0xe0)
+			count = 2;
+		else if (c >= 0xe0 && c < 0xf0)
+			count = 3;
+		else
+			break;
+
+		if (end - start < count || (start[1] & 0xc0) != 0x80
+			|| (count == 3 && (start[2] & 0xc0) != 0x80)) {
+			break;
+		}
+
+		start += count;
+	}
+
+	return start;
+}
+
+
 //! Get char from pty reader buffer.
 inline uchar
 TermParse::_NextParseChar()
@@ -420,6 +480,20 @@ TermParse::EscParse()
 							fBuffer->InsertChar(curGraphSet[offset]);
 							break;
 						}
+					} else if (parsestate == gUTF8GroundTable) {
+						// Insert all printable characters that follow at
+						// once, instead of passing each through the parser.
+						const uchar* start
+							= fParserBuffer + fParserBufferOffset - 1;
+						const uchar* end = find_printable_run_end(start + 1,
+							fParserBuffer + fParserBufferSize);
+#ifdef USE_DEBUG_SNAPSHOTS
+						for (const uchar* next = start + 1; next < end; next++)
+							fBuffer->CaptureChar(*next);
+#endif
+						fBuffer->InsertChars((const char*)start, end - start);
+						fParserBufferOffset = end - fParserBuffer;
+						break;
 					}
 					fBuffer->InsertChar((char)c);
 					break;
@@ -1327,12 +1401,13 @@ TermParse::_ReadParserBuffer()
 	if (toRead > ESC_PARSER_BUFFER_SIZE)
 		toRead = ESC_PARSER_BUFFER_SIZE;
 
-	for (int32 i = 0; i < toRead; i++) {
-		// TODO: This could be optimized using memcpy instead and
-		// calculating space left as in the PtyReader().
-		fParserBuffer[i] = fReadBuffer[fBufferPosition];
-		fBufferPosition = (fBufferPosition + 1) % READ_BUF_SIZE;
-	}
+	int32 left = READ_BUF_SIZE - fBufferPosition;
+	if (toRead > left) {
+		memcpy(fParserBuffer, fReadBuffer + fBufferPosition, left);
+		memcpy(fParserBuffer + left, fReadBuffer, toRead - left);
+	} else
+		memcpy(fParserBuffer, fReadBuffer + fBufferPosition, toRead);
+	fBufferPosition = (fBufferPosition + toRead) % READ_BUF_SIZE;
 
 	int32 bufferSize = atomic_add(&fReadBufferSize, -toRead);
 
@@ -23,7 +23,7 @@
 	// pty read buffer size
 #define MIN_PTY_BUFFER_SPACE	16
 	// minimal space left before the reader tries to read more
-#define ESC_PARSER_BUFFER_SIZE	64
+#define ESC_PARSER_BUFFER_SIZE	1024
 	// size of the parser buffer
 
 
@@ -619,6 +619,17 @@ list_interface(const char* name)
 		printf("\tCollisions: %d\n", stats.collisions);
 	}
 
+	int32 queueCount = interface.CountReceiveQueues();
+	for (int32 i = 0; queueCount > 1 && i < queueCount; i++) {
+		ifreq_stream_stats queueStats;
+		if (interface.GetReceiveQueueStats(i, queueStats) != B_OK)
+			break;
+
+		printf("\tReceive queue %" B_PRId32 ": %" B_PRIu32 " packets, %"
+			B_PRIu64 " bytes, %" B_PRIu32 " dropped\n", i, queueStats.packets,
+			queueStats.bytes, queueStats.dropped);
+	}
+
 	putchar('\n');
 	return true;
 }
@@ -19,6 +19,7 @@
 #include <string.h>
 #include <new>
 
+#include <LinkRing.h>
 #include <ServerProtocol.h>
 #include <String.h>
 #include <Region.h>
@@ -52,26 +53,50 @@ namespace BPrivate {
 
 LinkReceiver::LinkReceiver(port_id port)
 	:
-	fReceivePort(port), fRecvBuffer(NULL), fRecvPosition(0), fRecvStart(0),
+	fReceivePort(port), fRing(NULL), fRecvBuffer(NULL), fRecvPosition(0),
+	fRecvStart(0),
 	fRecvBufferSize(0), fDataSize(0),
-	fReplySize(0), fReadError(B_OK)
+	fReplySize(0), fReadError(B_OK),
+	fDeferredBuffer(NULL), fDeferredBufferSize(0), fDeferredSize(0),
+	fPortTurn(false)
 {
 }
 
 
 LinkReceiver::~LinkReceiver()
 {
+	delete fRing;
 	free(fRecvBuffer);
+	free(fDeferredBuffer);
 }
 
 
 void
 LinkReceiver::SetPort(port_id port)
 {
+	if (port != fReceivePort)
+		SetRing(NULL);
+
 	fReceivePort = port;
 }
 
 
+/*!	Lets the receiver also look for batches in \a ring. The receiver takes
+	over ownership of the ring; it is dropped again when the port changes.
+*/
+void
+LinkReceiver::SetRing(LinkRing* ring)
+{
+	if (ring == fRing)
+		return;
+
+	delete fRing;
+	fRing = ring;
+	fDeferredSize = 0;
+	fPortTurn = false;
+}
+
+
 status_t
 LinkReceiver::GetNextMessage(int32 &code, bigtime_t timeout)
 {
@@ -122,8 +147,13 @@ LinkReceiver::GetNextMessage(int32 &code, bigtime_t timeout)
 bool
 LinkReceiver::HasMessages() const
 {
-	return fDataSize - (fRecvStart + fReplySize) > 0
-		|| port_count(fReceivePort) > 0;
+	if (fDataSize - (fRecvStart + fReplySize) > 0)
+		return true;
+
+	if (fRing != NULL)
+		return fRing->HasData() || fDeferredSize > 0 || PortHasMessages();
+
+	return port_count(fReceivePort) > 0;
 }
 
 
@@ -190,36 +220,48 @@ LinkReceiver::AdjustReplyBuffer(bigtime_t timeout)
 			return (status_t)bufferSize;
 
 		// make sure our receive buffer is large enough
-		if (bufferSize > fRecvBufferSize) {
-			if (bufferSize <= (ssize_t)kInitialBufferSize)
-				bufferSize = (ssize_t)kInitialBufferSize;
-			else
-				bufferSize = (bufferSize + B_PAGE_SIZE - 1) & ~(B_PAGE_SIZE - 1);
-
-			if (bufferSize > (ssize_t)kMaxBufferSize)
-				return B_ERROR;	// we can't continue
-
-			STRACE(("info: LinkReceiver setting receive buffersize to %ld.\n", bufferSize));
-			char *buffer = (char *)malloc(bufferSize);
-			if (buffer == NULL)
-				return B_NO_MEMORY;
-
-			free(fRecvBuffer);
-			fRecvBuffer = buffer;
-			fRecvBufferSize = bufferSize;
-		}
+		return AdjustBufferSize(bufferSize);
 	}
 
 	return B_OK;
 }
 
 
+status_t
+LinkReceiver::AdjustBufferSize(ssize_t bufferSize)
+{
+	if (bufferSize <= fRecvBufferSize)
+		return B_OK;
+
+	if (bufferSize <= (ssize_t)kInitialBufferSize)
+		bufferSize = (ssize_t)kInitialBufferSize;
+	else
+		bufferSize = (bufferSize + B_PAGE_SIZE - 1) & ~(B_PAGE_SIZE - 1);
+
+	if (bufferSize > (ssize_t)kMaxBufferSize)
+		return B_ERROR;	// we can't continue
+
+	STRACE(("info: LinkReceiver setting receive buffersize to %ld.\n", bufferSize));
+	char *buffer = (char *)malloc(bufferSize);
+	if (buffer == NULL)
+		return B_NO_MEMORY;
+
+	free(fRecvBuffer);
+	fRecvBuffer = buffer;
+	fRecvBufferSize = bufferSize;
+	return B_OK;
+}
+
+
 status_t
 LinkReceiver::ReadFromPort(bigtime_t timeout)
 {
 	// we are here so it means we finished reading the buffer contents
 	ResetBuffer();
 
+	if (fRing != NULL)
+		return ReadFromRing(timeout);
+
 	status_t err = AdjustReplyBuffer(timeout);
 	if (err < B_OK)
 		return err;
@@ -261,6 +303,128 @@ LinkReceiver::ReadFromPort(bigtime_t timeout)
 }
 
 
+/*!	Variant of ReadFromPort() for when a LinkRing is attached. While both
+	the ring and the port have messages, they take turns, so that a steady
+	stream of batches through the ring cannot starve the other senders on
+	the port, like the server itself.
+	A batch that the sender had to put into the port is newer than those
+	still in the ring; it is held back until the ring is empty. The sender
+	doesn't use the ring again until it has been delivered.
+*/
+status_t
+LinkReceiver::ReadFromRing(bigtime_t timeout)
+{
+	while (true) {
+		if (fDeferredSize > 0) {
+			status_t err = ReadRingRecord();
+			if (err != B_WOULD_BLOCK)
+				return err;
+
+			char* buffer = fRecvBuffer;
+			int32 bufferSize = fRecvBufferSize;
+			fRecvBuffer = fDeferredBuffer;
+			fRecvBufferSize = fDeferredBufferSize;
+			fDeferredBuffer = buffer;
+			fDeferredBufferSize = bufferSize;
+
+			fDataSize = fDeferredSize;
+			fDeferredSize = 0;
+			fRing->PortBatchReceived();
+			return B_OK;
+		}
+
+		if (!fPortTurn || !PortHasMessages()) {
+			status_t err = ReadRingRecord();
+			if (err == B_WOULD_BLOCK && fRing->ArmWakeup()) {
+				// the sender might have missed the flag, look again
+				err = ReadRingRecord();
+			}
+			if (err != B_WOULD_BLOCK) {
+				fPortTurn = err == B_OK;
+				return err;
+			}
+		}
+		fPortTurn = false;
+
+		status_t err = AdjustReplyBuffer(timeout);
+		if (err < B_OK)
+			return err;
+
+		int32 code;
+		ssize_t bytesRead;
+		do {
+			bytesRead = read_port_etc(fReceivePort, &code, fRecvBuffer,
+				fRecvBufferSize, timeout == B_INFINITE_TIMEOUT
+					? 0 : B_RELATIVE_TIMEOUT, timeout);
+		} while (bytesRead == B_INTERRUPTED);
+
+		STRACE(("info: LinkReceiver read %ld bytes.\n", bytesRead));
+		if (bytesRead < B_OK)
+			return bytesRead;
+
+		if (code == kLinkRingWakeupCode) {
+			fRing->WakeupReceived();
+			continue;
+		}
+		if (code == kLinkRingCode) {
+			if (fRing->HasData()) {
+				// hold it back, and use the other buffer for the ring
+				char* buffer = fDeferredBuffer;
+				int32 bufferSize = fDeferredBufferSize;
+				fDeferredBuffer = fRecvBuffer;
+				fDeferredBufferSize = fRecvBufferSize;
+				fRecvBuffer = buffer;
+				fRecvBufferSize = bufferSize;
+
+				fDeferredSize = bytesRead;
+				continue;
+			}
+			fRing->PortBatchReceived();
+		} else if (code != kLinkCode) {
+			// a message we ignore
+			continue;
+		}
+
+		fDataSize = bytesRead;
+		return B_OK;
+	}
+}
+
+
+/*!	Moves the next batch from the ring into the receive buffer. Returns
+	\c B_WOULD_BLOCK if the ring is empty.
+*/
+status_t
+LinkReceiver::ReadRingRecord()
+{
+	ssize_t size = fRing->NextRecordSize();
+	if (size < 0)
+		return size;
+	if (size == 0)
+		return B_WOULD_BLOCK;
+
+	status_t err = AdjustBufferSize(size);
+	if (err < B_OK)
+		return err;
+
+	memcpy(fRecvBuffer, fRing->RecordData(), size);
+	fRing->SkipRecord();
+
+	fDataSize = size;
+	return B_OK;
+}
+
+
+/*!	Returns whether the port holds anything else than the wakeups the
+	sender wrote for the ring.
+*/
+bool
+LinkReceiver::PortHasMessages() const
+{
+	return port_count(fReceivePort) > fRing->PendingWakeups();
+}
+
+
 status_t
 LinkReceiver::Read(void *data, ssize_t passedSize)
 {
@@ -0,0 +1,324 @@
+/*
+ * Copyright 2026, Haiku.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Shared memory ring for the client to server direction of a link.
+
+	The ring lives in an area that is created by the receiving side and
+	cloned by the sending side. Records consist of a uint32 size followed by
+	the batch data, and are 8 byte aligned; a record never wraps around the
+	end of the ring, the remaining space is skipped with a padding record
+	instead.
+
+	Since the port may still carry batches when the ring is full, the sender
+	counts the batches it wrote to the port, and does not use the ring again
+	before the receiver has read them all. A batch the receiver takes from
+	the port is held back until the ring is empty, so the order of the
+	batches is kept.
+
+	The receiver arms the wakeup flag before it blocks on the port; the
+	sender only writes a (empty) wakeup message to the port when it finds
+	the flag armed. The sender counts these wakeups, so that the receiver
+	can tell whether the port holds anything else.
+*/
+
+
+#include <LinkRing.h>
+
+#include <string.h>
+
+
+namespace BPrivate {
+
+
+struct link_ring_header {
+	int32	write_position;
+	int32	port_batches_sent;
+	int32	wakeups_sent;
+	int32	_reserved0[13];
+
+	int32	read_position;
+	int32	port_batches_received;
+	int32	consumer_waiting;
+	int32	_reserved1[13];
+};
+
+
+static const uint32 kPaddingRecord = 0xffffffff;
+static const uint32 kRecordAlignment = 8;
+
+
+static inline uint32
+record_size(uint32 size)
+{
+	return (sizeof(uint32) + size + kRecordAlignment - 1)
+		& ~(kRecordAlignment - 1);
+}
+
+
+LinkRing::LinkRing()
+	:
+	fArea(-1),
+	fHeader(NULL),
+	fData(NULL),
+	fSize(0),
+	fReadPosition(0),
+	fRecordSize(0),
+	fWakeupsReceived(0)
+{
+}
+
+
+LinkRing::~LinkRing()
+{
+	if (fArea >= 0)
+		delete_area(fArea);
+}
+
+
+/*!	Creates the ring area. The size of the data part is rounded up to the
+	next power of two.
+*/
+status_t
+LinkRing::Create(const char* name, size_t size)
+{
+	if (fArea >= 0)
+		return B_BAD_VALUE;
+
+	size_t dataSize = B_PAGE_SIZE;
+	while (dataSize < size)
+		dataSize <<= 1;
+
+	size_t areaSize = (sizeof(link_ring_header) + dataSize + B_PAGE_SIZE - 1)
+		& ~(B_PAGE_SIZE - 1);
+
+	void* address;
+	fArea = create_area(name, &address, B_ANY_ADDRESS, areaSize, B_NO_LOCK,
+		B_READ_AREA | B_WRITE_AREA | B_CLONEABLE_AREA);
+	if (fArea < B_OK)
+		return fArea;
+
+	memset(address, 0, sizeof(link_ring_header));
+	return _Init(address, areaSize);
+}
+
+
+status_t
+LinkRing::Clone(area_id area)
+{
+	if (fArea >= 0)
+		return B_BAD_VALUE;
+
+	void* address;
+	fArea = clone_area("link ring", &address, B_ANY_ADDRESS,
+		B_READ_AREA | B_WRITE_AREA, area);
+	if (fArea < B_OK)
+		return fArea;
+
+	area_info info;
+	status_t status = get_area_info(fArea, &info);
+	if (status != B_OK)
+		return status;
+
+	return _Init(address, info.size);
+}
+
+
+/*!	Appends a batch to the ring. Returns \c false if the batch has to go
+	through the port instead, either because it does not fit, or because
+	earlier batches are still waiting in the port.
+*/
+bool
+LinkRing::Write(const void* data, size_t size)
+{
+	if (fHeader == NULL || record_size(size) > fSize / 2)
+		return false;
+
+	if (atomic_get(&fHeader->port_batches_sent)
+			!= atomic_get(&fHeader->port_batches_received))
+		return false;
+
+	uint32 recordSize = record_size(size);
+	uint32 write = (uint32)fHeader->write_position;
+	uint32 read = (uint32)atomic_get(&fHeader->read_position);
+	uint32 offset = write & (fSize - 1);
+	uint32 contiguous = fSize - offset;
+
+	uint32 needed = recordSize;
+	if (recordSize > contiguous)
+		needed += contiguous;
+	if (fSize - (write - read) < needed)
+		return false;
+
+	if (recordSize > contiguous) {
+		*(uint32*)(fData + offset) = kPaddingRecord;
+		write += contiguous;
+		offset = 0;
+	}
+
+	*(uint32*)(fData + offset) = size;
+	memcpy(fData + offset + sizeof(uint32), data, size);
+
+	atomic_set(&fHeader->write_position, (int32)(write + recordSize));
+	return true;
+}
+
+
+/*!	Returns \c true if the receiver is waiting on the port, and needs to be
+	woken up. The wakeup then already counts as sent; call WakeupFailed() if
+	it could not be written to the port.
+*/
+bool
+LinkRing::DisarmWakeup()
+{
+	if (atomic_get_and_set(&fHeader->consumer_waiting, 0) == 0)
+		return false;
+
+	atomic_add(&fHeader->wakeups_sent, 1);
+	return true;
+}
+
+
+void
+LinkRing::WakeupFailed()
+{
+	atomic_add(&fHeader->wakeups_sent, -1);
+}
+
+
+void
+LinkRing::PortBatchSent()
+{
+	atomic_add(&fHeader->port_batches_sent, 1);
+}
+
+
+void
+LinkRing::PortBatchFailed()
+{
+	atomic_add(&fHeader->port_batches_sent, -1);
+}
+
+
+bool
+LinkRing::HasData() const
+{
+	return (uint32)atomic_get(&fHeader->write_position) != fReadPosition;
+}
+
+
+/*!	Returns the size of the next record, 0 if the ring is empty, or an
+	error code if the ring contents are bogus. The ring memory is shared with
+	the sender, so the receiver keeps its own read position, and checks
+	everything else it finds in there.
+*/
+ssize_t
+LinkRing::NextRecordSize()
+{
+	while (true) {
+		uint32 available = (uint32)atomic_get(&fHeader->write_position)
+			- fReadPosition;
+		if (available == 0)
+			return 0;
+		if (available > fSize)
+			return B_BAD_DATA;
+
+		uint32 offset = fReadPosition & (fSize - 1);
+		uint32 size = *(volatile uint32*)(fData + offset);
+		if (size == kPaddingRecord) {
+			uint32 contiguous = fSize - offset;
+			if (contiguous > available)
+				return B_BAD_DATA;
+
+			fReadPosition += contiguous;
+			atomic_set(&fHeader->read_position, (int32)fReadPosition);
+			continue;
+		}
+
+		if (size > fSize / 2 || record_size(size) > available
+			|| record_size(size) > fSize - offset)
+			return B_BAD_DATA;
+
+		fRecordSize = size;
+		return size;
+	}
+}
+
+
+//!	Returns the data of the record last returned by NextRecordSize().
+const void*
+LinkRing::RecordData() const
+{
+	return fData + (fReadPosition & (fSize - 1)) + sizeof(uint32);
+}
+
+
+//!	Releases the record last returned by NextRecordSize().
+void
+LinkRing::SkipRecord()
+{
+	fReadPosition += record_size(fRecordSize);
+	fRecordSize = 0;
+	atomic_set(&fHeader->read_position, (int32)fReadPosition);
+}
+
+
+/*!	Announces that the receiver is about to block on the port. Returns
+	\c true if the flag was not yet set; the ring must then be checked once
+	more before blocking.
+*/
+bool
+LinkRing::ArmWakeup()
+{
+	return atomic_get_and_set(&fHeader->consumer_waiting, 1) == 0;
+}
+
+
+void
+LinkRing::PortBatchReceived()
+{
+	atomic_add(&fHeader->port_batches_received, 1);
+}
+
+
+void
+LinkRing::WakeupReceived()
+{
+	fWakeupsReceived++;
+}
+
+
+/*!	Returns the number of wakeups that the sender wrote to the port, and
+	that the receiver did not read yet.
+*/
+int32
+LinkRing::PendingWakeups() const
+{
+	int32 pending = (int32)((uint32)atomic_get(&fHeader->wakeups_sent)
+		- fWakeupsReceived);
+	return pending > 0 ? pending : 0;
+}
+
+
+status_t
+LinkRing::_Init(void* address, size_t areaSize)
+{
+	if (areaSize < sizeof(link_ring_header) + B_PAGE_SIZE)
+		return B_BAD_VALUE;
+
+	// use the largest power of two that fits into the area
+	uint32 size = B_PAGE_SIZE;
+	while ((size_t)size * 2 <= areaSize - sizeof(link_ring_header))
+		size <<= 1;
+
+	fHeader = (link_ring_header*)address;
+	fData = (uint8*)address + sizeof(link_ring_header);
+	fSize = size;
+	fReadPosition = (uint32)fHeader->read_position;
+	return B_OK;
+}
+
+
+}	// namespace BPrivate
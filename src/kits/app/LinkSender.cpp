@@ -15,6 +15,7 @@
 #include <new>
 
 #include <ServerProtocol.h>
+#include <LinkRing.h>
 #include <LinkSender.h>
 
 #include "link_message.h"
@@ -38,6 +39,7 @@ LinkSender::LinkSender(port_id port)
 	:
 	fPort(port),
 	fTargetTeam(-1),
+	fRing(NULL),
 	fBuffer(NULL),
 	fBufferSize(0),
 
@@ -50,6 +52,7 @@ LinkSender::LinkSender(port_id port)
 
 LinkSender::~LinkSender()
 {
+	delete fRing;
 	free(fBuffer);
 }
 
@@ -57,10 +60,28 @@ LinkSender::~LinkSender()
 void
 LinkSender::SetPort(port_id port)
 {
+	if (port != fPort)
+		SetRing(NULL);
+
 	fPort = port;
 }
 
 
+/*!	Lets the sender pass its batches through \a ring instead of the port,
+	whenever possible. The sender takes over ownership of the ring; it is
+	dropped again when the port changes.
+*/
+void
+LinkSender::SetRing(LinkRing* ring)
+{
+	if (ring == fRing)
+		return;
+
+	delete fRing;
+	fRing = ring;
+}
+
+
 status_t
 LinkSender::StartMessage(int32 code, size_t minSize)
 {
@@ -305,19 +326,50 @@ LinkSender::Flush(bigtime_t timeout, bool needsReply)
 	STRACE(("info: LinkSender Flush() waiting to send messages of %ld bytes on port %ld.\n",
 		fCurrentEnd, fPort));
 
+	int32 code = kLinkCode;
+	if (fRing != NULL) {
+		if (fRing->Write(fBuffer, fCurrentEnd)) {
+			STRACE(("info: LinkSender Flush() put %ld bytes into the ring.\n",
+				fCurrentEnd));
+
+			fCurrentEnd = 0;
+			fCurrentStart = 0;
+
+			if (fRing->DisarmWakeup()) {
+				// The batch is already on its way; if the port is too full
+				// for the wakeup, the receiver isn't waiting on it anyway.
+				status_t err;
+				do {
+					err = write_port_etc(fPort, kLinkRingWakeupCode, NULL, 0,
+						B_RELATIVE_TIMEOUT, timeout);
+				} while (err == B_INTERRUPTED);
+				if (err < B_OK)
+					fRing->WakeupFailed();
+			}
+			return B_OK;
+		}
+
+		// the ring is full, or the batch too large for it
+		code = kLinkRingCode;
+		fRing->PortBatchSent();
+	}
+
 	status_t err;
 	if (timeout != B_INFINITE_TIMEOUT) {
 		do {
-			err = write_port_etc(fPort, kLinkCode, fBuffer,
+			err = write_port_etc(fPort, code, fBuffer,
 				fCurrentEnd, B_RELATIVE_TIMEOUT, timeout);
 		} while (err == B_INTERRUPTED);
 	} else {
 		do {
-			err = write_port(fPort, kLinkCode, fBuffer, fCurrentEnd);
+			err = write_port(fPort, code, fBuffer, fCurrentEnd);
 		} while (err == B_INTERRUPTED);
 	}
 
 	if (err < B_OK) {
+		if (code == kLinkRingCode)
+			fRing->PortBatchFailed();
+
 		STRACE(("error info: LinkSender Flush() failed for %ld bytes (%s) on port %ld.\n",
 			fCurrentEnd, strerror(err), fPort));
 		return err;
@@ -1637,16 +1637,7 @@ BMessage::_ResizeData(uint32 offset, int32 change)
 uint32
 BMessage::_HashName(const char* name) const
 {
-	char ch;
-	uint32 result = 0;
-
-	while ((ch = *name++) != 0) {
-		result = (result << 7) ^ (result >> 24);
-		result ^= ch;
-	}
-
-	result ^= result << 12;
-	return result;
+	return Private::HashName(name);
 }
 
 
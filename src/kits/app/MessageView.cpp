@@ -0,0 +1,530 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <MessageView.h>
+
+#include <string.h>
+
+#include <Point.h>
+#include <Rect.h>
+
+#include <MessageAdapter.h>
+#include <MessagePrivate.h>
+
+
+namespace BPrivate {
+
+
+//	#pragma mark - FieldName
+
+
+/*!	The hint is only ever a guess that is verified before use, so a
+	FieldName can be shared between threads.
+*/
+MessageView::FieldName::FieldName(const char* name)
+	:
+	fName(name),
+	fLength(name != NULL ? strlen(name) : 0),
+	fHash(name != NULL ? BMessage::Private::HashName(name) : 0),
+	fHint(-1)
+{
+}
+
+
+//	#pragma mark - MessageView
+
+
+MessageView::MessageView()
+	:
+	fHeader(NULL),
+	fFields(NULL),
+	fData(NULL),
+	fStatus(B_NO_INIT)
+{
+}
+
+
+MessageView::MessageView(const void* buffer, size_t size)
+	:
+	fHeader(NULL),
+	fFields(NULL),
+	fData(NULL),
+	fStatus(B_NO_INIT)
+{
+	SetTo(buffer, size);
+}
+
+
+/*!	Sets the view to the flattened message in \a buffer, which must be
+	\a size bytes large, and checks that it is a valid native message.
+	Messages in other formats, and messages that were passed in an area, are
+	rejected with \c B_NOT_SUPPORTED; they have to be unflattened into a
+	BMessage.
+*/
+status_t
+MessageView::SetTo(const void* buffer, size_t size)
+{
+	Unset();
+
+	if (buffer == NULL)
+		return fStatus = B_BAD_VALUE;
+
+	fHeader = (const message_header*)buffer;
+	fFields = (const field_header*)(fHeader + 1);
+
+	status_t status = _Validate(size);
+	if (status != B_OK) {
+		Unset();
+		return fStatus = status;
+	}
+
+	fData = (const uint8*)(fFields + fHeader->field_count);
+	return fStatus = B_OK;
+}
+
+
+void
+MessageView::Unset()
+{
+	fHeader = NULL;
+	fFields = NULL;
+	fData = NULL;
+	fStatus = B_NO_INIT;
+}
+
+
+status_t
+MessageView::InitCheck() const
+{
+	return fStatus;
+}
+
+
+size_t
+MessageView::FlattenedSize() const
+{
+	if (fStatus != B_OK)
+		return 0;
+
+	return sizeof(message_header)
+		+ fHeader->field_count * sizeof(field_header) + fHeader->data_size;
+}
+
+
+uint32
+MessageView::What() const
+{
+	return fStatus == B_OK ? fHeader->what : 0;
+}
+
+
+int32
+MessageView::CountNames(type_code type) const
+{
+	if (fStatus != B_OK)
+		return 0;
+
+	if (type == B_ANY_TYPE)
+		return fHeader->field_count;
+
+	int32 count = 0;
+	for (uint32 i = 0; i < fHeader->field_count; i++) {
+		if (fFields[i].type == type)
+			count++;
+	}
+
+	return count;
+}
+
+
+bool
+MessageView::HasField(const FieldName& name, type_code type) const
+{
+	const field_header* field;
+	return _FindField(name, type, &field) == B_OK;
+}
+
+
+status_t
+MessageView::GetInfo(const FieldName& name, type_code* _type, int32* _count,
+	bool* _fixedSize) const
+{
+	const field_header* field;
+	status_t status = _FindField(name, B_ANY_TYPE, &field);
+	if (status != B_OK)
+		return status;
+
+	if (_type != NULL)
+		*_type = field->type;
+	if (_count != NULL)
+		*_count = field->count;
+	if (_fixedSize != NULL)
+		*_fixedSize = (field->flags & FIELD_FLAG_FIXED_SIZE) != 0;
+
+	return B_OK;
+}
+
+
+status_t
+MessageView::GetInfo(type_code type, int32 index, const char** _name,
+	type_code* _type, int32* _count) const
+{
+	if (fStatus != B_OK)
+		return fStatus;
+	if (index < 0 || _name == NULL)
+		return B_BAD_VALUE;
+
+	for (uint32 i = 0; i < fHeader->field_count; i++) {
+		const field_header* field = &fFields[i];
+		if (type != B_ANY_TYPE && field->type != type)
+			continue;
+
+		if (index-- > 0)
+			continue;
+
+		*_name = (const char*)(fData + field->offset);
+		if (_type != NULL)
+			*_type = field->type;
+		if (_count != NULL)
+			*_count = field->count;
+		return B_OK;
+	}
+
+	return type == B_ANY_TYPE ? B_BAD_INDEX : B_BAD_TYPE;
+}
+
+
+status_t
+MessageView::FindData(const FieldName& name, type_code type, int32 index,
+	const void** _data, ssize_t* _size) const
+{
+	if (_data == NULL)
+		return B_BAD_VALUE;
+
+	*_data = NULL;
+	const field_header* field;
+	status_t status = _FindField(name, type, &field);
+	if (status != B_OK)
+		return status;
+
+	if (index < 0 || (uint32)index >= field->count)
+		return B_BAD_INDEX;
+
+	const uint8* pointer = fData + field->offset + field->name_length;
+	if ((field->flags & FIELD_FLAG_FIXED_SIZE) != 0) {
+		size_t size = field->data_size / field->count;
+		*_data = pointer + index * size;
+		if (_size != NULL)
+			*_size = size;
+		return B_OK;
+	}
+
+	// the item sizes have been checked in _Validate()
+	uint32 size;
+	while (true) {
+		memcpy(&size, pointer, sizeof(uint32));
+		pointer += sizeof(uint32);
+		if (index-- == 0)
+			break;
+		pointer += size;
+	}
+
+	*_data = pointer;
+	if (_size != NULL)
+		*_size = size;
+	return B_OK;
+}
+
+
+status_t
+MessageView::FindData(const FieldName& name, type_code type,
+	const void** _data, ssize_t* _size) const
+{
+	return FindData(name, type, 0, _data, _size);
+}
+
+
+/*!	Returns a pointer to the string in the message buffer. */
+status_t
+MessageView::FindString(const FieldName& name, int32 index,
+	const char** _string) const
+{
+	if (_string == NULL)
+		return B_BAD_VALUE;
+
+	const void* data;
+	ssize_t size;
+	status_t status = FindData(name, B_STRING_TYPE, index, &data, &size);
+	if (status != B_OK)
+		return status;
+
+	if (size == 0 || ((const char*)data)[size - 1] != '\0')
+		return B_BAD_DATA;
+
+	*_string = (const char*)data;
+	return B_OK;
+}
+
+
+status_t
+MessageView::FindString(const FieldName& name, const char** _string) const
+{
+	return FindString(name, 0, _string);
+}
+
+
+/*!	Sets \a _message to view the embedded message, without copying it. */
+status_t
+MessageView::FindMessage(const FieldName& name, int32 index,
+	MessageView& _message) const
+{
+	const void* data;
+	ssize_t size;
+	status_t status = FindData(name, B_MESSAGE_TYPE, index, &data, &size);
+	if (status != B_OK) {
+		_message.Unset();
+		return status;
+	}
+
+	return _message.SetTo(data, size);
+}
+
+
+status_t
+MessageView::FindMessage(const FieldName& name, MessageView& _message) const
+{
+	return FindMessage(name, 0, _message);
+}
+
+
+#define DEFINE_FIND_FUNCTIONS(typeName, type, typeCode)						\
+status_t																	\
+MessageView::Find##typeName(const FieldName& name, int32 index,				\
+	type* _value) const														\
+{																			\
+	return _FindFixedSize(name, typeCode, index, _value, sizeof(type));		\
+}																			\
+																			\
+																			\
+status_t																	\
+MessageView::Find##typeName(const FieldName& name, type* _value) const		\
+{																			\
+	return _FindFixedSize(name, typeCode, 0, _value, sizeof(type));			\
+}
+
+
+DEFINE_FIND_FUNCTIONS(Bool, bool, B_BOOL_TYPE)
+DEFINE_FIND_FUNCTIONS(Int8, int8, B_INT8_TYPE)
+DEFINE_FIND_FUNCTIONS(Int16, int16, B_INT16_TYPE)
+DEFINE_FIND_FUNCTIONS(Int32, int32, B_INT32_TYPE)
+DEFINE_FIND_FUNCTIONS(Int64, int64, B_INT64_TYPE)
+DEFINE_FIND_FUNCTIONS(Float, float, B_FLOAT_TYPE)
+DEFINE_FIND_FUNCTIONS(Double, double, B_DOUBLE_TYPE)
+
+#undef DEFINE_FIND_FUNCTIONS
+
+
+status_t
+MessageView::FindPoint(const FieldName& name, int32 index,
+	BPoint* _value) const
+{
+	if (_value == NULL)
+		return B_BAD_VALUE;
+
+	float values[2];
+	status_t status = _FindFixedSize(name, B_POINT_TYPE, index, values,
+		sizeof(values));
+	if (status == B_OK)
+		_value->Set(values[0], values[1]);
+
+	return status;
+}
+
+
+status_t
+MessageView::FindPoint(const FieldName& name, BPoint* _value) const
+{
+	return FindPoint(name, 0, _value);
+}
+
+
+status_t
+MessageView::FindRect(const FieldName& name, int32 index, BRect* _value) const
+{
+	if (_value == NULL)
+		return B_BAD_VALUE;
+
+	float values[4];
+	status_t status = _FindFixedSize(name, B_RECT_TYPE, index, values,
+		sizeof(values));
+	if (status == B_OK)
+		_value->Set(values[0], values[1], values[2], values[3]);
+
+	return status;
+}
+
+
+status_t
+MessageView::FindRect(const FieldName& name, BRect* _value) const
+{
+	return FindRect(name, 0, _value);
+}
+
+
+/*!	Copies the message into \a message, for when it needs to be changed, or
+	must outlive the buffer.
+*/
+status_t
+MessageView::Unflatten(BMessage& message) const
+{
+	if (fStatus != B_OK)
+		return fStatus;
+
+	return message.Unflatten((const char*)fHeader);
+}
+
+
+status_t
+MessageView::_Validate(size_t size) const
+{
+	if (size < sizeof(message_header))
+		return B_BAD_VALUE;
+
+	if (fHeader->format != MESSAGE_FORMAT_HAIKU)
+		return B_NOT_SUPPORTED;
+	if ((fHeader->flags & MESSAGE_FLAG_VALID) == 0)
+		return B_BAD_VALUE;
+	if ((fHeader->flags & MESSAGE_FLAG_PASS_BY_AREA) != 0)
+		return B_NOT_SUPPORTED;
+
+	uint32 fieldCount = fHeader->field_count;
+	uint32 dataSize = fHeader->data_size;
+	if (fHeader->hash_table_size == 0
+		|| fHeader->hash_table_size > MESSAGE_BODY_HASH_TABLE_SIZE
+		|| (uint64)fieldCount * sizeof(field_header) + dataSize
+			> size - sizeof(message_header)) {
+		return B_BAD_VALUE;
+	}
+
+	for (uint32 i = 0; i < fHeader->hash_table_size; i++) {
+		if (fHeader->hash_table[i] >= (int32)fieldCount)
+			return B_BAD_VALUE;
+	}
+
+	const uint8* data = (const uint8*)(fFields + fieldCount);
+
+	for (uint32 i = 0; i < fieldCount; i++) {
+		const field_header* field = &fFields[i];
+		if ((field->flags & FIELD_FLAG_VALID) == 0
+			|| field->name_length == 0 || field->count == 0
+			|| field->next_field >= (int32)fieldCount
+			|| (uint64)field->offset + field->name_length + field->data_size
+				> dataSize
+			|| data[field->offset + field->name_length - 1] != '\0') {
+			return B_BAD_VALUE;
+		}
+
+		if ((field->flags & FIELD_FLAG_FIXED_SIZE) != 0) {
+			if (field->data_size % field->count != 0)
+				return B_BAD_VALUE;
+			continue;
+		}
+
+		// check that all items of variable size fit
+		const uint8* pointer = data + field->offset + field->name_length;
+		size_t left = field->data_size;
+		for (uint32 j = 0; j < field->count; j++) {
+			uint32 itemSize;
+			if (left < sizeof(uint32))
+				return B_BAD_VALUE;
+			memcpy(&itemSize, pointer, sizeof(uint32));
+			pointer += sizeof(uint32);
+			left -= sizeof(uint32);
+
+			if (itemSize > left)
+				return B_BAD_VALUE;
+			pointer += itemSize;
+			left -= itemSize;
+		}
+	}
+
+	return B_OK;
+}
+
+
+status_t
+MessageView::_FindField(const FieldName& name, type_code type,
+	const field_header** _field) const
+{
+	if (fStatus != B_OK)
+		return fStatus;
+	if (name.fName == NULL)
+		return B_BAD_VALUE;
+
+	const field_header* field = NULL;
+
+	int32 hint = name.fHint;
+	if (hint >= 0 && (uint32)hint < fHeader->field_count) {
+		const field_header* candidate = &fFields[hint];
+		if (candidate->name_length == name.fLength + 1
+			&& memcmp(fData + candidate->offset, name.fName, name.fLength)
+				== 0) {
+			field = candidate;
+		}
+	}
+
+	if (field == NULL) {
+		int32 next = fHeader->hash_table[name.fHash
+			% fHeader->hash_table_size];
+
+		// the chain length is bounded, in case the message contains a loop
+		for (uint32 i = 0; next >= 0 && i < fHeader->field_count; i++) {
+			const field_header* candidate = &fFields[next];
+			if (candidate->name_length == name.fLength + 1
+				&& memcmp(fData + candidate->offset, name.fName, name.fLength)
+					== 0) {
+				field = candidate;
+				name.fHint = next;
+				break;
+			}
+
+			next = candidate->next_field;
+		}
+
+		if (field == NULL)
+			return B_NAME_NOT_FOUND;
+	}
+
+	if (type != B_ANY_TYPE && field->type != type)
+		return B_BAD_TYPE;
+
+	*_field = field;
+	return B_OK;
+}
+
+
+status_t
+MessageView::_FindFixedSize(const FieldName& name, type_code type,
+	int32 index, void* value, size_t size) const
+{
+	if (value == NULL)
+		return B_BAD_VALUE;
+
+	const void* data;
+	ssize_t dataSize;
+	status_t status = FindData(name, type, index, &data, &dataSize);
+	if (status != B_OK)
+		return status;
+
+	if ((size_t)dataSize != size)
+		return B_BAD_DATA;
+
+	memcpy(value, data, size);
+	return B_OK;
+}
+
+
+}	// namespace BPrivate
@@ -13,6 +13,10 @@
 
 
 static const int32 kLinkCode = '_PTL';
+static const int32 kLinkRingCode = '_PTR';
+	// a batch sent through the port while a LinkRing is in use
+static const int32 kLinkRingWakeupCode = '_PTW';
+	// empty message telling the receiver to look into its LinkRing
 
 static const size_t kInitialBufferSize = 2048;
 static const size_t kMaxBufferSize = 65536;
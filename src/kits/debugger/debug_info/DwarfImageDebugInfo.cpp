@@ -341,6 +341,7 @@ DwarfImageDebugInfo::DwarfImageDebugInfo(const ImageInfo& imageInfo,
 	fTypeCache(typeCache),
 	fSourceInfo(sourceInfo),
 	fTypeNameTable(NULL),
+	fAllTypeNamesAdded(false),
 	fFile(file),
 	fTextSegment(NULL),
 	fRelocationDelta(0),
@@ -396,7 +397,22 @@ DwarfImageDebugInfo::Init()
 		fPLTSectionEnd = fPLTSectionStart + section->Size();
 	}
 
-	return _BuildTypeNameTable();
+	// The type names are added when they are first looked up.
+	fTypeNameTable = new(std::nothrow) TypeNameTable;
+	if (fTypeNameTable == NULL)
+		return B_NO_MEMORY;
+
+	error = fTypeNameTable->Init();
+	if (error != B_OK)
+		return error;
+
+	int32 unitCount = fFile->CountCompilationUnits();
+	if (!fTypeNamesAdded.AddUninitialized(unitCount))
+		return B_NO_MEMORY;
+	for (int32 i = 0; i < unitCount; i++)
+		fTypeNamesAdded[i] = false;
+
+	return B_OK;
 }
 
 
@@ -408,9 +424,14 @@ DwarfImageDebugInfo::GetFunctions(const BObjectList<SymbolInfo, true>& symbols,
 	TRACE_IMAGES("  %" B_PRId32 " compilation units\n",
 		fFile->CountCompilationUnits());
 
-	status_t error = B_OK;
-	for (int32 i = 0; CompilationUnit* unit = fFile->CompilationUnitAt(i);
-			i++) {
+	// the functions of all units are needed
+	status_t error = fFile->LoadCompilationUnits();
+	if (error != B_OK)
+		return error;
+
+	int32 unitCount = fFile->CountCompilationUnits();
+	for (int32 i = 0; i < unitCount; i++) {
+		CompilationUnit* unit = fFile->CompilationUnitAt(i);
 		DIECompileUnitBase* unitEntry = unit->UnitEntry();
 //		printf("  %s:\n", unitEntry->Name());
 //		printf("    address ranges:\n");
@@ -467,11 +488,12 @@ status_t
 DwarfImageDebugInfo::GetType(GlobalTypeCache* cache, const BString& name,
 	const TypeLookupConstraints& constraints, Type*& _type)
 {
-	TypeNameEntry* entry = fTypeNameTable->Lookup(name);
-	if (entry == NULL)
-		return B_ENTRY_NOT_FOUND;
+	TypeEntryInfoList types;
+	status_t error = _GetTypeEntries(name, types);
+	if (error != B_OK)
+		return error;
 
-	for (int32 i = 0; TypeEntryInfo* info = entry->types.ItemAt(i); i++) {
+	for (int32 i = 0; TypeEntryInfo* info = types.ItemAt(i); i++) {
 		DIEType* typeEntry = info->type;
 		if (constraints.HasTypeKind()) {
 			if (dwarf_tag_to_type_kind(typeEntry->Tag())
@@ -495,7 +517,7 @@ DwarfImageDebugInfo::GetType(GlobalTypeCache* cache, const BString& name,
 		// get the DWARF <-> architecture register maps
 		RegisterMap* toDwarfMap;
 		RegisterMap* fromDwarfMap;
-		status_t error = fArchitecture->GetDwarfRegisterMaps(&toDwarfMap,
+		error = fArchitecture->GetDwarfRegisterMaps(&toDwarfMap,
 			&fromDwarfMap);
 		if (error != B_OK)
 			return error;
@@ -539,11 +561,14 @@ bool
 DwarfImageDebugInfo::HasType(const BString& name,
 	const TypeLookupConstraints& constraints) const
 {
-	TypeNameEntry* entry = fTypeNameTable->Lookup(name);
-	if (entry == NULL)
+	// the type name table is filled lazily
+	TypeEntryInfoList types;
+	if (const_cast<DwarfImageDebugInfo*>(this)->_GetTypeEntries(name, types)
+			!= B_OK) {
 		return false;
+	}
 
-	for (int32 i = 0; TypeEntryInfo* info = entry->types.ItemAt(i); i++) {
+	for (int32 i = 0; TypeEntryInfo* info = types.ItemAt(i); i++) {
 		DIEType* typeEntry = info->type;
 		if (constraints.HasTypeKind()) {
 			if (dwarf_tag_to_type_kind(typeEntry->Tag())
@@ -647,7 +672,9 @@ DwarfImageDebugInfo::CreateFrame(Image* image,
 	target_addr_t framePointer;
 	CompilationUnit* unit = function != NULL ? function->GetCompilationUnit()
 			: NULL;
-	error = fFile->UnwindCallFrame(unit,
+	CompilationUnit* unwindUnit = unit != NULL
+		? unit : fFile->CompilationUnitForAddress(instructionPointer);
+	error = fFile->UnwindCallFrame(unwindUnit,
 		fArchitecture->AddressSize(), fArchitecture->IsBigEndian(),
 		entry, instructionPointer, inputInterface, outputInterface,
 		framePointer);
@@ -992,14 +1019,20 @@ status_t
 DwarfImageDebugInfo::AddSourceCodeInfo(LocatableFile* file,
 	FileSourceCode* sourceCode)
 {
+	// any unit might refer to the file
+	status_t error = fFile->LoadCompilationUnits();
+	if (error != B_OK)
+		return error;
+
 	bool addedAny = false;
-	for (int32 i = 0; CompilationUnit* unit = fFile->CompilationUnitAt(i);
-			i++) {
+	int32 unitCount = fFile->CountCompilationUnits();
+	for (int32 i = 0; i < unitCount; i++) {
+		CompilationUnit* unit = fFile->CompilationUnitAt(i);
 		int32 fileIndex = _GetSourceFileIndex(unit, file);
 		if (fileIndex < 0)
 			continue;
 
-		status_t error = _AddSourceCodeInfo(unit, sourceCode, fileIndex);
+		error = _AddSourceCodeInfo(unit, sourceCode, fileIndex);
 		if (error == B_NO_MEMORY)
 			return error;
 		addedAny |= error == B_OK;
@@ -1434,40 +1467,93 @@ DwarfImageDebugInfo::_AddFunction(DIESubprogram* subprogramEntry,
 }
 
 
+/*!	Returns the types named \a name. Before they are looked up, the types of
+	the compilation units that may define the name according to the index of
+	the file are added to the type name table. Without an index, the types of
+	all units are added at once.
+	The entries in the table are never removed, so that the returned types
+	can be used without holding the lock.
+*/
 status_t
-DwarfImageDebugInfo::_BuildTypeNameTable()
+DwarfImageDebugInfo::_GetTypeEntries(const BString& name,
+	TypeEntryInfoList& _types)
 {
-	fTypeNameTable = new(std::nothrow) TypeNameTable;
-	if (fTypeNameTable == NULL)
-		return B_NO_MEMORY;
+	AutoLocker<BLocker> locker(fLock);
 
-	status_t error = fTypeNameTable->Init();
-	if (error != B_OK)
-		return error;
+	if (!fAllTypeNamesAdded) {
+		Array<int32> unitIndices;
+		status_t error = fFile->GetCompilationUnitsForTypeName(name,
+			unitIndices);
+		if (error == B_UNSUPPORTED)
+			error = _AddAllTypeNames();
+		for (int32 i = 0; error == B_OK && i < unitIndices.Count(); i++)
+			error = _AddTypeNames(unitIndices[i]);
+		if (error != B_OK)
+			return error;
+	}
 
-	// iterate through all compilation units
-	for (int32 i = 0; CompilationUnit* unit = fFile->CompilationUnitAt(i);
-		i++) {
-		// iterate through all types of the compilation unit
-		for (DebugInfoEntryList::ConstIterator it
-				= unit->UnitEntry()->Types().GetIterator();
-			DIEType* typeEntry = dynamic_cast<DIEType*>(it.Next());) {
+	TypeNameEntry* entry = fTypeNameTable->Lookup(name);
+	if (entry == NULL)
+		return B_ENTRY_NOT_FOUND;
 
-			if (_RecursiveAddTypeNames(typeEntry, unit) != B_OK)
-				return B_NO_MEMORY;
-		}
+	for (int32 i = 0; TypeEntryInfo* info = entry->types.ItemAt(i); i++) {
+		if (!_types.AddItem(info))
+			return B_NO_MEMORY;
+	}
 
-		for (DebugInfoEntryList::ConstIterator it
-			= unit->UnitEntry()->OtherChildren().GetIterator();
-			DebugInfoEntry* child = it.Next();) {
-			DIENamespace* namespaceEntry = dynamic_cast<DIENamespace*>(child);
-			if (namespaceEntry == NULL)
-				continue;
+	return B_OK;
+}
 
-			if (_RecursiveTraverseNamespaceForTypes(namespaceEntry, unit)
-					!= B_OK) {
-				return B_NO_MEMORY;
-			}
+
+status_t
+DwarfImageDebugInfo::_AddAllTypeNames()
+{
+	// parse all units in one go, rather than one by one
+	fFile->LoadCompilationUnits();
+
+	int32 unitCount = fFile->CountCompilationUnits();
+	for (int32 i = 0; i < unitCount; i++) {
+		status_t error = _AddTypeNames(i);
+		if (error != B_OK)
+			return error;
+	}
+
+	fAllTypeNamesAdded = true;
+	return B_OK;
+}
+
+
+status_t
+DwarfImageDebugInfo::_AddTypeNames(int32 unitIndex)
+{
+	if (fTypeNamesAdded[unitIndex])
+		return B_OK;
+	fTypeNamesAdded[unitIndex] = true;
+
+	// a unit that can't be loaded doesn't define any types
+	CompilationUnit* unit = fFile->CompilationUnitAt(unitIndex);
+	if (unit == NULL)
+		return B_OK;
+
+	// iterate through all types of the compilation unit
+	for (DebugInfoEntryList::ConstIterator it
+			= unit->UnitEntry()->Types().GetIterator();
+		DIEType* typeEntry = dynamic_cast<DIEType*>(it.Next());) {
+
+		if (_RecursiveAddTypeNames(typeEntry, unit) != B_OK)
+			return B_NO_MEMORY;
+	}
+
+	for (DebugInfoEntryList::ConstIterator it
+		= unit->UnitEntry()->OtherChildren().GetIterator();
+		DebugInfoEntry* child = it.Next();) {
+		DIENamespace* namespaceEntry = dynamic_cast<DIENamespace*>(child);
+		if (namespaceEntry == NULL)
+			continue;
+
+		if (_RecursiveTraverseNamespaceForTypes(namespaceEntry, unit)
+				!= B_OK) {
+			return B_NO_MEMORY;
 		}
 	}
 
@@ -7,6 +7,7 @@
 #define DWARF_IMAGE_DEBUG_INFO_H
 
 
+#include <Array.h>
 #include <Locker.h>
 
 #include <util/OpenHashTable.h>
@@ -106,6 +107,7 @@ private:
 
 			struct TypeEntryInfo;
 			typedef BObjectList<TypeEntryInfo, true> TypeEntryList;
+			typedef BObjectList<TypeEntryInfo> TypeEntryInfoList;
 
 private:
 			status_t 			_AddSourceCodeInfo(CompilationUnit* unit,
@@ -140,7 +142,10 @@ private:
 									CompilationUnit* unit,
 									BObjectList<FunctionDebugInfo>& functions);
 
-			status_t			_BuildTypeNameTable();
+			status_t			_GetTypeEntries(const BString& name,
+									TypeEntryInfoList& _types);
+			status_t			_AddAllTypeNames();
+			status_t			_AddTypeNames(int32 unitIndex);
 			status_t			_RecursiveAddTypeNames(DIEType* type,
 									CompilationUnit* unit);
 			status_t			_RecursiveTraverseNamespaceForTypes(
@@ -157,6 +162,9 @@ private:
 			GlobalTypeCache*	fTypeCache;
 			TeamFunctionSourceInformation* fSourceInfo;
 			TypeNameTable*		fTypeNameTable;
+			Array<bool>			fTypeNamesAdded;
+									// per compilation unit
+			bool				fAllTypeNamesAdded;
 			DwarfFile*			fFile;
 			ElfSegment*			fTextSegment;
 			target_addr_t		fRelocationDelta;
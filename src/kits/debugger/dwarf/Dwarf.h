@@ -613,6 +613,17 @@ enum {
 	DW_UT_hi_user				= 0xff
 };
 
+// name index attributes (.debug_names)
+enum {
+	DW_IDX_compile_unit			= 0x01,
+	DW_IDX_type_unit			= 0x02,
+	DW_IDX_die_offset			= 0x03,
+	DW_IDX_parent				= 0x04,
+	DW_IDX_type_hash			= 0x05,
+	DW_IDX_lo_user				= 0x2000,
+	DW_IDX_hi_user				= 0x3fff
+};
+
 
 enum dwarf_reference_type {
 	dwarf_reference_type_local = 0,
@@ -11,8 +11,10 @@
 #include <new>
 
 #include <AutoDeleter.h>
+#include <AutoLocker.h>
 #include <Entry.h>
 #include <FindDirectory.h>
+#include <OS.h>
 #include <Path.h>
 #include <PathFinder.h>
 
@@ -31,6 +33,47 @@
 #include "Variant.h"
 
 
+static const int32 kMaxUnitProcessingThreads = 8;
+static const int32 kMinUnitsPerThread = 4;
+
+
+enum {
+	UNIT_STATE_UNPARSED = 0,
+	UNIT_STATE_PARSED,
+	UNIT_STATE_FINISHED,
+	UNIT_STATE_FAILED
+};
+
+
+/*!	Returns the hash of the unqualified part of \a name, i.e. without any
+	enclosing namespaces or classes, as the indices may use either form.
+	Template arguments are ignored as well, since they may be spelled
+	differently, and may contain "::" themselves. Collisions don't matter, as
+	the hash only selects the units to look at.
+*/
+static uint32
+hash_unqualified_name(const char* name)
+{
+	const char* baseName = name;
+	int32 depth = 0;
+	for (const char* c = name; *c != '\0'; c++) {
+		if (*c == '<')
+			depth++;
+		else if (*c == '>')
+			depth--;
+		else if (depth == 0 && c[0] == ':' && c[1] == ':')
+			baseName = c + 2;
+	}
+
+	uint32 hash = 5381;
+	for (const char* c = baseName; *c != '\0' && (*c != '<' || c == baseName);
+			c++) {
+		hash = hash * 33 + (uint8)*c;
+	}
+	return hash;
+}
+
+
 // #pragma mark - AutoSectionPutter
 
 
@@ -55,6 +98,52 @@ private:
 };
 
 
+// #pragma mark - UnitProcessingContext
+
+
+struct DwarfFile::UnitProcessingContext {
+	DwarfFile*	file;
+	bool		finish;
+	int32		nextUnit;
+	status_t	error;
+};
+
+
+// #pragma mark - AddressIndexEntry
+
+
+struct DwarfFile::AddressIndexEntry {
+	target_addr_t	start;
+	target_addr_t	end;
+	int32			unit;
+
+	bool operator<(const AddressIndexEntry& other) const
+	{
+		return start < other.start;
+	}
+};
+
+
+// #pragma mark - NameIndexEntry
+
+
+struct DwarfFile::NameIndexEntry {
+	uint32			hash;
+	int32			unit;
+
+	bool operator<(const NameIndexEntry& other) const
+	{
+		return hash < other.hash
+			|| (hash == other.hash && unit < other.unit);
+	}
+
+	bool operator==(const NameIndexEntry& other) const
+	{
+		return hash == other.hash && unit == other.unit;
+	}
+};
+
+
 // #pragma mark - ExpressionEvaluationContext
 
 
@@ -152,7 +241,8 @@ public:
 		const void*& _block, off_t& _size)
 	{
 		// resolve the entry
-		DebugInfoEntry* entry = fFile->_ResolveReference(fUnit, offset, refType);
+		DebugInfoEntry* entry = fFile->_ResolveLoadedReference(fUnit, offset,
+			refType);
 		if (entry == NULL)
 			return B_ENTRY_NOT_FOUND;
 
@@ -504,10 +594,11 @@ DwarfFile::DwarfFile()
 	fDebugPublicTypesSection(NULL),
 	fDebugTypesSection(NULL),
 	fCompilationUnits(20),
+	fUnitLock("dwarf units"),
+	fHasNameIndex(false),
 	fTypeUnits(),
 	fDebugFrameInfos(100),
 	fEHFrameInfos(100),
-	fTypesSectionRequired(false),
 	fFinished(false),
 	fItaniumEHFrameFormat(false),
 	fFinishError(B_OK)
@@ -536,6 +627,7 @@ DwarfFile::~DwarfFile()
 		fElfFile->PutSection(fEHFrameSection);
 		debugInfoFile->PutSection(fDebugLocationSection);
 		debugInfoFile->PutSection(fDebugPublicTypesSection);
+		debugInfoFile->PutSection(fDebugTypesSection);
 		delete fElfFile;
 		delete fAlternateElfFile;
 	}
@@ -634,18 +726,17 @@ DwarfFile::Load(uint8 addressSize, bool isBigEndian, const BString& externalInfo
 	if (error != B_OK)
 		return error;
 
-	if (fTypesSectionRequired) {
-		fDebugTypesSection = debugInfoFile->GetSection(".debug_types");
-		if (fDebugTypesSection == NULL) {
-			WARNING(".debug_types section required but missing.\n");
-			return B_BAD_DATA;
-		}
+	// Whether the compilation units refer to type units is only known once
+	// their DIEs are parsed, so the type units are always parsed if there
+	// are any.
+	fDebugTypesSection = debugInfoFile->GetSection(".debug_types");
+	if (fDebugTypesSection != NULL) {
 		error = _ParseTypesSection(addressSize, isBigEndian);
 		if (error != B_OK)
 			return error;
 	}
 
-	return B_OK;
+	return _BuildIndex(debugInfoFile, addressSize, isBigEndian);
 }
 
 
@@ -665,15 +756,8 @@ DwarfFile::FinishLoading(uint8 addressSize, bool isBigEndian)
 			return fFinishError = error;
 	}
 
-	for (int32 i = 0; CompilationUnit* unit = fCompilationUnits.ItemAt(i);
-			i++) {
-		error = _FinishUnit(unit);
-		if (error != B_OK)
-			return fFinishError = error;
-	}
-
-	_ParsePublicTypesInfo(addressSize, isBigEndian);
-
+	// The compilation units may refer to the type units, but not vice versa.
+	// They are parsed and finished when they are first asked for.
 	fFinished = true;
 	return B_OK;
 }
@@ -687,14 +771,53 @@ DwarfFile::CountCompilationUnits() const
 
 
 CompilationUnit*
-DwarfFile::CompilationUnitAt(int32 index) const
+DwarfFile::CompilationUnitAt(int32 index)
 {
+	if (index < 0 || index >= fCompilationUnits.CountItems())
+		return NULL;
+
+	AutoLocker<BLocker> locker(fUnitLock);
+	if (_LoadCompilationUnit(index) != B_OK)
+		return NULL;
+
 	return fCompilationUnits.ItemAt(index);
 }
 
 
+/*!	Parses and finishes all compilation units that haven't been yet, spread
+	over a few threads. Better than calling CompilationUnitAt() for every
+	unit, when all of them are needed anyway. Fails, if any of the units
+	cannot be loaded.
+*/
+status_t
+DwarfFile::LoadCompilationUnits()
+{
+	if (!fFinished)
+		return B_NO_INIT;
+
+	AutoLocker<BLocker> locker(fUnitLock);
+
+	bool allFinished = true;
+	for (int32 i = 0; i < fUnitStates.Count(); i++) {
+		if (fUnitStates[i] == UNIT_STATE_FAILED)
+			return B_BAD_DATA;
+		if (fUnitStates[i] != UNIT_STATE_FINISHED)
+			allFinished = false;
+	}
+	if (allFinished)
+		return B_OK;
+
+	// all units must be parsed, before any can be finished
+	status_t error = _ProcessCompilationUnits(false);
+	if (error != B_OK)
+		return error;
+
+	return _ProcessCompilationUnits(true);
+}
+
+
 CompilationUnit*
-DwarfFile::CompilationUnitForDIE(const DebugInfoEntry* entry) const
+DwarfFile::CompilationUnitForDIE(const DebugInfoEntry* entry)
 {
 	// find the root of the tree the entry lives in
 	while (entry != NULL && entry->Parent() != NULL)
@@ -706,7 +829,9 @@ DwarfFile::CompilationUnitForDIE(const DebugInfoEntry* entry) const
 	if (unitEntry == NULL)
 		return NULL;
 
-	// find the compilation unit
+	// find the compilation unit -- it has been parsed already, or the entry
+	// wouldn't exist
+	AutoLocker<BLocker> locker(fUnitLock);
 	for (int32 i = 0; CompilationUnit* unit = fCompilationUnits.ItemAt(i);
 			i++) {
 		if (unit->UnitEntry() == unitEntry)
@@ -717,6 +842,85 @@ DwarfFile::CompilationUnitForDIE(const DebugInfoEntry* entry) const
 }
 
 
+/*!	Returns the compilation unit whose code contains \a address, which is
+	not relocated. Only that unit is parsed, if .debug_aranges lists it.
+	Otherwise all units are loaded to find it.
+*/
+CompilationUnit*
+DwarfFile::CompilationUnitForAddress(target_addr_t address)
+{
+	if (!fAddressIndex.IsEmpty()) {
+		// find the last range starting at or before the address
+		int32 lower = 0;
+		int32 upper = fAddressIndex.Count();
+		while (lower < upper) {
+			int32 mid = (lower + upper) / 2;
+			if (fAddressIndex[mid].start <= address)
+				lower = mid + 1;
+			else
+				upper = mid;
+		}
+
+		if (lower > 0 && address < fAddressIndex[lower - 1].end)
+			return CompilationUnitAt(fAddressIndex[lower - 1].unit);
+		return NULL;
+	}
+
+	if (LoadCompilationUnits() != B_OK)
+		return NULL;
+
+	for (int32 i = 0; i < fCompilationUnits.CountItems(); i++) {
+		CompilationUnit* unit = CompilationUnitAt(i);
+		if (unit == NULL)
+			continue;
+
+		if (TargetAddressRangeList* ranges = unit->AddressRanges()) {
+			if (ranges->Contains(address))
+				return unit;
+		} else if (address >= unit->UnitEntry()->LowPC()
+			&& address < unit->UnitEntry()->HighPC()) {
+			return unit;
+		}
+	}
+
+	return NULL;
+}
+
+
+/*!	Returns the indices of the compilation units that may define a type (or
+	anything else) named \a name, according to .debug_names or
+	.debug_pubtypes. The list may contain units that don't, but none that do
+	is missing. Returns \c B_UNSUPPORTED, if the file has no such index.
+*/
+status_t
+DwarfFile::GetCompilationUnitsForTypeName(const char* name,
+	Array<int32>& _unitIndices) const
+{
+	if (!fHasNameIndex)
+		return B_UNSUPPORTED;
+
+	NameIndexEntry key;
+	key.hash = hash_unqualified_name(name);
+	key.unit = -1;
+
+	const NameIndexEntry* begin = fNameIndex.Elements();
+	const NameIndexEntry* end = begin + fNameIndex.Count();
+	for (const NameIndexEntry* entry = std::lower_bound(begin, end, key);
+			entry != end && entry->hash == key.hash; entry++) {
+		if (!_unitIndices.Add(entry->unit))
+			return B_NO_MEMORY;
+	}
+
+	// the units the index doesn't cover may define anything
+	for (int32 i = 0; i < fUnindexedUnits.Count(); i++) {
+		if (!_unitIndices.Add(fUnindexedUnits[i]))
+			return B_NO_MEMORY;
+	}
+
+	return B_OK;
+}
+
+
 TargetAddressRangeList*
 DwarfFile::ResolveRangeList(CompilationUnit* unit, uint64 offset) const
 {
@@ -1055,15 +1259,23 @@ DwarfFile::_ParseDebugInfoSection(uint8 _addressSize, bool isBigEndian)
 			delete unit;
 			return B_NO_MEMORY;
 		}
+		if (!fUnitStates.Add(UNIT_STATE_UNPARSED))
+			return B_NO_MEMORY;
 
-		// parse the debug info for the unit
-		status_t error = _ParseCompilationUnit(unit);
+		// Get the abbreviation table right away, as the list of tables is
+		// shared between all units.
+		AbbreviationTable* abbreviationTable;
+		status_t error = _GetAbbreviationTable(abbrevOffset,
+			abbreviationTable);
 		if (error != B_OK)
 			return error;
 
+		unit->SetAbbreviationTable(abbreviationTable);
+
 		dataReader.SeekAbsolute(unitLengthOffset + unitLength);
 	}
 
+	// The DIEs of the units are parsed only when they are needed.
 	return B_OK;
 }
 
@@ -1279,13 +1491,16 @@ DwarfFile::_ParseFrameSection(ElfSection* section, uint8 addressSize, bool isBig
 status_t
 DwarfFile::_ParseCompilationUnit(CompilationUnit* unit)
 {
-	AbbreviationTable* abbreviationTable;
-	status_t error = _GetAbbreviationTable(unit->AbbreviationOffset(),
-		abbreviationTable);
-	if (error != B_OK)
-		return error;
+	status_t error;
+	AbbreviationTable* abbreviationTable = unit->GetAbbreviationTable();
+	if (abbreviationTable == NULL) {
+		error = _GetAbbreviationTable(unit->AbbreviationOffset(),
+			abbreviationTable);
+		if (error != B_OK)
+			return error;
 
-	unit->SetAbbreviationTable(abbreviationTable);
+		unit->SetAbbreviationTable(abbreviationTable);
+	}
 
 	DataReader dataReader(
 		(const uint8*)fDebugInfoSection->Data() + unit->ContentOffset(),
@@ -1320,6 +1535,165 @@ DwarfFile::_ParseCompilationUnit(CompilationUnit* unit)
 }
 
 
+/*!	Parses (or, if \a finish is \c true, finishes) all compilation units
+	that haven't been yet. The units are independent of each other at this
+	point, so that they are spread over a few threads when there are enough of
+	them. Only the unit itself is changed while it is processed; everything
+	shared between the units, like the abbreviation tables, must already
+	exist. Finishing resolves references between the units, so all of them
+	must have been parsed before.
+
+	Units are otherwise loaded one at a time by _LoadCompilationUnit(), when
+	they are asked for. The caller must hold \c fUnitLock.
+*/
+status_t
+DwarfFile::_ProcessCompilationUnits(bool finish)
+{
+	UnitProcessingContext context;
+	context.file = this;
+	context.finish = finish;
+	context.nextUnit = 0;
+	context.error = B_OK;
+
+	int32 threadCount = 1;
+	system_info info;
+	if (get_system_info(&info) == B_OK)
+		threadCount = info.cpu_count;
+	threadCount = std::min(threadCount, kMaxUnitProcessingThreads);
+	threadCount = std::min(threadCount,
+		fCompilationUnits.CountItems() / kMinUnitsPerThread);
+
+	thread_id threads[kMaxUnitProcessingThreads];
+	int32 spawnedCount = 0;
+	for (int32 i = 1; i < threadCount; i++) {
+		thread_id thread = spawn_thread(&_ProcessCompilationUnitsThread,
+			finish ? "dwarf finish units" : "dwarf parse units",
+			B_NORMAL_PRIORITY, &context);
+		if (thread < 0)
+			break;
+
+		threads[spawnedCount++] = thread;
+		resume_thread(thread);
+	}
+
+	// do our share of the work as well
+	_ProcessCompilationUnitsThread(&context);
+
+	for (int32 i = 0; i < spawnedCount; i++) {
+		status_t result;
+		wait_for_thread(threads[i], &result);
+	}
+
+	if (!finish)
+		return context.error;
+
+	// The finishing threads may look at the states of other units, so they
+	// are only updated now. After a failure it is unknown which units have
+	// been finished completely.
+	for (int32 i = 0; i < fUnitStates.Count(); i++) {
+		if (fUnitStates[i] == UNIT_STATE_PARSED) {
+			fUnitStates[i] = context.error == B_OK
+				? UNIT_STATE_FINISHED : UNIT_STATE_FAILED;
+		}
+	}
+
+	return context.error;
+}
+
+
+/*static*/ status_t
+DwarfFile::_ProcessCompilationUnitsThread(void* data)
+{
+	UnitProcessingContext* context = (UnitProcessingContext*)data;
+	DwarfFile* file = context->file;
+
+	while (atomic_get(&context->error) == B_OK) {
+		int32 index = atomic_add(&context->nextUnit, 1);
+		CompilationUnit* unit = file->fCompilationUnits.ItemAt(index);
+		if (unit == NULL)
+			break;
+
+		uint8& state = file->fUnitStates[index];
+		status_t error;
+		if (context->finish) {
+			if (state != UNIT_STATE_PARSED)
+				continue;
+			error = file->_FinishUnit(unit);
+		} else {
+			if (state != UNIT_STATE_UNPARSED)
+				continue;
+			error = file->_ParseCompilationUnit(unit);
+			state = error == B_OK ? UNIT_STATE_PARSED : UNIT_STATE_FAILED;
+		}
+
+		if (error != B_OK)
+			atomic_test_and_set(&context->error, error, B_OK);
+	}
+
+	return B_OK;
+}
+
+
+/*!	Parses and finishes the compilation unit at \a index, if that hasn't
+	happened yet. The units it refers to are parsed as well, and are finished
+	before this method returns, so that no unfinished entry can be reached
+	from a finished unit. The caller must hold \c fUnitLock.
+*/
+status_t
+DwarfFile::_LoadCompilationUnit(int32 index)
+{
+	if (!fFinished)
+		return B_NO_INIT;
+
+	switch (fUnitStates[index]) {
+		case UNIT_STATE_FINISHED:
+			return B_OK;
+		case UNIT_STATE_FAILED:
+			return B_BAD_DATA;
+		case UNIT_STATE_UNPARSED:
+		{
+			status_t error = _ParseCompilationUnitAt(index);
+			if (error != B_OK)
+				return error;
+			break;
+		}
+	}
+
+	// finish the unit, and everything that got parsed on the way
+	while (!fUnitsToFinish.IsEmpty()) {
+		int32 unitIndex = fUnitsToFinish[fUnitsToFinish.Count() - 1];
+		fUnitsToFinish.Remove(fUnitsToFinish.Count() - 1);
+
+		status_t error = _FinishUnit(fCompilationUnits.ItemAt(unitIndex));
+		fUnitStates[unitIndex] = error == B_OK
+			? UNIT_STATE_FINISHED : UNIT_STATE_FAILED;
+	}
+
+	return fUnitStates[index] == UNIT_STATE_FINISHED ? B_OK : B_BAD_DATA;
+}
+
+
+/*!	Parses the DIEs of the compilation unit at \a index, and queues it to be
+	finished by _LoadCompilationUnit(). The caller must hold \c fUnitLock.
+*/
+status_t
+DwarfFile::_ParseCompilationUnitAt(int32 index)
+{
+	if (!fUnitsToFinish.Add(index))
+		return B_NO_MEMORY;
+
+	status_t error = _ParseCompilationUnit(fCompilationUnits.ItemAt(index));
+	if (error != B_OK) {
+		fUnitsToFinish.Remove(fUnitsToFinish.Count() - 1);
+		fUnitStates[index] = UNIT_STATE_FAILED;
+		return error;
+	}
+
+	fUnitStates[index] = UNIT_STATE_PARSED;
+	return B_OK;
+}
+
+
 status_t
 DwarfFile::_ParseTypeUnit(TypeUnit* unit)
 {
@@ -1761,7 +2135,10 @@ DwarfFile::_ParseEntryAttributes(DataReader& dataReader,
 				break;
 			}
 			case DW_FORM_ref_sig8:
-				fTypesSectionRequired = true;
+				if (fDebugTypesSection == NULL) {
+					WARNING(".debug_types section required but missing.\n");
+					return B_BAD_DATA;
+				}
 				value = dataReader.Read<uint64>(0);
 				refType = dwarf_reference_type_signature;
 				break;
@@ -2993,8 +3370,342 @@ DwarfFile::_ParseFrameInfoInstructions(CompilationUnit* unit,
 }
 
 
+/*!	Builds the indices that allow to find single compilation units without
+	parsing all of them: the address ranges of the units from .debug_aranges,
+	and the names defined by them from .debug_names or .debug_pubtypes.
+	Without these, all units need to be parsed to look something up.
+*/
+status_t
+DwarfFile::_BuildIndex(ElfFile* debugInfoFile, uint8 addressSize,
+	bool isBigEndian)
+{
+	ElfSection* section = debugInfoFile->GetSection(".debug_aranges");
+	AutoSectionPutter addressRangesPutter(debugInfoFile, section);
+	if (section != NULL) {
+		status_t error = _ParseAddressRangesSection(section, addressSize,
+			isBigEndian);
+		if (error == B_NO_MEMORY)
+			return error;
+		if (error != B_OK) {
+			WARNING("\"%s\": Ignoring .debug_aranges: %s\n", fName,
+				strerror(error));
+			fAddressIndex.MakeEmpty();
+		}
+
+		std::sort(fAddressIndex.Elements(),
+			fAddressIndex.Elements() + fAddressIndex.Count());
+	}
+
+	// units not covered by the name index must always be looked at
+	Array<bool> indexedUnits;
+	if (!indexedUnits.AddUninitialized(fCompilationUnits.CountItems()))
+		return B_NO_MEMORY;
+	for (int32 i = 0; i < indexedUnits.Count(); i++)
+		indexedUnits[i] = false;
+
+	section = debugInfoFile->GetSection(".debug_names");
+	AutoSectionPutter namesPutter(debugInfoFile, section);
+	status_t error = section != NULL
+		? _ParseNamesSection(section, addressSize, isBigEndian, indexedUnits)
+		: _ParsePublicTypesInfo(addressSize, isBigEndian, indexedUnits);
+	if (error == B_NO_MEMORY)
+		return error;
+	if (error != B_OK) {
+		fNameIndex.MakeEmpty();
+		return B_OK;
+	}
+
+	for (int32 i = 0; i < indexedUnits.Count(); i++) {
+		if (!indexedUnits[i] && !fUnindexedUnits.Add(i))
+			return B_NO_MEMORY;
+	}
+
+	NameIndexEntry* entries = fNameIndex.Elements();
+	std::sort(entries, entries + fNameIndex.Count());
+	int32 count = std::unique(entries, entries + fNameIndex.Count())
+		- entries;
+	fNameIndex.Remove(count, fNameIndex.Count() - count);
+
+	fHasNameIndex = true;
+	return B_OK;
+}
+
+
+status_t
+DwarfFile::_ParseAddressRangesSection(ElfSection* section, uint8 addressSize,
+	bool isBigEndian)
+{
+	DataReader dataReader(section->Data(), section->Size(), addressSize,
+		isBigEndian);
+
+	while (dataReader.HasData()) {
+		bool dwarf64;
+		uint64 length = dataReader.ReadInitialLength(dwarf64);
+
+		off_t lengthOffset = dataReader.Offset();
+			// the length starts here
+
+		if (dataReader.HasOverflow()
+			|| lengthOffset + length > (uint64)section->Size()) {
+			return B_BAD_DATA;
+		}
+
+		uint16 version = dataReader.Read<uint16>(0);
+		off_t debugInfoOffset = dwarf64
+			? dataReader.Read<uint64>(0)
+			: dataReader.Read<uint32>(0);
+		uint8 setAddressSize = dataReader.Read<uint8>(0);
+		uint8 segmentSelectorSize = dataReader.Read<uint8>(0);
+
+		if (dataReader.HasOverflow())
+			return B_BAD_DATA;
+
+		if (version != 2 || segmentSelectorSize != 0
+			|| (setAddressSize != 4 && setAddressSize != 8)) {
+			return B_UNSUPPORTED;
+		}
+
+		int32 unitIndex = _GetContainingCompilationUnit(debugInfoOffset);
+		if (unitIndex < 0)
+			return B_BAD_DATA;
+
+		// the tuples are aligned to their size
+		off_t tupleSize = 2 * setAddressSize;
+		dataReader.SetAddressSize(setAddressSize);
+		dataReader.SeekAbsolute((dataReader.Offset() + tupleSize - 1)
+			/ tupleSize * tupleSize);
+
+		while (dataReader.Offset() < (off_t)(lengthOffset + length)) {
+			AddressIndexEntry entry;
+			entry.start = dataReader.ReadAddress(0);
+			target_size_t size = dataReader.ReadAddress(0);
+			if (dataReader.HasOverflow())
+				return B_BAD_DATA;
+
+			if (entry.start == 0 && size == 0)
+				break;
+			if (size == 0)
+				continue;
+
+			entry.end = entry.start + size;
+			entry.unit = unitIndex;
+			if (!fAddressIndex.Add(entry))
+				return B_NO_MEMORY;
+		}
+
+		dataReader.SeekAbsolute(lengthOffset + length);
+	}
+
+	return B_OK;
+}
+
+
+status_t
+DwarfFile::_ParseNamesSection(ElfSection* section, uint8 addressSize,
+	bool isBigEndian, Array<bool>& indexedUnits)
+{
+	if (fDebugStringSection == NULL)
+		return B_BAD_DATA;
+
+	DataReader dataReader(section->Data(), section->Size(), addressSize,
+		isBigEndian);
+
+	while (dataReader.HasData()) {
+		bool dwarf64;
+		uint64 length = dataReader.ReadInitialLength(dwarf64);
+
+		off_t lengthOffset = dataReader.Offset();
+			// the length starts here
+
+		if (dataReader.HasOverflow()
+			|| lengthOffset + length > (uint64)section->Size()) {
+			return B_BAD_DATA;
+		}
+
+		DataReader unitDataReader(dataReader.Data(), length, addressSize,
+			isBigEndian);
+		status_t error = _ParseNamesUnit(unitDataReader, dwarf64,
+			indexedUnits);
+		if (error != B_OK)
+			return error;
+
+		dataReader.SeekAbsolute(lengthOffset + length);
+	}
+
+	return B_OK;
+}
+
+
+/*!	Adds the names of a single name index in .debug_names to the name index.
+	Only the compilation units of the entries are of interest, the DIEs
+	themselves are found by walking the units.
+*/
 status_t
-DwarfFile::_ParsePublicTypesInfo(uint8 _addressSize, bool isBigEndian)
+DwarfFile::_ParseNamesUnit(DataReader& dataReader, bool dwarf64,
+	Array<bool>& indexedUnits)
+{
+	uint16 version = dataReader.Read<uint16>(0);
+	dataReader.Read<uint16>(0);
+		// padding
+	uint32 compilationUnitCount = dataReader.Read<uint32>(0);
+	uint32 localTypeUnitCount = dataReader.Read<uint32>(0);
+	uint32 foreignTypeUnitCount = dataReader.Read<uint32>(0);
+	uint32 bucketCount = dataReader.Read<uint32>(0);
+	uint32 nameCount = dataReader.Read<uint32>(0);
+	uint32 abbreviationTableSize = dataReader.Read<uint32>(0);
+	uint32 augmentationStringSize = dataReader.Read<uint32>(0);
+
+	if (dataReader.HasOverflow())
+		return B_BAD_DATA;
+	if (version != 5)
+		return B_UNSUPPORTED;
+
+	off_t offsetSize = dwarf64 ? 8 : 4;
+	dataReader.SeekAbsolute(dataReader.Offset() + augmentationStringSize);
+
+	// map the compilation unit list to our units
+	Array<int32> units;
+	for (uint32 i = 0; i < compilationUnitCount; i++) {
+		off_t unitOffset = dataReader.ReadUInt(offsetSize, 0);
+		int32 unitIndex = _GetContainingCompilationUnit(unitOffset);
+		if (dataReader.HasOverflow() || unitIndex < 0)
+			return B_BAD_DATA;
+
+		if (!units.Add(unitIndex))
+			return B_NO_MEMORY;
+		indexedUnits[unitIndex] = true;
+	}
+
+	// skip the type unit lists and the hash table
+	off_t stringOffsetsOffset = dataReader.Offset()
+		+ localTypeUnitCount * offsetSize + foreignTypeUnitCount * 8
+		+ bucketCount * 4 + (bucketCount != 0 ? nameCount * 4 : 0);
+	off_t entryOffsetsOffset = stringOffsetsOffset + nameCount * offsetSize;
+	off_t abbreviationsOffset = entryOffsetsOffset + nameCount * offsetSize;
+	off_t entryPoolOffset = abbreviationsOffset + abbreviationTableSize;
+	if (entryPoolOffset > dataReader.Offset() + dataReader.BytesRemaining())
+		return B_BAD_DATA;
+
+	DataReader stringOffsetsReader(dataReader);
+	stringOffsetsReader.SeekAbsolute(stringOffsetsOffset);
+	DataReader entryOffsetsReader(dataReader);
+	entryOffsetsReader.SeekAbsolute(entryOffsetsOffset);
+
+	for (uint32 i = 0; i < nameCount; i++) {
+		uint64 stringOffset = stringOffsetsReader.ReadUInt(offsetSize, 0);
+		uint64 entryOffset = entryOffsetsReader.ReadUInt(offsetSize, 0);
+		if (stringOffsetsReader.HasOverflow()
+			|| entryOffsetsReader.HasOverflow()
+			|| stringOffset >= (uint64)fDebugStringSection->Size()) {
+			return B_BAD_DATA;
+		}
+
+		const char* name = (const char*)fDebugStringSection->Data()
+			+ stringOffset;
+
+		// walk the entries of the name
+		DataReader entryReader(dataReader);
+		entryReader.SeekAbsolute(entryPoolOffset + entryOffset);
+		while (true) {
+			uint64 code = entryReader.ReadUnsignedLEB128(0);
+			if (code == 0)
+				break;
+
+			// find the abbreviation
+			DataReader abbreviationReader(dataReader);
+			abbreviationReader.SeekAbsolute(abbreviationsOffset);
+			while (true) {
+				uint64 abbreviationCode
+					= abbreviationReader.ReadUnsignedLEB128(0);
+				if (abbreviationCode == 0 || abbreviationReader.HasOverflow())
+					return B_BAD_DATA;
+
+				abbreviationReader.ReadUnsignedLEB128(0);
+					// tag
+				if (abbreviationCode == code)
+					break;
+
+				while (abbreviationReader.ReadUnsignedLEB128(0) != 0
+					|| abbreviationReader.ReadUnsignedLEB128(0) != 0) {
+					if (abbreviationReader.HasOverflow())
+						return B_BAD_DATA;
+				}
+			}
+
+			// read the attributes of the entry
+			int64 unitNumber = compilationUnitCount == 1 ? 0 : -1;
+			bool typeUnit = false;
+			while (true) {
+				uint64 attribute = abbreviationReader.ReadUnsignedLEB128(0);
+				uint64 form = abbreviationReader.ReadUnsignedLEB128(0);
+				if (abbreviationReader.HasOverflow())
+					return B_BAD_DATA;
+				if (attribute == 0 && form == 0)
+					break;
+
+				uint64 value;
+				switch (form) {
+					case DW_FORM_flag_present:
+						value = 1;
+						break;
+					case DW_FORM_flag:
+					case DW_FORM_data1:
+					case DW_FORM_ref1:
+						value = entryReader.Read<uint8>(0);
+						break;
+					case DW_FORM_data2:
+					case DW_FORM_ref2:
+						value = entryReader.Read<uint16>(0);
+						break;
+					case DW_FORM_data4:
+					case DW_FORM_ref4:
+						value = entryReader.Read<uint32>(0);
+						break;
+					case DW_FORM_data8:
+					case DW_FORM_ref8:
+					case DW_FORM_ref_sig8:
+						value = entryReader.Read<uint64>(0);
+						break;
+					case DW_FORM_udata:
+					case DW_FORM_ref_udata:
+						value = entryReader.ReadUnsignedLEB128(0);
+						break;
+					case DW_FORM_sdata:
+						value = entryReader.ReadSignedLEB128(0);
+						break;
+					default:
+						return B_UNSUPPORTED;
+				}
+
+				if (attribute == DW_IDX_compile_unit)
+					unitNumber = value;
+				else if (attribute == DW_IDX_type_unit)
+					typeUnit = true;
+			}
+
+			if (entryReader.HasOverflow())
+				return B_BAD_DATA;
+
+			// Only the compilation units are indexed, the types defined in
+			// type units are not looked up by name.
+			if (typeUnit)
+				continue;
+			if (unitNumber < 0 || unitNumber >= (int64)compilationUnitCount)
+				return B_BAD_DATA;
+
+			status_t error = _AddIndexName(name, units[unitNumber]);
+			if (error != B_OK)
+				return error;
+		}
+	}
+
+	return B_OK;
+}
+
+
+status_t
+DwarfFile::_ParsePublicTypesInfo(uint8 _addressSize, bool isBigEndian,
+	Array<bool>& indexedUnits)
 {
 	TRACE_PUBTYPES("DwarfFile::_ParsePublicTypesInfo()\n");
 	if (fDebugPublicTypesSection == NULL) {
@@ -3018,11 +3729,14 @@ DwarfFile::_ParsePublicTypesInfo(uint8 _addressSize, bool isBigEndian)
 		if (unitLengthOffset + unitLength
 				> (uint64)fDebugPublicTypesSection->Size()) {
 			WARNING("Invalid public types set unit length.\n");
-			break;
+			return B_BAD_DATA;
 		}
 
 		DataReader unitDataReader(dataReader.Data(), unitLength, _addressSize, isBigEndian);
-		_ParsePublicTypesInfo(unitDataReader, dwarf64);
+		status_t error = _ParsePublicTypesInfo(unitDataReader, dwarf64,
+			indexedUnits);
+		if (error != B_OK)
+			return error;
 
 		dataReader.SeekAbsolute(unitLengthOffset + unitLength);
 	}
@@ -3032,7 +3746,8 @@ DwarfFile::_ParsePublicTypesInfo(uint8 _addressSize, bool isBigEndian)
 
 
 status_t
-DwarfFile::_ParsePublicTypesInfo(DataReader& dataReader, bool dwarf64)
+DwarfFile::_ParsePublicTypesInfo(DataReader& dataReader, bool dwarf64,
+	Array<bool>& indexedUnits)
 {
 	int version = dataReader.Read<uint16>(0);
 	if (version != 2) {
@@ -3040,7 +3755,7 @@ DwarfFile::_ParsePublicTypesInfo(DataReader& dataReader, bool dwarf64)
 		return B_UNSUPPORTED;
 	}
 
-	TRACE_PUBTYPES_ONLY(off_t debugInfoOffset =) dwarf64
+	off_t debugInfoOffset = dwarf64
 		? dataReader.Read<uint64>(0)
 		: (uint64)dataReader.Read<uint32>(0);
 	TRACE_PUBTYPES_ONLY(off_t debugInfoSize =) dwarf64
@@ -3054,6 +3769,11 @@ DwarfFile::_ParsePublicTypesInfo(DataReader& dataReader, bool dwarf64)
 		"info: (%" B_PRIdOFF ", %" B_PRIdOFF ")\n", debugInfoOffset,
 		debugInfoSize);
 
+	int32 unitIndex = _GetContainingCompilationUnit(debugInfoOffset);
+	if (unitIndex < 0)
+		return B_BAD_DATA;
+	indexedUnits[unitIndex] = true;
+
 	while (dataReader.BytesRemaining() > 0) {
 		off_t entryOffset = dwarf64
 			? dataReader.Read<uint64>(0)
@@ -3061,15 +3781,31 @@ DwarfFile::_ParsePublicTypesInfo(DataReader& dataReader, bool dwarf64)
 		if (entryOffset == 0)
 			return B_OK;
 
-		TRACE_PUBTYPES_ONLY(const char* name =) dataReader.ReadString();
+		const char* name = dataReader.ReadString();
+		if (dataReader.HasOverflow())
+			return B_BAD_DATA;
 
 		TRACE_PUBTYPES("  \"%s\" -> %" B_PRIdOFF "\n", name, entryOffset);
+
+		status_t error = _AddIndexName(name, unitIndex);
+		if (error != B_OK)
+			return error;
 	}
 
 	return B_OK;
 }
 
 
+status_t
+DwarfFile::_AddIndexName(const char* name, int32 unitIndex)
+{
+	NameIndexEntry entry;
+	entry.hash = hash_unqualified_name(name);
+	entry.unit = unitIndex;
+	return fNameIndex.Add(entry) ? B_OK : B_NO_MEMORY;
+}
+
+
 status_t
 DwarfFile::_GetAbbreviationTable(off_t offset, AbbreviationTable*& _table)
 {
@@ -3101,9 +3837,14 @@ DwarfFile::_GetAbbreviationTable(off_t offset, AbbreviationTable*& _table)
 }
 
 
+/*!	Resolves a reference while a unit is finished. A referenced compilation
+	unit that hasn't been parsed yet is parsed now, and queued to be finished
+	by _LoadCompilationUnit(). When all units are finished in parallel, they
+	have all been parsed before, so that nothing is changed here.
+*/
 DebugInfoEntry*
 DwarfFile::_ResolveReference(BaseUnit* unit, uint64 offset,
-	uint8 refType) const
+	uint8 refType)
 {
 	switch (refType) {
 		case dwarf_reference_type_local:
@@ -3111,10 +3852,19 @@ DwarfFile::_ResolveReference(BaseUnit* unit, uint64 offset,
 			break;
 		case dwarf_reference_type_global:
 		{
-			CompilationUnit* unit = _GetContainingCompilationUnit(offset);
-			if (unit == NULL)
+			int32 index = _GetContainingCompilationUnit(offset);
+			if (index < 0)
 				break;
 
+			if (fUnitStates[index] == UNIT_STATE_UNPARSED
+				&& _ParseCompilationUnitAt(index) != B_OK) {
+				break;
+			}
+			if (fUnitStates[index] == UNIT_STATE_FAILED)
+				break;
+
+			CompilationUnit* unit = fCompilationUnits.ItemAt(index);
+
 			offset -= unit->HeaderOffset();
 			DebugInfoEntry* entry = unit->EntryForOffset(offset);
 			if (entry != NULL)
@@ -3135,6 +3885,25 @@ DwarfFile::_ResolveReference(BaseUnit* unit, uint64 offset,
 }
 
 
+/*!	Resolves a reference from a finished unit, like _ResolveReference(), but
+	makes sure the referenced entry has been finished as well.
+*/
+DebugInfoEntry*
+DwarfFile::_ResolveLoadedReference(BaseUnit* unit, uint64 offset,
+	uint8 refType)
+{
+	if (refType != dwarf_reference_type_global)
+		return _ResolveReference(unit, offset, refType);
+
+	AutoLocker<BLocker> locker(fUnitLock);
+	int32 index = _GetContainingCompilationUnit(offset);
+	if (index < 0 || _LoadCompilationUnit(index) != B_OK)
+		return NULL;
+
+	return _ResolveReference(unit, offset, refType);
+}
+
+
 status_t
 DwarfFile::_GetLocationExpression(CompilationUnit* unit,
 	const LocationDescription* location, target_addr_t instructionPointer,
@@ -3335,11 +4104,11 @@ DwarfFile::_GetTypeUnit(uint64 signature) const
 }
 
 
-CompilationUnit*
+int32
 DwarfFile::_GetContainingCompilationUnit(off_t refAddr) const
 {
 	if (fCompilationUnits.IsEmpty())
-		return NULL;
+		return -1;
 
 	// binary search
 	int lower = 0;
@@ -3353,7 +4122,7 @@ DwarfFile::_GetContainingCompilationUnit(off_t refAddr) const
 	}
 
 	CompilationUnit* unit = fCompilationUnits.ItemAt(lower);
-	return unit->ContainsAbsoluteOffset(refAddr) ? unit : NULL;
+	return unit->ContainsAbsoluteOffset(refAddr) ? lower : -1;
 }
 
 
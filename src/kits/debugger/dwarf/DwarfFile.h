@@ -7,6 +7,8 @@
 #define DWARF_FILE_H
 
 
+#include <Array.h>
+#include <Locker.h>
 #include <ObjectList.h>
 #include <Referenceable.h>
 #include <util/DoublyLinkedList.h>
@@ -49,9 +51,16 @@ public:
 										|| fEHFrameSection != NULL; }
 
 			int32				CountCompilationUnits() const;
-			CompilationUnit*	CompilationUnitAt(int32 index) const;
+			CompilationUnit*	CompilationUnitAt(int32 index);
+									// parses the unit, if necessary
+			status_t			LoadCompilationUnits();
 			CompilationUnit*	CompilationUnitForDIE(
-									const DebugInfoEntry* entry) const;
+									const DebugInfoEntry* entry);
+			CompilationUnit*	CompilationUnitForAddress(
+									target_addr_t address);
+			status_t			GetCompilationUnitsForTypeName(
+									const char* name,
+									Array<int32>& _unitIndices) const;
 
 			TargetAddressRangeList* ResolveRangeList(CompilationUnit* unit,
 									uint64 offset) const;
@@ -111,11 +120,16 @@ private:
 			struct FDEAugmentation;
 			struct CIEAugmentation;
 			struct FDELookupInfo;
+			struct UnitProcessingContext;
+			struct AddressIndexEntry;
+			struct NameIndexEntry;
 
 			typedef DoublyLinkedList<AbbreviationTable> AbbreviationTableList;
 			typedef BObjectList<CompilationUnit, true> CompilationUnitList;
 			typedef BOpenHashTable<TypeUnitTableHashDefinition> TypeUnitTable;
 			typedef BObjectList<FDELookupInfo, true> FDEInfoList;
+			typedef Array<AddressIndexEntry> AddressIndex;
+			typedef Array<NameIndexEntry> NameIndex;
 
 private:
 			status_t			_ParseDebugInfoSection(uint8 _addressSize, bool isBigEndian);
@@ -123,6 +137,10 @@ private:
 			status_t			_ParseFrameSection(ElfSection* section,
 									uint8 addressSize, bool isBigEndian,
 									bool ehFrame, FDEInfoList& infos);
+			status_t			_ProcessCompilationUnits(bool finish);
+	static	status_t			_ProcessCompilationUnitsThread(void* data);
+			status_t			_LoadCompilationUnit(int32 index);
+			status_t			_ParseCompilationUnitAt(int32 index);
 			status_t			_ParseCompilationUnit(CompilationUnit* unit);
 			status_t			_ParseTypeUnit(TypeUnit* unit);
 			status_t			_ParseDebugInfoEntry(DataReader& dataReader,
@@ -170,16 +188,33 @@ private:
 									DataReader& dataReader,
 									CIEAugmentation& cieAugmentation);
 
-			status_t			_ParsePublicTypesInfo(uint8 _addressSize, bool isBigEndian);
+			status_t			_BuildIndex(ElfFile* debugInfoFile,
+									uint8 addressSize, bool isBigEndian);
+			status_t			_ParseAddressRangesSection(
+									ElfSection* section, uint8 addressSize,
+									bool isBigEndian);
+			status_t			_ParseNamesSection(ElfSection* section,
+									uint8 addressSize, bool isBigEndian,
+									Array<bool>& indexedUnits);
+			status_t			_ParseNamesUnit(DataReader& dataReader,
+									bool dwarf64, Array<bool>& indexedUnits);
+			status_t			_ParsePublicTypesInfo(uint8 _addressSize,
+									bool isBigEndian,
+									Array<bool>& indexedUnits);
 			status_t			_ParsePublicTypesInfo(DataReader& dataReader,
-									bool dwarf64);
+									bool dwarf64, Array<bool>& indexedUnits);
+			status_t			_AddIndexName(const char* name,
+									int32 unitIndex);
 
 			status_t			_GetAbbreviationTable(off_t offset,
 									AbbreviationTable*& _table);
 
 			DebugInfoEntry*		_ResolveReference(BaseUnit* unit,
 									uint64 offset,
-									uint8 refType) const;
+									uint8 refType);
+			DebugInfoEntry*		_ResolveLoadedReference(BaseUnit* unit,
+									uint64 offset,
+									uint8 refType);
 
 			status_t			_GetLocationExpression(CompilationUnit* unit,
 									const LocationDescription* location,
@@ -199,7 +234,7 @@ private:
 									BString& _infoPath) const;
 
 			TypeUnitTableEntry*	_GetTypeUnit(uint64 signature) const;
-			CompilationUnit*	_GetContainingCompilationUnit(
+			int32				_GetContainingCompilationUnit(
 									off_t refAddr) const;
 
 			FDELookupInfo*		_GetContainingFDEInfo(
@@ -233,10 +268,16 @@ private:
 			AbbreviationTableList fAbbreviationTables;
 			DebugInfoEntryFactory fDebugInfoFactory;
 			CompilationUnitList	fCompilationUnits;
+			Array<uint8>		fUnitStates;
+			Array<int32>		fUnitsToFinish;
+			BLocker				fUnitLock;
+			AddressIndex		fAddressIndex;
+			NameIndex			fNameIndex;
+			Array<int32>		fUnindexedUnits;
+			bool				fHasNameIndex;
 			TypeUnitTable		fTypeUnits;
 			FDEInfoList			fDebugFrameInfos;
 			FDEInfoList			fEHFrameInfos;
-			bool				fTypesSectionRequired;
 			bool				fFinished;
 			bool				fItaniumEHFrameFormat;
 			status_t			fFinishError;
@@ -10,6 +10,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -17,6 +18,7 @@
 #include <new>
 
 #include <AutoDeleter.h>
+#include <OS.h>
 
 #include "ElfSymbolLookup.h"
 #include "Tracing.h"
@@ -34,6 +36,8 @@ ElfSection::ElfSection(const char* name, uint32 type, int fd, uint64 offset,
 	fOffset(offset),
 	fSize(size),
 	fData(NULL),
+	fMapping(NULL),
+	fMappingSize(0),
 	fLoadAddress(loadAddress),
 	fFlags(flags),
 	fLoadCount(0),
@@ -44,7 +48,7 @@ ElfSection::ElfSection(const char* name, uint32 type, int fd, uint64 offset,
 
 ElfSection::~ElfSection()
 {
-	free(fData);
+	_FreeData();
 }
 
 
@@ -56,6 +60,24 @@ ElfSection::Load()
 		return B_OK;
 	}
 
+	// Map the section rather than copying it: the debug info sections of a
+	// large application can be huge, and only a part of them is ever looked
+	// at. The pages are then shared with the file cache, too.
+	if (fSize > 0 && fType != SHT_NOBITS) {
+		off_t mappingOffset = fOffset & ~(uint64)(B_PAGE_SIZE - 1);
+		size_t mappingSize = fSize + (fOffset - mappingOffset);
+		void* mapping = mmap(NULL, mappingSize, PROT_READ, MAP_PRIVATE, fFD,
+			mappingOffset);
+		if (mapping != MAP_FAILED) {
+			fMapping = mapping;
+			fMappingSize = mappingSize;
+			fData = (uint8*)mapping + (fOffset - mappingOffset);
+			fLoadCount++;
+			return B_OK;
+		}
+	}
+
+	// fall back to reading the section
 	fData = malloc(fSize);
 	if (fData == NULL)
 		return B_NO_MEMORY;
@@ -78,10 +100,22 @@ ElfSection::Unload()
 	if (fLoadCount == 0)
 		return;
 
-	if (--fLoadCount == 0) {
+	if (--fLoadCount == 0)
+		_FreeData();
+}
+
+
+void
+ElfSection::_FreeData()
+{
+	if (fMapping != NULL) {
+		munmap(fMapping, fMappingSize);
+		fMapping = NULL;
+		fMappingSize = 0;
+	} else
 		free(fData);
-		fData = NULL;
-	}
+
+	fData = NULL;
 }
 
 
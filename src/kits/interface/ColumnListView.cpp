@@ -48,8 +48,10 @@ All rights reserved.
 #include <typeinfo>
 
 #include <algorithm>
+#include <float.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <Application.h>
 #include <Bitmap.h>
@@ -144,6 +146,8 @@ static const float kDoubleClickMoveSensitivity = 4.0;
 static const float kSortIndicatorWidth = 9.0;
 static const float kDropHighlightLineHeight = 2.0;
 
+static const int32 kMaxFetchedRows = 1024;
+
 static const uint32 kToggleColumn = 'BTCL';
 
 
@@ -258,6 +262,63 @@ private:
 };
 
 
+/*!	Keeps the height of each root row together with its visible sub-tree in
+	a treap that is ordered by the index of the root rows. Every node also
+	knows the height, and the number of visible rows of the sub-tree below
+	it, so that the top of a root row, and the root row at a position can be
+	found, and root rows be inserted and removed in O(log n).
+*/
+class RowPositionTree {
+public:
+								RowPositionTree();
+								~RowPositionTree();
+
+			void				MakeEmpty();
+
+			void				Insert(int32 index, BRow* row, float height,
+									int32 visibleCount);
+			void				Remove(int32 index);
+			void				SetHeight(int32 index, float height,
+									int32 visibleCount);
+
+			int32				IndexOf(const BRow* row) const;
+			float				TopOf(int32 index,
+									int32* _visibleIndex = NULL) const;
+			int32				IndexAt(float position, float* _top,
+									int32* _visibleIndex = NULL) const;
+
+private:
+			struct tree_node {
+				BRow*			row;
+				int32			left;
+				int32			right;
+				int32			parent;
+				uint32			priority;
+				float			height;
+				int32			visibleCount;
+
+				// of the sub-tree below, and including this node
+				int32			count;
+				float			totalHeight;
+				int32			totalVisibleCount;
+			};
+
+			int32				_AllocateNode();
+			void				_Update(int32 node);
+			void				_Split(int32 node, int32 count, int32& _left,
+									int32& _right);
+			int32				_Merge(int32 left, int32 right);
+
+			tree_node*			fNodes;
+				// fNodes[0] is the empty sub-tree
+			int32				fSize;
+			int32				fUsed;
+			int32				fFreeNode;
+			int32				fRoot;
+			uint32				fSeed;
+};
+
+
 class OutlineView : public BView {
 	typedef BView _inherited;
 public:
@@ -299,6 +360,10 @@ public:
 									float* _top);
 			bool				FindRect(const BRow* row, BRect* _rect);
 			void				ScrollTo(const BRow* row);
+			void				InvalidateRowPositions();
+
+			void				SetRowSource(BRowSource* source);
+			BRowSource*			RowSource() const;
 
 			void				Clear();
 			void				SetSelectionMode(list_view_type type);
@@ -335,12 +400,35 @@ private:
 			bool				FindVisibleRect(BRow* row, BRect* _rect);
 			bool				RemoveRowFromSelectionOnly(BRow* row);
 
+			void				GetRootRowHeight(const BRow* row,
+									float* _height, int32* _visibleCount);
+			void				ValidateRowPositions();
+			void				RootRowAdded(int32 rootIndex);
+			void				RootRowRemoved(int32 rootIndex);
+			void				RootRowChanged(int32 rootIndex);
+			int32				RootIndexOf(const BRow* row);
+			int32				RootRowIndexAt(float position, float* _top,
+									int32* _visibleIndex = NULL);
+			float				RootRowTop(int32 rootIndex);
+
+			void				FetchFields(BRow* row);
+			bool				HasSortFields(BRow* row);
+			bool				IsSortField(int32 logicalFieldIndex);
+			void				ReleaseFields(BRow* row, bool keepSortFields);
+			void				ForgetFetchedRows(BRow* row);
+
 			BList*				fColumns;
 			BList*				fSortColumns;
 			float				fItemsHeight;
 			BRowContainer		fRows;
 			BRect				fVisibleRect;
 
+			RowPositionTree		fRowPositions;
+			bool				fRowPositionsValid;
+
+			BRowSource*			fRowSource;
+			BObjectList<BRow>	fFetchedRows;
+
 #if DOUBLE_BUFFERED_COLUMN_RESIZE
 			ColumnResizeBufferView* fResizeBufferView;
 #endif
@@ -395,7 +483,8 @@ class RecursiveOutlineIterator {
 public:
 								RecursiveOutlineIterator(
 									BRowContainer* container,
-									bool openBranchesOnly = true);
+									bool openBranchesOnly = true,
+									int32 startIndex = 0);
 
 			BRow*				CurrentRow() const;
 			int32				CurrentLevel() const;
@@ -529,6 +618,14 @@ BField::~BField()
 // #pragma mark -
 
 
+BRowSource::~BRowSource()
+{
+}
+
+
+// #pragma mark -
+
+
 void
 BColumn::MouseMoved(BColumnListView* /*parent*/, BRow* /*row*/,
 	BField* /*field*/, BRect /*field_rect*/, BPoint/*point*/,
@@ -558,12 +655,14 @@ BRow::BRow()
 	:
 	fChildList(NULL),
 	fIsExpanded(false),
+	fFieldsFetched(false),
 	fHeight(std::max(kMinRowHeight,
 		ceilf(be_plain_font->Size() * kRowSpacing))),
 	fNextSelected(NULL),
 	fPrevSelected(NULL),
 	fParent(NULL),
-	fList(NULL)
+	fList(NULL),
+	fPositionNode(-1)
 {
 }
 
@@ -572,11 +671,13 @@ BRow::BRow(float height)
 	:
 	fChildList(NULL),
 	fIsExpanded(false),
+	fFieldsFetched(false),
 	fHeight(height),
 	fNextSelected(NULL),
 	fPrevSelected(NULL),
 	fParent(NULL),
-	fList(NULL)
+	fList(NULL),
+	fPositionNode(-1)
 {
 }
 
@@ -624,15 +725,17 @@ BRow::GetField(int32 index) const
 void
 BRow::SetField(BField* field, int32 logicalFieldIndex)
 {
-	if (fFields.ItemAt(logicalFieldIndex) != 0)
-		delete (BField*)fFields.RemoveItem(logicalFieldIndex);
-
 	if (NULL != fList) {
 		ValidateField(field, logicalFieldIndex);
 		Invalidate();
 	}
 
-	fFields.AddItem(field, logicalFieldIndex);
+	if (logicalFieldIndex < fFields.CountItems()) {
+		// The slot may also have been left empty
+		delete (BField*)fFields.ItemAt(logicalFieldIndex);
+		fFields.ReplaceItem(logicalFieldIndex, field);
+	} else
+		fFields.AddItem(field, logicalFieldIndex);
 }
 
 
@@ -668,8 +771,10 @@ BRow::Invalidate()
 void
 BRow::ValidateFields() const
 {
-	for (int32 i = 0; i < CountFields(); i++)
-		ValidateField(GetField(i), i);
+	for (int32 i = 0; i < CountFields(); i++) {
+		if (GetField(i) != NULL)
+			ValidateField(GetField(i), i);
+	}
 }
 
 
@@ -1468,6 +1573,7 @@ BColumnListView::SwapRows(int32 index1, int32 index2, BRow* parentRow1,
 
 	container1->ReplaceItem(index2, row1);
 	container2->ReplaceItem(index1, row2);
+	fOutlineView->InvalidateRowPositions();
 
 	BRect rect1;
 	BRect rect2;
@@ -1516,6 +1622,24 @@ BColumnListView::InvalidateRow(BRow* row)
 }
 
 
+/*!	Sets the source that provides the fields of the rows on demand, see
+	BRowSource. The view does not take ownership of the \a source. Pass
+	\c NULL to have the rows keep their fields again.
+*/
+void
+BColumnListView::SetRowSource(BRowSource* source)
+{
+	fOutlineView->SetRowSource(source);
+}
+
+
+BRowSource*
+BColumnListView::RowSource() const
+{
+	return fOutlineView->RowSource();
+}
+
+
 // This method is deprecated.
 void
 BColumnListView::SetFont(const BFont* font, uint32 mask)
@@ -3242,6 +3366,8 @@ OutlineView::OutlineView(BRect rect, BList* visibleColumns, BList* sortColumns,
 	fSortColumns(sortColumns),
 	fItemsHeight(0.0),
 	fVisibleRect(rect.OffsetToCopy(0, 0)),
+	fRowPositionsValid(false),
+	fRowSource(NULL),
 	fFocusRow(0),
 	fRollOverRow(0),
 	fLastSelectedItem(0),
@@ -3288,7 +3414,9 @@ OutlineView::Clear()
 {
 	DeselectAll();
 		// Make sure selection list doesn't point to deleted rows!
+	fFetchedRows.MakeEmpty();
 	RecursiveDeleteRows(&fRows, false);
+	InvalidateRowPositions();
 	fItemsHeight = 0.0;
 	FixScrollBar(true);
 	Invalidate();
@@ -3383,9 +3511,12 @@ OutlineView::RedrawColumn(BColumn* column, float leftEdge, bool isFirstColumn)
 
 	font_height fh;
 	GetFontHeight(&fh);
-	float line = 0.0;
-	bool tintedLine = true;
-	for (RecursiveOutlineIterator iterator(&fRows); iterator.CurrentRow();
+	float line;
+	int32 visibleIndex;
+	int32 rootIndex = RootRowIndexAt(fVisibleRect.top, &line, &visibleIndex);
+	bool tintedLine = visibleIndex % 2 == 0;
+	for (RecursiveOutlineIterator iterator(&fRows, true, rootIndex);
+		iterator.CurrentRow();
 		line += iterator.CurrentRow()->Height() + 1, iterator.GoToNext()) {
 
 		BRow* row = iterator.CurrentRow();
@@ -3395,6 +3526,8 @@ OutlineView::RedrawColumn(BColumn* column, float leftEdge, bool isFirstColumn)
 		tintedLine = !tintedLine;
 
 		if (line + rowHeight >= fVisibleRect.top) {
+			FetchFields(row);
+
 #if DOUBLE_BUFFERED_COLUMN_RESIZE
 			BRect sourceRect(0, 0, column->Width(), rowHeight);
 #endif
@@ -3535,11 +3668,15 @@ OutlineView::Draw(BRect invalidBounds)
 	font_height fh;
 	GetFontHeight(&fh);
 
-	float line = 0.0;
-	bool tintedLine = true;
+	// Start with the first row that reaches into the invalid area
+	float line;
+	int32 visibleIndex;
+	int32 rootIndex = RootRowIndexAt(invalidBounds.top, &line, &visibleIndex);
+
+	bool tintedLine = visibleIndex % 2 == 0;
 	int32 numColumns = fColumns->CountItems();
-	for (RecursiveOutlineIterator iterator(&fRows); iterator.CurrentRow();
-		iterator.GoToNext()) {
+	for (RecursiveOutlineIterator iterator(&fRows, true, rootIndex);
+		iterator.CurrentRow(); iterator.GoToNext()) {
 		BRow* row = iterator.CurrentRow();
 		if (line > invalidBounds.bottom)
 			break;
@@ -3548,6 +3685,8 @@ OutlineView::Draw(BRect invalidBounds)
 		float rowHeight = row->Height();
 
 		if (line >= invalidBounds.top - rowHeight) {
+			FetchFields(row);
+
 			bool isFirstColumn = true;
 			float fieldLeftEdge = MAX(kLeftMargin, fMasterView->LatchWidth());
 
@@ -3712,9 +3851,10 @@ BRow*
 OutlineView::FindRow(float ypos, int32* _rowIndent, float* _top)
 {
 	if (_rowIndent && _top) {
-		float line = 0.0;
-		for (RecursiveOutlineIterator iterator(&fRows); iterator.CurrentRow();
-			iterator.GoToNext()) {
+		float line;
+		int32 rootIndex = RootRowIndexAt(ypos, &line);
+		for (RecursiveOutlineIterator iterator(&fRows, true, rootIndex);
+			iterator.CurrentRow(); iterator.GoToNext()) {
 
 			BRow* row = iterator.CurrentRow();
 			if (line > ypos)
@@ -3783,6 +3923,7 @@ OutlineView::MouseDown(BPoint position)
 					if ((MAX(kLeftMargin, fMasterView->LatchWidth()) + x)
 						+ new_column->Width() >= position.x) {
 						if (new_column->WantsEvents()) {
+							FetchFields(row);
 							new_field = row->GetField(c);
 							new_row = row;
 							FindRect(new_row,&new_rect);
@@ -3940,6 +4081,7 @@ OutlineView::MouseMoved(BPoint position, uint32 /*transit*/,
 						> position.x) {
 
 						if(new_column->WantsEvents()) {
+							FetchFields(row);
 							new_field = row->GetField(c);
 							new_row = row;
 							FindRect(new_row,&new_rect);
@@ -4348,6 +4490,7 @@ OutlineView::ExpandOrCollapse(BRow* parentRow, bool expand)
 		return;
 
 	parentRow->fIsExpanded = expand;
+	RootRowChanged(RootIndexOf(parentRow));
 
 	BRect parentRect;
 	if (FindRect(parentRow, &parentRect)) {
@@ -4451,8 +4594,13 @@ OutlineView::RemoveRow(BRow* row)
 		else
 			ScrollBy(0.0, -Bounds().top);
 	}
+
+	ForgetFetchedRows(row);
+
 	if (parentRow != NULL) {
 		parentRow->fChildList->RemoveItem(row);
+		RootRowChanged(RootIndexOf(parentRow));
+
 		if (parentRow->fChildList->CountItems() == 0) {
 			delete parentRow->fChildList;
 			parentRow->fChildList = 0;
@@ -4462,8 +4610,13 @@ OutlineView::RemoveRow(BRow* row)
 			if (parentIsVisible && FindRect(parentRow, &parentRowRect))
 				Invalidate(parentRowRect);
 		}
-	} else
-		fRows.RemoveItem(row);
+	} else {
+		int32 rootIndex = RootIndexOf(row);
+		if (rootIndex >= 0) {
+			fRows.RemoveItemAt(rootIndex);
+			RootRowRemoved(rootIndex);
+		}
+	}
 
 	// Adjust focus row if necessary.
 	if (fFocusRow && !FindRect(fFocusRow, &fFocusRowRect)) {
@@ -4570,12 +4723,16 @@ OutlineView::RemoveRows(BList* rows)
 			ScrollBy(0.0, -Bounds().top);
 	}
 
+	for (int32 i = 0; i < countRows; i++)
+		ForgetFetchedRows(static_cast<BRow*>(rows->ItemAt(i)));
+
 	if (parentRow != NULL) {
 
 		for (int32 i = 0; i < countRows; i++) {
 			BRow* row = static_cast<BRow*>(rows->ItemAt(i));
 			parentRow->fChildList->RemoveItem(row);
 		}
+		RootRowChanged(RootIndexOf(parentRow));
 
 		if (parentRow->fChildList->CountItems() == 0) {
 			delete parentRow->fChildList;
@@ -4588,8 +4745,11 @@ OutlineView::RemoveRows(BList* rows)
 		}
 	} else {
 		for (int32 i = 0; i < countRows; i++) {
-			BRow* row = static_cast<BRow*>(rows->ItemAt(i));
-			fRows.RemoveItem(row);
+			int32 rootIndex = RootIndexOf(static_cast<BRow*>(rows->ItemAt(i)));
+			if (rootIndex >= 0) {
+				fRows.RemoveItemAt(rootIndex);
+				RootRowRemoved(rootIndex);
+			}
 		}
 	}
 
@@ -4638,6 +4798,12 @@ void
 OutlineView::UpdateRow(BRow* row)
 {
 	if (row) {
+		if (row->fFieldsFetched && row != fCurrentRow) {
+			// Let the row source provide the new contents
+			fFetchedRows.RemoveItem(row);
+			ReleaseFields(row, false);
+		}
+
 		// Determine if this row has changed its sort order
 		BRow* parentRow = NULL;
 		bool parentIsVisible = false;
@@ -4661,7 +4827,34 @@ OutlineView::UpdateRow(BRow* row)
 			if (rowMoved) {
 				// Sort location of this row has changed.
 				// Remove and re-add in the right spot
-				SortList(list, parentIsVisible && (parentRow == NULL || parentRow->fIsExpanded));
+				BRect oldRect;
+				bool wasVisible = FindRect(row, &oldRect);
+
+				// Moving a child row does not change the height of its root
+				// row
+				list->RemoveItemAt(rowIndex);
+				if (parentRow == NULL)
+					RootRowRemoved(rowIndex);
+
+				int32 newIndex = AddSorted(list, row);
+				if (parentRow == NULL)
+					RootRowAdded(newIndex);
+
+				BRect newRect;
+				if (wasVisible && FindRect(row, &newRect)) {
+					// Everything between the old and the new location moves
+					float subTreeHeight = row->Height() + 1;
+					if (row->fIsExpanded) {
+						for (RecursiveOutlineIterator iterator(row->fChildList);
+							iterator.CurrentRow(); iterator.GoToNext())
+							subTreeHeight += iterator.CurrentRow()->Height() + 1;
+					}
+
+					Invalidate(BRect(fVisibleRect.left,
+						min_c(oldRect.top, newRect.top), fVisibleRect.right,
+						max_c(oldRect.top, newRect.top) + subTreeHeight));
+					InvalidateCachedPositions();
+				}
 			} else if (parentIsVisible && (parentRow == NULL || parentRow->fIsExpanded)) {
 				BRect invalidRect;
 				if (FindVisibleRect(row, &invalidRect))
@@ -4742,6 +4935,9 @@ OutlineView::AddRows(BList* addedRows, int32 index, BRow* parentRow)
 		int insertedIndex = AddRowToParentOnly(row, index, parentRow);
 
 		if (insertedIndex >= 0) {
+			if (parentRow == NULL)
+				RootRowAdded(insertedIndex);
+
 			if (firstIndex < 0 || insertedIndex <= firstIndex) {
 				firstIndex = insertedIndex;
 				firstRow = row;
@@ -4763,6 +4959,9 @@ OutlineView::AddRows(BList* addedRows, int32 index, BRow* parentRow)
 	// Now that the rows are loaded in, the metrics and other aspects of the
 	// user interface need to be updated.
 
+	if (parentRow != NULL)
+		RootRowChanged(RootIndexOf(firstRow));
+
 	if (parentRow == 0 || parentRow->fIsExpanded)
 		fItemsHeight += (sumRowHeight + static_cast<float>(countAddedRows));
 			// the height of the rows plus 1.0 for each row.
@@ -4809,7 +5008,11 @@ OutlineView::AddRow(BRow* row, int32 Index, BRow* parentRow)
 	if (!row)
 		return;
 
-	AddRowToParentOnly(row, Index, parentRow);
+	int32 index = AddRowToParentOnly(row, Index, parentRow);
+	if (parentRow == NULL)
+		RootRowAdded(index);
+	else
+		RootRowChanged(RootIndexOf(row));
 
 #ifdef DOUBLE_BUFFERED_COLUMN_RESIZE
 	ResizeBufferView()->UpdateMaxHeight(row->Height());
@@ -4960,6 +5163,11 @@ OutlineView::CompareRows(BRow* row1, BRow* row2)
 {
 	int32 itemCount (fSortColumns->CountItems());
 	if (row1 && row2) {
+		if (!HasSortFields(row1))
+			FetchFields(row1);
+		if (!HasSortFields(row2))
+			FetchFields(row2);
+
 		for (int32 index = 0; index < itemCount; index++) {
 			BColumn* column = (BColumn*) fSortColumns->ItemAt(index);
 			int comp = 0;
@@ -5018,20 +5226,9 @@ OutlineView::VisibleRect() const
 bool
 OutlineView::FindVisibleRect(BRow* row, BRect* _rect)
 {
-	if (row && _rect) {
-		float line = 0.0;
-		for (RecursiveOutlineIterator iterator(&fRows); iterator.CurrentRow();
-			iterator.GoToNext()) {
+	if (row && _rect && FindRect(row, _rect))
+		return _rect->top <= fVisibleRect.bottom;
 
-			if (iterator.CurrentRow() == row) {
-				_rect->Set(fVisibleRect.left, line, fVisibleRect.right,
-					line + row->Height());
-				return line <= fVisibleRect.bottom;
-			}
-
-			line += iterator.CurrentRow()->Height() + 1;
-		}
-	}
 	return false;
 }
 
@@ -5042,14 +5239,23 @@ OutlineView::FindVisibleRect(BRow* row, BRect* _rect)
 bool
 OutlineView::FindRect(const BRow* row, BRect* _rect)
 {
-	float line = 0.0;
-	for (RecursiveOutlineIterator iterator(&fRows); iterator.CurrentRow();
-		iterator.GoToNext()) {
+	int32 rootIndex = RootIndexOf(row);
+	if (rootIndex < 0)
+		return false;
+
+	// Only the sub-tree of the root row needs to be walked
+	float line = RootRowTop(rootIndex);
+	for (RecursiveOutlineIterator iterator(&fRows, true, rootIndex);
+		iterator.CurrentRow(); iterator.GoToNext()) {
 		if (iterator.CurrentRow() == row) {
 			_rect->Set(fVisibleRect.left, line, fVisibleRect.right,
 				line + row->Height());
 			return true;
 		}
+		if (iterator.CurrentLevel() == 0
+			&& iterator.CurrentRow() != fRows.ItemAt(rootIndex)) {
+			break;
+		}
 
 		line += iterator.CurrentRow()->Height() + 1;
 	}
@@ -5076,9 +5282,10 @@ void
 OutlineView::DeselectAll()
 {
 	// Invalidate all selected rows
-	float line = 0.0;
-	for (RecursiveOutlineIterator iterator(&fRows); iterator.CurrentRow();
-		iterator.GoToNext()) {
+	float line;
+	int32 rootIndex = RootRowIndexAt(fVisibleRect.top, &line);
+	for (RecursiveOutlineIterator iterator(&fRows, true, rootIndex);
+		iterator.CurrentRow(); iterator.GoToNext()) {
 		if (line > fVisibleRect.bottom)
 			break;
 
@@ -5163,6 +5370,8 @@ OutlineView::SortList(BRowContainer* list, bool isVisible)
 		if (isVisible) {
 			Invalidate();
 
+			if (list == &fRows)
+				InvalidateRowPositions();
 			InvalidateCachedPositions();
 			int lockCount = Window()->CountLocks();
 			for (int i = 0; i < lockCount; i++)
@@ -5382,12 +5591,292 @@ OutlineView::InvalidateCachedPositions()
 }
 
 
+/*!	Forgets the positions of all root rows; they are computed again when they
+	are needed next. This must be called whenever the root rows are reordered
+	without going through RootRowAdded(), and RootRowRemoved().
+*/
+void
+OutlineView::InvalidateRowPositions()
+{
+	fRowPositionsValid = false;
+}
+
+
+/*!	Returns the height of \a row together with its visible sub-tree, and the
+	number of visible rows in it.
+*/
+void
+OutlineView::GetRootRowHeight(const BRow* row, float* _height,
+	int32* _visibleCount)
+{
+	float height = row->Height() + 1;
+	int32 visibleCount = 1;
+
+	if (row->fIsExpanded) {
+		for (RecursiveOutlineIterator iterator(row->fChildList);
+			iterator.CurrentRow(); iterator.GoToNext()) {
+			height += iterator.CurrentRow()->Height() + 1;
+			visibleCount++;
+		}
+	}
+
+	*_height = height;
+	*_visibleCount = visibleCount;
+}
+
+
+void
+OutlineView::ValidateRowPositions()
+{
+	if (fRowPositionsValid)
+		return;
+
+	fRowPositions.MakeEmpty();
+
+	int32 count = fRows.CountItems();
+	for (int32 index = 0; index < count; index++) {
+		BRow* row = fRows.ItemAt(index);
+
+		float height;
+		int32 visibleCount;
+		GetRootRowHeight(row, &height, &visibleCount);
+		fRowPositions.Insert(index, row, height, visibleCount);
+	}
+
+	fRowPositionsValid = true;
+}
+
+
+/*!	Must be called after a row has been inserted into the root rows at
+	\a rootIndex.
+*/
+void
+OutlineView::RootRowAdded(int32 rootIndex)
+{
+	if (!fRowPositionsValid)
+		return;
+
+	BRow* row = fRows.ItemAt(rootIndex);
+
+	float height;
+	int32 visibleCount;
+	GetRootRowHeight(row, &height, &visibleCount);
+	fRowPositions.Insert(rootIndex, row, height, visibleCount);
+}
+
+
+/*!	Must be called after the root row at \a rootIndex has been removed.
+*/
+void
+OutlineView::RootRowRemoved(int32 rootIndex)
+{
+	if (fRowPositionsValid)
+		fRowPositions.Remove(rootIndex);
+}
+
+
+/*!	Must be called whenever a visible row in the sub-tree of the root row at
+	\a rootIndex has been added, removed, expanded, or collapsed. Negative
+	indices are ignored, so that the result of RootIndexOf() can be passed in
+	directly.
+*/
+void
+OutlineView::RootRowChanged(int32 rootIndex)
+{
+	if (!fRowPositionsValid || rootIndex < 0)
+		return;
+
+	float height;
+	int32 visibleCount;
+	GetRootRowHeight(fRows.ItemAt(rootIndex), &height, &visibleCount);
+	fRowPositions.SetHeight(rootIndex, height, visibleCount);
+}
+
+
+/*!	Returns the index of the root row that \a row belongs to, or -1 if the
+	row is not in the list, or hidden in a collapsed branch.
+*/
+int32
+OutlineView::RootIndexOf(const BRow* row)
+{
+	if (row == NULL)
+		return -1;
+
+	while (row->fParent != NULL) {
+		if (!row->fParent->fIsExpanded)
+			return -1;
+
+		row = row->fParent;
+	}
+
+	ValidateRowPositions();
+	return fRowPositions.IndexOf(row);
+}
+
+
+/*!	Returns the index of the first root row whose sub-tree reaches below
+	\a position, or the number of root rows if there is none. The top of that
+	row, and the number of visible rows above it are stored in \a _top, and
+	\a _visibleIndex.
+*/
+int32
+OutlineView::RootRowIndexAt(float position, float* _top, int32* _visibleIndex)
+{
+	ValidateRowPositions();
+	return fRowPositions.IndexAt(position, _top, _visibleIndex);
+}
+
+
+float
+OutlineView::RootRowTop(int32 rootIndex)
+{
+	ValidateRowPositions();
+	return fRowPositions.TopOf(rootIndex);
+}
+
+
+void
+OutlineView::SetRowSource(BRowSource* source)
+{
+	if (source == fRowSource)
+		return;
+
+	// The rows keep the fields they got from the previous source until they
+	// are fetched again
+	for (int32 i = 0; i < fFetchedRows.CountItems(); i++)
+		fFetchedRows.ItemAt(i)->fFieldsFetched = false;
+	fFetchedRows.MakeEmpty();
+
+	fRowSource = source;
+	Invalidate();
+}
+
+
+BRowSource*
+OutlineView::RowSource() const
+{
+	return fRowSource;
+}
+
+
+/*!	Lets the row source fill in the fields of \a row, if it has not done so
+	already. To keep the number of rows with fields bounded, the fields of
+	the row that was fetched the longest time ago are deleted again.
+*/
+void
+OutlineView::FetchFields(BRow* row)
+{
+	if (fRowSource == NULL || row->fFieldsFetched)
+		return;
+
+	// Don't let SetField() invalidate the row while it's being drawn
+	BColumnListView* list = row->fList;
+	row->fList = NULL;
+	fRowSource->FetchRow(row);
+	row->fList = list;
+	if (list != NULL)
+		row->ValidateFields();
+
+	row->fFieldsFetched = true;
+	fFetchedRows.AddItem(row);
+
+	if (fFetchedRows.CountItems() > kMaxFetchedRows) {
+		// fCurrentField belongs to fCurrentRow, and must stay valid
+		int32 index = fFetchedRows.ItemAt(0) == fCurrentRow ? 1 : 0;
+		ReleaseFields(fFetchedRows.RemoveItemAt(index), true);
+	}
+}
+
+
+/*!	Returns whether \a row has the fields of all sort columns, which is all
+	CompareRows() needs.
+*/
+bool
+OutlineView::HasSortFields(BRow* row)
+{
+	for (int32 i = 0; i < fSortColumns->CountItems(); i++) {
+		BColumn* column = (BColumn*)fSortColumns->ItemAt(i);
+		if (row->GetField(column->fFieldID) == NULL)
+			return false;
+	}
+
+	return true;
+}
+
+
+bool
+OutlineView::IsSortField(int32 logicalFieldIndex)
+{
+	if (!fMasterView->SortingEnabled())
+		return false;
+
+	for (int32 i = 0; i < fSortColumns->CountItems(); i++) {
+		BColumn* column = (BColumn*)fSortColumns->ItemAt(i);
+		if (column->fFieldID == logicalFieldIndex)
+			return true;
+	}
+
+	return false;
+}
+
+
+/*!	Deletes the fields of \a row, so that they are fetched again when they
+	are needed next. If \a keepSortFields is true, the fields of the sort
+	columns are kept in their slots, as comparing rows while sorting would
+	otherwise have to fetch most of them again.
+*/
+void
+OutlineView::ReleaseFields(BRow* row, bool keepSortFields)
+{
+	for (int32 i = row->fFields.CountItems(); i-- > 0;) {
+		if (keepSortFields && IsSortField(i))
+			continue;
+
+		delete (BField*)row->fFields.ItemAt(i);
+		row->fFields.ReplaceItem(i, NULL);
+	}
+
+	// Only keep the empty slots in front of a sort field
+	int32 count = row->fFields.CountItems();
+	while (count > 0 && row->fFields.ItemAt(count - 1) == NULL)
+		row->fFields.RemoveItem(--count);
+
+	row->fFieldsFetched = false;
+}
+
+
+/*!	Removes \a row, and all of its children from the rows with fetched
+	fields, as they are about to leave the list. They keep their fields.
+*/
+void
+OutlineView::ForgetFetchedRows(BRow* row)
+{
+	if (fFetchedRows.IsEmpty())
+		return;
+
+	if (row->fFieldsFetched) {
+		fFetchedRows.RemoveItem(row);
+		row->fFieldsFetched = false;
+	}
+
+	for (RecursiveOutlineIterator iterator(row->fChildList, false);
+		iterator.CurrentRow(); iterator.GoToNext()) {
+		BRow* child = iterator.CurrentRow();
+		if (child->fFieldsFetched) {
+			fFetchedRows.RemoveItem(child);
+			child->fFieldsFetched = false;
+		}
+	}
+}
+
+
 float
 OutlineView::GetColumnPreferredWidth(BColumn* column)
 {
 	float preferred = 0.0;
 	for (RecursiveOutlineIterator iterator(&fRows); BRow* row =
 		iterator.CurrentRow(); iterator.GoToNext()) {
+		FetchFields(row);
 		BField* field = row->GetField(column->fFieldID);
 		if (field) {
 			float width = column->GetPreferredWidth(field, this)
@@ -5414,15 +5903,326 @@ OutlineView::GetColumnPreferredWidth(BColumn* column)
 // #pragma mark -
 
 
+RowPositionTree::RowPositionTree()
+	:
+	fNodes(NULL),
+	fSize(0),
+	fUsed(0),
+	fFreeNode(0),
+	fRoot(0),
+	fSeed(0x2545f491)
+{
+}
+
+
+RowPositionTree::~RowPositionTree()
+{
+	delete[] fNodes;
+}
+
+
+void
+RowPositionTree::MakeEmpty()
+{
+	fUsed = 1;
+	fFreeNode = 0;
+	fRoot = 0;
+}
+
+
+/*!	Inserts \a row at \a index, and moves the rows from there on down by
+	\a height.
+*/
+void
+RowPositionTree::Insert(int32 index, BRow* row, float height,
+	int32 visibleCount)
+{
+	int32 node = _AllocateNode();
+	tree_node& treeNode = fNodes[node];
+	treeNode.row = row;
+	treeNode.left = 0;
+	treeNode.right = 0;
+	treeNode.height = height;
+	treeNode.visibleCount = visibleCount;
+
+	// xorshift
+	fSeed ^= fSeed << 13;
+	fSeed ^= fSeed >> 17;
+	fSeed ^= fSeed << 5;
+	treeNode.priority = fSeed;
+
+	_Update(node);
+	row->fPositionNode = node;
+
+	int32 left;
+	int32 right;
+	_Split(fRoot, index, left, right);
+	fRoot = _Merge(_Merge(left, node), right);
+	fNodes[fRoot].parent = 0;
+}
+
+
+void
+RowPositionTree::Remove(int32 index)
+{
+	int32 left;
+	int32 node;
+	int32 right;
+	_Split(fRoot, index, left, right);
+	_Split(right, 1, node, right);
+
+	if (node != 0) {
+		fNodes[node].row = NULL;
+		fNodes[node].left = fFreeNode;
+		fFreeNode = node;
+	}
+
+	fRoot = _Merge(left, right);
+	if (fRoot != 0)
+		fNodes[fRoot].parent = 0;
+}
+
+
+void
+RowPositionTree::SetHeight(int32 index, float height, int32 visibleCount)
+{
+	int32 node = fRoot;
+	while (node != 0) {
+		int32 leftCount = fNodes[fNodes[node].left].count;
+		if (index == leftCount)
+			break;
+
+		if (index < leftCount)
+			node = fNodes[node].left;
+		else {
+			index -= leftCount + 1;
+			node = fNodes[node].right;
+		}
+	}
+
+	if (node == 0)
+		return;
+
+	fNodes[node].height = height;
+	fNodes[node].visibleCount = visibleCount;
+
+	for (; node != 0; node = fNodes[node].parent)
+		_Update(node);
+}
+
+
+/*!	Returns the index of the root row \a row, or -1 if it is not in the tree.
+*/
+int32
+RowPositionTree::IndexOf(const BRow* row) const
+{
+	int32 node = row->fPositionNode;
+	if (node <= 0 || node >= fUsed || fNodes[node].row != row)
+		return -1;
+
+	int32 index = fNodes[fNodes[node].left].count;
+	for (int32 parent = fNodes[node].parent; parent != 0;
+			node = parent, parent = fNodes[node].parent) {
+		if (fNodes[parent].right == node)
+			index += fNodes[fNodes[parent].left].count + 1;
+	}
+
+	return index;
+}
+
+
+/*!	Returns the top of the root row at \a index, and stores the number of
+	visible rows above it in \a _visibleIndex. If \a index is the number of
+	root rows, the height of all of them is returned.
+*/
+float
+RowPositionTree::TopOf(int32 index, int32* _visibleIndex) const
+{
+	float top = 0;
+	int32 visibleIndex = 0;
+
+	int32 node = fRoot;
+	while (node != 0) {
+		const tree_node& treeNode = fNodes[node];
+		const tree_node& left = fNodes[treeNode.left];
+		if (index < left.count) {
+			node = treeNode.left;
+			continue;
+		}
+
+		top += left.totalHeight;
+		visibleIndex += left.totalVisibleCount;
+		if (index == left.count)
+			break;
+
+		top += treeNode.height;
+		visibleIndex += treeNode.visibleCount;
+		index -= left.count + 1;
+		node = treeNode.right;
+	}
+
+	if (_visibleIndex != NULL)
+		*_visibleIndex = visibleIndex;
+
+	return top;
+}
+
+
+/*!	Returns the index of the root row whose sub-tree covers \a position, or
+	the number of root rows if \a position lies below all of them. The top of
+	that row, and the number of visible rows above it are stored in \a _top,
+	and \a _visibleIndex.
+*/
+int32
+RowPositionTree::IndexAt(float position, float* _top,
+	int32* _visibleIndex) const
+{
+	int32 index = 0;
+	float top = 0;
+	int32 visibleIndex = 0;
+
+	int32 node = fRoot;
+	while (node != 0) {
+		const tree_node& treeNode = fNodes[node];
+		const tree_node& left = fNodes[treeNode.left];
+		if (position < top + left.totalHeight) {
+			node = treeNode.left;
+			continue;
+		}
+
+		index += left.count;
+		top += left.totalHeight;
+		visibleIndex += left.totalVisibleCount;
+		if (position < top + treeNode.height)
+			break;
+
+		index++;
+		top += treeNode.height;
+		visibleIndex += treeNode.visibleCount;
+		node = treeNode.right;
+	}
+
+	*_top = top;
+	if (_visibleIndex != NULL)
+		*_visibleIndex = visibleIndex;
+
+	return index;
+}
+
+
+int32
+RowPositionTree::_AllocateNode()
+{
+	if (fFreeNode != 0) {
+		int32 node = fFreeNode;
+		fFreeNode = fNodes[node].left;
+		return node;
+	}
+
+	if (fUsed == 0)
+		fUsed = 1;
+
+	if (fUsed >= fSize) {
+		int32 size = max_c(fSize * 2, 64);
+		tree_node* nodes = new tree_node[size];
+		if (fSize > 0)
+			memcpy(nodes, fNodes, fSize * sizeof(tree_node));
+		else
+			memset(&nodes[0], 0, sizeof(tree_node));
+
+		delete[] fNodes;
+		fNodes = nodes;
+		fSize = size;
+	}
+
+	return fUsed++;
+}
+
+
+/*!	Updates the sums of \a node from its children, and makes it their
+	parent.
+*/
+void
+RowPositionTree::_Update(int32 node)
+{
+	tree_node& treeNode = fNodes[node];
+	const tree_node& left = fNodes[treeNode.left];
+	const tree_node& right = fNodes[treeNode.right];
+
+	treeNode.count = left.count + 1 + right.count;
+	treeNode.totalHeight = left.totalHeight + treeNode.height
+		+ right.totalHeight;
+	treeNode.totalVisibleCount = left.totalVisibleCount
+		+ treeNode.visibleCount + right.totalVisibleCount;
+
+	if (treeNode.left != 0)
+		fNodes[treeNode.left].parent = node;
+	if (treeNode.right != 0)
+		fNodes[treeNode.right].parent = node;
+}
+
+
+/*!	Splits the sub-tree \a node into one with its first \a count nodes, and
+	one with the rest.
+*/
+void
+RowPositionTree::_Split(int32 node, int32 count, int32& _left, int32& _right)
+{
+	if (node == 0) {
+		_left = 0;
+		_right = 0;
+		return;
+	}
+
+	tree_node& treeNode = fNodes[node];
+	int32 leftCount = fNodes[treeNode.left].count;
+	if (count <= leftCount) {
+		_Split(treeNode.left, count, _left, treeNode.left);
+		_right = node;
+	} else {
+		_Split(treeNode.right, count - leftCount - 1, treeNode.right, _right);
+		_left = node;
+	}
+
+	_Update(node);
+}
+
+
+/*!	Joins the sub-trees \a left, and \a right, where all of the nodes in
+	\a left come first.
+*/
+int32
+RowPositionTree::_Merge(int32 left, int32 right)
+{
+	if (left == 0)
+		return right;
+	if (right == 0)
+		return left;
+
+	if (fNodes[left].priority > fNodes[right].priority) {
+		fNodes[left].right = _Merge(fNodes[left].right, right);
+		_Update(left);
+		return left;
+	}
+
+	fNodes[right].left = _Merge(left, fNodes[right].left);
+	_Update(right);
+	return right;
+}
+
+
+// #pragma mark -
+
+
 RecursiveOutlineIterator::RecursiveOutlineIterator(BRowContainer* list,
-	bool openBranchesOnly)
+	bool openBranchesOnly, int32 startIndex)
 	:
 	fStackIndex(0),
-	fCurrentListIndex(0),
+	fCurrentListIndex(startIndex),
 	fCurrentListDepth(0),
 	fOpenBranchesOnly(openBranchesOnly)
 {
-	if (list == 0 || list->CountItems() == 0)
+	if (list == 0 || startIndex < 0 || startIndex >= list->CountItems())
 		fCurrentList = 0;
 	else
 		fCurrentList = list;
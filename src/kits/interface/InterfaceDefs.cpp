@@ -1655,6 +1655,37 @@ set_control_look(const BString& path)
 }
 
 
+/*!	\brief Returns whether the app_server keeps the contents of covered
+		windows, and puts them back without asking the windows to redraw.
+*/
+bool
+get_compositing()
+{
+	BPrivate::AppServerLink link;
+	link.StartMessage(AS_GET_COMPOSITING);
+
+	int32 code;
+	bool compositing;
+	if (link.FlushWithReply(code) != B_OK || code != B_OK
+		|| link.Read<bool>(&compositing) != B_OK)
+		return false;
+
+	return compositing;
+}
+
+
+//!	\brief Private function which turns the compositing mode on or off.
+void
+set_compositing(bool compositing)
+{
+	BPrivate::AppServerLink link;
+
+	link.StartMessage(AS_SET_COMPOSITING);
+	link.Attach<bool>(compositing);
+	link.Flush();
+}
+
+
 status_t
 get_application_order(int32 workspace, team_id** _applications,
 	int32* _count)
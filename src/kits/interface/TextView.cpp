@@ -1,5 +1,5 @@
 /*
- * Copyright 2001-2020 Haiku, Inc. All rights reserved.
+ * Copyright 2001-2026 Haiku, Inc. All rights reserved.
  * Distributed under the terms of the MIT License.
  *
  * Authors:
@@ -27,6 +27,7 @@
 
 #include <algorithm>
 #include <new>
+#include <vector>
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -159,7 +160,9 @@ struct BTextView::LayoutData {
 		  rightInset(0),
 		  bottomInset(0),
 		  valid(false),
-		  overridden(false)
+		  overridden(false),
+		  layoutPending(false),
+		  scrollBarsOutdated(false)
 	{
 	}
 
@@ -172,6 +175,8 @@ struct BTextView::LayoutData {
 	BSize				preferred;
 	bool				valid : 1;
 	bool				overridden : 1;
+	bool				layoutPending : 1;
+	bool				scrollBarsOutdated : 1;
 };
 
 
@@ -184,6 +189,10 @@ static const float kVerticalScrollBarStep = 12.0;
 static const int32 kMsgNavigateArrow = '_NvA';
 static const int32 kMsgNavigatePage  = '_NvP';
 static const int32 kMsgRemoveWord    = '_RmW';
+static const int32 kMsgLayoutLines   = '_LyL';
+
+static const int32 kLayoutChunkSize = 64 * 1024;
+	// the amount of text that is laid out at once outside of the visible area
 
 
 static property_info sPropertyList[] = {
@@ -534,6 +543,21 @@ BTextView::Draw(BRect updateRect)
 	int32 startLine = _LineAt(BPoint(0.0, updateRect.top));
 	int32 endLine = _LineAt(BPoint(0.0, updateRect.bottom));
 
+	// lay out those that have only been estimated so far
+	if (_LayoutEstimatedLines(startLine, endLine) != 0) {
+		// everything below has moved, and the estimated lines may not have
+		// covered all of the update rect
+		_FitTextRectToLines();
+		endLine = _LineAt(BPoint(0.0, updateRect.bottom));
+
+		BRect bounds = Bounds();
+		bounds.top = (*fLines)[startLine]->origin + fTextRect.top;
+		Invalidate(bounds);
+
+		fLayoutData->scrollBarsOutdated = true;
+		_ScheduleLayout();
+	}
+
 	_DrawLines(startLine, endLine, -1, true);
 }
 
@@ -1035,6 +1059,10 @@ BTextView::MessageReceived(BMessage* message)
 			break;
 		}
 
+		case kMsgLayoutLines:
+			_ContinueLayout();
+			break;
+
 		default:
 			BView::MessageReceived(message);
 			break;
@@ -1338,6 +1366,7 @@ BTextView::ByteAt(int32 offset) const
 int32
 BTextView::CountLines() const
 {
+	_LayoutLinesUpTo(INT32_MAX);
 	return fLines->NumLines();
 }
 
@@ -1770,6 +1799,8 @@ BTextView::LineAt(int32 offset) const
 	else if (offset > fText->Length())
 		offset = fText->Length();
 
+	_LayoutLinesUpToOffset(offset);
+
 	int32 lineNum = _LineAt(offset);
 	if (_IsOnEmptyLastLine(offset))
 		lineNum++;
@@ -1780,6 +1811,8 @@ BTextView::LineAt(int32 offset) const
 int32
 BTextView::LineAt(BPoint point) const
 {
+	_LayoutLinesUpToPixel(point.y);
+
 	int32 lineNum = _LineAt(point);
 	if ((*fLines)[lineNum + 1]->origin <= point.y - fTextRect.top)
 		lineNum++;
@@ -1797,6 +1830,8 @@ BTextView::PointAt(int32 offset, float* _height) const
 	else if (offset > fText->Length())
 		offset = fText->Length();
 
+	_LayoutLinesUpToOffset(offset);
+
 	// ToDo: Cleanup.
 	int32 lineNum = _LineAt(offset);
 	STELine* line = (*fLines)[lineNum];
@@ -1854,6 +1889,8 @@ BTextView::OffsetAt(BPoint point) const
 {
 	const int32 textLength = fText->Length();
 
+	_LayoutLinesUpToPixel(point.y);
+
 	// should we even bother?
 	if (point.y >= fTextRect.bottom)
 		return textLength;
@@ -1933,6 +1970,8 @@ BTextView::OffsetAt(int32 line) const
 	if (line < 0)
 		return 0;
 
+	_LayoutLinesUpTo(line);
+
 	if (line > fLines->NumLines())
 		return fText->Length();
 
@@ -2035,6 +2074,8 @@ BTextView::CanEndLine(int32 offset)
 float
 BTextView::LineWidth(int32 lineNumber) const
 {
+	_LayoutLinesUpTo(lineNumber);
+
 	if (lineNumber < 0 || lineNumber >= fLines->NumLines())
 		return 0;
 
@@ -2075,26 +2116,12 @@ BTextView::LineHeight(int32 lineNumber) const
 float
 BTextView::TextHeight(int32 startLine, int32 endLine) const
 {
-	const int32 numLines = fLines->NumLines();
-	if (startLine < 0)
-		startLine = 0;
-	else if (startLine > numLines - 1)
-		startLine = numLines - 1;
-
-	if (endLine < 0)
-		endLine = 0;
-	else if (endLine > numLines - 1)
-		endLine = numLines - 1;
-
-	float height = (*fLines)[endLine + 1]->origin
-		- (*fLines)[startLine]->origin;
+	int32 lastLine = std::max(startLine, endLine);
+	if (lastLine >= fLines->NumLines() - 1)
+		lastLine = INT32_MAX;
+	_LayoutLinesUpTo(lastLine);
 
-	if (startLine != endLine && endLine == numLines - 1
-		&& fText->RealCharAt(fText->Length() - 1) == B_ENTER) {
-		height += (*fLines)[endLine + 1]->origin - (*fLines)[endLine]->origin;
-	}
-
-	return ceilf(height);
+	return _LinesHeight(startLine, endLine);
 }
 
 
@@ -2198,7 +2225,7 @@ BTextView::ScrollToOffset(int32 offset)
 	}
 
 	// vertical
-	if (CountLines() > 1) {
+	if (fLines->NumLines() > 1) {
 		// scroll in Y only if multiple lines!
 		if (point.y < bounds.top - fLayoutData->topInset)
 			scrollBy.y = point.y - bounds.top - fLayoutData->topInset;
@@ -2212,7 +2239,7 @@ BTextView::ScrollToOffset(int32 offset)
 	ScrollBy(scrollBy.x, scrollBy.y);
 
 	// Update text rect position and scroll bars
-	if (CountLines() > 1 && !fWrap)
+	if (fLines->NumLines() > 1 && !fWrap)
 		FrameResized(Bounds().Width(), Bounds().Height());
 }
 
@@ -3839,7 +3866,7 @@ BTextView::_Refresh(int32 fromOffset, int32 toOffset, int32 scrollTo)
 	int32 saveFromLine = fromLine;
 	int32 saveToLine = toLine;
 
-	_RecalculateLineBreaks(&fromLine, &toLine);
+	_RecalculateLineBreaks(&fromLine, &toLine, true);
 
 	// TODO: Maybe there is still something we can do without a window...
 	if (!Window())
@@ -3896,9 +3923,12 @@ BTextView::_Refresh(int32 fromOffset, int32 toOffset, int32 scrollTo)
 
 	\param startLine The line number to start recalculating line breaks.
 	\param endLine The line number to stop recalculating line breaks.
+	\param estimate Whether the lines more than a page below the visible area
+		may only be estimated, if there are a lot of them.
 */
 void
-BTextView::_RecalculateLineBreaks(int32* startLine, int32* endLine)
+BTextView::_RecalculateLineBreaks(int32* startLine, int32* endLine,
+	bool estimate)
 {
 	CALLED();
 
@@ -3919,7 +3949,25 @@ BTextView::_RecalculateLineBreaks(int32* startLine, int32* endLine)
 	STELine* curLine = (*fLines)[lineIndex];
 	STELine* nextLine = curLine + 1;
 
+	// Laying out a large text takes a while, and most of it will not be
+	// looked at right away: everything further below than the next page is
+	// only estimated, and laid out later on, when needed.
+	float estimateBelow = 0;
+	estimate = estimate && Window() != NULL && !fResizable;
+	if (estimate) {
+		BRect bounds = Bounds();
+		estimateBelow = bounds.bottom + bounds.Height() - fTextRect.top;
+	}
+	bool estimated = false;
+
 	do {
+		if (estimate && curLine->origin > estimateBelow
+			&& recalThreshold - curLine->offset > kLayoutChunkSize) {
+			lineIndex = _EstimateLines(lineIndex, recalThreshold);
+			estimated = true;
+			break;
+		}
+
 		float ascent, descent;
 		int32 fromOffset = curLine->offset;
 		int32 toOffset = _FindLineBreak(fromOffset, &ascent, &descent, &width);
@@ -3940,6 +3988,7 @@ BTextView::_RecalculateLineBreaks(int32* startLine, int32* endLine)
 			newLine.offset = toOffset;
 			newLine.origin = ceilf(curLine->origin + ascent + descent) + 1;
 			newLine.ascent = 0;
+			newLine.width = 0;
 			fLines->InsertLine(&newLine, lineIndex);
 		} else {
 			// update the existing line
@@ -3974,12 +4023,26 @@ BTextView::_RecalculateLineBreaks(int32* startLine, int32* endLine)
 	// has always a width of 0
 	(*fLines)[fLines->NumLines()]->width = 0;
 
+	_FitTextRectToLines();
+
+	*endLine = lineIndex - 1;
+	*startLine = std::min(*startLine, *endLine);
+
+	if (estimated)
+		_ScheduleLayout();
+}
+
+
+//!	Adjusts the size of the text rect to the current line breaks.
+void
+BTextView::_FitTextRectToLines()
+{
 	// update text rect
 	fTextRect.left = Bounds().left + fLayoutData->leftInset;
 	fTextRect.right = Bounds().right - fLayoutData->rightInset;
 
 	// always set text rect bottom
-	float newHeight = TextHeight(0, fLines->NumLines() - 1);
+	float newHeight = _LinesHeight(0, fLines->NumLines() - 1);
 	fTextRect.bottom = fTextRect.top + newHeight;
 
 	if (!fWrap) {
@@ -4007,9 +4070,33 @@ BTextView::_RecalculateLineBreaks(int32* startLine, int32* endLine)
 
 		_ValidateTextRect();
 	}
+}
 
-	*endLine = lineIndex - 1;
-	*startLine = std::min(*startLine, *endLine);
+
+//!	Returns the height of the given lines, without laying out any of them.
+float
+BTextView::_LinesHeight(int32 startLine, int32 endLine) const
+{
+	const int32 numLines = fLines->NumLines();
+	if (startLine < 0)
+		startLine = 0;
+	else if (startLine > numLines - 1)
+		startLine = numLines - 1;
+
+	if (endLine < 0)
+		endLine = 0;
+	else if (endLine > numLines - 1)
+		endLine = numLines - 1;
+
+	float height = (*fLines)[endLine + 1]->origin
+		- (*fLines)[startLine]->origin;
+
+	if (startLine != endLine && endLine == numLines - 1
+		&& fText->RealCharAt(fText->Length() - 1) == B_ENTER) {
+		height += (*fLines)[endLine + 1]->origin - (*fLines)[endLine]->origin;
+	}
+
+	return ceilf(height);
 }
 
 
@@ -4176,6 +4263,260 @@ BTextView::_FindLineBreak(int32 fromOffset, float* _ascent, float* _descent,
 }
 
 
+/*!	Replaces the lines from \a lineIndex up to the first paragraph starting
+	at or after \a minOffset with one estimated line per paragraph.
+
+	\return The index of the first line after the estimated ones.
+*/
+int32
+BTextView::_EstimateLines(int32 lineIndex, int32 minOffset)
+{
+	// the lines after lineIndex haven't been touched yet, and are still in
+	// order, so the first one to keep can be looked up
+	int32 endLine = _LineAt(minOffset);
+	if ((*fLines)[endLine]->offset < minOffset)
+		endLine++;
+	endLine = std::max(endLine, lineIndex + 1);
+	while (endLine < fLines->NumLines()
+		&& fText->RealCharAt((*fLines)[endLine]->offset - 1) != B_ENTER) {
+		endLine++;
+	}
+
+	const int32 endOffset = (*fLines)[endLine]->offset;
+	const float endOrigin = (*fLines)[endLine]->origin;
+
+	std::vector<STELine> lines;
+	STELine line;
+	line.offset = (*fLines)[lineIndex]->offset;
+	line.origin = (*fLines)[lineIndex]->origin;
+	line.width = kEstimatedLineWidth;
+
+	while (line.offset < endOffset) {
+		// the height of the first character is used for the whole paragraph
+		float ascent, descent;
+		fStyles->Iterate(line.offset, 1, fInline, NULL, NULL, &ascent,
+			&descent);
+		line.ascent = ascent;
+		lines.push_back(line);
+
+		int32 length = endOffset - line.offset;
+		if (fText->FindChar(B_ENTER, line.offset, &length))
+			length++;
+
+		line.offset += length;
+		line.origin = ceilf(line.origin + ascent + descent) + 1;
+	}
+
+	fLines->ReplaceLines(lineIndex, endLine - lineIndex, &lines[0],
+		lines.size());
+
+	endLine = lineIndex + lines.size();
+	if (line.origin != endOrigin)
+		fLines->BumpOrigin(line.origin - endOrigin, endLine);
+
+	return endLine;
+}
+
+
+/*!	Lays out the estimated lines between \a fromLine and \a toLine for real.
+
+	\return By how much this changed the height of the text.
+*/
+float
+BTextView::_LayoutEstimatedLines(int32 fromLine, int32 toLine)
+{
+	toLine = std::min(toLine, fLines->NumLines() - 1);
+	fromLine = std::max(fromLine, fLines->FirstEstimatedLine());
+
+	std::vector<STELine> lines;
+	float heightChange = 0;
+
+	for (int32 lineIndex = fromLine; lineIndex <= toLine; lineIndex++) {
+		if ((*fLines)[lineIndex]->width != kEstimatedLineWidth)
+			continue;
+
+		int32 endLine = lineIndex + 1;
+		while (endLine <= toLine
+			&& (*fLines)[endLine]->width == kEstimatedLineWidth) {
+			endLine++;
+		}
+
+		const int32 fromOffset = (*fLines)[lineIndex]->offset;
+		const int32 toOffset = (*fLines)[endLine]->offset;
+		const float endOrigin = (*fLines)[endLine]->origin;
+
+#if USE_WIDTHBUFFER
+		// Measuring all of the text first lets the width buffer ask the
+		// app_server for all characters it doesn't know yet at once, instead
+		// of once for every word.
+		if (BPrivate::gWidthBuffer != NULL)
+			_StyledWidth(fromOffset, toOffset - fromOffset);
+#endif
+
+		lines.clear();
+		STELine line;
+		line.offset = fromOffset;
+		line.origin = (*fLines)[lineIndex]->origin;
+
+		while (line.offset < toOffset) {
+			float ascent, descent;
+			float width = fTextRect.Width();
+			int32 nextOffset = _FindLineBreak(line.offset, &ascent, &descent,
+				&width);
+
+			// we want to advance at least by one character
+			nextOffset = std::max(nextOffset, _NextInitialByte(line.offset));
+
+			line.ascent = ascent;
+			line.width = width;
+			lines.push_back(line);
+
+			line.offset = std::min(nextOffset, toOffset);
+			line.origin = ceilf(line.origin + ascent + descent) + 1;
+		}
+
+		int32 count = endLine - lineIndex;
+		fLines->ReplaceLines(lineIndex, count, &lines[0], lines.size());
+
+		int32 added = (int32)lines.size() - count;
+		if (line.origin != endOrigin) {
+			fLines->BumpOrigin(line.origin - endOrigin, endLine + added);
+			heightChange += line.origin - endOrigin;
+		}
+
+		toLine += added;
+		lineIndex = endLine + added - 1;
+	}
+
+	return heightChange;
+}
+
+
+/*!	Lays out the next chunk of estimated lines.
+
+	Since this only changes how the text is broken into lines, it is also used
+	by the const methods that need to report about them.
+
+	\return \c false if there was nothing left to lay out.
+*/
+bool
+BTextView::_LayoutNextLines() const
+{
+	int32 fromLine = fLines->FirstEstimatedLine();
+	if (fromLine >= fLines->NumLines())
+		return false;
+
+	BTextView* self = const_cast<BTextView*>(this);
+	float heightChange = self->_LayoutEstimatedLines(fromLine,
+		_LineAt((*fLines)[fromLine]->offset + kLayoutChunkSize));
+
+	if (heightChange != 0) {
+		self->_FitTextRectToLines();
+
+		if (Window() != NULL) {
+			if ((*fLines)[fromLine]->origin + fTextRect.top <= Bounds().bottom)
+				self->Invalidate();
+
+			fLayoutData->scrollBarsOutdated = true;
+			self->_ScheduleLayout();
+		}
+	}
+
+	return fLines->FirstEstimatedLine() != fromLine;
+}
+
+
+//!	Makes sure that the lines up to and including \a line are laid out.
+void
+BTextView::_LayoutLinesUpTo(int32 line) const
+{
+	while (fLines->FirstEstimatedLine() <= line && _LayoutNextLines()) {
+	}
+}
+
+
+//!	Makes sure that the line containing \a offset is laid out, and all before.
+void
+BTextView::_LayoutLinesUpToOffset(int32 offset) const
+{
+	int32 line;
+	while ((line = fLines->FirstEstimatedLine()) < fLines->NumLines()
+		&& (*fLines)[line]->offset <= offset && _LayoutNextLines()) {
+	}
+}
+
+
+//!	Makes sure that the lines above the vertical position \a y are laid out.
+void
+BTextView::_LayoutLinesUpToPixel(float y) const
+{
+	int32 line;
+	while ((line = fLines->FirstEstimatedLine()) < fLines->NumLines()
+		&& (*fLines)[line]->origin + fTextRect.top <= y
+		&& _LayoutNextLines()) {
+	}
+}
+
+
+//!	Lets _ContinueLayout() run once the window has nothing else to do.
+void
+BTextView::_ScheduleLayout()
+{
+	if (fLayoutData->layoutPending || Looper() == NULL)
+		return;
+
+	if (Looper()->PostMessage(kMsgLayoutLines, this) == B_OK)
+		fLayoutData->layoutPending = true;
+}
+
+
+/*!	Lays out the next chunk of estimated lines, and schedules the one after
+	it, so that the window remains responsive while a large text is laid out.
+*/
+void
+BTextView::_ContinueLayout()
+{
+	fLayoutData->layoutPending = false;
+
+	float heightChange = 0;
+	bool aboveView = false;
+
+	int32 fromLine = fLines->FirstEstimatedLine();
+	if (fromLine < fLines->NumLines()) {
+		BRect bounds = Bounds();
+		int32 toLine = _LineAt((*fLines)[fromLine]->offset + kLayoutChunkSize);
+
+		float top = (*fLines)[fromLine]->origin + fTextRect.top;
+		aboveView = top < bounds.top;
+		if (aboveView) {
+			// don't let the lines in view move, the view is scrolled instead
+			toLine = std::max(fromLine,
+				std::min(toLine, _LineAt(BPoint(0, bounds.top)) - 1));
+		}
+
+		heightChange = _LayoutEstimatedLines(fromLine, toLine);
+		if (heightChange != 0) {
+			_FitTextRectToLines();
+			fLayoutData->scrollBarsOutdated = true;
+
+			if (!aboveView && top <= bounds.bottom)
+				Invalidate();
+		}
+	}
+
+	if (fLayoutData->scrollBarsOutdated) {
+		fLayoutData->scrollBarsOutdated = false;
+		_UpdateScrollbars();
+	}
+
+	if (aboveView && heightChange != 0)
+		ScrollBy(0, heightChange);
+
+	if (fLines->FirstEstimatedLine() < fLines->NumLines())
+		_ScheduleLayout();
+}
+
+
 int32
 BTextView::_PreviousLineStart(int32 offset)
 {
@@ -5057,7 +5398,7 @@ BTextView::_PerformAutoScrolling()
 	if (fTextRect.left > bounds.left && fTextRect.right < bounds.right)
 		scrollBy.x = 0;
 
-	if (CountLines() > 1) {
+	if (fLines->NumLines() > 1) {
 		// scroll in Y only if multiple lines!
 		if (fWhere.y > bounds.bottom)
 			scrollBy.y = fWhere.y - bounds.bottom;
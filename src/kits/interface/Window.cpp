@@ -30,6 +30,7 @@
 #include <InputServerTypes.h>
 #include <Layout.h>
 #include <LayoutUtils.h>
+#include <LinkRing.h>
 #include <MenuBar.h>
 #include <MenuItem.h>
 #include <MenuPrivate.h>
@@ -788,6 +789,7 @@ BWindow::MessageReceived(BMessage* message)
 
 			// Redirect our link to the new window connection
 			fLink->SetSenderPort(sendPort);
+			_AttachLinkRing();
 
 			// connect all views to the server again
 			fTopView->_CreateSelf();
@@ -2902,6 +2904,9 @@ BWindow::_InitData(BRect frame, const char* title, window_look look,
 		STRACE(("Server says that our send port is %ld\n", sendPort));
 	}
 
+	if (!fOffscreen)
+		_AttachLinkRing();
+
 	STRACE(("Window locked?: %s\n", IsLocked() ? "True" : "False"));
 
 	_CreateTopView();
@@ -3153,6 +3158,35 @@ BWindow::_DecomposeType(window_type type, window_look* _look,
 }
 
 
+/*!	Asks the server for a shared memory ring to send our messages through,
+	so that the port is only needed to wake up the server. If that doesn't
+	work out, the link just keeps using the port alone.
+*/
+void
+BWindow::_AttachLinkRing()
+{
+	if (fLink->SenderPort() < B_OK)
+		return;
+
+	fLink->StartMessage(AS_ATTACH_LINK_RING);
+
+	int32 code;
+	area_id area;
+	if (fLink->FlushWithReply(code) != B_OK || code != B_OK
+		|| fLink->Read<area_id>(&area) != B_OK)
+		return;
+
+	BPrivate::LinkRing* ring = new(std::nothrow) BPrivate::LinkRing;
+	if (ring == NULL || ring->Clone(area) != B_OK) {
+		// the server keeps looking into its ring, but that doesn't hurt
+		delete ring;
+		return;
+	}
+
+	fLink->Sender().SetRing(ring);
+}
+
+
 void
 BWindow::_CreateTopView()
 {
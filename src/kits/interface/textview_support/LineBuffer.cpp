@@ -1,5 +1,5 @@
 /*
- * Copyright 2001-2006, Haiku, Inc. All Rights Reserved.
+ * Copyright 2001-2026, Haiku, Inc. All Rights Reserved.
  * Distributed under the terms of the MIT License.
  *
  * Authors:
@@ -11,7 +11,9 @@
 
 
 BTextView::LineBuffer::LineBuffer()
-	:	_BTextViewSupportBuffer_<STELine>(20, 2)
+	:	_BTextViewSupportBuffer_<STELine>(20, 2),
+		fFirstEstimatedLine(0),
+		fEstimatedLineCount(0)
 {
 }
 
@@ -25,13 +27,43 @@ void
 BTextView::LineBuffer::InsertLine(STELine* inLine, int32 index)
 {
 	InsertItemsAt(1, index, inLine);
+
+	if (inLine->width == kEstimatedLineWidth) {
+		fFirstEstimatedLine = min_c(fFirstEstimatedLine, index);
+		fEstimatedLineCount++;
+	}
 }
 
 
 void
 BTextView::LineBuffer::RemoveLines(int32 index, int32 count)
 {
+	fEstimatedLineCount -= _CountEstimatedLines(index, count);
 	RemoveItemsAt(count, index);
+
+	fFirstEstimatedLine = min_c(fFirstEstimatedLine, index);
+}
+
+
+/*!	Replaces the \a count lines starting at \a index with \a newCount other
+	ones, moving the lines after them only once.
+*/
+void
+BTextView::LineBuffer::ReplaceLines(int32 index, int32 count,
+	const STELine* lines, int32 newCount)
+{
+	fEstimatedLineCount -= _CountEstimatedLines(index, count);
+
+	int32 common = min_c(count, newCount);
+	memcpy(&fBuffer[index], lines, common * sizeof(STELine));
+
+	if (newCount > count)
+		InsertItemsAt(newCount - count, index + common, lines + common);
+	else if (count > newCount)
+		RemoveItemsAt(count - newCount, index + common);
+
+	fFirstEstimatedLine = min_c(fFirstEstimatedLine, index);
+	fEstimatedLineCount += _CountEstimatedLines(index, newCount);
 }
 
 
@@ -124,3 +156,41 @@ BTextView::LineBuffer::MaxWidth() const
 	}
 	return maxWidth;
 }
+
+
+/*!	Returns the index of the first line that has only been estimated, or
+	NumLines() if there is none.
+*/
+int32
+BTextView::LineBuffer::FirstEstimatedLine() const
+{
+	int32 numLines = NumLines();
+	if (fEstimatedLineCount <= 0)
+		return numLines;
+
+	while (fFirstEstimatedLine < numLines
+		&& fBuffer[fFirstEstimatedLine].width != kEstimatedLineWidth) {
+		fFirstEstimatedLine++;
+	}
+
+	if (fFirstEstimatedLine >= numLines) {
+		// the ones that were counted have all been laid out in the mean time
+		fFirstEstimatedLine = numLines;
+		fEstimatedLineCount = 0;
+	}
+
+	return fFirstEstimatedLine;
+}
+
+
+int32
+BTextView::LineBuffer::_CountEstimatedLines(int32 index, int32 count) const
+{
+	int32 estimated = 0;
+	for (int32 i = index; i < index + count; i++) {
+		if (fBuffer[i].width == kEstimatedLineWidth)
+			estimated++;
+	}
+
+	return estimated;
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright 2001-2006, Haiku, Inc. All Rights Reserved.
+ * Copyright 2001-2026, Haiku, Inc. All Rights Reserved.
  * Distributed under the terms of the MIT License.
  *
  * Authors:
@@ -18,10 +18,17 @@ struct STELine {
 	long		offset;		// offset of first character of line
 	float		origin;		// pixel position of top of line
 	float		ascent;		// maximum ascent for line
-	float		width;		// cached width of line in pixels
+	float		width;		// cached width of line in pixels, or
+							// kEstimatedLineWidth
 };
 
 
+// Lines far outside of the visible area are not broken up right away: each
+// paragraph is only given a single line with an estimated height, and this
+// width, until it is laid out for real.
+static const float kEstimatedLineWidth = -1.0f;
+
+
 class BTextView::LineBuffer : public _BTextViewSupportBuffer_<STELine> {
 
 public:
@@ -30,6 +37,8 @@ public:
 
 			void				InsertLine(STELine* inLine, int32 index);
 			void				RemoveLines(int32 index, int32 count = 1);
+			void				ReplaceLines(int32 index, int32 count,
+									const STELine* lines, int32 newCount);
 			void				RemoveLineRange(int32 fromOffset,
 									int32 toOffset);
 
@@ -41,7 +50,18 @@ public:
 
 			int32				NumLines() const;
 			float				MaxWidth() const;
+			int32				FirstEstimatedLine() const;
 			STELine*			operator[](int32 index) const;
+
+private:
+			int32				_CountEstimatedLines(int32 index,
+									int32 count) const;
+
+private:
+	mutable	int32				fFirstEstimatedLine;
+									// no line before this one is estimated
+	mutable	int32				fEstimatedLineCount;
+									// there are at most this many of them
 };
 
 
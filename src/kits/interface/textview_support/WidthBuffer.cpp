@@ -1,5 +1,5 @@
 /*
- * Copyright 2003-2008, Haiku, Inc.
+ * Copyright 2003-2026, Haiku, Inc.
  * Distributed under the terms of the MIT License.
  *
  * Authors:
@@ -104,17 +104,17 @@ WidthBuffer::StringWidth(const char* inText, int32 fromOffset, int32 length,
 	if (!FindTable(inStyle, &index))
 		index = InsertTable(inStyle);
 
-	char* text = NULL;
-	int32 numChars = 0;
-	int32 textLen = 0;
+	char* missing = NULL;
+	int32 numMissingChars = 0;
+	int32 missingLength = 0;
 
 	const char* sourceText = inText + fromOffset;
 	const float fontSize = inStyle->Size();
 	float stringWidth = 0;
 
-	for (int32 charLen = 0; length > 0;
-			sourceText += charLen, length -= charLen) {
-		charLen = UTF8NextCharLen(sourceText, length);
+	for (int32 charLen = 0, remaining = length; remaining > 0;
+			sourceText += charLen, remaining -= charLen) {
+		charLen = UTF8NextCharLen(sourceText, remaining);
 
 		// End of string, bail out
 		if (charLen <= 0)
@@ -127,32 +127,35 @@ WidthBuffer::StringWidth(const char* inText, int32 fromOffset, int32 length,
 		if (GetEscapement(value, index, &escapement)) {
 			// Well, we've got a match for this character
 			stringWidth += escapement;
-		} else {
-			// Store this character into an array, which we'll
-			// pass to HashEscapements() later
-			int32 offset = textLen;
-			textLen += charLen;
-			numChars++;
-			char* newText = (char*)realloc(text, textLen + 1);
-			if (newText == NULL) {
-				free(text);
-				return 0;
-			}
+			continue;
+		}
 
-			text = newText;
-			memcpy(&text[offset], sourceText, charLen);
+		// Collect the characters which aren't yet in the hash table, so that
+		// HashEscapements() can get all of them from the app server at once.
+		// They are entered into the table right away, so that each of them is
+		// only asked for once.
+		if (missing == NULL) {
+			missing = (char*)malloc(remaining + 1);
+			if (missing == NULL)
+				return 0;
 		}
-	}
 
-	if (text != NULL) {
-		// We've found some characters which aren't yet in the hash table.
-		// Get their width via HashEscapements()
-		text[textLen] = 0;
-		stringWidth += HashEscapements(text, numChars, textLen, index, inStyle);
-		free(text);
+		memcpy(missing + missingLength, sourceText, charLen);
+		missingLength += charLen;
+		numMissingChars++;
+
+		InsertEscapement(value, index, 0);
 	}
 
-	return stringWidth * fontSize;
+	if (missing == NULL)
+		return stringWidth * fontSize;
+
+	missing[missingLength] = '\0';
+	HashEscapements(missing, numMissingChars, missingLength, index, inStyle);
+	free(missing);
+
+	// now that all characters are known, start over
+	return StringWidth(inText, fromOffset, length, inStyle);
 }
 
 
@@ -257,6 +260,67 @@ WidthBuffer::GetEscapement(uint32 value, int32 index, float* escapement)
 }
 
 
+/*!	\brief Puts the escapement for the given character into the hash table,
+		replacing the one that was there before, if any.
+	\param value An integer which uniquely identifies a character.
+	\param index The index of the table.
+	\param escapement The escapement of the character.
+*/
+void
+WidthBuffer::InsertEscapement(uint32 value, int32 index, float escapement)
+{
+	_width_table_ &table = fBuffer[index];
+	hashed_escapement* widths = static_cast<hashed_escapement*>(table.widths);
+
+	uint32 hashed = Hash(value) & (table.tableCount - 1);
+	uint32 found;
+	while ((found = widths[hashed].code) != kInvalidCode) {
+		if (found == value)
+			break;
+		if (++hashed >= (uint32)table.tableCount)
+			hashed = 0;
+	}
+
+	widths[hashed].escapement = escapement;
+	if (found != kInvalidCode)
+		return;
+
+	// The value is not in the table. Add it.
+	widths[hashed].code = value;
+	table.hashCount++;
+
+	// We always keep some free space in the hash table:
+	// we double the current size when hashCount is 2/3 of
+	// the total size.
+	if (table.tableCount * 2 / 3 <= table.hashCount) {
+		const int32 newSize = table.tableCount * 2;
+
+		// Create and initialize a new hash table
+		hashed_escapement* newWidths = new hashed_escapement[newSize];
+
+		// Rehash the values, and put them into the new table
+		for (uint32 oldPos = 0; oldPos < (uint32)table.tableCount;
+				oldPos++) {
+			if (widths[oldPos].code != kInvalidCode) {
+				uint32 newPos
+					= Hash(widths[oldPos].code) & (newSize - 1);
+				while (newWidths[newPos].code != kInvalidCode) {
+					if (++newPos >= (uint32)newSize)
+						newPos = 0;
+				}
+				newWidths[newPos] = widths[oldPos];
+			}
+		}
+
+		// Delete the old table, and put the new pointer into the
+		// _width_table_
+		delete[] widths;
+		table.tableCount = newSize;
+		table.widths = newWidths;
+	}
+}
+
+
 uint32
 WidthBuffer::Hash(uint32 val)
 {
@@ -270,18 +334,16 @@ WidthBuffer::Hash(uint32 val)
 }
 
 
-/*! \brief Gets the escapements for the given string, and put them into
-	the hash table.
+/*! \brief Gets the escapements for the given string with one request to the
+		app server, and puts them into the hash table.
 	\param inText The string to be examined.
 	\param numChars The amount of characters contained in the string.
 	\param textLen the amount of bytes contained in the string.
 	\param tableIndex the index of the table where the escapements
 		should be put.
 	\param inStyle the font.
-	\return The width of the supplied string (which should be multiplied by
-		the size of the font).
 */
-float
+void
 WidthBuffer::HashEscapements(const char* inText, int32 numChars, int32 textLen,
 	int32 tableIndex, const BFont* inStyle)
 {
@@ -292,11 +354,8 @@ WidthBuffer::HashEscapements(const char* inText, int32 numChars, int32 textLen,
 	float* escapements = new float[numChars];
 	inStyle->GetEscapements(inText, numChars, escapements);
 
-	_width_table_ &table = fBuffer[tableIndex];
-	hashed_escapement* widths = static_cast<hashed_escapement*>(table.widths);
-
 	int32 charCount = 0;
-	char* text = (char*)inText;
+	const char* text = inText;
 	const char* textEnd = inText + textLen;
 	// Insert the escapements into the hash table
 	do {
@@ -306,65 +365,14 @@ WidthBuffer::HashEscapements(const char* inText, int32 numChars, int32 textLen,
 		if (charLen == 0)
 			break;
 
-		const uint32 value = CharToCode(text, charLen);
-
-		uint32 hashed = Hash(value) & (table.tableCount - 1);
-		uint32 found;
-		while ((found = widths[hashed].code) != kInvalidCode) {
-			if (found == value)
-				break;
-			if (++hashed >= (uint32)table.tableCount)
-				hashed = 0;
-		}
-
-		if (found == kInvalidCode) {
-			// The value is not in the table. Add it.
-			widths[hashed].code = value;
-			widths[hashed].escapement = escapements[charCount];
-			table.hashCount++;
-
-			// We always keep some free space in the hash table:
-			// we double the current size when hashCount is 2/3 of
-			// the total size.
-			if (table.tableCount * 2 / 3 <= table.hashCount) {
-				const int32 newSize = table.tableCount * 2;
-
-				// Create and initialize a new hash table
-				hashed_escapement* newWidths = new hashed_escapement[newSize];
-
-				// Rehash the values, and put them into the new table
-				for (uint32 oldPos = 0; oldPos < (uint32)table.tableCount;
-						oldPos++) {
-					if (widths[oldPos].code != kInvalidCode) {
-						uint32 newPos
-							= Hash(widths[oldPos].code) & (newSize - 1);
-						while (newWidths[newPos].code != kInvalidCode) {
-							if (++newPos >= (uint32)newSize)
-								newPos = 0;
-						}
-						newWidths[newPos] = widths[oldPos];
-					}
-				}
+		InsertEscapement(CharToCode(text, charLen), tableIndex,
+			escapements[charCount]);
 
-				// Delete the old table, and put the new pointer into the
-				// _width_table_
-				delete[] widths;
-				table.tableCount = newSize;
-				table.widths = widths = newWidths;
-			}
-		}
 		charCount++;
 		text += charLen;
 	} while (text < textEnd);
 
-	// Calculate the width of the string
-	float width = 0;
-	for (int32 x = 0; x < numChars; x++)
-		width += escapements[x];
-
 	delete[] escapements;
-
-	return width;
 }
 
 } // namespace BPrivate
@@ -300,6 +300,39 @@ BNetworkInterface::GetStats(ifreq_stats& stats)
 }
 
 
+int32
+BNetworkInterface::CountReceiveQueues() const
+{
+	ifreceivequeuereq request;
+	request.ifrq_index = 0;
+	if (do_request(AF_INET, request, Name(),
+			B_SOCKET_GET_RECEIVE_QUEUE_STATS) != B_OK)
+		return 0;
+
+	return request.ifrq_count;
+}
+
+
+/*!	Retrieves the statistics of one of the receive queues of the interface.
+	Incoming packets are spread over these queues by flow, so that they can
+	be processed on several CPUs at once.
+*/
+status_t
+BNetworkInterface::GetReceiveQueueStats(int32 index,
+	ifreq_stream_stats& stats) const
+{
+	ifreceivequeuereq request;
+	request.ifrq_index = index;
+	status_t status = do_request(AF_INET, request, Name(),
+		B_SOCKET_GET_RECEIVE_QUEUE_STATS);
+	if (status != B_OK)
+		return status;
+
+	memcpy(&stats, &request.ifrq_stats, sizeof(ifreq_stream_stats));
+	return B_OK;
+}
+
+
 bool
 BNetworkInterface::HasLink() const
 {
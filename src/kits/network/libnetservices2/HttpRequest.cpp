@@ -493,9 +493,9 @@ BHttpRequest::SerializeHeaderTo(HttpBuffer& buffer) const
 			// of what it means (the RFC and Microsoft products), and we don't
 			// want to handle this. Very few websites support only deflate,
 			// and most of them will send gzip, or at worst, uncompressed data.
-			{"Connection"sv, "close"sv}
-			// Let the remote server close the connection after response since
-			// we don't handle multiple request on a single connection
+			{"Connection"sv, "keep-alive"sv}
+			// BHttpSession keeps connections open to reuse them for later
+			// requests to the same host
 		});
 	}
 
@@ -12,6 +12,10 @@
 #include <list>
 #include <map>
 #include <optional>
+#include <strings.h>
+#include <sys/socket.h>
+#include <tuple>
+#include <unistd.h>
 #include <vector>
 
 #include <AutoLocker.h>
@@ -31,6 +35,9 @@
 #include <Socket.h>
 #include <ZlibCompressionAlgorithm.h>
 
+#include <event_queue_defs.h>
+#include <syscalls.h>
+
 #include "HttpBuffer.h"
 #include "HttpParser.h"
 #include "HttpResultPrivate.h"
@@ -50,6 +57,21 @@ using namespace BPrivate::Network;
 static constexpr ssize_t kMaxHeaderLineSize = 64 * 1024;
 
 
+/*!
+	\brief Time after which an idle connection that was kept alive for reuse is closed.
+
+	Servers usually close idle connections on their side after 5 to 60 seconds. Connections
+	that the server closed earlier are detected before they are reused.
+*/
+static constexpr bigtime_t kIdleConnectionTimeout = 15000000;
+
+
+/*!
+	\brief Maximum number of events that the data thread picks up from the event queue at once.
+*/
+static constexpr int kMaxEventsPerWait = 32;
+
+
 struct CounterDeleter {
 	void operator()(int32* counter) const noexcept { atomic_add(counter, -1); }
 };
@@ -58,10 +80,19 @@ struct CounterDeleter {
 class BHttpSession::Request
 {
 public:
+	// Thrown when a request on a reused connection can be sent again on a new connection
+	struct Retry {
+	};
+
+	// Identifies the connections that can be shared between requests
+	using ConnectionKey = std::tuple<BString, int, bool>;
+
 	Request(BHttpRequest&& request, BBorrow<BDataIO> target, BMessenger observer);
 
 	Request(Request& original, const Redirect& redirect);
 
+	Request(Request& original, const Retry& retry);
+
 	// States
 	enum RequestState { InitialState, Connected, RequestSent, ContentReceived };
 	RequestState State() const noexcept { return fRequestStatus; }
@@ -74,9 +105,17 @@ public:
 	std::pair<BString, int> GetHost() const;
 	void SetCounter(int32* counter) noexcept;
 
+	// Helpers for the connection pool
+	ConnectionKey GetConnectionKey() const;
+	bool MayReuseConnection() const noexcept { return !fRetried; }
+	bool CanReuseConnection() const noexcept;
+	bool CanRetry() const noexcept;
+	std::unique_ptr<BSocket> ReleaseSocket() noexcept { return std::move(fSocket); }
+
 	// Operational methods
 	void ResolveHostName();
 	void OpenConnection();
+	void ReuseConnection(std::unique_ptr<BSocket> socket);
 	void TransferRequest();
 	bool ReceiveResult();
 	void Disconnect() noexcept;
@@ -102,6 +141,9 @@ private:
 	// Connection
 	BNetworkAddress fRemoteAddress;
 	std::unique_ptr<BSocket> fSocket;
+	bool fReusedConnection = false;
+	bool fRetried = false;
+	bool fKeepAlive = false;
 
 	// Sending and receiving
 	HttpBuffer fBuffer;
@@ -140,6 +182,16 @@ private:
 	// Helper functions
 	std::vector<BHttpSession::Request> GetRequestsForControlThread();
 
+	// Connection pool
+	using ConnectionKey = BHttpSession::Request::ConnectionKey;
+	std::unique_ptr<BSocket> TakeIdleConnection(const ConnectionKey& key);
+	void AddIdleConnection(const ConnectionKey& key, std::unique_ptr<BSocket> socket);
+	bigtime_t ExpireIdleConnections();
+
+	// Data thread helpers
+	void WatchSocket(int socket, int32 events);
+	void FinishRequest(std::map<int, BHttpSession::Request>::iterator it, bool keepConnection);
+
 private:
 		// constants (can be accessed unlocked)
 	const sem_id fControlQueueSem;
@@ -164,9 +216,16 @@ private:
 	std::atomic<size_t> fMaxConnectionsPerHost = 2;
 	std::atomic<size_t> fMaxHosts = 10;
 
+	// idle connections that are kept alive for reuse (protected by fLock)
+	struct IdleConnection {
+		std::unique_ptr<BSocket> socket;
+		bigtime_t expires;
+	};
+	std::map<ConnectionKey, std::deque<IdleConnection>> fIdleConnections;
+
 	// data owned by the dataThread
 	std::map<int, BHttpSession::Request> connectionMap;
-	std::vector<object_wait_info> objectList;
+	int fEventQueue = -1;
 };
 
 
@@ -298,8 +357,16 @@ BHttpSession::Impl::ControlThreadFunc(void* arg)
 		for (auto& request: requests) {
 			bool hasError = false;
 			try {
-				request.ResolveHostName();
-				request.OpenConnection();
+				std::unique_ptr<BSocket> socket;
+				if (request.MayReuseConnection())
+					socket = impl->TakeIdleConnection(request.GetConnectionKey());
+
+				if (socket)
+					request.ReuseConnection(std::move(socket));
+				else {
+					request.ResolveHostName();
+					request.OpenConnection();
+				}
 			} catch (...) {
 				request.SetError(std::current_exception());
 				hasError = true;
@@ -343,100 +410,122 @@ BHttpSession::Impl::ControlThreadFunc(void* arg)
 }
 
 
-static constexpr uint16 EVENT_CANCELLED = 0x4000;
-
-
 /*static*/ status_t
 BHttpSession::Impl::DataThreadFunc(void* arg)
 {
 	BHttpSession::Impl* data = static_cast<BHttpSession::Impl*>(arg);
 
-	// initial initialization of wait list
-	data->objectList.push_back(
-		object_wait_info{data->fDataQueueSem, B_OBJECT_TYPE_SEMAPHORE, B_EVENT_ACQUIRE_SEMAPHORE});
+	// The semaphore and the sockets of the active requests are watched through a kernel event
+	// queue. Only changes are passed on to the kernel, instead of handing over the complete list
+	// of objects for every wait.
+	data->fEventQueue = _kern_event_queue_create(O_CLOEXEC);
+	if (data->fEventQueue < 0)
+		throw BSystemError("_kern_event_queue_create()", data->fEventQueue);
+
+	event_wait_info semaphoreInfo = {data->fDataQueueSem, B_OBJECT_TYPE_SEMAPHORE,
+		B_EVENT_ACQUIRE_SEMAPHORE | B_EVENT_LEVEL_TRIGGERED, nullptr};
+	if (auto status = _kern_event_queue_select(data->fEventQueue, &semaphoreInfo, 1);
+		status != B_OK) {
+		throw BSystemError("_kern_event_queue_select()", status);
+	}
+
+	event_wait_info events[kMaxEventsPerWait];
+	bigtime_t nextExpiry = B_INFINITE_TIMEOUT;
+	bool quit = false;
 
-	while (true) {
-		if (auto status = wait_for_objects(data->objectList.data(), data->objectList.size());
-			status == B_INTERRUPTED)
+	while (!quit) {
+		auto count = _kern_event_queue_wait(data->fEventQueue, events, kMaxEventsPerWait,
+			nextExpiry == B_INFINITE_TIMEOUT ? 0 : B_ABSOLUTE_TIMEOUT, nextExpiry);
+		if (count == B_INTERRUPTED)
 			continue;
-		else if (status < 0) {
+		else if (count == B_TIMED_OUT)
+			count = 0;
+		else if (count < 0) {
 			// Something went inexplicably wrong
-			throw BSystemError("wait_for_objects()", status);
+			throw BSystemError("_kern_event_queue_wait()", count);
 		}
 
-		// First check if the change is in acquiring the sem, meaning that
-		// there are new requests to be scheduled
-		if (data->objectList[0].events == B_EVENT_ACQUIRE_SEMAPHORE) {
-			if (auto status = acquire_sem(data->fDataQueueSem); status == B_INTERRUPTED)
-				continue;
-			else if (status != B_OK) {
-				// Most likely B_BAD_SEM_ID indicating that the sem was deleted
-				break;
-			}
+		for (ssize_t i = 0; i < count; i++) {
+			const auto& event = events[i];
 
-			// Process the cancelList and dataQueue. Note that there might
-			// be a situation where a request is cancelled and added in the
-			// same iteration, but that is taken care by this algorithm.
-			data->fLock.Lock();
-			while (!data->fDataQueue.empty()) {
-				auto request = std::move(data->fDataQueue.front());
-				data->fDataQueue.pop_front();
-				auto socket = request.Socket();
+			if (event.type == B_OBJECT_TYPE_SEMAPHORE) {
+				if ((event.events & B_EVENT_INVALID) != 0) {
+					// The semaphore has been deleted. Start the cleanup
+					quit = true;
+					break;
+				}
 
-				data->connectionMap.insert(std::make_pair(socket, std::move(request)));
+				// Consume all releases at once, the queues are processed completely anyway
+				status_t status;
+				do {
+					status = acquire_sem_etc(data->fDataQueueSem, 1, B_RELATIVE_TIMEOUT, 0);
+				} while (status == B_OK || status == B_INTERRUPTED);
+				if (status == B_BAD_SEM_ID) {
+					quit = true;
+					break;
+				}
 
-				// Add to objectList
-				data->objectList.push_back(
-					object_wait_info{socket, B_OBJECT_TYPE_FD, B_EVENT_WRITE});
-			}
+				// Process the cancelList and dataQueue. Note that there might
+				// be a situation where a request is cancelled and added in the
+				// same iteration, but that is taken care by this algorithm.
+				data->fLock.Lock();
+				while (!data->fDataQueue.empty()) {
+					auto request = std::move(data->fDataQueue.front());
+					data->fDataQueue.pop_front();
+					auto socket = request.Socket();
+
+					data->connectionMap.insert(std::make_pair(socket, std::move(request)));
+					data->WatchSocket(socket, B_EVENT_WRITE);
+				}
 
-			for (auto id: data->fCancelList) {
-				// To cancel, we set a special event status on the
-				// object_wait_info list so that we can handle it below.
-				// Also: the first item in the waitlist is always the semaphore
-				// so the fun starts at offset 1.
-				size_t offset = 0;
-				for (auto it = data->connectionMap.cbegin(); it != data->connectionMap.cend();
-					it++) {
-					offset++;
-					if (it->second.Id() == id) {
-						data->objectList[offset].events = EVENT_CANCELLED;
-						break;
+				auto cancelList = std::move(data->fCancelList);
+				data->fCancelList.clear();
+				data->fLock.Unlock();
+
+				for (auto id: cancelList) {
+					auto it = std::find_if(data->connectionMap.begin(), data->connectionMap.end(),
+						[id](const auto& item) { return item.second.Id() == id; });
+					if (it == data->connectionMap.end())
+						continue;
+
+					try {
+						throw BNetworkRequestError(
+							__PRETTY_FUNCTION__, BNetworkRequestError::Canceled);
+					} catch (...) {
+						it->second.SetError(std::current_exception());
 					}
+					data->FinishRequest(it, false);
 				}
+				continue;
 			}
-			data->fCancelList.clear();
-			data->fLock.Unlock();
-		} else if ((data->objectList[0].events & B_EVENT_INVALID) == B_EVENT_INVALID) {
-			// The semaphore has been deleted. Start the cleanup
-			break;
-		}
 
-		// Process all objects that are ready
-		bool resizeObjectList = false;
-		for (auto& item: data->objectList) {
-			if (item.type != B_OBJECT_TYPE_FD)
+			// The request may already have been finished, ie. when it was cancelled
+			auto it = data->connectionMap.find(event.object);
+			if (it == data->connectionMap.end())
 				continue;
-			if ((item.events & B_EVENT_WRITE) == B_EVENT_WRITE) {
-				auto& request = data->connectionMap.find(item.object)->second;
+			auto& request = it->second;
+
+			if ((event.events & B_EVENT_WRITE) == B_EVENT_WRITE
+				&& request.State() == Request::Connected) {
 				auto error = false;
 				try {
 					request.TransferRequest();
 				} catch (...) {
-					request.SetError(std::current_exception());
+					if (request.CanRetry()) {
+						// The server closed the reused connection; try again on a new one
+						auto lock = AutoLocker<BLocker>(data->fLock);
+						data->fControlQueue.emplace_back(request, Request::Retry());
+					} else
+						request.SetError(std::current_exception());
 					error = true;
 				}
 
 				// End failed writes
-				if (error) {
-					request.Disconnect();
-					data->connectionMap.erase(item.object);
-					release_sem(data->fControlQueueSem);
-						// wake up control thread; there may queued requests unblocked.
-					resizeObjectList = true;
-				}
-			} else if ((item.events & B_EVENT_READ) == B_EVENT_READ) {
-				auto& request = data->connectionMap.find(item.object)->second;
+				if (error)
+					data->FinishRequest(it, false);
+				else if (request.State() == Request::RequestSent)
+					data->WatchSocket(event.object, B_EVENT_READ);
+			} else if ((event.events & B_EVENT_READ) == B_EVENT_READ) {
 				auto finished = false;
 				try {
 					if (request.CanCancel())
@@ -448,50 +537,35 @@ BHttpSession::Impl::DataThreadFunc(void* arg)
 					// Move existing request into a new request and hand over to the control queue
 					auto lock = AutoLocker<BLocker>(data->fLock);
 					data->fControlQueue.emplace_back(request, r);
-					release_sem(data->fControlQueueSem);
-
+					finished = true;
+				} catch (const Request::Retry& retry) {
+					// The server closed the reused connection; try again on a new one
+					auto lock = AutoLocker<BLocker>(data->fLock);
+					data->fControlQueue.emplace_back(request, retry);
 					finished = true;
 				} catch (...) {
 					request.SetError(std::current_exception());
 					finished = true;
 				}
 
-				if (finished) {
-					// Clean up finished requests; including redirected requests
-					request.Disconnect();
-					data->connectionMap.erase(item.object);
-					release_sem(data->fControlQueueSem);
-						// wake up control thread; there may queued requests unblocked.
-					resizeObjectList = true;
-				}
-			} else if ((item.events & B_EVENT_DISCONNECTED) == B_EVENT_DISCONNECTED) {
-				auto& request = data->connectionMap.find(item.object)->second;
-				try {
-					throw BNetworkRequestError(
-						__PRETTY_FUNCTION__, BNetworkRequestError::NetworkError);
-				} catch (...) {
-					request.SetError(std::current_exception());
-				}
-				data->connectionMap.erase(item.object);
-				resizeObjectList = true;
-			} else if ((item.events & EVENT_CANCELLED) == EVENT_CANCELLED) {
-				auto& request = data->connectionMap.find(item.object)->second;
-				request.Disconnect();
-				try {
-					throw BNetworkRequestError(__PRETTY_FUNCTION__, BNetworkRequestError::Canceled);
-				} catch (...) {
-					request.SetError(std::current_exception());
+				// Clean up finished requests; including redirected requests
+				if (finished)
+					data->FinishRequest(it, request.CanReuseConnection());
+			} else if ((event.events & B_EVENT_DISCONNECTED) == B_EVENT_DISCONNECTED) {
+				if (request.CanRetry()) {
+					auto lock = AutoLocker<BLocker>(data->fLock);
+					data->fControlQueue.emplace_back(request, Request::Retry());
+				} else {
+					try {
+						throw BNetworkRequestError(
+							__PRETTY_FUNCTION__, BNetworkRequestError::NetworkError);
+					} catch (...) {
+						request.SetError(std::current_exception());
+					}
 				}
-				data->connectionMap.erase(item.object);
-				release_sem(data->fControlQueueSem);
-					// wake up control thread; there may queued requests unblocked.
-				resizeObjectList = true;
-			} else if (item.events == 0) {
-				// No events for this item, skip
-				continue;
-			} else {
-				// Likely to be B_EVENT_INVALID. This should not happen
-				auto& request = data->connectionMap.find(item.object)->second;
+				data->FinishRequest(it, false);
+			} else if ((event.events & B_EVENT_INVALID) == B_EVENT_INVALID) {
+				// This should not happen
 				request.SendMessage(UrlEvent::DebugMessage, [](BMessage& msg) {
 					msg.AddUInt32(UrlEventData::DebugType, UrlEventData::DebugError);
 					msg.AddString(UrlEventData::DebugMessage, "Unexpected event; socket deleted?");
@@ -501,23 +575,9 @@ BHttpSession::Impl::DataThreadFunc(void* arg)
 			}
 		}
 
-		// Reset objectList
-		data->objectList[0].events = B_EVENT_ACQUIRE_SEMAPHORE;
-		if (resizeObjectList)
-			data->objectList.resize(data->connectionMap.size() + 1);
-
-		auto i = 1;
-		for (auto it = data->connectionMap.cbegin(); it != data->connectionMap.cend(); it++) {
-			data->objectList[i].object = it->first;
-			if (it->second.State() == Request::InitialState)
-				throw BRuntimeError(__PRETTY_FUNCTION__, "Invalid state of request");
-			else if (it->second.State() == Request::Connected)
-				data->objectList[i].events = B_EVENT_WRITE | B_EVENT_DISCONNECTED;
-			else
-				data->objectList[i].events = B_EVENT_READ | B_EVENT_DISCONNECTED;
-			i++;
-		}
+		nextExpiry = data->ExpireIdleConnections();
 	}
+
 	// Clean up and make sure we are quitting
 	if (data->fQuitting.load()) {
 		// Cancel all requests
@@ -528,6 +588,7 @@ BHttpSession::Impl::DataThreadFunc(void* arg)
 				it->second.SetError(std::current_exception());
 			}
 		}
+		close(data->fEventQueue);
 	} else {
 		throw BRuntimeError(__PRETTY_FUNCTION__, "Unknown reason that the dataQueueSem is deleted");
 	}
@@ -598,6 +659,142 @@ BHttpSession::Impl::GetRequestsForControlThread()
 }
 
 
+/*!
+	\brief Take an idle connection for \a key out of the pool, if there is one that is still usable.
+
+	Connections that have been closed by the server in the mean time are discarded. A connection
+	that has data waiting is not in a state we can use either.
+
+	This method will do the locking of the internal structure.
+*/
+std::unique_ptr<BSocket>
+BHttpSession::Impl::TakeIdleConnection(const ConnectionKey& key)
+{
+	auto lock = AutoLocker<BLocker>(fLock);
+
+	auto it = fIdleConnections.find(key);
+	if (it == fIdleConnections.end())
+		return nullptr;
+
+	auto& connections = it->second;
+	std::unique_ptr<BSocket> socket;
+	while (!connections.empty() && !socket) {
+		// take the most recently used one, it is the least likely to have been closed
+		socket = std::move(connections.back().socket);
+		connections.pop_back();
+
+		char dummy;
+		if (recv(socket->Socket(), &dummy, 1, MSG_PEEK | MSG_DONTWAIT) >= 0
+			|| (errno != B_WOULD_BLOCK && errno != EAGAIN)) {
+			socket->Disconnect();
+			socket.reset();
+		}
+	}
+
+	if (connections.empty())
+		fIdleConnections.erase(it);
+
+	return socket;
+}
+
+
+/*!
+	\brief Keep the \a socket of a finished request alive, so that it can be reused for the next
+		request to the same host.
+
+	This method will do the locking of the internal structure.
+*/
+void
+BHttpSession::Impl::AddIdleConnection(const ConnectionKey& key, std::unique_ptr<BSocket> socket)
+{
+	auto lock = AutoLocker<BLocker>(fLock);
+
+	auto& connections = fIdleConnections[key];
+	if (connections.size() >= fMaxConnectionsPerHost.load(std::memory_order_relaxed)) {
+		connections.front().socket->Disconnect();
+		connections.pop_front();
+	}
+
+	connections.push_back({std::move(socket), system_time() + kIdleConnectionTimeout});
+}
+
+
+/*!
+	\brief Close the idle connections that have not been used for too long.
+
+	This method will do the locking of the internal structure.
+
+	\returns The time at which the next idle connection expires, or B_INFINITE_TIMEOUT if there
+		are no idle connections left.
+*/
+bigtime_t
+BHttpSession::Impl::ExpireIdleConnections()
+{
+	auto lock = AutoLocker<BLocker>(fLock);
+
+	bigtime_t now = system_time();
+	bigtime_t nextExpiry = B_INFINITE_TIMEOUT;
+
+	for (auto it = fIdleConnections.begin(); it != fIdleConnections.end();) {
+		auto& connections = it->second;
+		while (!connections.empty() && connections.front().expires <= now) {
+			connections.front().socket->Disconnect();
+			connections.pop_front();
+		}
+
+		if (connections.empty()) {
+			it = fIdleConnections.erase(it);
+			continue;
+		}
+
+		nextExpiry = std::min(nextExpiry, connections.front().expires);
+		it++;
+	}
+
+	return nextExpiry;
+}
+
+
+/*!
+	\brief Let the data thread wait for \a events on the \a socket, or stop waiting for events
+		on it when \a events is 0.
+*/
+void
+BHttpSession::Impl::WatchSocket(int socket, int32 events)
+{
+	if (events != 0)
+		events |= B_EVENT_LEVEL_TRIGGERED;
+
+	event_wait_info info = {socket, B_OBJECT_TYPE_FD, events, nullptr};
+	if (auto status = _kern_event_queue_select(fEventQueue, &info, 1);
+		status != B_OK && events != 0) {
+		throw BSystemError("_kern_event_queue_select()", info.events);
+	}
+}
+
+
+/*!
+	\brief Remove a request from the data thread; either close its connection, or keep it for
+		reuse if \a keepConnection is \c true.
+*/
+void
+BHttpSession::Impl::FinishRequest(
+	std::map<int, BHttpSession::Request>::iterator it, bool keepConnection)
+{
+	auto& request = it->second;
+	WatchSocket(it->first, 0);
+
+	if (keepConnection)
+		AddIdleConnection(request.GetConnectionKey(), request.ReleaseSocket());
+	else
+		request.Disconnect();
+
+	connectionMap.erase(it);
+	release_sem(fControlQueueSem);
+		// wake up control thread; there may queued requests unblocked.
+}
+
+
 // #pragma mark -- BHttpSession (public interface)
 
 
@@ -698,6 +895,30 @@ BHttpSession::Request::Request(Request& original, const BHttpSession::Redirect&
 }
 
 
+/*!
+	\brief Create a new request from an \a original one that failed on a reused connection.
+
+	The new request will always open a new connection.
+*/
+BHttpSession::Request::Request(Request& original, const BHttpSession::Request::Retry&)
+	:
+	fRequest(std::move(original.fRequest)),
+	fObserver(original.fObserver),
+	fResult(original.fResult),
+	fRetried(true),
+	fRemainingRedirects(original.fRemainingRedirects)
+{
+	if (fRequest.Method() == BHttpMethod::Head)
+		fParser.SetNoContent();
+
+	SendMessage(UrlEvent::DebugMessage, [](BMessage& msg) {
+		msg.AddUInt32(UrlEventData::DebugType, UrlEventData::DebugInfo);
+		msg.AddString(UrlEventData::DebugMessage,
+			"Reused connection was closed by the server; retrying on a new connection");
+	});
+}
+
+
 /*!
 	\brief Helper that sets the error in the result to \a e and notifies the listeners.
 */
@@ -737,19 +958,63 @@ BHttpSession::Request::SetCounter(int32* counter) noexcept
 
 
 /*!
-	\brief Resolve the hostname for a request
+	\brief Get the key under which the connection of this request can be shared.
 */
-void
-BHttpSession::Request::ResolveHostName()
+BHttpSession::Request::ConnectionKey
+BHttpSession::Request::GetConnectionKey() const
 {
+	bool secure = fRequest.Url().Protocol() == "https";
+
 	int port;
 	if (fRequest.Url().HasPort())
 		port = fRequest.Url().Port();
-	else if (fRequest.Url().Protocol() == "https")
+	else if (secure)
 		port = 443;
 	else
 		port = 80;
 
+	return {fRequest.Url().Host(), port, secure};
+}
+
+
+/*!
+	\brief Check if the connection can be used for another request after this one completed.
+
+	This is the case when the server did not ask to close the connection, and the response has
+	been read completely, without relying on the server closing the connection.
+*/
+bool
+BHttpSession::Request::CanReuseConnection() const noexcept
+{
+	return fKeepAlive && fRequestStatus == ContentReceived && fSocket
+		&& fBuffer.RemainingBytes() == 0;
+}
+
+
+/*!
+	\brief Check if the request can be sent again after its connection failed.
+
+	A server may close an idle connection at any time, even while we start to send a new request
+	on it. Following RFC 9112 section 9.3.1, only idempotent requests are retried automatically,
+	and only when no part of the response has been received yet.
+*/
+bool
+BHttpSession::Request::CanRetry() const noexcept
+{
+	return fReusedConnection && fParser.State() == HttpInputStreamState::StatusLine
+		&& fBuffer.RemainingBytes() == 0
+		&& (fRequest.Method() == BHttpMethod::Get || fRequest.Method() == BHttpMethod::Head);
+}
+
+
+/*!
+	\brief Resolve the hostname for a request
+*/
+void
+BHttpSession::Request::ResolveHostName()
+{
+	int port = std::get<1>(GetConnectionKey());
+
 	// TODO: proxy
 	if (auto status = fRemoteAddress.SetTo(fRequest.Url().Host(), port); status != B_OK) {
 		throw BNetworkRequestError(
@@ -798,6 +1063,31 @@ BHttpSession::Request::OpenConnection()
 }
 
 
+/*!
+	\brief Use the idle \a socket of an earlier request to the same host.
+
+	The observer is sent the same messages as for a new connection.
+*/
+void
+BHttpSession::Request::ReuseConnection(std::unique_ptr<BSocket> socket)
+{
+	fSocket = std::move(socket);
+	fSocket->SetTimeout(fRequest.Timeout());
+	fRemoteAddress = fSocket->Peer();
+	fReusedConnection = true;
+
+	SendMessage(UrlEvent::HostNameResolved,
+		[this](BMessage& msg) { msg.AddString(UrlEventData::HostName, fRequest.Url().Host()); });
+	SendMessage(UrlEvent::DebugMessage, [](BMessage& msg) {
+		msg.AddUInt32(UrlEventData::DebugType, UrlEventData::DebugInfo);
+		msg.AddString(UrlEventData::DebugMessage, "Reusing idle connection");
+	});
+	SendMessage(UrlEvent::ConnectionOpened);
+
+	fRequestStatus = Connected;
+}
+
+
 /*!
 	\brief Transfer data from the request to the socket.
 
@@ -844,6 +1134,13 @@ BHttpSession::Request::ReceiveResult()
 		return false;
 
 	auto readEnd = bytesRead == 0;
+	if (readEnd) {
+		// A server may close a connection we reused before it got our request
+		if (CanRetry())
+			throw Retry();
+
+		fKeepAlive = false;
+	}
 
 	// Parse the content in the buffer
 	switch (fParser.State()) {
@@ -858,6 +1155,9 @@ BHttpSession::Request::ReceiveResult()
 			if (fParser.ParseStatus(fBuffer, fStatus)) {
 				// the status headers are now received, decide what to do next
 
+				// HTTP/1.1 connections are persistent unless the server says otherwise
+				fKeepAlive = fStatus.text.StartsWith("HTTP/1.1 ");
+
 				// Determine if we can handle redirects; else notify of receiving status
 				if (fRemainingRedirects > 0) {
 					switch (fStatus.StatusCode()) {
@@ -884,6 +1184,8 @@ BHttpSession::Request::ReceiveResult()
 				if ((fStatus.StatusClass() == BHttpStatusClass::ClientError
 						|| fStatus.StatusClass() == BHttpStatusClass::ServerError)
 					&& fRequest.StopOnError()) {
+					// the body is not read, so the connection cannot be used again
+					fKeepAlive = false;
 					fRequestStatus = ContentReceived;
 					fResult->SetStatus(std::move(fStatus));
 					fResult->SetFields(BHttpFields());
@@ -925,6 +1227,15 @@ BHttpSession::Request::ReceiveResult()
 
 			// The headers have been received, now set up the rest of the response handling
 
+			if (auto connectionField = fFields.FindField("Connection"sv);
+				connectionField != fFields.end()) {
+				auto value = (*connectionField).Value();
+				if (value.size() == 5 && strncasecmp(value.data(), "close", 5) == 0)
+					fKeepAlive = false;
+				else if (value.size() == 10 && strncasecmp(value.data(), "keep-alive", 10) == 0)
+					fKeepAlive = true;
+			}
+
 			// Handle redirects
 			if (fMightRedirect) {
 				auto redirectToGet = false;
@@ -1041,7 +1352,8 @@ BHttpSession::Request::ReceiveResult()
 void
 BHttpSession::Request::Disconnect() noexcept
 {
-	fSocket->Disconnect();
+	if (fSocket)
+		fSocket->Disconnect();
 }
 
 
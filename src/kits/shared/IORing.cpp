@@ -0,0 +1,286 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <IORing.h>
+
+#include <string.h>
+#include <unistd.h>
+
+#include <syscalls.h>
+
+
+namespace BPrivate {
+
+
+IORing::IORing()
+	:
+	fFD(-1),
+	fFlags(0),
+	fHeader(NULL),
+	fSubmissions(NULL),
+	fCompletions(NULL),
+	fSubmissionCount(0),
+	fCompletionCount(0),
+	fSubmissionTail(0)
+{
+}
+
+
+IORing::~IORing()
+{
+	Unset();
+}
+
+
+/*!	Creates a ring with room for at least \a entries operations that have
+	been queued, but not yet picked up by the kernel.
+*/
+status_t
+IORing::Init(uint32 entries, uint32 flags)
+{
+	Unset();
+
+	void* address;
+	fFD = _kern_io_ring_create(entries, flags, &address);
+	if (fFD < 0)
+		return fFD;
+
+	fFlags = flags;
+	fHeader = (io_ring_header*)address;
+	if (fHeader->magic != IO_RING_MAGIC) {
+		Unset();
+		return B_BAD_DATA;
+	}
+
+	fSubmissionCount = fHeader->sq_entries;
+	fCompletionCount = fHeader->cq_entries;
+	fSubmissions = (io_ring_sqe*)((uint8*)address + fHeader->sq_offset);
+	fCompletions = (io_ring_cqe*)((uint8*)address + fHeader->cq_offset);
+	fSubmissionTail = fHeader->sq_tail;
+
+	return B_OK;
+}
+
+
+/*!	Closes the ring. Operations that have not been started are dropped, and
+	blocking ones are interrupted.
+*/
+void
+IORing::Unset()
+{
+	if (fFD >= 0)
+		close(fFD);
+
+	fFD = -1;
+	fHeader = NULL;
+	fSubmissions = NULL;
+	fCompletions = NULL;
+	fSubmissionCount = 0;
+	fCompletionCount = 0;
+	fSubmissionTail = 0;
+}
+
+
+status_t
+IORing::InitCheck() const
+{
+	return fFD >= 0 ? B_OK : fFD == -1 ? B_NO_INIT : fFD;
+}
+
+
+status_t
+IORing::Nop(uint64 userData)
+{
+	return _NextSubmission(IO_RING_OP_NOP, -1, userData) != NULL
+		? B_OK : B_WOULD_BLOCK;
+}
+
+
+/*!	Queues a read at \a offset, or at the current file position if it is
+	-1.
+*/
+status_t
+IORing::Read(int fd, void* buffer, size_t length, off_t offset,
+	uint64 userData)
+{
+	io_ring_sqe* submission = _NextSubmission(IO_RING_OP_READ, fd, userData);
+	if (submission == NULL)
+		return B_WOULD_BLOCK;
+
+	submission->offset = offset;
+	submission->address = (addr_t)buffer;
+	submission->length = length;
+	return B_OK;
+}
+
+
+status_t
+IORing::Write(int fd, const void* buffer, size_t length, off_t offset,
+	uint64 userData)
+{
+	io_ring_sqe* submission = _NextSubmission(IO_RING_OP_WRITE, fd, userData);
+	if (submission == NULL)
+		return B_WOULD_BLOCK;
+
+	submission->offset = offset;
+	submission->address = (addr_t)buffer;
+	submission->length = length;
+	return B_OK;
+}
+
+
+status_t
+IORing::Sync(int fd, uint64 userData)
+{
+	return _NextSubmission(IO_RING_OP_FSYNC, fd, userData) != NULL
+		? B_OK : B_WOULD_BLOCK;
+}
+
+
+status_t
+IORing::Send(int socket, const void* buffer, size_t length, int flags,
+	uint64 userData)
+{
+	io_ring_sqe* submission = _NextSubmission(IO_RING_OP_SEND, socket,
+		userData);
+	if (submission == NULL)
+		return B_WOULD_BLOCK;
+
+	submission->address = (addr_t)buffer;
+	submission->length = length;
+	submission->op_flags = flags;
+	return B_OK;
+}
+
+
+status_t
+IORing::Receive(int socket, void* buffer, size_t length, int flags,
+	uint64 userData)
+{
+	io_ring_sqe* submission = _NextSubmission(IO_RING_OP_RECV, socket,
+		userData);
+	if (submission == NULL)
+		return B_WOULD_BLOCK;
+
+	submission->address = (addr_t)buffer;
+	submission->length = length;
+	submission->op_flags = flags;
+	return B_OK;
+}
+
+
+status_t
+IORing::Accept(int socket, int flags, uint64 userData)
+{
+	io_ring_sqe* submission = _NextSubmission(IO_RING_OP_ACCEPT, socket,
+		userData);
+	if (submission == NULL)
+		return B_WOULD_BLOCK;
+
+	submission->op_flags = flags;
+	return B_OK;
+}
+
+
+/*!	Hands all queued operations to the kernel, and optionally waits until at
+	least \a waitForCompletions results are available.
+	Returns the number of operations the kernel took. In polling mode, this
+	only needs a syscall if the polling thread has to be woken up, or if it
+	should wait.
+*/
+ssize_t
+IORing::Submit(uint32 waitForCompletions, bigtime_t timeout)
+{
+	if (fHeader == NULL)
+		return B_NO_INIT;
+
+	// This has to be a full barrier, so that we see the polling thread's
+	// IO_RING_SQ_NEED_WAKEUP flag if it did not see the new tail.
+	atomic_get_and_set((int32*)&fHeader->sq_tail, fSubmissionTail);
+
+	uint32 toSubmit = fSubmissionTail
+		- (uint32)atomic_get((int32*)&fHeader->sq_head);
+
+	uint32 flags = 0;
+	if (waitForCompletions > 0)
+		flags |= IO_RING_ENTER_GET_EVENTS;
+
+	if ((fFlags & IO_RING_SQ_POLL) != 0) {
+		if ((atomic_get(&fHeader->flags) & IO_RING_SQ_NEED_WAKEUP) != 0)
+			flags |= IO_RING_ENTER_SQ_WAKEUP;
+		if (flags == 0)
+			return toSubmit;
+	}
+
+	return _kern_io_ring_enter(fFD, toSubmit, waitForCompletions, flags,
+		timeout);
+}
+
+
+/*!	Takes the next result without a syscall; returns \c false if there is
+	none yet.
+*/
+bool
+IORing::GetCompletion(io_ring_cqe& completion)
+{
+	if (fHeader == NULL)
+		return false;
+
+	uint32 head = fHeader->cq_head;
+	if (head == (uint32)atomic_get((int32*)&fHeader->cq_tail))
+		return false;
+
+	completion = fCompletions[head & (fCompletionCount - 1)];
+	atomic_set((int32*)&fHeader->cq_head, head + 1);
+	return true;
+}
+
+
+/*!	Waits for the next result. Returns \c B_ENTRY_NOT_FOUND if there is no
+	operation it could come from.
+*/
+status_t
+IORing::WaitForCompletion(io_ring_cqe& completion, bigtime_t timeout)
+{
+	while (!GetCompletion(completion)) {
+		ssize_t submitted = Submit(1, timeout);
+		if (submitted < 0)
+			return submitted;
+
+		// The kernel does not wait when there is nothing in flight; if it
+		// did not take new operations either, we would wait forever.
+		if (submitted == 0 && !GetCompletion(completion))
+			return B_ENTRY_NOT_FOUND;
+		if (submitted == 0)
+			break;
+	}
+
+	return B_OK;
+}
+
+
+io_ring_sqe*
+IORing::_NextSubmission(uint8 opcode, int fd, uint64 userData)
+{
+	if (fHeader == NULL || fSubmissionTail
+			- (uint32)atomic_get((int32*)&fHeader->sq_head)
+			>= fSubmissionCount) {
+		return NULL;
+	}
+
+	io_ring_sqe* submission
+		= &fSubmissions[fSubmissionTail & (fSubmissionCount - 1)];
+	memset(submission, 0, sizeof(io_ring_sqe));
+	submission->opcode = opcode;
+	submission->fd = fd;
+	submission->user_data = userData;
+
+	fSubmissionTail++;
+	return submission;
+}
+
+
+}	// namespace BPrivate
@@ -12,6 +12,11 @@
 #include <cstdlib>
 #include <ctype.h>
 #include <cerrno>
+#include <string.h>
+
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#endif
 
 #include <AutoDeleter.h>
 #include <DataIO.h>
@@ -100,7 +105,7 @@ public:
 		return result;
 	}
 
-	status_t AppendCharacters(char* str, size_t len)
+	status_t AppendCharacters(const char* str, size_t len)
 	{
 		status_t result = _EnsureAssemblyBufferAllocatedSize(fAssemblyBufferUsedSize + len);
 
@@ -183,7 +188,109 @@ private:
 };
 
 
-/*! This class carries state around the parsing process. */
+/*!	Input that is not already in memory is read in blocks of this size. */
+
+static const size_t kReadBufferSize = 16 * 1024;
+
+
+/*!	Returns the first character in the range that can not be copied verbatim
+	into a string; this is the closing quote, the start of an escape sequence,
+	or a control character.
+*/
+
+static inline const char*
+find_string_special_char(const char* start, const char* end)
+{
+#if defined(__SSE2__)
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i maxControl = _mm_set1_epi8(0x1f);
+
+	while (end - start >= 16) {
+		__m128i chunk = _mm_loadu_si128((const __m128i*)start);
+		__m128i special = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+				_mm_cmpeq_epi8(chunk, backslash)),
+			_mm_cmpeq_epi8(_mm_min_epu8(chunk, maxControl), chunk));
+
+		int mask = _mm_movemask_epi8(special);
+		if (mask != 0)
+			return start + __builtin_ctz(mask);
+
+		start += 16;
+	}
+#endif
+
+	while (start < end) {
+		uint8 c = static_cast<uint8>(*start);
+		if (c == '"' || c == '\\' || c < 0x20)
+			break;
+		start++;
+	}
+
+	return start;
+}
+
+
+/*!	Returns the first character in the range that is not whitespace, and
+	counts the line breaks it skips into \a lineNumber.
+*/
+
+static inline const char*
+skip_whitespace(const char* start, const char* end, uint32& lineNumber)
+{
+#if defined(__SSE2__)
+	const __m128i space = _mm_set1_epi8(' ');
+	const __m128i newline = _mm_set1_epi8(0x0a);
+	const __m128i carriageReturn = _mm_set1_epi8(0x0d);
+
+	while (end - start >= 16) {
+		__m128i chunk = _mm_loadu_si128((const __m128i*)start);
+		__m128i lineBreaks = _mm_or_si128(_mm_cmpeq_epi8(chunk, newline),
+			_mm_cmpeq_epi8(chunk, carriageReturn));
+
+		int whitespaceMask = _mm_movemask_epi8(
+			_mm_or_si128(lineBreaks, _mm_cmpeq_epi8(chunk, space)));
+		int lineBreakMask = _mm_movemask_epi8(lineBreaks);
+
+		if (whitespaceMask != 0xffff) {
+			int count = __builtin_ctz(~whitespaceMask);
+			lineNumber += __builtin_popcount(lineBreakMask & ((1 << count) - 1));
+			return start + count;
+		}
+
+		lineNumber += __builtin_popcount(lineBreakMask);
+		start += 16;
+	}
+#endif
+
+	while (start < end) {
+		switch (*start) {
+			case 0x0a: // newline
+			case 0x0d: // cr
+				lineNumber++;
+			case ' ': // space
+				break;
+
+			default:
+				return start;
+		}
+		start++;
+	}
+
+	return start;
+}
+
+
+/*! This class carries state around the parsing process.
+
+	The input is consumed through a window of characters. If the input is
+	already in memory (a BMallocIO, or a string), the window covers all of it.
+	Otherwise it is read in blocks into a buffer; as the parser stops at the
+	end of the first JSON value, it may have read beyond it. For a BPositionIO,
+	the position is moved back to just after the value when parsing is done,
+	other streams lose the data that was read ahead.
+*/
 
 class JsonParseContext {
 public:
@@ -191,29 +298,53 @@ public:
 		:
 		fListener(listener),
 		fData(data),
+		fMallocIO(dynamic_cast<BMallocIO*>(data)),
 		fLineNumber(1), // 1 is the first line
-		fPushbackChar(0),
-		fHasPushbackChar(false),
+		fReadBuffer(NULL),
+		fPosition(NULL),
+		fEnd(NULL),
 		fAssemblyBuffer(new JsonParseAssemblyBuffer())
 	{
+		if (fMallocIO != NULL) {
+			// The data is already in memory, and can be parsed directly
+			const char* buffer = static_cast<const char*>(fMallocIO->Buffer());
+			off_t position = fMallocIO->Position();
+			size_t length = fMallocIO->BufferLength();
+
+			if (buffer != NULL && position >= 0 && (size_t)position < length) {
+				fPosition = buffer + position;
+				fEnd = buffer + length;
+			}
+			fData = NULL;
+		}
 	}
 
 
-	~JsonParseContext()
+	JsonParseContext(const char* data, size_t length,
+		BJsonEventListener* listener)
+		:
+		fListener(listener),
+		fData(NULL),
+		fMallocIO(NULL),
+		fLineNumber(1),
+		fReadBuffer(NULL),
+		fPosition(data),
+		fEnd(data + length),
+		fAssemblyBuffer(new JsonParseAssemblyBuffer())
 	{
-		delete fAssemblyBuffer;
 	}
 
 
-	BJsonEventListener* Listener() const
+	~JsonParseContext()
 	{
-		return fListener;
+		delete fAssemblyBuffer;
+		free(fReadBuffer);
 	}
 
 
-	BDataIO* Data() const
+	BJsonEventListener* Listener() const
 	{
-		return fData;
+		return fListener;
 	}
 
 
@@ -228,23 +359,74 @@ public:
 		fLineNumber++;
 	}
 
+
 	status_t NextChar(char* buffer)
 	{
-		if (fHasPushbackChar) {
-			buffer[0] = fPushbackChar;
-			fHasPushbackChar = false;
-			return B_OK;
+		if (fPosition == fEnd) {
+			status_t result = _FillBuffer();
+			if (result != B_OK)
+				return result;
 		}
 
-		return Data()->ReadExactly(buffer, 1);
+		buffer[0] = *fPosition++;
+		return B_OK;
 	}
 
+
+	/*!	Returns the last character to the input; it must be the one the last
+		call to NextChar() returned.
+	*/
+
 	void PushbackChar(char c)
 	{
-		if (fHasPushbackChar)
-			debugger("illegal state - more than one character pushed back");
-		fPushbackChar = c;
-		fHasPushbackChar = true;
+		if (fPosition == NULL || fPosition[-1] != c)
+			debugger("illegal state - pushed back character was not read");
+		fPosition--;
+	}
+
+
+	/*!	Skips the whitespace at the current position without refilling the
+		buffer; the caller needs to handle whitespace anyway.
+	*/
+
+	void SkipWhitespace()
+	{
+		fPosition = skip_whitespace(fPosition, fEnd, fLineNumber);
+	}
+
+
+	/*!	Consumes the run of characters at the current position that can be
+		taken into a string as they are, and returns its length. The run may
+		be followed by more such characters if the buffer had to be refilled.
+	*/
+
+	size_t NextStringRun(const char** _run)
+	{
+		const char* run = fPosition;
+		fPosition = find_string_special_char(fPosition, fEnd);
+		*_run = run;
+		return fPosition - run;
+	}
+
+
+	/*!	Gives the data that was read beyond the parsed value back to the input,
+		if possible.
+	*/
+
+	void ReturnUnusedData()
+	{
+		if (fMallocIO != NULL) {
+			if (fPosition != NULL) {
+				fMallocIO->Seek(
+					fPosition - static_cast<const char*>(fMallocIO->Buffer()),
+					SEEK_SET);
+			}
+			return;
+		}
+
+		BPositionIO* positionIO = dynamic_cast<BPositionIO*>(fData);
+		if (positionIO != NULL && fPosition != fEnd)
+			positionIO->Seek(-(off_t)(fEnd - fPosition), SEEK_CUR);
 	}
 
 
@@ -254,12 +436,37 @@ public:
 	}
 
 
+private:
+	status_t _FillBuffer()
+	{
+		if (fData == NULL)
+			return B_PARTIAL_READ;
+
+		if (fReadBuffer == NULL) {
+			fReadBuffer = (char*)malloc(kReadBufferSize);
+			if (fReadBuffer == NULL)
+				return B_NO_MEMORY;
+		}
+
+		ssize_t bytesRead = fData->Read(fReadBuffer, kReadBufferSize);
+		if (bytesRead < 0)
+			return bytesRead;
+		if (bytesRead == 0)
+			return B_PARTIAL_READ;
+
+		fPosition = fReadBuffer;
+		fEnd = fReadBuffer + bytesRead;
+		return B_OK;
+	}
+
 private:
 	BJsonEventListener*		fListener;
 	BDataIO*				fData;
+	BMallocIO*				fMallocIO;
 	uint32					fLineNumber;
-	char					fPushbackChar;
-	bool					fHasPushbackChar;
+	char*					fReadBuffer;
+	const char*				fPosition;
+	const char*				fEnd;
 	JsonParseAssemblyBuffer*
 							fAssemblyBuffer;
 };
@@ -275,15 +482,14 @@ BJson::Parse(const BString& JSON, BMessage& message)
 status_t
 BJson::Parse(const char* JSON, size_t length, BMessage& message)
 {
-	BMemoryIO* input = new BMemoryIO(JSON, length);
-	ObjectDeleter<BMemoryIO> inputDeleter(input);
 	BJsonMessageWriter* writer = new BJsonMessageWriter(message);
 	ObjectDeleter<BJsonMessageWriter> writerDeleter(writer);
 
-	Parse(input, writer);
-	status_t result = writer->ErrorStatus();
+	JsonParseContext context(JSON, length, writer);
+	ParseAny(context);
+	writer->Complete();
 
-	return result;
+	return writer->ErrorStatus();
 }
 
 
@@ -309,6 +515,7 @@ BJson::Parse(BDataIO* data, BJsonEventListener* listener)
 {
 	JsonParseContext context(data, listener);
 	ParseAny(context);
+	context.ReturnUnusedData();
 	listener->Complete();
 }
 
@@ -346,6 +553,8 @@ bool
 BJson::NextNonWhitespaceChar(JsonParseContext& jsonParseContext, char* c)
 {
 	while (true) {
+		jsonParseContext.SkipWhitespace();
+
 		if (!NextChar(jsonParseContext, c))
 			return false;
 
@@ -718,6 +927,11 @@ BJson::ParseString(JsonParseContext& jsonParseContext,
 	JsonParseAssemblyBufferResetter assembleBufferResetter(assemblyBuffer);
 
 	while(true) {
+		const char* run;
+		size_t runLength = jsonParseContext.NextStringRun(&run);
+		if (runLength > 0)
+			assemblyBuffer->AppendCharacters(run, runLength);
+
 		if (!NextChar(jsonParseContext, &c))
     		return false;
 
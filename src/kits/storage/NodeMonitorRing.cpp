@@ -0,0 +1,254 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <NodeMonitorRing.h>
+
+#include <stddef.h>
+
+#include <Handler.h>
+#include <Message.h>
+
+#include <MessengerPrivate.h>
+
+#include <syscalls.h>
+
+
+static const uint32 kEventHeaderSize = offsetof(node_monitor_ring_event, names);
+
+
+namespace BPrivate {
+
+
+BNodeMonitorRing::BNodeMonitorRing()
+	:
+	fArea(B_NO_INIT),
+	fHeader(NULL),
+	fBuffer(NULL),
+	fSize(0)
+{
+}
+
+
+BNodeMonitorRing::~BNodeMonitorRing()
+{
+	Unset();
+}
+
+
+/*!	Sets up a ring of at least \a size bytes for \a target. Any previous
+	ring of the target is removed, and so is everything it was watching.
+*/
+status_t
+BNodeMonitorRing::SetTo(const BMessenger& target, size_t size)
+{
+	Unset();
+
+	if (!target.IsValid())
+		return B_BAD_VALUE;
+
+	fTarget = target;
+	BMessenger::Private messengerPrivate(fTarget);
+
+	void* address;
+	fArea = _kern_set_node_monitor_ring(messengerPrivate.Port(),
+		messengerPrivate.Token(), size, &address);
+	if (fArea < 0)
+		return fArea;
+
+	fHeader = (node_monitor_ring_header*)address;
+	fBuffer = (uint8*)address + B_PAGE_SIZE;
+	fSize = fHeader->size;
+
+	if (fHeader->magic != NODE_MONITOR_RING_MAGIC || fSize == 0
+		|| (fSize & (fSize - 1)) != 0) {
+		Unset();
+		return B_BAD_DATA;
+	}
+
+	return B_OK;
+}
+
+
+/*!	Removes the ring, and stops all watching of the target. */
+void
+BNodeMonitorRing::Unset()
+{
+	if (fArea >= 0) {
+		BMessenger::Private messengerPrivate(fTarget);
+		_kern_set_node_monitor_ring(messengerPrivate.Port(),
+			messengerPrivate.Token(), 0, NULL);
+	}
+
+	fArea = B_NO_INIT;
+	fHeader = NULL;
+	fBuffer = NULL;
+	fSize = 0;
+}
+
+
+status_t
+BNodeMonitorRing::InitCheck() const
+{
+	return fArea >= 0 ? B_OK : fArea;
+}
+
+
+/*!	Returns whether \a message is the kernel telling the target that there
+	are new events in the ring.
+*/
+bool
+BNodeMonitorRing::IsReadyMessage(const BMessage* message) const
+{
+	return message->what == B_NODE_MONITOR
+		&& message->GetInt32("opcode", 0) == B_NODE_MONITOR_RING_READY;
+}
+
+
+/*!	Takes the next event from the ring, and converts it to the message the
+	target would have received without the ring.
+	Returns \c B_ENTRY_NOT_FOUND if there are no more events; the kernel will
+	then notify the target again once there are.
+*/
+status_t
+BNodeMonitorRing::GetNextEvent(BMessage& message)
+{
+	if (fHeader == NULL)
+		return B_NO_INIT;
+
+	while (true) {
+		uint32 tail = fHeader->tail;
+		uint32 head = (uint32)atomic_get((int32*)&fHeader->head);
+		if (head == tail) {
+			// Ask the kernel for another notification, and look again, in
+			// case it added events before it saw the request.
+			if (atomic_get_and_set(&fHeader->wakeup_pending, 0) == 0)
+				return B_ENTRY_NOT_FOUND;
+			continue;
+		}
+
+		uint32 offset = tail & (fSize - 1);
+		node_monitor_ring_event* event
+			= (node_monitor_ring_event*)(fBuffer + offset);
+		uint32 size = event->size;
+		if (size < 8 || (size & 7) != 0 || size > fSize - offset
+			|| size > head - tail) {
+			return B_BAD_DATA;
+		}
+
+		if (event->opcode == B_NODE_MONITOR_RING_PADDING) {
+			atomic_set((int32*)&fHeader->tail, tail + size);
+			continue;
+		}
+
+		if (size < kEventHeaderSize
+			|| (uint32)event->name_length + event->from_name_length
+				> size - kEventHeaderSize) {
+			return B_BAD_DATA;
+		}
+
+		// from now on, the kernel will no longer change the event
+		int32 state = atomic_or(&event->state,
+			NODE_MONITOR_RING_EVENT_CONSUMED);
+		state &= ~NODE_MONITOR_RING_EVENT_CONSUMED;
+
+		const char* name = event->name_length > 0 ? event->names : NULL;
+		const char* fromName = event->from_name_length > 0
+			? event->names + event->name_length : NULL;
+		if ((name != NULL && name[event->name_length - 1] != '\0')
+			|| (fromName != NULL
+				&& fromName[event->from_name_length - 1] != '\0')) {
+			return B_BAD_DATA;
+		}
+
+		message.MakeEmpty();
+		message.what = B_NODE_MONITOR;
+		message.AddInt32("opcode", event->opcode);
+
+		switch (event->opcode) {
+			case B_ENTRY_CREATED:
+			case B_ENTRY_REMOVED:
+				message.AddInt32("device", event->device);
+				message.AddInt64("directory", event->directory);
+				message.AddInt64("node", event->node);
+				message.AddString("name", name != NULL ? name : "");
+				break;
+
+			case B_ENTRY_MOVED:
+				message.AddInt32("device", event->device);
+				message.AddInt64("from directory", event->directory);
+				message.AddInt64("to directory", event->to_directory);
+				message.AddInt32("node device", event->node_device);
+				message.AddInt64("node", event->node);
+				message.AddString("from name",
+					fromName != NULL ? fromName : "");
+				message.AddString("name", name != NULL ? name : "");
+				break;
+
+			case B_STAT_CHANGED:
+				message.AddInt32("device", event->device);
+				message.AddInt64("node", event->node);
+				message.AddInt32("fields", state);
+				break;
+
+			case B_ATTR_CHANGED:
+				message.AddInt32("device", event->device);
+				if (event->directory >= 0)
+					message.AddInt64("directory", event->directory);
+				message.AddInt64("node", event->node);
+				message.AddString("attr", name != NULL ? name : "");
+				message.AddInt32("cause", state);
+				break;
+
+			case B_DEVICE_MOUNTED:
+				message.AddInt32("new device", event->node_device);
+				message.AddInt32("device", event->device);
+				message.AddInt64("directory", event->directory);
+				break;
+
+			case B_DEVICE_UNMOUNTED:
+				message.AddInt32("device", event->device);
+				break;
+
+			case B_NODE_MONITOR_EVENTS_LOST:
+				message.AddInt32("count", state);
+				break;
+		}
+
+		atomic_set((int32*)&fHeader->tail, tail + size);
+		return B_OK;
+	}
+}
+
+
+/*!	Passes all pending events to \a handler, and returns their number. */
+int32
+BNodeMonitorRing::DispatchEvents(BHandler* handler)
+{
+	BMessage event;
+	int32 count = 0;
+	while (GetNextEvent(event) == B_OK) {
+		handler->MessageReceived(&event);
+		count++;
+	}
+
+	return count;
+}
+
+
+/*!	Returns the total number of events the kernel had to drop since the ring
+	was set up.
+*/
+uint32
+BNodeMonitorRing::LostEvents() const
+{
+	if (fHeader == NULL)
+		return 0;
+
+	return (uint32)atomic_get((int32*)&fHeader->lost_events);
+}
+
+
+}	// namespace BPrivate
@@ -0,0 +1,22 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <unistd.h>
+
+#include <errno.h>
+#include <pthread.h>
+
+#include <syscall_utils.h>
+#include <syscalls.h>
+
+
+ssize_t
+copy_file_range(int fromFD, off_t* fromOffset, int toFD, off_t* toOffset,
+	size_t length, unsigned int flags)
+{
+	RETURN_AND_SET_ERRNO_TEST_CANCEL(_kern_copy_file_range(fromFD, fromOffset,
+		toFD, toOffset, length, flags));
+}
@@ -0,0 +1,21 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <sys/sendfile.h>
+
+#include <errno.h>
+#include <pthread.h>
+
+#include <syscall_utils.h>
+#include <syscalls.h>
+
+
+ssize_t
+sendfile(int toFD, int fromFD, off_t* offset, size_t count)
+{
+	RETURN_AND_SET_ERRNO_TEST_CANCEL(_kern_sendfile(toFD, fromFD, offset,
+		count));
+}
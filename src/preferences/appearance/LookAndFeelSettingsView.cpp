@@ -60,6 +60,8 @@ static const int32 kMsgDoubleScrollBarArrows = 'dsba';
 static const int32 kMsgArrowStyleSingle = 'mass';
 static const int32 kMsgArrowStyleDouble = 'masd';
 
+static const int32 kMsgCompositing = 'cmps';
+
 static const bool kDefaultDoubleScrollBarArrowsSetting = false;
 
 
@@ -77,11 +79,13 @@ LookAndFeelSettingsView::LookAndFeelSettingsView(const char* name)
 	fControlLookMenu(NULL),
 	fArrowStyleSingle(NULL),
 	fArrowStyleDouble(NULL),
+	fCompositingCheckBox(NULL),
 	fSavedDecor(NULL),
 	fCurrentDecor(NULL),
 	fSavedControlLook(NULL),
 	fCurrentControlLook(NULL),
-	fSavedDoubleArrowsValue(_DoubleScrollBarArrows())
+	fSavedDoubleArrowsValue(_DoubleScrollBarArrows()),
+	fSavedCompositingValue(BPrivate::get_compositing())
 {
 	fCurrentDecor = fDecorUtility.CurrentDecorator()->ShortcutName();
 	fSavedDecor = fCurrentDecor;
@@ -138,6 +142,13 @@ LookAndFeelSettingsView::LookAndFeelSettingsView(const char* name)
 	scrollBarLabel->SetExplicitAlignment(
 		BAlignment(B_ALIGN_LEFT, B_ALIGN_TOP));
 
+	fCompositingCheckBox = new BCheckBox("compositing",
+		B_TRANSLATE("Keep the contents of covered windows"),
+		new BMessage(kMsgCompositing));
+	fCompositingCheckBox->SetToolTip(
+		B_TRANSLATE("Windows that become visible again don't need to redraw, "
+			"at the cost of some memory"));
+
 	// control layout
 	BLayoutBuilder::Grid<>(this, B_USE_DEFAULT_SPACING, B_USE_DEFAULT_SPACING)
 		.Add(fDecorMenuField->CreateLabelLayoutItem(), 0, 0)
@@ -148,7 +159,8 @@ LookAndFeelSettingsView::LookAndFeelSettingsView(const char* name)
 		.Add(fControlLookInfoButton, 2, 1)
 		.Add(scrollBarLabel, 0, 2)
 		.Add(arrowStyleBox, 1, 2)
-		.AddGlue(0, 3)
+		.Add(fCompositingCheckBox, 1, 3)
+		.AddGlue(0, 4)
 		.SetInsets(B_USE_WINDOW_SPACING);
 
 	// TODO : Decorator Preview Image?
@@ -174,11 +186,15 @@ LookAndFeelSettingsView::AttachedToWindow()
 	fControlLookInfoButton->SetTarget(this);
 	fArrowStyleSingle->SetTarget(this);
 	fArrowStyleDouble->SetTarget(this);
+	fCompositingCheckBox->SetTarget(this);
 
 	if (fSavedDoubleArrowsValue)
 		fArrowStyleDouble->SetValue(B_CONTROL_ON);
 	else
 		fArrowStyleSingle->SetValue(B_CONTROL_ON);
+
+	fCompositingCheckBox->SetValue(
+		fSavedCompositingValue ? B_CONTROL_ON : B_CONTROL_OFF);
 }
 
 
@@ -270,6 +286,10 @@ LookAndFeelSettingsView::MessageReceived(BMessage* message)
 			_SetDoubleScrollBarArrows(true);
 			break;
 
+		case kMsgCompositing:
+			_SetCompositing(fCompositingCheckBox->Value() == B_CONTROL_ON);
+			break;
+
 		default:
 			BView::MessageReceived(message);
 			break;
@@ -429,12 +449,26 @@ LookAndFeelSettingsView::_SetDoubleScrollBarArrows(bool doubleArrows)
 }
 
 
+void
+LookAndFeelSettingsView::_SetCompositing(bool compositing)
+{
+	if (BPrivate::get_compositing() != compositing)
+		BPrivate::set_compositing(compositing);
+
+	fCompositingCheckBox->SetValue(
+		compositing ? B_CONTROL_ON : B_CONTROL_OFF);
+
+	Window()->PostMessage(kMsgUpdate);
+}
+
+
 bool
 LookAndFeelSettingsView::IsDefaultable()
 {
 	return fCurrentDecor != fDecorUtility.DefaultDecorator()->ShortcutName()
 		|| fCurrentControlLook.Length() != 0
-		|| _DoubleScrollBarArrows() != false;
+		|| _DoubleScrollBarArrows() != false
+		|| fCompositingCheckBox->Value() != B_CONTROL_OFF;
 }
 
 
@@ -444,6 +478,7 @@ LookAndFeelSettingsView::SetDefaults()
 	_SetDecor(fDecorUtility.DefaultDecorator());
 	_SetControlLook(BString(""));
 	_SetDoubleScrollBarArrows(false);
+	_SetCompositing(false);
 }
 
 
@@ -452,7 +487,9 @@ LookAndFeelSettingsView::IsRevertable()
 {
 	return fCurrentDecor != fSavedDecor
 		|| fCurrentControlLook != fSavedControlLook
-		|| _DoubleScrollBarArrows() != fSavedDoubleArrowsValue;
+		|| _DoubleScrollBarArrows() != fSavedDoubleArrowsValue
+		|| (fCompositingCheckBox->Value() == B_CONTROL_ON)
+			!= fSavedCompositingValue;
 }
 
 
@@ -463,5 +500,6 @@ LookAndFeelSettingsView::Revert()
 		_SetDecor(fSavedDecor);
 		_SetControlLook(fSavedControlLook);
 		_SetDoubleScrollBarArrows(fSavedDoubleArrowsValue);
+		_SetCompositing(fSavedCompositingValue);
 	}
 }
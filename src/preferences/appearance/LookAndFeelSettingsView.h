@@ -50,6 +50,8 @@ private:
 			bool				_DoubleScrollBarArrows();
 			void				_SetDoubleScrollBarArrows(bool doubleArrows);
 
+			void				_SetCompositing(bool compositing);
+
 private:
 			DecorInfoUtility	fDecorUtility;
 
@@ -64,6 +66,8 @@ private:
 			FakeScrollBar*		fArrowStyleSingle;
 			FakeScrollBar*		fArrowStyleDouble;
 
+			BCheckBox*			fCompositingCheckBox;
+
 			BString				fSavedDecor;
 			BString				fCurrentDecor;
 
@@ -71,6 +75,7 @@ private:
 			BString				fCurrentControlLook;
 
 			bool				fSavedDoubleArrowsValue : 1;
+			bool				fSavedCompositingValue : 1;
 };
 
 
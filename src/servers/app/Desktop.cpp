@@ -47,6 +47,7 @@
 #include "DecorManager.h"
 #include "DesktopSettingsPrivate.h"
 #include "DrawingEngine.h"
+#include "FontCache.h"
 #include "GlobalFontManager.h"
 #include "HWInterface.h"
 #include "InputManager.h"
@@ -435,6 +436,8 @@ Desktop::Desktop(uid_t userID, const char* targetScreen)
 	fWorkspacesLock("workspaces list"),
 	fWindowLock("window lock"),
 
+	fClippingGeneration(0),
+
 	fMouseEventWindow(NULL),
 	fWindowUnderMouse(NULL),
 	fLockedFocusWindow(NULL),
@@ -2743,6 +2746,10 @@ Desktop::_DispatchMessage(int32 code, BPrivate::LinkReceiver& link)
 			break;
 		}
 
+		case AS_DUMP_FONT_CACHE:
+			FontCache::Default()->Dump();
+			break;
+
 		case AS_EVENT_STREAM_CLOSED:
 			_LaunchInputServer();
 			break;
@@ -3179,6 +3186,7 @@ Desktop::_HideWindow(Window* window)
 	// hidden windows are excluded from the
 	// clipping calculation, but anyways)
 	BRegion dirty(window->VisibleRegion());
+	window->SaveContents();
 
 	BRegion background;
 	_RebuildClippingForAllWindows(background);
@@ -3442,6 +3450,7 @@ Desktop::_RebuildClippingForAllWindows(BRegion& stillAvailableOnScreen)
 
 	// figure out what the entire screen area is
 	stillAvailableOnScreen = fScreenRegion;
+	fClippingGeneration++;
 
 	// set clipping of each window
 	for (Window* window = CurrentWindows().LastWindow(); window != NULL;
@@ -3515,6 +3524,7 @@ Desktop::RebuildAndRedrawAfterWindowChange(Window* changedWindow,
 
 	// figure out what the entire screen area is
 	BRegion stillAvailableOnScreen(fScreenRegion);
+	fClippingGeneration++;
 
 	// set clipping of each window
 	for (Window* window = CurrentWindows().LastWindow(); window != NULL;
@@ -3602,6 +3612,9 @@ Desktop::_ScreenChanged(Screen* screen)
 	fScreenRegion.Set(screen->Frame());
 	gInputManager->UpdateScreenBounds(screen->Frame());
 
+	// nothing that is on screen right now can be saved by the windows
+	fClippingGeneration++;
+
 	BRegion background;
 	_RebuildClippingForAllWindows(background);
 
@@ -3785,6 +3798,7 @@ Desktop::_SetWorkspace(int32 index, bool moveFocusWindow)
 		if (!window->IsHidden()) {
 			// this window will no longer be visible
 			dirty.Include(&window->VisibleRegion());
+			window->SaveContents();
 		}
 
 		window->SetCurrentWorkspace(-1);
@@ -250,6 +250,8 @@ public:
 
 			BRegion&			BackgroundRegion()
 									{ return fBackgroundRegion; }
+			uint32				ClippingGeneration() const
+									{ return fClippingGeneration; }
 
 			void				MinimizeApplication(team_id team);
 			void				BringApplicationToFront(team_id team);
@@ -370,6 +372,7 @@ private:
 
 			BRegion				fBackgroundRegion;
 			BRegion				fScreenRegion;
+			uint32				fClippingGeneration;
 
 			Window*				fMouseEventWindow;
 			const Window*		fWindowUnderMouse;
@@ -29,6 +29,7 @@
 #include "GlobalSubpixelSettings.h"
 #include "ServerConfig.h"
 #include "SystemPalette.h"
+#include "Window.h"
 
 
 DesktopSettingsPrivate::DesktopSettingsPrivate(server_read_only_memory* shared)
@@ -57,6 +58,7 @@ DesktopSettingsPrivate::_SetDefaults()
 	fFocusFollowsMouseMode = B_NORMAL_FOCUS_FOLLOWS_MOUSE;
 	fAcceptFirstClick = true;
 	fShowAllDraggers = true;
+	fCompositing = false;
 
 	// init scrollbar info
 	fScrollBarInfo.proportional = true;
@@ -306,6 +308,10 @@ DesktopSettingsPrivate::_Load()
 				fControlLook = controlLook;
 			}
 
+			bool compositing;
+			if (settings.FindBool("compositing", &compositing) == B_OK)
+				fCompositing = compositing;
+
 			// colors
 			for (int32 i = 0; i < kColorWhichCount; i++) {
 				char colorName[12];
@@ -456,6 +462,7 @@ DesktopSettingsPrivate::Save(uint32 mask)
 			settings.AddBool("subpixel ordering", gSubpixelOrderingRGB);
 
 			settings.AddString("control look", fControlLook);
+			settings.AddBool("compositing", fCompositing);
 
 			for (int32 i = 0; i < kColorWhichCount; i++) {
 				char colorName[12];
@@ -614,6 +621,21 @@ DesktopSettingsPrivate::ShowAllDraggers() const
 }
 
 
+void
+DesktopSettingsPrivate::SetCompositing(bool compositing)
+{
+	fCompositing = compositing;
+	Save(kAppearanceSettings);
+}
+
+
+bool
+DesktopSettingsPrivate::Compositing() const
+{
+	return fCompositing;
+}
+
+
 void
 DesktopSettingsPrivate::SetWorkspacesLayout(int32 columns, int32 rows)
 {
@@ -906,6 +928,13 @@ DesktopSettings::ShowAllDraggers() const
 }
 
 
+bool
+DesktopSettings::Compositing() const
+{
+	return fSettings->Compositing();
+}
+
+
 int32
 DesktopSettings::WorkspacesCount() const
 {
@@ -1063,6 +1092,20 @@ LockedDesktopSettings::SetShowAllDraggers(bool show)
 }
 
 
+void
+LockedDesktopSettings::SetCompositing(bool compositing)
+{
+	fSettings->SetCompositing(compositing);
+
+	if (!compositing) {
+		for (Window* window = fDesktop->AllWindows().FirstWindow();
+				window != NULL; window = window->NextWindow(kAllWindowList)) {
+			window->DiscardSavedContents();
+		}
+	}
+}
+
+
 void
 LockedDesktopSettings::SetUIColors(const BMessage& colors, bool* changed)
 {
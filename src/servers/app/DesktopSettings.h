@@ -64,6 +64,8 @@ public:
 
 			bool				ShowAllDraggers() const;
 
+			bool				Compositing() const;
+
 			int32				WorkspacesCount() const;
 			int32				WorkspacesColumns() const;
 			int32				WorkspacesRows() const;
@@ -102,6 +104,8 @@ public:
 
 			void				SetShowAllDraggers(bool show);
 
+			void				SetCompositing(bool compositing);
+
 			void				SetUIColors(const BMessage& colors,
 									bool* changed = NULL);
 
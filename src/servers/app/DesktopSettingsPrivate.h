@@ -65,6 +65,9 @@ public:
 			void				SetShowAllDraggers(bool show);
 			bool				ShowAllDraggers() const;
 
+			void				SetCompositing(bool compositing);
+			bool				Compositing() const;
+
 			void				SetWorkspacesLayout(int32 columns, int32 rows);
 			int32				WorkspacesCount() const;
 			int32				WorkspacesColumns() const;
@@ -116,6 +119,7 @@ private:
 			mode_focus_follows_mouse	fFocusFollowsMouseMode;
 			bool				fAcceptFirstClick;
 			bool				fShowAllDraggers;
+			bool				fCompositing;
 			int32				fWorkspacesColumns;
 			int32				fWorkspacesRows;
 			BMessage			fWorkspaceMessages[kMaxWorkspaces];
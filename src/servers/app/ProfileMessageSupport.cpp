@@ -320,6 +320,9 @@ string_for_message_code(uint32 code)
 		CODE(AS_DIRECT_WINDOW_GET_SYNC_DATA);
 		CODE(AS_DIRECT_WINDOW_SET_FULLSCREEN);
 
+		// link ring codes
+		CODE(AS_ATTACH_LINK_RING);
+
 		default:
 			return "unknown code";
 			break;
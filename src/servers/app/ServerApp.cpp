@@ -724,6 +724,36 @@ ServerApp::_DispatchMessage(int32 code, BPrivate::LinkReceiver& link)
 			break;
 		}
 
+		case AS_SET_COMPOSITING:
+		{
+			STRACE(("ServerApp %s: Set Compositing\n", Signature()));
+
+			bool compositing;
+			if (link.Read<bool>(&compositing) == B_OK) {
+				LockedDesktopSettings settings(fDesktop);
+				settings.SetCompositing(compositing);
+			}
+			break;
+		}
+
+		case AS_GET_COMPOSITING:
+		{
+			STRACE(("ServerApp %s: Get Compositing\n", Signature()));
+
+			if (fDesktop->LockSingleWindow()) {
+				DesktopSettings settings(fDesktop);
+
+				fLink.StartMessage(B_OK);
+				fLink.Attach<bool>(settings.Compositing());
+
+				fDesktop->UnlockSingleWindow();
+			} else
+				fLink.StartMessage(B_ERROR);
+
+			fLink.Flush();
+			break;
+		}
+
 		case AS_CREATE_BITMAP:
 		{
 			STRACE(("ServerApp %s: Received BBitmap creation request\n",
@@ -35,6 +35,7 @@
 #include <Autolock.h>
 #include <Debug.h>
 #include <DirectWindow.h>
+#include <LinkRing.h>
 #include <TokenSpace.h>
 #include <View.h>
 #include <GradientLinear.h>
@@ -80,6 +81,10 @@
 using std::nothrow;
 
 
+static const size_t kLinkRingSize = 128 * 1024;
+	// batches larger than half of it still go through the port
+
+
 //#define TRACE_SERVER_WINDOW
 #ifdef TRACE_SERVER_WINDOW
 #	include <stdio.h>
@@ -1106,6 +1111,31 @@ ServerWindow::_DispatchMessage(int32 code, BPrivate::LinkReceiver& link)
 			break;
 		}
 
+		case AS_ATTACH_LINK_RING:
+		{
+			// The client wants to send its messages through a shared ring
+			// from now on. We own the area, the client only clones it.
+			BPrivate::LinkRing* ring = NULL;
+			status_t status = B_OK;
+			if (link.Ring() == NULL) {
+				ring = new(std::nothrow) BPrivate::LinkRing;
+				if (ring == NULL)
+					status = B_NO_MEMORY;
+				else
+					status = ring->Create("link ring", kLinkRingSize);
+				if (status == B_OK)
+					link.SetRing(ring);
+				else
+					delete ring;
+			}
+
+			fLink.StartMessage(status);
+			if (status == B_OK)
+				fLink.Attach<area_id>(link.Ring()->Area());
+			fLink.Flush();
+			break;
+		}
+
 		// View creation and destruction (don't need a valid fCurrentView)
 
 		case AS_SET_CURRENT_VIEW:
@@ -2482,6 +2512,9 @@ void
 ServerWindow::_DispatchViewDrawingMessage(int32 code,
 	BPrivate::LinkReceiver &link)
 {
+	// even if nothing is drawn now, saved contents of the view are outdated
+	fWindow->ViewContentsChanged(fCurrentView);
+
 	if (!fCurrentView->IsVisible() || !fWindow->IsVisible()) {
 		if (link.NeedsReply()) {
 			debug_printf("ServerWindow::DispatchViewDrawingMessage() got "
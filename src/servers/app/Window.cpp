@@ -118,7 +118,13 @@ Window::Window(const BRect& frame, const char *name,
 	fMinHeight(1),
 	fMaxHeight(32768),
 
-	fWorkspacesViewCount(0)
+	fWorkspacesViewCount(0),
+
+	fSavedContentsSerial(0),
+	fLastChangedView(NULL),
+	fLastChangedSerial(0),
+	fClippingGeneration(0),
+	fClippingOrigin(B_ORIGIN)
 {
 	_InitWindowStack();
 
@@ -194,6 +200,16 @@ Window::SetClipping(BRegion* stillAvailableOnScreen)
 {
 	// this function is only called from the Desktop thread
 
+	// In compositing mode, remember what was visible before; the screen
+	// still shows it at the old location, unless the window was not part of
+	// the last clipping update.
+	BRegion* previouslyVisible = NULL;
+	if (_CanSaveContents()) {
+		if (fClippingGeneration + 1 == fDesktop->ClippingGeneration())
+			previouslyVisible = fRegionPool.GetRegion(fVisibleRegion);
+	} else if (fSavedContents.IsSet())
+		DiscardSavedContents();
+
 	// start from full region (as if the window was fully visible)
 	GetFullRegion(&fVisibleRegion);
 	// clip to region still available on screen
@@ -201,6 +217,24 @@ Window::SetClipping(BRegion* stillAvailableOnScreen)
 
 	fVisibleContentRegionValid = false;
 	fEffectiveDrawingRegionValid = false;
+
+	if (previouslyVisible != NULL) {
+		// save everything that is covered now
+		BRegion* visible = fRegionPool.GetRegion(VisibleContentRegion());
+		if (visible != NULL) {
+			previouslyVisible->OffsetBy((int32)-fClippingOrigin.x,
+				(int32)-fClippingOrigin.y);
+			visible->OffsetBy((int32)-fFrame.left, (int32)-fFrame.top);
+			previouslyVisible->Exclude(visible);
+
+			_SaveContents(*previouslyVisible, fClippingOrigin);
+			fRegionPool.Recycle(visible);
+		}
+		fRegionPool.Recycle(previouslyVisible);
+	}
+
+	fClippingGeneration = fDesktop->ClippingGeneration();
+	fClippingOrigin = fFrame.LeftTop();
 }
 
 
@@ -361,6 +395,11 @@ Window::ResizeBy(int32 x, int32 y, BRegion* dirtyRegion, bool resizeStack)
 	if (x == 0 && y == 0)
 		return;
 
+	// the saved contents no longer fit, and what is still on screen does
+	// not match the new size
+	DiscardSavedContents();
+	fClippingGeneration = 0;
+
 	fFrame.right += x;
 	fFrame.bottom += y;
 
@@ -444,6 +483,15 @@ Window::ScrollViewBy(View* view, int32 dx, int32 dy)
 	if (!dirty)
 		return;
 
+	if (fSavedContentsRegion.CountRects() > 0) {
+		// the covered parts of the view would move along as well
+		IntRect bounds(view->Bounds());
+		view->LocalToScreenTransform().Apply(&bounds);
+		dirty->Set((clipping_rect)bounds);
+		_ForgetSavedContents(*dirty);
+		dirty->MakeEmpty();
+	}
+
 	view->ScrollBy(dx, dy, dirty);
 
 //fDrawingEngine->FillRegion(*dirty, (rgb_color){ 255, 0, 255, 255 });
@@ -466,6 +514,15 @@ Window::CopyContents(BRegion* region, int32 xOffset, int32 yOffset)
 	if (!IsVisible())
 		return;
 
+	if (fSavedContentsRegion.CountRects() > 0) {
+		BRegion* destination = fRegionPool.GetRegion(*region);
+		if (destination != NULL) {
+			destination->OffsetBy(xOffset, yOffset);
+			_ForgetSavedContents(*destination);
+			fRegionPool.Recycle(destination);
+		}
+	}
+
 	BRegion* newDirty = fRegionPool.GetRegion(*region);
 
 	// clip the region to the visible contents at the
@@ -547,12 +604,71 @@ Window::CopyContents(BRegion* region, int32 xOffset, int32 yOffset)
 }
 
 
+/*!	Saves the currently visible contents of the window before it is hidden,
+	or leaves the current workspace. Like SetClipping(), this is only called
+	from the Desktop thread.
+*/
+void
+Window::SaveContents()
+{
+	if (fClippingGeneration != fDesktop->ClippingGeneration()
+		|| !_CanSaveContents())
+		return;
+
+	BRegion* visible = fRegionPool.GetRegion(VisibleContentRegion());
+	if (visible == NULL)
+		return;
+
+	visible->OffsetBy((int32)-fFrame.left, (int32)-fFrame.top);
+	_SaveContents(*visible, fFrame.LeftTop());
+
+	fRegionPool.Recycle(visible);
+}
+
+
+void
+Window::DiscardSavedContents()
+{
+	fSavedContents.Unset();
+	fSavedContentsRegion.MakeEmpty();
+	fSavedContentsSerial++;
+}
+
+
+/*!	Called for every drawing command of the client; the saved contents of
+	the view are outdated by it. Since clients usually draw a lot into the
+	same view, this only does something if either the view, its clipping, or
+	the saved contents changed since the last call.
+*/
+void
+Window::ViewContentsChanged(View* view)
+{
+	if (fSavedContentsRegion.CountRects() == 0)
+		return;
+
+	if (view == fLastChangedView && fLastChangedSerial == fSavedContentsSerial
+		&& view->IsScreenClippingValid())
+		return;
+
+	if (!fContentRegionValid)
+		_UpdateContentRegion();
+
+	_ForgetSavedContents(view->ScreenAndUserClipping(&fContentRegion));
+
+	fLastChangedView = view;
+	fLastChangedSerial = fSavedContentsSerial;
+}
+
+
 // #pragma mark -
 
 
 void
 Window::SetTopView(View* topView)
 {
+	DiscardSavedContents();
+	fLastChangedView = NULL;
+
 	if (fTopView.IsSet()) {
 		fTopView->DetachedFromWindow();
 	}
@@ -746,7 +862,24 @@ Window::ProcessDirtyRegion(const BRegion& dirtyRegion, const BRegion& exposeRegi
 	// have the read lock and the desktop thread
 	// is blocking to get the write lock. IAW, this
 	// is only executed in one thread.
-	if (fDirtyRegion.CountRects() == 0) {
+
+	// in compositing mode, parts that have been saved can be put back on
+	// screen right away, and do not need to be redrawn
+	const BRegion* dirty = &dirtyRegion;
+	const BRegion* expose = &exposeRegion;
+	BRegion* remainingDirty = NULL;
+	BRegion* remainingExpose = NULL;
+	if (fSavedContentsRegion.CountRects() > 0) {
+		remainingDirty = fRegionPool.GetRegion(dirtyRegion);
+		remainingExpose = fRegionPool.GetRegion(exposeRegion);
+		if (remainingDirty != NULL && remainingExpose != NULL) {
+			_RestoreContents(*remainingDirty, *remainingExpose);
+			dirty = remainingDirty;
+			expose = remainingExpose;
+		}
+	}
+
+	if (fDirtyRegion.CountRects() == 0 && dirty->CountRects() > 0) {
 		// the window needs to be informed
 		// when the dirty region was empty.
 		// NOTE: when the window thread has processed
@@ -760,8 +893,13 @@ Window::ProcessDirtyRegion(const BRegion& dirtyRegion, const BRegion& exposeRegi
 		ServerWindow()->RequestRedraw();
 	}
 
-	fDirtyRegion.Include(&dirtyRegion);
-	fExposeRegion.Include(&exposeRegion);
+	fDirtyRegion.Include(dirty);
+	fExposeRegion.Include(expose);
+
+	if (remainingDirty != NULL)
+		fRegionPool.Recycle(remainingDirty);
+	if (remainingExpose != NULL)
+		fRegionPool.Recycle(remainingExpose);
 }
 
 
@@ -820,6 +958,8 @@ Window::MarkContentDirty(BRegion& dirtyRegion, BRegion& exposeRegion)
 	// since this won't affect other windows, read locking
 	// is sufficient. If there was no dirty region before,
 	// an update message is triggered
+	_ForgetSavedContents(dirtyRegion);
+
 	if (fHidden || IsOffscreenWindow())
 		return;
 
@@ -833,6 +973,8 @@ void
 Window::MarkContentDirtyAsync(BRegion& dirtyRegion)
 {
 	// NOTE: see comments in ProcessDirtyRegion()
+	_ForgetSavedContents(dirtyRegion);
+
 	if (fHidden || IsOffscreenWindow())
 		return;
 
@@ -849,6 +991,17 @@ Window::MarkContentDirtyAsync(BRegion& dirtyRegion)
 void
 Window::InvalidateView(View* view, BRegion& viewRegion)
 {
+	if (view != NULL && fSavedContentsRegion.CountRects() > 0) {
+		// even if the window is hidden, the saved contents must not be
+		// used anymore
+		BRegion* region = fRegionPool.GetRegion(viewRegion);
+		if (region != NULL) {
+			view->LocalToScreenTransform().Apply(region);
+			_ForgetSavedContents(*region);
+			fRegionPool.Recycle(region);
+		}
+	}
+
 	if (view && IsVisible() && view->IsVisible()) {
 		if (!fContentRegionValid)
 			_UpdateContentRegion();
@@ -1269,6 +1422,8 @@ Window::GetDecoratorSettings(BMessage* settings)
 void
 Window::FontsChanged(BRegion* updateRegion)
 {
+	DiscardSavedContents();
+
 	::Decorator* decorator = Decorator();
 	if (decorator != NULL) {
 		DesktopSettings settings(fDesktop);
@@ -1280,6 +1435,8 @@ Window::FontsChanged(BRegion* updateRegion)
 void
 Window::ColorsChanged(BRegion* updateRegion)
 {
+	DiscardSavedContents();
+
 	::Decorator* decorator = Decorator();
 	if (decorator != NULL) {
 		DesktopSettings settings(fDesktop);
@@ -2013,6 +2170,146 @@ Window::_UpdateContentRegion()
 }
 
 
+/*!	Returns whether or not the window contents may be saved when they are
+	covered; this is only done in compositing mode, and for windows that
+	draw through the app_server.
+*/
+bool
+Window::_CanSaveContents()
+{
+	if (IsOffscreenWindow() || (fFlags & kWindowScreenFlag) != 0
+		|| fWindow->HasDirectFrameBufferAccess()
+		|| TopLayerStackWindow() != this)
+		return false;
+
+	return DesktopSettings(fDesktop).Compositing();
+}
+
+
+/*!	Reads \a region (in window coordinates) from the screen, where the
+	window was located at \a origin. Parts that are waiting for a redraw
+	anyway are left out.
+*/
+void
+Window::_SaveContents(const BRegion& region, BPoint origin)
+{
+	BRegion* save = fRegionPool.GetRegion(region);
+	BRegion* excluded = fRegionPool.GetRegion(fDirtyRegion);
+	if (save == NULL || excluded == NULL) {
+		if (save != NULL)
+			fRegionPool.Recycle(save);
+		if (excluded != NULL)
+			fRegionPool.Recycle(excluded);
+		return;
+	}
+
+	excluded->Include(&fExposeRegion);
+	if (fPendingUpdateSession->IsUsed())
+		excluded->Include(&fPendingUpdateSession->DirtyRegion());
+	if (fCurrentUpdateSession->IsUsed())
+		excluded->Include(&fCurrentUpdateSession->DirtyRegion());
+	excluded->OffsetBy((int32)-fFrame.left, (int32)-fFrame.top);
+	save->Exclude(excluded);
+
+	if (!fContentRegionValid)
+		_UpdateContentRegion();
+	*excluded = fContentRegion;
+	excluded->OffsetBy((int32)-fFrame.left, (int32)-fFrame.top);
+	save->IntersectWith(excluded);
+
+	if (save->CountRects() > 0 && !fSavedContents.IsSet()) {
+		fSavedContents.SetTo(new(std::nothrow) UtilityBitmap(
+			BRect(0, 0, fFrame.IntegerWidth(), fFrame.IntegerHeight()),
+			B_RGB32, 0), true);
+		if (fSavedContents.IsSet() && !fSavedContents->IsValid())
+			fSavedContents.Unset();
+	}
+
+	if (save->CountRects() > 0 && fSavedContents.IsSet()
+		&& fDrawingEngine->LockParallelAccess()) {
+		save->OffsetBy((int32)origin.x, (int32)origin.y);
+		status_t status = fDrawingEngine->CopyRegionToBitmap(*save,
+			fSavedContents.Get(), (int32)origin.x, (int32)origin.y);
+		fDrawingEngine->UnlockParallelAccess();
+
+		if (status == B_OK) {
+			save->OffsetBy((int32)-origin.x, (int32)-origin.y);
+			fSavedContentsRegion.Include(save);
+			fSavedContentsSerial++;
+		}
+	}
+
+	fRegionPool.Recycle(save);
+	fRegionPool.Recycle(excluded);
+}
+
+
+/*!	Puts everything of \a dirty that has been saved back onto the screen,
+	and removes it from both \a dirty and \a expose.
+*/
+void
+Window::_RestoreContents(BRegion& dirty, BRegion& expose)
+{
+	if (TopLayerStackWindow() != this) {
+		DiscardSavedContents();
+		return;
+	}
+
+	BRegion* restore = fRegionPool.GetRegion(fSavedContentsRegion);
+	if (restore == NULL)
+		return;
+
+	restore->OffsetBy((int32)fFrame.left, (int32)fFrame.top);
+	restore->IntersectWith(&dirty);
+	restore->IntersectWith(&VisibleContentRegion());
+
+	if (restore->CountRects() > 0 && fDrawingEngine->LockParallelAccess()) {
+		bool copyToFrontEnabled = fDrawingEngine->CopyToFrontEnabled();
+		fDrawingEngine->SetCopyToFrontEnabled(true);
+		status_t status = fDrawingEngine->CopyRegionFromBitmap(*restore,
+			fSavedContents.Get(), (int32)fFrame.left, (int32)fFrame.top);
+		fDrawingEngine->SetCopyToFrontEnabled(copyToFrontEnabled);
+		fDrawingEngine->UnlockParallelAccess();
+
+		if (status == B_OK) {
+			dirty.Exclude(restore);
+			expose.Exclude(restore);
+
+			// what is on screen is no longer saved
+			restore->OffsetBy((int32)-fFrame.left, (int32)-fFrame.top);
+			fSavedContentsRegion.Exclude(restore);
+			if (fSavedContentsRegion.CountRects() == 0)
+				fSavedContents.Unset();
+		}
+	}
+
+	fRegionPool.Recycle(restore);
+}
+
+
+//!	Drops the saved contents of \a screenRegion, as they are outdated.
+void
+Window::_ForgetSavedContents(const BRegion& screenRegion)
+{
+	if (fSavedContentsRegion.CountRects() == 0)
+		return;
+
+	BRegion* region = fRegionPool.GetRegion(screenRegion);
+	if (region == NULL) {
+		DiscardSavedContents();
+		return;
+	}
+
+	region->OffsetBy((int32)-fFrame.left, (int32)-fFrame.top);
+	fSavedContentsRegion.Exclude(region);
+	fRegionPool.Recycle(region);
+
+	// the window is completely uncovered, or everything saved is outdated
+	if (fSavedContentsRegion.CountRects() == 0)
+		fSavedContents.Unset();
+}
+
+
 void
 Window::_ObeySizeLimits()
 {
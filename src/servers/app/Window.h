@@ -17,6 +17,7 @@
 
 
 #include "RegionPool.h"
+#include "ServerBitmap.h"
 #include "ServerWindow.h"
 #include "View.h"
 #include "WindowList.h"
@@ -187,6 +188,11 @@ public:
 			void				CopyContents(BRegion* region,
 									int32 xOffset, int32 yOffset);
 
+			// saved contents in compositing mode
+			void				SaveContents();
+			void				DiscardSavedContents();
+			void				ViewContentsChanged(View* view);
+
 			void				MouseDown(BMessage* message, BPoint where,
 									const ClickTarget& lastClickTarget,
 									int32& clickCount,
@@ -335,6 +341,14 @@ protected:
 			void				_ObeySizeLimits();
 			void				_PropagatePosition();
 
+			bool				_CanSaveContents();
+			void				_SaveContents(const BRegion& region,
+									BPoint origin);
+			void				_RestoreContents(BRegion& dirty,
+									BRegion& expose);
+			void				_ForgetSavedContents(
+									const BRegion& screenRegion);
+
 			BString				fTitle;
 			// TODO: no fp rects anywhere
 			BRect				fFrame;
@@ -438,6 +452,21 @@ protected:
 
 			int32				fWorkspacesViewCount;
 
+			// In compositing mode, the parts of the window contents that are
+			// covered by other windows are kept here (in window coordinates),
+			// so that they can be put back on screen without a client redraw.
+			BReference<UtilityBitmap>
+								fSavedContents;
+			BRegion				fSavedContentsRegion;
+			uint32				fSavedContentsSerial;
+			View*				fLastChangedView;
+			uint32				fLastChangedSerial;
+
+			// the Desktop::ClippingGeneration() of the last SetClipping()
+			// call, and where the window was then
+			uint32				fClippingGeneration;
+			BPoint				fClippingOrigin;
+
 		friend class DecorManager;
 
 private:
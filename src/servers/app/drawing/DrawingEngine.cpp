@@ -1379,6 +1379,96 @@ DrawingEngine::ReadBitmap(ServerBitmap* bitmap, bool drawCursor, BRect bounds)
 }
 
 
+/*!	Copies the pixels of \a region (in screen coordinates) into \a bitmap,
+	where a screen pixel at (x, y) ends up at (x - xOffset, y - yOffset).
+	The region is expected to be clipped to the bitmap already.
+*/
+status_t
+DrawingEngine::CopyRegionToBitmap(const BRegion& region, ServerBitmap* bitmap,
+	int32 xOffset, int32 yOffset)
+{
+	ASSERT_PARALLEL_LOCKED();
+
+	RenderingBuffer* buffer = fGraphicsCard->DrawingBuffer();
+	if (buffer == NULL || bitmap->BitsLength() == 0)
+		return B_ERROR;
+
+	// TODO: assumes drawing buffer is 32 bits (which it currently always is)
+	BRegion clipped(BRect(0, 0, buffer->Width() - 1, buffer->Height() - 1));
+	clipped.IntersectWith(&region);
+
+	AutoFloatingOverlaysHider _(fGraphicsCard, clipped.Frame());
+
+	uint32 bytesPerRow = buffer->BytesPerRow();
+	uint32 bitmapBytesPerRow = bitmap->BytesPerRow();
+
+	int32 count = clipped.CountRects();
+	for (int32 i = 0; i < count; i++) {
+		clipping_rect rect = clipped.RectAtInt(i);
+		uint32 width = rect.right - rect.left + 1;
+
+		const uint8* src = (const uint8*)buffer->Bits()
+			+ (ssize_t)rect.top * bytesPerRow + (ssize_t)rect.left * 4;
+		uint8* dst = bitmap->Bits()
+			+ (ssize_t)(rect.top - yOffset) * bitmapBytesPerRow
+			+ (ssize_t)(rect.left - xOffset) * 4;
+
+		for (int32 y = rect.top; y <= rect.bottom; y++) {
+			memcpy(dst, src, width * 4);
+			src += bytesPerRow;
+			dst += bitmapBytesPerRow;
+		}
+	}
+
+	return B_OK;
+}
+
+
+/*!	The reverse of CopyRegionToBitmap(): puts the pixels of \a bitmap back
+	onto the screen.
+*/
+status_t
+DrawingEngine::CopyRegionFromBitmap(const BRegion& region,
+	ServerBitmap* bitmap, int32 xOffset, int32 yOffset)
+{
+	ASSERT_PARALLEL_LOCKED();
+
+	RenderingBuffer* buffer = fGraphicsCard->DrawingBuffer();
+	if (buffer == NULL || bitmap->BitsLength() == 0)
+		return B_ERROR;
+
+	BRegion clipped(BRect(0, 0, buffer->Width() - 1, buffer->Height() - 1));
+	clipped.IntersectWith(&region);
+
+	DrawTransaction transaction(this, clipped);
+	if (!transaction.IsDirty())
+		return B_OK;
+
+	uint32 bytesPerRow = buffer->BytesPerRow();
+	uint32 bitmapBytesPerRow = bitmap->BytesPerRow();
+
+	int32 count = clipped.CountRects();
+	for (int32 i = 0; i < count; i++) {
+		clipping_rect rect = clipped.RectAtInt(i);
+		uint32 width = rect.right - rect.left + 1;
+
+		const uint8* src = bitmap->Bits()
+			+ (ssize_t)(rect.top - yOffset) * bitmapBytesPerRow
+			+ (ssize_t)(rect.left - xOffset) * 4;
+		uint8* dst = (uint8*)buffer->Bits()
+			+ (ssize_t)rect.top * bytesPerRow + (ssize_t)rect.left * 4;
+
+		for (int32 y = rect.top; y <= rect.bottom; y++) {
+			memcpy(dst, src, width * 4);
+			src += bitmapBytesPerRow;
+			dst += bytesPerRow;
+		}
+	}
+
+	return B_OK;
+}
+
+
 // #pragma mark -
 
 
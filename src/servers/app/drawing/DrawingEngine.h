@@ -66,6 +66,14 @@ public:
 	virtual	status_t		ReadBitmap(ServerBitmap *bitmap, bool drawCursor,
 								BRect bounds);
 
+	// for saving and restoring window contents in compositing mode
+	virtual	status_t		CopyRegionToBitmap(const BRegion& region,
+								ServerBitmap* bitmap, int32 xOffset,
+								int32 yOffset);
+	virtual	status_t		CopyRegionFromBitmap(const BRegion& region,
+								ServerBitmap* bitmap, int32 xOffset,
+								int32 yOffset);
+
 	// clipping for all drawing functions, passing a NULL region
 	// will remove any clipping (drawing allowed everywhere)
 	virtual	void			ConstrainClippingRegion(const BRegion* region);
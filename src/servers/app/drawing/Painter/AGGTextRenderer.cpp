@@ -363,6 +363,44 @@ public:
 		return true;
 	}
 
+	void ConsumeRun(const GlyphRun* run, FontCacheEntry* entry)
+	{
+		double phaseX = fTransformOffset.x - floor(fTransformOffset.x);
+		double phaseY = fTransformOffset.y - floor(fTransformOffset.y);
+		if (!run->HasCoverage(phaseX, phaseY)) {
+			for (int32 i = 0; i < run->count; i++) {
+				const GlyphPlacement& placement = run->placements[i];
+				ConsumeGlyph(i, 0, placement.glyph, entry, placement.x,
+					placement.y, 0.0, 0.0);
+			}
+			return;
+		}
+
+		IntRect runBounds(run->bounds.x1, run->bounds.y1, run->bounds.x2,
+			run->bounds.y2);
+		if (!runBounds.IsValid())
+			return;
+
+		fBounds = fBounds | runBounds;
+		if (fDryRun)
+			return;
+
+		// the combined coverage of all glyphs is rendered in one go
+		runBounds.OffsetBy(fTransformOffset);
+		if (!fClippingFrame.Intersects(runBounds))
+			return;
+
+		fRenderer.fGray8Adaptor.init(run->coverage, run->coverage_size,
+			floor(fTransformOffset.x), floor(fTransformOffset.y));
+		if (fRenderer.fMaskedScanline != NULL) {
+			agg::render_scanlines(fRenderer.fGray8Adaptor,
+				*fRenderer.fMaskedScanline, fRenderer.fSolidRenderer);
+		} else {
+			agg::render_scanlines(fRenderer.fGray8Adaptor,
+				fRenderer.fGray8Scanline, fRenderer.fSolidRenderer);
+		}
+	}
+
 	IntRect Bounds() const
 	{
 		return fBounds;
@@ -420,6 +458,65 @@ AGGTextRenderer::RenderString(const char* string, uint32 length,
 		underscore, strikeout, transformedOutline, transformedContourOutline, transform,
 		transformOffset, nextCharPos, *this);
 
+	// Strings that are drawn over and over again are laid out only once,
+	// see GlyphRunCache
+	FontCacheReference localCacheReference;
+	if (cacheReference == NULL)
+		cacheReference = &localCacheReference;
+
+	if (cacheReference->Entry() == NULL
+		&& length <= GlyphRunCache::kMaxStringLength) {
+		FontCacheEntry* entry = GlyphLayoutEngine::FontCacheEntryFor(fFont,
+			renderer.NeedsVector());
+		if (entry != NULL) {
+			cacheReference->SetTo(entry);
+			cacheReference->ReadLock();
+		}
+	}
+
+	FontCacheEntry* entry = cacheReference->Entry();
+	if (entry != NULL && length <= GlyphRunCache::kMaxStringLength) {
+		GlyphRunKey key(string, length, delta, fFont.Spacing(), fFont.Size());
+		const GlyphRun* run = entry->RunCache().Lookup(key);
+		if (run != NULL) {
+			double phaseX = transformOffset.x - floor(transformOffset.x);
+			double phaseY = transformOffset.y - floor(transformOffset.y);
+			if (!dryRun && run->gray8_only
+				&& !run->HasCoverage(phaseX, phaseY)) {
+				// the lock is given up in between, so the run needs to be
+				// looked up again
+				if (cacheReference->WriteLock()) {
+					run = cacheReference->Entry()->RunCache().AddCoverage(key,
+						phaseX, phaseY);
+				} else
+					run = NULL;
+			}
+
+			if (run != NULL) {
+				renderer.Start();
+				renderer.ConsumeRun(run, cacheReference->Entry());
+				renderer.Finish(run->end_x, run->end_y);
+
+				return transform.TransformBounds(renderer.Bounds());
+			}
+		} else if (!dryRun && entry->RunCache().Admit(key)) {
+			GlyphRunBuilder<StringRenderer> builder(renderer);
+			if (GlyphLayoutEngine::LayoutGlyphs(builder, fFont, string, length,
+					INT32_MAX, delta, fFont.Spacing(), NULL, cacheReference)
+				&& builder.IsValid() && cacheReference->Entry() != NULL
+				&& cacheReference->WriteLock()) {
+				IntRect bounds = renderer.Bounds();
+				cacheReference->Entry()->RunCache().Insert(key,
+					builder.Placements(), builder.CountPlacements(),
+					agg::rect_i(bounds.left, bounds.top, bounds.right,
+						bounds.bottom),
+					builder.EndX(), builder.EndY());
+			}
+
+			return transform.TransformBounds(renderer.Bounds());
+		}
+	}
+
 	GlyphLayoutEngine::LayoutGlyphs(renderer, fFont, string, length, INT32_MAX,
 		delta, fFont.Spacing(), NULL, cacheReference);
 
@@ -60,6 +60,7 @@
 #include "RenderingBuffer.h"
 #include "ServerBitmap.h"
 #include "ServerFont.h"
+#include "SpanBlend.h"
 #include "SystemPalette.h"
 
 #include "AppServer.h"
@@ -106,9 +107,23 @@ using std::nothrow;
 #define fCurve					fInternal.fCurve
 
 
-static uint32 detect_simd();
+static uint32 init_simd();
 
-uint32 gSIMDFlags = detect_simd();
+uint32 gSIMDFlags = init_simd();
+
+
+#if __i386__ || __x86_64__
+/*!	Returns whether the OS saves the AVX register state on context switches.
+*/
+static bool
+avx_state_enabled()
+{
+	uint32 low;
+	uint32 high;
+	asm volatile("xgetbv" : "=a" (low), "=d" (high) : "c" (0));
+	return (low & 0x6) == 0x6;
+}
+#endif
 
 
 /*!	Detect SIMD flags for use in AppServer. Checks all CPUs in the system
@@ -117,7 +132,7 @@ uint32 gSIMDFlags = detect_simd();
 static uint32
 detect_simd()
 {
-#if __i386__
+#if __i386__ || __x86_64__
 	// Only scan CPUs for which we are certain the SIMD flags are properly
 	// defined.
 	const char* vendorNames[] = {
@@ -158,10 +173,23 @@ detect_simd()
 		if (vendorFound && maxStdFunc >= 1) {
 			get_cpuid(&cpuInfo, 1, 0);
 			uint32 edx = cpuInfo.regs.edx;
+			uint32 ecx = cpuInfo.regs.ecx;
 			if (edx & (1 << 23))
 				cpuSIMD |= APPSERVER_SIMD_MMX;
 			if (edx & (1 << 25))
 				cpuSIMD |= APPSERVER_SIMD_SSE;
+			if (edx & (1 << 26))
+				cpuSIMD |= APPSERVER_SIMD_SSE2;
+
+			// AVX2 needs OSXSAVE and AVX, and the OS must have enabled the
+			// extended register state.
+			const uint32 avxBits = (1 << 27) | (1 << 28);
+			if (maxStdFunc >= 7 && (ecx & avxBits) == avxBits
+				&& avx_state_enabled()) {
+				get_cpuid(&cpuInfo, 7, cpu);
+				if (cpuInfo.regs.ebx & (1 << 5))
+					cpuSIMD |= APPSERVER_SIMD_AVX2;
+			}
 		} else {
 			// no flags can be identified
 			cpuSIMD = 0;
@@ -169,12 +197,31 @@ detect_simd()
 		systemSIMD &= cpuSIMD;
 	}
 	return systemSIMD;
-#else	// !__i386__
+#else	// !__i386__ && !__x86_64__
 	return 0;
 #endif
 }
 
 
+/*!	Detects the SIMD flags and selects the matching span blending kernels
+	for the drawing modes.
+*/
+static uint32
+init_simd()
+{
+	uint32 flags = detect_simd();
+
+#if APPSERVER_SPAN_BLEND_SIMD
+	if ((flags & APPSERVER_SIMD_AVX2) != 0)
+		gSpanBlenders = &gAVX2SpanBlenders;
+	else if ((flags & APPSERVER_SIMD_SSE2) != 0)
+		gSpanBlenders = &gSSE2SpanBlenders;
+#endif
+
+	return flags;
+}
+
+
 // Gradients and strings don't use patterns, but we want the special handling
 // we have for solid patterns in certain modes to get the expected results for
 // border antialiasing.
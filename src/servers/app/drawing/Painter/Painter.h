@@ -46,6 +46,8 @@ class ServerFont;
 // Defines for SIMD support.
 #define APPSERVER_SIMD_MMX	(1 << 0)
 #define APPSERVER_SIMD_SSE	(1 << 1)
+#define APPSERVER_SIMD_SSE2	(1 << 2)
+#define APPSERVER_SIMD_AVX2	(1 << 3)
 
 
 class Painter {
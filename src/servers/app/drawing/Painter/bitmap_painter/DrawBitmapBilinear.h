@@ -598,10 +598,14 @@ struct DrawBitmapBilinear {
 
 		if (typeid(ColorType) == typeid(ColorTypeRgb)
 			&& typeid(DrawMode) == typeid(DrawModeCopy)) {
+#ifdef __i386__
+			// the assembler routine is only available on x86
 			uint32 neededSIMDFlags = APPSERVER_SIMD_MMX | APPSERVER_SIMD_SSE;
 			if ((gSIMDFlags & neededSIMDFlags) == neededSIMDFlags)
 				codeSelect = kUseSIMDVersion;
-			else {
+			else
+#endif
+			{
 				if (scaleX == scaleY && (scaleX == 1.5 || scaleX == 2.0
 					|| scaleX == 2.5 || scaleX == 3.0)) {
 					codeSelect = kOptimizeForLowFilterRatio;
@@ -33,20 +33,8 @@ blend_hline_alpha_co_solid(int x, int y, unsigned len,
 {
 	uint16 alpha = pattern->HighColor().alpha * cover;
 	if (alpha == 255 * 255) {
-		// cache the color as 32bit values
-		uint32 v;
-		uint8* p8 = (uint8*)&v;
-		p8[0] = c.b;
-		p8[1] = c.g;
-		p8[2] = c.r;
-		p8[3] = 255;
-		// row offset as 32bit pointer
 		uint32* p32 = (uint32*)(buffer->row_ptr(y)) + x;
-		do {
-			*p32 = v;
-			p32++;
-			x++;
-		} while(--len);
+		gSpanBlenders->fill(p32, span_pixel(c.r, c.g, c.b), len);
 	} else {
 		uint8* p = buffer->row_ptr(y) + (x << 2);
 		if (len < 4) {
@@ -69,20 +57,8 @@ blend_solid_hspan_alpha_co_solid(int x, int y, unsigned len,
 								 agg_buffer* buffer, const PatternHandler* pattern)
 {
 	uint8* p = buffer->row_ptr(y) + (x << 2);
-	uint8 hAlpha = pattern->HighColor().alpha;
-	do {
-		uint16 alpha = hAlpha * *covers;
-		if (alpha) {
-			if (alpha == 255 * 255) {
-				ASSIGN_ALPHA_CO(p, c.r, c.g, c.b);
-			} else {
-				BLEND_ALPHA_CO(p, c.r, c.g, c.b, alpha);
-			}
-		}
-		covers++;
-		p += 4;
-		x++;
-	} while(--len);
+	gSpanBlenders->blend16_covers(p, span_pixel(c.r, c.g, c.b),
+		pattern->HighColor().alpha, covers, len);
 }
 
 
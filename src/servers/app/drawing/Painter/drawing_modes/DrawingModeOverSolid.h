@@ -37,18 +37,8 @@ blend_hline_over_solid(int x, int y, unsigned len,
 		return;
 
 	if (cover == 255) {
-		uint32 v;
-		uint8* p8 = (uint8*)&v;
-		p8[0] = (uint8)c.b;
-		p8[1] = (uint8)c.g;
-		p8[2] = (uint8)c.r;
-		p8[3] = 255;
 		uint32* p32 = (uint32*)(buffer->row_ptr(y)) + x;
-		do {
-			*p32 = v;
-			p32++;
-			x++;
-		} while(--len);
+		gSpanBlenders->fill(p32, span_pixel(c.r, c.g, c.b), len);
 	} else {
 		uint8* p = buffer->row_ptr(y) + (x << 2);
 		do {
@@ -69,18 +59,7 @@ blend_solid_hspan_over_solid(int x, int y, unsigned len,
 		return;
 
 	uint8* p = buffer->row_ptr(y) + (x << 2);
-	do {
-		if (*covers) {
-			if (*covers == 255) {
-				ASSIGN_OVER(p, c.r, c.g, c.b);
-			} else {
-				BLEND_OVER(p, c.r, c.g, c.b, *covers);
-			}
-		}
-		covers++;
-		p += 4;
-		x++;
-	} while(--len);
+	gSpanBlenders->blend_covers(p, span_pixel(c.r, c.g, c.b), covers, len);
 }
 
 // blend_solid_vspan_over_solid
@@ -23,17 +23,8 @@ blend_solid_hspan_over_solid_subpix(int x, int y, unsigned len,
 		return;
 
 	uint8* p = buffer->row_ptr(y) + (x << 2);
-	const int subpixelL = gSubpixelOrderingRGB ? 2 : 0;
-	const int subpixelM = 1;
-	const int subpixelR = gSubpixelOrderingRGB ? 0 : 2;
-	do {
-		BLEND_OVER_SUBPIX(p, c.r, c.g, c.b,
-			covers[subpixelL], covers[subpixelM], covers[subpixelR]);
-		covers += 3;
-		p += 4;
-		x++;
-		len -= 3;
-	} while (len);
+	gSpanBlenders->blend_covers_subpix(p, span_pixel(c.r, c.g, c.b), covers,
+		len / 3, gSubpixelOrderingRGB);
 }
 
 #endif // DRAWING_MODE_OVER_SUBPIX_H
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ *
+ * Scalar span kernels. They are built from the same macros as the drawing
+ * modes and serve as the reference for the SIMD versions.
+ *
+ */
+
+#include "SpanBlend.h"
+
+#include "DrawingMode.h"
+
+
+// scalar_fill
+static void
+scalar_fill(uint32* dst, uint32 color, unsigned len)
+{
+	while (len--)
+		*dst++ = color;
+}
+
+// scalar_blend_covers
+static void
+scalar_blend_covers(uint8* dst, uint32 color, const uint8* covers,
+	unsigned len)
+{
+	const uint8* c = (const uint8*)&color;
+	while (len--) {
+		if (*covers) {
+			if (*covers == 255)
+				*(uint32*)dst = color;
+			else
+				BLEND(dst, c[2], c[1], c[0], *covers);
+		}
+		covers++;
+		dst += 4;
+	}
+}
+
+// scalar_blend_covers_subpix
+static void
+scalar_blend_covers_subpix(uint8* dst, uint32 color, const uint8* covers,
+	unsigned len, bool rgbOrder)
+{
+	const uint8* c = (const uint8*)&color;
+	const int subpixelL = rgbOrder ? 2 : 0;
+	const int subpixelR = rgbOrder ? 0 : 2;
+	while (len--) {
+		BLEND_SUBPIX(dst, c[2], c[1], c[0], covers[subpixelL], covers[1],
+			covers[subpixelR]);
+		covers += 3;
+		dst += 4;
+	}
+}
+
+// scalar_blend16_covers
+static void
+scalar_blend16_covers(uint8* dst, uint32 color, uint8 alpha,
+	const uint8* covers, unsigned len)
+{
+	const uint8* c = (const uint8*)&color;
+	while (len--) {
+		uint16 a = alpha * *covers;
+		if (a) {
+			if (a == 255 * 255)
+				*(uint32*)dst = color;
+			else
+				BLEND16(dst, c[2], c[1], c[0], a);
+		}
+		covers++;
+		dst += 4;
+	}
+}
+
+// scalar_blend16_colors
+static void
+scalar_blend16_colors(uint8* dst, const agg::rgba8* colors,
+	const uint8* covers, unsigned len)
+{
+	while (len--) {
+		uint16 a = colors->a * *covers;
+		if (a) {
+			if (a == 255 * 255) {
+				*(uint32*)dst = span_pixel(colors->r, colors->g, colors->b);
+			} else
+				BLEND16(dst, colors->r, colors->g, colors->b, a);
+		}
+		covers++;
+		colors++;
+		dst += 4;
+	}
+}
+
+// scalar_average_covers
+static void
+scalar_average_covers(uint8* dst, uint32 color, const uint8* covers,
+	unsigned len)
+{
+	const uint8* c = (const uint8*)&color;
+	while (len--) {
+		if (*covers) {
+			uint8 b = (dst[0] + c[0]) >> 1;
+			uint8 g = (dst[1] + c[1]) >> 1;
+			uint8 r = (dst[2] + c[2]) >> 1;
+			if (*covers == 255) {
+				dst[0] = b;
+				dst[1] = g;
+				dst[2] = r;
+				dst[3] = 255;
+			} else
+				BLEND(dst, r, g, b, *covers);
+		}
+		covers++;
+		dst += 4;
+	}
+}
+
+
+const span_blenders gScalarSpanBlenders = {
+	"scalar",
+	scalar_fill,
+	scalar_blend_covers,
+	scalar_blend_covers_subpix,
+	scalar_blend16_covers,
+	scalar_blend16_colors,
+	scalar_average_covers
+};
+
+const span_blenders* gSpanBlenders = &gScalarSpanBlenders;
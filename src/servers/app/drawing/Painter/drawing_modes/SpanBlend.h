@@ -0,0 +1,78 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ *
+ * Span kernels for the most common B_RGBA32 drawing modes. The drawing mode
+ * functions hand whole spans to these kernels instead of going through the
+ * per-pixel macros. The kernel set is chosen at runtime depending on the
+ * SIMD capabilities of the CPUs, all sets produce bit-identical results.
+ *
+ */
+
+#ifndef SPAN_BLEND_H
+#define SPAN_BLEND_H
+
+#include <SupportDefs.h>
+
+#include <agg_color_rgba.h>
+
+
+struct span_blenders {
+	const char*	name;
+
+	// Writes color to every pixel of the span.
+	void		(*fill)(uint32* dst, uint32 color, unsigned len);
+
+	// BLEND() of color with one cover per pixel. A cover of 0 leaves the
+	// pixel untouched, a cover of 255 assigns the color.
+	void		(*blend_covers)(uint8* dst, uint32 color,
+					const uint8* covers, unsigned len);
+
+	// BLEND_SUBPIX() of color with three covers per pixel. The first cover
+	// of each triplet applies to blue, unless rgbOrder is set, in which case
+	// it applies to red.
+	void		(*blend_covers_subpix)(uint8* dst, uint32 color,
+					const uint8* covers, unsigned len, bool rgbOrder);
+
+	// BLEND16() of color with alpha * cover, as used by B_OP_ALPHA with a
+	// solid pattern. A product of 0 leaves the pixel untouched, a product
+	// of 255 * 255 assigns the color.
+	void		(*blend16_covers)(uint8* dst, uint32 color, uint8 alpha,
+					const uint8* covers, unsigned len);
+
+	// BLEND16() of each colors[i] with colors[i].a * covers[i], as used by
+	// B_OP_ALPHA in B_PIXEL_ALPHA mode.
+	void		(*blend16_colors)(uint8* dst, const agg::rgba8* colors,
+					const uint8* covers, unsigned len);
+
+	// B_OP_BLEND of color with one cover per pixel: the color is averaged
+	// with the destination, which is then BLEND()ed like in blend_covers.
+	void		(*average_covers)(uint8* dst, uint32 color,
+					const uint8* covers, unsigned len);
+};
+
+
+// Packs a color into a B_RGBA32 pixel with full opacity.
+static inline uint32
+span_pixel(uint8 r, uint8 g, uint8 b)
+{
+	uint32 pixel;
+	uint8* p8 = (uint8*)&pixel;
+	p8[0] = b;
+	p8[1] = g;
+	p8[2] = r;
+	p8[3] = 255;
+	return pixel;
+}
+
+
+extern const span_blenders gScalarSpanBlenders;
+#if APPSERVER_SPAN_BLEND_SIMD
+extern const span_blenders gSSE2SpanBlenders;
+extern const span_blenders gAVX2SpanBlenders;
+#endif
+
+extern const span_blenders* gSpanBlenders;
+
+
+#endif // SPAN_BLEND_H
@@ -0,0 +1,296 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ *
+ * AVX2 span kernels, processing eight pixels per iteration. They mirror the
+ * SSE2 kernels in SpanBlendSSE2.cpp; all unpack and pack operations work
+ * within 128 bit lanes, so pixels never cross lanes.
+ *
+ */
+
+#include "SpanBlend.h"
+
+#include <string.h>
+
+#include <immintrin.h>
+
+
+static const uint32 kAlphaMask = 0xff000000;
+
+
+// load_covers
+//! Returns eight covers with each cover repeated for all bytes of its pixel.
+static inline __m256i
+load_covers(const uint8* covers, uint64& packed)
+{
+	memcpy(&packed, covers, 8);
+	__m256i c = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)covers));
+	return _mm256_mullo_epi32(c, _mm256_set1_epi32(0x01010101));
+}
+
+// assign_alpha
+static inline __m256i
+assign_alpha(__m256i a)
+{
+	return _mm256_add_epi16(a,
+		_mm256_srli_epi16(_mm256_add_epi16(a, _mm256_set1_epi16(1)), 8));
+}
+
+// blend8
+static inline __m256i
+blend8(__m256i s, __m256i d, __m256i a)
+{
+	__m256i inverse = _mm256_sub_epi16(_mm256_set1_epi16(256), a);
+	return _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(s, a),
+		_mm256_mullo_epi16(d, inverse)), 8);
+}
+
+// blend16
+static inline __m256i
+blend16(__m256i s, __m256i d, __m256i a)
+{
+	__m256i inverse = _mm256_sub_epi16(_mm256_setzero_si256(), a);
+	__m256i saLow = _mm256_mullo_epi16(s, a);
+	__m256i saHigh = _mm256_mulhi_epu16(s, a);
+	__m256i dbLow = _mm256_mullo_epi16(d, inverse);
+	__m256i dbHigh = _mm256_mulhi_epu16(d, inverse);
+	__m256i sum0 = _mm256_add_epi32(_mm256_unpacklo_epi16(saLow, saHigh),
+		_mm256_unpacklo_epi16(dbLow, dbHigh));
+	__m256i sum1 = _mm256_add_epi32(_mm256_unpackhi_epi16(saLow, saHigh),
+		_mm256_unpackhi_epi16(dbLow, dbHigh));
+	return _mm256_packs_epi32(_mm256_srli_epi32(sum0, 16),
+		_mm256_srli_epi32(sum1, 16));
+}
+
+// select
+static inline __m256i
+select(__m256i mask, __m256i a, __m256i b)
+{
+	return _mm256_blendv_epi8(b, a, mask);
+}
+
+// swap_red_blue
+static inline __m256i
+swap_red_blue(__m256i v)
+{
+	return _mm256_shufflehi_epi16(
+		_mm256_shufflelo_epi16(v, _MM_SHUFFLE(3, 0, 1, 2)),
+		_MM_SHUFFLE(3, 0, 1, 2));
+}
+
+// broadcast_alpha
+static inline __m256i
+broadcast_alpha(__m256i v)
+{
+	return _mm256_shufflehi_epi16(
+		_mm256_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3)),
+		_MM_SHUFFLE(3, 3, 3, 3));
+}
+
+
+// #pragma mark -
+
+
+// avx2_fill
+static void
+avx2_fill(uint32* dst, uint32 color, unsigned len)
+{
+	__m256i c = _mm256_set1_epi32(color);
+	for (; len >= 8; len -= 8, dst += 8)
+		_mm256_storeu_si256((__m256i*)dst, c);
+	gScalarSpanBlenders.fill(dst, color, len);
+}
+
+// avx2_blend_covers
+static void
+avx2_blend_covers(uint8* dst, uint32 color, const uint8* covers,
+	unsigned len)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i alphaMask = _mm256_set1_epi32(kAlphaMask);
+	const __m256i c = _mm256_set1_epi32(color);
+	const __m256i s = _mm256_unpacklo_epi8(c, zero);
+
+	for (; len >= 8; len -= 8, dst += 32, covers += 8) {
+		uint64 packed;
+		__m256i cov = load_covers(covers, packed);
+		if (packed == 0)
+			continue;
+		if (packed == ~(uint64)0) {
+			_mm256_storeu_si256((__m256i*)dst, c);
+			continue;
+		}
+
+		__m256i d = _mm256_loadu_si256((const __m256i*)dst);
+		__m256i low = blend8(s, _mm256_unpacklo_epi8(d, zero),
+			assign_alpha(_mm256_unpacklo_epi8(cov, zero)));
+		__m256i high = blend8(s, _mm256_unpackhi_epi8(d, zero),
+			assign_alpha(_mm256_unpackhi_epi8(cov, zero)));
+		__m256i result = _mm256_or_si256(_mm256_packus_epi16(low, high),
+			alphaMask);
+
+		_mm256_storeu_si256((__m256i*)dst,
+			select(_mm256_cmpeq_epi8(cov, zero), d, result));
+	}
+	gScalarSpanBlenders.blend_covers(dst, color, covers, len);
+}
+
+// avx2_blend_covers_subpix
+static void
+avx2_blend_covers_subpix(uint8* dst, uint32 color, const uint8* covers,
+	unsigned len, bool rgbOrder)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i alphaMask = _mm256_set1_epi32(kAlphaMask);
+	const __m256i s = _mm256_unpacklo_epi8(_mm256_set1_epi32(color), zero);
+	const int subpixelL = rgbOrder ? 2 : 0;
+	const int subpixelR = rgbOrder ? 0 : 2;
+
+	for (; len >= 8; len -= 8, dst += 32, covers += 24) {
+		uint32 packed[8];
+		for (int i = 0; i < 8; i++) {
+			const uint8* triplet = covers + i * 3;
+			packed[i] = triplet[subpixelL] | (triplet[1] << 8)
+				| (triplet[subpixelR] << 16);
+		}
+		__m256i cov = _mm256_loadu_si256((const __m256i*)packed);
+
+		__m256i d = _mm256_loadu_si256((const __m256i*)dst);
+		__m256i low = blend8(s, _mm256_unpacklo_epi8(d, zero),
+			_mm256_unpacklo_epi8(cov, zero));
+		__m256i high = blend8(s, _mm256_unpackhi_epi8(d, zero),
+			_mm256_unpackhi_epi8(cov, zero));
+
+		_mm256_storeu_si256((__m256i*)dst,
+			_mm256_or_si256(_mm256_packus_epi16(low, high), alphaMask));
+	}
+	gScalarSpanBlenders.blend_covers_subpix(dst, color, covers, len,
+		rgbOrder);
+}
+
+// avx2_blend16_covers
+static void
+avx2_blend16_covers(uint8* dst, uint32 color, uint8 alpha,
+	const uint8* covers, unsigned len)
+{
+	if (alpha == 0)
+		return;
+
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i alphaMask = _mm256_set1_epi32(kAlphaMask);
+	const __m256i opaque = _mm256_set1_epi16((short)(255 * 255));
+	const __m256i alpha16 = _mm256_set1_epi16(alpha);
+	const __m256i c = _mm256_set1_epi32(color);
+	const __m256i s = _mm256_unpacklo_epi8(c, zero);
+
+	for (; len >= 8; len -= 8, dst += 32, covers += 8) {
+		uint64 packed;
+		__m256i cov = load_covers(covers, packed);
+		if (packed == 0)
+			continue;
+
+		__m256i aLow = _mm256_mullo_epi16(_mm256_unpacklo_epi8(cov, zero),
+			alpha16);
+		__m256i aHigh = _mm256_mullo_epi16(_mm256_unpackhi_epi8(cov, zero),
+			alpha16);
+		__m256i assign = _mm256_packs_epi16(
+			_mm256_cmpeq_epi16(aLow, opaque),
+			_mm256_cmpeq_epi16(aHigh, opaque));
+
+		__m256i d = _mm256_loadu_si256((const __m256i*)dst);
+		__m256i low = blend16(s, _mm256_unpacklo_epi8(d, zero), aLow);
+		__m256i high = blend16(s, _mm256_unpackhi_epi8(d, zero), aHigh);
+		__m256i result = _mm256_or_si256(_mm256_packus_epi16(low, high),
+			alphaMask);
+		result = select(assign, c, result);
+
+		_mm256_storeu_si256((__m256i*)dst,
+			select(_mm256_cmpeq_epi8(cov, zero), d, result));
+	}
+	gScalarSpanBlenders.blend16_covers(dst, color, alpha, covers, len);
+}
+
+// avx2_blend16_colors
+static void
+avx2_blend16_colors(uint8* dst, const agg::rgba8* colors,
+	const uint8* covers, unsigned len)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i alphaMask = _mm256_set1_epi32(kAlphaMask);
+	const __m256i opaque = _mm256_set1_epi16((short)(255 * 255));
+
+	for (; len >= 8; len -= 8, dst += 32, covers += 8, colors += 8) {
+		uint64 packed;
+		__m256i cov = load_covers(covers, packed);
+		if (packed == 0)
+			continue;
+
+		__m256i rgba = _mm256_loadu_si256((const __m256i*)colors);
+		__m256i sLow = swap_red_blue(_mm256_unpacklo_epi8(rgba, zero));
+		__m256i sHigh = swap_red_blue(_mm256_unpackhi_epi8(rgba, zero));
+
+		__m256i aLow = _mm256_mullo_epi16(broadcast_alpha(sLow),
+			_mm256_unpacklo_epi8(cov, zero));
+		__m256i aHigh = _mm256_mullo_epi16(broadcast_alpha(sHigh),
+			_mm256_unpackhi_epi8(cov, zero));
+
+		__m256i assign = _mm256_packs_epi16(
+			_mm256_cmpeq_epi16(aLow, opaque),
+			_mm256_cmpeq_epi16(aHigh, opaque));
+		__m256i skip = _mm256_packs_epi16(_mm256_cmpeq_epi16(aLow, zero),
+			_mm256_cmpeq_epi16(aHigh, zero));
+
+		__m256i d = _mm256_loadu_si256((const __m256i*)dst);
+		__m256i low = blend16(sLow, _mm256_unpacklo_epi8(d, zero), aLow);
+		__m256i high = blend16(sHigh, _mm256_unpackhi_epi8(d, zero), aHigh);
+		__m256i result = _mm256_or_si256(_mm256_packus_epi16(low, high),
+			alphaMask);
+		result = select(assign, _mm256_or_si256(
+			_mm256_packus_epi16(sLow, sHigh), alphaMask), result);
+
+		_mm256_storeu_si256((__m256i*)dst, select(skip, d, result));
+	}
+	gScalarSpanBlenders.blend16_colors(dst, colors, covers, len);
+}
+
+// avx2_average_covers
+static void
+avx2_average_covers(uint8* dst, uint32 color, const uint8* covers,
+	unsigned len)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i alphaMask = _mm256_set1_epi32(kAlphaMask);
+	const __m256i s = _mm256_unpacklo_epi8(_mm256_set1_epi32(color), zero);
+
+	for (; len >= 8; len -= 8, dst += 32, covers += 8) {
+		uint64 packed;
+		__m256i cov = load_covers(covers, packed);
+		if (packed == 0)
+			continue;
+
+		__m256i d = _mm256_loadu_si256((const __m256i*)dst);
+		__m256i dLow = _mm256_unpacklo_epi8(d, zero);
+		__m256i dHigh = _mm256_unpackhi_epi8(d, zero);
+		__m256i low = blend8(_mm256_srli_epi16(_mm256_add_epi16(dLow, s), 1),
+			dLow, assign_alpha(_mm256_unpacklo_epi8(cov, zero)));
+		__m256i high = blend8(_mm256_srli_epi16(_mm256_add_epi16(dHigh, s),
+			1), dHigh, assign_alpha(_mm256_unpackhi_epi8(cov, zero)));
+		__m256i result = _mm256_or_si256(_mm256_packus_epi16(low, high),
+			alphaMask);
+
+		_mm256_storeu_si256((__m256i*)dst,
+			select(_mm256_cmpeq_epi8(cov, zero), d, result));
+	}
+	gScalarSpanBlenders.average_covers(dst, color, covers, len);
+}
+
+
+const span_blenders gAVX2SpanBlenders = {
+	"avx2",
+	avx2_fill,
+	avx2_blend_covers,
+	avx2_blend_covers_subpix,
+	avx2_blend16_covers,
+	avx2_blend16_colors,
+	avx2_average_covers
+};
@@ -0,0 +1,295 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ *
+ * SSE2 span kernels, processing four pixels per iteration. Remaining pixels
+ * are handed to the scalar kernels. The arithmetic is rearranged so that it
+ * fits into unsigned 16 bit lanes, but is otherwise identical to the BLEND()
+ * and BLEND16() macros:
+ *
+ *	((s - d) * a + (d << 8)) >> 8   ==  (s * a + d * (256 - a)) >> 8
+ *	((s - d) * a + (d << 16)) >> 16 ==  (s * a + d * (65536 - a)) >> 16
+ *
+ */
+
+#include "SpanBlend.h"
+
+#include <string.h>
+
+#include <emmintrin.h>
+
+
+static const uint32 kAlphaMask = 0xff000000;
+
+
+// load_covers
+//! Returns four covers with each cover repeated for all bytes of its pixel.
+static inline __m128i
+load_covers(const uint8* covers, uint32& packed)
+{
+	memcpy(&packed, covers, 4);
+	__m128i c = _mm_cvtsi32_si128(packed);
+	c = _mm_unpacklo_epi8(c, c);
+	return _mm_unpacklo_epi16(c, c);
+}
+
+// assign_alpha
+//! Turns a cover of 255 into 256, so that blend8() yields the source.
+static inline __m128i
+assign_alpha(__m128i a)
+{
+	return _mm_add_epi16(a,
+		_mm_srli_epi16(_mm_add_epi16(a, _mm_set1_epi16(1)), 8));
+}
+
+// blend8
+static inline __m128i
+blend8(__m128i s, __m128i d, __m128i a)
+{
+	__m128i inverse = _mm_sub_epi16(_mm_set1_epi16(256), a);
+	return _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(s, a),
+		_mm_mullo_epi16(d, inverse)), 8);
+}
+
+// blend16
+static inline __m128i
+blend16(__m128i s, __m128i d, __m128i a)
+{
+	// 65536 - a, lanes with a == 0 are masked out by the callers
+	__m128i inverse = _mm_sub_epi16(_mm_setzero_si128(), a);
+	__m128i saLow = _mm_mullo_epi16(s, a);
+	__m128i saHigh = _mm_mulhi_epu16(s, a);
+	__m128i dbLow = _mm_mullo_epi16(d, inverse);
+	__m128i dbHigh = _mm_mulhi_epu16(d, inverse);
+	__m128i sum0 = _mm_add_epi32(_mm_unpacklo_epi16(saLow, saHigh),
+		_mm_unpacklo_epi16(dbLow, dbHigh));
+	__m128i sum1 = _mm_add_epi32(_mm_unpackhi_epi16(saLow, saHigh),
+		_mm_unpackhi_epi16(dbLow, dbHigh));
+	return _mm_packs_epi32(_mm_srli_epi32(sum0, 16),
+		_mm_srli_epi32(sum1, 16));
+}
+
+// select
+//! Returns a where mask is set, b otherwise.
+static inline __m128i
+select(__m128i mask, __m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+
+// #pragma mark -
+
+
+// sse2_fill
+static void
+sse2_fill(uint32* dst, uint32 color, unsigned len)
+{
+	__m128i c = _mm_set1_epi32(color);
+	for (; len >= 4; len -= 4, dst += 4)
+		_mm_storeu_si128((__m128i*)dst, c);
+	gScalarSpanBlenders.fill(dst, color, len);
+}
+
+// sse2_blend_covers
+static void
+sse2_blend_covers(uint8* dst, uint32 color, const uint8* covers,
+	unsigned len)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alphaMask = _mm_set1_epi32(kAlphaMask);
+	const __m128i c = _mm_set1_epi32(color);
+	const __m128i s = _mm_unpacklo_epi8(c, zero);
+
+	for (; len >= 4; len -= 4, dst += 16, covers += 4) {
+		uint32 packed;
+		__m128i cov = load_covers(covers, packed);
+		if (packed == 0)
+			continue;
+		if (packed == 0xffffffff) {
+			_mm_storeu_si128((__m128i*)dst, c);
+			continue;
+		}
+
+		__m128i d = _mm_loadu_si128((const __m128i*)dst);
+		__m128i low = blend8(s, _mm_unpacklo_epi8(d, zero),
+			assign_alpha(_mm_unpacklo_epi8(cov, zero)));
+		__m128i high = blend8(s, _mm_unpackhi_epi8(d, zero),
+			assign_alpha(_mm_unpackhi_epi8(cov, zero)));
+		__m128i result = _mm_or_si128(_mm_packus_epi16(low, high),
+			alphaMask);
+
+		_mm_storeu_si128((__m128i*)dst,
+			select(_mm_cmpeq_epi8(cov, zero), d, result));
+	}
+	gScalarSpanBlenders.blend_covers(dst, color, covers, len);
+}
+
+// sse2_blend_covers_subpix
+static void
+sse2_blend_covers_subpix(uint8* dst, uint32 color, const uint8* covers,
+	unsigned len, bool rgbOrder)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alphaMask = _mm_set1_epi32(kAlphaMask);
+	const __m128i s = _mm_unpacklo_epi8(_mm_set1_epi32(color), zero);
+	const int subpixelL = rgbOrder ? 2 : 0;
+	const int subpixelR = rgbOrder ? 0 : 2;
+
+	for (; len >= 4; len -= 4, dst += 16, covers += 12) {
+		uint32 packed[4];
+		for (int i = 0; i < 4; i++) {
+			const uint8* triplet = covers + i * 3;
+			packed[i] = triplet[subpixelL] | (triplet[1] << 8)
+				| (triplet[subpixelR] << 16);
+		}
+		__m128i cov = _mm_loadu_si128((const __m128i*)packed);
+
+		__m128i d = _mm_loadu_si128((const __m128i*)dst);
+		__m128i low = blend8(s, _mm_unpacklo_epi8(d, zero),
+			_mm_unpacklo_epi8(cov, zero));
+		__m128i high = blend8(s, _mm_unpackhi_epi8(d, zero),
+			_mm_unpackhi_epi8(cov, zero));
+
+		_mm_storeu_si128((__m128i*)dst,
+			_mm_or_si128(_mm_packus_epi16(low, high), alphaMask));
+	}
+	gScalarSpanBlenders.blend_covers_subpix(dst, color, covers, len,
+		rgbOrder);
+}
+
+// sse2_blend16_covers
+static void
+sse2_blend16_covers(uint8* dst, uint32 color, uint8 alpha,
+	const uint8* covers, unsigned len)
+{
+	if (alpha == 0)
+		return;
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alphaMask = _mm_set1_epi32(kAlphaMask);
+	const __m128i opaque = _mm_set1_epi16((short)(255 * 255));
+	const __m128i alpha16 = _mm_set1_epi16(alpha);
+	const __m128i c = _mm_set1_epi32(color);
+	const __m128i s = _mm_unpacklo_epi8(c, zero);
+
+	for (; len >= 4; len -= 4, dst += 16, covers += 4) {
+		uint32 packed;
+		__m128i cov = load_covers(covers, packed);
+		if (packed == 0)
+			continue;
+
+		__m128i aLow = _mm_mullo_epi16(_mm_unpacklo_epi8(cov, zero),
+			alpha16);
+		__m128i aHigh = _mm_mullo_epi16(_mm_unpackhi_epi8(cov, zero),
+			alpha16);
+		__m128i assign = _mm_packs_epi16(_mm_cmpeq_epi16(aLow, opaque),
+			_mm_cmpeq_epi16(aHigh, opaque));
+
+		__m128i d = _mm_loadu_si128((const __m128i*)dst);
+		__m128i low = blend16(s, _mm_unpacklo_epi8(d, zero), aLow);
+		__m128i high = blend16(s, _mm_unpackhi_epi8(d, zero), aHigh);
+		__m128i result = _mm_or_si128(_mm_packus_epi16(low, high),
+			alphaMask);
+		result = select(assign, c, result);
+
+		_mm_storeu_si128((__m128i*)dst,
+			select(_mm_cmpeq_epi8(cov, zero), d, result));
+	}
+	gScalarSpanBlenders.blend16_covers(dst, color, alpha, covers, len);
+}
+
+// sse2_blend16_colors
+static void
+sse2_blend16_colors(uint8* dst, const agg::rgba8* colors,
+	const uint8* covers, unsigned len)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alphaMask = _mm_set1_epi32(kAlphaMask);
+	const __m128i opaque = _mm_set1_epi16((short)(255 * 255));
+
+	for (; len >= 4; len -= 4, dst += 16, covers += 4, colors += 4) {
+		uint32 packed;
+		__m128i cov = load_covers(covers, packed);
+		if (packed == 0)
+			continue;
+
+		// agg::rgba8 is stored as RGBA, swap red and blue to get BGRA
+		__m128i rgba = _mm_loadu_si128((const __m128i*)colors);
+		__m128i sLow = _mm_unpacklo_epi8(rgba, zero);
+		__m128i sHigh = _mm_unpackhi_epi8(rgba, zero);
+		sLow = _mm_shufflehi_epi16(
+			_mm_shufflelo_epi16(sLow, _MM_SHUFFLE(3, 0, 1, 2)),
+			_MM_SHUFFLE(3, 0, 1, 2));
+		sHigh = _mm_shufflehi_epi16(
+			_mm_shufflelo_epi16(sHigh, _MM_SHUFFLE(3, 0, 1, 2)),
+			_MM_SHUFFLE(3, 0, 1, 2));
+
+		__m128i aLow = _mm_shufflehi_epi16(
+			_mm_shufflelo_epi16(sLow, _MM_SHUFFLE(3, 3, 3, 3)),
+			_MM_SHUFFLE(3, 3, 3, 3));
+		__m128i aHigh = _mm_shufflehi_epi16(
+			_mm_shufflelo_epi16(sHigh, _MM_SHUFFLE(3, 3, 3, 3)),
+			_MM_SHUFFLE(3, 3, 3, 3));
+		aLow = _mm_mullo_epi16(aLow, _mm_unpacklo_epi8(cov, zero));
+		aHigh = _mm_mullo_epi16(aHigh, _mm_unpackhi_epi8(cov, zero));
+
+		__m128i assign = _mm_packs_epi16(_mm_cmpeq_epi16(aLow, opaque),
+			_mm_cmpeq_epi16(aHigh, opaque));
+		__m128i skip = _mm_packs_epi16(_mm_cmpeq_epi16(aLow, zero),
+			_mm_cmpeq_epi16(aHigh, zero));
+
+		__m128i d = _mm_loadu_si128((const __m128i*)dst);
+		__m128i low = blend16(sLow, _mm_unpacklo_epi8(d, zero), aLow);
+		__m128i high = blend16(sHigh, _mm_unpackhi_epi8(d, zero), aHigh);
+		__m128i result = _mm_or_si128(_mm_packus_epi16(low, high),
+			alphaMask);
+		result = select(assign,
+			_mm_or_si128(_mm_packus_epi16(sLow, sHigh), alphaMask), result);
+
+		_mm_storeu_si128((__m128i*)dst, select(skip, d, result));
+	}
+	gScalarSpanBlenders.blend16_colors(dst, colors, covers, len);
+}
+
+// sse2_average_covers
+static void
+sse2_average_covers(uint8* dst, uint32 color, const uint8* covers,
+	unsigned len)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alphaMask = _mm_set1_epi32(kAlphaMask);
+	const __m128i s = _mm_unpacklo_epi8(_mm_set1_epi32(color), zero);
+
+	for (; len >= 4; len -= 4, dst += 16, covers += 4) {
+		uint32 packed;
+		__m128i cov = load_covers(covers, packed);
+		if (packed == 0)
+			continue;
+
+		__m128i d = _mm_loadu_si128((const __m128i*)dst);
+		__m128i dLow = _mm_unpacklo_epi8(d, zero);
+		__m128i dHigh = _mm_unpackhi_epi8(d, zero);
+		__m128i low = blend8(_mm_srli_epi16(_mm_add_epi16(dLow, s), 1), dLow,
+			assign_alpha(_mm_unpacklo_epi8(cov, zero)));
+		__m128i high = blend8(_mm_srli_epi16(_mm_add_epi16(dHigh, s), 1),
+			dHigh, assign_alpha(_mm_unpackhi_epi8(cov, zero)));
+		__m128i result = _mm_or_si128(_mm_packus_epi16(low, high),
+			alphaMask);
+
+		_mm_storeu_si128((__m128i*)dst,
+			select(_mm_cmpeq_epi8(cov, zero), d, result));
+	}
+	gScalarSpanBlenders.average_covers(dst, color, covers, len);
+}
+
+
+const span_blenders gSSE2SpanBlenders = {
+	"sse2",
+	sse2_fill,
+	sse2_blend_covers,
+	sse2_blend_covers_subpix,
+	sse2_blend16_covers,
+	sse2_blend16_colors,
+	sse2_average_covers
+};
@@ -0,0 +1,437 @@
+/*
+ * Copyright 2026, Haiku, Inc.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	The bitmap contents are split into tiles of kTileBytes bytes times
+	kTileRows rows; the tiles are hashed, and the hash of all tile hashes
+	identifies the bitmap contents. The client keeps a bitmap in every slot
+	it has been sent to, until the slot is reused for another bitmap.
+
+	When a bitmap changed since it was last drawn, the client is told to copy
+	the previous contents into the new slot, and only the tiles that differ
+	are transferred. All tiles are PackBits compressed, which works well for
+	the large uniform areas that are common in icons and backgrounds.
+*/
+
+
+#include "RemoteBitmapCache.h"
+
+#include "RemoteMessage.h"
+#include "ServerBitmap.h"
+
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define TRACE(x...)				/*debug_printf("RemoteBitmapCache: " x)*/
+#define TRACE_ALWAYS(x...)		debug_printf("RemoteBitmapCache: " x)
+
+
+static const uint32 kMaxClientCacheSize = 64 * 1024 * 1024;
+static const int32 kTileBytes = 256;
+static const int32 kTileRows = 32;
+static const size_t kTileSize = kTileBytes * kTileRows;
+static const size_t kMaxPackedTileSize = kTileSize + kTileSize / 128 + 1;
+
+
+static inline uint64
+hash_data(const uint8* data, size_t length, uint64 hash)
+{
+	while (length >= sizeof(uint64)) {
+		uint64 value;
+		memcpy(&value, data, sizeof(uint64));
+		hash = (hash ^ value) * 0x9e3779b97f4a7c15ULL;
+		hash ^= hash >> 32;
+		data += sizeof(uint64);
+		length -= sizeof(uint64);
+	}
+	while (length-- > 0)
+		hash = (hash ^ *data++) * 0x100000001b3ULL;
+
+	return hash;
+}
+
+
+/*!	Compresses \a length bytes from \a source using PackBits; \a target must
+	have room for at least \a length + \a length / 128 + 1 bytes.
+*/
+static size_t
+pack_bits(const uint8* source, size_t length, uint8* target)
+{
+	uint8* start = target;
+	size_t index = 0;
+
+	while (index < length) {
+		size_t run = 1;
+		while (index + run < length && run < 128
+			&& source[index + run] == source[index]) {
+			run++;
+		}
+
+		if (run >= 3) {
+			*target++ = (uint8)(257 - run);
+			*target++ = source[index];
+			index += run;
+			continue;
+		}
+
+		size_t literalStart = index;
+		size_t literal = 0;
+		while (index < length && literal < 128) {
+			if (index + 2 < length && source[index] == source[index + 1]
+				&& source[index] == source[index + 2]) {
+				break;
+			}
+			index++;
+			literal++;
+		}
+
+		*target++ = (uint8)(literal - 1);
+		memcpy(target, source + literalStart, literal);
+		target += literal;
+	}
+
+	return target - start;
+}
+
+
+static inline bool
+same_layout(const remote_cached_bitmap* entry, const ServerBitmap& bitmap)
+{
+	return entry->width == bitmap.Width() && entry->height == bitmap.Height()
+		&& entry->bytes_per_row == bitmap.BytesPerRow()
+		&& entry->space == bitmap.ColorSpace()
+		&& entry->flags == bitmap.Flags();
+}
+
+
+// #pragma mark -
+
+
+RemoteBitmapCache::RemoteBitmapCache()
+	:
+	fLock("remote bitmap cache"),
+	fClientCacheSize(0),
+	fUsedSize(0),
+	fSlots(NULL),
+	fUsedSlots(0),
+	fTileHashes(NULL),
+	fTileHashesSize(0),
+	fDrawCount(0),
+	fUncachedBytes(0),
+	fSentBytes(0)
+{
+}
+
+
+RemoteBitmapCache::~RemoteBitmapCache()
+{
+	_Clear();
+	delete[] fSlots;
+	free(fTileHashes);
+}
+
+
+/*!	Is called whenever a client connects; everything that has been cached
+	for a previous client is forgotten.
+*/
+void
+RemoteBitmapCache::SetClientCacheSize(uint32 size)
+{
+	_Clear();
+
+	fClientCacheSize = 0;
+	if (size == 0)
+		return;
+
+	if (fSlots == NULL) {
+		fSlots = new(std::nothrow) remote_cached_bitmap[kMaxCachedBitmaps];
+		if (fSlots == NULL)
+			return;
+
+		for (int32 i = 0; i < kMaxCachedBitmaps; i++) {
+			fSlots[i].slot = i;
+			fSlots[i].used = false;
+			fSlots[i].tile_hashes = NULL;
+		}
+	}
+
+	if (fTable.TableSize() == 0 && fTable.Init() != B_OK)
+		return;
+
+	fClientCacheSize = min_c(size, kMaxClientCacheSize);
+}
+
+
+/*!	Makes sure the client has the contents of \a bitmap in one of its
+	slots, and returns that slot. If the bitmap cannot be cached, -1 is
+	returned, and the bitmap needs to be sent as is.
+	The cache must be locked until the message that uses the slot has been
+	sent, too.
+*/
+int32
+RemoteBitmapCache::PrepareBitmap(const ServerBitmap& bitmap,
+	StreamingRingBuffer* target)
+{
+	uint32 size = bitmap.BitsLength();
+	const uint8* bits = bitmap.Bits();
+	if (!IsEnabled() || bits == NULL || size == 0
+		|| size > fClientCacheSize / 4) {
+		return -1;
+	}
+
+	fDrawCount++;
+	fUncachedBytes += size;
+
+	int32 bytesPerRow = bitmap.BytesPerRow();
+	int32 height = bitmap.Height();
+	int32 columns = (bytesPerRow + kTileBytes - 1) / kTileBytes;
+	int32 rows = (height + kTileRows - 1) / kTileRows;
+	int32 tileCount = columns * rows;
+
+	if (tileCount > fTileHashesSize) {
+		uint64* tileHashes = (uint64*)realloc(fTileHashes,
+			tileCount * sizeof(uint64));
+		if (tileHashes == NULL)
+			return -1;
+
+		fTileHashes = tileHashes;
+		fTileHashesSize = tileCount;
+	}
+
+	for (int32 row = 0; row < rows; row++) {
+		int32 tileHeight = min_c(kTileRows, height - row * kTileRows);
+		for (int32 column = 0; column < columns; column++) {
+			int32 x = column * kTileBytes;
+			int32 tileWidth = min_c(kTileBytes, bytesPerRow - x);
+			const uint8* tileBits = bits + row * kTileRows * bytesPerRow + x;
+
+			uint64 hash = 0xcbf29ce484222325ULL;
+			for (int32 y = 0; y < tileHeight; y++)
+				hash = hash_data(tileBits + y * bytesPerRow, tileWidth, hash);
+
+			fTileHashes[row * columns + column] = hash;
+		}
+	}
+
+	int32 layout[4] = { bitmap.Width(), height, bytesPerRow,
+		(int32)bitmap.ColorSpace() };
+	uint64 hash = hash_data((const uint8*)layout, sizeof(layout),
+		0xcbf29ce484222325ULL ^ bitmap.Flags());
+	hash = hash_data((const uint8*)fTileHashes, tileCount * sizeof(uint64),
+		hash);
+
+	remote_cached_bitmap* entry = fTable.Lookup(hash);
+	if (entry != NULL && same_layout(entry, bitmap)) {
+		// the client already has it
+		fUsageList.Remove(entry);
+		fUsageList.Add(entry);
+
+		if (entry->source != &bitmap) {
+			_ForgetSource(entry);
+			entry->source = &bitmap;
+		}
+		fLastSlots.Put(&bitmap, entry->slot);
+		return entry->slot;
+	}
+	if (entry != NULL)
+		return -1;
+
+	// The bitmap may have been drawn with different contents before; the
+	// client can then start with those
+	remote_cached_bitmap* base = NULL;
+	if (fLastSlots.ContainsKey(&bitmap)) {
+		base = &fSlots[fLastSlots.Get(&bitmap)];
+		if (!base->used || base->source != &bitmap
+			|| !same_layout(base, bitmap) || base->tile_count != tileCount) {
+			base = NULL;
+		} else {
+			fUsageList.Remove(base);
+			fUsageList.Add(base);
+		}
+	}
+
+	entry = _Allocate(size, base);
+	if (entry == NULL)
+		return -1;
+
+	entry->tile_hashes = (uint64*)malloc(tileCount * sizeof(uint64));
+	if (entry->tile_hashes == NULL)
+		return -1;
+
+	memcpy(entry->tile_hashes, fTileHashes, tileCount * sizeof(uint64));
+	entry->tile_count = tileCount;
+	entry->hash = hash;
+	entry->width = bitmap.Width();
+	entry->height = height;
+	entry->bytes_per_row = bytesPerRow;
+	entry->space = bitmap.ColorSpace();
+	entry->flags = bitmap.Flags();
+	entry->size = size;
+	entry->source = &bitmap;
+	entry->used = true;
+
+	fTable.Insert(entry);
+	fUsageList.Add(entry);
+	fUsedSize += size;
+	fUsedSlots++;
+
+	if (_Send(bitmap, entry, base, target) != B_OK) {
+		_Evict(entry);
+		return -1;
+	}
+
+	fLastSlots.Put(&bitmap, entry->slot);
+	return entry->slot;
+}
+
+
+void
+RemoteBitmapCache::PrintStatistics()
+{
+	if (fDrawCount == 0)
+		return;
+
+	TRACE_ALWAYS("%" B_PRIu64 " bitmaps drawn, %" B_PRIu64 " bytes sent "
+		"instead of %" B_PRIu64 " (%" B_PRIu64 "%%)\n", fDrawCount, fSentBytes,
+		fUncachedBytes, fSentBytes * 100 / max_c(fUncachedBytes, 1));
+}
+
+
+void
+RemoteBitmapCache::_Clear()
+{
+	while (remote_cached_bitmap* entry = fUsageList.Head())
+		_Evict(entry);
+
+	fLastSlots.Clear();
+	fDrawCount = 0;
+	fUncachedBytes = 0;
+	fSentBytes = 0;
+}
+
+
+//!	Returns an unused slot, evicting the least recently used bitmaps.
+remote_cached_bitmap*
+RemoteBitmapCache::_Allocate(uint32 size, remote_cached_bitmap* keep)
+{
+	while (fUsedSize + size > fClientCacheSize || fUsedSlots == kMaxCachedBitmaps) {
+		remote_cached_bitmap* oldest = fUsageList.Head();
+		if (oldest == NULL || oldest == keep)
+			return NULL;
+
+		_Evict(oldest);
+	}
+
+	for (int32 i = 0; i < kMaxCachedBitmaps; i++) {
+		if (!fSlots[i].used)
+			return &fSlots[i];
+	}
+
+	return NULL;
+}
+
+
+void
+RemoteBitmapCache::_Evict(remote_cached_bitmap* entry)
+{
+	TRACE("evict slot %" B_PRId32 "\n", entry->slot);
+
+	fTable.Remove(entry);
+	fUsageList.Remove(entry);
+	fUsedSize -= entry->size;
+	fUsedSlots--;
+
+	_ForgetSource(entry);
+
+	free(entry->tile_hashes);
+	entry->tile_hashes = NULL;
+	entry->source = NULL;
+	entry->used = false;
+}
+
+
+void
+RemoteBitmapCache::_ForgetSource(remote_cached_bitmap* entry)
+{
+	if (fLastSlots.ContainsKey(entry->source)
+		&& fLastSlots.Get(entry->source) == entry->slot) {
+		fLastSlots.Remove(entry->source);
+	}
+}
+
+
+/*!	Sends the tiles of \a bitmap that differ from \a base, or all of them
+	if there is no base, to the slot of \a entry.
+*/
+status_t
+RemoteBitmapCache::_Send(const ServerBitmap& bitmap,
+	remote_cached_bitmap* entry, remote_cached_bitmap* base,
+	StreamingRingBuffer* target)
+{
+	uint8* tile = (uint8*)malloc(kTileSize + kMaxPackedTileSize);
+	if (tile == NULL)
+		return B_NO_MEMORY;
+
+	uint8* packed = tile + kTileSize;
+
+	int32 bytesPerRow = entry->bytes_per_row;
+	int32 columns = (bytesPerRow + kTileBytes - 1) / kTileBytes;
+
+	int32 changedCount = 0;
+	for (int32 i = 0; i < entry->tile_count; i++) {
+		if (base == NULL || base->tile_hashes[i] != entry->tile_hashes[i])
+			changedCount++;
+	}
+
+	RemoteMessage message(NULL, target);
+	message.Start(RP_CACHE_BITMAP);
+	message.Add(entry->slot);
+	message.Add(base != NULL ? base->slot : (int32)-1);
+	message.Add(entry->width);
+	message.Add(entry->height);
+	message.Add(entry->bytes_per_row);
+	message.Add(entry->space);
+	message.Add(entry->flags);
+	message.Add(changedCount);
+
+	fSentBytes += 9 * sizeof(int32) + sizeof(uint16) + sizeof(uint32);
+
+	const uint8* bits = bitmap.Bits();
+	for (int32 i = 0; i < entry->tile_count; i++) {
+		if (base != NULL && base->tile_hashes[i] == entry->tile_hashes[i])
+			continue;
+
+		int32 x = (i % columns) * kTileBytes;
+		int32 y = (i / columns) * kTileRows;
+		int32 tileWidth = min_c(kTileBytes, bytesPerRow - x);
+		int32 tileHeight = min_c(kTileRows, entry->height - y);
+
+		for (int32 row = 0; row < tileHeight; row++) {
+			memcpy(tile + row * tileWidth, bits + (y + row) * bytesPerRow + x,
+				tileWidth);
+		}
+
+		uint32 packedSize = pack_bits(tile, tileWidth * tileHeight, packed);
+
+		message.Add(x);
+		message.Add(y);
+		message.Add(tileWidth);
+		message.Add(tileHeight);
+		message.Add(packedSize);
+		message.AddData(packed, packedSize);
+
+		fSentBytes += 5 * sizeof(int32) + packedSize;
+	}
+
+	free(tile);
+
+	TRACE("sent slot %" B_PRId32 " (base %" B_PRId32 "), %" B_PRId32 " of %"
+		B_PRId32 " tiles\n", entry->slot, base != NULL ? base->slot : -1,
+		changedCount, entry->tile_count);
+
+	return message.Flush();
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2026, Haiku, Inc.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef REMOTE_BITMAP_CACHE_H
+#define REMOTE_BITMAP_CACHE_H
+
+#include <GraphicsDefs.h>
+#include <Locker.h>
+
+#include <HashMap.h>
+#include <util/DoublyLinkedList.h>
+#include <util/OpenHashTable.h>
+
+class ServerBitmap;
+class StreamingRingBuffer;
+
+
+struct remote_cached_bitmap : DoublyLinkedListLinkImpl<remote_cached_bitmap> {
+	uint64					hash;
+	int32					slot;
+	bool					used;
+
+	int32					width;
+	int32					height;
+	int32					bytes_per_row;
+	color_space				space;
+	uint32					flags;
+	uint32					size;
+
+	uint64*					tile_hashes;
+	int32					tile_count;
+
+	const ServerBitmap*		source;
+	remote_cached_bitmap*	hash_link;
+};
+
+
+/*!	Keeps track of the bitmaps the client has stored, so that a bitmap needs
+	to be transferred only once, and then only in those parts that changed.
+	The client announces how much memory it is willing to spend on this when
+	it connects.
+*/
+class RemoteBitmapCache {
+public:
+								RemoteBitmapCache();
+								~RemoteBitmapCache();
+
+			bool				Lock() { return fLock.Lock(); }
+			void				Unlock() { fLock.Unlock(); }
+
+			void				SetClientCacheSize(uint32 size);
+			uint32				ClientCacheSize() const
+									{ return fClientCacheSize; }
+			bool				IsEnabled() const
+									{ return fClientCacheSize > 0; }
+
+			int32				PrepareBitmap(const ServerBitmap& bitmap,
+									StreamingRingBuffer* target);
+
+			void				PrintStatistics();
+
+private:
+			struct HashDefinition {
+				typedef uint64					KeyType;
+				typedef	remote_cached_bitmap	ValueType;
+
+				size_t HashKey(uint64 key) const
+				{
+					return (size_t)(key ^ (key >> 32));
+				}
+
+				size_t Hash(remote_cached_bitmap* value) const
+				{
+					return HashKey(value->hash);
+				}
+
+				bool Compare(uint64 key, remote_cached_bitmap* value) const
+				{
+					return value->hash == key;
+				}
+
+				remote_cached_bitmap*& GetLink(
+					remote_cached_bitmap* value) const
+				{
+					return value->hash_link;
+				}
+			};
+
+			typedef BOpenHashTable<HashDefinition> BitmapTable;
+			typedef DoublyLinkedList<remote_cached_bitmap> BitmapList;
+			typedef HashMap<HashKeyPointer<const ServerBitmap*>, int32>
+				SourceMap;
+
+			void				_Clear();
+			remote_cached_bitmap* _Allocate(uint32 size,
+									remote_cached_bitmap* keep);
+			void				_Evict(remote_cached_bitmap* entry);
+			void				_ForgetSource(remote_cached_bitmap* entry);
+			status_t			_Send(const ServerBitmap& bitmap,
+									remote_cached_bitmap* entry,
+									remote_cached_bitmap* base,
+									StreamingRingBuffer* target);
+
+			BLocker				fLock;
+			uint32				fClientCacheSize;
+			uint32				fUsedSize;
+
+			remote_cached_bitmap* fSlots;
+			int32				fUsedSlots;
+			BitmapTable			fTable;
+			BitmapList			fUsageList;
+			SourceMap			fLastSlots;
+
+			uint64*				fTileHashes;
+			int32				fTileHashesSize;
+
+			uint64				fDrawCount;
+			uint64				fUncachedBytes;
+			uint64				fSentBytes;
+};
+
+
+#endif // REMOTE_BITMAP_CACHE_H
@@ -7,12 +7,14 @@
  */
 
 #include "RemoteDrawingEngine.h"
+#include "RemoteBitmapCache.h"
 #include "RemoteMessage.h"
 
 #include "BitmapDrawingEngine.h"
 #include "DrawState.h"
 #include "ServerTokenSpace.h"
 
+#include <AutoLocker.h>
 #include <Bitmap.h>
 #include <utf8_functions.h>
 
@@ -353,6 +355,26 @@ RemoteDrawingEngine::DrawBitmap(ServerBitmap* bitmap, const BRect& _bitmapRect,
 	if (rectCount == 0)
 		return;
 
+	// If the client keeps bitmaps, it does the clipping and scaling on its
+	// own, so that the whole bitmap can be reused later
+	RemoteBitmapCache* cache = fHWInterface->BitmapCache();
+	AutoLocker<RemoteBitmapCache> cacheLocker(cache);
+	if (cache->IsEnabled()) {
+		int32 slot = cache->PrepareBitmap(*bitmap, fHWInterface->SendBuffer());
+		if (slot >= 0) {
+			RemoteMessage message(NULL, fHWInterface->SendBuffer());
+			message.Start(RP_DRAW_CACHED_BITMAP);
+			message.Add(fToken);
+			message.Add(bitmapRect);
+			message.Add(viewRect);
+			message.Add(options);
+			message.Add(slot);
+			message.Flush();
+			return;
+		}
+	}
+	cacheLocker.Unlock();
+
 	if (rectCount > 1 || (rectCount == 1 && clippedRegion.RectAt(0) != viewRect)
 		|| viewRect.Width() < bitmapRect.Width()
 		|| viewRect.Height() < bitmapRect.Height()) {
@@ -380,7 +402,6 @@ RemoteDrawingEngine::DrawBitmap(ServerBitmap* bitmap, const BRect& _bitmapRect,
 		return;
 	}
 
-	// TODO: we may want to cache/checksum bitmaps
 	RemoteMessage message(NULL, fHWInterface->SendBuffer());
 	message.Start(RP_DRAW_BITMAP);
 	message.Add(fToken);
@@ -7,6 +7,7 @@
  */
 
 #include "RemoteHWInterface.h"
+#include "RemoteBitmapCache.h"
 #include "RemoteDrawingEngine.h"
 #include "RemoteEventStream.h"
 #include "RemoteMessage.h"
@@ -17,6 +18,7 @@
 
 #include "SystemPalette.h"
 
+#include <AutoLocker.h>
 #include <Autolock.h>
 #include <NetEndpoint.h>
 
@@ -51,6 +53,7 @@ RemoteHWInterface::RemoteHWInterface(const char* target)
 	fReceiver(NULL),
 	fEventThread(-1),
 	fEventStream(NULL),
+	fBitmapCache(NULL),
 	fCallbackLocker("callback locker")
 {
 	memset(&fFallbackMode, 0, sizeof(fFallbackMode));
@@ -109,6 +112,12 @@ RemoteHWInterface::RemoteHWInterface(const char* target)
 		return;
 	}
 
+	fBitmapCache.SetTo(new(std::nothrow) RemoteBitmapCache());
+	if (!fBitmapCache.IsSet()) {
+		fInitStatus = B_NO_MEMORY;
+		return;
+	}
+
 	fEventThread = spawn_thread(_EventThreadEntry, "remote event thread",
 		B_NORMAL_PRIORITY, this);
 	if (fEventThread < 0) {
@@ -253,8 +262,19 @@ RemoteHWInterface::_EventThread()
 		switch (code) {
 			case RP_INIT_CONNECTION:
 			{
+				// Newer clients tell how much memory they have for cached
+				// bitmaps, older ones don't send anything
+				uint32 bitmapCacheSize = 0;
+				if (message.DataLeft() >= sizeof(uint32))
+					message.Read(bitmapCacheSize);
+
+				AutoLocker<RemoteBitmapCache> cacheLocker(fBitmapCache.Get());
+				fBitmapCache->PrintStatistics();
+				fBitmapCache->SetClientCacheSize(bitmapCacheSize);
+
 				RemoteMessage reply(NULL, fSendBuffer.Get());
 				reply.Start(RP_INIT_CONNECTION);
+				reply.Add(fBitmapCache->ClientCacheSize());
 				status_t result = reply.Flush();
 				(void)result;
 				TRACE("init connection result: %s\n", strerror(result));
@@ -354,6 +374,12 @@ RemoteHWInterface::_Disconnect()
 		fIsConnected = false;
 	}
 
+	if (fBitmapCache.IsSet()) {
+		AutoLocker<RemoteBitmapCache> cacheLocker(fBitmapCache.Get());
+		fBitmapCache->PrintStatistics();
+		fBitmapCache->SetClientCacheSize(0);
+	}
+
 	if (fListenEndpoint.IsSet())
 		fListenEndpoint->Close();
 }
@@ -18,6 +18,7 @@ class BNetEndpoint;
 class StreamingRingBuffer;
 class NetSender;
 class NetReceiver;
+class RemoteBitmapCache;
 class RemoteEventStream;
 class RemoteMessage;
 
@@ -84,6 +85,8 @@ virtual	status_t					CopyBackToFront(const BRect& frame);
 		StreamingRingBuffer*		ReceiveBuffer()
 										{ return fReceiveBuffer.Get(); }
 		StreamingRingBuffer*		SendBuffer() { return fSendBuffer.Get(); }
+		RemoteBitmapCache*			BitmapCache()
+										{ return fBitmapCache.Get(); }
 
 typedef bool (*CallbackFunction)(void* cookie, RemoteMessage& message);
 
@@ -130,6 +133,8 @@ static	status_t					_NewConnectionCallback(void *cookie,
 		thread_id					fEventThread;
 		ObjectDeleter<RemoteEventStream>
 									fEventStream;
+		ObjectDeleter<RemoteBitmapCache>
+									fBitmapCache;
 
 		BLocker						fCallbackLocker;
 		BObjectList<callback_info>	fCallbacks;
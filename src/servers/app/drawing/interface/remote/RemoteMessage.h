@@ -65,6 +65,8 @@ enum {
 	RP_INVERT_RECT,
 	RP_DRAW_BITMAP,
 	RP_DRAW_BITMAP_RECTS,
+	RP_CACHE_BITMAP,
+	RP_DRAW_CACHED_BITMAP,
 
 	RP_STROKE_ARC = 80,
 	RP_STROKE_BEZIER,
@@ -129,6 +131,10 @@ enum {
 };
 
 
+// number of bitmap slots for RP_CACHE_BITMAP and RP_DRAW_CACHED_BITMAP
+static const int32 kMaxCachedBitmaps = 1024;
+
+
 class RemoteMessage {
 public:
 								RemoteMessage(StreamingRingBuffer* source,
@@ -146,6 +152,7 @@ public:
 		template<typename T>
 		void					Add(const T& value);
 
+		void					AddData(const void* data, size_t length);
 		void					AddString(const char* string, size_t length);
 		void					AddRegion(const BRegion& region);
 		void					AddGradient(const BGradient& gradient);
@@ -169,6 +176,7 @@ public:
 		template<typename T>
 		status_t				Read(T& value);
 
+		status_t				ReadData(void* data, size_t length);
 		status_t				ReadRegion(BRegion& region);
 		status_t				ReadFontState(BFont& font);
 									// sets font state
@@ -266,6 +274,18 @@ RemoteMessage::Add(const T& value)
 }
 
 
+inline void
+RemoteMessage::AddData(const void* data, size_t length)
+{
+	if (!_MakeSpace(length))
+		return;
+
+	memcpy(fBuffer + fWriteIndex, data, length);
+	fWriteIndex += length;
+	fAvailable -= length;
+}
+
+
 inline void
 RemoteMessage::AddString(const char* string, size_t length)
 {
@@ -321,6 +341,27 @@ RemoteMessage::Read(T& value)
 }
 
 
+inline status_t
+RemoteMessage::ReadData(void* data, size_t length)
+{
+	if (fDataLeft < length)
+		return B_ERROR;
+
+	if (fSource == NULL)
+		return B_NO_INIT;
+
+	int32 readSize = fSource->Read(data, length);
+	if (readSize < 0)
+		return readSize;
+
+	if ((size_t)readSize != length)
+		return B_ERROR;
+
+	fDataLeft -= readSize;
+	return B_OK;
+}
+
+
 inline status_t
 RemoteMessage::ReadRegion(BRegion& region)
 {
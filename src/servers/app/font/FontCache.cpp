@@ -105,6 +105,37 @@ FontCache::Recycle(FontCacheEntry* entry)
 	entry->ReleaseReference();
 }
 
+// Dump
+void
+FontCache::Dump()
+{
+	AutoReadLocker locker(this);
+
+	debug_printf("font cache: %" B_PRId32 " entries\n",
+		fFontCacheEntries.Size());
+
+	FontMap::Iterator iterator = fFontCacheEntries.GetIterator();
+	while (iterator.HasNext()) {
+		FontMap::Entry mapEntry = iterator.Next();
+		FontCacheEntry* entry = mapEntry.value;
+
+		glyph_run_cache_stats stats;
+		if (!entry->ReadLock())
+			continue;
+		entry->RunCache().GetStatistics(stats);
+		entry->ReadUnlock();
+
+		int64 lookups = stats.hits + stats.misses;
+		debug_printf("  %s: %" B_PRId64 " used, runs: %" B_PRId32 " (%" B_PRIuSIZE
+			" bytes), hits: %" B_PRId64 " of %" B_PRId64 " (%" B_PRId64 "%%), "
+			"inserted: %" B_PRId64 ", evicted: %" B_PRId64 ", combined: %"
+			B_PRId64 "\n", mapEntry.key.GetString(), entry->UsedCount(),
+			stats.runs, stats.memory, stats.hits, lookups,
+			lookups > 0 ? stats.hits * 100 / lookups : 0, stats.insertions,
+			stats.evictions, stats.coverage_builds);
+	}
+}
+
 static const int32 kMaxEntryCount = 30;
 
 static inline double
@@ -28,6 +28,8 @@ class FontCache : public MultiLocker {
 									bool forceVector);
 			void				Recycle(FontCacheEntry* entry);
 
+			void				Dump();
+
  private:
 			void				_ConstrainEntryCount();
 
@@ -133,6 +133,7 @@ FontCacheEntry::FontCacheEntry()
 	:
 	MultiLocker("FontCacheEntry lock"),
 	fGlyphCache(new(std::nothrow) GlyphCachePool()),
+	fRunCache(new(std::nothrow) GlyphRunCache()),
 	fEngine(),
 	fLastUsedTime(LONGLONG_MIN),
 	fUseCounter(0)
@@ -149,7 +150,7 @@ FontCacheEntry::~FontCacheEntry()
 bool
 FontCacheEntry::Init(const ServerFont& font, bool forceVector)
 {
-	if (!fGlyphCache.IsSet())
+	if (!fGlyphCache.IsSet() || !fRunCache.IsSet())
 		return false;
 
 	glyph_rendering renderingType = _RenderTypeFor(font, forceVector);
@@ -178,6 +179,12 @@ FontCacheEntry::Init(const ServerFont& font, bool forceVector)
 		return false;
 	}
 
+	if (fRunCache->Init() != B_OK) {
+		fprintf(stderr, "FontCacheEntry::Init() - failed to allocate "
+			"GlyphRunCache table for font file %s\n", font.Path());
+		return false;
+	}
+
 	return true;
 }
 
@@ -36,6 +36,7 @@
 
 #include "ServerFont.h"
 #include "FontEngine.h"
+#include "GlyphRunCache.h"
 #include "MultiLocker.h"
 #include "Referenceable.h"
 #include "Transformable.h"
@@ -125,6 +126,9 @@ class FontCacheEntry : public MultiLocker, public BReferenceable {
 			bool				GetKerning(uint32 glyphCode1,
 									uint32 glyphCode2, double* x, double* y);
 
+			GlyphRunCache&		RunCache()
+									{ return *fRunCache.Get(); }
+
 	static	void				GenerateSignature(char* signature,
 									size_t signatureSize,
 									const ServerFont& font, bool forceVector);
@@ -147,6 +151,8 @@ class FontCacheEntry : public MultiLocker, public BReferenceable {
 
 			ObjectDeleter<GlyphCachePool>
 								fGlyphCache;
+			ObjectDeleter<GlyphRunCache>
+								fRunCache;
 			FontEngine			fEngine;
 
 	static	BLocker				sUsageUpdateLock;
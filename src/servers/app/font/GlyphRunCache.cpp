@@ -0,0 +1,386 @@
+/*
+ * Copyright 2026, Haiku. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Caches the layout of strings that are drawn over and over again.
+
+	For a string that has been drawn before, the glyphs, their positions and
+	the bounds are remembered, so that GlyphLayoutEngine does not need to
+	decode the string, look up each glyph, and apply kerning again. Once such
+	a run is drawn with native gray8 glyphs, the coverage of all its glyphs is
+	combined into a single serialized scanline storage (the same format the
+	glyphs themselves use), and can then be blitted in one pass.
+
+	Strings are only taken into the cache when they have been drawn at least
+	twice, so that one-off strings do not push out the useful ones.
+*/
+
+
+#include "GlyphRunCache.h"
+
+#include <new>
+#include <string.h>
+
+#include <agg_scanline_u.h>
+
+#include "FontCacheEntry.h"
+
+
+static const int32 kMaxRuns = 256;
+static const size_t kMaxMemoryUsage = 1024 * 1024;
+static const size_t kMaxCoverageSize = 256 * 1024;
+
+
+GlyphRunKey::GlyphRunKey(const char* string, uint32 length,
+	const escapement_delta* delta, uint8 spacing, float size)
+	:
+	string(string),
+	length(length),
+	space(delta != NULL ? delta->space : 0.0f),
+	nonspace(delta != NULL ? delta->nonspace : 0.0f),
+	spacing(spacing),
+	size(size)
+{
+	uint32 value = 2166136261U;
+	for (uint32 i = 0; i < length; i++)
+		value = (value ^ (uint8)string[i]) * 16777619U;
+
+	hash = value ^ spacing;
+}
+
+
+// #pragma mark -
+
+
+GlyphRun::GlyphRun()
+	:
+	string(NULL),
+	length(0),
+	placements(NULL),
+	count(0),
+	end_x(0.0),
+	end_y(0.0),
+	gray8_only(false),
+	coverage(NULL),
+	coverage_size(0),
+	coverage_phase_x(0.0),
+	coverage_phase_y(0.0),
+	hash_link(NULL)
+{
+}
+
+
+GlyphRun::~GlyphRun()
+{
+	free(string);
+	free(placements);
+	free(coverage);
+}
+
+
+size_t
+GlyphRun::MemoryUsage() const
+{
+	return sizeof(GlyphRun) + length + count * sizeof(GlyphPlacement)
+		+ coverage_size;
+}
+
+
+// #pragma mark -
+
+
+bool
+GlyphRunCache::RunHashDefinition::Compare(const GlyphRunKey& key,
+	GlyphRun* value) const
+{
+	return value->hash == key.hash && value->length == key.length
+		&& value->spacing == key.spacing && value->space == key.space
+		&& value->nonspace == key.nonspace && value->size == key.size
+		&& memcmp(value->string, key.string, key.length) == 0;
+}
+
+
+GlyphRunCache::GlyphRunCache()
+	:
+	fRunCount(0),
+	fMemoryUsage(0),
+	fHits(0),
+	fMisses(0),
+	fInsertions(0),
+	fEvictions(0),
+	fCoverageBuilds(0)
+{
+	memset(fSeenHashes, 0, sizeof(fSeenHashes));
+}
+
+
+GlyphRunCache::~GlyphRunCache()
+{
+	fRunTable.Clear();
+	while (GlyphRun* run = fRunList.RemoveHead())
+		delete run;
+}
+
+
+status_t
+GlyphRunCache::Init()
+{
+	return fRunTable.Init();
+}
+
+
+const GlyphRun*
+GlyphRunCache::Lookup(const GlyphRunKey& key)
+{
+	GlyphRun* run = NULL;
+	if (key.length <= kMaxStringLength)
+		run = fRunTable.Lookup(key);
+
+	if (run != NULL)
+		atomic_add64(&fHits, 1);
+	else
+		atomic_add64(&fMisses, 1);
+
+	return run;
+}
+
+
+/*!	Returns whether or not the run should be added to the cache. This is the
+	case when it was asked for before; the first time, the string is only
+	remembered.
+*/
+bool
+GlyphRunCache::Admit(const GlyphRunKey& key)
+{
+	if (key.length > kMaxStringLength)
+		return false;
+
+	int32* seen = &fSeenHashes[key.hash % B_COUNT_OF(fSeenHashes)];
+	if ((uint32)atomic_get(seen) == key.hash)
+		return true;
+
+	atomic_set(seen, (int32)key.hash);
+	return false;
+}
+
+
+const GlyphRun*
+GlyphRunCache::Insert(const GlyphRunKey& key, const GlyphPlacement* placements,
+	int32 count, const agg::rect_i& bounds, double endX, double endY)
+{
+	if (key.length > kMaxStringLength)
+		return NULL;
+
+	GlyphRun* run = fRunTable.Lookup(key);
+	if (run != NULL)
+		return run;
+
+	run = new(std::nothrow) GlyphRun;
+	if (run == NULL)
+		return NULL;
+
+	run->string = (char*)malloc(key.length > 0 ? key.length : 1);
+	run->placements = (GlyphPlacement*)malloc(
+		(count > 0 ? count : 1) * sizeof(GlyphPlacement));
+	if (run->string == NULL || run->placements == NULL) {
+		delete run;
+		return NULL;
+	}
+
+	memcpy(run->string, key.string, key.length);
+	run->length = key.length;
+	run->space = key.space;
+	run->nonspace = key.nonspace;
+	run->spacing = key.spacing;
+	run->size = key.size;
+	run->hash = key.hash;
+
+	memcpy(run->placements, placements, count * sizeof(GlyphPlacement));
+	run->count = count;
+	run->bounds = bounds;
+	run->end_x = endX;
+	run->end_y = endY;
+
+	run->gray8_only = true;
+	for (int32 i = 0; i < count; i++) {
+		if (placements[i].glyph->data_type != glyph_data_gray8) {
+			run->gray8_only = false;
+			break;
+		}
+	}
+
+	_MakeRoom(run->MemoryUsage(), NULL);
+
+	fRunTable.Insert(run);
+	fRunList.Add(run);
+	fRunCount++;
+	fMemoryUsage += run->MemoryUsage();
+	atomic_add64(&fInsertions, 1);
+
+	return run;
+}
+
+
+/*!	Combines the coverage of all glyphs in the run, as they would be placed
+	when the base line is at (\a phaseX, \a phaseY). The phase is the
+	fractional part of the base line position, as the glyph positions are
+	rounded individually.
+*/
+const GlyphRun*
+GlyphRunCache::AddCoverage(const GlyphRunKey& key, double phaseX,
+	double phaseY)
+{
+	GlyphRun* run = fRunTable.Lookup(key);
+	if (run == NULL || !run->gray8_only || run->count == 0)
+		return run;
+	if (run->HasCoverage(phaseX, phaseY))
+		return run;
+
+	// find out the area covered by the glyphs
+	agg::rect_i area(INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN);
+	for (int32 i = 0; i < run->count; i++) {
+		const GlyphPlacement& placement = run->placements[i];
+		int x = agg::iround(placement.x + phaseX);
+		int y = agg::iround(placement.y + phaseY);
+		const agg::rect_i& bounds = placement.glyph->bounds;
+		if (bounds.x1 > bounds.x2 || bounds.y1 > bounds.y2)
+			continue;
+
+		area.x1 = min_c(area.x1, bounds.x1 + x);
+		area.y1 = min_c(area.y1, bounds.y1 + y);
+		area.x2 = max_c(area.x2, bounds.x2 + x);
+		area.y2 = max_c(area.y2, bounds.y2 + y);
+	}
+	if (area.x1 > area.x2 || area.y1 > area.y2)
+		return run;
+
+	size_t width = area.x2 - area.x1 + 1;
+	size_t height = area.y2 - area.y1 + 1;
+	if (width * height > kMaxCoverageSize)
+		return run;
+
+	uint8* buffer = (uint8*)calloc(width, height);
+	if (buffer == NULL)
+		return run;
+
+	// render all glyphs into the buffer; overlapping parts are combined
+	// like the glyphs would be when blended one after the other
+	FontCacheEntry::GlyphGray8Adapter adapter;
+	FontCacheEntry::GlyphGray8Scanline glyphScanline;
+	for (int32 i = 0; i < run->count; i++) {
+		const GlyphPlacement& placement = run->placements[i];
+		adapter.init(placement.glyph->data, placement.glyph->data_size,
+			agg::iround(placement.x + phaseX),
+			agg::iround(placement.y + phaseY));
+		if (!adapter.rewind_scanlines())
+			continue;
+
+		while (adapter.sweep_scanline(glyphScanline)) {
+			int y = glyphScanline.y();
+			if (y < area.y1 || y > area.y2)
+				continue;
+
+			uint8* row = buffer + (y - area.y1) * width;
+			FontCacheEntry::GlyphGray8Scanline::const_iterator span
+				= glyphScanline.begin();
+			for (unsigned count = glyphScanline.num_spans(); count-- > 0;
+					++span) {
+				int32 length = span->len < 0 ? -span->len : span->len;
+				for (int32 j = 0; j < length; j++) {
+					int32 x = span->x + j;
+					if (x < area.x1 || x > area.x2)
+						continue;
+
+					uint32 cover = span->len < 0
+						? span->covers[0] : span->covers[j];
+					uint8& target = row[x - area.x1];
+					target = target + cover - (target * cover + 255) / 256;
+				}
+			}
+		}
+	}
+
+	// turn it into a scanline storage
+	agg::scanline_u8 scanline;
+	agg::scanline_storage_aa8 storage;
+	scanline.reset(area.x1, area.x2);
+	storage.prepare();
+	for (size_t y = 0; y < height; y++) {
+		const uint8* row = buffer + y * width;
+		scanline.reset_spans();
+		for (size_t x = 0; x < width; x++) {
+			if (row[x] != 0)
+				scanline.add_cell(area.x1 + x, row[x]);
+		}
+		if (scanline.num_spans() != 0) {
+			scanline.finalize(area.y1 + y);
+			storage.render(scanline);
+		}
+	}
+	free(buffer);
+
+	uint32 size = storage.byte_size();
+	uint8* coverage = (uint8*)malloc(size);
+	if (coverage == NULL)
+		return run;
+	storage.serialize(coverage);
+
+	fMemoryUsage -= run->MemoryUsage();
+	free(run->coverage);
+	run->coverage = coverage;
+	run->coverage_size = size;
+	run->coverage_phase_x = phaseX;
+	run->coverage_phase_y = phaseY;
+	atomic_add64(&fCoverageBuilds, 1);
+
+	// the run is in use, so put it at the end of the line, and make room
+	// for its new size
+	fRunList.Remove(run);
+	fRunList.Add(run);
+	_MakeRoom(run->MemoryUsage(), run);
+	fMemoryUsage += run->MemoryUsage();
+
+	return run;
+}
+
+
+void
+GlyphRunCache::GetStatistics(glyph_run_cache_stats& stats) const
+{
+	stats.hits = fHits;
+	stats.misses = fMisses;
+	stats.insertions = fInsertions;
+	stats.evictions = fEvictions;
+	stats.coverage_builds = fCoverageBuilds;
+	stats.runs = fRunCount;
+	stats.memory = fMemoryUsage;
+}
+
+
+//!	Removes the oldest runs until one of \a size fits in.
+void
+GlyphRunCache::_MakeRoom(size_t size, GlyphRun* keep)
+{
+	while (fRunCount > 0 && (fRunCount >= kMaxRuns
+			|| fMemoryUsage + size > kMaxMemoryUsage)) {
+		GlyphRun* run = fRunList.Head();
+		if (run == keep)
+			break;
+
+		_Remove(run);
+		atomic_add64(&fEvictions, 1);
+	}
+}
+
+
+void
+GlyphRunCache::_Remove(GlyphRun* run)
+{
+	fRunTable.Remove(run);
+	fRunList.Remove(run);
+	fRunCount--;
+	fMemoryUsage -= run->MemoryUsage();
+	delete run;
+}
@@ -0,0 +1,276 @@
+/*
+ * Copyright 2026, Haiku. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef GLYPH_RUN_CACHE_H
+#define GLYPH_RUN_CACHE_H
+
+
+#include <stdlib.h>
+
+#include <Font.h>
+#include <SupportDefs.h>
+
+#include <agg_basics.h>
+#include <util/DoublyLinkedList.h>
+#include <util/OpenHashTable.h>
+
+
+class FontCacheEntry;
+struct GlyphCache;
+
+
+struct GlyphRunKey {
+								GlyphRunKey(const char* string, uint32 length,
+									const escapement_delta* delta,
+									uint8 spacing, float size);
+
+			const char*			string;
+			uint32				length;
+			float				space;
+			float				nonspace;
+			uint8				spacing;
+			float				size;
+			uint32				hash;
+};
+
+
+struct GlyphPlacement {
+	const GlyphCache*	glyph;
+	double				x;
+	double				y;
+};
+
+
+/*!	A laid out string: the glyphs with their positions relative to the
+	base line, and, once it has been drawn as such, the coverage of all
+	glyphs combined, so that the whole run can be rendered in one pass.
+*/
+struct GlyphRun : DoublyLinkedListLinkImpl<GlyphRun> {
+								GlyphRun();
+								~GlyphRun();
+
+			bool				HasCoverage(double phaseX,
+									double phaseY) const
+									{ return coverage != NULL
+										&& coverage_phase_x == phaseX
+										&& coverage_phase_y == phaseY; }
+
+			size_t				MemoryUsage() const;
+
+			char*				string;
+			uint32				length;
+			float				space;
+			float				nonspace;
+			uint8				spacing;
+			float				size;
+			uint32				hash;
+
+			GlyphPlacement*		placements;
+			int32				count;
+			agg::rect_i			bounds;
+			double				end_x;
+			double				end_y;
+			bool				gray8_only;
+
+			uint8*				coverage;
+			uint32				coverage_size;
+			double				coverage_phase_x;
+			double				coverage_phase_y;
+
+			GlyphRun*			hash_link;
+};
+
+
+struct glyph_run_cache_stats {
+	int64	hits;
+	int64	misses;
+	int64	insertions;
+	int64	evictions;
+	int64	coverage_builds;
+	int32	runs;
+	size_t	memory;
+};
+
+
+/*!	Per FontCacheEntry cache of laid out strings. Lookups happen with the
+	entry read locked, all changes need the entry to be write locked.
+*/
+class GlyphRunCache {
+public:
+								GlyphRunCache();
+								~GlyphRunCache();
+
+			status_t			Init();
+
+			const GlyphRun*		Lookup(const GlyphRunKey& key);
+			bool				Admit(const GlyphRunKey& key);
+
+			const GlyphRun*		Insert(const GlyphRunKey& key,
+									const GlyphPlacement* placements,
+									int32 count, const agg::rect_i& bounds,
+									double endX, double endY);
+			const GlyphRun*		AddCoverage(const GlyphRunKey& key,
+									double phaseX, double phaseY);
+
+			void				GetStatistics(
+									glyph_run_cache_stats& stats) const;
+
+	static	const uint32		kMaxStringLength = 512;
+
+private:
+	struct RunHashDefinition {
+		typedef GlyphRunKey		KeyType;
+		typedef	GlyphRun		ValueType;
+
+		size_t HashKey(const GlyphRunKey& key) const
+		{
+			return key.hash;
+		}
+
+		size_t Hash(GlyphRun* value) const
+		{
+			return value->hash;
+		}
+
+		bool Compare(const GlyphRunKey& key, GlyphRun* value) const;
+
+		GlyphRun*& GetLink(GlyphRun* value) const
+		{
+			return value->hash_link;
+		}
+	};
+
+	typedef BOpenHashTable<RunHashDefinition> RunTable;
+	typedef DoublyLinkedList<GlyphRun> RunList;
+
+			void				_MakeRoom(size_t size, GlyphRun* keep);
+			void				_Remove(GlyphRun* run);
+
+			RunTable			fRunTable;
+			RunList				fRunList;
+			int32				fRunCount;
+			size_t				fMemoryUsage;
+
+			int32				fSeenHashes[64];
+
+			int64				fHits;
+			int64				fMisses;
+			int64				fInsertions;
+			int64				fEvictions;
+			int64				fCoverageBuilds;
+};
+
+
+/*!	Wraps another glyph consumer for GlyphLayoutEngine::LayoutGlyphs(), and
+	remembers the glyphs it has been passed.
+*/
+template<class GlyphConsumer>
+class GlyphRunBuilder {
+public:
+	GlyphRunBuilder(GlyphConsumer& consumer)
+		:
+		fConsumer(consumer),
+		fPlacements(NULL),
+		fCount(0),
+		fCapacity(0),
+		fEndX(0.0),
+		fEndY(0.0),
+		fValid(true)
+	{
+	}
+
+	~GlyphRunBuilder()
+	{
+		free(fPlacements);
+	}
+
+	bool NeedsVector()
+	{
+		return fConsumer.NeedsVector();
+	}
+
+	void Start()
+	{
+		fConsumer.Start();
+	}
+
+	void Finish(double x, double y)
+	{
+		fEndX = x;
+		fEndY = y;
+		fConsumer.Finish(x, y);
+	}
+
+	void ConsumeEmptyGlyph(int32 index, uint32 charCode, double x, double y)
+	{
+		fConsumer.ConsumeEmptyGlyph(index, charCode, x, y);
+	}
+
+	bool ConsumeGlyph(int32 index, uint32 charCode, const GlyphCache* glyph,
+		FontCacheEntry* entry, double x, double y, double advanceX,
+		double advanceY)
+	{
+		if (fValid && fCount == fCapacity) {
+			int32 capacity = fCapacity == 0 ? 32 : fCapacity * 2;
+			GlyphPlacement* placements = (GlyphPlacement*)realloc(
+				fPlacements, capacity * sizeof(GlyphPlacement));
+			if (placements != NULL) {
+				fPlacements = placements;
+				fCapacity = capacity;
+			} else
+				fValid = false;
+		}
+		if (fValid) {
+			fPlacements[fCount].glyph = glyph;
+			fPlacements[fCount].x = x;
+			fPlacements[fCount].y = y;
+			fCount++;
+		}
+
+		if (!fConsumer.ConsumeGlyph(index, charCode, glyph, entry, x, y,
+				advanceX, advanceY)) {
+			// the run would not be complete
+			fValid = false;
+			return false;
+		}
+		return true;
+	}
+
+	bool IsValid() const
+	{
+		return fValid;
+	}
+
+	const GlyphPlacement* Placements() const
+	{
+		return fPlacements;
+	}
+
+	int32 CountPlacements() const
+	{
+		return fCount;
+	}
+
+	double EndX() const
+	{
+		return fEndX;
+	}
+
+	double EndY() const
+	{
+		return fEndY;
+	}
+
+private:
+	GlyphConsumer&		fConsumer;
+	GlyphPlacement*		fPlacements;
+	int32				fCount;
+	int32				fCapacity;
+	double				fEndX;
+	double				fEndY;
+	bool				fValid;
+};
+
+
+#endif // GLYPH_RUN_CACHE_H
@@ -1066,6 +1066,136 @@ cache_prefetch(dev_t mountID, ino_t vnodeID, off_t offset, size_t size)
 }
 
 
+/*!	Makes sure that up to \a _size bytes at \a offset of the file are in its
+	cache, and wires the pages holding them, so that their contents can be
+	used without copying them first. \a cookie is the file system's cookie
+	of the file, it is only used for reading.
+	\a _count is the capacity of \a pages on entry, and the number of pages
+	that have been wired on return; \a _size is reduced to the part of the
+	range that these pages cover. The data starts at \a offset % B_PAGE_SIZE
+	in the first page.
+	Returns \c B_UNSUPPORTED if the file does not use a file cache, and
+	\c B_BUSY if no page could be wired right now. On success, the pages and
+	the cache returned in \a _cache must be passed to
+	cache_unwire_vnode_pages() later.
+*/
+extern "C" status_t
+cache_wire_vnode_pages(struct vnode* vnode, void* cookie, off_t offset,
+	size_t* _size, vm_page** pages, uint32* _count, VMCache** _cache)
+{
+	if (offset < 0)
+		return B_BAD_VALUE;
+
+	VMCache* cache;
+	if (vfs_get_vnode_cache(vnode, &cache, false) != B_OK)
+		return B_UNSUPPORTED;
+
+	file_cache_ref* ref = NULL;
+	if (cache->type == CACHE_TYPE_VNODE)
+		ref = ((VMVnodeCache*)cache)->FileCacheRef();
+	if (ref == NULL || ref->disabled_count > 0) {
+		cache->ReleaseRef();
+		return B_UNSUPPORTED;
+	}
+
+	off_t firstPage = ROUNDDOWN(offset, B_PAGE_SIZE);
+	size_t size = min_c(*_size,
+		(size_t)*_count * B_PAGE_SIZE - (size_t)(offset - firstPage));
+	off_t fileSize = cache->virtual_end;
+	if (offset >= fileSize)
+		size = 0;
+	else if ((off_t)(offset + size) > fileSize)
+		size = fileSize - offset;
+
+	if (size == 0) {
+		cache->ReleaseRef();
+		*_size = 0;
+		*_count = 0;
+		return B_OK;
+	}
+
+	// read what is missing into the cache, without copying it anywhere
+	size_t bytesRead = size;
+	status_t status = cache_io(ref, cookie, offset, 0, &bytesRead, false);
+	if (status != B_OK) {
+		cache->ReleaseRef();
+		return status;
+	}
+
+	off_t end = offset + size;
+	uint32 count = 0;
+
+	cache->Lock();
+
+	for (off_t pageOffset = firstPage; pageOffset < end;
+			pageOffset += B_PAGE_SIZE) {
+		// the page might already be gone again, or be in use for I/O
+		vm_page* page = cache->LookupPage(pageOffset);
+		if (page == NULL || page->busy)
+			break;
+
+		DEBUG_PAGE_ACCESS_START(page);
+
+		if (!page->IsMapped())
+			atomic_add(&gMappedPagesCount, 1);
+		page->IncrementWiredCount();
+		page->lent = true;
+
+		// the page daemon must not look at it as an unused page
+		if (page->State() == PAGE_STATE_CACHED
+			|| page->State() == PAGE_STATE_INACTIVE) {
+			vm_page_set_state(page, PAGE_STATE_ACTIVE);
+		}
+
+		DEBUG_PAGE_ACCESS_END(page);
+		pages[count++] = page;
+	}
+
+	if (count == 0) {
+		cache->ReleaseRefAndUnlock();
+		return B_BUSY;
+	}
+
+	cache->Unlock();
+
+	*_size = min_c(end, firstPage + (off_t)count * B_PAGE_SIZE) - offset;
+	*_count = count;
+	*_cache = cache;
+	return B_OK;
+}
+
+
+/*!	Releases the pages wired by cache_wire_vnode_pages(), and the cache.
+	Pages that have been removed from the cache in the mean time, because the
+	file was truncated or deleted, are freed once they are no longer wired.
+*/
+extern "C" void
+cache_unwire_vnode_pages(VMCache* cache, vm_page** pages, uint32 count)
+{
+	cache->Lock();
+
+	for (uint32 i = 0; i < count; i++) {
+		vm_page* page = pages[i];
+		bool removed = page->Cache() != cache;
+
+		DEBUG_PAGE_ACCESS_START(page);
+		page->DecrementWiredCount();
+		if (page->WiredCount() == 0)
+			page->lent = false;
+		if (!page->IsMapped())
+			atomic_add(&gMappedPagesCount, -1);
+
+		if (removed && page->WiredCount() == 0) {
+			vm_page_free(NULL, page);
+			continue;
+		}
+		DEBUG_PAGE_ACCESS_END(page);
+	}
+
+	cache->ReleaseRefAndUnlock();
+}
+
+
 extern "C" void
 cache_node_opened(struct vnode* vnode, VMCache* cache,
 	dev_t mountID, ino_t parentID, ino_t vnodeID, const char* name)
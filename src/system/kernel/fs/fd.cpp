@@ -21,12 +21,15 @@
 #include <BytePointer.h>
 #include <StackOrHeapArray.h>
 
+#include <file_cache.h>
+
 #include <syscalls.h>
 #include <syscall_restart.h>
 #include <slab/Slab.h>
 #include <util/AutoLock.h>
 #include <util/iovec_support.h>
 #include <vfs.h>
+#include <vm/vm.h>
 #include <wait_for_objects.h>
 
 #include "vfs_tracing.h"
@@ -41,6 +44,8 @@
 
 
 static const size_t kMaxReadDirBufferSize = B_PAGE_SIZE * 2;
+static const size_t kCopyBufferSize = 64 * 1024;
+static const uint32 kCopyPageCount = 16;
 
 extern object_cache* sFileDescriptorCache;
 
@@ -830,6 +835,215 @@ common_user_vector_io(int fd, off_t pos, const iovec* userVecs, size_t count,
 }
 
 
+/*!	Reads from or writes to \a descriptor at \a _pos, or at the current
+	position of the descriptor, if \a _pos is \c NULL. The respective
+	position is moved forward by the number of bytes transferred.
+*/
+static status_t
+fd_transfer(file_descriptor* descriptor, off_t* _pos, void* buffer,
+	size_t* _length, bool write)
+{
+	off_t pos = _pos != NULL ? *_pos : descriptor->pos;
+
+	status_t status;
+	if (write)
+		status = descriptor->ops->fd_write(descriptor, pos, buffer, _length);
+	else
+		status = descriptor->ops->fd_read(descriptor, pos, buffer, _length);
+	if (status != B_OK)
+		return status;
+
+	if (_pos != NULL)
+		*_pos += *_length;
+	else if (descriptor->pos != -1) {
+		descriptor->pos = write && (descriptor->open_mode & O_APPEND) != 0
+			? descriptor->ops->fd_seek(descriptor, 0, SEEK_END)
+			: pos + *_length;
+	}
+
+	return B_OK;
+}
+
+
+/*!	Writes the data of \a from to \a to directly out of the file cache of
+	\a from, so that it does not need to be copied into a buffer first.
+	\a _bytesCopied is increased by the number of bytes written.
+	Returns \c B_UNSUPPORTED if the file has no file cache, or \c B_BUSY if
+	its pages cannot be used right now; the rest of the data has to be
+	copied through a buffer then. Otherwise, the copy is done.
+*/
+static status_t
+copy_from_file_cache(file_descriptor* from, off_t* _fromPos,
+	file_descriptor* to, off_t* _toPos, size_t length, size_t& _bytesCopied)
+{
+	struct vnode* vnode = fd_vnode(from);
+
+	while (_bytesCopied < length) {
+		off_t fromPos = _fromPos != NULL ? *_fromPos : from->pos;
+		size_t size = length - _bytesCopied;
+		vm_page* pages[kCopyPageCount];
+		uint32 count = kCopyPageCount;
+		VMCache* cache;
+		status_t status = cache_wire_vnode_pages(vnode, from->cookie,
+			fromPos, &size, pages, &count, &cache);
+		if (status != B_OK)
+			return status;
+		if (count == 0)
+			return B_OK;
+
+		size_t pageOffset = fromPos % B_PAGE_SIZE;
+		size_t bytesLeft = size;
+		for (uint32 i = 0; i < count; i++) {
+			size_t bytes = min_c(bytesLeft, B_PAGE_SIZE - pageOffset);
+
+			addr_t address;
+			void* handle;
+			status = vm_get_physical_page(
+				(phys_addr_t)pages[i]->physical_page_number * B_PAGE_SIZE,
+				&address, &handle);
+			if (status != B_OK) {
+				status = B_BUSY;
+				break;
+			}
+
+			size_t bytesWritten = bytes;
+			status = fd_transfer(to, _toPos, (uint8*)address + pageOffset,
+				&bytesWritten, true);
+			vm_put_physical_page(address, handle);
+			if (status != B_OK)
+				break;
+
+			if (_fromPos != NULL)
+				*_fromPos += bytesWritten;
+			else if (from->pos != -1)
+				from->pos += bytesWritten;
+			_bytesCopied += bytesWritten;
+
+			if (bytesWritten < bytes)
+				break;
+
+			bytesLeft -= bytes;
+			pageOffset = 0;
+		}
+
+		cache_unwire_vnode_pages(cache, pages, count);
+
+		if (status != B_OK)
+			return status;
+		if (bytesLeft > 0) {
+			// the target did not take everything
+			return B_OK;
+		}
+	}
+
+	return B_OK;
+}
+
+
+/*!	Copies up to \a length bytes from one descriptor to another, without
+	the data ever leaving the kernel. When \a from is a file, the data is
+	taken straight from its file cache. The positions are handled as with
+	fd_transfer().
+	Returns the number of bytes copied, or an error, if nothing could be
+	copied.
+*/
+ssize_t
+fd_copy_data(file_descriptor* from, off_t* _fromPos, file_descriptor* to,
+	off_t* _toPos, size_t length)
+{
+	if ((from->open_mode & O_RWMASK) == O_WRONLY
+		|| (to->open_mode & O_RWMASK) == O_RDONLY)
+		return B_FILE_ERROR;
+	if (from->ops->fd_read == NULL || to->ops->fd_write == NULL)
+		return B_BAD_VALUE;
+
+	if (length == 0)
+		return 0;
+	if (length > SSIZE_MAX)
+		length = SSIZE_MAX;
+
+	status_t status = B_OK;
+	size_t bytesCopied = 0;
+
+	if (fd_is_file(from)) {
+		status = copy_from_file_cache(from, _fromPos, to, _toPos, length,
+			bytesCopied);
+		if (status != B_UNSUPPORTED && status != B_BUSY) {
+			if (bytesCopied == 0 && status != B_OK)
+				return status;
+			return bytesCopied;
+		}
+		status = B_OK;
+	}
+
+	size_t bufferSize = min_c(length - bytesCopied, kCopyBufferSize);
+	MemoryDeleter buffer(malloc(bufferSize));
+	if (!buffer.IsSet())
+		return bytesCopied > 0 ? (ssize_t)bytesCopied : B_NO_MEMORY;
+
+	while (bytesCopied < length) {
+		size_t bytesRead = min_c(length - bytesCopied, bufferSize);
+		status = fd_transfer(from, _fromPos, buffer.Get(), &bytesRead, false);
+		if (status != B_OK || bytesRead == 0)
+			break;
+
+		size_t bytesWritten = bytesRead;
+		status = fd_transfer(to, _toPos, buffer.Get(), &bytesWritten, true);
+		if (status != B_OK)
+			bytesWritten = 0;
+
+		bytesCopied += bytesWritten;
+
+		if (bytesWritten < bytesRead) {
+			// give back what could not be written
+			off_t unwritten = bytesRead - bytesWritten;
+			if (_fromPos != NULL)
+				*_fromPos -= unwritten;
+			else if (from->pos != -1)
+				from->pos -= unwritten;
+			break;
+		}
+	}
+
+	if (bytesCopied == 0 && status != B_OK)
+		return status;
+
+	return bytesCopied;
+}
+
+
+static ssize_t
+common_copy_file_range(int fromFD, off_t* _fromPos, int toFD, off_t* _toPos,
+	size_t length, uint32 flags, bool kernel)
+{
+	if (flags != 0)
+		return B_BAD_VALUE;
+
+	io_context* context = get_current_io_context(kernel);
+	FileDescriptorPutter from(get_fd(context, fromFD));
+	FileDescriptorPutter to(get_fd(context, toFD));
+	if (!from.IsSet() || !to.IsSet())
+		return B_FILE_ERROR;
+
+	if (!fd_is_file(from.Get()) || !fd_is_file(to.Get()))
+		return B_BAD_VALUE;
+	if ((to->open_mode & O_APPEND) != 0)
+		return B_FILE_ERROR;
+
+	off_t fromPos = _fromPos != NULL ? *_fromPos : from->pos;
+	off_t toPos = _toPos != NULL ? *_toPos : to->pos;
+	if (fromPos < 0 || toPos < 0)
+		return B_BAD_VALUE;
+
+	// the ranges within the same file must not overlap
+	if (fd_vnode(from.Get()) == fd_vnode(to.Get())
+		&& fromPos < toPos + (off_t)length && toPos < fromPos + (off_t)length)
+		return B_BAD_VALUE;
+
+	return fd_copy_data(from.Get(), _fromPos, to.Get(), _toPos, length);
+}
+
+
 static status_t
 common_close(int fd, bool kernel)
 {
@@ -1012,6 +1226,40 @@ _user_dup2(int ofd, int nfd, int flags)
 }
 
 
+ssize_t
+_user_copy_file_range(int fromFD, off_t* userFromPos, int toFD,
+	off_t* userToPos, size_t length, uint32 flags)
+{
+	off_t fromPos;
+	off_t toPos;
+	if (userFromPos != NULL) {
+		if (!IS_USER_ADDRESS(userFromPos)
+			|| user_memcpy(&fromPos, userFromPos, sizeof(off_t)) != B_OK)
+			return B_BAD_ADDRESS;
+	}
+	if (userToPos != NULL) {
+		if (!IS_USER_ADDRESS(userToPos)
+			|| user_memcpy(&toPos, userToPos, sizeof(off_t)) != B_OK)
+			return B_BAD_ADDRESS;
+	}
+
+	SyscallRestartWrapper<ssize_t> result;
+	result = common_copy_file_range(fromFD,
+		userFromPos != NULL ? &fromPos : NULL, toFD,
+		userToPos != NULL ? &toPos : NULL, length, flags, false);
+
+	if (result > 0) {
+		if ((userFromPos != NULL
+				&& user_memcpy(userFromPos, &fromPos, sizeof(off_t)) != B_OK)
+			|| (userToPos != NULL
+				&& user_memcpy(userToPos, &toPos, sizeof(off_t)) != B_OK))
+			return B_BAD_ADDRESS;
+	}
+
+	return result;
+}
+
+
 //	#pragma mark - Kernel calls
 
 
@@ -1203,3 +1451,12 @@ _kern_dup2(int ofd, int nfd, int flags)
 	return dup2_fd(ofd, nfd, flags, true);
 }
 
+
+ssize_t
+_kern_copy_file_range(int fromFD, off_t* _fromPos, int toFD, off_t* _toPos,
+	size_t length, uint32 flags)
+{
+	return common_copy_file_range(fromFD, _fromPos, toFD, _toPos, length,
+		flags, true);
+}
+
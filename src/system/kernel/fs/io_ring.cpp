@@ -0,0 +1,1241 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	I/O rings: a team submits I/O operations through a queue in memory that
+	it shares with the kernel, and gets their results through a second one.
+
+	Reads and writes at an offset on devices that support asynchronous I/O
+	are passed on as IORequests, and are completed from their finished
+	callback. Other vnode I/O -- file system I/O, which has to go through the
+	file cache, and fsync() -- is done by a small pool of kernel threads that
+	run in the team, and use the same functions as the respective syscalls.
+
+	Socket operations, and reads and writes on descriptors that are not
+	vnodes, never block a thread. They select their descriptor, and a single
+	thread per ring does the non-blocking call once it has been notified that
+	the descriptor is ready. A send is repeated until all of its data has
+	been sent, unless MSG_DONTWAIT was given. accept() cannot be asked not to
+	block, so it is only called once a connection is waiting. If another
+	thread takes that connection first, the socket thread blocks in it, just
+	like a select() loop would, unless the listening socket is non-blocking.
+
+	No operation is started with the ring's lock held, as an IORequest might
+	complete right away.
+
+	With IO_RING_SQ_POLL, another such thread looks for new submissions by
+	itself, so that a busy team needs no syscall at all. When there was
+	nothing to do for a while, it sets IO_RING_SQ_NEED_WAKEUP, and waits for
+	_kern_io_ring_enter() with IO_RING_ENTER_SQ_WAKEUP.
+
+	The kernel only trusts its own copies of the queue positions. It never
+	starts more operations than the completion queue has room for, so that
+	no completion ever gets lost.
+*/
+
+
+#include <io_ring.h>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include <new>
+
+#include <AutoDeleterDrivers.h>
+#include <Referenceable.h>
+
+#include <condition_variable.h>
+#include <fs/fd.h>
+#include <kernel.h>
+#include <ksignal.h>
+#include <lock.h>
+#include <syscall_restart.h>
+#include <team.h>
+#include <thread.h>
+#include <util/AutoLock.h>
+#include <util/DoublyLinkedList.h>
+#include <vfs.h>
+#include <vm/vm.h>
+#include <wait_for_objects.h>
+
+#include "IORequest.h"
+#include "select_sync.h"
+#include "Vnode.h"
+
+
+//#define TRACE_IO_RING
+#ifdef TRACE_IO_RING
+#	define TRACE(x...) dprintf("io_ring: " x)
+#else
+#	define TRACE(x...) do {} while (false)
+#endif
+
+
+static const int32 kMaxWorkers = 16;
+static const int32 kMaxThreads = kMaxWorkers + 2;
+	// the workers, the polling thread, and the socket thread
+static const bigtime_t kWorkerIdleTimeout = 2000000;
+static const bigtime_t kPollIdleTime = 2000;
+	// how long the polling thread keeps looking for new submissions, before
+	// it goes to sleep
+
+
+class IORing;
+
+
+/*!	An operation taken from the submission queue. While a socket operation
+	waits for its socket to become ready, it is selected as its own
+	select_sync, so that it stays around as long as it might be notified.
+*/
+struct io_ring_operation : select_sync, select_info,
+		DoublyLinkedListLinkImpl<io_ring_operation> {
+	enum SocketState {
+		kSocketIdle = 0,
+		kSocketQueued,
+			// in IORing::fSocketOperations, waiting for the socket thread
+		kSocketWaiting,
+			// in IORing::fWaitingSocketOperations, waiting for the socket
+		kSocketRunning,
+		kSocketDone
+	};
+
+								io_ring_operation(IORing* ring,
+									const io_ring_sqe& sqe);
+	virtual						~io_ring_operation();
+
+	virtual	status_t			Notify(select_info* info, uint16 events);
+
+			IORing*				ring;
+			io_ring_sqe			sqe;
+			file_descriptor*	descriptor;
+				// the descriptor, if the operation is done by an IORequest
+			SocketState			socket_state;
+			bool				selected;
+			size_t				transferred;
+};
+
+typedef DoublyLinkedList<io_ring_operation> OperationList;
+
+
+class IORing : public BReferenceable {
+public:
+								IORing(uint32 flags);
+								~IORing();
+
+			status_t			Init(uint32 entries, void** _address);
+			void				Close();
+
+			ssize_t				Enter(uint32 toSubmit, uint32 minComplete,
+									uint32 flags, uint32 timeoutFlags,
+									bigtime_t timeout);
+
+			void				SocketNotified(io_ring_operation* operation,
+									uint16 events);
+
+private:
+			ssize_t				_Submit(MutexLocker& locker, uint32 count);
+			void				_Start(io_ring_operation* operation);
+			bool				_StartRequest(io_ring_operation* operation,
+									file_descriptor* descriptor);
+			void				_QueueForWorker(io_ring_operation* operation);
+			void				_QueueForSocket(io_ring_operation* operation);
+			status_t			_WaitForSocket(io_ring_operation* operation);
+			void				_SocketReady(io_ring_operation* operation,
+									uint16 events);
+			void				_Complete(uint64 userData, int64 result);
+			status_t			_WaitForCompletions(uint32 count,
+									uint32 timeoutFlags, bigtime_t timeout);
+
+			status_t			_SpawnThread(thread_func function,
+									const char* name, int32 priority);
+			void				_ThreadExited();
+			bool				_ShouldExit() const;
+
+	static	void				_RequestFinished(void* data,
+									io_request* request, status_t status,
+									bool partialTransfer,
+									generic_size_t transferredBytes);
+	static	int64				_Execute(const io_ring_sqe& sqe);
+	static	bool				_ExecuteSocket(io_ring_operation* operation,
+									int64& _result);
+
+	static	status_t			_WorkerThread(void* data);
+	static	status_t			_PollThread(void* data);
+	static	status_t			_SocketThread(void* data);
+			void				_Work();
+			void				_Poll();
+			void				_HandleSockets();
+
+private:
+			uint32				fFlags;
+			team_id				fTeam;
+			area_id				fArea;
+			area_id				fUserArea;
+			io_ring_header*		fHeader;
+			io_ring_sqe*		fSubmissions;
+			io_ring_cqe*		fCompletions;
+			uint32				fSubmissionCount;
+			uint32				fCompletionCount;
+
+			mutex				fLock;
+				// guards the submission side, and all below
+			uint32				fSubmissionHead;
+			OperationList		fPendingOperations;
+			int32				fPendingCount;
+			ConditionVariable	fWorkCondition;
+			ConditionVariable	fPollCondition;
+			thread_id			fThreads[kMaxThreads];
+			int32				fWorkerCount;
+			int32				fIdleWorkers;
+			bool				fHasSocketThread;
+			bool				fClosed;
+
+			spinlock			fSocketLock;
+				// guards the socket operation lists, and their states
+			OperationList		fSocketOperations;
+			OperationList		fWaitingSocketOperations;
+			ConditionVariable	fSocketCondition;
+
+			spinlock			fCompletionLock;
+			uint32				fCompletionTail;
+			int32				fInFlight;
+			ConditionVariable	fCompletionCondition;
+};
+
+
+io_ring_operation::io_ring_operation(IORing* ring, const io_ring_sqe& sqe)
+	:
+	ring(ring),
+	sqe(sqe),
+	descriptor(NULL),
+	socket_state(kSocketIdle),
+	selected(false),
+	transferred(0)
+{
+	next = NULL;
+	sync = this;
+	events = 0;
+	selected_events = 0;
+
+	ring->AcquireReference();
+}
+
+
+io_ring_operation::~io_ring_operation()
+{
+	ring->ReleaseReference();
+}
+
+
+status_t
+io_ring_operation::Notify(select_info* info, uint16 events)
+{
+	ring->SocketNotified(this, events);
+	return B_OK;
+}
+
+
+//	#pragma mark - IORing
+
+
+IORing::IORing(uint32 flags)
+	:
+	fFlags(flags),
+	fTeam(team_get_current_team_id()),
+	fArea(-1),
+	fUserArea(-1),
+	fHeader(NULL),
+	fSubmissions(NULL),
+	fCompletions(NULL),
+	fSubmissionCount(0),
+	fCompletionCount(0),
+	fSubmissionHead(0),
+	fPendingCount(0),
+	fWorkerCount(0),
+	fIdleWorkers(0),
+	fHasSocketThread(false),
+	fClosed(false),
+	fCompletionTail(0),
+	fInFlight(0)
+{
+	mutex_init(&fLock, "io ring");
+	B_INITIALIZE_SPINLOCK(&fSocketLock);
+	B_INITIALIZE_SPINLOCK(&fCompletionLock);
+	fWorkCondition.Init(this, "io ring work");
+	fPollCondition.Init(this, "io ring poll");
+	fSocketCondition.Init(this, "io ring sockets");
+	fCompletionCondition.Init(this, "io ring completion");
+
+	for (int32 i = 0; i < kMaxThreads; i++)
+		fThreads[i] = -1;
+}
+
+
+IORing::~IORing()
+{
+	ASSERT(fClosed && fInFlight == 0 && fPendingOperations.IsEmpty()
+		&& fSocketOperations.IsEmpty() && fWaitingSocketOperations.IsEmpty());
+
+	if (fUserArea >= 0)
+		vm_delete_area(fTeam, fUserArea, true);
+	if (fArea >= 0)
+		delete_area(fArea);
+
+	mutex_destroy(&fLock);
+}
+
+
+status_t
+IORing::Init(uint32 entries, void** _address)
+{
+	if (entries == 0 || entries > IO_RING_MAX_ENTRIES)
+		return B_BAD_VALUE;
+
+	fSubmissionCount = 1;
+	while (fSubmissionCount < entries)
+		fSubmissionCount <<= 1;
+	fCompletionCount = fSubmissionCount * 2;
+
+	size_t submissionSize = ROUNDUP(fSubmissionCount * sizeof(io_ring_sqe),
+		B_PAGE_SIZE);
+	size_t size = B_PAGE_SIZE + submissionSize
+		+ ROUNDUP(fCompletionCount * sizeof(io_ring_cqe), B_PAGE_SIZE);
+
+	void* address;
+	fArea = create_area("io ring", &address, B_ANY_KERNEL_ADDRESS, size,
+		B_FULL_LOCK, B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA);
+	if (fArea < 0)
+		return fArea;
+
+	fHeader = (io_ring_header*)address;
+	fHeader->magic = IO_RING_MAGIC;
+	fHeader->sq_entries = fSubmissionCount;
+	fHeader->cq_entries = fCompletionCount;
+	fHeader->sq_offset = B_PAGE_SIZE;
+	fHeader->cq_offset = B_PAGE_SIZE + submissionSize;
+
+	fSubmissions = (io_ring_sqe*)((uint8*)address + fHeader->sq_offset);
+	fCompletions = (io_ring_cqe*)((uint8*)address + fHeader->cq_offset);
+
+	// the team must not be able to delete or resize the area
+	*_address = NULL;
+	fUserArea = vm_clone_area(fTeam, "io ring", _address, B_ANY_ADDRESS,
+		B_READ_AREA | B_WRITE_AREA | B_KERNEL_AREA, REGION_NO_PRIVATE_MAP,
+		fArea, true);
+	if (fUserArea < 0)
+		return fUserArea;
+
+	if ((fFlags & IO_RING_SQ_POLL) != 0) {
+		MutexLocker locker(fLock);
+		status_t status = _SpawnThread(&_PollThread, "io ring poller",
+			B_NORMAL_PRIORITY);
+		if (status != B_OK)
+			return status;
+	}
+
+	return B_OK;
+}
+
+
+/*!	Called when the file descriptor of the ring is closed. Operations that
+	were not started yet are dropped, and blocking operations in progress are
+	interrupted.
+*/
+void
+IORing::Close()
+{
+	MutexLocker locker(fLock);
+
+	fClosed = true;
+
+	while (io_ring_operation* operation = fPendingOperations.RemoveHead()) {
+		atomic_add(&fInFlight, -1);
+		operation->ReleaseReference();
+	}
+	fPendingCount = 0;
+
+	// The threads clear their slot while holding the lock, so the IDs
+	// cannot be stale. The socket thread drops its operations when it exits.
+	for (int32 i = 0; i < kMaxThreads; i++) {
+		if (fThreads[i] >= 0)
+			send_signal_etc(fThreads[i], SIGKILLTHR, B_DO_NOT_RESCHEDULE);
+	}
+
+	fWorkCondition.NotifyAll(B_INTERRUPTED);
+	fPollCondition.NotifyAll(B_INTERRUPTED);
+	fSocketCondition.NotifyAll(B_INTERRUPTED);
+}
+
+
+ssize_t
+IORing::Enter(uint32 toSubmit, uint32 minComplete, uint32 flags,
+	uint32 timeoutFlags, bigtime_t timeout)
+{
+	// the ring only works in the team that created it, and not in a forked
+	// child that inherited the descriptor
+	if (team_get_current_team_id() != fTeam)
+		return B_NOT_ALLOWED;
+
+	ssize_t submitted = 0;
+
+	MutexLocker locker(fLock);
+	if (fClosed)
+		return B_FILE_ERROR;
+
+	if ((fFlags & IO_RING_SQ_POLL) != 0) {
+		if ((flags & IO_RING_ENTER_SQ_WAKEUP) != 0)
+			fPollCondition.NotifyAll();
+	} else if (toSubmit > 0) {
+		submitted = _Submit(locker, toSubmit);
+		if (submitted < 0)
+			return submitted;
+	}
+
+	locker.Unlock();
+
+	if ((flags & IO_RING_ENTER_GET_EVENTS) != 0 && minComplete > 0) {
+		status_t status = _WaitForCompletions(minComplete, timeoutFlags,
+			timeout);
+		if (status != B_OK && submitted == 0)
+			return status;
+	}
+
+	return submitted;
+}
+
+
+/*!	Takes up to \a count new entries from the submission queue, and starts
+	them. Must be called with the lock held; it is released while the
+	operations are started.
+*/
+ssize_t
+IORing::_Submit(MutexLocker& locker, uint32 count)
+{
+	uint32 tail = (uint32)atomic_get((int32*)&fHeader->sq_tail);
+	uint32 available = tail - fSubmissionHead;
+	if (available > fSubmissionCount)
+		return B_BAD_DATA;
+
+	if (count > available)
+		count = available;
+
+	OperationList operations;
+
+	uint32 submitted = 0;
+	for (; submitted < count; submitted++) {
+		// Don't start more operations than the completion queue has room
+		// for. A nonsensical head makes the queue look full.
+		uint32 completed = (uint32)atomic_get((int32*)&fCompletionTail)
+			- (uint32)atomic_get((int32*)&fHeader->cq_head);
+		if (completed > fCompletionCount
+			|| completed + (uint32)atomic_get(&fInFlight) >= fCompletionCount) {
+			break;
+		}
+
+		io_ring_sqe sqe;
+		memcpy(&sqe, &fSubmissions[fSubmissionHead & (fSubmissionCount - 1)],
+			sizeof(io_ring_sqe));
+		fSubmissionHead++;
+
+		atomic_add(&fInFlight, 1);
+
+		io_ring_operation* operation
+			= new(std::nothrow) io_ring_operation(this, sqe);
+		if (operation == NULL) {
+			_Complete(sqe.user_data, B_NO_MEMORY);
+			continue;
+		}
+
+		operations.Add(operation);
+	}
+
+	atomic_set((int32*)&fHeader->sq_head, fSubmissionHead);
+
+	if (operations.IsEmpty())
+		return submitted;
+
+	locker.Unlock();
+
+	while (io_ring_operation* operation = operations.RemoveHead())
+		_Start(operation);
+
+	locker.Lock();
+	return submitted;
+}
+
+
+/*!	Starts an operation. Must be called without the lock held. */
+void
+IORing::_Start(io_ring_operation* operation)
+{
+	const io_ring_sqe& sqe = operation->sqe;
+
+	TRACE("%p: start opcode %u, fd %" B_PRId32 ", offset %" B_PRIdOFF
+		", length %" B_PRIu32 "\n", this, sqe.opcode, sqe.fd, sqe.offset,
+		sqe.length);
+
+	status_t status = B_OK;
+
+	switch (sqe.opcode) {
+		case IO_RING_OP_NOP:
+			break;
+
+		case IO_RING_OP_READ:
+		case IO_RING_OP_WRITE:
+		case IO_RING_OP_SEND:
+		case IO_RING_OP_RECV:
+			if (!is_user_address_range((void*)(addr_t)sqe.address,
+					sqe.length)) {
+				status = B_BAD_ADDRESS;
+			}
+			break;
+
+		case IO_RING_OP_FSYNC:
+		case IO_RING_OP_ACCEPT:
+			break;
+
+		default:
+			status = B_BAD_VALUE;
+			break;
+	}
+
+	if (status != B_OK || sqe.opcode == IO_RING_OP_NOP) {
+		_Complete(sqe.user_data, status);
+		operation->ReleaseReference();
+		return;
+	}
+
+	switch (sqe.opcode) {
+		case IO_RING_OP_SEND:
+		case IO_RING_OP_RECV:
+		case IO_RING_OP_ACCEPT:
+			_QueueForSocket(operation);
+			return;
+
+		case IO_RING_OP_READ:
+		case IO_RING_OP_WRITE:
+		{
+			file_descriptor* descriptor = get_fd(
+				get_current_io_context(false), sqe.fd);
+			if (descriptor == NULL)
+				break;
+
+			if (fd_vnode(descriptor) == NULL) {
+				// most likely a socket
+				put_fd(descriptor);
+				_QueueForSocket(operation);
+				return;
+			}
+
+			if (sqe.offset >= 0 && _StartRequest(operation, descriptor))
+				return;
+
+			put_fd(descriptor);
+			break;
+		}
+	}
+
+	_QueueForWorker(operation);
+}
+
+
+/*!	Starts a read or write on a device as an IORequest, if the device
+	supports that. Files are left to the workers, since an IORequest would
+	bypass the file cache.
+	On success, the operation owns the reference to \a descriptor.
+*/
+bool
+IORing::_StartRequest(io_ring_operation* operation,
+	file_descriptor* descriptor)
+{
+	const io_ring_sqe& sqe = operation->sqe;
+	bool write = sqe.opcode == IO_RING_OP_WRITE;
+
+	int accessMode = descriptor->open_mode & O_RWMASK;
+	if (!fd_is_file(descriptor) || !S_ISCHR(descriptor->u.vnode->Type())
+		|| accessMode == (write ? O_RDONLY : O_WRONLY)) {
+		// leave it to the worker to deal with, including reporting the error
+		return false;
+	}
+
+	IORequest* request = IORequest::Create(false);
+	if (request == NULL)
+		return false;
+
+	status_t status = request->Init(sqe.offset, (generic_addr_t)sqe.address,
+		sqe.length, write, B_DELETE_IO_REQUEST);
+	if (status != B_OK) {
+		delete request;
+		return false;
+	}
+
+	operation->descriptor = descriptor;
+	request->SetFinishedCallback(&_RequestFinished, operation);
+
+	status = vfs_asynchronous_vnode_io(descriptor->u.vnode,
+		descriptor->cookie, request);
+	if (status == B_UNSUPPORTED) {
+		// the device can only do synchronous I/O -- the request is still
+		// untouched
+		operation->descriptor = NULL;
+		delete request;
+		return false;
+	}
+
+	// any other error has been reported through the callback already
+	return true;
+}
+
+
+/*!	Hands an operation over to the workers, and starts another one if none
+	is idle. Must be called without the lock held.
+*/
+void
+IORing::_QueueForWorker(io_ring_operation* operation)
+{
+	MutexLocker locker(fLock);
+
+	if (fClosed) {
+		atomic_add(&fInFlight, -1);
+		operation->ReleaseReference();
+		return;
+	}
+
+	fPendingOperations.Add(operation);
+	fPendingCount++;
+
+	if (fPendingCount > fIdleWorkers && fWorkerCount < kMaxWorkers
+		&& _SpawnThread(&_WorkerThread, "io ring worker", B_NORMAL_PRIORITY)
+			== B_OK) {
+		return;
+	}
+
+	if (fWorkerCount == 0) {
+		// we could not get a single worker
+		fPendingOperations.Remove(operation);
+		fPendingCount--;
+		locker.Unlock();
+
+		_Complete(operation->sqe.user_data, B_NO_MORE_THREADS);
+		operation->ReleaseReference();
+		return;
+	}
+
+	fWorkCondition.NotifyOne();
+}
+
+
+/*!	Hands an operation over to the socket thread, and starts that if needed.
+	Must be called without the lock held.
+*/
+void
+IORing::_QueueForSocket(io_ring_operation* operation)
+{
+	MutexLocker locker(fLock);
+
+	if (fClosed) {
+		atomic_add(&fInFlight, -1);
+		operation->ReleaseReference();
+		return;
+	}
+
+	if (!fHasSocketThread) {
+		status_t status = _SpawnThread(&_SocketThread, "io ring sockets",
+			B_NORMAL_PRIORITY);
+		if (status != B_OK) {
+			locker.Unlock();
+
+			_Complete(operation->sqe.user_data, status);
+			operation->ReleaseReference();
+			return;
+		}
+		fHasSocketThread = true;
+	}
+
+	InterruptsSpinLocker socketLocker(fSocketLock);
+	operation->socket_state = io_ring_operation::kSocketQueued;
+	fSocketOperations.Add(operation);
+	fSocketCondition.NotifyOne();
+}
+
+
+/*!	Selects the socket of the operation, which is then queued again as soon
+	as it is ready. Must only be called by the socket thread.
+*/
+status_t
+IORing::_WaitForSocket(io_ring_operation* operation)
+{
+	const io_ring_sqe& sqe = operation->sqe;
+	uint16 event = sqe.opcode == IO_RING_OP_SEND
+		|| sqe.opcode == IO_RING_OP_WRITE ? B_EVENT_WRITE : B_EVENT_READ;
+
+	operation->events = 0;
+	operation->selected_events = event | B_EVENT_ERROR | B_EVENT_INVALID;
+
+	InterruptsSpinLocker locker(fSocketLock);
+	operation->socket_state = io_ring_operation::kSocketWaiting;
+	fWaitingSocketOperations.Add(operation);
+	locker.Unlock();
+
+	// This might notify us right away.
+	status_t status = select_fd(sqe.fd, operation, false);
+	if (status == B_OK) {
+		operation->selected = true;
+		return B_OK;
+	}
+
+	locker.Lock();
+
+	if (status == B_UNSUPPORTED) {
+		// The descriptor cannot tell, so just try again; the call fails if
+		// it is not a socket.
+		_SocketReady(operation, event);
+		return B_OK;
+	}
+
+	if (operation->socket_state == io_ring_operation::kSocketWaiting)
+		fWaitingSocketOperations.Remove(operation);
+	else
+		fSocketOperations.Remove(operation);
+	operation->socket_state = io_ring_operation::kSocketRunning;
+	return status;
+}
+
+
+/*!	Called when the socket of a waiting operation is ready, or has been
+	closed. May be called in any context.
+*/
+void
+IORing::SocketNotified(io_ring_operation* operation, uint16 events)
+{
+	InterruptsSpinLocker locker(fSocketLock);
+	_SocketReady(operation, events);
+}
+
+
+/*!	Queues a waiting operation for the socket thread again. Must be called
+	with the socket lock held.
+*/
+void
+IORing::_SocketReady(io_ring_operation* operation, uint16 events)
+{
+	operation->events |= events;
+
+	if (operation->socket_state != io_ring_operation::kSocketWaiting)
+		return;
+
+	fWaitingSocketOperations.Remove(operation);
+	fSocketOperations.Add(operation);
+	operation->socket_state = io_ring_operation::kSocketQueued;
+	fSocketCondition.NotifyOne();
+}
+
+
+/*!	Adds a completion entry. May be called in any context. */
+void
+IORing::_Complete(uint64 userData, int64 result)
+{
+	TRACE("%p: complete %" B_PRIu64 ": %" B_PRId64 "\n", this, userData,
+		result);
+
+	InterruptsSpinLocker locker(fCompletionLock);
+
+	io_ring_cqe* completion
+		= &fCompletions[fCompletionTail & (fCompletionCount - 1)];
+	completion->user_data = userData;
+	completion->result = result;
+
+	fCompletionTail++;
+	atomic_set((int32*)&fHeader->cq_tail, fCompletionTail);
+	atomic_add(&fInFlight, -1);
+
+	fCompletionCondition.NotifyAll();
+}
+
+
+status_t
+IORing::_WaitForCompletions(uint32 count, uint32 timeoutFlags,
+	bigtime_t timeout)
+{
+	uint32 flags = B_CAN_INTERRUPT;
+	if (timeout != B_INFINITE_TIMEOUT)
+		flags |= timeoutFlags;
+
+	while (true) {
+		ConditionVariableEntry entry;
+
+		InterruptsSpinLocker locker(fCompletionLock);
+
+		uint32 completed = fCompletionTail
+			- (uint32)atomic_get((int32*)&fHeader->cq_head);
+		if (completed > fCompletionCount)
+			return B_BAD_DATA;
+
+		// don't wait for more than can ever arrive
+		uint32 possible = completed + (uint32)atomic_get(&fInFlight);
+		if ((fFlags & IO_RING_SQ_POLL) != 0) {
+			// the polling thread will pick these up soon
+			uint32 queued = (uint32)atomic_get((int32*)&fHeader->sq_tail)
+				- (uint32)atomic_get((int32*)&fSubmissionHead);
+			if (queued <= fSubmissionCount)
+				possible += queued;
+		}
+		if (completed >= count || completed >= possible)
+			return B_OK;
+
+		fCompletionCondition.Add(&entry);
+		locker.Unlock();
+
+		status_t status = entry.Wait(flags, timeout);
+		if (status != B_OK)
+			return status;
+	}
+}
+
+
+/*!	Starts a worker or the polling thread in the team of the ring. Must be
+	called with the lock held.
+*/
+status_t
+IORing::_SpawnThread(thread_func function, const char* name, int32 priority)
+{
+	int32 slot = 0;
+	while (fThreads[slot] >= 0) {
+		if (++slot == kMaxThreads)
+			return B_NO_MORE_THREADS;
+	}
+
+	thread_id thread = spawn_kernel_thread_etc(function, name, priority, this,
+		fTeam);
+	if (thread < 0)
+		return thread;
+
+	fThreads[slot] = thread;
+	if (function == &_WorkerThread)
+		fWorkerCount++;
+
+	AcquireReference();
+	resume_thread(thread);
+	return B_OK;
+}
+
+
+/*!	Must be called with the lock held. */
+void
+IORing::_ThreadExited()
+{
+	thread_id self = find_thread(NULL);
+	for (int32 i = 0; i < kMaxThreads; i++) {
+		if (fThreads[i] == self) {
+			fThreads[i] = -1;
+			break;
+		}
+	}
+}
+
+
+bool
+IORing::_ShouldExit() const
+{
+	return fClosed
+		|| (thread_get_current_thread()->AllPendingSignals() & KILL_SIGNALS)
+			!= 0;
+}
+
+
+/*static*/ void
+IORing::_RequestFinished(void* data, io_request* request, status_t status,
+	bool partialTransfer, generic_size_t transferredBytes)
+{
+	io_ring_operation* operation = (io_ring_operation*)data;
+
+	put_fd(operation->descriptor);
+
+	operation->ring->_Complete(operation->sqe.user_data,
+		status != B_OK && transferredBytes == 0
+			? (int64)status : (int64)transferredBytes);
+
+	operation->ReleaseReference();
+}
+
+
+/*!	Does a blocking operation in a worker thread, which belongs to the team
+	of the ring, so that the syscall implementations do just the right thing.
+*/
+/*static*/ int64
+IORing::_Execute(const io_ring_sqe& sqe)
+{
+	void* buffer = (void*)(addr_t)sqe.address;
+
+	switch (sqe.opcode) {
+		case IO_RING_OP_READ:
+			return _user_read(sqe.fd, sqe.offset, buffer, sqe.length);
+		case IO_RING_OP_WRITE:
+			return _user_write(sqe.fd, sqe.offset, buffer, sqe.length);
+		case IO_RING_OP_FSYNC:
+			return _user_fsync(sqe.fd);
+	}
+
+	return B_BAD_VALUE;
+}
+
+
+/*!	Does a socket operation without blocking. Returns \c false if the
+	socket has to become ready first.
+*/
+/*static*/ bool
+IORing::_ExecuteSocket(io_ring_operation* operation, int64& _result)
+{
+	const io_ring_sqe& sqe = operation->sqe;
+	uint8* buffer = (uint8*)(addr_t)sqe.address;
+
+	// plain reads and writes end up here for descriptors that are not vnodes
+	int flags = 0;
+	if (sqe.opcode == IO_RING_OP_SEND || sqe.opcode == IO_RING_OP_RECV)
+		flags = sqe.op_flags;
+	bool wait = (flags & MSG_DONTWAIT) == 0;
+
+	switch (sqe.opcode) {
+		case IO_RING_OP_RECV:
+		case IO_RING_OP_READ:
+			_result = _user_recv(sqe.fd, buffer, sqe.length,
+				flags | MSG_DONTWAIT);
+			return _result != B_WOULD_BLOCK || !wait;
+
+		case IO_RING_OP_SEND:
+		case IO_RING_OP_WRITE:
+		{
+			ssize_t bytes = _user_send(sqe.fd,
+				buffer + operation->transferred,
+				sqe.length - operation->transferred, flags | MSG_DONTWAIT);
+			if (!wait) {
+				_result = bytes;
+				return true;
+			}
+
+			if (bytes > 0)
+				operation->transferred += bytes;
+			if ((bytes >= 0 && operation->transferred < sqe.length)
+				|| bytes == B_WOULD_BLOCK) {
+				return false;
+			}
+
+			_result = bytes < 0 && operation->transferred == 0
+				? (int64)bytes : (int64)operation->transferred;
+			return true;
+		}
+
+		case IO_RING_OP_ACCEPT:
+			if (operation->events == 0)
+				return false;
+
+			_result = _user_accept(sqe.fd, NULL, NULL, sqe.op_flags);
+			return true;
+	}
+
+	_result = B_BAD_VALUE;
+	return true;
+}
+
+
+/*static*/ status_t
+IORing::_WorkerThread(void* data)
+{
+	IORing* ring = (IORing*)data;
+	ring->_Work();
+	ring->ReleaseReference();
+	return B_OK;
+}
+
+
+/*static*/ status_t
+IORing::_PollThread(void* data)
+{
+	IORing* ring = (IORing*)data;
+	ring->_Poll();
+	ring->ReleaseReference();
+	return B_OK;
+}
+
+
+/*static*/ status_t
+IORing::_SocketThread(void* data)
+{
+	IORing* ring = (IORing*)data;
+	ring->_HandleSockets();
+	ring->ReleaseReference();
+	return B_OK;
+}
+
+
+void
+IORing::_Work()
+{
+	// only the kill signals must interrupt us
+	sigset_t blockedSignals = ~(sigset_t)0;
+	sigprocmask(SIG_SETMASK, &blockedSignals, NULL);
+
+	MutexLocker locker(fLock);
+
+	while (!_ShouldExit()) {
+		io_ring_operation* operation = fPendingOperations.RemoveHead();
+		if (operation == NULL) {
+			fIdleWorkers++;
+			status_t status = fWorkCondition.Wait(&fLock,
+				B_CAN_INTERRUPT | B_RELATIVE_TIMEOUT, kWorkerIdleTimeout);
+			fIdleWorkers--;
+
+			if (status == B_TIMED_OUT && fPendingOperations.IsEmpty())
+				break;
+			continue;
+		}
+
+		fPendingCount--;
+		locker.Unlock();
+
+		int64 result = _Execute(operation->sqe);
+		if (!_ShouldExit())
+			_Complete(operation->sqe.user_data, result);
+		else
+			atomic_add(&fInFlight, -1);
+		operation->ReleaseReference();
+
+		locker.Lock();
+	}
+
+	fWorkerCount--;
+	_ThreadExited();
+
+	if (fWorkerCount == 0 && !fPendingOperations.IsEmpty()
+		&& !_ShouldExit()) {
+		// an operation came in while we decided to quit
+		_SpawnThread(&_WorkerThread, "io ring worker", B_NORMAL_PRIORITY);
+	}
+}
+
+
+void
+IORing::_Poll()
+{
+	sigset_t blockedSignals = ~(sigset_t)0;
+	sigprocmask(SIG_SETMASK, &blockedSignals, NULL);
+
+	bigtime_t lastSubmission = system_time();
+
+	MutexLocker locker(fLock);
+
+	while (!_ShouldExit()) {
+		ssize_t submitted = _Submit(locker, fSubmissionCount);
+		if (submitted > 0) {
+			lastSubmission = system_time();
+		} else if (submitted == 0
+			&& system_time() - lastSubmission < kPollIdleTime) {
+			locker.Unlock();
+			thread_yield();
+			locker.Lock();
+			continue;
+		} else {
+			// Go to sleep. Look at the queue once more after setting the
+			// flag, so that we can't miss a submission.
+			atomic_or(&fHeader->flags, IO_RING_SQ_NEED_WAKEUP);
+			if (submitted == 0 && atomic_get((int32*)&fHeader->sq_tail)
+					!= (int32)fSubmissionHead) {
+				atomic_and(&fHeader->flags, ~IO_RING_SQ_NEED_WAKEUP);
+				continue;
+			}
+
+			fPollCondition.Wait(&fLock, B_CAN_INTERRUPT);
+			atomic_and(&fHeader->flags, ~IO_RING_SQ_NEED_WAKEUP);
+			lastSubmission = system_time();
+		}
+	}
+
+	_ThreadExited();
+}
+
+
+void
+IORing::_HandleSockets()
+{
+	sigset_t blockedSignals = ~(sigset_t)0;
+	sigprocmask(SIG_SETMASK, &blockedSignals, NULL);
+
+	while (!_ShouldExit()) {
+		InterruptsSpinLocker socketLocker(fSocketLock);
+
+		io_ring_operation* operation = fSocketOperations.RemoveHead();
+		if (operation == NULL) {
+			ConditionVariableEntry entry;
+			fSocketCondition.Add(&entry);
+			socketLocker.Unlock();
+
+			entry.Wait(B_CAN_INTERRUPT);
+			continue;
+		}
+
+		operation->socket_state = io_ring_operation::kSocketRunning;
+		socketLocker.Unlock();
+
+		if (operation->selected) {
+			deselect_fd(operation->sqe.fd, operation, false);
+			operation->selected = false;
+		}
+
+		int64 result;
+		if (!_ExecuteSocket(operation, result)) {
+			status_t status = _WaitForSocket(operation);
+			if (status == B_OK)
+				continue;
+			result = status;
+		}
+
+		socketLocker.Lock();
+		operation->socket_state = io_ring_operation::kSocketDone;
+		socketLocker.Unlock();
+
+		if (!_ShouldExit())
+			_Complete(operation->sqe.user_data, result);
+		else
+			atomic_add(&fInFlight, -1);
+		operation->ReleaseReference();
+	}
+
+	// Drop the remaining operations. New ones will start another thread.
+	OperationList operations;
+
+	MutexLocker locker(fLock);
+	fHasSocketThread = false;
+	_ThreadExited();
+
+	InterruptsSpinLocker socketLocker(fSocketLock);
+	operations.TakeFrom(&fSocketOperations);
+	operations.TakeFrom(&fWaitingSocketOperations);
+
+	OperationList::Iterator iterator = operations.GetIterator();
+	while (io_ring_operation* operation = iterator.Next())
+		operation->socket_state = io_ring_operation::kSocketDone;
+
+	socketLocker.Unlock();
+	locker.Unlock();
+
+	while (io_ring_operation* operation = operations.RemoveHead()) {
+		if (operation->selected)
+			deselect_fd(operation->sqe.fd, operation, false);
+
+		atomic_add(&fInFlight, -1);
+		operation->ReleaseReference();
+	}
+}
+
+
+//	#pragma mark - file descriptor
+
+
+static status_t
+io_ring_close(file_descriptor* descriptor)
+{
+	((IORing*)descriptor->cookie)->Close();
+	return B_OK;
+}
+
+
+static void
+io_ring_free(file_descriptor* descriptor)
+{
+	((IORing*)descriptor->cookie)->ReleaseReference();
+}
+
+
+static struct fd_ops sIORingFDOps = {
+	&io_ring_close,
+	&io_ring_free
+};
+
+
+//	#pragma mark - syscalls
+
+
+int
+_user_io_ring_create(uint32 entries, uint32 flags, void** _userAddress)
+{
+	if ((flags & ~IO_RING_SQ_POLL) != 0)
+		return B_BAD_VALUE;
+	if (_userAddress == NULL || !IS_USER_ADDRESS(_userAddress))
+		return B_BAD_ADDRESS;
+
+	IORing* ring = new(std::nothrow) IORing(flags);
+	if (ring == NULL)
+		return B_NO_MEMORY;
+
+	BReference<IORing> reference(ring, true);
+
+	void* address;
+	status_t status = ring->Init(entries, &address);
+	if (status != B_OK) {
+		ring->Close();
+		return status;
+	}
+
+	if (user_memcpy(_userAddress, &address, sizeof(void*)) != B_OK) {
+		ring->Close();
+		return B_BAD_ADDRESS;
+	}
+
+	file_descriptor* descriptor = alloc_fd();
+	if (descriptor == NULL) {
+		ring->Close();
+		return B_NO_MEMORY;
+	}
+
+	descriptor->ops = &sIORingFDOps;
+	descriptor->cookie = ring;
+	descriptor->open_mode = O_RDWR;
+
+	io_context* context = get_current_io_context(false);
+	int fd = new_fd(context, descriptor);
+	if (fd < 0) {
+		free(descriptor);
+		ring->Close();
+		return fd;
+	}
+
+	// an executed image could not use the ring
+	rw_lock_write_lock(&context->lock);
+	fd_set_close_on_exec(context, fd, true);
+	rw_lock_write_unlock(&context->lock);
+
+	reference.Detach();
+	return fd;
+}
+
+
+ssize_t
+_user_io_ring_enter(int fd, uint32 toSubmit, uint32 minComplete, uint32 flags,
+	bigtime_t timeout)
+{
+	if (timeout < 0)
+		timeout = B_INFINITE_TIMEOUT;
+
+	uint32 timeoutFlags = B_RELATIVE_TIMEOUT;
+	syscall_restart_handle_timeout_pre(timeoutFlags, timeout);
+
+	file_descriptor* descriptor = get_fd(get_current_io_context(false), fd);
+	if (descriptor == NULL)
+		return B_FILE_ERROR;
+
+	FileDescriptorPutter descriptorPutter(descriptor);
+	if (descriptor->ops != &sIORingFDOps)
+		return B_BAD_VALUE;
+
+	ssize_t result = ((IORing*)descriptor->cookie)->Enter(toSubmit,
+		minComplete, flags, timeoutFlags, timeout);
+	if (result == B_INTERRUPTED)
+		return syscall_restart_handle_timeout_post(result, timeout);
+
+	return result;
+}
@@ -19,11 +19,14 @@
 #include <lock.h>
 #include <messaging.h>
 #include <Notifications.h>
+#include <team.h>
 #include <vfs.h>
 #include <util/AutoLock.h>
 #include <util/DoublyLinkedList.h>
 #include <util/KMessage.h>
 #include <util/list.h>
+#include <util/StringHash.h>
+#include <vm/vm.h>
 
 #include "node_monitor_private.h"
 #include "Vnode.h"
@@ -68,6 +71,43 @@ struct interested_monitor_listener_list {
 	uint32				flags;
 };
 
+static const int32 kMaxRingsPerContext = 8;
+static const int32 kRingCoalesceSlots = 64;
+static const uint32 kRingEventHeaderSize
+	= offsetof(node_monitor_ring_event, names);
+
+/*!	Remembers where the last stat or attribute change of a node has been put
+	into a ring, so that further changes can be merged into it.
+*/
+struct ring_coalesce_slot {
+	dev_t				device;
+	ino_t				node;
+	int32				opcode;
+	uint32				name_hash;
+	uint32				position;
+	uint32				size;
+		// 0 if the slot is unused
+};
+
+struct node_monitor_ring : DoublyLinkedListLinkImpl<node_monitor_ring> {
+	io_context*			context;
+	port_id				port;
+	uint32				token;
+	area_id				area;
+	area_id				user_area;
+	node_monitor_ring_header* header;
+	uint8*				buffer;
+	uint32				size;
+	uint32				head;
+	uint32				notified_head;
+	uint32				lost_events;
+		// dropped events that have not yet been reported in the ring
+	const KMessage*		current_event;
+	ring_coalesce_slot	coalesce_slots[kRingCoalesceSlots];
+};
+
+typedef DoublyLinkedList<node_monitor_ring> NodeMonitorRingList;
+
 static UserMessagingMessageSender sNodeMonitorSender;
 
 class UserNodeListener : public UserMessagingListener {
@@ -86,6 +126,381 @@ class UserNodeListener : public UserMessagingListener {
 		}
 };
 
+
+//	#pragma mark - node monitor rings
+
+
+/*!	Returns the number of bytes in the ring the consumer did not yet get to.
+	Since the consumer can write anything into the ring header, a tail that
+	makes no sense lets the ring appear to be full.
+*/
+static uint32
+ring_used_space(node_monitor_ring* ring)
+{
+	uint32 tail = (uint32)atomic_get((int32*)&ring->header->tail);
+	uint32 used = ring->head - tail;
+	if (used > ring->size)
+		return ring->size;
+
+	return used;
+}
+
+
+/*!	Returns the event \a slot points to, if the consumer did not get to it
+	yet, \c NULL otherwise.
+*/
+static node_monitor_ring_event*
+ring_unread_event(node_monitor_ring* ring, const ring_coalesce_slot& slot)
+{
+	if (slot.size == 0)
+		return NULL;
+
+	uint32 tail = (uint32)atomic_get((int32*)&ring->header->tail);
+	uint32 used = ring->head - tail;
+	if (used > ring->size || slot.position - tail >= used)
+		return NULL;
+
+	return (node_monitor_ring_event*)(ring->buffer
+		+ (slot.position & (ring->size - 1)));
+}
+
+
+/*!	Reserves room for an event of \a size bytes in the ring, and returns it
+	cleared, or \c NULL if the ring is full.
+	Events never wrap around the end of the buffer; the rest of the buffer
+	is filled with a padding event in this case.
+	The new head is not visible to the consumer before ring_publish() is
+	called.
+*/
+static node_monitor_ring_event*
+ring_allocate_event(node_monitor_ring* ring, uint32 size)
+{
+	uint32 offset = ring->head & (ring->size - 1);
+	uint32 padding = 0;
+	if (ring->size - offset < size)
+		padding = ring->size - offset;
+
+	if (ring->size - ring_used_space(ring) < padding + size)
+		return NULL;
+
+	if (padding > 0) {
+		node_monitor_ring_event* event
+			= (node_monitor_ring_event*)(ring->buffer + offset);
+		event->size = padding;
+		event->opcode = B_NODE_MONITOR_RING_PADDING;
+		ring->head += padding;
+		offset = 0;
+	}
+
+	node_monitor_ring_event* event
+		= (node_monitor_ring_event*)(ring->buffer + offset);
+	memset(event, 0, kRingEventHeaderSize);
+	event->size = size;
+	ring->head += size;
+
+	return event;
+}
+
+
+static void
+ring_publish(node_monitor_ring* ring)
+{
+	atomic_set((int32*)&ring->header->head, ring->head);
+}
+
+
+static void
+ring_drop_event(node_monitor_ring* ring)
+{
+	ring->lost_events++;
+	atomic_add((int32*)&ring->header->lost_events, 1);
+}
+
+
+static ring_coalesce_slot&
+ring_slot_for(node_monitor_ring* ring, dev_t device, ino_t node,
+	uint32 nameHash)
+{
+	uint32 hash = ((uint32)(node >> 32) + (uint32)node) ^ (uint32)device
+		^ nameHash;
+	return ring->coalesce_slots[hash % kRingCoalesceSlots];
+}
+
+
+/*!	Forgets about the events of the given node (or of all nodes of the
+	device, if \a node is negative), so that later changes are not merged
+	into events that precede the current one.
+*/
+static void
+ring_forget_node(node_monitor_ring* ring, dev_t device, ino_t node)
+{
+	for (int32 i = 0; i < kRingCoalesceSlots; i++) {
+		ring_coalesce_slot& slot = ring->coalesce_slots[i];
+		if (slot.device == device && (node < 0 || slot.node == node))
+			slot.size = 0;
+	}
+}
+
+
+/*!	Tries to merge a stat change into an event the consumer has not yet
+	read. The resulting event is only an interim update if both were.
+*/
+static bool
+ring_coalesce_stat(node_monitor_ring* ring, dev_t device, ino_t node,
+	int32 fields)
+{
+	ring_coalesce_slot& slot = ring_slot_for(ring, device, node, 0);
+	if (slot.opcode != B_STAT_CHANGED || slot.device != device
+		|| slot.node != node) {
+		return false;
+	}
+
+	node_monitor_ring_event* event = ring_unread_event(ring, slot);
+	if (event == NULL)
+		return false;
+
+	int32 oldState = atomic_get(&event->state);
+	while ((oldState & NODE_MONITOR_RING_EVENT_CONSUMED) == 0) {
+		int32 newState = oldState | fields;
+		if ((oldState & fields & B_STAT_INTERIM_UPDATE) == 0)
+			newState &= ~B_STAT_INTERIM_UPDATE;
+
+		int32 previous = atomic_test_and_set(&event->state, newState,
+			oldState);
+		if (previous == oldState)
+			return true;
+
+		oldState = previous;
+	}
+
+	return false;
+}
+
+
+/*!	An attribute that changed again before the consumer read the previous
+	change does not need another event.
+*/
+static bool
+ring_coalesce_attribute(node_monitor_ring* ring, dev_t device, ino_t node,
+	const char* attribute, uint32 nameHash)
+{
+	ring_coalesce_slot& slot = ring_slot_for(ring, device, node, nameHash);
+	if (slot.opcode != B_ATTR_CHANGED || slot.device != device
+		|| slot.node != node || slot.name_hash != nameHash) {
+		return false;
+	}
+
+	node_monitor_ring_event* event = ring_unread_event(ring, slot);
+	if (event == NULL
+		|| strncmp(event->names, attribute, slot.size - kRingEventHeaderSize)
+			!= 0) {
+		return false;
+	}
+
+	// make sure the consumer did not take the event in the meantime
+	int32 state = atomic_get(&event->state);
+	return (state & NODE_MONITOR_RING_EVENT_CONSUMED) == 0
+		&& atomic_test_and_set(&event->state, state, state) == state;
+}
+
+
+/*!	Puts the node monitor message \a message into the ring, or merges it into
+	a pending event. If there is no room left, the event is dropped, and
+	the consumer will find a B_NODE_MONITOR_EVENTS_LOST event in the ring
+	before the next event that fits in again.
+	Must be called with the service lock held.
+*/
+static void
+ring_add_event(node_monitor_ring* ring, const KMessage* message)
+{
+	int32 opcode;
+	if (message->FindInt32("opcode", &opcode) != B_OK)
+		return;
+
+	dev_t device = message->GetInt32("device", -1);
+	dev_t nodeDevice = device;
+	ino_t node = message->GetInt64("node", -1);
+	ino_t directory = message->GetInt64("directory", -1);
+	ino_t toDirectory = -1;
+	const char* name = NULL;
+	const char* fromName = NULL;
+	int32 state = 0;
+	uint32 nameHash = 0;
+
+	switch (opcode) {
+		case B_ENTRY_CREATED:
+		case B_ENTRY_REMOVED:
+			name = message->GetString("name", NULL);
+			ring_forget_node(ring, device, node);
+			break;
+
+		case B_ENTRY_MOVED:
+			directory = message->GetInt64("from directory", -1);
+			toDirectory = message->GetInt64("to directory", -1);
+			nodeDevice = message->GetInt32("node device", device);
+			name = message->GetString("name", NULL);
+			fromName = message->GetString("from name", NULL);
+			ring_forget_node(ring, nodeDevice, node);
+			break;
+
+		case B_STAT_CHANGED:
+			state = message->GetInt32("fields", 0);
+			if (ring_coalesce_stat(ring, device, node, state))
+				return;
+			break;
+
+		case B_ATTR_CHANGED:
+			name = message->GetString("attr", NULL);
+			state = message->GetInt32("cause", 0);
+			if (name == NULL)
+				return;
+
+			nameHash = hash_hash_string(name);
+			if (state == B_ATTR_CHANGED
+				&& ring_coalesce_attribute(ring, device, node, name,
+					nameHash)) {
+				return;
+			}
+			break;
+
+		case B_DEVICE_MOUNTED:
+			nodeDevice = message->GetInt32("new device", -1);
+			break;
+
+		case B_DEVICE_UNMOUNTED:
+			ring_forget_node(ring, device, -1);
+			break;
+	}
+
+	size_t nameLength = name != NULL
+		? strnlen(name, B_FILE_NAME_LENGTH - 1) + 1 : 0;
+	size_t fromNameLength = fromName != NULL
+		? strnlen(fromName, B_FILE_NAME_LENGTH - 1) + 1 : 0;
+	uint32 size = ROUNDUP(kRingEventHeaderSize + nameLength + fromNameLength,
+		8);
+
+	if (ring->lost_events > 0) {
+		node_monitor_ring_event* lost = ring_allocate_event(ring,
+			kRingEventHeaderSize);
+		if (lost == NULL) {
+			ring_drop_event(ring);
+			return;
+		}
+
+		lost->opcode = B_NODE_MONITOR_EVENTS_LOST;
+		lost->state = ring->lost_events;
+		ring->lost_events = 0;
+	}
+
+	node_monitor_ring_event* event = ring_allocate_event(ring, size);
+	if (event == NULL) {
+		ring_drop_event(ring);
+		ring_publish(ring);
+		return;
+	}
+
+	event->opcode = opcode;
+	event->state = state;
+	event->device = device;
+	event->node_device = nodeDevice;
+	event->node = node;
+	event->directory = directory;
+	event->to_directory = toDirectory;
+	event->name_length = nameLength;
+	event->from_name_length = fromNameLength;
+	if (nameLength > 0) {
+		memcpy(event->names, name, nameLength - 1);
+		event->names[nameLength - 1] = '\0';
+	}
+	if (fromNameLength > 0) {
+		memcpy(event->names + nameLength, fromName, fromNameLength - 1);
+		event->names[nameLength + fromNameLength - 1] = '\0';
+	}
+
+	if (opcode == B_STAT_CHANGED || opcode == B_ATTR_CHANGED) {
+		ring_coalesce_slot& slot = ring_slot_for(ring, device, node,
+			nameHash);
+		slot.device = device;
+		slot.node = node;
+		// a created or removed attribute must not be merged into later
+		// changes, but it still replaces the previous event of the slot
+		slot.opcode = opcode == B_ATTR_CHANGED && state != B_ATTR_CHANGED
+			? 0 : opcode;
+		slot.name_hash = nameHash;
+		slot.position = ring->head - size;
+		slot.size = size;
+	}
+
+	ring_publish(ring);
+}
+
+
+/*!	Tells the consumer that there are new events in the ring, unless it has
+	not yet reacted to a previous notification.
+*/
+static void
+ring_notify(node_monitor_ring* ring)
+{
+	ring->current_event = NULL;
+
+	if (ring->head == ring->notified_head
+		|| atomic_get_and_set(&ring->header->wakeup_pending, 1) != 0) {
+		return;
+	}
+
+	char messageBuffer[64];
+	KMessage message;
+	message.SetTo(messageBuffer, sizeof(messageBuffer), B_NODE_MONITOR);
+	message.AddInt32("opcode", B_NODE_MONITOR_RING_READY);
+
+	messaging_target target;
+	target.port = ring->port;
+	target.token = ring->token;
+
+	if (send_message(&message, &target, 1) != B_OK) {
+		// try again with the next event
+		atomic_set(&ring->header->wakeup_pending, 0);
+		return;
+	}
+
+	ring->notified_head = ring->head;
+}
+
+
+/*!	A user listener that has a ring: instead of sending a message for every
+	event, the events are written into the ring, and the target only gets a
+	message when there is something new in there.
+*/
+class RingNodeListener : public UserNodeListener {
+	public:
+		RingNodeListener(const UserNodeListener& listener,
+				node_monitor_ring* ring)
+			: UserNodeListener(listener),
+			fRing(ring)
+		{
+		}
+
+		virtual void EventOccurred(NotificationService& service,
+			const KMessage* event)
+		{
+			// the same event can reach us through more than one monitor
+			if (fRing->current_event == event)
+				return;
+
+			fRing->current_event = event;
+			ring_add_event(fRing, event);
+		}
+
+		virtual void AllListenersNotified(NotificationService& service)
+		{
+			ring_notify(fRing);
+		}
+
+	private:
+		node_monitor_ring* fRing;
+};
+
+
 class NodeMonitorService : public NotificationService {
 	public:
 		NodeMonitorService();
@@ -124,6 +539,8 @@ class NodeMonitorService : public NotificationService {
 			port_id port, uint32 token);
 		status_t UpdateUserListener(io_context *context, dev_t device,
 			ino_t node, uint32 flags, UserNodeListener &userListener);
+		area_id SetUserRing(io_context *context, port_id port, uint32 token,
+			size_t size, void **_address);
 
 		virtual const char* Name() { return "node monitor"; }
 
@@ -154,6 +571,9 @@ class NodeMonitorService : public NotificationService {
 		status_t _SendNotificationMessage(KMessage &message,
 			interested_monitor_listener_list *interestedListeners,
 			int32 interestedListenerCount);
+		node_monitor_ring *_RingFor(io_context *context, port_id port,
+			uint32 token);
+		void _DeleteRing(node_monitor_ring *ring, bool deleteUserArea);
 		void _ResolveMountPoint(dev_t device, ino_t directory,
 			dev_t& parentDevice, ino_t& parentDirectory);
 
@@ -215,6 +635,7 @@ class NodeMonitorService : public NotificationService {
 
 		MonitorHash	fMonitors;
 		VolumeMonitorHash fVolumeMonitors;
+		NodeMonitorRingList fRings;
 		recursive_lock fRecursiveLock;
 };
 
@@ -626,6 +1047,41 @@ NodeMonitorService::_SendNotificationMessage(KMessage &message,
 }
 
 
+/*!	Returns the ring that has been set for the given target, if any.
+	Must be called with monitors lock hold.
+*/
+node_monitor_ring*
+NodeMonitorService::_RingFor(io_context *context, port_id port, uint32 token)
+{
+	NodeMonitorRingList::Iterator iterator = fRings.GetIterator();
+	while (node_monitor_ring* ring = iterator.Next()) {
+		if (ring->context == context && ring->port == port
+			&& ring->token == token) {
+			return ring;
+		}
+	}
+
+	return NULL;
+}
+
+
+/*!	Removes the ring from the list, and frees it. There must not be any
+	listeners left that use it.
+	Must be called with monitors lock hold.
+*/
+void
+NodeMonitorService::_DeleteRing(node_monitor_ring *ring, bool deleteUserArea)
+{
+	fRings.Remove(ring);
+
+	if (deleteUserArea)
+		vm_delete_area(team_get_current_team_id(), ring->user_area, true);
+	delete_area(ring->area);
+
+	delete ring;
+}
+
+
 /*!	\brief Resolves the device/directory node pair to the node it's covered
 	by, if any.
 */
@@ -938,6 +1394,14 @@ NodeMonitorService::RemoveListeners(io_context *context)
 			(monitor_listener*)list_get_first_item(&context->node_monitors));
 	}
 
+	// The team is going away, its clones of the ring areas will be deleted
+	// with its address space
+	NodeMonitorRingList::Iterator iterator = fRings.GetIterator();
+	while (node_monitor_ring* ring = iterator.Next()) {
+		if (ring->context == context)
+			_DeleteRing(ring, false);
+	}
+
 	return B_OK;
 }
 
@@ -1067,8 +1531,14 @@ NodeMonitorService::UpdateUserListener(io_context *context, dev_t device,
 		}
 	}
 
-	UserNodeListener* copiedListener = new(std::nothrow) UserNodeListener(
-		userListener);
+	UserNodeListener* copiedListener;
+	node_monitor_ring* ring = _RingFor(context, userListener.Port(),
+		userListener.Token());
+	if (ring != NULL) {
+		copiedListener = new(std::nothrow) RingNodeListener(userListener,
+			ring);
+	} else
+		copiedListener = new(std::nothrow) UserNodeListener(userListener);
 	if (copiedListener == NULL) {
 		if (monitor->listeners.IsEmpty())
 			_RemoveMonitor(monitor, flags);
@@ -1083,6 +1553,85 @@ NodeMonitorService::UpdateUserListener(io_context *context, dev_t device,
 }
 
 
+/*!	Sets up a ring for the given target, and maps it into the current team.
+	Any previous ring of the target is deleted, and all of its listeners are
+	removed, so the ring must be set before watching anything with it.
+	A \a size of 0 only removes the ring.
+*/
+area_id
+NodeMonitorService::SetUserRing(io_context *context, port_id port,
+	uint32 token, size_t size, void **_address)
+{
+	RecursiveLocker _(fRecursiveLock);
+
+	node_monitor_ring* ring = _RingFor(context, port, token);
+	if (ring != NULL) {
+		RemoveUserListeners(context, port, token);
+		_DeleteRing(ring, true);
+	}
+
+	if (size == 0)
+		return ring != NULL ? B_OK : B_ENTRY_NOT_FOUND;
+
+	if (size > NODE_MONITOR_RING_MAX_SIZE)
+		return B_BAD_VALUE;
+
+	int32 ringCount = 0;
+	NodeMonitorRingList::Iterator iterator = fRings.GetIterator();
+	while (node_monitor_ring* other = iterator.Next()) {
+		if (other->context == context)
+			ringCount++;
+	}
+	if (ringCount >= kMaxRingsPerContext)
+		return B_NO_MEMORY;
+
+	// the buffer size must be a power of two
+	uint32 bufferSize = NODE_MONITOR_RING_MIN_SIZE;
+	while (bufferSize < size)
+		bufferSize <<= 1;
+
+	ring = new(std::nothrow) node_monitor_ring();
+	if (ring == NULL)
+		return B_NO_MEMORY;
+
+	ring->context = context;
+	ring->port = port;
+	ring->token = token;
+	ring->size = bufferSize;
+
+	void* address;
+	ring->area = create_area("node monitor ring", &address,
+		B_ANY_KERNEL_ADDRESS, B_PAGE_SIZE + bufferSize, B_FULL_LOCK,
+		B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA);
+	if (ring->area < 0) {
+		status_t status = ring->area;
+		delete ring;
+		return status;
+	}
+
+	ring->header = (node_monitor_ring_header*)address;
+	ring->buffer = (uint8*)address + B_PAGE_SIZE;
+	ring->header->magic = NODE_MONITOR_RING_MAGIC;
+	ring->header->size = bufferSize;
+
+	// the team must not be able to delete or resize the area
+	*_address = NULL;
+	ring->user_area = vm_clone_area(team_get_current_team_id(),
+		"node monitor ring", _address, B_ANY_ADDRESS,
+		B_READ_AREA | B_WRITE_AREA | B_KERNEL_AREA, REGION_NO_PRIVATE_MAP,
+		ring->area, true);
+	if (ring->user_area < 0) {
+		status_t status = ring->user_area;
+		delete_area(ring->area);
+		delete ring;
+		return status;
+	}
+
+	fRings.Add(ring);
+	return ring->user_area;
+}
+
+
 //	#pragma mark - private kernel API
 
 
@@ -1340,3 +1889,26 @@ _user_stop_watching(dev_t device, ino_t node, port_id port, uint32 token)
 		listener);
 }
 
+
+area_id
+_user_set_node_monitor_ring(port_id port, uint32 token, size_t size,
+	void** _userAddress)
+{
+	if (size != 0 && (_userAddress == NULL || !IS_USER_ADDRESS(_userAddress)))
+		return B_BAD_ADDRESS;
+
+	io_context *context = get_current_io_context(false);
+
+	void* address;
+	area_id area = sNodeMonitorService.SetUserRing(context, port, token, size,
+		&address);
+	if (area < 0 || size == 0)
+		return area;
+
+	if (user_memcpy(_userAddress, &address, sizeof(void*)) != B_OK) {
+		sNodeMonitorService.SetUserRing(context, port, token, 0, NULL);
+		return B_BAD_ADDRESS;
+	}
+
+	return area;
+}
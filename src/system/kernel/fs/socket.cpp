@@ -9,6 +9,7 @@
 
 #include <errno.h>
 #include <limits.h>
+#include <new>
 
 #include <module.h>
 
@@ -18,13 +19,17 @@
 #include <syscall_utils.h>
 
 #include <fd.h>
+#include <file_cache.h>
 #include <kernel.h>
 #include <lock.h>
 #include <syscall_restart.h>
 #include <util/AutoLock.h>
 #include <util/iovec_support.h>
 #include <vfs.h>
+#include <vm/vm.h>
+#include <vm/VMCache.h>
 
+#include <net_buffer.h>
 #include <net_stack_interface.h>
 #include <net_stat.h>
 
@@ -32,6 +37,10 @@
 #define MAX_SOCKET_ADDRESS_LENGTH	(sizeof(sockaddr_storage))
 #define MAX_SOCKET_OPTION_LENGTH	128
 #define MAX_ANCILLARY_DATA_LENGTH	1024
+#define SEND_FILE_CHUNK_SIZE		(64 * 1024)
+#define SEND_FILE_PAGES				16
+#define MAX_SEND_FILE_PAGES			1024
+#define MESSAGE_BATCH_SIZE			32
 
 #define GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor)	\
 	do {												\
@@ -195,6 +204,122 @@ prepare_userland_msghdr(const msghdr* userMessage, msghdr& message,
 }
 
 
+/*!	Prepares \a message for receiving into the userland buffers it refers to.
+	The address and the ancillary data are received into kernel buffers first.
+*/
+static status_t
+prepare_userland_receive_msghdr(const msghdr* userMessage, msghdr& message,
+	iovec*& userVecs, MemoryDeleter& vecsDeleter, void*& userAddress,
+	char* address, void*& userAncillary, MemoryDeleter& ancillaryDeleter)
+{
+	status_t error = prepare_userland_msghdr(userMessage, message, userVecs,
+		vecsDeleter, userAddress, address);
+	if (error != B_OK)
+		return error;
+
+	// prepare a buffer for ancillary data
+	userAncillary = message.msg_control;
+	if (userAncillary != NULL) {
+		if (!IS_USER_ADDRESS(userAncillary))
+			return B_BAD_ADDRESS;
+		if (message.msg_controllen < 0)
+			return B_BAD_VALUE;
+		if (message.msg_controllen > MAX_ANCILLARY_DATA_LENGTH)
+			message.msg_controllen = MAX_ANCILLARY_DATA_LENGTH;
+
+		message.msg_control = malloc(message.msg_controllen);
+		if (message.msg_control == NULL)
+			return B_NO_MEMORY;
+
+		ancillaryDeleter.SetTo(message.msg_control);
+	}
+
+	return B_OK;
+}
+
+
+/*!	Copies the address and the ancillary data received into \a message back
+	to userland, and restores the userland pointers of \a message.
+*/
+static status_t
+finish_userland_receive_msghdr(msghdr& message, iovec* userVecs,
+	void* userAddress, const char* address, void* userAncillary)
+{
+	void* ancillary = message.msg_control;
+
+	message.msg_name = userAddress;
+	message.msg_iov = userVecs;
+	message.msg_control = userAncillary;
+	if ((userAddress != NULL && user_memcpy(userAddress, address,
+				message.msg_namelen) != B_OK)
+		|| (userAncillary != NULL && user_memcpy(userAncillary, ancillary,
+				message.msg_controllen) != B_OK)) {
+		return B_BAD_ADDRESS;
+	}
+
+	return B_OK;
+}
+
+
+/*!	Prepares \a message for sending from the userland buffers it refers to.
+	The address and the ancillary data are copied into kernel buffers.
+*/
+static status_t
+prepare_userland_send_msghdr(const msghdr* userMessage, msghdr& message,
+	iovec*& userVecs, MemoryDeleter& vecsDeleter, char* address,
+	MemoryDeleter& ancillaryDeleter)
+{
+	void* userAddress;
+	status_t error = prepare_userland_msghdr(userMessage, message, userVecs,
+		vecsDeleter, userAddress, address);
+	if (error != B_OK)
+		return error;
+
+	// copy the address from userland
+	if (userAddress != NULL
+			&& user_memcpy(address, userAddress, message.msg_namelen) != B_OK) {
+		return B_BAD_ADDRESS;
+	}
+
+	// copy ancillary data from userland
+	void* userAncillary = message.msg_control;
+	if (userAncillary != NULL) {
+		if (!IS_USER_ADDRESS(userAncillary))
+			return B_BAD_ADDRESS;
+		if (message.msg_controllen < 0
+				|| message.msg_controllen > MAX_ANCILLARY_DATA_LENGTH) {
+			return B_BAD_VALUE;
+		}
+
+		message.msg_control = malloc(message.msg_controllen);
+		if (message.msg_control == NULL)
+			return B_NO_MEMORY;
+		ancillaryDeleter.SetTo(message.msg_control);
+
+		if (user_memcpy(message.msg_control, userAncillary,
+				message.msg_controllen) != B_OK) {
+			return B_BAD_ADDRESS;
+		}
+	}
+
+	return B_OK;
+}
+
+
+/*!	The kernel copies of a batch of userland mmsghdrs for recvmmsg() and
+	sendmmsg().
+*/
+struct userland_message_batch {
+	mmsghdr			messages[MESSAGE_BATCH_SIZE];
+	iovec*			user_vecs[MESSAGE_BATCH_SIZE];
+	void*			user_addresses[MESSAGE_BATCH_SIZE];
+	void*			user_ancillary[MESSAGE_BATCH_SIZE];
+	MemoryDeleter	vecs_deleters[MESSAGE_BATCH_SIZE];
+	MemoryDeleter	ancillary_deleters[MESSAGE_BATCH_SIZE];
+	char			addresses[MESSAGE_BATCH_SIZE][MAX_SOCKET_ADDRESS_LENGTH];
+};
+
+
 // #pragma mark - socket file descriptor
 
 
@@ -545,6 +670,19 @@ common_recvmsg(int fd, struct msghdr *message, int flags, bool kernel)
 }
 
 
+static ssize_t
+common_recvmmsg(int fd, struct mmsghdr *messages, size_t count, int flags,
+	bool kernel)
+{
+	file_descriptor* descriptor;
+	GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor);
+	FileDescriptorPutter _(descriptor);
+
+	return sStackInterface->recvmmsg(FD_SOCKET(descriptor), messages, count,
+		flags);
+}
+
+
 static ssize_t
 common_send(int fd, const void *data, size_t length, int flags, bool kernel)
 {
@@ -580,6 +718,245 @@ common_sendmsg(int fd, const struct msghdr *message, int flags, bool kernel)
 }
 
 
+static ssize_t
+common_sendmmsg(int fd, struct mmsghdr *messages, size_t count, int flags,
+	bool kernel)
+{
+	file_descriptor* descriptor;
+	GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor);
+	FileDescriptorPutter _(descriptor);
+
+	return sStackInterface->sendmmsg(FD_SOCKET(descriptor), messages, count,
+		flags);
+}
+
+
+/*!	The file cache pages a sendfile() passes on to the stack. They stay wired
+	and mapped until the last net_buffer referring to them is gone.
+*/
+struct send_file_pages : net_buffer_external {
+	VMCache*	cache;
+	uint32		count;
+	vm_page*	pages[SEND_FILE_PAGES];
+	addr_t		addresses[SEND_FILE_PAGES];
+	void*		handles[SEND_FILE_PAGES];
+};
+
+/*!	If the file data cannot be taken from the file cache, it is read into
+	these chunks, which are then passed on to the stack as they are.
+*/
+struct send_file_chunk : net_buffer_external {
+	uint8	data[SEND_FILE_CHUNK_SIZE - sizeof(net_buffer_external)];
+};
+
+
+static int32 sSendFilePagesCount = 0;
+	// the number of pages currently mapped for sendfile(); they are limited
+	// as they might use up the kernel's physical page mapping slots
+
+
+static void
+free_send_file_pages(net_buffer_external* external)
+{
+	send_file_pages* pages = (send_file_pages*)external;
+
+	for (uint32 i = 0; i < pages->count; i++)
+		vm_put_physical_page(pages->addresses[i], pages->handles[i]);
+
+	cache_unwire_vnode_pages(pages->cache, pages->pages, pages->count);
+	atomic_add(&sSendFilePagesCount, -(int32)pages->count);
+	free(pages);
+}
+
+
+static void
+free_send_file_chunk(net_buffer_external* chunk)
+{
+	free(chunk);
+}
+
+
+/*!	Sends up to \a _size bytes of the \a file at \a pos straight from the
+	file cache, without copying them. \a _size is set to the number of bytes
+	that were tried to be sent.
+	Returns \c B_UNSUPPORTED if the file has no file cache, and \c B_BUSY if
+	its pages cannot be used right now; the data has to be copied then.
+*/
+static ssize_t
+send_file_cache_pages(file_descriptor* descriptor, file_descriptor* file,
+	off_t pos, size_t* _size)
+{
+	if (atomic_add(&sSendFilePagesCount, SEND_FILE_PAGES)
+			> MAX_SEND_FILE_PAGES - SEND_FILE_PAGES) {
+		atomic_add(&sSendFilePagesCount, -SEND_FILE_PAGES);
+		return B_BUSY;
+	}
+
+	send_file_pages* pages = (send_file_pages*)malloc(sizeof(send_file_pages));
+	if (pages == NULL) {
+		atomic_add(&sSendFilePagesCount, -SEND_FILE_PAGES);
+		return B_NO_MEMORY;
+	}
+
+	uint32 count = SEND_FILE_PAGES;
+	status_t status = cache_wire_vnode_pages(fd_vnode(file), file->cookie,
+		pos, _size, pages->pages, &count, &pages->cache);
+	if (status == B_OK)
+		atomic_add(&sSendFilePagesCount, (int32)count - SEND_FILE_PAGES);
+	else
+		atomic_add(&sSendFilePagesCount, -SEND_FILE_PAGES);
+	if (status != B_OK || count == 0) {
+		free(pages);
+		return status;
+	}
+
+	pages->ref_count = 1;
+	pages->free = &free_send_file_pages;
+	pages->count = 0;
+
+	iovec vecs[SEND_FILE_PAGES];
+	size_t pageOffset = pos % B_PAGE_SIZE;
+	size_t bytesLeft = *_size;
+
+	for (uint32 i = 0; i < count; i++) {
+		vm_page* page = pages->pages[i];
+		if (vm_get_physical_page(
+				(phys_addr_t)page->physical_page_number * B_PAGE_SIZE,
+				&pages->addresses[i], &pages->handles[i]) != B_OK) {
+			break;
+		}
+
+		vecs[i].iov_base = (uint8*)pages->addresses[i] + pageOffset;
+		vecs[i].iov_len = min_c(bytesLeft, B_PAGE_SIZE - pageOffset);
+		bytesLeft -= vecs[i].iov_len;
+		pageOffset = 0;
+		pages->count++;
+	}
+
+	if (pages->count < count) {
+		// return the pages we could not map
+		uint32 unmapped = count - pages->count;
+		if (pages->count > 0)
+			pages->cache->AcquireRef();
+		cache_unwire_vnode_pages(pages->cache, pages->pages + pages->count,
+			unmapped);
+		atomic_add(&sSendFilePagesCount, -(int32)unmapped);
+
+		if (pages->count == 0) {
+			free(pages);
+			return B_BUSY;
+		}
+
+		*_size -= bytesLeft;
+	}
+
+	ssize_t sent = sStackInterface->send_external(FD_SOCKET(descriptor),
+		vecs, pages->count, pages, 0);
+
+	// the stack holds its own references to the pages
+	if (atomic_add(&pages->ref_count, -1) == 1)
+		free_send_file_pages(pages);
+
+	return sent;
+}
+
+
+static ssize_t
+common_sendfile(int fd, int fileFD, off_t* _pos, size_t length, bool kernel)
+{
+	FileDescriptorPutter file(get_fd(get_current_io_context(kernel), fileFD));
+	if (!file.IsSet())
+		return EBADF;
+	if (!fd_is_file(file.Get()))
+		return B_BAD_VALUE;
+
+	file_descriptor* descriptor;
+	status_t status = get_socket_descriptor(fd, kernel, descriptor);
+	if (status == ENOTSOCK) {
+		// just copy the data to whatever this is
+		FileDescriptorPutter target(get_fd(get_current_io_context(kernel),
+			fd));
+		if (!target.IsSet())
+			return EBADF;
+
+		return fd_copy_data(file.Get(), _pos, target.Get(), NULL, length);
+	}
+	if (status != B_OK)
+		return status;
+	FileDescriptorPutter _(descriptor);
+
+	if ((file->open_mode & O_RWMASK) == O_WRONLY)
+		return EBADF;
+	if (length > SSIZE_MAX)
+		length = SSIZE_MAX;
+
+	bool useFileCache = true;
+	size_t bytesSent = 0;
+	while (bytesSent < length) {
+		off_t pos = _pos != NULL ? *_pos : file->pos;
+		size_t bytesLeft = length - bytesSent;
+		size_t bytesToSend = 0;
+		ssize_t sent = B_UNSUPPORTED;
+
+		if (useFileCache) {
+			bytesToSend = bytesLeft;
+			sent = send_file_cache_pages(descriptor, file.Get(), pos,
+				&bytesToSend);
+			if (sent == B_UNSUPPORTED) {
+				// the file has no file cache, don't ask again
+				useFileCache = false;
+			}
+		}
+
+		if (sent == B_UNSUPPORTED || sent == B_BUSY) {
+			// copy the data into a chunk
+			send_file_chunk* chunk = (send_file_chunk*)malloc(
+				sizeof(send_file_chunk));
+			if (chunk == NULL) {
+				status = B_NO_MEMORY;
+				break;
+			}
+			chunk->ref_count = 1;
+			chunk->free = &free_send_file_chunk;
+
+			bytesToSend = min_c(bytesLeft, sizeof(chunk->data));
+			status = file->ops->fd_read(file.Get(), pos, chunk->data,
+				&bytesToSend);
+
+			sent = 0;
+			if (status == B_OK && bytesToSend > 0) {
+				iovec vec = { chunk->data, bytesToSend };
+				sent = sStackInterface->send_external(FD_SOCKET(descriptor),
+					&vec, 1, chunk, 0);
+			}
+
+			// the stack holds its own references to the data
+			if (atomic_add(&chunk->ref_count, -1) == 1)
+				free_send_file_chunk(chunk);
+		}
+
+		if (sent < 0)
+			status = sent;
+		if (status != B_OK || sent == 0)
+			break;
+
+		if (_pos != NULL)
+			*_pos += sent;
+		else
+			file->pos += sent;
+		bytesSent += sent;
+
+		if ((size_t)sent < bytesToSend)
+			break;
+	}
+
+	if (bytesSent == 0 && status != B_OK)
+		return status;
+
+	return bytesSent;
+}
+
+
 static status_t
 common_getsockopt(int fd, int level, int option, void *value,
 	socklen_t *_length, bool kernel)
@@ -1016,31 +1393,15 @@ _user_recvmsg(int socket, struct msghdr *userMessage, int flags)
 	MemoryDeleter vecsDeleter;
 	void* userAddress;
 	char address[MAX_SOCKET_ADDRESS_LENGTH];
+	void* userAncillary;
+	MemoryDeleter ancillaryDeleter;
 
-	status_t error = prepare_userland_msghdr(userMessage, message, userVecs,
-		vecsDeleter, userAddress, address);
+	status_t error = prepare_userland_receive_msghdr(userMessage, message,
+		userVecs, vecsDeleter, userAddress, address, userAncillary,
+		ancillaryDeleter);
 	if (error != B_OK)
 		return error;
 
-	// prepare a buffer for ancillary data
-	MemoryDeleter ancillaryDeleter;
-	void* ancillary = NULL;
-	void* userAncillary = message.msg_control;
-	if (userAncillary != NULL) {
-		if (!IS_USER_ADDRESS(userAncillary))
-			return B_BAD_ADDRESS;
-		if (message.msg_controllen < 0)
-			return B_BAD_VALUE;
-		if (message.msg_controllen > MAX_ANCILLARY_DATA_LENGTH)
-			message.msg_controllen = MAX_ANCILLARY_DATA_LENGTH;
-
-		message.msg_control = ancillary = malloc(message.msg_controllen);
-		if (message.msg_control == NULL)
-			return B_NO_MEMORY;
-
-		ancillaryDeleter.SetTo(ancillary);
-	}
-
 	// recvmsg()
 	SyscallRestartWrapper<ssize_t> result;
 
@@ -1050,13 +1411,8 @@ _user_recvmsg(int socket, struct msghdr *userMessage, int flags)
 
 	// copy the address, the ancillary data, and the message header back to
 	// userland
-	message.msg_name = userAddress;
-	message.msg_iov = userVecs;
-	message.msg_control = userAncillary;
-	if ((userAddress != NULL && user_memcpy(userAddress, address,
-				message.msg_namelen) != B_OK)
-		|| (userAncillary != NULL && user_memcpy(userAncillary, ancillary,
-				message.msg_controllen) != B_OK)
+	if (finish_userland_receive_msghdr(message, userVecs, userAddress,
+			address, userAncillary) != B_OK
 		|| user_memcpy(userMessage, &message, sizeof(msghdr)) != B_OK) {
 		return B_BAD_ADDRESS;
 	}
@@ -1065,6 +1421,82 @@ _user_recvmsg(int socket, struct msghdr *userMessage, int flags)
 }
 
 
+ssize_t
+_user_recvmmsg(int socket, struct mmsghdr *userMessages, unsigned int count,
+	int flags, bigtime_t timeout)
+{
+	if (userMessages == NULL || !IS_USER_ADDRESS(userMessages))
+		return B_BAD_ADDRESS;
+	if (count > IOV_MAX)
+		count = IOV_MAX;
+
+	userland_message_batch* batch
+		= new(std::nothrow) userland_message_batch;
+	if (batch == NULL)
+		return B_NO_MEMORY;
+	ObjectDeleter<userland_message_batch> batchDeleter(batch);
+
+	bigtime_t deadline = B_INFINITE_TIMEOUT;
+	if (timeout >= 0 && timeout != B_INFINITE_TIMEOUT)
+		deadline = system_time() + timeout;
+
+	const int waitForOne = flags & MSG_WAITFORONE;
+	flags &= ~MSG_WAITFORONE;
+
+	SyscallRestartWrapper<ssize_t> result;
+	unsigned int received = 0;
+	ssize_t error = B_OK;
+
+	while (received < count) {
+		// copy the message headers from userland
+		size_t batchCount = min_c(count - received, MESSAGE_BATCH_SIZE);
+		for (size_t i = 0; i < batchCount; i++) {
+			error = prepare_userland_receive_msghdr(
+				&userMessages[received + i].msg_hdr,
+				batch->messages[i].msg_hdr, batch->user_vecs[i],
+				batch->vecs_deleters[i], batch->user_addresses[i],
+				batch->addresses[i], batch->user_ancillary[i],
+				batch->ancillary_deleters[i]);
+			if (error != B_OK) {
+				batchCount = i;
+				break;
+			}
+		}
+		if (batchCount == 0)
+			break;
+
+		// Once we got a message, MSG_WAITFORONE makes us only take what is
+		// already there
+		ssize_t batchReceived = common_recvmmsg(socket, batch->messages,
+			batchCount, received > 0 && waitForOne != 0
+				? flags | MSG_DONTWAIT : flags, false);
+		if (batchReceived < 0) {
+			error = batchReceived;
+			break;
+		}
+
+		// copy the results back to userland
+		for (ssize_t i = 0; i < batchReceived; i++) {
+			mmsghdr& message = batch->messages[i];
+			if (finish_userland_receive_msghdr(message.msg_hdr,
+					batch->user_vecs[i], batch->user_addresses[i],
+					batch->addresses[i], batch->user_ancillary[i]) != B_OK
+				|| user_memcpy(&userMessages[received + i], &message,
+					sizeof(mmsghdr)) != B_OK) {
+				return result = received > 0 ? (ssize_t)received : B_BAD_ADDRESS;
+			}
+		}
+
+		received += batchReceived;
+
+		if (deadline != B_INFINITE_TIMEOUT && system_time() >= deadline)
+			break;
+	}
+
+	return result = received > 0 ? (ssize_t)received : error;
+}
+
+
 ssize_t
 _user_send(int socket, const void *data, size_t length, int flags)
 {
@@ -1114,46 +1546,104 @@ _user_sendmsg(int socket, const struct msghdr *userMessage, int flags)
 	msghdr message;
 	iovec* userVecs;
 	MemoryDeleter vecsDeleter;
-	void* userAddress;
 	char address[MAX_SOCKET_ADDRESS_LENGTH];
+	MemoryDeleter ancillaryDeleter;
 
-	status_t error = prepare_userland_msghdr(userMessage, message, userVecs,
-		vecsDeleter, userAddress, address);
+	status_t error = prepare_userland_send_msghdr(userMessage, message,
+		userVecs, vecsDeleter, address, ancillaryDeleter);
 	if (error != B_OK)
 		return error;
 
-	// copy the address from userland
-	if (userAddress != NULL
-			&& user_memcpy(address, userAddress, message.msg_namelen) != B_OK) {
+	// sendmsg()
+	SyscallRestartWrapper<ssize_t> result;
+
+	return result = common_sendmsg(socket, &message, flags, false);
+}
+
+
+ssize_t
+_user_sendmmsg(int socket, struct mmsghdr *userMessages, unsigned int count,
+	int flags)
+{
+	if (userMessages == NULL || !IS_USER_ADDRESS(userMessages))
 		return B_BAD_ADDRESS;
-	}
+	if (count > IOV_MAX)
+		count = IOV_MAX;
 
-	// copy ancillary data from userland
-	MemoryDeleter ancillaryDeleter;
-	void* userAncillary = message.msg_control;
-	if (userAncillary != NULL) {
-		if (!IS_USER_ADDRESS(userAncillary))
-			return B_BAD_ADDRESS;
-		if (message.msg_controllen < 0
-				|| message.msg_controllen > MAX_ANCILLARY_DATA_LENGTH) {
-			return B_BAD_VALUE;
+	userland_message_batch* batch
+		= new(std::nothrow) userland_message_batch;
+	if (batch == NULL)
+		return B_NO_MEMORY;
+	ObjectDeleter<userland_message_batch> batchDeleter(batch);
+
+	SyscallRestartWrapper<ssize_t> result;
+	unsigned int sent = 0;
+	ssize_t error = B_OK;
+
+	while (sent < count) {
+		// copy the message headers from userland
+		size_t batchCount = min_c(count - sent, MESSAGE_BATCH_SIZE);
+		for (size_t i = 0; i < batchCount; i++) {
+			error = prepare_userland_send_msghdr(
+				&userMessages[sent + i].msg_hdr, batch->messages[i].msg_hdr,
+				batch->user_vecs[i], batch->vecs_deleters[i],
+				batch->addresses[i], batch->ancillary_deleters[i]);
+			if (error != B_OK) {
+				batchCount = i;
+				break;
+			}
+		}
+		if (batchCount == 0)
+			break;
+
+		ssize_t batchSent = common_sendmmsg(socket, batch->messages,
+			batchCount, flags, false);
+		if (batchSent < 0) {
+			error = batchSent;
+			break;
 		}
 
-		message.msg_control = malloc(message.msg_controllen);
-		if (message.msg_control == NULL)
-			return B_NO_MEMORY;
-		ancillaryDeleter.SetTo(message.msg_control);
+		// report the number of bytes sent for each message
+		for (ssize_t i = 0; i < batchSent; i++) {
+			if (user_memcpy(&userMessages[sent + i].msg_len,
+					&batch->messages[i].msg_len, sizeof(unsigned int))
+						!= B_OK) {
+				return result = sent > 0 ? (ssize_t)sent : B_BAD_ADDRESS;
+			}
+		}
 
-		if (user_memcpy(message.msg_control, userAncillary,
-				message.msg_controllen) != B_OK) {
+		sent += batchSent;
+		if ((size_t)batchSent < batchCount)
+			break;
+	}
+
+	return result = sent > 0 ? (ssize_t)sent : error;
+}
+
+
+ssize_t
+_user_sendfile(int socket, int fd, off_t *userPos, size_t length)
+{
+	off_t pos;
+	if (userPos != NULL) {
+		if (!IS_USER_ADDRESS(userPos)
+			|| user_memcpy(&pos, userPos, sizeof(off_t)) != B_OK) {
 			return B_BAD_ADDRESS;
 		}
+		if (pos < 0)
+			return B_BAD_VALUE;
 	}
 
-	// sendmsg()
 	SyscallRestartWrapper<ssize_t> result;
+	result = common_sendfile(socket, fd, userPos != NULL ? &pos : NULL,
+		length, false);
 
-	return result = common_sendmsg(socket, &message, flags, false);
+	if (result > 0 && userPos != NULL
+		&& user_memcpy(userPos, &pos, sizeof(off_t)) != B_OK) {
+		return B_BAD_ADDRESS;
+	}
+
+	return result;
 }
 
 
@@ -416,6 +416,21 @@ vfs_vnode_io(struct vnode* vnode, void* cookie, io_request* request)
 }
 
 
+/*!	Like vfs_vnode_io(), but never falls back to synchronous I/O in the
+	calling thread. If the file system or device cannot handle \a request
+	itself, \c B_UNSUPPORTED is returned, and the request is left untouched.
+*/
+status_t
+vfs_asynchronous_vnode_io(struct vnode* vnode, void* cookie,
+	io_request* request)
+{
+	if (!HAS_FS_CALL(vnode, io))
+		return B_UNSUPPORTED;
+
+	return FS_CALL(vnode, io, cookie, request);
+}
+
+
 status_t
 vfs_synchronous_io(io_request* request,
 	status_t (*doIO)(void* cookie, off_t offset, void* buffer, size_t* length),
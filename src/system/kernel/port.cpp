@@ -101,6 +101,32 @@ struct port_message : DoublyLinkedListLinkImpl<port_message> {
 
 typedef DoublyLinkedList<port_message> MessageList;
 
+
+/*!	A reader that waits with a large buffer on a port without messages.
+	A writer copies the message directly into its buffer, instead of queuing
+	a copy of it in the kernel heap. The buffer is only locked in memory by
+	the writer, and only while it is copying.
+*/
+struct port_receiver : DoublyLinkedListLinkImpl<port_receiver> {
+	enum State {
+		kWaiting = 0,
+		kClaimed,
+			// a writer is copying its message into the buffer
+		kDone
+	};
+
+	ConditionVariable	condition;
+	team_id				team;
+	void*				buffer;
+	size_t				buffer_size;
+	State				state;
+	int32				code;
+	ssize_t				size;
+		// or an error code
+};
+
+typedef DoublyLinkedList<port_receiver> ReceiverList;
+
 } // namespace
 
 
@@ -133,6 +159,8 @@ struct Port : public KernelReferenceable {
 		// messages read from port since creation
 	select_info*		select_infos;
 	MessageList			messages;
+	ReceiverList		receivers;
+		// only non-empty while there are no messages
 
 	Port(team_id owner, int32 queueLength, const char* name)
 		:
@@ -445,6 +473,10 @@ static const size_t kBufferGrowRate = kInitialPortBufferSize;
 #define MAX_QUEUE_LENGTH 4096
 #define PORT_MAX_MESSAGE_SIZE (256 * 1024)
 
+// Readers with at least this much buffer space have messages written into
+// their buffer directly when they have to wait for them.
+static const size_t kDirectReadThreshold = 64 * 1024;
+
 static int32 sMaxPorts = 4096;
 static int32 sUsedPorts;
 
@@ -792,6 +824,177 @@ copy_port_message(port_message* message, int32* _code, void* buffer,
 }
 
 
+/*!	Wakes up all direct readers of the port, which must be locked. */
+static void
+notify_port_receivers(Port* port, status_t status)
+{
+	ReceiverList::Iterator iterator = port->receivers.GetIterator();
+	while (port_receiver* receiver = iterator.Next())
+		receiver->condition.NotifyAll(status);
+}
+
+
+/*!	Waits for a writer to copy its message directly into \a buffer, which
+	must be a userland buffer of the current team. The buffer is not locked
+	while waiting; the writer locks as much of it as the message needs while
+	it copies.
+
+	The port must be locked, and must not have any messages queued. Returns
+	with the port unlocked, unless it returns \c B_UNSUPPORTED, in which case
+	the caller should read a queued message instead.
+*/
+static ssize_t
+read_port_directly(BReference<Port>& portRef, MutexLocker& locker,
+	int32* _code, void* buffer, size_t bufferSize, uint32 flags,
+	bigtime_t timeout)
+{
+	port_receiver receiver;
+	receiver.condition.Init(&receiver, "port direct read");
+	receiver.team = team_get_current_team_id();
+	receiver.buffer = buffer;
+	receiver.buffer_size = std::min(bufferSize, (size_t)PORT_MAX_MESSAGE_SIZE);
+	receiver.state = port_receiver::kWaiting;
+	portRef->receivers.Add(&receiver);
+
+	while (true) {
+		ConditionVariableEntry entry;
+		receiver.condition.Add(&entry);
+
+		// Once a writer has claimed us, we have to wait for it to finish
+		// no matter what, as it is writing into our buffer.
+		bool claimed = receiver.state == port_receiver::kClaimed;
+
+		locker.Unlock();
+		status_t status = claimed ? entry.Wait() : entry.Wait(flags, timeout);
+		locker.Lock();
+
+		if (receiver.state == port_receiver::kDone) {
+			if (receiver.size >= 0 && _code != NULL)
+				*_code = receiver.code;
+
+			T(Read(portRef, receiver.code, receiver.size));
+			locker.Unlock();
+			return receiver.size;
+		}
+		if (receiver.state == port_receiver::kClaimed)
+			continue;
+
+		if (atomic_get(&portRef->state) != Port::kActive
+			|| (is_port_closed(portRef) && portRef->messages.IsEmpty())) {
+			status = B_BAD_PORT_ID;
+		}
+		if (status == B_OK && portRef->read_count == 0)
+			continue;
+
+		portRef->receivers.Remove(&receiver);
+
+		if (status != B_OK) {
+			T(Read(portRef, 0, status));
+			locker.Unlock();
+			return status;
+		}
+
+		// a message was queued instead
+		return B_UNSUPPORTED;
+	}
+}
+
+
+/*!	Copies a message directly into the buffer of the first waiting reader.
+	The port must be locked, and must not have any messages queued; it is
+	unlocked while copying.
+	Returns \c B_UNSUPPORTED if the reader's buffer could not be locked; the
+	reader then fails with \c B_BAD_ADDRESS, as it would when reading a
+	queued message into it, and the message has not been delivered.
+*/
+static status_t
+write_port_directly(BReference<Port>& portRef, MutexLocker& locker,
+	int32 code, const iovec* vecs, size_t vecCount, size_t bufferSize,
+	bool userCopy)
+{
+	port_receiver* receiver = portRef->receivers.RemoveHead();
+	receiver->state = port_receiver::kClaimed;
+
+	locker.Unlock();
+
+	team_id team = receiver->team;
+	uint8* target = (uint8*)receiver->buffer;
+	size_t size = std::min(bufferSize, receiver->buffer_size);
+
+	status_t targetStatus = B_OK;
+	status_t status = B_OK;
+	if (size > 0)
+		targetStatus = lock_memory_etc(team, target, size, B_READ_DEVICE);
+
+	if (size > 0 && targetStatus == B_OK) {
+		size_t vecIndex = 0;
+		size_t vecOffset = 0;
+		size_t offset = 0;
+
+		while (offset < size && status == B_OK) {
+			physical_entry entries[16];
+			uint32 entryCount = B_COUNT_OF(entries);
+			targetStatus = get_memory_map_etc(team, target + offset,
+				size - offset, entries, &entryCount);
+			if (targetStatus == B_BUFFER_OVERFLOW)
+				targetStatus = B_OK;
+			if (targetStatus != B_OK)
+				break;
+
+			for (uint32 i = 0; i < entryCount && status == B_OK; i++) {
+				phys_addr_t address = entries[i].address;
+				size_t entryBytes = entries[i].size;
+
+				while (entryBytes > 0) {
+					while (vecOffset == vecs[vecIndex].iov_len) {
+						vecIndex++;
+						vecOffset = 0;
+					}
+
+					size_t bytes = std::min(entryBytes,
+						vecs[vecIndex].iov_len - vecOffset);
+					status = vm_memcpy_to_physical(address,
+						(const uint8*)vecs[vecIndex].iov_base + vecOffset,
+						bytes, userCopy);
+					if (status != B_OK)
+						break;
+
+					address += bytes;
+					entryBytes -= bytes;
+					vecOffset += bytes;
+					offset += bytes;
+				}
+			}
+		}
+
+		unlock_memory_etc(team, target, size, B_READ_DEVICE);
+	}
+
+	locker.Lock();
+
+	if (targetStatus != B_OK) {
+		receiver->size = B_BAD_ADDRESS;
+		receiver->state = port_receiver::kDone;
+		receiver->condition.NotifyAll();
+		return B_UNSUPPORTED;
+	}
+
+	if (status != B_OK) {
+		// give the reader back, so that the next writer can try
+		receiver->state = port_receiver::kWaiting;
+		portRef->receivers.Add(receiver, false);
+		receiver->condition.NotifyAll();
+		return status;
+	}
+
+	receiver->code = code;
+	receiver->size = size;
+	receiver->state = port_receiver::kDone;
+	receiver->condition.NotifyAll();
+	return B_OK;
+}
+
+
 static void
 uninit_port(Port* port)
 {
@@ -804,6 +1007,7 @@ uninit_port(Port* port)
 	// read_port() will see the B_BAD_PORT_ID return value, and act accordingly
 	port->read_condition.NotifyAll(B_BAD_PORT_ID);
 	port->write_condition.NotifyAll(B_BAD_PORT_ID);
+	notify_port_receivers(port, B_BAD_PORT_ID);
 	sNotificationService.Notify(PORT_REMOVED, port->id);
 }
 
@@ -1083,6 +1287,7 @@ close_port(port_id id)
 
 	portRef->read_condition.NotifyAll(B_BAD_PORT_ID);
 	portRef->write_condition.NotifyAll(B_BAD_PORT_ID);
+	notify_port_receivers(portRef, B_BAD_PORT_ID);
 
 	return B_OK;
 }
@@ -1460,6 +1665,15 @@ read_port_etc(port_id id, int32* _code, void* buffer, size_t bufferSize,
 		return B_BAD_PORT_ID;
 	}
 
+	if (portRef->read_count == 0 && userCopy && !peekOnly
+		&& bufferSize >= kDirectReadThreshold
+		&& ((flags & B_RELATIVE_TIMEOUT) == 0 || timeout > 0)) {
+		ssize_t result = read_port_directly(portRef, locker, _code, buffer,
+			bufferSize, flags, timeout);
+		if (result != B_UNSUPPORTED)
+			return result;
+	}
+
 	while (portRef->read_count == 0) {
 		if ((flags & B_RELATIVE_TIMEOUT) != 0 && timeout <= 0)
 			return B_WOULD_BLOCK;
@@ -1623,6 +1837,29 @@ writev_port_etc(port_id id, int32 msgCode, const iovec* msgVecs,
 	} else
 		portRef->write_count--;
 
+	while (!portRef->receivers.IsEmpty()) {
+		// A reader is waiting for this message, we can copy it directly
+		// into its buffer.
+		status = write_port_directly(portRef, locker, msgCode, msgVecs,
+			vecCount, bufferSize, userCopy);
+		if (status == B_UNSUPPORTED) {
+			// the buffer of that reader was not valid
+			continue;
+		}
+		if (status != B_OK)
+			goto error;
+
+		portRef->total_count++;
+		portRef->write_count++;
+
+		T(Write(id, portRef->read_count, portRef->write_count, msgCode,
+			bufferSize, B_OK));
+
+		notify_port_select_events(portRef, B_EVENT_WRITE);
+		portRef->write_condition.NotifyOne();
+		return B_OK;
+	}
+
 	status = get_port_message(msgCode, bufferSize, flags, timeout,
 		&message, *portRef);
 	if (status != B_OK) {
@@ -29,6 +29,7 @@
 #include <fs/node_monitor.h>
 #include <generic_syscall.h>
 #include <int.h>
+#include <io_ring.h>
 #include <kernel.h>
 #include <kimage.h>
 #include <ksignal.h>
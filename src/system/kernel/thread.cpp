@@ -43,6 +43,7 @@
 #include <syscalls.h>
 #include <syscall_restart.h>
 #include <team.h>
+#include <timer.h>
 #include <tls.h>
 #include <user_runtime.h>
 #include <user_thread.h>
@@ -64,6 +65,11 @@
 
 #define THREAD_MAX_MESSAGE_SIZE		65536
 
+// Relative timeouts may expire later by this fraction of the timeout, up to
+// the given maximum (in microseconds).
+static const bigtime_t kTimeoutSlackDivisor = 1024;
+static const bigtime_t kMaxTimeoutSlack = 1000;
+
 
 // #pragma mark - ThreadHashTable
 
@@ -3065,10 +3071,19 @@ thread_block_with_timeout(uint32 timeoutFlags, bigtime_t timeout)
 				timerFlags |= B_TIMER_REAL_TIME_BASE;
 		}
 
+		// Relative timeouts of non real-time threads may expire a little
+		// later, so that they can share timer interrupts.
+		bigtime_t slack = 0;
+		if ((timeoutFlags & B_RELATIVE_TIMEOUT) != 0
+			&& thread->priority < B_FIRST_REAL_TIME_PRIORITY) {
+			slack = std::min(timeout / kTimeoutSlackDivisor,
+				kMaxTimeoutSlack);
+		}
+
 		// install the timer
 		thread->wait.unblock_timer.user_data = thread;
-		add_timer(&thread->wait.unblock_timer, &thread_block_timeout, timeout,
-			timerFlags);
+		add_timer_etc(&thread->wait.unblock_timer, &thread_block_timeout,
+			timeout, timerFlags, slack);
 	}
 
 	status_t error = thread_block_locked(thread);
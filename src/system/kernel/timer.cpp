@@ -1,5 +1,5 @@
 /*
- * Copyright 2002-2011, Haiku. All rights reserved.
+ * Copyright 2002-2026, Haiku. All rights reserved.
  * Distributed under the terms of the MIT License.
  *
  * Copyright 2001, Travis Geiselbrecht. All rights reserved.
@@ -14,6 +14,9 @@
 
 #include <OS.h>
 
+#include <stdlib.h>
+#include <string.h>
+
 #include <arch/timer.h>
 #include <boot/kernel_args.h>
 #include <cpu.h>
@@ -25,9 +28,44 @@
 #include <util/AutoLock.h>
 
 
+/*!	The pending timers of a CPU are kept in a hierarchical timing wheel.
+
+	Each level has kWheelSlots slots, and covers kWheelLevelBits more bits of
+	the schedule time than the level below it. Where a timer is stored is a
+	function of its schedule time and of the wheel time only: its level is
+	determined by the highest bit in which the two differ, its slot by the
+	schedule time's bits of that level. Timers of level 0 thus all have
+	exactly the schedule time of their slot, and all timers of a level expire
+	before any timer of the levels above.
+	When the wheel time advances, the timers whose location changes are moved
+	down the levels, or into the sorted list of expired timers if their time
+	has come.
+
+	Since a timer's location can always be computed from its schedule time,
+	cancel_timer() only needs to search a single slot, and no additional
+	fields are needed in the timer structure. This also means that the
+	schedule time of a scheduled timer must not be changed.
+*/
+
+static const int32 kWheelLevelBits = 6;
+static const int32 kWheelSlots = 1 << kWheelLevelBits;
+static const int32 kWheelLevels = 8;
+	// covers 2^48 microseconds (about 8.9 years); anything beyond that goes
+	// into the far events list
+
+struct timer_wheel_level {
+	uint64			occupied;
+		// one bit per non-empty slot
+	timer*			slots[kWheelSlots];
+};
+
 struct per_cpu_timer_data {
 	spinlock		lock;
-	timer*			events;
+	timer_wheel_level* wheel;
+	timer*			expired_events;
+	timer*			far_events;
+	bigtime_t		wheel_time;
+	bigtime_t		next_event_time;
 	timer*			current_event;
 	int32			current_event_in_progress;
 	bigtime_t		real_time_offset;
@@ -87,24 +125,214 @@ add_event_to_list(timer* event, timer** list)
 }
 
 
+static inline int32
+wheel_level(uint64 difference)
+{
+	return (63 - __builtin_clzll(difference)) / kWheelLevelBits;
+}
+
+
+static inline int32
+wheel_slot(bigtime_t scheduleTime, int32 level)
+{
+	return (scheduleTime >> (level * kWheelLevelBits)) & (kWheelSlots - 1);
+}
+
+
+/*!	Returns a mask of the slots up to and including \a slot. */
+static inline uint64
+wheel_slots_up_to(int32 slot)
+{
+	return slot == kWheelSlots - 1 ? ~(uint64)0 : ((uint64)2 << slot) - 1;
+}
+
+
+/*!	Returns the list the event belongs into, and, if it is stored in the
+	wheel, its level and slot.
+	NOTE: expects the CPU's timer data to be locked.
+*/
+static timer**
+event_list_for(per_cpu_timer_data& cpuData, bigtime_t scheduleTime,
+	int32& _level, int32& _slot)
+{
+	_level = -1;
+
+	if (scheduleTime <= cpuData.wheel_time)
+		return &cpuData.expired_events;
+
+	int32 level = wheel_level((uint64)scheduleTime ^ (uint64)cpuData.wheel_time);
+	if (level >= kWheelLevels)
+		return &cpuData.far_events;
+
+	_level = level;
+	_slot = wheel_slot(scheduleTime, level);
+	return &cpuData.wheel[level].slots[_slot];
+}
+
+
+/*! NOTE: expects the CPU's timer data to be locked. */
 static void
-per_cpu_real_time_clock_changed(void*, int cpu)
+insert_event(per_cpu_timer_data& cpuData, timer* event)
 {
-	per_cpu_timer_data& cpuData = sPerCPU[cpu];
-	SpinLocker cpuDataLocker(cpuData.lock);
+	int32 level;
+	int32 slot;
+	timer** list = event_list_for(cpuData, event->schedule_time, level, slot);
+
+	if (level < 0) {
+		if (list == &cpuData.expired_events) {
+			add_event_to_list(event, list);
+			return;
+		}
+	} else
+		cpuData.wheel[level].occupied |= (uint64)1 << slot;
 
-	bigtime_t realTimeOffset = rtc_boot_time();
-	if (realTimeOffset == cpuData.real_time_offset)
+	event->next = *list;
+	*list = event;
+}
+
+
+/*!	Removes the event from the CPU's timers, and returns whether it was
+	scheduled there at all.
+	NOTE: expects the CPU's timer data to be locked.
+*/
+static bool
+remove_event(per_cpu_timer_data& cpuData, timer* event)
+{
+	int32 level;
+	int32 slot;
+	timer** list = event_list_for(cpuData, event->schedule_time, level, slot);
+
+	for (timer** it = list; *it != NULL; it = &(*it)->next) {
+		if (*it != event)
+			continue;
+
+		*it = event->next;
+		event->next = NULL;
+
+		if (level >= 0 && *list == NULL)
+			cpuData.wheel[level].occupied &= ~((uint64)1 << slot);
+		return true;
+	}
+
+	return false;
+}
+
+
+/*!	Computes the time the next event is scheduled for, or
+	\c B_INFINITE_TIMEOUT, if there is none.
+	NOTE: expects the CPU's timer data to be locked.
+*/
+static bigtime_t
+compute_next_event_time(per_cpu_timer_data& cpuData)
+{
+	if (cpuData.expired_events != NULL)
+		return cpuData.expired_events->schedule_time;
+
+	timer* list = cpuData.far_events;
+	for (int32 level = 0; level < kWheelLevels; level++) {
+		uint64 occupied = cpuData.wheel[level].occupied;
+		if (occupied != 0) {
+			list = cpuData.wheel[level].slots[__builtin_ctzll(occupied)];
+			if (level == 0)
+				return list->schedule_time;
+			break;
+		}
+	}
+
+	bigtime_t nextTime = B_INFINITE_TIMEOUT;
+	for (timer* event = list; event != NULL; event = event->next) {
+		if (event->schedule_time < nextTime)
+			nextTime = event->schedule_time;
+	}
+
+	return nextTime;
+}
+
+
+/*!	Moves the wheel time forward to \a time, and moves all timers that need
+	to be stored elsewhere now.
+	NOTE: expects the CPU's timer data to be locked.
+*/
+static void
+advance_wheel(per_cpu_timer_data& cpuData, bigtime_t time)
+{
+	uint64 changed = (uint64)cpuData.wheel_time ^ (uint64)time;
+	if (time <= cpuData.wheel_time)
 		return;
 
-	// The real time offset has changed. We need to update all affected
-	// timers. First find and dequeue them.
-	bigtime_t timeDiff = cpuData.real_time_offset - realTimeOffset;
-	cpuData.real_time_offset = realTimeOffset;
+	int32 topLevel = wheel_level(changed);
+	timer* moved = NULL;
 
-	timer* affectedTimers = NULL;
-	timer** it = &cpuData.events;
-	timer* firstEvent = *it;
+	if (topLevel >= kWheelLevels) {
+		moved = cpuData.far_events;
+		cpuData.far_events = NULL;
+	}
+
+	for (int32 level = 0; level < kWheelLevels && level <= topLevel; level++) {
+		timer_wheel_level& wheelLevel = cpuData.wheel[level];
+
+		// If the time changed above this level, all of its timers need to be
+		// moved; otherwise only the ones up to the new time's slot.
+		uint64 slots = wheelLevel.occupied;
+		if (level == topLevel) {
+			slots &= wheel_slots_up_to(wheel_slot(time, level))
+				& ~wheel_slots_up_to(wheel_slot(cpuData.wheel_time, level));
+		}
+
+		wheelLevel.occupied &= ~slots;
+
+		while (slots != 0) {
+			int32 slot = __builtin_ctzll(slots);
+			slots &= slots - 1;
+
+			timer* event = wheelLevel.slots[slot];
+			wheelLevel.slots[slot] = NULL;
+
+			while (event != NULL) {
+				timer* next = event->next;
+				event->next = moved;
+				moved = event;
+				event = next;
+			}
+		}
+	}
+
+	cpuData.wheel_time = time;
+
+	while (moved != NULL) {
+		timer* event = moved;
+		moved = event->next;
+		insert_event(cpuData, event);
+	}
+}
+
+
+/*!	Returns the time within the given slack after \a scheduleTime that is a
+	multiple of the largest power of two. Timers that allow for some slack
+	thus tend to be scheduled for the same times, and are handled by a
+	single timer interrupt.
+*/
+static bigtime_t
+apply_slack(bigtime_t scheduleTime, bigtime_t slack)
+{
+	if (slack <= 0 || scheduleTime <= 0
+		|| scheduleTime > B_INFINITE_TIMEOUT - slack) {
+		return scheduleTime;
+	}
+
+	uint64 latest = scheduleTime + slack;
+	uint64 difference = (uint64)(scheduleTime - 1) ^ latest;
+	uint64 mask = ((uint64)1 << (63 - __builtin_clzll(difference))) - 1;
+
+	return latest & ~mask;
+}
+
+
+/*!	Moves all absolute real-time timers from \a list to \a affectedTimers. */
+static void
+collect_real_time_events(timer** list, timer*& affectedTimers)
+{
+	timer** it = list;
 	while (timer* event = *it) {
 		// check whether it's an absolute real-time timer
 		uint32 flags = event->flags;
@@ -120,11 +348,43 @@ per_cpu_real_time_clock_changed(void*, int cpu)
 		event->next = affectedTimers;
 		affectedTimers = event;
 	}
+}
 
-	// update and requeue the affected timers
-	bool firstEventChanged = cpuData.events != firstEvent;
-	firstEvent = cpuData.events;
 
+static void
+per_cpu_real_time_clock_changed(void*, int cpu)
+{
+	per_cpu_timer_data& cpuData = sPerCPU[cpu];
+	SpinLocker cpuDataLocker(cpuData.lock);
+
+	bigtime_t realTimeOffset = rtc_boot_time();
+	if (realTimeOffset == cpuData.real_time_offset)
+		return;
+
+	// The real time offset has changed. We need to update all affected
+	// timers. First find and dequeue them.
+	bigtime_t timeDiff = cpuData.real_time_offset - realTimeOffset;
+	cpuData.real_time_offset = realTimeOffset;
+
+	timer* affectedTimers = NULL;
+	collect_real_time_events(&cpuData.expired_events, affectedTimers);
+	collect_real_time_events(&cpuData.far_events, affectedTimers);
+
+	for (int32 level = 0; level < kWheelLevels; level++) {
+		timer_wheel_level& wheelLevel = cpuData.wheel[level];
+		uint64 slots = wheelLevel.occupied;
+
+		while (slots != 0) {
+			int32 slot = __builtin_ctzll(slots);
+			slots &= slots - 1;
+
+			collect_real_time_events(&wheelLevel.slots[slot], affectedTimers);
+			if (wheelLevel.slots[slot] == NULL)
+				wheelLevel.occupied &= ~((uint64)1 << slot);
+		}
+	}
+
+	// update and requeue the affected timers
 	while (affectedTimers != NULL) {
 		timer* event = affectedTimers;
 		affectedTimers = event->next;
@@ -141,58 +401,85 @@ per_cpu_real_time_clock_changed(void*, int cpu)
 				event->schedule_time = 0;
 		}
 
-		add_event_to_list(event, &cpuData.events);
+		insert_event(cpuData, event);
 	}
 
-	firstEventChanged |= cpuData.events != firstEvent;
-
 	// If the first event has changed, reset the hardware timer.
-	if (firstEventChanged)
-		set_hardware_timer(cpuData.events->schedule_time);
+	bigtime_t nextEventTime = compute_next_event_time(cpuData);
+	if (nextEventTime != cpuData.next_event_time) {
+		cpuData.next_event_time = nextEventTime;
+		if (nextEventTime != B_INFINITE_TIMEOUT)
+			set_hardware_timer(nextEventTime);
+	}
 }
 
 
 // #pragma mark - debugging
 
 
+static void
+dump_timer(timer* event)
+{
+	kprintf("  [%9lld] %p: ", (long long)event->schedule_time, event);
+	if ((event->flags & ~B_TIMER_FLAGS) == B_PERIODIC_TIMER)
+		kprintf("periodic %9lld, ", (long long)event->period);
+	else
+		kprintf("one shot,           ");
+
+	kprintf("flags: %#x, user data: %p, callback: %p  ",
+		event->flags, event->user_data, event->hook);
+
+	// look up and print the hook function symbol
+	const char* symbol;
+	const char* imageName;
+	bool exactMatch;
+
+	status_t error = elf_debug_lookup_symbol_address(
+		(addr_t)event->hook, NULL, &symbol, &imageName, &exactMatch);
+	if (error == B_OK && exactMatch) {
+		if (const char* slash = strchr(imageName, '/'))
+			imageName = slash + 1;
+
+		kprintf("   %s:%s", imageName, symbol);
+	}
+
+	kprintf("\n");
+}
+
+
 static int
 dump_timers(int argc, char** argv)
 {
 	int32 cpuCount = smp_get_num_cpus();
 	for (int32 i = 0; i < cpuCount; i++) {
-		kprintf("CPU %" B_PRId32 ":\n", i);
+		per_cpu_timer_data& cpuData = sPerCPU[i];
+		kprintf("CPU %" B_PRId32 ": wheel time %lld\n", i,
+			(long long)cpuData.wheel_time);
 
-		if (sPerCPU[i].events == NULL) {
+		if (cpuData.next_event_time == B_INFINITE_TIMEOUT) {
 			kprintf("  no timers scheduled\n");
 			continue;
 		}
 
-		for (timer* event = sPerCPU[i].events; event != NULL;
+		// Print the timers in the order they are going to expire in; only the
+		// timers within a slot are unordered.
+		for (timer* event = cpuData.expired_events; event != NULL;
 				event = event->next) {
-			kprintf("  [%9lld] %p: ", (long long)event->schedule_time, event);
-			if ((event->flags & ~B_TIMER_FLAGS) == B_PERIODIC_TIMER)
-				kprintf("periodic %9lld, ", (long long)event->period);
-			else
-				kprintf("one shot,           ");
-
-			kprintf("flags: %#x, user data: %p, callback: %p  ",
-				event->flags, event->user_data, event->hook);
-
-			// look up and print the hook function symbol
-			const char* symbol;
-			const char* imageName;
-			bool exactMatch;
-
-			status_t error = elf_debug_lookup_symbol_address(
-				(addr_t)event->hook, NULL, &symbol, &imageName, &exactMatch);
-			if (error == B_OK && exactMatch) {
-				if (const char* slash = strchr(imageName, '/'))
-					imageName = slash + 1;
+			dump_timer(event);
+		}
 
-				kprintf("   %s:%s", imageName, symbol);
+		for (int32 level = 0; level < kWheelLevels; level++) {
+			for (int32 slot = 0; slot < kWheelSlots; slot++) {
+				for (timer* event = cpuData.wheel[level].slots[slot];
+						event != NULL; event = event->next) {
+					dump_timer(event);
+				}
 			}
+		}
 
-			kprintf("\n");
+		for (timer* event = cpuData.far_events; event != NULL;
+				event = event->next) {
+			dump_timer(event);
 		}
 	}
 
@@ -213,6 +500,18 @@ timer_init(kernel_args* args)
 	if (arch_init_timer(args) != B_OK)
 		panic("arch_init_timer() failed");
 
+	int32 cpuCount = smp_get_num_cpus();
+	for (int32 i = 0; i < cpuCount; i++) {
+		per_cpu_timer_data& cpuData = sPerCPU[i];
+		cpuData.wheel = (timer_wheel_level*)calloc(kWheelLevels,
+			sizeof(timer_wheel_level));
+		if (cpuData.wheel == NULL)
+			panic("timer_init(): failed to allocate the timer wheel");
+
+		cpuData.wheel_time = system_time();
+		cpuData.next_event_time = B_INFINITE_TIMEOUT;
+	}
+
 	add_debugger_command_etc("timers", &dump_timers, "List all timers",
 		"\n"
 		"Prints a list of all scheduled timers.\n", 0);
@@ -251,12 +550,17 @@ timer_interrupt()
 	spinlock* spinlock = &cpuData.lock;
 	acquire_spinlock(spinlock);
 
-	timer* event = cpuData.events;
-	while (event != NULL && ((bigtime_t)event->schedule_time < system_time())) {
-		// this event needs to happen
+	while (true) {
+		// all events scheduled before now need to happen
+		advance_wheel(cpuData, system_time() - 1);
+
+		timer* event = cpuData.expired_events;
+		if (event == NULL)
+			break;
+
 		int mode = event->flags;
 
-		cpuData.events = event->next;
+		cpuData.expired_events = event->next;
 		cpuData.current_event = event;
 		atomic_set(&cpuData.current_event_in_progress, 1);
 
@@ -289,16 +593,16 @@ timer_interrupt()
 					- (now - event->schedule_time) % event->period;
 			}
 
-			add_event_to_list(event, &cpuData.events);
+			insert_event(cpuData, event);
 		}
 
 		cpuData.current_event = NULL;
-		event = cpuData.events;
 	}
 
 	// setup the next hardware timer
-	if (cpuData.events != NULL)
-		set_hardware_timer(cpuData.events->schedule_time);
+	cpuData.next_event_time = compute_next_event_time(cpuData);
+	if (cpuData.next_event_time != B_INFINITE_TIMEOUT)
+		set_hardware_timer(cpuData.next_event_time);
 
 	release_spinlock(spinlock);
 
@@ -306,11 +610,13 @@ timer_interrupt()
 }
 
 
-// #pragma mark - public API
-
-
+/*!	Like add_timer(), but allows the timer to fire up to \a slack microseconds
+	later than requested, so that it can be handled together with other
+	timers. The slack is ignored for periodic timers.
+*/
 status_t
-add_timer(timer* event, timer_hook hook, bigtime_t period, int32 flags)
+add_timer_etc(timer* event, timer_hook hook, bigtime_t period, int32 flags,
+	bigtime_t slack)
 {
 	const bigtime_t currentTime = system_time();
 
@@ -346,17 +652,35 @@ add_timer(timer* event, timer_hook hook, bigtime_t period, int32 flags)
 			event->schedule_time = 0;
 	}
 
-	add_event_to_list(event, &cpuData.events);
+	if ((flags & ~B_TIMER_FLAGS) != B_PERIODIC_TIMER)
+		event->schedule_time = apply_slack(event->schedule_time, slack);
+
+	// Keeping the wheel time close to the current time keeps new timers on
+	// the lower levels of the wheel.
+	advance_wheel(cpuData, currentTime - 1);
+	insert_event(cpuData, event);
 	event->cpu = currentCPU;
 
-	// if we were stuck at the head of the list, set the hardware timer
-	if (event == cpuData.events)
+	// if we are the first event to happen, set the hardware timer
+	if (event->schedule_time < cpuData.next_event_time) {
+		cpuData.next_event_time = event->schedule_time;
 		set_hardware_timer(event->schedule_time, currentTime);
+	}
 
 	return B_OK;
 }
 
 
+// #pragma mark - public API
+
+
+status_t
+add_timer(timer* event, timer_hook hook, bigtime_t period, int32 flags)
+{
+	return add_timer_etc(event, hook, period, flags, 0);
+}
+
+
 bool
 cancel_timer(timer* event)
 {
@@ -384,41 +708,28 @@ cancel_timer(timer* event)
 
 	if (event != cpuData.current_event) {
 		// The timer hook is not yet being executed.
-		timer* current = cpuData.events;
-		timer* previous = NULL;
-
-		while (current != NULL) {
-			if (current == event) {
-				// we found it
-				if (previous == NULL)
-					cpuData.events = current->next;
-				else
-					previous->next = current->next;
-				current->next = NULL;
-				// break out of the whole thing
-				break;
-			}
-			previous = current;
-			current = current->next;
-		}
 
 		// If not found, we assume this was a one-shot timer and has already
 		// fired.
-		if (current == NULL)
+		if (!remove_event(cpuData, event))
 			return true;
 
 		// invalidate CPU field
 		event->cpu = 0xffff;
 
+		if (event->schedule_time == cpuData.next_event_time)
+			cpuData.next_event_time = compute_next_event_time(cpuData);
+
 		// If on the current CPU, also reset the hardware timer.
-		// FIXME: Theoretically we should be able to skip this if (previous == NULL).
-		// But it seems adding that causes problems on some systems, possibly due to
-		// some other bug. For now, just reset the hardware timer on every cancellation.
+		// FIXME: Theoretically we should be able to skip this if the event
+		// was not the next one. But it seems adding that causes problems on
+		// some systems, possibly due to some other bug. For now, just reset
+		// the hardware timer on every cancellation.
 		if (cpu == smp_get_current_cpu()) {
-			if (cpuData.events == NULL)
+			if (cpuData.next_event_time == B_INFINITE_TIMEOUT)
 				arch_timer_clear_hardware_timer();
 			else
-				set_hardware_timer(cpuData.events->schedule_time);
+				set_hardware_timer(cpuData.next_event_time);
 		}
 
 		return false;
@@ -1124,6 +1124,21 @@ VMCache::_FreePageRange(VMCachePagesTree::Iterator it,
 			return true;
 		}
 
+		if (page->lent) {
+			// The file cache lent the page out (e.g. to network buffers by
+			// sendfile()), and we cannot know when it will be returned.
+			// Take it out of the cache; cache_unwire_vnode_pages() frees it.
+			DEBUG_PAGE_ACCESS_START(page);
+			vm_remove_all_page_mappings(page);
+			vm_page_set_state(page, PAGE_STATE_WIRED);
+			RemovePage(page);
+			DEBUG_PAGE_ACCESS_END(page);
+
+			if (freedPages != NULL)
+				(*freedPages)++;
+			continue;
+		}
+
 		// remove the page and put it into the free queue
 		DEBUG_PAGE_ACCESS_START(page);
 		vm_remove_all_page_mappings(page);
@@ -989,6 +989,7 @@ dump_page_long(int argc, char **argv)
 	kprintf("busy_writing:    %d\n", page->busy_writing);
 	kprintf("accessed:        %d\n", page->accessed);
 	kprintf("modified:        %d\n", page->modified);
+	kprintf("lent:            %d\n", page->lent);
 #if DEBUG_PAGE_QUEUE
 	kprintf("queue:           %p\n", page->queue);
 #endif
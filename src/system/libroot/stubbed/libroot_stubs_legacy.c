@@ -1023,6 +1023,7 @@ void _kern_clone_area() {}
 void _kern_close() {}
 void _kern_close_port() {}
 void _kern_connect() {}
+void _kern_copy_file_range() {}
 void _kern_cpu_enabled() {}
 void _kern_create_area() {}
 void _kern_create_child_partition() {}
@@ -1119,6 +1120,8 @@ void _kern_image_relocated() {}
 void _kern_initialize_partition() {}
 void _kern_install_default_debugger() {}
 void _kern_install_team_debugger() {}
+void _kern_io_ring_create() {}
+void _kern_io_ring_enter() {}
 void _kern_ioctl() {}
 void _kern_is_computer_on() {}
 void _kern_kernel_debugger() {}
@@ -1175,6 +1178,7 @@ void _kern_realtime_sem_wait() {}
 void _kern_receive_data() {}
 void _kern_recv() {}
 void _kern_recvfrom() {}
+void _kern_recvmmsg() {}
 void _kern_recvmsg() {}
 void _kern_register_file_device() {}
 void _kern_register_image() {}
@@ -1201,6 +1205,8 @@ void _kern_select() {}
 void _kern_send() {}
 void _kern_send_data() {}
 void _kern_send_signal() {}
+void _kern_sendfile() {}
+void _kern_sendmmsg() {}
 void _kern_sendmsg() {}
 void _kern_sendto() {}
 void _kern_set_area_protection() {}
@@ -1208,6 +1214,7 @@ void _kern_set_clock() {}
 void _kern_set_cpu_enabled() {}
 void _kern_set_debugger_breakpoint() {}
 void _kern_set_memory_protection() {}
+void _kern_set_node_monitor_ring() {}
 void _kern_set_partition_content_name() {}
 void _kern_set_partition_content_parameters() {}
 void _kern_set_partition_name() {}
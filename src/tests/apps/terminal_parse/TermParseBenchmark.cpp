@@ -0,0 +1,174 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Feeds terminal output through TermParse into a TerminalBuffer, without
+	any view attached, and measures how fast it gets through.
+
+	Usage: TermParseBenchmark [<recorded output>]
+	Without a file, compiler-like output with some colors and UTF-8 is
+	generated.
+*/
+
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <File.h>
+#include <String.h>
+
+#include "TermApp.h"
+#include "TerminalBuffer.h"
+#include "TermParse.h"
+
+
+// TerminalBuffer gets its colors from here; we don't need the rest of the
+// application.
+rgb_color TermApp::fDefaultPalette[kTermColorCount];
+
+
+static const size_t kGeneratedSize = 32 * 1024 * 1024;
+static const char* kStatusRequest = "\033[5n";
+static const char* kStatusReply = "\033[0n";
+
+
+struct feed_data {
+	int			fd;
+	const char*	data;
+	size_t		size;
+};
+
+
+static void
+generate_output(BString& output)
+{
+	static const char* kLines[] = {
+		"src/kits/app/Message.cpp:1234:17: \033[01;35mwarning:\033[0m "
+			"unused variable 'result' [-Wunused-variable]\r\n",
+		"   1234 |         status_t result = _FindField(name, type, "
+			"&field);\r\n",
+		"        |                  \033[01;32m^~~~~~\033[0m\r\n",
+		"C++ generated/objects/haiku/x86_64/release/kits/app/Looper.o\r\n",
+		"Link generated/objects/haiku/x86_64/release/kits/libbe.so\r\n",
+		"Größe der Ausgabe: 4 KiB – alles in Ordnung ✓\r\n",
+		"\t...skipped libbe_test.so for lack of Message.o...\r\n",
+	};
+	static const int32 kLineCount = sizeof(kLines) / sizeof(kLines[0]);
+
+	int32 index = 0;
+	while ((size_t)output.Length() < kGeneratedSize) {
+		output << kLines[index];
+		index = (index + 1) % kLineCount;
+	}
+}
+
+
+static status_t
+feed_thread(void* _data)
+{
+	feed_data* data = (feed_data*)_data;
+
+	size_t offset = 0;
+	while (offset < data->size) {
+		ssize_t bytes = write(data->fd, data->data + offset,
+			data->size - offset);
+		if (bytes < 0) {
+			if (errno == EINTR)
+				continue;
+			return errno;
+		}
+		offset += bytes;
+	}
+
+	// TermParse answers this once it got through everything before it
+	write(data->fd, kStatusRequest, strlen(kStatusRequest));
+	return B_OK;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	BString output;
+	if (argc > 1) {
+		BFile file(argv[1], B_READ_ONLY);
+		off_t size;
+		status_t status = file.GetSize(&size);
+		if (status == B_OK) {
+			char* buffer = output.LockBuffer(size);
+			ssize_t bytesRead = file.Read(buffer, size);
+			output.UnlockBuffer(bytesRead > 0 ? bytesRead : 0);
+			if (bytesRead != size)
+				status = bytesRead < 0 ? bytesRead : B_IO_ERROR;
+		}
+		if (status != B_OK) {
+			fprintf(stderr, "Could not read %s: %s\n", argv[1],
+				strerror(status));
+			return 1;
+		}
+	} else
+		generate_output(output);
+
+	int sockets[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+		fprintf(stderr, "Could not create sockets: %s\n", strerror(errno));
+		return 1;
+	}
+
+	TerminalBuffer buffer;
+	status_t status = buffer.Init(80, 25, 10000);
+	if (status != B_OK) {
+		fprintf(stderr, "Could not init buffer: %s\n", strerror(status));
+		return 1;
+	}
+
+	TermParse parser(sockets[1]);
+	status = parser.StartThreads(&buffer);
+	if (status != B_OK) {
+		fprintf(stderr, "Could not start parser: %s\n", strerror(status));
+		return 1;
+	}
+
+	feed_data data;
+	data.fd = sockets[0];
+	data.data = output.String();
+	data.size = output.Length();
+
+	bigtime_t start = system_time();
+
+	thread_id feeder = spawn_thread(&feed_thread, "feeder", B_NORMAL_PRIORITY,
+		&data);
+	resume_thread(feeder);
+
+	char reply[16];
+	size_t replyLength = 0;
+	while (replyLength < strlen(kStatusReply)) {
+		ssize_t bytes = read(sockets[0], reply + replyLength,
+			strlen(kStatusReply) - replyLength);
+		if (bytes <= 0) {
+			fprintf(stderr, "Parser did not answer\n");
+			return 1;
+		}
+		replyLength += bytes;
+	}
+
+	bigtime_t runTime = system_time() - start;
+
+	status_t result;
+	wait_for_thread(feeder, &result);
+
+	close(sockets[0]);
+	parser.StopThreads();
+	close(sockets[1]);
+
+	printf("%" B_PRId32 " bytes in %" B_PRId64 " ms: %.1f MB/s\n",
+		output.Length(), runTime / 1000,
+		output.Length() / (runTime / 1000000.0) / (1024 * 1024));
+	return 0;
+}
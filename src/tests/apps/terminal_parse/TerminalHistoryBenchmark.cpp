@@ -0,0 +1,137 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Fills a large terminal history, and measures how long it takes to get
+	there, and to search through it.
+
+	Usage: TerminalHistoryBenchmark [<history lines>]
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+#include <String.h>
+
+#include "TermApp.h"
+#include "TerminalBuffer.h"
+
+
+// TerminalBuffer gets its colors from here; we don't need the rest of the
+// application.
+rgb_color TermApp::fDefaultPalette[kTermColorCount];
+
+
+static const int32 kWidth = 80;
+static const int32 kHeight = 25;
+static const int32 kMarkerInterval = 10000;
+
+
+static void
+fill_buffer(TerminalBuffer& buffer, int32 lineCount)
+{
+	static const char* kLines[] = {
+		"C++ generated/objects/haiku/x86_64/release/kits/app/Looper.o",
+		"src/kits/app/Message.cpp:1234:17: warning: unused variable 'result'",
+		"   1234 |         status_t result = _FindField(name, type, &field);",
+		"Link generated/objects/haiku/x86_64/release/kits/libbe.so",
+		"Größe der Ausgabe: 4 KiB – alles in Ordnung",
+		"\t...skipped libbe_test.so for lack of Message.o...",
+	};
+	static const int32 kLineCount = sizeof(kLines) / sizeof(kLines[0]);
+
+	for (int32 i = 0; i < lineCount; i++) {
+		BString line;
+		if (i % kMarkerInterval == 0)
+			line.SetToFormat("marker %" B_PRId32, i);
+		else
+			line = kLines[i % kLineCount];
+
+		buffer.InsertChars(line.String(), line.Length());
+		buffer.InsertCR();
+		buffer.InsertLF();
+	}
+}
+
+
+static bool
+find(TerminalBuffer& buffer, const char* pattern, const TermPos& start,
+	bool forward, bool expectMatch)
+{
+	TermPos matchStart;
+	TermPos matchEnd;
+
+	bigtime_t startTime = system_time();
+	bool found = buffer.Find(pattern, start, forward, false, true,
+		matchStart, matchEnd);
+	bigtime_t runTime = system_time() - startTime;
+
+	printf("%-8s \"%s\": %" B_PRId64 " ms", forward ? "forward" : "backward",
+		pattern, runTime / 1000);
+
+	if (found) {
+		BString match;
+		buffer.GetStringFromRegion(match, matchStart, matchEnd);
+		printf(", found in line %" B_PRId32 "\n", matchStart.y);
+
+		if (match.ICompare(pattern) != 0) {
+			fprintf(stderr, "Found \"%s\" instead\n", match.String());
+			return false;
+		}
+	} else
+		printf(", not found\n");
+
+	return found == expectMatch;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int32 lineCount = argc > 1 ? atoi(argv[1]) : 1000000;
+	if (lineCount <= kHeight) {
+		fprintf(stderr, "Usage: %s [<history lines>]\n", argv[0]);
+		return 1;
+	}
+
+	TerminalBuffer buffer;
+	status_t status = buffer.Init(kWidth, kHeight, lineCount);
+	if (status != B_OK) {
+		fprintf(stderr, "Could not init buffer: %s\n", strerror(status));
+		return 1;
+	}
+
+	bigtime_t start = system_time();
+	fill_buffer(buffer, lineCount);
+	bigtime_t runTime = system_time() - start;
+
+	printf("%" B_PRId32 " lines in %" B_PRId64 " ms, %" B_PRId32
+		" in the history\n", lineCount, runTime / 1000, buffer.HistorySize());
+
+	// the oldest and the most recent marker that are still there
+	int32 lastMarker = (lineCount - 1) / kMarkerInterval * kMarkerInterval;
+	int32 firstMarker = (max_c(lineCount - buffer.HistorySize(), 0)
+		+ kMarkerInterval - 1) / kMarkerInterval * kMarkerInterval;
+	firstMarker = min_c(firstMarker, lastMarker);
+
+	BString first;
+	first.SetToFormat("marker %" B_PRId32, firstMarker);
+	BString last;
+	last.SetToFormat("marker %" B_PRId32, lastMarker);
+
+	TermPos top(0, -buffer.HistorySize());
+	TermPos bottom(0, kHeight);
+
+	bool success = find(buffer, first, bottom, false, true)
+		&& find(buffer, last, top, true, true)
+		&& find(buffer, "no such text", bottom, false, false)
+		&& find(buffer, "NO SUCH TEXT", top, true, false)
+		&& find(buffer, "warning:", top, true, true);
+
+	return success ? 0 : 1;
+}
@@ -13,6 +13,7 @@
 #include "bmessenger/MessengerTest.h"
 #include "bpropertyinfo/PropertyInfoTest.h"
 #include "broster/RosterTest.h"
+#include "MessageViewTest.h"
 #include "RegistrarThreadManagerTest.h"
 
 BTestSuite* getTestSuite2() {
@@ -25,6 +26,7 @@ BTestSuite* getTestSuite2() {
 	suite->addTest("BHandler", HandlerTestSuite());
 	suite->addTest("BLooper", LooperTestSuite());
 //	suite->addTest("BMessage", MessageTestSuite());
+	suite->addTest("MessageView", MessageViewTest::Suite());
 	suite->addTest("BMessageQueue", MessageQueueTestSuite());
 	suite->addTest("BMessageRunner", MessageRunnerTestSuite());
 	suite->addTest("BMessenger", MessengerTestSuite());
@@ -0,0 +1,591 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "MessageViewTest.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/TestSuite.h>
+
+#include <Message.h>
+#include <Point.h>
+#include <Rect.h>
+#include <String.h>
+
+#include <MessagePrivate.h>
+#include <MessageView.h>
+
+
+typedef BMessage::message_header message_header;
+typedef BMessage::field_header field_header;
+
+
+/*!	A flattened message whose parts can be changed for a test. */
+class FlatMessage {
+public:
+	FlatMessage(const BMessage& message)
+	{
+		fSize = message.FlattenedSize();
+		fBuffer = (char*)malloc(fSize);
+		CPPUNIT_ASSERT(fBuffer != NULL);
+		CPPUNIT_ASSERT_EQUAL(B_OK, message.Flatten(fBuffer, fSize));
+	}
+
+	~FlatMessage()
+	{
+		free(fBuffer);
+	}
+
+	char* Buffer() const
+	{
+		return fBuffer;
+	}
+
+	ssize_t Size() const
+	{
+		return fSize;
+	}
+
+	message_header* Header() const
+	{
+		return (message_header*)fBuffer;
+	}
+
+	field_header* Field(const char* name) const
+	{
+		field_header* fields = (field_header*)(Header() + 1);
+		uint8* data = (uint8*)(fields + Header()->field_count);
+		for (uint32 i = 0; i < Header()->field_count; i++) {
+			if (strcmp((char*)data + fields[i].offset, name) == 0)
+				return &fields[i];
+		}
+
+		CPPUNIT_FAIL("field not found");
+		return NULL;
+	}
+
+	uint8* Data(const char* name) const
+	{
+		field_header* field = Field(name);
+		field_header* fields = (field_header*)(Header() + 1);
+		uint8* data = (uint8*)(fields + Header()->field_count);
+		return data + field->offset + field->name_length;
+	}
+
+private:
+	char*	fBuffer;
+	ssize_t	fSize;
+};
+
+
+static void
+create_message(BMessage& message)
+{
+	message.what = 'test';
+	message.AddBool("bool", true);
+	message.AddInt8("int8", -8);
+	message.AddInt16("int16", -1600);
+	message.AddInt32("int32", 32);
+	message.AddInt32("int32", -320000);
+	message.AddInt64("int64", -6400000000LL);
+	message.AddFloat("float", 1.5f);
+	message.AddDouble("double", -2.25);
+	message.AddPoint("point", BPoint(3, 4));
+	message.AddRect("rect", BRect(1, 2, 30, 40));
+	message.AddString("string", "first");
+	message.AddString("string", "");
+	message.AddString("string", "third string");
+	message.AddData("data", B_RAW_TYPE, "\x01\x02\x03", 3, false);
+	message.AddData("data", B_RAW_TYPE, "\x04", 1, false);
+
+	// more fields than hash table slots, so that chains are followed
+	for (int32 i = 0; i < 20; i++) {
+		BString name;
+		name.SetToFormat("extra %" B_PRId32, i);
+		message.AddInt32(name, i);
+	}
+}
+
+
+static void
+check_matches(const BMessage& message, const MessageView& view)
+{
+	CPPUNIT_ASSERT_EQUAL(message.what, view.What());
+	CPPUNIT_ASSERT_EQUAL(message.CountNames(B_ANY_TYPE), view.CountNames());
+	CPPUNIT_ASSERT_EQUAL(message.CountNames(B_INT32_TYPE),
+		view.CountNames(B_INT32_TYPE));
+
+	bool boolValue;
+	CPPUNIT_ASSERT_EQUAL(B_OK, view.FindBool("bool", &boolValue));
+	CPPUNIT_ASSERT_EQUAL(message.GetBool("bool"), boolValue);
+
+	int8 int8Value;
+	CPPUNIT_ASSERT_EQUAL(B_OK, view.FindInt8("int8", &int8Value));
+	CPPUNIT_ASSERT_EQUAL(message.GetInt8("int8", 0), int8Value);
+
+	int16 int16Value;
+	CPPUNIT_ASSERT_EQUAL(B_OK, view.FindInt16("int16", &int16Value));
+	CPPUNIT_ASSERT_EQUAL(message.GetInt16("int16", 0), int16Value);
+
+	for (int32 i = 0; i < 2; i++) {
+		int32 int32Value;
+		CPPUNIT_ASSERT_EQUAL(B_OK, view.FindInt32("int32", i, &int32Value));
+		CPPUNIT_ASSERT_EQUAL(message.GetInt32("int32", i, 0), int32Value);
+	}
+
+	int64 int64Value;
+	CPPUNIT_ASSERT_EQUAL(B_OK, view.FindInt64("int64", &int64Value));
+	CPPUNIT_ASSERT_EQUAL(message.GetInt64("int64", 0), int64Value);
+
+	float floatValue;
+	CPPUNIT_ASSERT_EQUAL(B_OK, view.FindFloat("float", &floatValue));
+	CPPUNIT_ASSERT_EQUAL(message.GetFloat("float", 0), floatValue);
+
+	double doubleValue;
+	CPPUNIT_ASSERT_EQUAL(B_OK, view.FindDouble("double", &doubleValue));
+	CPPUNIT_ASSERT_EQUAL(message.GetDouble("double", 0), doubleValue);
+
+	BPoint point;
+	CPPUNIT_ASSERT_EQUAL(B_OK, view.FindPoint("point", &point));
+	CPPUNIT_ASSERT(message.GetPoint("point", BPoint()) == point);
+
+	BRect rect;
+	CPPUNIT_ASSERT_EQUAL(B_OK, view.FindRect("rect", &rect));
+	CPPUNIT_ASSERT(message.GetRect("rect", BRect()) == rect);
+
+	for (int32 i = 0; i < 3; i++) {
+		const char* expected;
+		const char* string;
+		CPPUNIT_ASSERT_EQUAL(B_OK, message.FindString("string", i, &expected));
+		CPPUNIT_ASSERT_EQUAL(B_OK, view.FindString("string", i, &string));
+		CPPUNIT_ASSERT(strcmp(expected, string) == 0);
+	}
+
+	for (int32 i = 0; i < 2; i++) {
+		const void* expected;
+		ssize_t expectedSize;
+		const void* data;
+		ssize_t size;
+		CPPUNIT_ASSERT_EQUAL(B_OK, message.FindData("data", B_RAW_TYPE, i,
+			&expected, &expectedSize));
+		CPPUNIT_ASSERT_EQUAL(B_OK, view.FindData("data", B_RAW_TYPE, i, &data,
+			&size));
+		CPPUNIT_ASSERT_EQUAL(expectedSize, size);
+		CPPUNIT_ASSERT(memcmp(expected, data, size) == 0);
+	}
+
+	for (int32 i = 0; i < 20; i++) {
+		BString name;
+		name.SetToFormat("extra %" B_PRId32, i);
+
+		int32 value;
+		CPPUNIT_ASSERT_EQUAL(B_OK, view.FindInt32(name.String(), &value));
+		CPPUNIT_ASSERT_EQUAL(message.GetInt32(name.String(), -1), value);
+	}
+}
+
+
+//	#pragma mark -
+
+
+CppUnit::Test*
+MessageViewTest::Suite()
+{
+	CppUnit::TestSuite* suite = new CppUnit::TestSuite("MessageView");
+	typedef CppUnit::TestCaller<MessageViewTest> TC;
+
+	suite->addTest(new TC("MessageView::FindTest",
+		&MessageViewTest::FindTest));
+	suite->addTest(new TC("MessageView::MissingFieldTest",
+		&MessageViewTest::MissingFieldTest));
+	suite->addTest(new TC("MessageView::GetInfoTest",
+		&MessageViewTest::GetInfoTest));
+	suite->addTest(new TC("MessageView::NestedMessageTest",
+		&MessageViewTest::NestedMessageTest));
+	suite->addTest(new TC("MessageView::TruncatedTest",
+		&MessageViewTest::TruncatedTest));
+	suite->addTest(new TC("MessageView::MalformedTest",
+		&MessageViewTest::MalformedTest));
+	suite->addTest(new TC("MessageView::CorruptedTest",
+		&MessageViewTest::CorruptedTest));
+
+	return suite;
+}
+
+
+/*!	All fields must be found with the same values as BMessage finds them,
+	also when the same FieldName is used for different messages.
+*/
+void
+MessageViewTest::FindTest()
+{
+	BMessage message;
+	create_message(message);
+	FlatMessage flat(message);
+
+	MessageView view(flat.Buffer(), flat.Size());
+	CPPUNIT_ASSERT_EQUAL(B_OK, view.InitCheck());
+	CPPUNIT_ASSERT_EQUAL((size_t)flat.Size(), view.FlattenedSize());
+
+	check_matches(message, view);
+
+	// the hint of a FieldName must not find the field of another message
+	MessageView::FieldName name("int32");
+	BMessage other;
+	other.AddInt32("first", 1);
+	other.AddInt32("int32", 2);
+	FlatMessage otherFlat(other);
+	MessageView otherView(otherFlat.Buffer(), otherFlat.Size());
+
+	int32 value;
+	CPPUNIT_ASSERT_EQUAL(B_OK, view.FindInt32(name, &value));
+	CPPUNIT_ASSERT_EQUAL((int32)32, value);
+	CPPUNIT_ASSERT_EQUAL(B_OK, otherView.FindInt32(name, &value));
+	CPPUNIT_ASSERT_EQUAL((int32)2, value);
+	CPPUNIT_ASSERT_EQUAL(B_OK, view.FindInt32(name, &value));
+	CPPUNIT_ASSERT_EQUAL((int32)32, value);
+
+	// the copy must be the same message again
+	BMessage copy;
+	CPPUNIT_ASSERT_EQUAL(B_OK, view.Unflatten(copy));
+	check_matches(copy, view);
+}
+
+
+/*!	Failing lookups must fail with the same errors as in BMessage. */
+void
+MessageViewTest::MissingFieldTest()
+{
+	BMessage message;
+	create_message(message);
+	FlatMessage flat(message);
+	MessageView view(flat.Buffer(), flat.Size());
+
+	int32 expected;
+	int32 value;
+	CPPUNIT_ASSERT_EQUAL(message.FindInt32("missing", &expected),
+		view.FindInt32("missing", &value));
+	CPPUNIT_ASSERT_EQUAL(B_NAME_NOT_FOUND, view.FindInt32("missing", &value));
+
+	CPPUNIT_ASSERT_EQUAL(message.FindInt32("string", &expected),
+		view.FindInt32("string", &value));
+	CPPUNIT_ASSERT_EQUAL(B_BAD_TYPE, view.FindInt32("string", &value));
+
+	CPPUNIT_ASSERT_EQUAL(message.FindInt32("int32", 2, &expected),
+		view.FindInt32("int32", 2, &value));
+	CPPUNIT_ASSERT_EQUAL(B_BAD_INDEX, view.FindInt32("int32", 2, &value));
+
+	CPPUNIT_ASSERT_EQUAL(message.FindInt32("int32", -1, &expected),
+		view.FindInt32("int32", -1, &value));
+
+	// a prefix of an existing name is a different name
+	CPPUNIT_ASSERT_EQUAL(B_NAME_NOT_FOUND, view.FindInt32("int", &value));
+	CPPUNIT_ASSERT_EQUAL(B_NAME_NOT_FOUND, view.FindInt32("", &value));
+
+	CPPUNIT_ASSERT(view.HasField("int32"));
+	CPPUNIT_ASSERT(view.HasField("int32", B_INT32_TYPE));
+	CPPUNIT_ASSERT(!view.HasField("int32", B_STRING_TYPE));
+	CPPUNIT_ASSERT(!view.HasField("missing"));
+
+	// an unset view finds nothing
+	MessageView empty;
+	CPPUNIT_ASSERT_EQUAL(B_NO_INIT, empty.InitCheck());
+	CPPUNIT_ASSERT_EQUAL(B_NO_INIT, empty.FindInt32("int32", &value));
+	CPPUNIT_ASSERT_EQUAL((int32)0, empty.CountNames());
+	CPPUNIT_ASSERT_EQUAL((size_t)0, empty.FlattenedSize());
+}
+
+
+void
+MessageViewTest::GetInfoTest()
+{
+	BMessage message;
+	create_message(message);
+	FlatMessage flat(message);
+	MessageView view(flat.Buffer(), flat.Size());
+
+	type_code expectedType;
+	int32 expectedCount;
+	bool expectedFixedSize;
+	CPPUNIT_ASSERT_EQUAL(B_OK, message.GetInfo("string", &expectedType,
+		&expectedCount, &expectedFixedSize));
+
+	type_code type;
+	int32 count;
+	bool fixedSize;
+	CPPUNIT_ASSERT_EQUAL(B_OK, view.GetInfo("string", &type, &count,
+		&fixedSize));
+	CPPUNIT_ASSERT_EQUAL(expectedType, type);
+	CPPUNIT_ASSERT_EQUAL(expectedCount, count);
+	CPPUNIT_ASSERT_EQUAL(expectedFixedSize, fixedSize);
+
+	for (int32 i = 0; i < message.CountNames(B_ANY_TYPE); i++) {
+		const char* expectedName;
+		CPPUNIT_ASSERT_EQUAL(B_OK, message.GetInfo(B_ANY_TYPE, i,
+			(char**)&expectedName, &expectedType, &expectedCount));
+
+		const char* name;
+		CPPUNIT_ASSERT_EQUAL(B_OK, view.GetInfo(B_ANY_TYPE, i, &name, &type,
+			&count));
+		CPPUNIT_ASSERT(strcmp(expectedName, name) == 0);
+		CPPUNIT_ASSERT_EQUAL(expectedType, type);
+		CPPUNIT_ASSERT_EQUAL(expectedCount, count);
+	}
+
+	const char* name;
+	CPPUNIT_ASSERT_EQUAL(B_BAD_INDEX, view.GetInfo(B_ANY_TYPE,
+		message.CountNames(B_ANY_TYPE), &name, &type));
+	CPPUNIT_ASSERT_EQUAL(B_BAD_TYPE, view.GetInfo(B_POINTER_TYPE, 0, &name,
+		&type));
+}
+
+
+void
+MessageViewTest::NestedMessageTest()
+{
+	BMessage inner('innr');
+	inner.AddString("label", "inside");
+	BMessage middle('midl');
+	middle.AddMessage("inner", &inner);
+	middle.AddInt32("value", 7);
+
+	BMessage message('outr');
+	message.AddMessage("middle", &middle);
+	message.AddMessage("middle", &inner);
+	FlatMessage flat(message);
+
+	MessageView view(flat.Buffer(), flat.Size());
+	CPPUNIT_ASSERT_EQUAL(B_OK, view.InitCheck());
+
+	MessageView middleView;
+	CPPUNIT_ASSERT_EQUAL(B_OK, view.FindMessage("middle", middleView));
+	CPPUNIT_ASSERT_EQUAL(middle.what, middleView.What());
+
+	int32 value;
+	CPPUNIT_ASSERT_EQUAL(B_OK, middleView.FindInt32("value", &value));
+	CPPUNIT_ASSERT_EQUAL((int32)7, value);
+
+	MessageView innerView;
+	CPPUNIT_ASSERT_EQUAL(B_OK, middleView.FindMessage("inner", innerView));
+	const char* label;
+	CPPUNIT_ASSERT_EQUAL(B_OK, innerView.FindString("label", &label));
+	CPPUNIT_ASSERT(strcmp(label, "inside") == 0);
+
+	CPPUNIT_ASSERT_EQUAL(B_OK, view.FindMessage("middle", 1, innerView));
+	CPPUNIT_ASSERT_EQUAL(inner.what, innerView.What());
+
+	// a failed lookup leaves the target unset
+	CPPUNIT_ASSERT_EQUAL(B_BAD_INDEX, view.FindMessage("middle", 2,
+		innerView));
+	CPPUNIT_ASSERT_EQUAL(B_NO_INIT, innerView.InitCheck());
+}
+
+
+/*!	No part of a message may be accepted, only the whole of it. */
+void
+MessageViewTest::TruncatedTest()
+{
+	BMessage message;
+	create_message(message);
+	FlatMessage flat(message);
+
+	MessageView view;
+	for (ssize_t size = 0; size < flat.Size(); size++) {
+		CPPUNIT_ASSERT_EQUAL(B_BAD_VALUE, view.SetTo(flat.Buffer(), size));
+		CPPUNIT_ASSERT_EQUAL(B_BAD_VALUE, view.InitCheck());
+	}
+
+	CPPUNIT_ASSERT_EQUAL(B_OK, view.SetTo(flat.Buffer(), flat.Size()));
+	CPPUNIT_ASSERT_EQUAL(B_BAD_VALUE, view.SetTo(NULL, flat.Size()));
+
+	// a nested message must not reach beyond its item either
+	BMessage inner('innr');
+	inner.AddString("label", "inside");
+	BMessage outer('outr');
+	outer.AddMessage("inner", &inner);
+	FlatMessage outerFlat(outer);
+
+	field_header* field = outerFlat.Field("inner");
+	uint8* data = outerFlat.Data("inner");
+	uint32 size;
+	memcpy(&size, data, sizeof(uint32));
+	size--;
+	memcpy(data, &size, sizeof(uint32));
+	field->data_size--;
+
+	MessageView outerView(outerFlat.Buffer(), outerFlat.Size());
+	CPPUNIT_ASSERT_EQUAL(B_OK, outerView.InitCheck());
+	MessageView innerView;
+	CPPUNIT_ASSERT_EQUAL(B_BAD_VALUE, outerView.FindMessage("inner",
+		innerView));
+}
+
+
+/*!	Each of these changes makes the message invalid, and must be detected
+	by SetTo().
+*/
+void
+MessageViewTest::MalformedTest()
+{
+	BMessage message;
+	create_message(message);
+	MessageView view;
+
+	{
+		FlatMessage flat(message);
+		flat.Header()->format = 'FOB2';
+		CPPUNIT_ASSERT_EQUAL(B_NOT_SUPPORTED,
+			view.SetTo(flat.Buffer(), flat.Size()));
+	}
+	{
+		FlatMessage flat(message);
+		flat.Header()->flags |= MESSAGE_FLAG_PASS_BY_AREA;
+		CPPUNIT_ASSERT_EQUAL(B_NOT_SUPPORTED,
+			view.SetTo(flat.Buffer(), flat.Size()));
+	}
+	{
+		FlatMessage flat(message);
+		flat.Header()->flags &= ~MESSAGE_FLAG_VALID;
+		CPPUNIT_ASSERT_EQUAL(B_BAD_VALUE,
+			view.SetTo(flat.Buffer(), flat.Size()));
+	}
+	{
+		FlatMessage flat(message);
+		flat.Header()->hash_table_size = 0;
+		CPPUNIT_ASSERT_EQUAL(B_BAD_VALUE,
+			view.SetTo(flat.Buffer(), flat.Size()));
+	}
+	{
+		FlatMessage flat(message);
+		flat.Header()->hash_table[0] = flat.Header()->field_count;
+		CPPUNIT_ASSERT_EQUAL(B_BAD_VALUE,
+			view.SetTo(flat.Buffer(), flat.Size()));
+	}
+	{
+		FlatMessage flat(message);
+		flat.Header()->field_count = 0x10000000;
+		CPPUNIT_ASSERT_EQUAL(B_BAD_VALUE,
+			view.SetTo(flat.Buffer(), flat.Size()));
+	}
+	{
+		FlatMessage flat(message);
+		flat.Header()->data_size = 0xffffffff;
+		CPPUNIT_ASSERT_EQUAL(B_BAD_VALUE,
+			view.SetTo(flat.Buffer(), flat.Size()));
+	}
+	{
+		FlatMessage flat(message);
+		flat.Field("int64")->next_field = flat.Header()->field_count;
+		CPPUNIT_ASSERT_EQUAL(B_BAD_VALUE,
+			view.SetTo(flat.Buffer(), flat.Size()));
+	}
+	{
+		FlatMessage flat(message);
+		flat.Field("int64")->count = 0;
+		CPPUNIT_ASSERT_EQUAL(B_BAD_VALUE,
+			view.SetTo(flat.Buffer(), flat.Size()));
+	}
+	{
+		FlatMessage flat(message);
+		flat.Field("int64")->offset = flat.Header()->data_size;
+		CPPUNIT_ASSERT_EQUAL(B_BAD_VALUE,
+			view.SetTo(flat.Buffer(), flat.Size()));
+	}
+	{
+		// the name must be terminated
+		FlatMessage flat(message);
+		flat.Data("int64")[-1] = 'x';
+		CPPUNIT_ASSERT_EQUAL(B_BAD_VALUE,
+			view.SetTo(flat.Buffer(), flat.Size()));
+	}
+	{
+		// the items of a fixed size field must all have the same size
+		FlatMessage flat(message);
+		flat.Field("int32")->data_size--;
+		CPPUNIT_ASSERT_EQUAL(B_BAD_VALUE,
+			view.SetTo(flat.Buffer(), flat.Size()));
+	}
+	{
+		// an item of variable size must not reach beyond its field
+		FlatMessage flat(message);
+		uint32 size = flat.Field("string")->data_size;
+		memcpy(flat.Data("string"), &size, sizeof(uint32));
+		CPPUNIT_ASSERT_EQUAL(B_BAD_VALUE,
+			view.SetTo(flat.Buffer(), flat.Size()));
+	}
+	{
+		// a string must be terminated
+		FlatMessage flat(message);
+		uint8* data = flat.Data("string");
+		data[sizeof(uint32) + strlen("first")] = 'x';
+		CPPUNIT_ASSERT_EQUAL(B_OK, view.SetTo(flat.Buffer(), flat.Size()));
+
+		const char* string;
+		CPPUNIT_ASSERT_EQUAL(B_BAD_DATA, view.FindString("string", &string));
+	}
+	{
+		// a loop in a hash chain must not keep a lookup from returning
+		FlatMessage flat(message);
+		field_header* fields = (field_header*)(flat.Header() + 1);
+		for (uint32 i = 0; i < flat.Header()->field_count; i++)
+			fields[i].next_field = i;
+		CPPUNIT_ASSERT_EQUAL(B_OK, view.SetTo(flat.Buffer(), flat.Size()));
+
+		int32 value;
+		CPPUNIT_ASSERT_EQUAL(B_NAME_NOT_FOUND,
+			view.FindInt32("missing", &value));
+	}
+}
+
+
+/*!	Flips each byte of a message in turn. The view must then either reject
+	the message, or return only data from within the buffer.
+*/
+void
+MessageViewTest::CorruptedTest()
+{
+	BMessage message;
+	create_message(message);
+	FlatMessage flat(message);
+
+	char* start = (char*)malloc(flat.Size());
+	CPPUNIT_ASSERT(start != NULL);
+	const char* end = start + flat.Size();
+
+	for (ssize_t i = 0; i < flat.Size(); i++) {
+		memcpy(start, flat.Buffer(), flat.Size());
+		start[i] ^= 0xff;
+
+		MessageView view(start, flat.Size());
+		if (view.InitCheck() != B_OK)
+			continue;
+
+		for (int32 j = 0; j < view.CountNames(); j++) {
+			const char* name;
+			type_code type;
+			int32 count;
+			CPPUNIT_ASSERT_EQUAL(B_OK, view.GetInfo(B_ANY_TYPE, j, &name,
+				&type, &count));
+			CPPUNIT_ASSERT(name >= start && name < end);
+			CPPUNIT_ASSERT(name + strlen(name) < end);
+
+			for (int32 k = 0; k < count; k++) {
+				const void* data;
+				ssize_t size;
+				if (view.FindData(name, type, k, &data, &size) != B_OK)
+					continue;
+
+				CPPUNIT_ASSERT((const char*)data >= start);
+				CPPUNIT_ASSERT((const char*)data + size <= end);
+			}
+		}
+	}
+
+	free(start);
+}
@@ -0,0 +1,27 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef MESSAGE_VIEW_TEST_H
+#define MESSAGE_VIEW_TEST_H
+
+
+#include <cppunit/Test.h>
+#include <TestCase.h>
+
+
+class MessageViewTest : public BTestCase {
+public:
+	static	CppUnit::Test*		Suite();
+
+			void				FindTest();
+			void				MissingFieldTest();
+			void				GetInfoTest();
+			void				NestedMessageTest();
+			void				TruncatedTest();
+			void				MalformedTest();
+			void				CorruptedTest();
+};
+
+
+#endif	// MESSAGE_VIEW_TEST_H
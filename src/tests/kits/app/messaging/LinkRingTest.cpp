@@ -0,0 +1,166 @@
+#include <LinkRing.h>
+#include <PortLink.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+
+const int32 kMessageCount = 2000;
+const size_t kRingSize = 16384;
+
+
+static void
+check_message(BPrivate::PortLink &link, int32 expectedIndex)
+{
+	int32 code;
+	if (link.GetNextMessage(code) != B_OK) {
+		fprintf(stderr, "get message %ld failed!\n", expectedIndex);
+		exit(-1);
+	}
+	if (code != 'tst1') {
+		fprintf(stderr, "code is wrong (%ld)!\n", code);
+		exit(-1);
+	}
+
+	int32 index;
+	size_t size;
+	if (link.Read<int32>(&index) != B_OK || link.Read<size_t>(&size) != B_OK) {
+		fprintf(stderr, "reading message failed!\n");
+		exit(-1);
+	}
+	if (index != expectedIndex) {
+		fprintf(stderr, "message %ld arrived out of order (expected %ld)!\n",
+			index, expectedIndex);
+		exit(-1);
+	}
+
+	char buffer[8192];
+	if (size > 0 && link.Read(buffer, size) != B_OK) {
+		fprintf(stderr, "reading data failed!\n");
+		exit(-1);
+	}
+	for (size_t i = 0; i < size; i++) {
+		if (buffer[i] != (char)(index + i)) {
+			fprintf(stderr, "data of message %ld is wrong!\n", index);
+			exit(-1);
+		}
+	}
+}
+
+
+int
+main()
+{
+	port_id port = create_port(1000, "link ring");
+
+	BPrivate::PortLink sender(port, -1);
+	BPrivate::PortLink receiver(-1, port);
+
+	BPrivate::LinkRing* serverRing = new BPrivate::LinkRing;
+	status_t status = serverRing->Create("link ring test", kRingSize);
+	if (status != B_OK) {
+		fprintf(stderr, "creating the ring failed: %s\n", strerror(status));
+		return -1;
+	}
+
+	BPrivate::LinkRing* clientRing = new BPrivate::LinkRing;
+	status = clientRing->Clone(serverRing->Area());
+	if (status != B_OK) {
+		fprintf(stderr, "cloning the ring failed: %s\n", strerror(status));
+		return -1;
+	}
+
+	receiver.Receiver().SetRing(serverRing);
+	sender.Sender().SetRing(clientRing);
+
+	// Message sizes vary, so that the ring fills up, and batches go
+	// through the port every now and then; some never fit into the ring.
+	int32 received = 0;
+	srand(42);
+	for (int32 i = 0; i < kMessageCount; i++) {
+		char data[8192];
+		size_t size = rand() % 5 == 0 ? rand() % sizeof(data) : rand() % 64;
+		for (size_t j = 0; j < size; j++)
+			data[j] = (char)(i + j);
+
+		sender.StartMessage('tst1');
+		sender.Attach<int32>(i);
+		sender.Attach<size_t>(size);
+		if (size > 0)
+			sender.Attach(data, size);
+
+		if (rand() % 3 == 0) {
+			status = sender.Flush();
+			if (status != B_OK) {
+				fprintf(stderr, "flushing messages failed: %s!\n",
+					strerror(status));
+				return -1;
+			}
+		}
+
+		// drain from time to time, but not always to the end
+		if (rand() % 20 == 0) {
+			int32 count = rand() % (i + 1 - received + 1);
+			while (count-- > 0 && received <= i
+				&& receiver.Receiver().HasMessages()) {
+				check_message(receiver, received++);
+			}
+		}
+	}
+
+	status = sender.Flush();
+	if (status != B_OK) {
+		fprintf(stderr, "flushing messages failed: %s!\n", strerror(status));
+		return -1;
+	}
+
+	while (received < kMessageCount)
+		check_message(receiver, received++);
+
+	int32 code;
+	status = receiver.GetNextMessage(code, 0);
+	if (status != B_WOULD_BLOCK) {
+		fprintf(stderr, "reading would not block!\n");
+		return -1;
+	}
+
+	// A stale wakeup is all that's left in the port now
+	sender.StartMessage('tst1');
+	sender.Attach<int32>(kMessageCount);
+	sender.Attach<size_t>(0);
+	sender.Flush();
+	check_message(receiver, kMessageCount);
+
+	if (receiver.Receiver().HasMessages()) {
+		fprintf(stderr, "a stale wakeup counts as a message!\n");
+		return -1;
+	}
+
+	// Another sender on the port must not wait until the ring is empty
+	BPrivate::PortLink other(port, -1);
+	for (int32 i = 0; i < 10; i++) {
+		sender.StartMessage('tst1');
+		sender.Attach<int32>(kMessageCount + 1 + i);
+		sender.Attach<size_t>(0);
+		sender.Flush();
+	}
+	other.StartMessage('tst2');
+	other.Flush();
+
+	if (!receiver.Receiver().HasMessages()) {
+		fprintf(stderr, "messages got lost!\n");
+		return -1;
+	}
+
+	check_message(receiver, kMessageCount + 1);
+	if (receiver.GetNextMessage(code) != B_OK || code != 'tst2') {
+		fprintf(stderr, "the port starves behind the ring!\n");
+		return -1;
+	}
+	for (int32 i = 1; i < 10; i++)
+		check_message(receiver, kMessageCount + 1 + i);
+
+	puts("All OK!");
+	return 0;
+}
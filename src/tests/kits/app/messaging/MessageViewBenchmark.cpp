@@ -0,0 +1,207 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Compares reading fields from a flattened message with Unflatten() and
+	the BMessage Find*() functions against doing the same with a
+	MessageView.
+
+	Usage: MessageViewBenchmark [<blob size>]
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Message.h>
+#include <Rect.h>
+#include <String.h>
+
+#include <MessageView.h>
+
+
+static const bigtime_t kRunTime = 1000000;
+static const int32 kExtraFields = 16;
+
+
+static void
+create_message(BMessage& message, size_t blobSize)
+{
+	message.what = 'test';
+	message.AddInt32("id", 42);
+	message.AddString("name", "some rather typical name of something");
+	message.AddString("path", "/boot/home/Desktop/some/deeper/path/to/file");
+	message.AddRect("frame", BRect(10, 20, 640, 480));
+	message.AddBool("visible", true);
+
+	for (int32 i = 0; i < kExtraFields; i++) {
+		BString name;
+		name.SetToFormat("field %" B_PRId32, i);
+		message.AddInt64(name, i * 1000);
+	}
+
+	BMessage nested('nest');
+	nested.AddInt32("nested id", 23);
+	nested.AddString("label", "nested label");
+	message.AddMessage("nested", &nested);
+
+	if (blobSize > 0) {
+		char* blob = (char*)malloc(blobSize);
+		memset(blob, 0x55, blobSize);
+		message.AddData("blob", B_RAW_TYPE, blob, blobSize);
+		free(blob);
+	}
+}
+
+
+static void
+print_result(const char* mode, int64 count, bigtime_t runTime)
+{
+	printf("%-22s %10.0f messages/s\n", mode, count * 1000000.0 / runTime);
+}
+
+
+static void
+run_unflatten(const char* buffer)
+{
+	int64 count = 0;
+	int64 sum = 0;
+
+	bigtime_t start = system_time();
+	bigtime_t end = start + kRunTime;
+	while (system_time() < end) {
+		for (int32 i = 0; i < 100; i++) {
+			BMessage message;
+			if (message.Unflatten(buffer) != B_OK) {
+				fprintf(stderr, "Unflatten() failed\n");
+				exit(1);
+			}
+
+			int32 id;
+			BString name;
+			BString path;
+			BRect frame;
+			bool visible;
+			int64 value;
+			BMessage nested;
+			int32 nestedID;
+			const void* blob;
+			ssize_t blobSize = 0;
+
+			message.FindInt32("id", &id);
+			message.FindString("name", &name);
+			message.FindString("path", &path);
+			message.FindRect("frame", &frame);
+			message.FindBool("visible", &visible);
+			message.FindInt64("field 7", &value);
+			message.FindMessage("nested", &nested);
+			nested.FindInt32("nested id", &nestedID);
+			message.FindData("blob", B_RAW_TYPE, &blob, &blobSize);
+
+			sum += id + name.Length() + path.Length() + frame.IntegerWidth()
+				+ visible + value + nestedID + blobSize;
+		}
+		count += 100;
+	}
+
+	print_result("Unflatten() + Find*()", count, system_time() - start);
+	if (sum == 0)
+		printf("no result\n");
+}
+
+
+static void
+run_view(const char* buffer, size_t size)
+{
+	static const MessageView::FieldName kID("id");
+	static const MessageView::FieldName kName("name");
+	static const MessageView::FieldName kPath("path");
+	static const MessageView::FieldName kFrame("frame");
+	static const MessageView::FieldName kVisible("visible");
+	static const MessageView::FieldName kField7("field 7");
+	static const MessageView::FieldName kNested("nested");
+	static const MessageView::FieldName kNestedID("nested id");
+	static const MessageView::FieldName kBlob("blob");
+
+	int64 count = 0;
+	int64 sum = 0;
+
+	bigtime_t start = system_time();
+	bigtime_t end = start + kRunTime;
+	while (system_time() < end) {
+		for (int32 i = 0; i < 100; i++) {
+			MessageView message(buffer, size);
+			if (message.InitCheck() != B_OK) {
+				fprintf(stderr, "MessageView::SetTo() failed\n");
+				exit(1);
+			}
+
+			int32 id;
+			const char* name;
+			const char* path;
+			BRect frame;
+			bool visible;
+			int64 value;
+			MessageView nested;
+			int32 nestedID;
+			const void* blob;
+			ssize_t blobSize = 0;
+
+			message.FindInt32(kID, &id);
+			message.FindString(kName, &name);
+			message.FindString(kPath, &path);
+			message.FindRect(kFrame, &frame);
+			message.FindBool(kVisible, &visible);
+			message.FindInt64(kField7, &value);
+			message.FindMessage(kNested, nested);
+			nested.FindInt32(kNestedID, &nestedID);
+			message.FindData(kBlob, B_RAW_TYPE, &blob, &blobSize);
+
+			sum += id + strlen(name) + strlen(path) + frame.IntegerWidth()
+				+ visible + value + nestedID + blobSize;
+		}
+		count += 100;
+	}
+
+	print_result("MessageView", count, system_time() - start);
+	if (sum == 0)
+		printf("no result\n");
+}
+
+
+int
+main(int argc, char** argv)
+{
+	size_t blobSize = argc > 1 ? strtoul(argv[1], NULL, 0) : 64 * 1024;
+
+	BMessage message;
+	create_message(message, blobSize);
+
+	ssize_t size = message.FlattenedSize();
+	char* buffer = (char*)malloc(size);
+	if (buffer == NULL || message.Flatten(buffer, size) != B_OK) {
+		fprintf(stderr, "Could not flatten message\n");
+		return 1;
+	}
+
+	printf("%" B_PRIdSSIZE " bytes, %" B_PRId32 " fields\n", size,
+		message.CountNames(B_ANY_TYPE));
+
+	// make sure both see the same message
+	MessageView view(buffer, size);
+	int32 id;
+	if (view.InitCheck() != B_OK || view.What() != message.what
+		|| view.FindInt32("id", &id) != B_OK || id != 42) {
+		fprintf(stderr, "MessageView does not match the message\n");
+		return 1;
+	}
+
+	run_unflatten(buffer);
+	run_view(buffer, size);
+
+	free(buffer);
+	return 0;
+}
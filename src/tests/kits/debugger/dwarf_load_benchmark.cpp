@@ -0,0 +1,144 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures how long loading the debug information of a file takes, and how
+	much memory it needs, like when the Debugger attaches to a team using it.
+	Loading the file only reads the unit headers and the indices; parsing all
+	compilation units is timed separately.
+	The memory use of the team is sampled while loading to find its peak, and
+	reported again once loading is done.
+
+	Usage: dwarf_load_benchmark <file> ...
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include <ByteOrder.h>
+#include <OS.h>
+
+#include "DwarfFile.h"
+#include "DwarfFileLoadingState.h"
+#include "DwarfManager.h"
+
+
+static const bigtime_t kSampleInterval = 5000;
+
+
+static size_t
+team_memory_usage()
+{
+	size_t size = 0;
+	ssize_t cookie = 0;
+	area_info info;
+	while (get_next_area_info(B_CURRENT_TEAM, &cookie, &info) == B_OK)
+		size += info.ram_size;
+
+	return size;
+}
+
+
+/*!	Samples the memory usage of the team until it is told to stop, and keeps
+	the highest value seen.
+*/
+struct MemorySampler {
+	volatile bool	stop;
+	size_t			peak;
+};
+
+
+static status_t
+sample_memory_usage(void* data)
+{
+	MemorySampler* sampler = (MemorySampler*)data;
+	while (!sampler->stop) {
+		size_t size = team_memory_usage();
+		if (size > sampler->peak)
+			sampler->peak = size;
+		snooze(kSampleInterval);
+	}
+
+	return B_OK;
+}
+
+
+static bool
+load_file(const char* path)
+{
+	DwarfManager manager(sizeof(void*), B_HOST_IS_BENDIAN);
+	status_t status = manager.Init();
+	if (status != B_OK) {
+		fprintf(stderr, "Could not init DwarfManager: %s\n", strerror(status));
+		return false;
+	}
+
+	size_t memoryBefore = team_memory_usage();
+
+	MemorySampler sampler;
+	sampler.stop = false;
+	sampler.peak = memoryBefore;
+	thread_id samplerThread = spawn_thread(&sample_memory_usage,
+		"memory sampler", B_URGENT_DISPLAY_PRIORITY, &sampler);
+	if (samplerThread < 0) {
+		fprintf(stderr, "Could not spawn sampler thread: %s\n",
+			strerror(samplerThread));
+		return false;
+	}
+	resume_thread(samplerThread);
+
+	bigtime_t start = system_time();
+
+	DwarfFileLoadingState state;
+	status = manager.LoadFile(path, state);
+	if (status == B_OK)
+		status = manager.FinishLoading();
+
+	bigtime_t loadTime = system_time() - start;
+
+	if (status == B_OK)
+		status = state.dwarfFile->LoadCompilationUnits();
+
+	bigtime_t parseTime = system_time() - start - loadTime;
+
+	sampler.stop = true;
+	wait_for_thread(samplerThread, NULL);
+
+	if (status != B_OK) {
+		fprintf(stderr, "Could not load \"%s\": %s\n", path, strerror(status));
+		return false;
+	}
+
+	size_t memoryAfter = team_memory_usage();
+	if (memoryAfter > sampler.peak)
+		sampler.peak = memoryAfter;
+
+	printf("%s: %" B_PRId32 " compilation units, loaded in %" B_PRId64 " ms,"
+		" parsed in %" B_PRId64 " ms\n"
+		"  peak while loading: %" B_PRIuSIZE " KB (+%" B_PRIuSIZE " KB)\n"
+		"  resident after load: %" B_PRIuSIZE " KB (+%" B_PRIuSIZE " KB)\n",
+		path, state.dwarfFile->CountCompilationUnits(), loadTime / 1000,
+		parseTime / 1000, sampler.peak / 1024, (sampler.peak - memoryBefore) / 1024,
+		memoryAfter / 1024,
+		(memoryAfter > memoryBefore ? memoryAfter - memoryBefore : 0) / 1024);
+	return true;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <file> ...\n", argv[0]);
+		return 1;
+	}
+
+	bool success = true;
+	for (int i = 1; i < argc; i++)
+		success &= load_file(argv[i]);
+
+	return success ? 0 : 1;
+}
@@ -0,0 +1,285 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Fills a BColumnListView with many sorted rows, and measures how long
+	that, updating rows, and looking up row positions takes. The same is
+	then done with rows that get their fields from a BRowSource.
+
+	Usage: ColumnListViewBenchmark [<rows>]
+*/
+
+
+#include <Application.h>
+#include <ColumnListView.h>
+#include <ColumnTypes.h>
+#include <OS.h>
+#include <Window.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+static const int32 kUpdates = 1000;
+static const int32 kLookups = 10000;
+static const int32 kMaxFetchedRows = 1024;
+
+
+class IndexRow : public BRow {
+public:
+	IndexRow(int32 index)
+		:
+		fIndex(index)
+	{
+	}
+
+	int32 Index() const
+	{
+		return fIndex;
+	}
+
+private:
+	int32	fIndex;
+};
+
+
+class ValueSource : public BRowSource {
+public:
+	ValueSource(const int32* values)
+		:
+		fValues(values),
+		fFetches(0)
+	{
+	}
+
+	virtual void FetchRow(BRow* row)
+	{
+		int32 index = static_cast<IndexRow*>(row)->Index();
+		row->SetField(new BIntegerField(fValues[index]), 0);
+		row->SetField(new BIntegerField(index), 1);
+		fFetches++;
+	}
+
+	int32 Fetches() const
+	{
+		return fFetches;
+	}
+
+private:
+	const int32*	fValues;
+	int32			fFetches;
+};
+
+
+static uint32 sSeed = 42;
+
+
+static int32
+random_value(int32 limit)
+{
+	sSeed = sSeed * 1103515245 + 12345;
+	return (sSeed >> 8) % limit;
+}
+
+
+static void
+print_time(const char* what, bigtime_t startTime)
+{
+	printf("%-40s %6" B_PRId64 " ms\n", what,
+		(system_time() - startTime) / 1000);
+}
+
+
+static BColumnListView*
+create_list_view(BWindow* window, BRowSource* source)
+{
+	BColumnListView* listView = new BColumnListView(window->Bounds(), "list",
+		B_FOLLOW_ALL, B_WILL_DRAW | B_FRAME_EVENTS);
+
+	BColumn* column = new BIntegerColumn("Value", 100, 10, 1000);
+	listView->AddColumn(column, 0);
+	listView->AddColumn(new BIntegerColumn("Index", 100, 10, 1000), 1);
+	listView->SetSortColumn(column, false, true);
+	listView->SetRowSource(source);
+
+	window->AddChild(listView);
+	return listView;
+}
+
+
+static bool
+check_order(BColumnListView* listView, const int32* values)
+{
+	int32 previous = -1;
+	for (int32 i = 0; i < listView->CountRows(); i++) {
+		int32 value = values[static_cast<IndexRow*>(listView->RowAt(i))
+			->Index()];
+		if (value < previous) {
+			fprintf(stderr, "Row %" B_PRId32 " is out of order!\n", i);
+			return false;
+		}
+		previous = value;
+	}
+
+	return true;
+}
+
+
+static bool
+check_positions(BColumnListView* listView)
+{
+	int32 count = listView->CountRows();
+	int32 step = max_c(count / 1000, 1);
+	float top = 0;
+
+	for (int32 i = 0; i < count; i++) {
+		BRow* row = listView->RowAt(i);
+		if (i % step == 0) {
+			BRect rect;
+			if (!listView->GetRowRect(row, &rect) || rect.top != top
+				|| listView->RowAt(BPoint(10, rect.top + 1)) != row) {
+				fprintf(stderr, "Row %" B_PRId32 " is misplaced!\n", i);
+				return false;
+			}
+		}
+		top += row->Height() + 1;
+	}
+
+	return true;
+}
+
+
+static bool
+run_benchmark(BWindow* window, int32 rowCount, int32* values)
+{
+	BColumnListView* listView = create_list_view(window, NULL);
+
+	bigtime_t startTime = system_time();
+	for (int32 i = 0; i < rowCount; i++) {
+		IndexRow* row = new IndexRow(i);
+		row->SetField(new BIntegerField(values[i]), 0);
+		row->SetField(new BIntegerField(i), 1);
+		listView->AddRow(row);
+	}
+	print_time("AddRow(), sorted", startTime);
+
+	if (!check_order(listView, values))
+		return false;
+
+	startTime = system_time();
+	for (int32 i = 0; i < kUpdates; i++) {
+		IndexRow* row = static_cast<IndexRow*>(
+			listView->RowAt(random_value(rowCount)));
+		values[row->Index()] = random_value(rowCount);
+		static_cast<BIntegerField*>(row->GetField(0))->SetValue(
+			values[row->Index()]);
+		listView->UpdateRow(row);
+	}
+	print_time("UpdateRow(), with a new value", startTime);
+
+	if (!check_order(listView, values))
+		return false;
+
+	BRect lastRect;
+	listView->GetRowRect(listView->RowAt(rowCount - 1), &lastRect);
+
+	startTime = system_time();
+	for (int32 i = 0; i < kLookups; i++) {
+		float y = random_value((int32)lastRect.bottom);
+		if (listView->RowAt(BPoint(10, y)) == NULL
+			&& listView->RowAt(BPoint(10, y + 1)) == NULL) {
+			fprintf(stderr, "No row at %g!\n", y);
+			return false;
+		}
+	}
+	print_time("RowAt(BPoint)", startTime);
+
+	if (!check_positions(listView))
+		return false;
+
+	startTime = system_time();
+	for (int32 i = 0; i < kUpdates; i++) {
+		BRow* row = listView->RowAt(random_value(rowCount - i));
+		listView->RemoveRow(row);
+		delete row;
+	}
+	print_time("RemoveRow()", startTime);
+
+	if (!check_positions(listView))
+		return false;
+
+	listView->RemoveSelf();
+	delete listView;
+	return true;
+}
+
+
+static bool
+run_source_benchmark(BWindow* window, int32 rowCount, const int32* values)
+{
+	ValueSource source(values);
+	BColumnListView* listView = create_list_view(window, &source);
+
+	bigtime_t startTime = system_time();
+	for (int32 i = 0; i < rowCount; i++)
+		listView->AddRow(new IndexRow(i));
+	print_time("AddRow(), sorted, from a source", startTime);
+
+	printf("%" B_PRId32 " rows fetched\n", source.Fetches());
+
+	// Only the sort column is kept for all rows, so sorting must not have to
+	// fetch rows again
+	if (source.Fetches() > rowCount + kMaxFetchedRows) {
+		fprintf(stderr, "Rows were fetched again while sorting!\n");
+		return false;
+	}
+
+	int32 rowsWithFields = 0;
+	for (int32 i = 0; i < rowCount; i++) {
+		if (listView->RowAt(i)->GetField(1) != NULL)
+			rowsWithFields++;
+	}
+	if (rowsWithFields > kMaxFetchedRows) {
+		fprintf(stderr, "%" B_PRId32 " rows kept their fields!\n",
+			rowsWithFields);
+		return false;
+	}
+
+	bool success = check_order(listView, values)
+		&& check_positions(listView);
+
+	listView->RemoveSelf();
+	delete listView;
+	return success;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int32 rowCount = argc > 1 ? atoi(argv[1]) : 500000;
+	if (rowCount <= kUpdates) {
+		fprintf(stderr, "Usage: %s [<rows>]\n", argv[0]);
+		return 1;
+	}
+
+	BApplication app("application/x-vnd.Haiku-ColumnListViewBenchmark");
+
+	int32* values = new int32[rowCount];
+	for (int32 i = 0; i < rowCount; i++)
+		values[i] = random_value(rowCount);
+
+	BWindow* window = new BWindow(BRect(100, 100, 700, 500),
+		"ColumnListView-Benchmark", B_TITLED_WINDOW, B_QUIT_ON_WINDOW_CLOSE);
+	window->Lock();
+
+	bool success = run_benchmark(window, rowCount, values)
+		&& run_source_benchmark(window, rowCount, values);
+
+	window->Quit();
+	delete[] values;
+
+	return success ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Puts a large document into a BTextView, and measures how long that, and
+	editing it takes.
+
+	Usage: TextViewBenchmark [<megabytes>]
+*/
+
+
+#include <Application.h>
+#include <OS.h>
+#include <ScrollView.h>
+#include <String.h>
+#include <TextView.h>
+#include <Window.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+static const int32 kEdits = 200;
+
+
+static void
+print_time(const char* what, bigtime_t startTime)
+{
+	printf("%-40s %6" B_PRId64 " ms\n", what,
+		(system_time() - startTime) / 1000);
+}
+
+
+static void
+create_document(BString& document, int32 size)
+{
+	static const char* kParagraphs[] = {
+		"Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do "
+			"eiusmod tempor incididunt ut labore et dolore magna aliqua.",
+		"short line",
+		"",
+		"Größe der Ausgabe: 4 KiB – alles in Ordnung, keine Fehler gefunden. "
+			"日本語のテキストも少しだけ含まれています。",
+		"\tif (status != B_OK)\n\t\treturn status;",
+	};
+	static const int32 kParagraphCount
+		= sizeof(kParagraphs) / sizeof(kParagraphs[0]);
+
+	for (int32 i = 0; document.Length() < size; i++) {
+		document << kParagraphs[i % kParagraphCount];
+		document << '\n';
+	}
+}
+
+
+static bool
+run_benchmark(BTextView* textView, const BString& document)
+{
+	bigtime_t startTime = system_time();
+	textView->SetText(document.String(), document.Length());
+	print_time("SetText()", startTime);
+
+	startTime = system_time();
+	for (int32 i = 0; i < kEdits; i++)
+		textView->Insert(0, "x", 1);
+	print_time("insert at the start", startTime);
+
+	int32 middle = textView->TextLength() / 2;
+	startTime = system_time();
+	for (int32 i = 0; i < kEdits; i++)
+		textView->Insert(middle, "a longer line\n", 14);
+	print_time("insert lines in the middle", startTime);
+
+	startTime = system_time();
+	for (int32 i = 0; i < kEdits; i++)
+		textView->Insert(textView->TextLength(), "appended\n", 9);
+	print_time("append at the end", startTime);
+
+	startTime = system_time();
+	textView->Delete(middle, middle + textView->TextLength() / 4);
+	print_time("delete a quarter of the text", startTime);
+
+	startTime = system_time();
+	int32 lineCount = textView->CountLines();
+	print_time("CountLines(), lays out the rest", startTime);
+
+	startTime = system_time();
+	textView->SetWordWrap(!textView->DoesWordWrap());
+	int32 otherLineCount = textView->CountLines();
+	print_time("toggle word wrap, and CountLines()", startTime);
+
+	printf("%" B_PRId32 " lines, %" B_PRId32 " with word wrap %s\n",
+		lineCount, otherLineCount,
+		textView->DoesWordWrap() ? "on" : "off");
+
+	// every line must be where the text view says it is
+	int32 textLength = textView->TextLength();
+	if (textView->LineAt(textLength) != textView->CountLines() - 1
+		|| textView->OffsetAt(textView->CountLines()) != textLength) {
+		fprintf(stderr, "Line breaks are inconsistent!\n");
+		return false;
+	}
+
+	int32 previousOffset = -1;
+	for (int32 line = 0; line < textView->CountLines(); line++) {
+		int32 offset = textView->OffsetAt(line);
+		if (offset <= previousOffset || textView->LineAt(offset) != line) {
+			fprintf(stderr, "Line %" B_PRId32 " is broken!\n", line);
+			return false;
+		}
+		previousOffset = offset;
+	}
+
+	return true;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int32 megabytes = argc > 1 ? atoi(argv[1]) : 4;
+	if (megabytes <= 0) {
+		fprintf(stderr, "Usage: %s [<megabytes>]\n", argv[0]);
+		return 1;
+	}
+
+	BApplication app("application/x-vnd.Haiku-TextViewBenchmark");
+
+	BString document;
+	create_document(document, megabytes * 1024 * 1024);
+
+	BWindow* window = new BWindow(BRect(100, 100, 700, 500),
+		"TextView-Benchmark", B_TITLED_WINDOW, B_QUIT_ON_WINDOW_CLOSE);
+
+	window->Lock();
+
+	BRect rect = window->Bounds();
+	rect.right -= B_V_SCROLL_BAR_WIDTH;
+	BTextView* textView = new BTextView(rect, "text", rect.OffsetToCopy(0, 0),
+		B_FOLLOW_ALL);
+	window->AddChild(new BScrollView("scroll", textView, B_FOLLOW_ALL, 0,
+		false, true));
+
+	bool success = run_benchmark(textView, document);
+	window->Quit();
+
+	return success ? 0 : 1;
+}
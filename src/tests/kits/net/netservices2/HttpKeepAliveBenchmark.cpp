@@ -0,0 +1,124 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Compares fetching many small resources from a server that keeps the
+	connections open with one that closes them after each response, over
+	http and https.
+
+	Usage: HttpKeepAliveBenchmark [<requests>]
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include <HttpRequest.h>
+#include <HttpResult.h>
+#include <HttpSession.h>
+#include <OS.h>
+#include <Url.h>
+
+#include "TestServer.h"
+
+using BPrivate::Network::BHttpRequest;
+using BPrivate::Network::BHttpResult;
+using BPrivate::Network::BHttpSession;
+
+
+static bool
+get_sequentially(BHttpSession& session, const BUrl& baseUrl, int32 count)
+{
+	for (int32 i = 0; i < count; i++) {
+		auto result = session.Execute(BHttpRequest(BUrl(baseUrl, "/")));
+		if (result.Status().code != 200) {
+			fprintf(stderr, "Request failed with status %d\n",
+				(int)result.Status().code);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+static bool
+get_in_parallel(BHttpSession& session, const BUrl& baseUrl, int32 count)
+{
+	std::vector<BHttpResult> results;
+	for (int32 i = 0; i < count; i++)
+		results.push_back(session.Execute(BHttpRequest(BUrl(baseUrl, "/"))));
+
+	for (auto& result: results) {
+		if (result.Status().code != 200) {
+			fprintf(stderr, "Request failed with status %d\n",
+				(int)result.Status().code);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+static bool
+run_benchmark(const char* name, TestServerMode mode, bool keepAlive,
+	int32 requests)
+{
+	TestServer server(mode, keepAlive);
+	status_t status = server.Start();
+	if (status != B_OK) {
+		fprintf(stderr, "Could not start the test server: %s\n",
+			strerror(status));
+		return false;
+	}
+
+	BHttpSession session;
+	session.SetMaxConnectionsPerHost(4);
+
+	// the first request also waits for the server to come up
+	if (!get_sequentially(session, server.BaseUrl(), 1))
+		return false;
+
+	bigtime_t start = system_time();
+	if (!get_sequentially(session, server.BaseUrl(), requests))
+		return false;
+	bigtime_t sequential = system_time() - start;
+
+	start = system_time();
+	if (!get_in_parallel(session, server.BaseUrl(), requests))
+		return false;
+	bigtime_t parallel = system_time() - start;
+
+	printf("%-20s %6" B_PRId64 " ms sequential, %6" B_PRId64 " ms parallel\n",
+		name, sequential / 1000, parallel / 1000);
+	return true;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int32 requests = argc > 1 ? atoi(argv[1]) : 200;
+	if (requests <= 0) {
+		fprintf(stderr, "Usage: %s [<requests>]\n", argv[0]);
+		return 1;
+	}
+
+	printf("%" B_PRId32 " requests each:\n", requests);
+
+	bool success = run_benchmark("http, keep-alive:", TestServerMode::Http,
+			true, requests)
+		&& run_benchmark("http, close:", TestServerMode::Http, false, requests)
+		&& run_benchmark("https, keep-alive:", TestServerMode::Https, true,
+			requests)
+		&& run_benchmark("https, close:", TestServerMode::Https, false,
+			requests);
+
+	return success ? 0 : 1;
+}
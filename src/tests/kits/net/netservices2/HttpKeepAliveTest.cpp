@@ -0,0 +1,146 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "HttpKeepAliveTest.h"
+
+#include <unistd.h>
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/TestSuite.h>
+
+#include <HttpRequest.h>
+#include <HttpResult.h>
+#include <HttpSession.h>
+#include <Looper.h>
+#include <NetServicesDefs.h>
+#include <OS.h>
+#include <Url.h>
+
+#include "TestServer.h"
+
+using BPrivate::Network::BHttpRequest;
+using BPrivate::Network::BHttpSession;
+
+
+/*!	Counts the debug messages of a session that announce the reuse of an idle
+	connection.
+*/
+class ReuseCounter : public BLooper {
+public:
+	ReuseCounter()
+		:
+		BLooper("ReuseCounter"),
+		fReused(0)
+	{
+	}
+
+	void MessageReceived(BMessage* message) override
+	{
+		using namespace BPrivate::Network;
+
+		if (message->what != UrlEvent::DebugMessage)
+			return;
+
+		BString text = message->GetString(UrlEventData::DebugMessage, "");
+		if (text == "Reusing idle connection")
+			fReused++;
+	}
+
+	int32 Reused()
+	{
+		// wait until all messages of the session have been processed
+		Lock();
+		while (IsMessageWaiting()) {
+			Unlock();
+			usleep(1000);
+			Lock();
+		}
+		int32 reused = fReused;
+		Unlock();
+
+		return reused;
+	}
+
+private:
+	int32 fReused;
+};
+
+
+static void
+get_sequentially(BHttpSession& session, const BUrl& baseUrl, int32 count,
+	BMessenger observer = BMessenger(), bigtime_t pause = 0)
+{
+	for (int32 i = 0; i < count; i++) {
+		auto result = session.Execute(BHttpRequest(BUrl(baseUrl, "/")), nullptr, observer);
+		CPPUNIT_ASSERT_EQUAL(200, (int)result.Status().code);
+		CPPUNIT_ASSERT(result.Body().text.has_value());
+
+		// The result is complete slightly before the session puts the
+		// connection back into its pool.
+		if (pause > 0)
+			snooze(pause);
+	}
+}
+
+
+HttpKeepAliveTest::HttpKeepAliveTest()
+{
+}
+
+
+void
+HttpKeepAliveTest::ConnectionReuseTest()
+{
+	TestServer server(TestServerMode::Http, true);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE("Starting up test server", B_OK, server.Start());
+
+	auto counter = new ReuseCounter();
+	counter->Run();
+
+	BHttpSession session;
+	get_sequentially(session, server.BaseUrl(), 5, BMessenger(counter), 50000);
+
+	// all but the first request must have used the connection of the first
+	CPPUNIT_ASSERT_EQUAL(4, counter->Reused());
+
+	counter->Lock();
+	counter->Quit();
+}
+
+
+void
+HttpKeepAliveTest::ServerCloseTest()
+{
+	// This server answers with HTTP/1.0 and closes every connection
+	TestServer server(TestServerMode::Http, false);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE("Starting up test server", B_OK, server.Start());
+
+	auto counter = new ReuseCounter();
+	counter->Run();
+
+	BHttpSession session;
+	get_sequentially(session, server.BaseUrl(), 5, BMessenger(counter), 50000);
+
+	CPPUNIT_ASSERT_EQUAL(0, counter->Reused());
+
+	counter->Lock();
+	counter->Quit();
+}
+
+
+/* static */ void
+HttpKeepAliveTest::AddTests(BTestSuite& parent)
+{
+	CppUnit::TestSuite& suite = *new CppUnit::TestSuite("HttpKeepAliveTest");
+
+	suite.addTest(new CppUnit::TestCaller<HttpKeepAliveTest>(
+		"HttpKeepAliveTest::ConnectionReuseTest", &HttpKeepAliveTest::ConnectionReuseTest));
+	suite.addTest(new CppUnit::TestCaller<HttpKeepAliveTest>(
+		"HttpKeepAliveTest::ServerCloseTest", &HttpKeepAliveTest::ServerCloseTest));
+
+	parent.addTest("HttpKeepAliveTest", &suite);
+}
@@ -0,0 +1,25 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef HTTP_KEEP_ALIVE_TEST_H
+#define HTTP_KEEP_ALIVE_TEST_H
+
+
+#include <TestCase.h>
+#include <TestSuite.h>
+
+
+class HttpKeepAliveTest : public BTestCase
+{
+public:
+								HttpKeepAliveTest();
+
+			void				ConnectionReuseTest();
+			void				ServerCloseTest();
+
+	static	void				AddTests(BTestSuite& suite);
+};
+
+
+#endif // HTTP_KEEP_ALIVE_TEST_H
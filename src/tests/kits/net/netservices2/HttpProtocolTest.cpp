@@ -278,7 +278,7 @@ HttpProtocolTest::HttpMethodTest()
 constexpr std::string_view kExpectedRequestText = "GET / HTTP/1.1\r\n"
 												  "Host: www.haiku-os.org\r\n"
 												  "Accept-Encoding: gzip\r\n"
-												  "Connection: close\r\n"
+												  "Connection: keep-alive\r\n"
 												  "Api-Key: 01234567890abcdef\r\n\r\n";
 
 
@@ -519,7 +519,7 @@ static const BHttpFields kExpectedGetFields = {
 	{"Server"sv, "Test HTTP Server for Haiku"sv},
 	{"Date"sv, "Sun, 09 Feb 2020 19:32:42 GMT"sv},
 	{"Content-Type"sv, "text/plain"sv},
-	{"Content-Length"sv, "107"sv},
+	{"Content-Length"sv, "112"sv},
 	{"Content-Encoding"sv, "gzip"sv},
 };
 
@@ -530,7 +530,7 @@ constexpr std::string_view kExpectedGetBody = {"Path: /\r\n"
 											   "--------\r\n"
 											   "Host: 127.0.0.1:PORT\r\n"
 											   "Accept-Encoding: gzip\r\n"
-											   "Connection: close\r\n"};
+											   "Connection: keep-alive\r\n"};
 
 
 void
@@ -744,7 +744,7 @@ static BString kExpectedPostBody = BString().SetToFormat("Path: /post\r\n"
 														 "--------\r\n"
 														 "Host: 127.0.0.1:PORT\r\n"
 														 "Accept-Encoding: gzip\r\n"
-														 "Connection: close\r\n"
+														 "Connection: keep-alive\r\n"
 														 "Content-Type: text/plain\r\n"
 														 "Content-Length: 1083\r\n"
 														 "\r\n"
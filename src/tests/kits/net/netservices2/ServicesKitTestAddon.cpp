@@ -8,6 +8,7 @@
 #include <TestSuiteAddon.h>
 
 #include "ExclusiveBorrowTest.h"
+#include "HttpKeepAliveTest.h"
 #include "HttpProtocolTest.h"
 
 
@@ -19,6 +20,7 @@ getTestSuite()
 	ExclusiveBorrowTest::AddTests(*suite);
 	HttpProtocolTest::AddTests(*suite);
 	HttpIntegrationTest::AddTests(*suite);
+	HttpKeepAliveTest::AddTests(*suite);
 
 	return suite;
 }
@@ -11,6 +11,8 @@
 #include <netinet/in.h>
 #include <posix/libgen.h>
 #include <sstream>
+#include <stdio.h>
+#include <string.h>
 #include <string>
 #include <sys/socket.h>
 #include <sys/wait.h>
@@ -18,7 +20,6 @@
 #include <vector>
 
 #include <AutoDeleter.h>
-#include <TestShell.h>
 
 
 namespace {
@@ -208,9 +209,10 @@ ChildProcess::Start(const std::vector<std::string>& args)
 }
 
 
-TestServer::TestServer(TestServerMode mode)
+TestServer::TestServer(TestServerMode mode, bool keepAlive)
 	:
-	fMode(mode)
+	fMode(mode),
+	fKeepAlive(keepAlive)
 {
 }
 
@@ -243,6 +245,10 @@ TestServer::Start()
 		child_process_args.push_back("--use-tls");
 	}
 
+	if (fKeepAlive) {
+		child_process_args.push_back("--keep-alive");
+	}
+
 	// After this the child process has started. It may take a short amount of
 	// time before the child process is ready to call accept(), but that's OK.
 	//
@@ -194,10 +194,11 @@ class RequestHandler(http.server.BaseHTTPRequestHandler):
         return encoding, output_stream.get_bytes()
 
     def _not_supported(self):
+        response_body = '{} not supported\r\n'.format(self.command).encode('utf-8')
         self.send_response(405, '{} not supported'.format(self.command))
+        self.send_header('Content-Length', str(len(response_body)))
         self.end_headers()
-        self.wfile.write(
-            '{} not supported\r\n'.format(self.command).encode('utf-8'))
+        self.wfile.write(response_body)
 
     def _authorize(self):
         """
@@ -247,6 +248,7 @@ class RequestHandler(http.server.BaseHTTPRequestHandler):
                 or password != expected_password:
             self.send_response(401, 'Not authorized')
             self.send_header('Www-Authenticate', 'Basic realm="Fake Realm"')
+            self.send_header('Content-Length', '0')
             self.end_headers()
             return False, []
 
@@ -293,6 +295,7 @@ class RequestHandler(http.server.BaseHTTPRequestHandler):
                 ' stale=FALSE'.format(NONCE, OPAQUE))
             self.send_header('Set-Cookie', 'stale_after=never; Path=/')
             self.send_header('Set-Cookie', 'fake=fake_value; Path=/')
+            self.send_header('Content-Length', '0')
             self.end_headers()
             return False, extra_headers
 
@@ -455,7 +458,15 @@ def main():
         options.bind_addr,
         0 if options.port is None else options.port)
 
-    server = http.server.HTTPServer(
+    if options.keep_alive:
+        # Persistent connections need HTTP/1.1, and a thread per connection
+        # so that an idle connection does not block all the others.
+        RequestHandler.protocol_version = 'HTTP/1.1'
+        server_class = http.server.ThreadingHTTPServer
+    else:
+        server_class = http.server.HTTPServer
+
+    server = server_class(
         bind_addr,
         RequestHandler,
         bind_and_activate=False)
@@ -519,6 +530,13 @@ def parse_args(argv):
         action='store_true',
         help='If set, a self-signed TLS certificate, key and CA will be'
         ' generated for testing purposes.')
+    parser.add_option(
+        '--keep-alive',
+        dest='keep_alive',
+        default=False,
+        action='store_true',
+        help='If set, respond with HTTP/1.1 and keep connections open for'
+        ' further requests.')
     parser.add_option(
         '--port',
         dest='port',
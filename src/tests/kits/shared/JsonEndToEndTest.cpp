@@ -4,6 +4,8 @@
  */
 #include "JsonEndToEndTest.h"
 
+#include <stdio.h>
+
 #include <AutoDeleter.h>
 
 #include <Json.h>
@@ -22,6 +24,94 @@ using namespace BPrivate;
 
 static const size_t kHighVolumeItemCount = 10000;
 static const uint32 kChecksumLimit = 100000;
+static const int32 kLargeDocumentPackageCount = 2000;
+
+
+/*!	Reads from a buffer in memory, but only ever hands out a limited number of
+	bytes at a time, and does not reveal to the parser that the data is in
+	memory already.
+*/
+
+class ChunkedMemoryDataIO : public BDataIO {
+public:
+	ChunkedMemoryDataIO(const char* data, size_t length, size_t chunkSize)
+		:
+		fData(data),
+		fLength(length),
+		fPosition(0),
+		fChunkSize(chunkSize)
+	{
+	}
+
+	virtual ssize_t Read(void* buffer, size_t size)
+	{
+		size_t remaining = fLength - fPosition;
+		if (size > remaining)
+			size = remaining;
+		if (size > fChunkSize)
+			size = fChunkSize;
+
+		memcpy(buffer, fData + fPosition, size);
+		fPosition += size;
+		return size;
+	}
+
+private:
+	const char*			fData;
+	size_t				fLength;
+	size_t				fPosition;
+	size_t				fChunkSize;
+};
+
+
+/*!	Records all events and errors as text so that the results of parsing the
+	same input in different ways can be compared.
+*/
+
+class RecordingJsonEventListener : public BJsonEventListener {
+public:
+	virtual bool Handle(const BJsonEvent& event)
+	{
+		fRecord << (int32)event.EventType();
+		if (event.Content() != NULL)
+			fRecord << " " << event.Content();
+		fRecord << "\n";
+		return true;
+	}
+
+	virtual void HandleError(status_t status, int32 line, const char* message)
+	{
+		fRecord << "error " << status << " line " << line << ": " << message << "\n";
+	}
+
+	virtual void Complete()
+	{
+		fRecord << "complete\n";
+	}
+
+	const BString& Record() const
+	{
+		return fRecord;
+	}
+
+private:
+	BString				fRecord;
+};
+
+
+static void
+append_package(BString& json, int32 index)
+{
+	BString package;
+	package.SetToFormat("%s\n  {\"name\": \"package_%" B_PRId32 "\",\n"
+		"    \"summary\": \"A \\\"sample\\\" package\\nwith \\u00e9scapes\",\n"
+		"    \"description\": \"Some longer text that describes what this package"
+		" is good for, and why someone would want to install it.\",\n"
+		"    \"version\": [%" B_PRId32 ", 2, 3], \"size\": %" B_PRId32 ".5e3,"
+		" \"native\": true, \"source\": null}",
+		index == 0 ? "" : ",", index, index % 17, index * 31);
+	json << package;
+}
 
 
 JsonEndToEndTest::JsonEndToEndTest()
@@ -203,6 +293,131 @@ JsonEndToEndTest::TestObjectA()
 }
 
 
+/*!	Parses the input as a stream that delivers only a few bytes at a time, as
+	a stream that delivers large blocks, and from memory, and checks that the
+	listener sees exactly the same events in each case.
+*/
+
+void
+JsonEndToEndTest::TestBufferedParsing(const char* input)
+{
+	size_t length = strlen(input);
+
+	ChunkedMemoryDataIO trickle(input, length, 1);
+	RecordingJsonEventListener trickleListener;
+	BJson::Parse(&trickle, &trickleListener);
+
+	ChunkedMemoryDataIO stream(input, length, 1000);
+	RecordingJsonEventListener streamListener;
+	BJson::Parse(&stream, &streamListener);
+
+	BMemoryIO memoryIO(input, length);
+	RecordingJsonEventListener memoryListener;
+	BJson::Parse(&memoryIO, &memoryListener);
+
+	BMallocIO mallocIO;
+	mallocIO.Write(input, length);
+	mallocIO.Seek(0, SEEK_SET);
+	RecordingJsonEventListener mallocListener;
+	BJson::Parse(&mallocIO, &mallocListener);
+
+	CPPUNIT_ASSERT(trickleListener.Record() == streamListener.Record());
+	CPPUNIT_ASSERT(trickleListener.Record() == memoryListener.Record());
+	CPPUNIT_ASSERT(trickleListener.Record() == mallocListener.Record());
+}
+
+
+void
+JsonEndToEndTest::TestBufferedParsingSamples()
+{
+	TestBufferedParsing(JSON_SAMPLE_NUMBER_A_IN);
+	TestBufferedParsing(JSON_SAMPLE_STRING_A_IN);
+	TestBufferedParsing(JSON_SAMPLE_STRING_A2_IN);
+	TestBufferedParsing(JSON_SAMPLE_ARRAY_A_IN);
+	TestBufferedParsing(JSON_SAMPLE_ARRAY_B_IN);
+	TestBufferedParsing(JSON_SAMPLE_OBJECT_A_IN);
+	TestBufferedParsing(JSON_SAMPLE_OBJECT_B_IN);
+	TestBufferedParsing(JSON_SAMPLE_BROKEN_UNTERMINATED_STRING);
+	TestBufferedParsing(JSON_SAMPLE_BROKEN_UNTERMINATED_ARRAY);
+	TestBufferedParsing(JSON_SAMPLE_BROKEN_BAD_STRING_ESCAPE);
+	TestBufferedParsing(JSON_SAMPLE_BROKEN_NUMBER);
+	TestBufferedParsing("[\"control \x01 character\"]");
+	TestBufferedParsing(" \r\n\n  [\ttabs are not whitespace]");
+}
+
+
+/*!	Tests strings, whitespace and escape sequences that cross the boundaries of
+	the blocks the parser reads.
+*/
+
+void
+JsonEndToEndTest::TestBufferedParsingLongRuns()
+{
+	BString input("[");
+	for (int32 i = 0; i < 40000; i++)
+		input << (i % 100 == 0 ? "\n" : " ");
+	input << "\"";
+	for (int32 i = 0; i < 40000; i++)
+		input << (char)('a' + i % 26) << (i % 1000 == 0 ? "\\t\\u00e9" : "");
+	input << "\", 12345, \"\\\"\\\\\"]";
+
+	TestBufferedParsing(input.String());
+}
+
+
+/*!	As the parser reads ahead, it needs to give the data after the value back
+	to the input.
+*/
+
+void
+JsonEndToEndTest::TestPositionAfterParsing()
+{
+	const char* input = "[1, 2] {\"next\": true}";
+	RecordingJsonEventListener listener;
+
+	BMemoryIO memoryIO(input, strlen(input));
+	BJson::Parse(&memoryIO, &listener);
+	CPPUNIT_ASSERT_EQUAL((off_t)6, memoryIO.Position());
+
+	BMallocIO mallocIO;
+	mallocIO.Write(input, strlen(input));
+	mallocIO.Seek(0, SEEK_SET);
+	BJson::Parse(&mallocIO, &listener);
+	CPPUNIT_ASSERT_EQUAL((off_t)6, mallocIO.Position());
+}
+
+
+/*!	Checks that a large HaikuDepot like document is parsed the same way from a
+	stream that delivers large blocks, and from memory. JsonParseBenchmark
+	measures how fast that is.
+*/
+
+void
+JsonEndToEndTest::TestLargeDocumentParsing()
+{
+	BString json("[");
+	for (int32 i = 0; i < kLargeDocumentPackageCount; i++)
+		append_package(json, i);
+	json << "\n]\n";
+
+	size_t length = json.Length();
+
+	ChunkedMemoryDataIO stream(json.String(), length, 64 * 1024);
+	ChecksumJsonEventListener streamListener(kChecksumLimit);
+	BJson::Parse(&stream, &streamListener);
+
+	BMallocIO mallocIO;
+	mallocIO.Write(json.String(), length);
+	mallocIO.Seek(0, SEEK_SET);
+	ChecksumJsonEventListener memoryListener(kChecksumLimit);
+	BJson::Parse(&mallocIO, &memoryListener);
+
+	CPPUNIT_ASSERT_EQUAL(B_OK, streamListener.Error());
+	CPPUNIT_ASSERT_EQUAL(B_OK, memoryListener.Error());
+	CPPUNIT_ASSERT_EQUAL(streamListener.Checksum(), memoryListener.Checksum());
+}
+
+
 /*! This method will test an element being unterminated; such an object that
     is missing the terminating "}" symbol or a string that has no closing
     quote.  This is tested here because the writer
@@ -289,6 +504,18 @@ JsonEndToEndTest::AddTests(BTestSuite& parent)
 	suite.addTest(new CppUnit::TestCaller<JsonEndToEndTest>(
 		"JsonEndToEndTest::TestHighVolumeNumberSampleGenerationOnly",
 		&JsonEndToEndTest::TestHighVolumeNumberSampleGenerationOnly));
+	suite.addTest(new CppUnit::TestCaller<JsonEndToEndTest>(
+		"JsonEndToEndTest::TestBufferedParsingSamples",
+		&JsonEndToEndTest::TestBufferedParsingSamples));
+	suite.addTest(new CppUnit::TestCaller<JsonEndToEndTest>(
+		"JsonEndToEndTest::TestBufferedParsingLongRuns",
+		&JsonEndToEndTest::TestBufferedParsingLongRuns));
+	suite.addTest(new CppUnit::TestCaller<JsonEndToEndTest>(
+		"JsonEndToEndTest::TestPositionAfterParsing",
+		&JsonEndToEndTest::TestPositionAfterParsing));
+	suite.addTest(new CppUnit::TestCaller<JsonEndToEndTest>(
+		"JsonEndToEndTest::TestLargeDocumentParsing",
+		&JsonEndToEndTest::TestLargeDocumentParsing));
 
 	parent.addTest("JsonEndToEndTest", &suite);
 }
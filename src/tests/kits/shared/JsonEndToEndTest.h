@@ -38,9 +38,15 @@ public:
 			void				TestArrayUnterminated();
 			void				TestObjectUnterminated();
 
+			void				TestBufferedParsingSamples();
+			void				TestBufferedParsingLongRuns();
+			void				TestPositionAfterParsing();
+			void				TestLargeDocumentParsing();
+
 	static	void				AddTests(BTestSuite& suite);
 private:
 			void				TestUnterminated(const char* input);
+			void				TestBufferedParsing(const char* input);
 
 			void				TestParseAndWrite(const char* input,
 									const char* expectedOutput);
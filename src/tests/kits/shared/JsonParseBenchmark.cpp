@@ -0,0 +1,142 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures how fast a HaikuDepot like document is parsed from a stream that
+	hands out 64 KB at a time, and from memory.
+
+	Usage: JsonParseBenchmark [<packages>]
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <DataIO.h>
+#include <OS.h>
+#include <String.h>
+
+#include <Json.h>
+
+#include "ChecksumJsonEventListener.h"
+
+
+using namespace BPrivate;
+
+
+static const uint32 kChecksumLimit = 100000;
+
+
+/*!	Reads from a buffer in memory, but does not reveal to the parser that the
+	data is in memory already.
+*/
+class ChunkedMemoryDataIO : public BDataIO {
+public:
+	ChunkedMemoryDataIO(const char* data, size_t length, size_t chunkSize)
+		:
+		fData(data),
+		fLength(length),
+		fPosition(0),
+		fChunkSize(chunkSize)
+	{
+	}
+
+	virtual ssize_t Read(void* buffer, size_t size)
+	{
+		size_t remaining = fLength - fPosition;
+		if (size > remaining)
+			size = remaining;
+		if (size > fChunkSize)
+			size = fChunkSize;
+
+		memcpy(buffer, fData + fPosition, size);
+		fPosition += size;
+		return size;
+	}
+
+private:
+	const char*			fData;
+	size_t				fLength;
+	size_t				fPosition;
+	size_t				fChunkSize;
+};
+
+
+static void
+append_package(BString& json, int32 index)
+{
+	BString package;
+	package.SetToFormat("%s\n  {\"name\": \"package_%" B_PRId32 "\",\n"
+		"    \"summary\": \"A \\\"sample\\\" package\\nwith \\u00e9scapes\",\n"
+		"    \"description\": \"Some longer text that describes what this package"
+		" is good for, and why someone would want to install it.\",\n"
+		"    \"version\": [%" B_PRId32 ", 2, 3], \"size\": %" B_PRId32 ".5e3,"
+		" \"native\": true, \"source\": null}",
+		index == 0 ? "" : ",", index, index % 17, index * 31);
+	json << package;
+}
+
+
+static bool
+parse(BDataIO* input, const char* what, double megabytes, uint32* _checksum)
+{
+	ChecksumJsonEventListener listener(kChecksumLimit);
+
+	bigtime_t startTime = system_time();
+	BJson::Parse(input, &listener);
+	bigtime_t time = system_time() - startTime;
+
+	if (listener.Error() != B_OK) {
+		fprintf(stderr, "Parsing from %s failed: %s\n", what,
+			strerror(listener.Error()));
+		return false;
+	}
+
+	printf("%-10s %6" B_PRId64 " ms, %8.1f MB/s\n", what, time / 1000,
+		megabytes * 1000000 / (time + 1));
+
+	*_checksum = listener.Checksum();
+	return true;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int32 packageCount = argc > 1 ? atoi(argv[1]) : 20000;
+	if (packageCount <= 0) {
+		fprintf(stderr, "Usage: %s [<packages>]\n", argv[0]);
+		return 1;
+	}
+
+	BString json("[");
+	for (int32 i = 0; i < packageCount; i++)
+		append_package(json, i);
+	json << "\n]\n";
+
+	size_t length = json.Length();
+	double megabytes = length / (1024.0 * 1024.0);
+	printf("Parsing %.1f MB\n", megabytes);
+
+	ChunkedMemoryDataIO stream(json.String(), length, 64 * 1024);
+	uint32 streamChecksum;
+	if (!parse(&stream, "stream", megabytes, &streamChecksum))
+		return 1;
+
+	BMallocIO mallocIO;
+	mallocIO.Write(json.String(), length);
+	mallocIO.Seek(0, SEEK_SET);
+	uint32 memoryChecksum;
+	if (!parse(&mallocIO, "memory", megabytes, &memoryChecksum))
+		return 1;
+
+	if (streamChecksum != memoryChecksum) {
+		fprintf(stderr, "The checksums differ!\n");
+		return 1;
+	}
+
+	return 0;
+}
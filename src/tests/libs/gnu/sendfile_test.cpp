@@ -0,0 +1,257 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Checks sendfile() and copy_file_range(), and compares their throughput
+	with a read()/write() loop.
+*/
+
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+
+static const size_t kBufferSize = 64 * 1024;
+
+
+static void*
+drain_socket(void* _socket)
+{
+	int socket = (int)(addr_t)_socket;
+	size_t* total = new size_t(0);
+	char buffer[kBufferSize];
+
+	while (true) {
+		ssize_t bytesRead = read(socket, buffer, sizeof(buffer));
+		if (bytesRead <= 0)
+			break;
+		*total += bytesRead;
+	}
+
+	close(socket);
+	return total;
+}
+
+
+static bool
+connect_sockets(int& client, int& server)
+{
+	int listener = socket(AF_INET, SOCK_STREAM, 0);
+	if (listener < 0)
+		return false;
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_len = sizeof(address);
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	socklen_t length = sizeof(address);
+	if (bind(listener, (sockaddr*)&address, sizeof(address)) != 0
+		|| listen(listener, 1) != 0
+		|| getsockname(listener, (sockaddr*)&address, &length) != 0) {
+		close(listener);
+		return false;
+	}
+
+	client = socket(AF_INET, SOCK_STREAM, 0);
+	if (client < 0 || connect(client, (sockaddr*)&address, length) != 0) {
+		close(listener);
+		return false;
+	}
+
+	server = accept(listener, NULL, NULL);
+	close(listener);
+	return server >= 0;
+}
+
+
+static ssize_t
+read_write_loop(int from, int to, size_t length)
+{
+	char* buffer = (char*)malloc(kBufferSize);
+	size_t total = 0;
+
+	while (total < length) {
+		ssize_t bytesRead = read(from, buffer, kBufferSize);
+		if (bytesRead <= 0)
+			break;
+
+		ssize_t bytesWritten = write(to, buffer, bytesRead);
+		if (bytesWritten != bytesRead)
+			break;
+
+		total += bytesWritten;
+	}
+
+	free(buffer);
+	return total;
+}
+
+
+static ssize_t
+sendfile_loop(int from, int to, size_t length)
+{
+	size_t total = 0;
+	while (total < length) {
+		ssize_t bytesSent = sendfile(to, from, NULL, length - total);
+		if (bytesSent <= 0)
+			break;
+		total += bytesSent;
+	}
+
+	return total;
+}
+
+
+static ssize_t
+copy_file_range_loop(int from, int to, size_t length)
+{
+	size_t total = 0;
+	while (total < length) {
+		ssize_t bytesCopied = copy_file_range(from, NULL, to, NULL,
+			length - total, 0);
+		if (bytesCopied <= 0)
+			break;
+		total += bytesCopied;
+	}
+
+	return total;
+}
+
+
+typedef ssize_t (*transfer_func)(int from, int to, size_t length);
+
+
+static void
+benchmark_socket(const char* name, transfer_func transfer, int file,
+	size_t length)
+{
+	int client;
+	int server;
+	if (!connect_sockets(client, server)) {
+		fprintf(stderr, "%s: could not connect: %s\n", name, strerror(errno));
+		exit(1);
+	}
+
+	pthread_t thread;
+	pthread_create(&thread, NULL, &drain_socket, (void*)(addr_t)server);
+
+	lseek(file, 0, SEEK_SET);
+
+	bigtime_t start = system_time();
+	ssize_t sent = transfer(file, client, length);
+	close(client);
+
+	size_t* received;
+	pthread_join(thread, (void**)&received);
+	bigtime_t time = system_time() - start;
+
+	printf("%-24s %8.1f MB/s\n", name, length / (time / 1000000.0)
+		/ (1024 * 1024));
+
+	if (sent != (ssize_t)length || *received != length) {
+		fprintf(stderr, "%s: sent %zd, received %zu of %zu bytes\n", name,
+			sent, *received, length);
+		exit(1);
+	}
+	delete received;
+}
+
+
+static void
+benchmark_file(const char* name, transfer_func transfer, int file,
+	const char* targetPath, size_t length)
+{
+	int target = open(targetPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (target < 0) {
+		fprintf(stderr, "%s: could not create %s: %s\n", name, targetPath,
+			strerror(errno));
+		exit(1);
+	}
+
+	lseek(file, 0, SEEK_SET);
+
+	bigtime_t start = system_time();
+	ssize_t copied = transfer(file, target, length);
+	fsync(target);
+	bigtime_t time = system_time() - start;
+
+	printf("%-24s %8.1f MB/s\n", name, length / (time / 1000000.0)
+		/ (1024 * 1024));
+
+	if (copied != (ssize_t)length) {
+		fprintf(stderr, "%s: copied %zd of %zu bytes\n", name, copied, length);
+		exit(1);
+	}
+
+	// verify the contents
+	char* expected = (char*)malloc(kBufferSize);
+	char* actual = (char*)malloc(kBufferSize);
+	for (off_t offset = 0; offset < (off_t)length; offset += kBufferSize) {
+		ssize_t bytes = pread(file, expected, kBufferSize, offset);
+		if (bytes <= 0 || pread(target, actual, bytes, offset) != bytes
+			|| memcmp(expected, actual, bytes) != 0) {
+			fprintf(stderr, "%s: contents differ at %" B_PRIdOFF "\n", name,
+				offset);
+			exit(1);
+		}
+	}
+	free(expected);
+	free(actual);
+
+	close(target);
+	unlink(targetPath);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	size_t length = 256 * 1024 * 1024;
+	if (argc > 1)
+		length = strtoul(argv[1], NULL, 0) * 1024 * 1024;
+
+	const char* path = "/tmp/sendfile_test.source";
+	int file = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (file < 0) {
+		fprintf(stderr, "could not create %s: %s\n", path, strerror(errno));
+		return 1;
+	}
+
+	char* buffer = (char*)malloc(kBufferSize);
+	for (size_t offset = 0; offset < length; offset += kBufferSize) {
+		for (size_t i = 0; i < kBufferSize; i++)
+			buffer[i] = (char)(offset / kBufferSize + i * 7);
+		write(file, buffer, kBufferSize);
+	}
+	free(buffer);
+
+	benchmark_socket("read/write to socket", &read_write_loop, file, length);
+	benchmark_socket("sendfile to socket", &sendfile_loop, file, length);
+
+	const char* targetPath = "/tmp/sendfile_test.target";
+	benchmark_file("read/write to file", &read_write_loop, file, targetPath,
+		length);
+	benchmark_file("copy_file_range to file", &copy_file_range_loop, file,
+		targetPath, length);
+	benchmark_file("sendfile to file", &sendfile_loop, file, targetPath,
+		length);
+
+	close(file);
+	unlink(path);
+	return 0;
+}
@@ -17,6 +17,7 @@
 // tests
 #include "HorizontalLineTest.h"
 #include "RandomLineTest.h"
+#include "RepeatedStringTest.h"
 #include "StringTest.h"
 #include "VerticalLineTest.h"
 
@@ -29,6 +30,7 @@ struct test_info {
 const test_info kTestInfos[] = {
 	{ "HorizontalLines",	HorizontalLineTest::CreateTest },
 	{ "RandomLines",		RandomLineTest::CreateTest },
+	{ "RepeatedStrings",	RepeatedStringTest::CreateTest },
 	{ "Strings",			StringTest::CreateTest },
 	{ "VerticalLines",		VerticalLineTest::CreateTest },
 	{ NULL, NULL }
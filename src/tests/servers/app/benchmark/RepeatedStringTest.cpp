@@ -0,0 +1,108 @@
+/*
+ * Copyright 2026, Haiku. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "RepeatedStringTest.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <View.h>
+
+
+RepeatedStringTest::RepeatedStringTest()
+	: Test(),
+	  fTestDuration(0),
+	  fTestStart(-1),
+	  fGlyphsRendered(0),
+	  fGlyphsPerLine(40),
+	  fIterations(0),
+	  fMaxIterations(1500),
+
+	  fStartHeight(11.0),
+	  fLineHeight(15.0)
+{
+}
+
+
+RepeatedStringTest::~RepeatedStringTest()
+{
+}
+
+
+void
+RepeatedStringTest::Prepare(BView* view)
+{
+	font_height fh;
+	view->GetFontHeight(&fh);
+	fLineHeight = ceilf(fh.ascent) + ceilf(fh.descent)
+		+ ceilf(fh.leading);
+	fStartHeight = ceilf(fh.ascent) + ceilf(fh.descent);
+	fViewBounds = view->Bounds();
+
+	for (int32 i = 0; i < kLineCount; i++) {
+		char* buffer = fLines[i].LockBuffer(fGlyphsPerLine + 1);
+		for (uint32 j = 0; j < fGlyphsPerLine; j++)
+			buffer[j] = 'A' + rand() % ('z' - 'A');
+		fLines[i].UnlockBuffer(fGlyphsPerLine);
+	}
+
+	fTestDuration = 0;
+	fGlyphsRendered = 0;
+	fIterations = 0;
+	fTestStart = system_time();
+}
+
+
+bool
+RepeatedStringTest::RunIteration(BView* view)
+{
+	BPoint textLocation(5, fStartHeight);
+
+	bigtime_t now = system_time();
+
+	for (int32 i = 0; i < kLineCount; i++) {
+		view->DrawString(fLines[i].String(), textLocation);
+
+		fGlyphsRendered += fGlyphsPerLine;
+
+		textLocation.y += fLineHeight;
+		if (textLocation.y > fViewBounds.bottom)
+			break;
+	}
+
+	view->Sync();
+
+	fTestDuration += system_time() - now;
+	fIterations++;
+
+	return fIterations < fMaxIterations;
+}
+
+
+void
+RepeatedStringTest::PrintResults(BView* view)
+{
+	if (fTestDuration == 0) {
+		printf("Test was not run.\n");
+		return;
+	}
+	bigtime_t timeLeak = system_time() - fTestStart - fTestDuration;
+
+	Test::PrintResults(view);
+
+	printf("Glyphs per DrawString() call: %" B_PRIu32 "\n", fGlyphsPerLine);
+	printf("Glyphs per second: %.3f\n",
+		fGlyphsRendered * 1000000.0 / fTestDuration);
+	printf("Average time between iterations: %.4f seconds.\n",
+		(float)timeLeak / fIterations / 1000000);
+}
+
+
+Test*
+RepeatedStringTest::CreateTest()
+{
+	return new RepeatedStringTest();
+}
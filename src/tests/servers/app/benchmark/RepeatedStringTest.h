@@ -0,0 +1,44 @@
+/*
+ * Copyright 2026, Haiku. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef REPEATED_STRING_TEST_H
+#define REPEATED_STRING_TEST_H
+
+#include <Rect.h>
+#include <String.h>
+
+#include "Test.h"
+
+// Unlike StringTest, this draws the same lines at the same positions in every
+// iteration, like a list or text view that is redrawn.
+class RepeatedStringTest : public Test {
+public:
+								RepeatedStringTest();
+	virtual						~RepeatedStringTest();
+
+	virtual	void				Prepare(BView* view);
+	virtual	bool				RunIteration(BView* view);
+	virtual	void				PrintResults(BView* view);
+
+	static	Test*				CreateTest();
+
+private:
+	enum {
+		kLineCount = 64
+	};
+
+	bigtime_t					fTestDuration;
+	bigtime_t					fTestStart;
+	uint64						fGlyphsRendered;
+	uint32						fGlyphsPerLine;
+	uint32						fIterations;
+	uint32						fMaxIterations;
+
+	float						fStartHeight;
+	float						fLineHeight;
+	BRect						fViewBounds;
+	BString						fLines[kLineCount];
+};
+
+#endif // REPEATED_STRING_TEST_H
@@ -7,6 +7,9 @@
 #include <TestSuiteAddon.h>
 
 #include "SimpleTransformTest.h"
+#if APPSERVER_SPAN_BLEND_SIMD
+#	include "SpanBlendTest.h"
+#endif
 
 
 BTestSuite*
@@ -15,6 +18,9 @@ getTestSuite()
 	BTestSuite* suite = new BTestSuite("AppServerUnitTests");
 
 	SimpleTransformTest::AddTests(*suite);
+#if APPSERVER_SPAN_BLEND_SIMD
+	SpanBlendTest::AddTests(*suite);
+#endif
 
 	return suite;
 }
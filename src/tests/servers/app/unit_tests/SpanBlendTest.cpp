@@ -0,0 +1,229 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "SpanBlendTest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cppunit/TestCaller.h>
+#include <cppunit/TestSuite.h>
+
+
+static const unsigned kMaxSpanLength = 67;
+static const int kIterations = 5000;
+
+
+// Returns random values with a bias towards the 0 and 255 special cases.
+static uint8
+random_cover(uint32& seed)
+{
+	seed = seed * 1103515245 + 12345;
+	uint32 value = seed >> 16;
+	switch (value & 3) {
+		case 0:
+			return 0;
+		case 1:
+			return 255;
+		default:
+			return value >> 8;
+	}
+}
+
+
+static uint8
+random_byte(uint32& seed)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 16;
+}
+
+
+static void
+run_fill(const span_blenders& blenders, uint8* dst, unsigned len,
+	uint32 seed)
+{
+	uint32 color = span_pixel(random_byte(seed), random_byte(seed),
+		random_byte(seed));
+	blenders.fill((uint32*)dst, color, len);
+}
+
+
+static void
+run_blend_covers(const span_blenders& blenders, uint8* dst, unsigned len,
+	uint32 seed)
+{
+	uint8 covers[kMaxSpanLength];
+	for (unsigned i = 0; i < len; i++)
+		covers[i] = random_cover(seed);
+	uint32 color = span_pixel(random_byte(seed), random_byte(seed),
+		random_byte(seed));
+	blenders.blend_covers(dst, color, covers, len);
+}
+
+
+static void
+run_blend_covers_subpix(const span_blenders& blenders, uint8* dst,
+	unsigned len, uint32 seed)
+{
+	uint8 covers[kMaxSpanLength * 3];
+	for (unsigned i = 0; i < len * 3; i++)
+		covers[i] = random_cover(seed);
+	uint32 color = span_pixel(random_byte(seed), random_byte(seed),
+		random_byte(seed));
+	blenders.blend_covers_subpix(dst, color, covers, len, (seed & 1) != 0);
+}
+
+
+static void
+run_blend16_covers(const span_blenders& blenders, uint8* dst, unsigned len,
+	uint32 seed)
+{
+	uint8 covers[kMaxSpanLength];
+	for (unsigned i = 0; i < len; i++)
+		covers[i] = random_cover(seed);
+	uint32 color = span_pixel(random_byte(seed), random_byte(seed),
+		random_byte(seed));
+	blenders.blend16_covers(dst, color, random_cover(seed), covers, len);
+}
+
+
+static void
+run_blend16_colors(const span_blenders& blenders, uint8* dst, unsigned len,
+	uint32 seed)
+{
+	uint8 covers[kMaxSpanLength];
+	agg::rgba8 colors[kMaxSpanLength];
+	for (unsigned i = 0; i < len; i++) {
+		covers[i] = random_cover(seed);
+		colors[i].r = random_byte(seed);
+		colors[i].g = random_byte(seed);
+		colors[i].b = random_byte(seed);
+		colors[i].a = random_cover(seed);
+	}
+	blenders.blend16_colors(dst, colors, covers, len);
+}
+
+
+static void
+run_average_covers(const span_blenders& blenders, uint8* dst, unsigned len,
+	uint32 seed)
+{
+	uint8 covers[kMaxSpanLength];
+	for (unsigned i = 0; i < len; i++)
+		covers[i] = random_cover(seed);
+	uint32 color = span_pixel(random_byte(seed), random_byte(seed),
+		random_byte(seed));
+	blenders.average_covers(dst, color, covers, len);
+}
+
+
+// #pragma mark -
+
+
+void
+SpanBlendTest::_Compare(const char* kernel, const span_blenders& blenders,
+	void (*run)(const span_blenders& blenders, uint8* dst, unsigned len,
+		uint32 seed))
+{
+	// the extra pixel lets us check misaligned destinations, too
+	uint8 expected[(kMaxSpanLength + 1) * 4];
+	uint8 actual[(kMaxSpanLength + 1) * 4];
+
+	uint32 seed = 42;
+	for (int i = 0; i < kIterations; i++) {
+		unsigned len = 1 + random_byte(seed) % kMaxSpanLength;
+		unsigned offset = (random_byte(seed) & 1) * 4;
+		for (unsigned j = 0; j < sizeof(expected); j++)
+			expected[j] = actual[j] = random_byte(seed);
+
+		uint32 runSeed = seed;
+		run(gScalarSpanBlenders, expected + offset, len, runSeed);
+		run(blenders, actual + offset, len, runSeed);
+
+		if (memcmp(expected, actual, sizeof(expected)) != 0) {
+			char message[128];
+			snprintf(message, sizeof(message),
+				"%s %s differs from scalar (span length %u)", blenders.name,
+				kernel, len);
+			CPPUNIT_FAIL(message);
+		}
+	}
+}
+
+
+#define COMPARE_KERNEL(kernel, function) \
+	{ \
+		_Compare(kernel, gSSE2SpanBlenders, function); \
+		if (__builtin_cpu_supports("avx2")) \
+			_Compare(kernel, gAVX2SpanBlenders, function); \
+	}
+
+
+void
+SpanBlendTest::Fill()
+{
+	COMPARE_KERNEL("fill", run_fill);
+}
+
+
+void
+SpanBlendTest::BlendCovers()
+{
+	COMPARE_KERNEL("blend_covers", run_blend_covers);
+}
+
+
+void
+SpanBlendTest::BlendCoversSubpix()
+{
+	COMPARE_KERNEL("blend_covers_subpix", run_blend_covers_subpix);
+}
+
+
+void
+SpanBlendTest::Blend16Covers()
+{
+	COMPARE_KERNEL("blend16_covers", run_blend16_covers);
+}
+
+
+void
+SpanBlendTest::Blend16Colors()
+{
+	COMPARE_KERNEL("blend16_colors", run_blend16_colors);
+}
+
+
+void
+SpanBlendTest::AverageCovers()
+{
+	COMPARE_KERNEL("average_covers", run_average_covers);
+}
+
+
+/* static */ void
+SpanBlendTest::AddTests(BTestSuite& parent)
+{
+	CppUnit::TestSuite* const suite = new CppUnit::TestSuite(
+		"SpanBlendTest");
+
+	suite->addTest(new CppUnit::TestCaller<SpanBlendTest>(
+		"SpanBlendTest::Fill", &SpanBlendTest::Fill));
+	suite->addTest(new CppUnit::TestCaller<SpanBlendTest>(
+		"SpanBlendTest::BlendCovers", &SpanBlendTest::BlendCovers));
+	suite->addTest(new CppUnit::TestCaller<SpanBlendTest>(
+		"SpanBlendTest::BlendCoversSubpix",
+		&SpanBlendTest::BlendCoversSubpix));
+	suite->addTest(new CppUnit::TestCaller<SpanBlendTest>(
+		"SpanBlendTest::Blend16Covers", &SpanBlendTest::Blend16Covers));
+	suite->addTest(new CppUnit::TestCaller<SpanBlendTest>(
+		"SpanBlendTest::Blend16Colors", &SpanBlendTest::Blend16Colors));
+	suite->addTest(new CppUnit::TestCaller<SpanBlendTest>(
+		"SpanBlendTest::AverageCovers", &SpanBlendTest::AverageCovers));
+
+	parent.addTest("SpanBlendTest", suite);
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef SPAN_BLEND_TEST_H
+#define SPAN_BLEND_TEST_H
+
+#include <TestCase.h>
+#include <TestSuite.h>
+
+#include "SpanBlend.h"
+
+
+class SpanBlendTest : public BTestCase {
+public:
+	static	void			AddTests(BTestSuite& parent);
+
+			void			Fill();
+			void			BlendCovers();
+			void			BlendCoversSubpix();
+			void			Blend16Covers();
+			void			Blend16Colors();
+			void			AverageCovers();
+
+private:
+			void			_Compare(const char* kernel,
+								const span_blenders& blenders,
+								void (*run)(const span_blenders& blenders,
+									uint8* dst, unsigned len, uint32 seed));
+};
+
+
+#endif // SPAN_BLEND_TEST_H
@@ -0,0 +1,328 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	An echo server on the loopback interface, once with a thread per
+	connection, and once with a single thread that drives all connections
+	through an I/O ring. A number of client threads send small messages, and
+	wait for their echo.
+
+	Usage: io_ring_echo_test [<connections> [<message size>]]
+*/
+
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+#include <IORing.h>
+
+
+static const bigtime_t kRunTime = 2000000;
+static const int32 kMaxMessageSize = 65536;
+
+static int32 sConnectionCount = 64;
+static int32 sMessageSize = 64;
+static int32 sQuit;
+
+
+enum {
+	OP_ACCEPT	= 0,
+	OP_RECEIVE,
+	OP_SEND
+};
+
+
+static uint64
+make_user_data(int32 connection, int32 op)
+{
+	return (uint64)connection << 8 | op;
+}
+
+
+static int
+create_server_socket(uint16& port)
+{
+	int server = socket(AF_INET, SOCK_STREAM, 0);
+
+	sockaddr_in address = {};
+	address.sin_len = sizeof(address);
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	if (bind(server, (sockaddr*)&address, sizeof(address)) != 0
+		|| listen(server, sConnectionCount) != 0) {
+		fprintf(stderr, "Could not set up server socket: %s\n",
+			strerror(errno));
+		exit(1);
+	}
+
+	socklen_t length = sizeof(address);
+	getsockname(server, (sockaddr*)&address, &length);
+	port = ntohs(address.sin_port);
+	return server;
+}
+
+
+//	#pragma mark - clients
+
+
+static status_t
+client_thread(void* data)
+{
+	uint16 port = (uint16)(addr_t)data;
+
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	int noDelay = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+	sockaddr_in address = {};
+	address.sin_len = sizeof(address);
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+		fprintf(stderr, "Could not connect: %s\n", strerror(errno));
+		close(fd);
+		return 0;
+	}
+
+	char message[kMaxMessageSize];
+	memset(message, 'x', sMessageSize);
+
+	int32 roundTrips = 0;
+	while (atomic_get(&sQuit) == 0) {
+		if (send(fd, message, sMessageSize, 0) != sMessageSize)
+			break;
+
+		ssize_t received = 0;
+		while (received < sMessageSize) {
+			ssize_t bytes = recv(fd, message + received,
+				sMessageSize - received, 0);
+			if (bytes <= 0)
+				break;
+			received += bytes;
+		}
+		if (received < sMessageSize)
+			break;
+
+		roundTrips++;
+	}
+
+	close(fd);
+	return roundTrips;
+}
+
+
+static void
+run_clients(const char* mode, uint16 port)
+{
+	thread_id* threads = new thread_id[sConnectionCount];
+	atomic_set(&sQuit, 0);
+
+	bigtime_t start = system_time();
+	for (int32 i = 0; i < sConnectionCount; i++) {
+		threads[i] = spawn_thread(&client_thread, "echo client",
+			B_NORMAL_PRIORITY, (void*)(addr_t)port);
+		resume_thread(threads[i]);
+	}
+
+	snooze(kRunTime);
+	atomic_set(&sQuit, 1);
+
+	int64 roundTrips = 0;
+	for (int32 i = 0; i < sConnectionCount; i++) {
+		status_t result;
+		if (wait_for_thread(threads[i], &result) == B_OK)
+			roundTrips += result;
+	}
+	bigtime_t runTime = system_time() - start;
+	delete[] threads;
+
+	printf("%-18s %8.0f round trips/s\n", mode,
+		roundTrips * 1000000.0 / runTime);
+}
+
+
+//	#pragma mark - thread per connection server
+
+
+static status_t
+echo_thread(void* data)
+{
+	int fd = (int)(addr_t)data;
+	char buffer[kMaxMessageSize];
+
+	while (true) {
+		ssize_t bytes = recv(fd, buffer, sizeof(buffer), 0);
+		if (bytes <= 0 || send(fd, buffer, bytes, 0) != bytes)
+			break;
+	}
+
+	close(fd);
+	return B_OK;
+}
+
+
+static status_t
+threaded_server(void* data)
+{
+	int server = (int)(addr_t)data;
+
+	for (int32 i = 0; i < sConnectionCount; i++) {
+		int fd = accept(server, NULL, NULL);
+		if (fd < 0)
+			break;
+
+		thread_id thread = spawn_thread(&echo_thread, "echo",
+			B_NORMAL_PRIORITY, (void*)(addr_t)fd);
+		resume_thread(thread);
+	}
+
+	return B_OK;
+}
+
+
+//	#pragma mark - I/O ring server
+
+
+struct ring_server {
+	int		server;
+	uint32	flags;
+};
+
+
+static status_t
+ring_server_thread(void* data)
+{
+	ring_server* config = (ring_server*)data;
+
+	IORing ring;
+	status_t status = ring.Init(sConnectionCount * 2, config->flags);
+	if (status != B_OK) {
+		fprintf(stderr, "Could not create ring: %s\n", strerror(status));
+		return status;
+	}
+
+	int* sockets = new int[sConnectionCount];
+	char* buffers = new char[sConnectionCount * kMaxMessageSize];
+
+	for (int32 i = 0; i < sConnectionCount; i++)
+		ring.Accept(config->server, 0, make_user_data(i, OP_ACCEPT));
+	ring.Submit();
+
+	int32 pending = sConnectionCount;
+	while (pending > 0) {
+		io_ring_cqe completion;
+		if (ring.WaitForCompletion(completion) != B_OK)
+			break;
+
+		do {
+			pending--;
+
+			int32 connection = completion.user_data >> 8;
+			char* buffer = buffers + connection * kMaxMessageSize;
+
+			switch (completion.user_data & 0xff) {
+				case OP_ACCEPT:
+					if (completion.result < 0)
+						break;
+					sockets[connection] = completion.result;
+					ring.Receive(sockets[connection], buffer, kMaxMessageSize,
+						0, make_user_data(connection, OP_RECEIVE));
+					pending++;
+					break;
+
+				case OP_RECEIVE:
+					if (completion.result <= 0) {
+						close(sockets[connection]);
+						break;
+					}
+					ring.Send(sockets[connection], buffer, completion.result,
+						0, make_user_data(connection, OP_SEND));
+					pending++;
+					break;
+
+				case OP_SEND:
+					if (completion.result <= 0) {
+						close(sockets[connection]);
+						break;
+					}
+					ring.Receive(sockets[connection], buffer, kMaxMessageSize,
+						0, make_user_data(connection, OP_RECEIVE));
+					pending++;
+					break;
+			}
+		} while (ring.GetCompletion(completion));
+
+		ring.Submit();
+	}
+
+	delete[] sockets;
+	delete[] buffers;
+	return B_OK;
+}
+
+
+static void
+run_ring_server(const char* mode, uint32 flags)
+{
+	uint16 port;
+	ring_server config;
+	config.server = create_server_socket(port);
+	config.flags = flags;
+
+	thread_id thread = spawn_thread(&ring_server_thread, "ring server",
+		B_NORMAL_PRIORITY, &config);
+	resume_thread(thread);
+
+	run_clients(mode, port);
+
+	close(config.server);
+	status_t result;
+	wait_for_thread(thread, &result);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	if (argc > 1)
+		sConnectionCount = atoi(argv[1]);
+	if (argc > 2)
+		sMessageSize = atoi(argv[2]);
+
+	if (sConnectionCount <= 0 || sConnectionCount > IO_RING_MAX_ENTRIES / 2
+		|| sMessageSize <= 0 || sMessageSize > kMaxMessageSize) {
+		fprintf(stderr, "Usage: %s [<connections> [<message size>]]\n",
+			argv[0]);
+		return 1;
+	}
+
+	printf("%" B_PRId32 " connections, %" B_PRId32 " byte messages\n",
+		sConnectionCount, sMessageSize);
+
+	uint16 port;
+	int server = create_server_socket(port);
+	thread_id thread = spawn_thread(&threaded_server, "threaded server",
+		B_NORMAL_PRIORITY, (void*)(addr_t)server);
+	resume_thread(thread);
+	run_clients("thread per client", port);
+	close(server);
+	status_t result;
+	wait_for_thread(thread, &result);
+
+	run_ring_server("ring", 0);
+	run_ring_server("ring (polled)", IO_RING_SQ_POLL);
+
+	return 0;
+}
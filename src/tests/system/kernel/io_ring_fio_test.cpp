@@ -0,0 +1,263 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures random reads and writes of a file or device, like fio does.
+
+	The same workload is done with read_pos()/write_pos() from a single
+	thread, through an I/O ring with a number of operations in flight, and
+	through a ring in polling mode.
+
+	Usage: io_ring_fio_test [<file or device> [<block size> [<queue depth>]]]
+	Without a file, a temporary one is created. Writes are only done on
+	that one.
+*/
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <Drivers.h>
+#include <OS.h>
+
+#include <IORing.h>
+
+
+static const bigtime_t kRunTime = 2000000;
+static const off_t kDefaultFileSize = 256 * 1024 * 1024;
+
+
+struct test_config {
+	int		fd;
+	off_t	size;
+	size_t	blockSize;
+	uint32	queueDepth;
+	bool	write;
+};
+
+
+static off_t
+random_offset(const test_config& config, unsigned int& seed)
+{
+	off_t blocks = config.size / config.blockSize;
+	off_t block = ((off_t)rand_r(&seed) << 31 | rand_r(&seed)) % blocks;
+	return block * config.blockSize;
+}
+
+
+static void
+print_result(const char* mode, const test_config& config, int64 operations,
+	int64 errors, bigtime_t runTime)
+{
+	double seconds = runTime / 1000000.0;
+	printf("%-6s %-14s %9.0f IOPS  %8.1f MB/s", config.write ? "write" : "read",
+		mode, operations / seconds,
+		operations * config.blockSize / seconds / (1024 * 1024));
+	if (errors > 0)
+		printf("  (%" B_PRId64 " errors)", errors);
+	printf("\n");
+}
+
+
+static void
+run_synchronous(const test_config& config, uint8* buffer)
+{
+	unsigned int seed = 42;
+	int64 operations = 0;
+	int64 errors = 0;
+
+	bigtime_t start = system_time();
+	bigtime_t end = start + kRunTime;
+	while (system_time() < end) {
+		off_t offset = random_offset(config, seed);
+		ssize_t result = config.write
+			? write_pos(config.fd, offset, buffer, config.blockSize)
+			: read_pos(config.fd, offset, buffer, config.blockSize);
+		if (result != (ssize_t)config.blockSize)
+			errors++;
+		operations++;
+	}
+
+	print_result(config.write ? "write_pos" : "read_pos", config, operations,
+		errors, system_time() - start);
+}
+
+
+static void
+run_ring(const test_config& config, uint8* buffers, uint32 flags)
+{
+	IORing ring;
+	status_t status = ring.Init(config.queueDepth, flags);
+	if (status != B_OK) {
+		fprintf(stderr, "Could not create ring: %s\n", strerror(status));
+		return;
+	}
+
+	unsigned int seed = 42;
+	int64 operations = 0;
+	int64 errors = 0;
+	uint32 inFlight = 0;
+
+	bigtime_t start = system_time();
+	bigtime_t end = start + kRunTime;
+	bool done = false;
+
+	// The user data is the index of the buffer the operation uses.
+	for (uint32 i = 0; i < config.queueDepth; i++) {
+		uint8* buffer = buffers + i * config.blockSize;
+		off_t offset = random_offset(config, seed);
+		if (config.write)
+			ring.Write(config.fd, buffer, config.blockSize, offset, i);
+		else
+			ring.Read(config.fd, buffer, config.blockSize, offset, i);
+		inFlight++;
+	}
+	ring.Submit();
+
+	while (inFlight > 0) {
+		io_ring_cqe completion;
+		status = ring.WaitForCompletion(completion);
+		if (status != B_OK) {
+			fprintf(stderr, "Waiting for completion failed: %s\n",
+				strerror(status));
+			return;
+		}
+
+		inFlight--;
+		operations++;
+		if (completion.result != (int64)config.blockSize)
+			errors++;
+
+		// reap what is there anyway without waiting
+		bool more = true;
+		while (more) {
+			uint32 index = completion.user_data;
+			if (!done && system_time() >= end)
+				done = true;
+
+			if (!done) {
+				uint8* buffer = buffers + index * config.blockSize;
+				off_t offset = random_offset(config, seed);
+				if (config.write) {
+					ring.Write(config.fd, buffer, config.blockSize, offset,
+						index);
+				} else {
+					ring.Read(config.fd, buffer, config.blockSize, offset,
+						index);
+				}
+				inFlight++;
+			}
+
+			more = ring.GetCompletion(completion);
+			if (more) {
+				inFlight--;
+				operations++;
+				if (completion.result != (int64)config.blockSize)
+					errors++;
+			}
+		}
+
+		ring.Submit();
+	}
+
+	print_result((flags & IO_RING_SQ_POLL) != 0 ? "ring (polled)" : "ring",
+		config, operations, errors, system_time() - start);
+}
+
+
+static void
+run_tests(test_config& config)
+{
+	uint8* buffers = (uint8*)malloc(config.blockSize * config.queueDepth);
+	if (buffers == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+	memset(buffers, 0x55, config.blockSize * config.queueDepth);
+
+	run_synchronous(config, buffers);
+	run_ring(config, buffers, 0);
+	run_ring(config, buffers, IO_RING_SQ_POLL);
+
+	free(buffers);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	test_config config;
+	config.blockSize = argc > 2 ? strtoul(argv[2], NULL, 0) : 4096;
+	config.queueDepth = argc > 3 ? strtoul(argv[3], NULL, 0) : 32;
+	config.write = false;
+
+	if (config.blockSize == 0 || config.queueDepth == 0
+		|| config.queueDepth > IO_RING_MAX_ENTRIES) {
+		fprintf(stderr, "Invalid block size or queue depth\n");
+		return 1;
+	}
+
+	char path[B_PATH_NAME_LENGTH];
+	bool temporary = argc < 2;
+	if (temporary) {
+		snprintf(path, sizeof(path), "/tmp/io_ring_fio_test-%" B_PRId32,
+			getpid());
+	} else
+		strlcpy(path, argv[1], sizeof(path));
+
+	config.fd = open(path, temporary ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY,
+		0644);
+	if (config.fd < 0) {
+		fprintf(stderr, "Could not open %s: %s\n", path, strerror(errno));
+		return 1;
+	}
+
+	if (temporary) {
+		config.size = kDefaultFileSize;
+
+		// fill the file, so that reads don't just hit a hole
+		size_t chunkSize = 1024 * 1024;
+		uint8* chunk = (uint8*)malloc(chunkSize);
+		memset(chunk, 0xaa, chunkSize);
+		for (off_t offset = 0; offset < config.size; offset += chunkSize)
+			write_pos(config.fd, offset, chunk, chunkSize);
+		free(chunk);
+		fsync(config.fd);
+	} else {
+		config.size = lseek(config.fd, 0, SEEK_END);
+
+		device_geometry geometry;
+		if (ioctl(config.fd, B_GET_GEOMETRY, &geometry, sizeof(geometry))
+				== 0) {
+			config.size = (off_t)geometry.bytes_per_sector
+				* geometry.sectors_per_track * geometry.cylinder_count
+				* geometry.head_count;
+		}
+		if (config.size < (off_t)config.blockSize) {
+			fprintf(stderr, "%s is too small\n", path);
+			return 1;
+		}
+	}
+
+	printf("%s: %" B_PRIdOFF " MB, block size %" B_PRIuSIZE ", queue depth %"
+		B_PRIu32 "\n", path, config.size / (1024 * 1024), config.blockSize,
+		config.queueDepth);
+
+	run_tests(config);
+	if (temporary) {
+		config.write = true;
+		run_tests(config);
+	}
+
+	close(config.fd);
+	if (temporary)
+		unlink(path);
+
+	return 0;
+}
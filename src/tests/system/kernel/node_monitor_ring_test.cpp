@@ -0,0 +1,175 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Compares classic node monitor delivery with delivery through a ring.
+
+	A directory with its children is watched while a number of files is
+	created, written to in small pieces, and gets its attributes changed
+	repeatedly, and then removed again.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <Directory.h>
+#include <Entry.h>
+#include <File.h>
+#include <Looper.h>
+#include <NodeMonitor.h>
+
+#include <NodeMonitorRing.h>
+
+
+static const int32 kFileCount = 1000;
+static const int32 kWritesPerFile = 16;
+static const int32 kAttributeWritesPerFile = 8;
+
+
+class Watcher : public BLooper {
+public:
+	Watcher(bool useRing)
+		:
+		BLooper("watcher"),
+		fUseRing(useRing),
+		fMessages(0),
+		fEvents(0),
+		fLostEvents(0)
+	{
+	}
+
+	virtual void MessageReceived(BMessage* message)
+	{
+		if (message->what != B_NODE_MONITOR) {
+			BLooper::MessageReceived(message);
+			return;
+		}
+
+		atomic_add(&fMessages, 1);
+
+		if (!fRing.IsReadyMessage(message)) {
+			atomic_add(&fEvents, 1);
+			return;
+		}
+
+		BMessage event;
+		while (fRing.GetNextEvent(event) == B_OK) {
+			if (event.GetInt32("opcode", 0) == B_NODE_MONITOR_EVENTS_LOST)
+				atomic_add(&fLostEvents, event.GetInt32("count", 0));
+			else
+				atomic_add(&fEvents, 1);
+		}
+	}
+
+	status_t StartWatching(const node_ref& directory)
+	{
+		if (fUseRing) {
+			status_t status = fRing.SetTo(BMessenger(this));
+			if (status != B_OK)
+				return status;
+		}
+
+		return watch_node(&directory, B_WATCH_DIRECTORY | B_WATCH_CHILDREN
+			| B_WATCH_STAT | B_WATCH_ATTR, this);
+	}
+
+	void StopWatching()
+	{
+		stop_watching(this);
+		fRing.Unset();
+	}
+
+	int32 Messages() { return atomic_get(&fMessages); }
+	int32 Events() { return atomic_get(&fEvents); }
+	int32 LostEvents() { return atomic_get(&fLostEvents); }
+
+private:
+	bool				fUseRing;
+	BNodeMonitorRing	fRing;
+	int32				fMessages;
+	int32				fEvents;
+	int32				fLostEvents;
+};
+
+
+static void
+run_test(const char* path, bool useRing)
+{
+	BDirectory directory(path);
+	node_ref directoryRef;
+	directory.GetNodeRef(&directoryRef);
+
+	Watcher* watcher = new Watcher(useRing);
+	watcher->Run();
+
+	status_t status = watcher->StartWatching(directoryRef);
+	if (status != B_OK) {
+		fprintf(stderr, "Could not start watching: %s\n", strerror(status));
+		exit(1);
+	}
+
+	bigtime_t start = system_time();
+
+	char buffer[64] = {};
+	for (int32 i = 0; i < kFileCount; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "file-%" B_PRId32, i);
+
+		BFile file(&directory, name, B_CREATE_FILE | B_READ_WRITE);
+		for (int32 j = 0; j < kWritesPerFile; j++)
+			file.Write(buffer, sizeof(buffer));
+		for (int32 j = 0; j < kAttributeWritesPerFile; j++)
+			file.WriteAttr("test:counter", B_INT32_TYPE, 0, &j, sizeof(j));
+	}
+
+	for (int32 i = 0; i < kFileCount; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "file-%" B_PRId32, i);
+		BEntry(&directory, name).Remove();
+	}
+
+	bigtime_t generated = system_time() - start;
+
+	// wait until the watcher got everything
+	int32 messages;
+	do {
+		messages = watcher->Messages();
+		snooze(200000);
+	} while (messages != watcher->Messages());
+
+	bigtime_t delivered = system_time() - start - 200000;
+
+	printf("%-8s %8" B_PRId32 " events, %8" B_PRId32 " port messages, %6"
+		B_PRId32 " lost; generated in %5" B_PRId64 " ms, delivered in %5"
+		B_PRId64 " ms\n", useRing ? "ring:" : "classic:", watcher->Events(),
+		messages, watcher->LostEvents(), generated / 1000, delivered / 1000);
+
+	watcher->StopWatching();
+	watcher->Lock();
+	watcher->Quit();
+}
+
+
+int
+main(int argc, char** argv)
+{
+	char path[B_PATH_NAME_LENGTH];
+	snprintf(path, sizeof(path), "/tmp/node_monitor_ring_test-%" B_PRId32,
+		getpid());
+
+	if (create_directory(path, 0755) != B_OK) {
+		fprintf(stderr, "Could not create %s\n", path);
+		return 1;
+	}
+
+	run_test(path, false);
+	run_test(path, true);
+
+	rmdir(path);
+	return 0;
+}
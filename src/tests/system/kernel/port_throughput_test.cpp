@@ -0,0 +1,153 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures how fast messages of 4 KiB to 256 KiB can be passed through a
+	port, from one writer to a number of readers.
+
+	Large messages are written directly into the buffer of a waiting reader,
+	so the results depend on whether the readers have to wait for messages,
+	or find them queued; a queue length of 1 makes them wait most of the time.
+
+	Usage: port_throughput_test [<queue length> [<readers>]]
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+
+
+static const bigtime_t kRunTime = 1000000;
+static const size_t kMinMessageSize = 4 * 1024;
+static const size_t kMaxMessageSize = 256 * 1024;
+static const int32 kQuitCode = 'quit';
+
+
+struct reader_data {
+	port_id	port;
+	size_t	size;
+	int64	bytes;
+	int64	errors;
+};
+
+
+static status_t
+reader_thread(void* _data)
+{
+	reader_data* data = (reader_data*)_data;
+
+	uint8* buffer = (uint8*)malloc(data->size);
+	if (buffer == NULL)
+		return B_NO_MEMORY;
+
+	while (true) {
+		int32 code;
+		ssize_t bytes = read_port(data->port, &code, buffer, data->size);
+		if (bytes < 0 || code == kQuitCode)
+			break;
+
+		// check the start and the end, the rest was copied the same way
+		if (bytes != (ssize_t)data->size || buffer[0] != (uint8)code
+			|| buffer[bytes - 1] != (uint8)code) {
+			data->errors++;
+		}
+		data->bytes += bytes;
+	}
+
+	free(buffer);
+	return B_OK;
+}
+
+
+static void
+run_test(size_t size, int32 queueLength, int32 readerCount)
+{
+	port_id port = create_port(queueLength, "throughput test");
+	if (port < 0) {
+		fprintf(stderr, "Could not create port: %s\n", strerror(port));
+		exit(1);
+	}
+
+	reader_data* readers = new reader_data[readerCount];
+	thread_id* threads = new thread_id[readerCount];
+	for (int32 i = 0; i < readerCount; i++) {
+		readers[i].port = port;
+		readers[i].size = size;
+		readers[i].bytes = 0;
+		readers[i].errors = 0;
+
+		threads[i] = spawn_thread(&reader_thread, "reader", B_NORMAL_PRIORITY,
+			&readers[i]);
+		resume_thread(threads[i]);
+	}
+
+	uint8* buffer = (uint8*)malloc(size);
+	int64 messages = 0;
+
+	bigtime_t start = system_time();
+	bigtime_t end = start + kRunTime;
+	while (system_time() < end) {
+		// the code is also used to mark the message contents
+		int32 code = messages % 251;
+		buffer[0] = code;
+		buffer[size - 1] = code;
+
+		status_t status = write_port(port, code, buffer, size);
+		if (status != B_OK) {
+			fprintf(stderr, "Writing %" B_PRIuSIZE " bytes failed: %s\n", size,
+				strerror(status));
+			break;
+		}
+		messages++;
+	}
+
+	for (int32 i = 0; i < readerCount; i++)
+		write_port(port, kQuitCode, NULL, 0);
+
+	int64 bytes = 0;
+	int64 errors = 0;
+	for (int32 i = 0; i < readerCount; i++) {
+		status_t result;
+		wait_for_thread(threads[i], &result);
+		bytes += readers[i].bytes;
+		errors += readers[i].errors;
+	}
+	bigtime_t runTime = system_time() - start;
+
+	delete_port(port);
+	free(buffer);
+	delete[] threads;
+	delete[] readers;
+
+	double seconds = runTime / 1000000.0;
+	printf("%8" B_PRIuSIZE " KiB  %10.0f msgs/s  %9.1f MB/s", size / 1024,
+		messages / seconds, bytes / seconds / (1024 * 1024));
+	if (errors > 0)
+		printf("  (%" B_PRId64 " corrupt messages)", errors);
+	printf("\n");
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int32 queueLength = argc > 1 ? atoi(argv[1]) : 1;
+	int32 readerCount = argc > 2 ? atoi(argv[2]) : 1;
+	if (queueLength <= 0 || readerCount <= 0) {
+		fprintf(stderr, "Usage: %s [<queue length> [<readers>]]\n", argv[0]);
+		return 1;
+	}
+
+	printf("queue length %" B_PRId32 ", %" B_PRId32 " reader(s)\n", queueLength,
+		readerCount);
+
+	for (size_t size = kMinMessageSize; size <= kMaxMessageSize; size *= 2)
+		run_test(size, queueLength, readerCount);
+
+	return 0;
+}
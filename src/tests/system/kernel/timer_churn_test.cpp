@@ -0,0 +1,173 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures the cost of kernel timers while many of them are scheduled.
+
+	A number of idle threads wait with a long timeout, so that each of them
+	keeps a kernel timer scheduled. Then pairs of threads ping-pong a
+	semaphore with a timeout, which adds and cancels a timer per round trip,
+	and a number of threads wait with short timeouts that actually expire.
+*/
+
+
+#include <OS.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+static const bigtime_t kRunTime = 2000000;
+static const int32 kPingPongPairs = 4;
+static const int32 kExpiringThreads = 4;
+
+static sem_id sIdleSem;
+static int32 sQuit;
+
+
+struct ping_pong {
+	sem_id	ping;
+	sem_id	pong;
+	int32	rounds;
+};
+
+
+static status_t
+idle_thread(void*)
+{
+	while (atomic_get(&sQuit) == 0)
+		acquire_sem_etc(sIdleSem, 1, B_RELATIVE_TIMEOUT, 3600000000LL);
+
+	return B_OK;
+}
+
+
+static status_t
+ping_thread(void* data)
+{
+	ping_pong* pair = (ping_pong*)data;
+
+	while (atomic_get(&sQuit) == 0) {
+		release_sem(pair->ping);
+		if (acquire_sem_etc(pair->pong, 1, B_RELATIVE_TIMEOUT, 1000000) == B_OK)
+			pair->rounds++;
+	}
+
+	return B_OK;
+}
+
+
+static status_t
+pong_thread(void* data)
+{
+	ping_pong* pair = (ping_pong*)data;
+
+	while (atomic_get(&sQuit) == 0) {
+		if (acquire_sem_etc(pair->ping, 1, B_RELATIVE_TIMEOUT, 1000000) == B_OK)
+			release_sem(pair->pong);
+	}
+
+	return B_OK;
+}
+
+
+static status_t
+expiring_thread(void* data)
+{
+	int32* timeouts = (int32*)data;
+	sem_id sem = create_sem(0, "expiring");
+	unsigned int seed = find_thread(NULL);
+
+	while (atomic_get(&sQuit) == 0) {
+		bigtime_t timeout = 50 + rand_r(&seed) % 450;
+		if (acquire_sem_etc(sem, 1, B_RELATIVE_TIMEOUT, timeout) == B_TIMED_OUT)
+			(*timeouts)++;
+	}
+
+	delete_sem(sem);
+	return B_OK;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int32 idleCount = argc > 1 ? atoi(argv[1]) : 2000;
+
+	sIdleSem = create_sem(0, "idle");
+
+	thread_id* idleThreads = new thread_id[idleCount];
+	for (int32 i = 0; i < idleCount; i++) {
+		idleThreads[i] = spawn_thread(&idle_thread, "idle", B_LOW_PRIORITY,
+			NULL);
+		if (idleThreads[i] < 0) {
+			fprintf(stderr, "Could only create %" B_PRId32 " idle threads\n",
+				i);
+			idleCount = i;
+			break;
+		}
+		resume_thread(idleThreads[i]);
+	}
+
+	// give the idle threads a chance to block
+	snooze(500000);
+
+	ping_pong pairs[kPingPongPairs];
+	thread_id threads[kPingPongPairs * 2 + kExpiringThreads];
+	int32 timeouts[kExpiringThreads] = {};
+	int32 threadCount = 0;
+
+	for (int32 i = 0; i < kPingPongPairs; i++) {
+		pairs[i].ping = create_sem(0, "ping");
+		pairs[i].pong = create_sem(0, "pong");
+		pairs[i].rounds = 0;
+
+		threads[threadCount++] = spawn_thread(&ping_thread, "ping",
+			B_NORMAL_PRIORITY, &pairs[i]);
+		threads[threadCount++] = spawn_thread(&pong_thread, "pong",
+			B_NORMAL_PRIORITY, &pairs[i]);
+	}
+
+	for (int32 i = 0; i < kExpiringThreads; i++) {
+		threads[threadCount++] = spawn_thread(&expiring_thread, "expiring",
+			B_NORMAL_PRIORITY, &timeouts[i]);
+	}
+
+	bigtime_t start = system_time();
+	for (int32 i = 0; i < threadCount; i++)
+		resume_thread(threads[i]);
+
+	snooze(kRunTime);
+	atomic_set(&sQuit, 1);
+	bigtime_t runTime = system_time() - start;
+
+	for (int32 i = 0; i < kPingPongPairs; i++) {
+		delete_sem(pairs[i].ping);
+		delete_sem(pairs[i].pong);
+	}
+	delete_sem(sIdleSem);
+
+	status_t status;
+	for (int32 i = 0; i < threadCount; i++)
+		wait_for_thread(threads[i], &status);
+	for (int32 i = 0; i < idleCount; i++)
+		wait_for_thread(idleThreads[i], &status);
+	delete[] idleThreads;
+
+	int64 rounds = 0;
+	for (int32 i = 0; i < kPingPongPairs; i++)
+		rounds += pairs[i].rounds;
+
+	int64 expired = 0;
+	for (int32 i = 0; i < kExpiringThreads; i++)
+		expired += timeouts[i];
+
+	printf("%" B_PRId32 " idle timers scheduled\n", idleCount);
+	printf("  ping-pong: %8.0f round trips/s (2 timers added and cancelled "
+		"each)\n", rounds * 1000000.0 / runTime);
+	printf("  expiring:  %8.0f timeouts/s\n", expired * 1000000.0 / runTime);
+
+	return 0;
+}
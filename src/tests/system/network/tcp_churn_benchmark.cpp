@@ -0,0 +1,173 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Opens and closes as many short TCP connections as possible over the
+	loopback interface, like a busy HTTP server would see them: the client
+	sends a small request, and the server answers and closes the connection
+	first, so that it is the server that has to keep the TIME_WAIT state.
+*/
+
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+
+static const char kRequest[] = "GET / HTTP/1.0\r\n\r\n";
+static const char kResponse[] = "HTTP/1.0 204 No Content\r\n\r\n";
+
+
+struct client_info {
+	sockaddr_in	address;
+	uint32		count;
+	uint32		failed;
+	bigtime_t	worst_connect;
+};
+
+
+static void*
+client_thread(void* _info)
+{
+	client_info* info = (client_info*)_info;
+
+	for (uint32 i = 0; i < info->count; i++) {
+		int fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (fd < 0) {
+			info->failed++;
+			continue;
+		}
+
+		bigtime_t start = system_time();
+		if (connect(fd, (sockaddr*)&info->address, sizeof(info->address))
+				!= 0) {
+			info->failed++;
+			close(fd);
+			continue;
+		}
+
+		bigtime_t connectTime = system_time() - start;
+		if (connectTime > info->worst_connect)
+			info->worst_connect = connectTime;
+
+		char buffer[256];
+		if (write(fd, kRequest, sizeof(kRequest) - 1) < 0
+			|| read(fd, buffer, sizeof(buffer)) <= 0) {
+			info->failed++;
+		}
+
+		// wait for the server to close the connection
+		while (read(fd, buffer, sizeof(buffer)) > 0)
+			;
+
+		close(fd);
+	}
+
+	return NULL;
+}
+
+
+static void*
+server_thread(void* _listener)
+{
+	int listener = (int)(addr_t)_listener;
+
+	while (true) {
+		int fd = accept(listener, NULL, NULL);
+		if (fd < 0)
+			break;
+
+		char buffer[256];
+		if (read(fd, buffer, sizeof(buffer)) > 0)
+			write(fd, kResponse, sizeof(kResponse) - 1);
+
+		close(fd);
+	}
+
+	return NULL;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	uint32 count = 20000;
+	uint32 clientCount = 4;
+	if (argc > 1)
+		count = strtoul(argv[1], NULL, 0);
+	if (argc > 2)
+		clientCount = strtoul(argv[2], NULL, 0);
+
+	int listener = socket(AF_INET, SOCK_STREAM, 0);
+	if (listener < 0) {
+		fprintf(stderr, "could not create socket: %s\n", strerror(errno));
+		return 1;
+	}
+
+	int reuse = 1;
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_len = sizeof(address);
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	socklen_t length = sizeof(address);
+	if (bind(listener, (sockaddr*)&address, sizeof(address)) != 0
+		|| listen(listener, 128) != 0
+		|| getsockname(listener, (sockaddr*)&address, &length) != 0) {
+		fprintf(stderr, "could not listen: %s\n", strerror(errno));
+		return 1;
+	}
+
+	pthread_t server;
+	pthread_create(&server, NULL, &server_thread, (void*)(addr_t)listener);
+
+	client_info* clients = new client_info[clientCount];
+	pthread_t* threads = new pthread_t[clientCount];
+
+	bigtime_t start = system_time();
+
+	for (uint32 i = 0; i < clientCount; i++) {
+		memset(&clients[i], 0, sizeof(client_info));
+		clients[i].address = address;
+		clients[i].count = count / clientCount;
+		pthread_create(&threads[i], NULL, &client_thread, &clients[i]);
+	}
+
+	uint32 total = 0;
+	uint32 failed = 0;
+	bigtime_t worstConnect = 0;
+	for (uint32 i = 0; i < clientCount; i++) {
+		pthread_join(threads[i], NULL);
+		total += clients[i].count;
+		failed += clients[i].failed;
+		if (clients[i].worst_connect > worstConnect)
+			worstConnect = clients[i].worst_connect;
+	}
+
+	bigtime_t time = system_time() - start;
+
+	printf("%" B_PRIu32 " connections with %" B_PRIu32 " clients in %g s: "
+		"%.0f connections/s, %" B_PRIu32 " failed, slowest connect %"
+		B_PRIdBIGTIME " usecs\n", total, clientCount, time / 1000000.0,
+		total / (time / 1000000.0), failed, worstConnect);
+
+	close(listener);
+	pthread_join(server, NULL);
+
+	delete[] clients;
+	delete[] threads;
+	return failed != 0 ? 1 : 0;
+}
@@ -31,6 +31,7 @@
 
 #include <netinet/in.h>
 #include <netinet/ip.h>
+#include <netinet/tcp.h>
 
 #include <ctype.h>
 #include <errno.h>
@@ -114,6 +115,9 @@ static std::set<uint32> sReorderList;
 static bool sSimultaneousConnect = false;
 static bool sSimultaneousClose = false;
 static bool sServerActiveClose = false;
+static int64 sServerReceived = 0;
+static int32 sDroppedPackets = 0;
+static bool sQuiet = false;
 
 static struct net_domain sDomain = {
 	"ipv4",
@@ -698,9 +702,12 @@ net_socket_module_info gNetSocketModule = {
 	NULL, // listen,
 	NULL, // receive,
 	NULL, // send,
+	NULL, // receive_multiple,
+	NULL, // send_multiple,
 	NULL, // setsockopt,
 	NULL, // shutdown,
 	NULL, // socketpair
+	NULL, // send_external
 };
 
 
@@ -962,7 +969,7 @@ domain_receive_data(net_buffer *buffer)
 
 	bool drop = false;
 	if (sDropList.find(packetNumber) != sDropList.end()
-		|| (sRandomDrop > 0.0 && (1.0 * rand() / RAND_MAX) > sRandomDrop))
+		|| (sRandomDrop > 0.0 && (1.0 * rand() / RAND_MAX) < sRandomDrop))
 		drop = true;
 
 	if (!drop && (sRoundTripTime > 0 || sRandomRoundTrip || sIncreasingRoundTrip)) {
@@ -975,12 +982,15 @@ domain_receive_data(net_buffer *buffer)
 		snooze(sRoundTripTime / 2 + add);
 	}
 
-	if (sPacketMonitor != NULL) {
+	if (sQuiet) {
+		// the scenario command prints its own summary
+	} else if (sPacketMonitor != NULL) {
 		sPacketMonitor(buffer, packetNumber, drop);
 	} else if (drop)
 		printf("<**** DROPPED %ld ****>\n", packetNumber);
 
 	if (drop) {
+		atomic_add(&sDroppedPackets, 1);
 		gNetBufferModule.free(buffer);
 		return B_OK;
 	}
@@ -1123,6 +1133,22 @@ dump_printf(net_buffer* buffer, int32 packetNumber, bool willBeDropped)
 					printf(" <ts %lu:%lu>", option->timestamp.value, option->timestamp.reply);
 					length = 10;
 					break;
+				case TCP_OPTION_SACK_PERMITTED:
+					printf(" <sack ok>");
+					length = 2;
+					break;
+				case TCP_OPTION_SACK:
+					length = option->length;
+					printf(" <sack");
+					for (uint32 i = 0; length > 2
+							&& i < (length - 2) / sizeof(tcp_sack); i++) {
+						printf(" %lu:%lu", ntohl(option->sack[i].left_edge),
+							ntohl(option->sack[i].right_edge));
+					}
+					putchar('>');
+					if (length == 0)
+						size = 0;
+					break;
 
 				default:
 					length = option->length;
@@ -1313,7 +1339,9 @@ server_thread(void*)
 		ssize_t bytesRead;
 		while ((bytesRead = socket_recv(connectionSocket, buffer,
 				sizeof(buffer), 0)) > 0) {
-			printf("server: received %ld bytes\n", bytesRead);
+			atomic_add64(&sServerReceived, bytesRead);
+			if (!sQuiet)
+				printf("server: received %ld bytes\n", bytesRead);
 
 			if (sServerActiveClose) {
 				printf("server: active close\n");
@@ -1713,6 +1741,111 @@ do_round_trip_time(int argc, char** argv)
 }
 
 
+static void
+do_congestion_control(int argc, char** argv)
+{
+	net_protocol* protocol = gClientSocket->first_protocol;
+
+	if (argc == 1) {
+		char name[TCP_CA_NAME_MAX];
+		int length = sizeof(name);
+		status_t status = gTCPModule->getsockopt(protocol, IPPROTO_TCP,
+			TCP_CONGESTION, name, &length);
+		if (status != B_OK) {
+			fprintf(stderr, "could not get congestion control: %s\n",
+				strerror(status));
+			return;
+		}
+
+		printf("Congestion control: %s\n", name);
+		return;
+	}
+
+	status_t status = gTCPModule->setsockopt(protocol, IPPROTO_TCP,
+		TCP_CONGESTION, argv[1], strlen(argv[1]) + 1);
+	if (status != B_OK) {
+		fprintf(stderr, "could not set congestion control \"%s\": %s\n",
+			argv[1], strerror(status));
+	}
+}
+
+
+/*!	Sends data from the connected client over a lossy and slow link, and
+	reports how long it took the server to receive all of it.
+*/
+static void
+do_scenario(int argc, char** argv)
+{
+	if (argc != 5 || !isdigit(argv[2][0])) {
+		puts("usage: scenario <congestion-control> <size> <drop-probability> "
+			"<rtt>\n\n"
+			"Sends <size> bytes from the client (which must be connected) with\n"
+			"the given congestion control algorithm, while packets are dropped\n"
+			"with the given probability, and delayed by half the round trip\n"
+			"time (in ms) in each direction.");
+		return;
+	}
+
+	ssize_t size = parse_size(argv[2]);
+	if (size <= 0)
+		return;
+
+	char* setArgs[] = {argv[0], argv[1]};
+	do_congestion_control(2, setArgs);
+
+	double previousDrop = sRandomDrop;
+	bigtime_t previousRoundTripTime = sRoundTripTime;
+	sRandomDrop = max_c(0.0, min_c(1.0, atof(argv[3])));
+	sRoundTripTime = 1000LL * strtoul(argv[4], NULL, 0);
+
+	const size_t bufferSize = 4096;
+	char buffer[bufferSize];
+	for (uint32 i = 0; i < bufferSize; i++)
+		buffer[i] = (char)(i & 0xff);
+
+	sQuiet = true;
+	int64 target = atomic_get64(&sServerReceived) + size;
+	int32 firstPacket = atomic_get(&sPacketNumber);
+	int32 previousDropped = atomic_get(&sDroppedPackets);
+	bigtime_t start = system_time();
+
+	for (ssize_t total = 0; total < size; ) {
+		ssize_t bytesWritten = socket_send(gClientSocket, buffer,
+			min_c(bufferSize, (size_t)(size - total)), 0);
+		if (bytesWritten < B_OK) {
+			fprintf(stderr, "failed sending (after %" B_PRIdSSIZE "): %s\n",
+				total, strerror(bytesWritten));
+			break;
+		}
+
+		total += bytesWritten;
+	}
+
+	// wait until the server got everything, but not forever
+	bigtime_t timeout = start + 300000000LL;
+	while (atomic_get64(&sServerReceived) < target
+		&& system_time() < timeout) {
+		snooze(10000);
+	}
+
+	bigtime_t time = system_time() - start;
+	int64 missing = target - atomic_get64(&sServerReceived);
+
+	sQuiet = false;
+	sRandomDrop = previousDrop;
+	sRoundTripTime = previousRoundTripTime;
+
+	printf("%s: %" B_PRIdSSIZE " bytes in %g s (%g KB/s), %" B_PRId32
+		" packets, %" B_PRId32 " dropped", argv[1], size, time / 1000000.0,
+		(size - missing) / 1024.0 / (time / 1000000.0),
+		atomic_get(&sPacketNumber) - firstPacket,
+		atomic_get(&sDroppedPackets) - previousDropped);
+	if (missing > 0)
+		printf(", %" B_PRId64 " bytes NOT received", missing);
+	putchar('\n');
+}
+
+
 static void
 do_dprintf(int argc, char** argv)
 {
@@ -1730,11 +1863,15 @@ static cmd_entry sBuiltinCommands[] = {
 	{"send", do_send, "Sends data from the client to the server"},
 	{"send_loop", do_send_loop, "Sends data in a loop"},
 	{"close", do_close, "Performs an active or simultaneous close"},
+	{"congestion", do_congestion_control,
+		"Shows or sets the congestion control algorithm of the client"},
 	{"dprintf", do_dprintf, "Toggles debug output"},
 	{"drop", do_drop, "Lets you drop packets during transfer"},
 	{"reorder", do_reorder, "Lets you reorder packets during transfer"},
 	{"help", do_help, "prints this help text"},
 	{"rtt", do_round_trip_time, "Specifies the round trip time"},
+	{"scenario", do_scenario,
+		"Measures a transfer with packet loss and delay"},
 	{"quit", NULL, "exits the application"},
 	{NULL, NULL, NULL},
 };
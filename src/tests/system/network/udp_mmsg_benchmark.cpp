@@ -0,0 +1,224 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures how many datagrams per second can be passed over the loopback
+	interface, once with one send()/recv() call per datagram, and once with
+	sendmmsg()/recvmmsg().
+*/
+
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+
+static const unsigned int kBatchSize = 64;
+static const size_t kDatagramSize = 64;
+
+
+struct receiver_info {
+	int			socket;
+	bool		batched;
+	uint32		received;
+	uint32		out_of_order;
+	bigtime_t	last_receive;
+};
+
+
+static void*
+receiver_thread(void* _info)
+{
+	receiver_info* info = (receiver_info*)_info;
+
+	char buffers[kBatchSize][kDatagramSize];
+	iovec vecs[kBatchSize];
+	mmsghdr messages[kBatchSize];
+	uint32 expected = 0;
+
+	while (true) {
+		int count = 1;
+
+		if (info->batched) {
+			memset(messages, 0, sizeof(messages));
+			for (unsigned int i = 0; i < kBatchSize; i++) {
+				vecs[i].iov_base = buffers[i];
+				vecs[i].iov_len = kDatagramSize;
+				messages[i].msg_hdr.msg_iov = &vecs[i];
+				messages[i].msg_hdr.msg_iovlen = 1;
+			}
+
+			count = recvmmsg(info->socket, messages, kBatchSize,
+				MSG_WAITFORONE, NULL);
+		} else {
+			ssize_t bytesReceived = recv(info->socket, buffers[0],
+				kDatagramSize, 0);
+			if (bytesReceived < 0)
+				count = -1;
+			else
+				messages[0].msg_len = bytesReceived;
+		}
+
+		if (count <= 0)
+			break;
+
+		info->last_receive = system_time();
+
+		for (int i = 0; i < count; i++) {
+			if (messages[i].msg_len != kDatagramSize) {
+				fprintf(stderr, "received datagram of %u bytes\n",
+					messages[i].msg_len);
+				exit(1);
+			}
+
+			uint32 sequence;
+			memcpy(&sequence, buffers[i], sizeof(sequence));
+			if (sequence < expected)
+				info->out_of_order++;
+			expected = sequence + 1;
+		}
+
+		info->received += count;
+	}
+
+	return NULL;
+}
+
+
+static bool
+create_sockets(int& sender, int& receiver)
+{
+	receiver = socket(AF_INET, SOCK_DGRAM, 0);
+	sender = socket(AF_INET, SOCK_DGRAM, 0);
+	if (receiver < 0 || sender < 0)
+		return false;
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_len = sizeof(address);
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	socklen_t length = sizeof(address);
+	if (bind(receiver, (sockaddr*)&address, sizeof(address)) != 0
+		|| getsockname(receiver, (sockaddr*)&address, &length) != 0
+		|| connect(sender, (sockaddr*)&address, length) != 0) {
+		return false;
+	}
+
+	// stop receiving once no more datagrams arrive
+	timeval timeout = { 1, 0 };
+	setsockopt(receiver, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	int bufferSize = 1024 * 1024;
+	setsockopt(receiver, SOL_SOCKET, SO_RCVBUF, &bufferSize,
+		sizeof(bufferSize));
+	return true;
+}
+
+
+static void
+run(const char* name, bool batched, uint32 count)
+{
+	int sender;
+	int receiver;
+	if (!create_sockets(sender, receiver)) {
+		fprintf(stderr, "%s: could not create sockets: %s\n", name,
+			strerror(errno));
+		exit(1);
+	}
+
+	receiver_info info;
+	memset(&info, 0, sizeof(info));
+	info.socket = receiver;
+	info.batched = batched;
+
+	pthread_t thread;
+	pthread_create(&thread, NULL, &receiver_thread, &info);
+
+	char buffers[kBatchSize][kDatagramSize];
+	memset(buffers, 0, sizeof(buffers));
+	iovec vecs[kBatchSize];
+	mmsghdr messages[kBatchSize];
+
+	bigtime_t start = system_time();
+	uint32 sent = 0;
+
+	while (sent < count) {
+		if (batched) {
+			unsigned int batchCount = kBatchSize;
+			if (count - sent < batchCount)
+				batchCount = count - sent;
+
+			memset(messages, 0, sizeof(messages));
+			for (unsigned int i = 0; i < batchCount; i++) {
+				uint32 sequence = sent + i;
+				memcpy(buffers[i], &sequence, sizeof(sequence));
+				vecs[i].iov_base = buffers[i];
+				vecs[i].iov_len = kDatagramSize;
+				messages[i].msg_hdr.msg_iov = &vecs[i];
+				messages[i].msg_hdr.msg_iovlen = 1;
+			}
+
+			int result = sendmmsg(sender, messages, batchCount, 0);
+			if (result <= 0) {
+				fprintf(stderr, "%s: sendmmsg() failed: %s\n", name,
+					strerror(errno));
+				exit(1);
+			}
+			for (int i = 0; i < result; i++) {
+				if (messages[i].msg_len != kDatagramSize) {
+					fprintf(stderr, "%s: sent %u bytes\n", name,
+						messages[i].msg_len);
+					exit(1);
+				}
+			}
+			sent += result;
+		} else {
+			memcpy(buffers[0], &sent, sizeof(sent));
+			if (send(sender, buffers[0], kDatagramSize, 0) < 0) {
+				fprintf(stderr, "%s: send() failed: %s\n", name,
+					strerror(errno));
+				exit(1);
+			}
+			sent++;
+		}
+	}
+
+	bigtime_t sendTime = system_time() - start;
+
+	pthread_join(thread, NULL);
+	bigtime_t receiveTime = info.last_receive - start;
+
+	printf("%-10s sent %8.0f datagrams/s, received %" B_PRIu32 " (%8.0f "
+		"datagrams/s), %" B_PRIu32 " out of order\n", name,
+		sent / (sendTime / 1000000.0), info.received,
+		info.received / (receiveTime / 1000000.0), info.out_of_order);
+
+	close(sender);
+	close(receiver);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	uint32 count = 1000000;
+	if (argc > 1)
+		count = strtoul(argv[1], NULL, 0);
+
+	run("single", false, count);
+	run("batched", true, count);
+	return 0;
+}
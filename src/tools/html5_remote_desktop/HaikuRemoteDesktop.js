@@ -29,6 +29,8 @@ const RP_COPY_RECT_NO_CLIPPING = 61;
 const RP_INVERT_RECT = 62;
 const RP_DRAW_BITMAP = 63;
 const RP_DRAW_BITMAP_RECTS = 64;
+const RP_CACHE_BITMAP = 65;
+const RP_DRAW_CACHED_BITMAP = 66;
 
 const RP_STROKE_ARC = 80;
 const RP_STROKE_BEZIER = 81;
@@ -91,6 +93,9 @@ const RP_UNMAPPED_KEY_DOWN = 242;
 const RP_UNMAPPED_KEY_UP = 243;
 const RP_MODIFIERS_CHANGED = 244;
 
+const kMaxCachedBitmaps = 1024;
+const kBitmapCacheSize = 32 * 1024 * 1024;
+
 
 // drawing_mode
 const B_OP_COPY = 0;
@@ -131,6 +136,14 @@ const B_TRANSPARENT_MAGIC_RGBA32 = 0xff777477;
 const B_TRANSPARENT_MAGIC_RGBA32_BIG = 0x777477ff;
 
 
+// bitmap drawing options
+const B_TILE_BITMAP_X = 0x00000001;
+const B_TILE_BITMAP_Y = 0x00000002;
+const B_TILE_BITMAP = 0x00000003;
+const B_FILTER_BITMAP_BILINEAR = 0x00000100;
+const B_WAIT_FOR_RETRACE = 0x00000800;
+
+
 // source_alpha
 const B_PIXEL_ALPHA = 0;
 const B_CONSTANT_ALPHA = 1;
@@ -653,7 +666,13 @@ RemoteBitmap.prototype.readFrom = function(remoteMessage, unsetAlpha,
 	}
 
 	this.bitsLength = remoteMessage.dataView.readUint32();
+	this.decodeFrom(remoteMessage.dataView, unsetAlpha);
+	return this;
+}
 
+
+RemoteBitmap.prototype.decodeFrom = function(dataView, unsetAlpha)
+{
 	this.canvas = document.createElement('canvas');
 	this.canvas.width = this.width;
 	this.canvas.height = this.height;
@@ -665,7 +684,7 @@ RemoteBitmap.prototype.readFrom = function(remoteMessage, unsetAlpha,
 	var imageData = context.createImageData(this.width, this.height);
 	switch (this.colorSpace) {
 		case B_RGBA32:
-			remoteMessage.dataView.readInto(imageData.data);
+			dataView.readInto(imageData.data);
 			var output = new Uint32Array(imageData.data.buffer);
 
 			for (var i = 0; i < imageData.data.length / 4; i++) {
@@ -681,7 +700,7 @@ RemoteBitmap.prototype.readFrom = function(remoteMessage, unsetAlpha,
 			break;
 
 		case B_RGB32:
-			remoteMessage.dataView.readInto(imageData.data);
+			dataView.readInto(imageData.data);
 			var output = new Uint32Array(imageData.data.buffer);
 
 			for (var i = 0; i < imageData.data.length / 4; i++) {
@@ -698,7 +717,7 @@ RemoteBitmap.prototype.readFrom = function(remoteMessage, unsetAlpha,
 			var position = 0;
 
 			for (var y = 0; y < this.height; y++) {
-				remoteMessage.dataView.readInto(line);
+				dataView.readInto(line);
 
 				for (var x = 0; x < this.width; x++) {
 					imageData.data[position++] = line[x * 3 + 2];
@@ -716,7 +735,7 @@ RemoteBitmap.prototype.readFrom = function(remoteMessage, unsetAlpha,
 			var position = 0;
 
 			for (var y = 0; y < this.height; y++) {
-				remoteMessage.dataView.readInto(lineBuffer);
+				dataView.readInto(lineBuffer);
 
 				for (var x = 0; x < this.width; x++) {
 					imageData.data[position++] = (line[x] & 0xf800) >> 8;
@@ -734,7 +753,7 @@ RemoteBitmap.prototype.readFrom = function(remoteMessage, unsetAlpha,
 			var position = 0;
 
 			for (var y = 0; y < this.height; y++) {
-				remoteMessage.dataView.readInto(line);
+				dataView.readInto(line);
 
 				for (var x = 0; x < this.width; x++)
 					output[position++] = gSystemPalette[line[x]];
@@ -744,7 +763,7 @@ RemoteBitmap.prototype.readFrom = function(remoteMessage, unsetAlpha,
 
 		case B_GRAY8:
 			var source = new Uint8Array(this.bitsLength);
-			remoteMessage.dataView.readInto(source);
+			dataView.readInto(source);
 			for (var i = 0; i < imageData.data.length / 4; i++) {
 				imageData.data[i * 4 + 0] = source[i];
 				imageData.data[i * 4 + 1] = source[i];
@@ -755,7 +774,7 @@ RemoteBitmap.prototype.readFrom = function(remoteMessage, unsetAlpha,
 
 		case B_GRAY1:
 			var source = new Uint8Array(this.bitsLength);
-			remoteMessage.dataView.readInto(source);
+			dataView.readInto(source);
 			for (var i = 0; i < imageData.data.length / 4; i++) {
 				var value = (source[Math.floor(i / 8)] >> i % 8) & 1 ? 255 : 0;
 				imageData.data[i * 4 + 0] = value;
@@ -771,7 +790,132 @@ RemoteBitmap.prototype.readFrom = function(remoteMessage, unsetAlpha,
 	}
 
 	context.putImageData(imageData, 0, 0);
-	return this;
+}
+
+
+//	Decompresses PackBits data, returns whether it filled the target array.
+function unpackBits(source, target)
+{
+	var index = 0;
+	var position = 0;
+	while (index < source.length) {
+		var header = source[index++];
+		if (header < 128) {
+			var length = header + 1;
+			if (index + length > source.length
+				|| position + length > target.length) {
+				return false;
+			}
+
+			target.set(source.subarray(index, index + length), position);
+			index += length;
+			position += length;
+		} else if (header > 128) {
+			var length = 257 - header;
+			if (index >= source.length || position + length > target.length)
+				return false;
+
+			target.fill(source[index++], position, position + length);
+			position += length;
+		}
+	}
+
+	return position == target.length;
+}
+
+
+/*	A bitmap the server asked us to keep; it is only converted for drawing
+	when it is used, as that depends on the drawing mode. */
+function CachedBitmap(remoteMessage, base)
+{
+	var dataView = remoteMessage.dataView;
+	this.width = dataView.readInt32();
+	this.height = dataView.readInt32();
+	this.bytesPerRow = dataView.readInt32();
+	this.colorSpace = dataView.readUint32();
+	this.flags = dataView.readUint32();
+	this.canvases = [];
+
+	this.bits = new Uint8Array(this.bytesPerRow * this.height);
+	if (base) {
+		if (base.bits.length != this.bits.length)
+			throw 'cached bitmap does not match its base';
+
+		this.bits.set(base.bits);
+	}
+
+	var tileCount = dataView.readInt32();
+	for (var i = 0; i < tileCount; i++) {
+		var x = dataView.readInt32();
+		var y = dataView.readInt32();
+		var tileWidth = dataView.readInt32();
+		var tileHeight = dataView.readInt32();
+		var packed = new Uint8Array(dataView.readUint32());
+		dataView.readInto(packed);
+
+		if (x < 0 || y < 0 || tileWidth <= 0 || tileHeight <= 0
+			|| x + tileWidth > this.bytesPerRow
+			|| y + tileHeight > this.height) {
+			throw 'invalid cached bitmap tile';
+		}
+
+		var tile = new Uint8Array(tileWidth * tileHeight);
+		if (!unpackBits(packed, tile))
+			throw 'invalid cached bitmap data';
+
+		for (var row = 0; row < tileHeight; row++) {
+			this.bits.set(tile.subarray(row * tileWidth,
+				(row + 1) * tileWidth), (y + row) * this.bytesPerRow + x);
+		}
+	}
+}
+
+
+CachedBitmap.prototype.canvas = function(unsetAlpha)
+{
+	var index = unsetAlpha ? 1 : 0;
+	if (!this.canvases[index]) {
+		var bitmap = new RemoteBitmap();
+		bitmap.width = this.width;
+		bitmap.height = this.height;
+		bitmap.bytesPerRow = this.bytesPerRow;
+		bitmap.colorSpace = this.colorSpace;
+		bitmap.flags = this.flags;
+		bitmap.bitsLength = this.bits.length;
+		bitmap.decodeFrom(new StreamingDataView(this.bits, true), unsetAlpha);
+		this.canvases[index] = bitmap.canvas;
+	}
+
+	return this.canvases[index];
+}
+
+
+function drawBitmap(context, canvas, bitmapRect, viewRect, options)
+{
+	context.save();
+	context.imageSmoothingEnabled
+		= (options & B_FILTER_BITMAP_BILINEAR) != 0;
+
+	if ((options & B_TILE_BITMAP) != 0) {
+		// Tiles are not scaled, the bitmap rect only moves their origin.
+		var repetition = 'repeat';
+		if ((options & B_TILE_BITMAP) == B_TILE_BITMAP_X)
+			repetition = 'repeat-x';
+		else if ((options & B_TILE_BITMAP) == B_TILE_BITMAP_Y)
+			repetition = 'repeat-y';
+
+		context.translate(viewRect.left - bitmapRect.left,
+			viewRect.top - bitmapRect.top);
+		context.fillStyle = context.createPattern(canvas, repetition);
+		context.fillRect(bitmapRect.left, bitmapRect.top, viewRect.width(),
+			viewRect.height());
+	} else {
+		context.drawImage(canvas, bitmapRect.left, bitmapRect.top,
+			bitmapRect.width(), bitmapRect.height(), viewRect.left,
+			viewRect.top, viewRect.width(), viewRect.height());
+	}
+
+	context.restore();
 }
 
 
@@ -1293,37 +1437,48 @@ RemoteState.prototype.messageReceived = function(remoteMessage, reply)
 			var bitmapRect = new RemoteRect(remoteMessage);
 			var viewRect = new RemoteRect(remoteMessage);
 			var options = remoteMessage.dataView.readUint32();
-				// TODO: Implement options.
-
-			if (options != 0)
-				console.warn('bitmap options not supported: ' + options);
 
 			var bitmap = new RemoteBitmap(remoteMessage, this.unsetAlpha);
-			context.drawImage(bitmap.canvas, bitmapRect.left, bitmapRect.top,
-				bitmapRect.width(), bitmapRect.height(), viewRect.left,
-				viewRect.top, viewRect.width(), viewRect.height());
+			drawBitmap(context, bitmap.canvas, bitmapRect, viewRect, options);
+			break;
+
+		case RP_DRAW_CACHED_BITMAP:
+			this.applyContext();
+
+			var bitmapRect = new RemoteRect(remoteMessage);
+			var viewRect = new RemoteRect(remoteMessage);
+			var options = remoteMessage.dataView.readUint32();
+			var slot = remoteMessage.dataView.readInt32();
+
+			var bitmap = this.session.cachedBitmaps[slot];
+			if (!bitmap) {
+				console.error('no cached bitmap in slot ' + slot);
+				break;
+			}
+
+			drawBitmap(context, bitmap.canvas(this.unsetAlpha), bitmapRect,
+				viewRect, options);
 			break;
 
 		case RP_DRAW_BITMAP_RECTS:
 			this.applyContext();
 
 			var options = remoteMessage.dataView.readUint32();
-				// TODO: Implement options.
 			var colorSpace = remoteMessage.dataView.readUint32();
 			var flags = remoteMessage.dataView.readUint32();
 
-			if (options != 0)
-				console.warn('bitmap options not supported: ' + options);
-
 			var rectCount = remoteMessage.dataView.readUint32();
 			for (var i = 0; i < rectCount; i++) {
 				var rect = new RemoteRect(remoteMessage);
 				var bitmap = new RemoteBitmap(remoteMessage, this.unsetAlpha,
 					colorSpace, flags);
 
-				context.drawImage(bitmap.canvas, 0, 0, bitmap.width,
-					bitmap.height, rect.left, rect.top, rect.width(),
-					rect.height());
+				// each rect comes with its own bitmap, tiling doesn't apply
+				var bitmapRect = new RemoteRect();
+				bitmapRect.right = bitmap.width - 1;
+				bitmapRect.bottom = bitmap.height - 1;
+				drawBitmap(context, bitmap.canvas, bitmapRect, rect,
+					options & ~B_TILE_BITMAP);
 			}
 			break;
 
@@ -1802,6 +1957,7 @@ function RemoteDesktopSession(targetElement, width, height, targetAddress,
 
 	this.states = new Object();
 	this.modifiers = 0;
+	this.cachedBitmaps = new Array(kMaxCachedBitmaps);
 
 	this.canvas.onmousemove = this.onMouseMove.bind(this);
 	this.canvas.onmousedown = this.onMouseDown.bind(this);
@@ -1883,6 +2039,24 @@ RemoteDesktopSession.prototype.messageReceived = function(remoteMessage, reply)
 			this.sendMessage.flush();
 			break;
 
+		case RP_CACHE_BITMAP:
+			var slot = remoteMessage.dataView.readInt32();
+			var baseSlot = remoteMessage.dataView.readInt32();
+			if (slot < 0 || slot >= kMaxCachedBitmaps || baseSlot == slot) {
+				console.error('invalid bitmap cache slot: ' + slot);
+				break;
+			}
+
+			var base = baseSlot >= 0 ? this.cachedBitmaps[baseSlot] : null;
+			this.cachedBitmaps[slot] = null;
+			if (baseSlot >= 0 && !base) {
+				console.error('no cached bitmap in slot ' + baseSlot);
+				break;
+			}
+
+			this.cachedBitmaps[slot] = new CachedBitmap(remoteMessage, base);
+			break;
+
 		case RP_GET_SYSTEM_PALETTE_RESULT:
 			var count = remoteMessage.dataView.readUint32();
 			gSystemPalette = new Uint32Array(count);
@@ -2048,6 +2222,7 @@ RemoteDesktopSession.prototype.removeClipping = function()
 RemoteDesktopSession.prototype.init = function()
 {
 	this.sendMessage.start(RP_INIT_CONNECTION);
+	this.sendMessage.dataView.writeUint32(kBitmapCacheSize);
 	this.sendMessage.flush();
 }
 